@@ -859,28 +859,28 @@ installdeps() {
     apt-get install -y --no-install-recommends \
       gcc cmake perl libssl-dev libid3tag0-dev libflac-dev liblua5.4-dev lua5.4 \
       build-essential pkg-config libpcre2-dev gzip jq whiptail \
-      libutf8proc-dev
+      libutf8proc-dev libjpeg-dev libpng-dev
   elif [ -f /etc/arch-release ]
   then
     #arch
     pacman -Sy gcc base-devel cmake perl openssl libid3tag flac lua pkgconf pcre2 \
-      gzip jq libnewt libutf8proc
+      gzip jq libnewt libutf8proc libjpeg-turbo libpng
   elif [ -f /etc/alpine-release ]
   then
     #alpine
     apk add cmake perl openssl-dev libid3tag-dev flac-dev lua5.4-dev lua5.4 \
       alpine-sdk linux-headers pkgconf pcre2-dev gzip jq newt ca-certificates utf8proc-dev \
-      samurai
+      samurai libjpeg-turbo-dev libpng-dev
   elif [ -f /etc/SuSE-release ]
   then
     #suse
     zypper install gcc cmake pkgconfig perl openssl-devel libid3tag-devel flac-devel \
-      lua-devel unzip pcre2-devel gzip jq whiptail utf8proc-devel
+      lua-devel unzip pcre2-devel gzip jq whiptail utf8proc-devel libjpeg8-devel libpng16-devel
   elif [ -f /etc/redhat-release ]
   then
     #fedora
     dnf install gcc cmake pkgconfig perl openssl-devel libid3tag-devel flac-devel \
-      lua-devel unzip pcre2-devel gzip jq whiptail utf8proc-devel
+      lua-devel unzip pcre2-devel gzip jq whiptail utf8proc-devel libjpeg-turbo-devel libpng-devel
   else
     echo_warn "Unsupported distribution detected."
     echo "You should manually install:"
@@ -894,6 +894,8 @@ installdeps() {
     echo "  - openssl (devel)"
     echo "  - flac (devel)"
     echo "  - libid3tag (devel)"
+    echo "  - libjpeg (devel)"
+    echo "  - libpng (devel)"
     echo "  - liblua5.4 (devel)"
     echo "  - libpcre2 (devel)"
     echo "  - utf8proc (devel)"
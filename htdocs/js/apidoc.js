@@ -243,6 +243,11 @@ const APImethods = {
                 "type": APItypes.bool,
                 "example": false,
                 "desc": "true = forces an update"
+            },
+            "incremental": {
+                "type": APItypes.bool,
+                "example": false,
+                "desc": "true = updates only the albums of changed songs, optional, default false"
             }
         }
     },
@@ -332,6 +337,10 @@ const APImethods = {
         "desc": "Shows MPD database statistics.",
         "params": {}
     },
+    "MYMPD_API_STATS_METRICS": {
+        "desc": "Shows the latency metrics of the api methods.",
+        "params": {}
+    },
     "MYMPD_API_SONG_DETAILS": {
         "desc": "Shows all details of a song.",
         "params": {
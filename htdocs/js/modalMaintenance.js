@@ -174,7 +174,8 @@ function updateCaches(force, target) {
         btnWaiting(target, true);
     }
     sendAPI("MYMPD_API_CACHES_CREATE", {
-        "force": force
+        "force": force,
+        "incremental": false
     }, function() {
         if (target) {
             btnWaiting(target, false);
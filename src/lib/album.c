@@ -17,6 +17,7 @@
 #include "src/lib/sds/sds_extras.h"
 #include "src/lib/sds/sds_file.h"
 #include "src/lib/sds/sds_json.h"
+#include "src/lib/str_pool.h"
 #include "src/mympd_client/tags.h"
 
 #include <assert.h>
@@ -30,13 +31,17 @@ static sds get_tag_value_string(const struct t_album *album, enum mpd_tag_type t
         sds tag_values, unsigned *value_count);
 static sds get_tag_values(const struct t_album *album, enum mpd_tag_type tag,
         sds tag_values, bool multi, unsigned *value_count);
+static unsigned find_tag(const struct t_album *album, enum mpd_tag_type type);
+static bool append_tag(struct t_album *album, enum mpd_tag_type type, const char *value, bool mapped);
 
 /**
  * Structure representing an album tag value
  */
 struct t_album_tag_value {
-    struct t_album_tag_value *next;  //!< Next value
-    char *value;                     //!< The value
+    const char *value;      //!< The value, owned by the shared string pool or the mapped album cache file
+    sds value_norm;         //!< Normalized value, owned by the string pool of the album cache
+    enum mpd_tag_type tag;  //!< Tag type of the value
+    bool mapped;            //!< true if the value points into the mapped album cache file
 };
 
 /**
@@ -45,7 +50,9 @@ struct t_album_tag_value {
  */
 struct t_album {
     char *uri;                                      //!< First song uri, used to fetch AlbumArt
-    struct t_album_tag_value tags[MPD_TAG_COUNT];   //!< Tag values (same struct as it is for mpd_song)
+    struct t_album_tag_value *tags;                 //!< Tag values sorted by tag type, values of a tag in insertion order
+    unsigned tags_len;                              //!< Number of tag values
+    unsigned tags_size;                             //!< Allocated number of tag values
     unsigned total_time;                            //!< Total disc playtime
     unsigned disc_count;                            //!< Number of discs
     unsigned song_count;                            //!< Number of songs
@@ -73,11 +80,9 @@ struct t_album *album_new_uri(const char *uri) {
     assert(uri);
     struct t_album *album = malloc_assert(sizeof(struct t_album));
     album->uri = my_strdup(uri, strlen(uri));
-
-    for (unsigned i = 0; i < MPD_TAG_COUNT; ++i) {
-        album->tags[i].value = NULL;
-    }
-
+    album->tags = NULL;
+    album->tags_len = 0;
+    album->tags_size = 0;
     album->total_time = 0;
     album->disc_count = 0;
     album->song_count = 0;
@@ -97,10 +102,9 @@ struct t_album *album_new_from_song(const struct mpd_song *song, const struct t_
     struct t_album *album = malloc_assert(sizeof(struct t_album));
     const char *song_uri = mpd_song_get_uri(song);
     album->uri = my_strdup(song_uri, strlen(song_uri));
-
-    for (unsigned i = 0; i < MPD_TAG_COUNT; ++i) {
-        album->tags[i].value = NULL;
-    }
+    album->tags = NULL;
+    album->tags_len = 0;
+    album->tags_size = 0;
 
     for (unsigned tagnr = 0; tagnr < album_tags->len; ++tagnr) {
         const char *value;
@@ -123,7 +127,6 @@ struct t_album *album_new_from_song(const struct mpd_song *song, const struct t_
     album->song_count = 1;
     album->last_modified = mpd_song_get_last_modified(song);
     album->added = mpd_song_get_added(song);
-    
     return album;
 }
 
@@ -134,26 +137,26 @@ struct t_album *album_new_from_song(const struct mpd_song *song, const struct t_
 void album_free(struct t_album *album) {
     assert(album != NULL);
     free(album->uri);
-    for (unsigned i = 0; i < MPD_TAG_COUNT; ++i) {
-        struct t_album_tag_value *tag = &album->tags[i];
-        struct t_album_tag_value *next;
-        if (tag->value == NULL) {
-            continue;
-        }
-        free(tag->value);
-        tag = tag->next;
-        while (tag != NULL) {
-            assert(tag->value != NULL);
-            free(tag->value);
-
-            next = tag->next;
-            free(tag);
-            tag = next;
+    for (unsigned i = 0; i < album->tags_len; ++i) {
+        if (album->tags[i].mapped == false) {
+            str_pool_release(album->tags[i].value);
         }
     }
+    free(album->tags);
     free(album);
 }
 
+/**
+ * Gets the heap memory used by the album, excluding the shared tag values
+ * @param album t_album struct representing the album
+ * @return size in bytes
+ */
+size_t album_get_memory_size(const struct t_album *album) {
+    return sizeof(struct t_album) +
+        strlen(album->uri) + 1 +
+        album->tags_size * sizeof(struct t_album_tag_value);
+}
+
 /**
  * Gets the album uri (uri of first song)
  * @param album t_album struct representing the album
@@ -216,21 +219,48 @@ unsigned album_get_disc_count(const struct t_album *album) {
  * @return const char* tag value or NULL
  */
 const char *album_get_tag(const struct t_album *album, enum mpd_tag_type type, unsigned idx) {
-    const struct t_album_tag_value *tag = &album->tags[type];
+    if ((int)type < 0) {
+        return NULL;
+    }
+    unsigned pos = find_tag(album, type) + idx;
+    if (pos >= album->tags_len ||
+        album->tags[pos].tag != type)
+    {
+        return NULL;
+    }
+    return album->tags[pos].value;
+}
 
-    if ((int)type < 0 ||
-        tag->value == NULL)
+/**
+ * Gets the normalized album tag value at position idx
+ * @param album t_album struct representing the album
+ * @param type mpd tag type
+ * @param idx index of tag value to get
+ * @return normalized tag value or NULL if the value does not exist or is not normalized
+ */
+sds album_get_tag_normalized(const struct t_album *album, enum mpd_tag_type type, unsigned idx) {
+    if ((int)type < 0) {
+        return NULL;
+    }
+    unsigned pos = find_tag(album, type) + idx;
+    if (pos >= album->tags_len ||
+        album->tags[pos].tag != type)
     {
         return NULL;
     }
+    return album->tags[pos].value_norm;
+}
 
-    while (idx-- > 0) {
-        tag = tag->next;
-        if (tag == NULL) {
-            return NULL;
-        }
+/**
+ * Sets the normalized values for all tag values of the album
+ * @param album t_album struct representing the album
+ * @param pool string pool for the normalized values
+ */
+void album_normalize_tags(struct t_album *album, struct t_str_pool *pool) {
+    for (unsigned i = 0; i < album->tags_len; ++i) {
+        struct t_album_tag_value *tag = &album->tags[i];
+        tag->value_norm = str_pool_get_normalized(pool, tag->value, strlen(tag->value));
     }
-    return tag->value;
 }
 
 /**
@@ -302,6 +332,15 @@ void album_set_added(struct t_album *album, time_t added) {
     }
 }
 
+/**
+ * Resets the albums added and last-modified timestamps
+ * @param album t_album struct representing the album
+ */
+void album_reset_timestamps(struct t_album *album) {
+    album->added = 0;
+    album->last_modified = 0;
+}
+
 /**
  * Sets the albums duration
  * @param album t_album struct representing the album
@@ -373,47 +412,45 @@ bool album_append_tags(struct t_album *album,
  *         false if the tag could not be added
  */
 bool album_append_tag(struct t_album *album, enum mpd_tag_type type, const char *value) {
-    struct t_album_tag_value *tag = &album->tags[type];
+    return append_tag(album, type, value, false);
+}
 
-    if ((int)type < 0 ||
-        type >= MPD_TAG_COUNT)
-    {
-        return false;
-    }
+/**
+ * Adds a tag value that is owned by the mapped album cache file.
+ * The value must be valid for the lifetime of the album.
+ * @param album pointer to a t_album struct
+ * @param type mpd tag type
+ * @param value tag value to add
+ * @return true if tag is added or already there,
+ *         false if the tag could not be added
+ */
+bool album_append_tag_mapped(struct t_album *album, enum mpd_tag_type type, const char *value) {
+    return append_tag(album, type, value, true);
+}
 
-    if (tag->value == NULL) {
-        tag->next = NULL;
-        tag->value = my_strdup(value, strlen(value));
-        if (tag->value == NULL) {
-            return false;
-        }
+/**
+ * Preallocates the tag values array
+ * @param album pointer to a t_album struct
+ * @param count number of tag values to allocate
+ */
+void album_reserve_tags(struct t_album *album, unsigned count) {
+    if (count > album->tags_size) {
+        album->tags = realloc_assert(album->tags, count * sizeof(struct t_album_tag_value));
+        album->tags_size = count;
     }
-    else {
-        while (tag->next != NULL) {
-            if (strcmp(tag->value, value) == 0) {
-                //do not add duplicate values
-                return true;
-            }
-            tag = tag->next;
-        }
-        if (strcmp(tag->value, value) == 0) {
-            //do not add duplicate values
-            return true;
-        }
-        struct t_album_tag_value *prev = tag;
-        tag = malloc_assert(sizeof(*tag));
+}
 
-        tag->value = my_strdup(value, strlen(value));
-        if (tag->value == NULL) {
-            FREE_PTR(tag);
-            return false;
+/**
+ * Removes all tag values
+ * @param album pointer to a t_album struct
+ */
+void album_clear_tags(struct t_album *album) {
+    for (unsigned i = 0; i < album->tags_len; ++i) {
+        if (album->tags[i].mapped == false) {
+            str_pool_release(album->tags[i].value);
         }
-
-        tag->next = NULL;
-        prev->next = tag;
     }
-
-    return true;
+    album->tags_len = 0;
 }
 
 /**
@@ -547,6 +584,64 @@ sds print_album_tags(sds buffer, const struct t_albums_config *album_config, con
 
 // Private functions
 
+/**
+ * Adds a tag value to the album if value does not already exists
+ * @param album pointer to a t_album struct
+ * @param type mpd tag type
+ * @param value tag value to add
+ * @param mapped true if the value is owned by the mapped album cache file, false to intern the value
+ * @return true if tag is added or already there,
+ *         false if the tag could not be added
+ */
+static bool append_tag(struct t_album *album, enum mpd_tag_type type, const char *value, bool mapped) {
+    if ((int)type < 0 ||
+        type >= MPD_TAG_COUNT)
+    {
+        return false;
+    }
+
+    // insert after the last value of this tag
+    unsigned pos = find_tag(album, type);
+    for (; pos < album->tags_len && album->tags[pos].tag == type; pos++) {
+        if (strcmp(album->tags[pos].value, value) == 0) {
+            //do not add duplicate values
+            return true;
+        }
+    }
+    // grow by one element, albums have only a few tag values
+    album_reserve_tags(album, album->tags_len + 1);
+    memmove(&album->tags[pos + 1], &album->tags[pos], (album->tags_len - pos) * sizeof(struct t_album_tag_value));
+    album->tags[pos].value = mapped == true
+        ? value
+        : str_pool_intern(value, strlen(value));
+    album->tags[pos].value_norm = NULL;
+    album->tags[pos].tag = type;
+    album->tags[pos].mapped = mapped;
+    album->tags_len++;
+    return true;
+}
+
+/**
+ * Finds the position of the first value of a tag
+ * @param album pointer to album struct
+ * @param type mpd tag type
+ * @return position of the first value or the insert position if the album has no values for the tag
+ */
+static unsigned find_tag(const struct t_album *album, enum mpd_tag_type type) {
+    unsigned low = 0;
+    unsigned high = album->tags_len;
+    while (low < high) {
+        unsigned mid = low + (high - low) / 2;
+        if (album->tags[mid].tag < type) {
+            low = mid + 1;
+        }
+        else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
 /**
  * Appends a comma separated list of tag values
  * @param album pointer to album struct
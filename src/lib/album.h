@@ -13,6 +13,7 @@
 
 #include "src/lib/fields.h"
 #include "src/lib/mpdclient.h"
+#include "src/lib/str_pool.h"
 
 #include <stdbool.h>
 
@@ -44,6 +45,7 @@ struct t_album *album_new(void);
 struct t_album *album_new_uri(const char *uri);
 struct t_album *album_new_from_song(const struct mpd_song *song, const struct t_mympd_mpd_tags *album_tags);
 void album_free(struct t_album *album);
+size_t album_get_memory_size(const struct t_album *album);
 
 const char *album_get_uri(const struct t_album *album);
 time_t album_get_last_modified(const struct t_album *album);
@@ -53,16 +55,22 @@ unsigned album_get_total_time(const struct t_album *album);
 unsigned album_get_song_count(const struct t_album *album);
 bool album_get_unknown(const struct t_album *album);
 const char *album_get_tag(const struct t_album *album, enum mpd_tag_type type, unsigned idx);
+sds album_get_tag_normalized(const struct t_album *album, enum mpd_tag_type type, unsigned idx);
+void album_normalize_tags(struct t_album *album, struct t_str_pool *pool);
 
 void album_set_discs(struct t_album *album, const char *disc);
 void album_set_disc_count(struct t_album *album, unsigned count);
 void album_set_last_modified(struct t_album *album, time_t last_modified);
 void album_set_added(struct t_album *album, time_t added);
+void album_reset_timestamps(struct t_album *album);
 void album_set_total_time(struct t_album *album, unsigned duration);
 void album_inc_total_time(struct t_album *album, unsigned duration);
 void album_set_song_count(struct t_album *album, unsigned count);
 void album_inc_song_count(struct t_album *album);
 bool album_append_tag(struct t_album *song, enum mpd_tag_type type, const char *value);
+bool album_append_tag_mapped(struct t_album *album, enum mpd_tag_type type, const char *value);
+void album_reserve_tags(struct t_album *album, unsigned count);
+void album_clear_tags(struct t_album *album);
 bool album_append_tags(struct t_album *album, const struct mpd_song *song, const struct t_mympd_mpd_tags *tags);
 bool album_copy_tags(struct t_album *song, enum mpd_tag_type src, enum mpd_tag_type dst);
 void album_set_uri(struct t_album *album, const char *uri);
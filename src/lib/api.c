@@ -11,8 +11,10 @@
 #include "compile_time.h"
 #include "src/lib/api.h"
 
+#include "src/lib/json/json_query.h"
 #include "src/lib/log.h"
 #include "src/lib/mem.h"
+#include "src/lib/metrics.h"
 #include "src/lib/msg_queue.h"
 #include "src/lib/sds/sds_extras.h"
 
@@ -223,6 +225,7 @@ static enum mympd_cmd_acl_entity mympd_cmd_acl[] = {
     [MYMPD_API_SONG_DETAILS] = API_PUBLIC,
     [MYMPD_API_SONG_FINGERPRINT] = API_PUBLIC | API_MYMPD_ONLY,  // Handled in a worker thread
     [MYMPD_API_STATS] = API_PUBLIC,
+    [MYMPD_API_STATS_METRICS] = API_PUBLIC | API_MYMPD_ONLY,
     [MYMPD_API_STICKER_DELETE] = API_PUBLIC | API_MYMPD_ONLY,  // Stickers are handled by a different MPD connection
     [MYMPD_API_STICKER_GET] = API_PUBLIC | API_MYMPD_ONLY,  // Stickers are handled by a different MPD connection
     [MYMPD_API_STICKER_FIND] = API_PUBLIC | API_MYMPD_ONLY,  // Stickers are handled by a different MPD connection
@@ -407,6 +410,7 @@ struct t_work_request *create_request(enum work_request_types type, unsigned lon
     request->partition = sdsnew(partition);
     request->extra = NULL;
     request->extra_free = NULL;
+    (void)clock_gettime(CLOCK_MONOTONIC, &request->queued);
     return request;
 }
 
@@ -418,6 +422,8 @@ void free_request(struct t_work_request *request) {
     if (request == NULL) {
         return;
     }
+    // the token index must not outlive the request data
+    json_query_release(request->data);
     FREE_SDS(request->data);
     FREE_SDS(request->partition);
     if (request->extra != NULL) {
@@ -458,6 +464,9 @@ void free_response(struct t_work_response *response) {
  * @return true on success, else false
  */
 bool push_response(struct t_work_response *response) {
+    if (response->data != NULL) {
+        metrics_count_response_bytes(sdslen(response->data));
+    }
     switch(response->type) {
         case RESPONSE_TYPE_DEFAULT:
         case RESPONSE_TYPE_NOTIFY_CLIENT:
@@ -17,6 +17,7 @@
 #include "src/lib/webradio.h"
 
 #include <stdbool.h>
+#include <time.h>
 
 /**
  * myMPD api methods
@@ -220,6 +221,7 @@
     X(MYMPD_API_SONG_DETAILS) \
     X(MYMPD_API_SONG_FINGERPRINT) \
     X(MYMPD_API_STATS) \
+    X(MYMPD_API_STATS_METRICS) \
     X(MYMPD_API_STICKER_DELETE) \
     X(MYMPD_API_STICKER_GET) \
     X(MYMPD_API_STICKER_FIND) \
@@ -319,6 +321,7 @@ struct t_work_request {
     sds partition;                 //!< mpd partition
     void *extra;                   //!< extra data for the request
     void (*extra_free)(void *);    //!< Function pointer to free extra data
+    struct timespec queued;        //!< time the request was created from CLOCK_MONOTONIC
 };
 
 /**
@@ -11,18 +11,23 @@
 #include "compile_time.h"
 #include "src/lib/cache/cache_disk.h"
 
-#include "src/lib/datetime.h"
+#include "src/lib/cache/cache_disk_index.h"
 #include "src/lib/filehandler.h"
+#include "src/lib/http_client/http_client_cache.h"
+#include "src/lib/image_index.h"
 #include "src/lib/log.h"
 #include "src/lib/sds/sds_extras.h"
 
 #include <dirent.h>
 #include <errno.h>
+#include <limits.h>
 #include <time.h>
 
 // private definitions
 
-static int crop_dir(sds cache_basedir, const char *type, int keepdays);
+static int clear_dir(sds cache_basedir, const char *type);
+static unsigned crop_type(struct t_config *config, enum cache_disk_type type, unsigned max_files);
+static void get_crop_settings(struct t_config *config, enum cache_disk_type type, int *keep_days, unsigned *size_max);
 
 // public functions
 
@@ -31,49 +36,127 @@ static int crop_dir(sds cache_basedir, const char *type, int keepdays);
  * @param config pointer to static config
  */
 void cache_disk_clear(struct t_config *config) {
-    crop_dir(config->cachedir, DIR_CACHE_COVER, 0);
-    crop_dir(config->cachedir, DIR_CACHE_HTTP, 0);
-    crop_dir(config->cachedir, DIR_CACHE_LYRICS, 0);
-    crop_dir(config->cachedir, DIR_CACHE_THUMBS, 0);
-    crop_dir(config->cachedir, DIR_CACHE_MISC, 0);
+    http_client_cache_mem_clear();
+    for (unsigned i = 0; i < CACHE_DISK_TYPE_COUNT; i++) {
+        clear_dir(config->cachedir, cache_disk_index_dir((enum cache_disk_type)i));
+        cache_disk_index_reset((enum cache_disk_type)i);
+    }
+    image_index_files_removed(IMAGE_INDEX_SCOPE_CACHE);
 }
 
 /**
- * Crops the caches respecting the keep_days settings
+ * Synchronizes the cache indexes with the cache directories
+ * and crops the caches respecting the keep_days and size_max settings
  * @param config pointer to static config
  */
 void cache_disk_crop(struct t_config *config) {
-    if (config->cache_cover_keep_days > CACHE_DISK_DISABLED) {
-        crop_dir(config->cachedir, DIR_CACHE_COVER, config->cache_cover_keep_days);
+    if (config->cache_http_keep_days > CACHE_DISK_DISABLED) {
+        // write the pending mtime updates of recently used responses
+        http_client_cache_mem_flush(config->cache_http_keep_days);
     }
-    if (config->cache_lyrics_keep_days > CACHE_DISK_DISABLED) {
-        crop_dir(config->cachedir, DIR_CACHE_LYRICS, config->cache_lyrics_keep_days);
+    for (unsigned i = 0; i < CACHE_DISK_TYPE_COUNT; i++) {
+        enum cache_disk_type type = (enum cache_disk_type)i;
+        if (cache_disk_index_sync(config->cachedir, type) == false) {
+            continue;
+        }
+        unsigned num_deleted = crop_type(config, type, UINT_MAX);
+        MYMPD_LOG_NOTICE(NULL, "Deleted %u files from %s cache", num_deleted, cache_disk_index_dir(type));
     }
-    if (config->cache_thumbs_keep_days > CACHE_DISK_DISABLED) {
-        crop_dir(config->cachedir, DIR_CACHE_THUMBS, config->cache_thumbs_keep_days);
+}
+
+/**
+ * Crops the caches in a small slice, called periodically by a timer.
+ * Caches are cropped only after the first synchronization of the index.
+ * @param config pointer to static config
+ */
+void cache_disk_crop_slice(struct t_config *config) {
+    for (unsigned i = 0; i < CACHE_DISK_TYPE_COUNT; i++) {
+        unsigned num_deleted = crop_type(config, (enum cache_disk_type)i, CACHE_DISK_CROP_SLICE_FILES);
+        if (num_deleted > 0) {
+            MYMPD_LOG_INFO(NULL, "Deleted %u files from %s cache", num_deleted, cache_disk_index_dir((enum cache_disk_type)i));
+        }
     }
-    if (config->cache_http_keep_days > CACHE_DISK_DISABLED) {
-        crop_dir(config->cachedir, DIR_CACHE_HTTP, config->cache_http_keep_days);
+}
+
+// private functions
+
+/**
+ * Crops a cache by its index
+ * @param config pointer to static config
+ * @param type cache type
+ * @param max_files maximum number of files to remove
+ * @return number of deleted files
+ */
+static unsigned crop_type(struct t_config *config, enum cache_disk_type type, unsigned max_files) {
+    int keep_days;
+    unsigned size_max;
+    get_crop_settings(config, type, &keep_days, &size_max);
+    time_t expire_time = keep_days > CACHE_DISK_DISABLED
+        ? time(NULL) - (time_t)keep_days * 24 * 60 * 60
+        : 0;
+    if (expire_time == 0 &&
+        size_max == 0)
+    {
+        return 0;
+    }
+    cache_disk_removed_callback removed_cb = type == CACHE_DISK_TYPE_HTTP
+        ? http_client_cache_mem_remove
+        : NULL;
+    unsigned num_deleted = cache_disk_index_crop(config->cachedir, type, expire_time,
+        (uint64_t)size_max * 1024 * 1024, max_files, removed_cb);
+    if (num_deleted > 0 &&
+        (type == CACHE_DISK_TYPE_COVER || type == CACHE_DISK_TYPE_THUMBS))
+    {
+        image_index_files_removed(IMAGE_INDEX_SCOPE_CACHE);
+    }
+    return num_deleted;
+}
+
+/**
+ * Returns the crop settings for a cache
+ * @param config pointer to static config
+ * @param type cache type
+ * @param keep_days pointer to set the expiration in days
+ * @param size_max pointer to set the size limit in MiB
+ */
+static void get_crop_settings(struct t_config *config, enum cache_disk_type type, int *keep_days, unsigned *size_max) {
+    switch(type) {
+        case CACHE_DISK_TYPE_COVER:
+            *keep_days = config->cache_cover_keep_days;
+            *size_max = config->cache_cover_size_max;
+            return;
+        case CACHE_DISK_TYPE_HTTP:
+            *keep_days = config->cache_http_keep_days;
+            *size_max = config->cache_http_size_max;
+            return;
+        case CACHE_DISK_TYPE_LYRICS:
+            *keep_days = config->cache_lyrics_keep_days;
+            *size_max = config->cache_lyrics_size_max;
+            return;
+        case CACHE_DISK_TYPE_THUMBS:
+            *keep_days = config->cache_thumbs_keep_days;
+            *size_max = config->cache_thumbs_size_max;
+            return;
+        case CACHE_DISK_TYPE_MISC:
+        case CACHE_DISK_TYPE_COUNT:
+            break;
     }
-    crop_dir(config->cachedir, DIR_CACHE_MISC, config->cache_misc_keep_days);
+    *keep_days = config->cache_misc_keep_days;
+    *size_max = 0;
 }
 
 /**
- * Crops a specific cache dir
+ * Removes all files from a specific cache dir
  * @param cache_basedir cache basedir
  * @param type cache subdir
- * @param keepdays expiration in days
  * @return deleted file count on success, else -1
  */
-static int crop_dir(sds cache_basedir, const char *type, int keepdays) {
+static int clear_dir(sds cache_basedir, const char *type) {
     int num_deleted = 0;
     bool rc = true;
-    time_t expire_time = time(NULL) - (time_t)(keepdays * 24 * 60 * 60);
 
     sds cache_path = sdscatfmt(sdsempty(), "%S/%s", cache_basedir, type);
-    char fmt_time[32];
-    readable_time(fmt_time, expire_time);
-    MYMPD_LOG_INFO(NULL, "Cleaning %s cache \"%s\", removing files older than %s ", type, cache_path, fmt_time);
+    MYMPD_LOG_INFO(NULL, "Clearing %s cache \"%s\"", type, cache_path);
     errno = 0;
     DIR *cache_dir = opendir(cache_path);
     if (cache_dir == NULL) {
@@ -91,13 +174,10 @@ static int crop_dir(sds cache_basedir, const char *type, int keepdays) {
         }
         sdsclear(filepath);
         filepath = sdscatfmt(filepath, "%S/%s", cache_path, next_file->d_name);
-        time_t mtime = get_mtime(filepath);
-        if (mtime < expire_time) {
-            MYMPD_LOG_DEBUG(NULL, "Deleting \"%s\"", filepath);
-            rc = rm_file(filepath);
-            if (rc == true) {
-                num_deleted++;
-            }
+        MYMPD_LOG_DEBUG(NULL, "Deleting \"%s\"", filepath);
+        rc = rm_file(filepath);
+        if (rc == true) {
+            num_deleted++;
         }
     }
     closedir(cache_dir);
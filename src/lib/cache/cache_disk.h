@@ -25,5 +25,6 @@ enum cache_disk_conf {
 
 void cache_disk_clear(struct t_config *config);
 void cache_disk_crop(struct t_config *config);
+void cache_disk_crop_slice(struct t_config *config);
 
 #endif
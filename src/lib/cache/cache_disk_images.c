@@ -8,9 +8,12 @@
  * \brief Image cache handling
  */
 
+#include "compile_time.h"
 #include "src/lib/cache/cache_disk_images.h"
 
+#include "src/lib/cache/cache_disk_index.h"
 #include "src/lib/filehandler.h"
+#include "src/lib/image_index.h"
 #include "src/lib/log.h"
 #include "src/lib/mimetype.h"
 #include "src/lib/sds/sds_extras.h"
@@ -18,6 +21,15 @@
 
 #include <time.h>
 
+//optional includes
+#ifdef MYMPD_ENABLE_THUMBNAILS
+    #include "src/lib/thumbnail.h"
+#endif
+
+/**
+ * Public functions
+ */
+
 /**
  * Returns the path / basename for an uri to save it in the image cache
  * @param cachedir cache directory
@@ -33,9 +45,41 @@ sds cache_disk_images_get_basename(const char *cachedir, const char *type, const
     return filepath;
 }
 
+/**
+ * Returns the path / basename of a thumbnail variant of a cover in the thumbs cache
+ * @param cachedir cache directory
+ * @param uri uri of the song for the cover
+ * @param offset number of the coverimage
+ * @param variant thumbnail variant, THUMBNAIL_VARIANT_SM or THUMBNAIL_VARIANT_MD
+ * @return path / basename as newly allocated sds string
+ */
+sds cache_disk_images_get_thumbnail_basename(const char *cachedir, const char *uri, int offset, const char *variant) {
+    sds filepath = cache_disk_images_get_basename(cachedir, DIR_CACHE_THUMBS, uri, offset);
+    filepath = sdscatfmt(filepath, "-%s", variant);
+    return filepath;
+}
+
+/**
+ * Returns the full path of an image in the image cache
+ * @param cachedir cache directory
+ * @param type image type
+ * @param uri uri of the song for the cover
+ * @param mime_type mime_type of the image
+ * @param offset number of the coverimage
+ * @return full path as newly allocated sds string or NULL if the mime_type is unknown
+ */
+sds cache_disk_images_get_filepath(const char *cachedir, const char *type, const char *uri, const char *mime_type, int offset) {
+    const char *ext = get_ext_by_mime_type(mime_type);
+    if (ext == NULL) {
+        return NULL;
+    }
+    sds filepath = cache_disk_images_get_basename(cachedir, type, uri, offset);
+    return sdscatfmt(filepath, ".%s", ext);
+}
+
 /**
  * Writes the image (as binary buffer) to the image cache,
- * filename is the hash of the full path
+ * filename is the hash of the full path.
  * @param cachedir cache directory
  * @param type image type
  * @param uri uri of the song for the cover
@@ -49,18 +93,65 @@ sds cache_disk_images_write_file(sds cachedir, const char *type, const char *uri
         MYMPD_LOG_WARN(NULL, "Covercache file for \"%s\" not written, mime_type is empty", uri);
         return false;
     }
-    const char *ext = get_ext_by_mime_type(mime_type);
-    if (ext == NULL) {
+    sds filepath = cache_disk_images_get_filepath(cachedir, type, uri, mime_type, offset);
+    if (filepath == NULL) {
         MYMPD_LOG_WARN(NULL, "Image cache file for \"%s\" not written, could not determine file extension", uri);
         return false;
     }
     MYMPD_LOG_DEBUG(NULL, "Writing image cache for \"%s\"", uri);
-    sds filepath = cache_disk_images_get_basename(cachedir, type, uri, offset);
-    filepath = sdscatfmt(filepath, ".%s", ext);
     MYMPD_LOG_DEBUG(NULL, "Writing image cache file \"%s\"", filepath);
     bool rc = write_data_to_file(filepath, binary, sdslen(binary));
     if (rc == false) {
         FREE_SDS(filepath);
     }
+    else {
+        cache_disk_index_add(filepath);
+        image_index_files_added(IMAGE_INDEX_SCOPE_CACHE);
+    }
     return filepath;
 }
+
+#ifdef MYMPD_ENABLE_THUMBNAILS
+/**
+ * Decodes the image once and writes the small and medium thumbnail variants.
+ * This function is called from the mympd_worker threads.
+ * @param cachedir cache directory
+ * @param uri uri of the song for the cover
+ * @param binary the image
+ * @param offset number of the coverimage
+ * @return true on success, else false
+ */
+bool cache_disk_images_write_thumbnails(const char *cachedir, const char *uri, sds binary, int offset) {
+    struct t_thumbnail_image image;
+    if (thumbnail_decode(binary, sdslen(binary), THUMBNAIL_SIZE_MD, &image) == false) {
+        MYMPD_LOG_DEBUG(NULL, "No thumbnails created for \"%s\"", uri);
+        return false;
+    }
+    const char *variants[] = {THUMBNAIL_VARIANT_SM, THUMBNAIL_VARIANT_MD};
+    const unsigned sizes[] = {THUMBNAIL_SIZE_SM, THUMBNAIL_SIZE_MD};
+    bool rc = true;
+    sds jpeg = sdsempty();
+    for (size_t i = 0; i < 2; i++) {
+        if (thumbnail_encode(&image, sizes[i], &jpeg) == true) {
+            sds filepath = cache_disk_images_get_thumbnail_basename(cachedir, uri, offset, variants[i]);
+            filepath = sdscat(filepath, ".jpg");
+            MYMPD_LOG_DEBUG(NULL, "Writing thumbnail \"%s\" (%lu bytes)", filepath, (unsigned long)sdslen(jpeg));
+            if (write_data_to_file(filepath, jpeg, sdslen(jpeg)) == true) {
+                cache_disk_index_add(filepath);
+            }
+            else {
+                rc = false;
+            }
+            FREE_SDS(filepath);
+        }
+        else {
+            rc = false;
+        }
+        sdsclear(jpeg);
+    }
+    FREE_SDS(jpeg);
+    thumbnail_image_clear(&image);
+    image_index_files_added(IMAGE_INDEX_SCOPE_CACHE);
+    return rc;
+}
+#endif
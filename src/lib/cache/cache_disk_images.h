@@ -16,6 +16,11 @@
 #include <stdbool.h>
 
 sds cache_disk_images_get_basename(const char *cachedir, const char *type, const char *uri, int offset);
+sds cache_disk_images_get_filepath(const char *cachedir, const char *type, const char *uri, const char *mime_type, int offset);
+sds cache_disk_images_get_thumbnail_basename(const char *cachedir, const char *uri, int offset, const char *variant);
 sds cache_disk_images_write_file(sds cachedir,  const char *type, const char *uri, const char *mime_type, sds binary, int offset);
+#ifdef MYMPD_ENABLE_THUMBNAILS
+    bool cache_disk_images_write_thumbnails(const char *cachedir, const char *uri, sds binary, int offset);
+#endif
 
 #endif
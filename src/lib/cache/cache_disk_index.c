@@ -0,0 +1,564 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2026 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+/*! \file
+ * \brief In-memory index of the disk cache files
+ *
+ * The index holds size and last access time of all cache files in a
+ * recency list, the least recently used file is the tail of the list.
+ * It is built by one directory pass and kept up to date by the cache
+ * writers and readers. Crops remove files from the tail until the cache
+ * is in its budget and the tail is not expired.
+ */
+
+#include "compile_time.h"
+#include "src/lib/cache/cache_disk_index.h"
+
+#include "dist/rax/rax.h"
+#include "src/lib/filehandler.h"
+#include "src/lib/json/json_print.h"
+#include "src/lib/list/list.h"
+#include "src/lib/log.h"
+#include "src/lib/lru_list.h"
+#include "src/lib/mem.h"
+#include "src/lib/sds/sds_extras.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+/**
+ * Private definitions
+ */
+
+/**
+ * An indexed cache file
+ */
+struct t_cache_disk_entry {
+    sds name;                           //!< filename without path
+    uint64_t size;                      //!< file size in bytes
+    time_t atime;                       //!< last access, initialized with the mtime
+    unsigned generation;                //!< sync generation the file was last seen
+    struct t_lru_node lru;              //!< node in the recency list
+};
+
+/**
+ * Index of one cache directory
+ */
+struct t_cache_disk_index {
+    pthread_mutex_t mutex;              //!< protects all other members
+    rax *entries;                       //!< entries by filename
+    struct t_lru_list lru;              //!< entries by recency
+    uint64_t bytes;                     //!< size of all indexed files
+    unsigned generation;                //!< current sync generation
+    bool built;                         //!< true if the directory was scanned
+    uint64_t hits;                      //!< cache hits
+    uint64_t misses;                    //!< cache misses
+    uint64_t evicted;                   //!< files removed by crops
+};
+
+/**
+ * Static initializer for an index
+ */
+#define CACHE_DISK_INDEX_INIT { \
+    .mutex = PTHREAD_MUTEX_INITIALIZER, \
+    .entries = NULL, \
+    .lru = LRU_LIST_INIT, \
+    .bytes = 0, \
+    .generation = 0, \
+    .built = false, \
+    .hits = 0, \
+    .misses = 0, \
+    .evicted = 0 \
+}
+
+/**
+ * The indexes for all cache types
+ */
+static struct t_cache_disk_index indexes[CACHE_DISK_TYPE_COUNT] = {
+    [CACHE_DISK_TYPE_COVER] = CACHE_DISK_INDEX_INIT,
+    [CACHE_DISK_TYPE_HTTP] = CACHE_DISK_INDEX_INIT,
+    [CACHE_DISK_TYPE_LYRICS] = CACHE_DISK_INDEX_INIT,
+    [CACHE_DISK_TYPE_MISC] = CACHE_DISK_INDEX_INIT,
+    [CACHE_DISK_TYPE_THUMBS] = CACHE_DISK_INDEX_INIT
+};
+
+/**
+ * Cache subdirectories by type
+ */
+static const char *cache_disk_dirs[CACHE_DISK_TYPE_COUNT] = {
+    [CACHE_DISK_TYPE_COVER] = DIR_CACHE_COVER,
+    [CACHE_DISK_TYPE_HTTP] = DIR_CACHE_HTTP,
+    [CACHE_DISK_TYPE_LYRICS] = DIR_CACHE_LYRICS,
+    [CACHE_DISK_TYPE_MISC] = DIR_CACHE_MISC,
+    [CACHE_DISK_TYPE_THUMBS] = DIR_CACHE_THUMBS
+};
+
+static struct t_cache_disk_index *index_by_path(const char *filepath, const char **name);
+static void entry_set(struct t_cache_disk_index *index, const char *name, size_t name_len, uint64_t size, time_t atime);
+static void entry_remove(struct t_cache_disk_index *index, struct t_cache_disk_entry *entry);
+static void index_clear(struct t_cache_disk_index *index);
+static void index_relink(struct t_cache_disk_index *index);
+static int cmp_atime_desc(const void *a, const void *b);
+
+/**
+ * Public functions
+ */
+
+/**
+ * Returns the cache subdirectory for a cache type
+ * @param type cache type
+ * @return name of the subdirectory
+ */
+const char *cache_disk_index_dir(enum cache_disk_type type) {
+    return cache_disk_dirs[type];
+}
+
+/**
+ * Returns the cache type for a cache subdirectory
+ * @param dir name of the subdirectory
+ * @return cache type or CACHE_DISK_TYPE_COUNT if unknown
+ */
+enum cache_disk_type cache_disk_index_type(const char *dir) {
+    for (unsigned i = 0; i < CACHE_DISK_TYPE_COUNT; i++) {
+        if (strcmp(dir, cache_disk_dirs[i]) == 0) {
+            return (enum cache_disk_type)i;
+        }
+    }
+    return CACHE_DISK_TYPE_COUNT;
+}
+
+/**
+ * Synchronizes the index with the cache directory in one directory pass.
+ * Only files that are not already indexed are stated,
+ * vanished files are removed from the index.
+ * The directory is read and the new files are stated without holding the mutex.
+ * @param cachedir cache base directory
+ * @param type cache type
+ * @return true on success, else false
+ */
+bool cache_disk_index_sync(const char *cachedir, enum cache_disk_type type) {
+    struct t_cache_disk_index *index = &indexes[type];
+    sds cache_path = sdscatfmt(sdsempty(), "%s/%s", cachedir, cache_disk_dirs[type]);
+    errno = 0;
+    DIR *cache_dir = opendir(cache_path);
+    if (cache_dir == NULL) {
+        MYMPD_LOG_ERROR(NULL, "Error opening directory \"%s\"", cache_path);
+        MYMPD_LOG_ERRNO(NULL, errno);
+        FREE_SDS(cache_path);
+        return false;
+    }
+    struct t_list files;
+    list_init(&files);
+    struct dirent *next_file;
+    while ((next_file = readdir(cache_dir)) != NULL) {
+        if (next_file->d_type == DT_REG) {
+            list_push(&files, next_file->d_name, 0, NULL, NULL);
+        }
+    }
+    // mark the indexed files as seen, the files added while syncing get the new generation
+    pthread_mutex_lock(&index->mutex);
+    if (index->entries == NULL) {
+        index->entries = raxNew();
+    }
+    index->generation++;
+    struct t_list_node *current = files.head;
+    while (current != NULL) {
+        void *data;
+        if (raxFind(index->entries, (unsigned char *)current->key, sdslen(current->key), &data) == 1) {
+            ((struct t_cache_disk_entry *)data)->generation = index->generation;
+            current->value_i = 1;
+        }
+        current = current->next;
+    }
+    pthread_mutex_unlock(&index->mutex);
+    // stat the new files
+    int dir_fd = dirfd(cache_dir);
+    unsigned stated = 0;
+    current = files.head;
+    while (current != NULL) {
+        if (current->value_i == 0) {
+            struct stat *status = malloc_assert(sizeof(struct stat));
+            if (fstatat(dir_fd, current->key, status, 0) == 0) {
+                current->user_data = status;
+                stated++;
+            }
+            else {
+                FREE_PTR(status);
+            }
+        }
+        current = current->next;
+    }
+    closedir(cache_dir);
+    // add the new files and remove the vanished files
+    pthread_mutex_lock(&index->mutex);
+    current = files.head;
+    while (current != NULL) {
+        // files added by the cache writers meanwhile are already indexed
+        if (current->user_data != NULL &&
+            raxFind(index->entries, (unsigned char *)current->key, sdslen(current->key), NULL) == 0)
+        {
+            const struct stat *status = (struct stat *)current->user_data;
+            entry_set(index, current->key, sdslen(current->key), (uint64_t)status->st_size, status->st_mtime);
+        }
+        current = current->next;
+    }
+    index_relink(index);
+    index->built = true;
+    MYMPD_LOG_INFO(NULL, "Synchronized %s cache index: %llu files, %llu bytes, %u new",
+        cache_disk_dirs[type], (unsigned long long)index->entries->numele, (unsigned long long)index->bytes, stated);
+    pthread_mutex_unlock(&index->mutex);
+    list_clear_user_data(&files, list_free_cb_ptr_user_data);
+    FREE_SDS(cache_path);
+    return true;
+}
+
+/**
+ * Empties the index after the cache directory was cleared
+ * @param type cache type
+ */
+void cache_disk_index_reset(enum cache_disk_type type) {
+    struct t_cache_disk_index *index = &indexes[type];
+    pthread_mutex_lock(&index->mutex);
+    index_clear(index);
+    index->entries = raxNew();
+    index->built = true;
+    pthread_mutex_unlock(&index->mutex);
+}
+
+/**
+ * Adds or updates a written cache file.
+ * The cache type is derived from the parent directory of the file.
+ * @param filepath path of the written file
+ */
+void cache_disk_index_add(const char *filepath) {
+    const char *name;
+    struct t_cache_disk_index *index = index_by_path(filepath, &name);
+    if (index == NULL) {
+        return;
+    }
+    struct stat status;
+    if (stat(filepath, &status) != 0) {
+        return;
+    }
+    pthread_mutex_lock(&index->mutex);
+    if (index->built == true) {
+        entry_set(index, name, strlen(name), (uint64_t)status.st_size, time(NULL));
+    }
+    pthread_mutex_unlock(&index->mutex);
+}
+
+/**
+ * Marks a cache file as most recently used
+ * @param filepath path of the accessed file
+ */
+void cache_disk_index_touch(const char *filepath) {
+    const char *name;
+    struct t_cache_disk_index *index = index_by_path(filepath, &name);
+    if (index == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&index->mutex);
+    void *data;
+    if (index->entries != NULL &&
+        raxFind(index->entries, (unsigned char *)name, strlen(name), &data) == 1)
+    {
+        struct t_cache_disk_entry *entry = (struct t_cache_disk_entry *)data;
+        entry->atime = time(NULL);
+        lru_list_touch(&index->lru, &entry->lru);
+    }
+    pthread_mutex_unlock(&index->mutex);
+}
+
+/**
+ * Counts a cache lookup
+ * @param type cache type, CACHE_DISK_TYPE_COUNT is ignored
+ * @param hit true for a cache hit, false for a miss
+ */
+void cache_disk_index_count(enum cache_disk_type type, bool hit) {
+    if (type >= CACHE_DISK_TYPE_COUNT) {
+        return;
+    }
+    struct t_cache_disk_index *index = &indexes[type];
+    pthread_mutex_lock(&index->mutex);
+    if (hit == true) {
+        index->hits++;
+    }
+    else {
+        index->misses++;
+    }
+    pthread_mutex_unlock(&index->mutex);
+}
+
+/**
+ * Removes the least recently used files until the cache is in its budget
+ * and the least recently used file is not expired.
+ * The files are removed from the index while holding the mutex
+ * and deleted from disc afterwards.
+ * Does nothing if the index is not built.
+ * @param cachedir cache base directory
+ * @param type cache type
+ * @param expire_time files last accessed before are removed, 0 to disable
+ * @param max_bytes byte budget of the cache, 0 for no limit
+ * @param max_files maximum number of files to remove in this call
+ * @param removed_cb callback for each removed file, can be NULL
+ * @return number of removed files
+ */
+unsigned cache_disk_index_crop(const char *cachedir, enum cache_disk_type type, time_t expire_time,
+        uint64_t max_bytes, unsigned max_files, cache_disk_removed_callback removed_cb)
+{
+    struct t_cache_disk_index *index = &indexes[type];
+    struct t_list victims;
+    list_init(&victims);
+    pthread_mutex_lock(&index->mutex);
+    while (index->built == true &&
+        index->lru.tail != NULL &&
+        victims.length < max_files)
+    {
+        struct t_cache_disk_entry *entry = LRU_LIST_ENTRY(index->lru.tail, struct t_cache_disk_entry, lru);
+        if (entry->atime >= expire_time &&
+            (max_bytes == 0 || index->bytes <= max_bytes))
+        {
+            break;
+        }
+        // the entry is removed from the index also if deleting fails to not block the crop
+        list_push(&victims, entry->name, 0, NULL, NULL);
+        entry_remove(index, entry);
+        index->evicted++;
+    }
+    pthread_mutex_unlock(&index->mutex);
+
+    unsigned deleted = 0;
+    sds filepath = sdsempty();
+    struct t_list_node *current = victims.head;
+    while (current != NULL) {
+        sdsclear(filepath);
+        filepath = sdscatfmt(filepath, "%s/%s/%S", cachedir, cache_disk_dirs[type], current->key);
+        MYMPD_LOG_DEBUG(NULL, "Deleting \"%s\"", filepath);
+        if (try_rm_file(filepath) != RM_FILE_ERROR) {
+            deleted++;
+        }
+        if (removed_cb != NULL) {
+            removed_cb(current->key);
+        }
+        current = current->next;
+    }
+    FREE_SDS(filepath);
+    list_clear(&victims);
+    return deleted;
+}
+
+/**
+ * Returns the size of all indexed files of a cache
+ * @param type cache type
+ * @return size in bytes
+ */
+uint64_t cache_disk_index_bytes(enum cache_disk_type type) {
+    struct t_cache_disk_index *index = &indexes[type];
+    pthread_mutex_lock(&index->mutex);
+    uint64_t bytes = index->bytes;
+    pthread_mutex_unlock(&index->mutex);
+    return bytes;
+}
+
+/**
+ * Prints size and hit rate of all caches as json object
+ * @param buffer already allocated sds string to append
+ * @return pointer to buffer
+ */
+sds cache_disk_index_stats(sds buffer) {
+    buffer = sdscatlen(buffer, "{", 1);
+    for (unsigned i = 0; i < CACHE_DISK_TYPE_COUNT; i++) {
+        struct t_cache_disk_index *index = &indexes[i];
+        pthread_mutex_lock(&index->mutex);
+        uint64_t lookups = index->hits + index->misses;
+        unsigned hit_rate = lookups > 0
+            ? (unsigned)(index->hits * 100 / lookups)
+            : 0;
+        if (i > 0) {
+            buffer = sdscatlen(buffer, ",", 1);
+        }
+        buffer = sdscatfmt(buffer, "\"%s\":{", cache_disk_dirs[i]);
+        buffer = tojson_bool(buffer, "indexed", index->built, true);
+        buffer = tojson_uint64(buffer, "files", (index->entries != NULL ? index->entries->numele : 0), true);
+        buffer = tojson_uint64(buffer, "bytes", index->bytes, true);
+        buffer = tojson_uint64(buffer, "hits", index->hits, true);
+        buffer = tojson_uint64(buffer, "misses", index->misses, true);
+        buffer = tojson_uint(buffer, "hitRate", hit_rate, true);
+        buffer = tojson_uint64(buffer, "evicted", index->evicted, false);
+        buffer = sdscatlen(buffer, "}", 1);
+        pthread_mutex_unlock(&index->mutex);
+    }
+    buffer = sdscatlen(buffer, "}", 1);
+    return buffer;
+}
+
+/**
+ * Frees all indexes
+ */
+void cache_disk_index_free(void) {
+    for (unsigned i = 0; i < CACHE_DISK_TYPE_COUNT; i++) {
+        struct t_cache_disk_index *index = &indexes[i];
+        pthread_mutex_lock(&index->mutex);
+        index_clear(index);
+        index->built = false;
+        index->hits = 0;
+        index->misses = 0;
+        index->evicted = 0;
+        pthread_mutex_unlock(&index->mutex);
+    }
+}
+
+/**
+ * Private functions
+ */
+
+/**
+ * Returns the index for a cache file by its parent directory
+ * @param filepath path of the cache file
+ * @param name pointer to set to the filename part
+ * @return the index or NULL if the file is not in a cache directory
+ */
+static struct t_cache_disk_index *index_by_path(const char *filepath, const char **name) {
+    const char *slash = strrchr(filepath, '/');
+    if (slash == NULL ||
+        slash == filepath)
+    {
+        return NULL;
+    }
+    *name = slash + 1;
+    const char *dir = slash - 1;
+    while (dir > filepath &&
+        *(dir - 1) != '/')
+    {
+        dir--;
+    }
+    size_t dir_len = (size_t)(slash - dir);
+    for (unsigned i = 0; i < CACHE_DISK_TYPE_COUNT; i++) {
+        if (strlen(cache_disk_dirs[i]) == dir_len &&
+            memcmp(dir, cache_disk_dirs[i], dir_len) == 0)
+        {
+            return &indexes[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Adds or replaces an entry as most recently used, the mutex must be held
+ * @param index the index
+ * @param name filename
+ * @param name_len length of the filename
+ * @param size file size
+ * @param atime last access time
+ */
+static void entry_set(struct t_cache_disk_index *index, const char *name, size_t name_len, uint64_t size, time_t atime) {
+    void *data;
+    struct t_cache_disk_entry *entry;
+    if (raxFind(index->entries, (unsigned char *)name, name_len, &data) == 1) {
+        entry = (struct t_cache_disk_entry *)data;
+        lru_list_unlink(&index->lru, &entry->lru);
+        index->bytes -= entry->size;
+    }
+    else {
+        entry = malloc_assert(sizeof(struct t_cache_disk_entry));
+        entry->name = sdsnewlen(name, name_len);
+        raxInsert(index->entries, (unsigned char *)entry->name, sdslen(entry->name), entry, NULL);
+    }
+    entry->size = size;
+    entry->atime = atime;
+    entry->generation = index->generation;
+    index->bytes += size;
+    lru_list_link_head(&index->lru, &entry->lru);
+}
+
+/**
+ * Removes and frees an entry, the mutex must be held
+ * @param index the index
+ * @param entry the entry
+ */
+static void entry_remove(struct t_cache_disk_index *index, struct t_cache_disk_entry *entry) {
+    raxRemove(index->entries, (unsigned char *)entry->name, sdslen(entry->name), NULL);
+    lru_list_unlink(&index->lru, &entry->lru);
+    index->bytes -= entry->size;
+    FREE_SDS(entry->name);
+    FREE_PTR(entry);
+}
+
+/**
+ * Frees all entries of an index, the mutex must be held
+ * @param index the index
+ */
+static void index_clear(struct t_cache_disk_index *index) {
+    struct t_lru_node *node = index->lru.head;
+    while (node != NULL) {
+        struct t_lru_node *next = node->next;
+        struct t_cache_disk_entry *current = LRU_LIST_ENTRY(node, struct t_cache_disk_entry, lru);
+        FREE_SDS(current->name);
+        FREE_PTR(current);
+        node = next;
+    }
+    if (index->entries != NULL) {
+        raxFree(index->entries);
+        index->entries = NULL;
+    }
+    lru_list_init(&index->lru);
+    index->bytes = 0;
+}
+
+/**
+ * Removes the entries not seen by the current sync
+ * and rebuilds the recency list ordered by the access time
+ * @param index the index, the mutex must be held
+ */
+static void index_relink(struct t_cache_disk_index *index) {
+    struct t_cache_disk_entry **sorted = malloc_assert((index->entries->numele + 1) * sizeof(struct t_cache_disk_entry *));
+    size_t count = 0;
+    raxIterator iter;
+    raxStart(&iter, index->entries);
+    raxSeek(&iter, "^", NULL, 0);
+    while (raxNext(&iter)) {
+        sorted[count++] = (struct t_cache_disk_entry *)iter.data;
+    }
+    raxStop(&iter);
+    lru_list_init(&index->lru);
+    qsort(sorted, count, sizeof(struct t_cache_disk_entry *), cmp_atime_desc);
+    for (size_t i = count; i > 0; i--) {
+        struct t_cache_disk_entry *entry = sorted[i - 1];
+        if (entry->generation != index->generation) {
+            // file has vanished
+            raxRemove(index->entries, (unsigned char *)entry->name, sdslen(entry->name), NULL);
+            index->bytes -= entry->size;
+            FREE_SDS(entry->name);
+            FREE_PTR(entry);
+            continue;
+        }
+        lru_list_link_head(&index->lru, &entry->lru);
+    }
+    FREE_PTR(sorted);
+}
+
+/**
+ * Compares two entries by access time, most recent first
+ * @param a pointer to first entry pointer
+ * @param b pointer to second entry pointer
+ * @return compare result
+ */
+static int cmp_atime_desc(const void *a, const void *b) {
+    const struct t_cache_disk_entry *entry_a = *(struct t_cache_disk_entry * const *)a;
+    const struct t_cache_disk_entry *entry_b = *(struct t_cache_disk_entry * const *)b;
+    if (entry_a->atime > entry_b->atime) {
+        return -1;
+    }
+    if (entry_a->atime < entry_b->atime) {
+        return 1;
+    }
+    return 0;
+}
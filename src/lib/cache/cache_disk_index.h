@@ -0,0 +1,51 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2026 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+/*! \file
+ * \brief In-memory index of the disk cache files
+ */
+
+#ifndef MYMPD_CACHE_DISK_INDEX_H
+#define MYMPD_CACHE_DISK_INDEX_H
+
+#include "dist/sds/sds.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+/**
+ * Disk cache types, one for each cache subdirectory
+ */
+enum cache_disk_type {
+    CACHE_DISK_TYPE_COVER = 0,  //!< DIR_CACHE_COVER
+    CACHE_DISK_TYPE_HTTP,       //!< DIR_CACHE_HTTP
+    CACHE_DISK_TYPE_LYRICS,     //!< DIR_CACHE_LYRICS
+    CACHE_DISK_TYPE_MISC,       //!< DIR_CACHE_MISC
+    CACHE_DISK_TYPE_THUMBS,     //!< DIR_CACHE_THUMBS
+    CACHE_DISK_TYPE_COUNT
+};
+
+/**
+ * Callback for files removed by a crop
+ * @param name filename without the path
+ */
+typedef void (*cache_disk_removed_callback)(const char *name);
+
+const char *cache_disk_index_dir(enum cache_disk_type type);
+enum cache_disk_type cache_disk_index_type(const char *dir);
+bool cache_disk_index_sync(const char *cachedir, enum cache_disk_type type);
+void cache_disk_index_reset(enum cache_disk_type type);
+void cache_disk_index_add(const char *filepath);
+void cache_disk_index_touch(const char *filepath);
+void cache_disk_index_count(enum cache_disk_type type, bool hit);
+unsigned cache_disk_index_crop(const char *cachedir, enum cache_disk_type type, time_t expire_time,
+        uint64_t max_bytes, unsigned max_files, cache_disk_removed_callback removed_cb);
+uint64_t cache_disk_index_bytes(enum cache_disk_type type);
+sds cache_disk_index_stats(sds buffer);
+void cache_disk_index_free(void);
+
+#endif
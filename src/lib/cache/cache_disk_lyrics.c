@@ -11,6 +11,7 @@
 #include "compile_time.h"
 #include "src/lib/cache/cache_disk_lyrics.h"
 
+#include "src/lib/cache/cache_disk_index.h"
 #include "src/lib/filehandler.h"
 #include "src/lib/log.h"
 #include "src/lib/sds/sds_extras.h"
@@ -48,5 +49,8 @@ sds cache_disk_lyrics_write_file(const char *cachedir, const char *uri, const ch
     if (rc == false) {
         FREE_SDS(filepath);
     }
+    else {
+        cache_disk_index_add(filepath);
+    }
     return filepath;
 }
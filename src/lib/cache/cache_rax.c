@@ -20,6 +20,9 @@
 bool cache_init(struct t_cache *cache) {
     cache->building = false;
     cache->cache = NULL;
+    cache->index = NULL;
+    cache->pool = NULL;
+    cache->map = NULL;
     cache->mtime = 0;
     int rc = pthread_rwlock_init(&cache->rwlock, NULL);
     if (rc == 0) {
@@ -37,6 +40,9 @@ bool cache_init(struct t_cache *cache) {
  */
 bool cache_free(struct t_cache *cache) {
     cache->cache = NULL;
+    cache->index = NULL;
+    cache->pool = NULL;
+    cache->map = NULL;
     int rc = pthread_rwlock_destroy(&cache->rwlock);
     if (rc == 0) {
         return true;
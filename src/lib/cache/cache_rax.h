@@ -16,14 +16,21 @@
 #include <pthread.h>
 #include <stdbool.h>
 
+struct t_album_bin;
+struct t_album_index;
+struct t_str_pool;
+
 /**
  * Holds cache information
  */
 struct t_cache {
-    bool building;             //!< true if the mympd_worker thread is creating the cache
-    rax *cache;                //!< pointer to the cache
-    pthread_rwlock_t rwlock;   //!< pthreads read-write lock object
-    time_t mtime;              //!< modification time
+    bool building;                //!< true if the mympd_worker thread is creating the cache
+    rax *cache;                   //!< pointer to the cache
+    struct t_album_index *index;  //!< sort indexes for the cache, owned by the cache
+    struct t_str_pool *pool;      //!< normalized tag values for searching, owned by the cache
+    struct t_album_bin *map;      //!< memory mapped album cache file the albums reference, owned by the cache
+    pthread_rwlock_t rwlock;      //!< pthreads read-write lock object
+    time_t mtime;                 //!< modification time
 };
 
 bool cache_init(struct t_cache *cache);
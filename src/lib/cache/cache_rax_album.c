@@ -14,12 +14,17 @@
 #include "dist/mpack/mpack.h"
 #include "dist/rax/rax.h"
 #include "src/lib/album.h"
+#include "src/lib/cache/cache_rax_album_bin.h"
+#include "src/lib/cache/cache_rax_album_index.h"
+#include "src/lib/cache/cache_rax_album_songs.h"
 #include "src/lib/filehandler.h"
+#include "src/lib/json/json_print.h"
 #include "src/lib/log.h"
 #include "src/lib/mem.h"
 #include "src/lib/mpack.h"
 #include "src/lib/sds/sds_extras.h"
 #include "src/lib/sds/sds_hash.h"
+#include "src/lib/str_pool.h"
 #include "src/lib/utility.h"
 #include "src/mympd_client/tags.h"
 
@@ -34,6 +39,8 @@
 
 enum { ALBUM_CACHE_VERSION = 1 }; //!< Internal album cache version
 
+static rax *album_cache_read_mpack(const char *filepath, const struct t_albums_config *album_config,
+        struct t_mympd_mpd_tags *album_tags);
 static struct t_album *album_from_mpack_node(mpack_node_t album_node, const struct t_mympd_mpd_tags *tags,
         sds *key, const struct t_albums_config *album_config);
 
@@ -71,21 +78,31 @@ const char *lookup_album_mode(enum album_modes mode) {
 }
 
 /**
- * Removes the album cache file
+ * Removes the album cache file and the song index for incremental updates
  * @param workdir myMPD working directory
  * @return bool true on success, else false
  */
 bool album_cache_remove(sds workdir) {
     sds filepath = sdscatfmt(sdsempty(), "%S/%s/%s", workdir, DIR_WORK_TAGS, FILENAME_ALBUMCACHE);
     int rc = try_rm_file(filepath);
+    sdsclear(filepath);
+    filepath = sdscatfmt(filepath, "%S/%s/%s", workdir, DIR_WORK_TAGS, FILENAME_ALBUMCACHE_MPACK);
+    if (try_rm_file(filepath) == RM_FILE_ERROR) {
+        rc = RM_FILE_ERROR;
+    }
     FREE_SDS(filepath);
+    if (album_songs_remove_file(workdir) == false) {
+        return false;
+    }
     return rc == RM_FILE_ERROR
         ? false
         : true;
 }
 
 /**
- * Reads the album cache from disc
+ * Reads the album cache from disc.
+ * The album cache file is mapped and the albums reference its strings in place.
+ * An album cache from older myMPD versions is converted.
  * @param album_cache pointer to t_cache struct
  * @param workdir myMPD working directory
  * @param album_config album configuration
@@ -97,99 +114,31 @@ bool album_cache_read(struct t_cache *album_cache, sds workdir, const struct t_a
         MEASURE_START
     #endif
     sds filepath = sdscatfmt(sdsempty(), "%S/%s/%s", workdir, DIR_WORK_TAGS, FILENAME_ALBUMCACHE);
-    if (testfile_read(filepath) == false) {
+    if (testfile_read(filepath) == false &&
+        album_cache_convert(workdir, album_config) == false)
+    {
         FREE_SDS(filepath);
         return false;
     }
     album_cache->mtime = get_mtime(filepath);
-
-    mpack_tree_t tree;
-    mpack_tree_init_filename(&tree, filepath, 0);
-    mpack_tree_set_error_handler(&tree, log_mpack_node_error);
+    struct t_album_bin *album_bin = album_bin_open(filepath);
     FREE_SDS(filepath);
-    mpack_tree_parse(&tree);
-    mpack_node_t root = mpack_tree_root(&tree);
-
-    // check for expected cache version
-    int album_cache_version = mpack_node_int(mpack_node_map_cstr(root, "cacheVersion"));
-    if (album_cache_version != ALBUM_CACHE_VERSION) {
-        mpack_tree_destroy(&tree);
-        MYMPD_LOG_WARN(NULL, "Unexpected cache version");
-        album_cache_remove(workdir);
-        return false;
-    }
-
-    // check for expected album_mode
-    enum album_modes album_mode = (enum album_modes)mpack_node_int(mpack_node_map_cstr(root, "albumMode"));
-    if (album_mode != album_config->mode) {
-        mpack_tree_destroy(&tree);
-        MYMPD_LOG_WARN(NULL, "Unexpected album mode, discarding cache");
-        album_cache_remove(workdir);
-        return false;
-    }
-
-    // check for expected album_group_tag
-    enum mpd_tag_type group_tag = (enum mpd_tag_type)mpack_node_int(mpack_node_map_cstr(root, "albumGroupTag"));
-    if (group_tag != album_config->group_tag) {
-        mpack_tree_destroy(&tree);
-        MYMPD_LOG_WARN(NULL, "Unexpected album group tag, discarding cache");
+    if (album_bin == NULL) {
         album_cache_remove(workdir);
         return false;
     }
-
-    // check for expected album_unknown setting
-    bool album_unknown = mpack_node_bool(mpack_node_map_cstr(root, "albumUnknown"));
-    if (album_unknown != album_config->unknown) {
-        mpack_tree_destroy(&tree);
-        MYMPD_LOG_WARN(NULL, "Unexpected album_unknown setting, discarding cache");
+    if (album_bin_check_config(album_bin, album_config) == false) {
+        album_bin_close(album_bin);
         album_cache_remove(workdir);
         return false;
     }
 
-    // read tags array
-    struct t_mympd_mpd_tags *album_tags = malloc_assert(sizeof(struct t_mympd_mpd_tags));
-    mympd_mpd_tags_reset(album_tags);
-
-    mpack_node_t tags_node = mpack_node_map_cstr(root, "tags");
-    size_t len = mpack_node_array_length(tags_node);
-    for (size_t i = 0; i < len; i++) {
-        mpack_node_t value_node = mpack_node_array_at(tags_node, i);
-        char *value = mpack_node_cstr_alloc(value_node, JSONRPC_STR_MAX);
-        if (value == NULL) {
-            break;
-        }
-        enum mpd_tag_type tag = mpd_tag_name_parse(value);
-        if (tag != MPD_TAG_UNKNOWN) {
-            album_tags->tags[album_tags->len++] = tag;
-        }
-        else {
-            MYMPD_LOG_ERROR(NULL, "Unkown MPD tag type: \"%s\"", value);
-        }
-        MPACK_FREE(value);
-    }
-
-    // read albums array
-    mpack_node_t albums_node = mpack_node_map_cstr(root, "albums");
-    len = mpack_node_array_length(albums_node);
-    sds key = sdsempty();
     album_cache->building = true;
-    album_cache->cache = raxNew();
-
-    for (size_t i = 0; i < len; i++) {
-        mpack_node_t album_node = mpack_node_array_at(albums_node, i);
-        struct t_album *album = album_from_mpack_node(album_node, album_tags, &key, album_config);
-        if (album != NULL) {
-            if (raxTryInsert(album_cache->cache, (unsigned char *)key, sdslen(key), album, NULL) == 0) {
-                MYMPD_LOG_ERROR(NULL, "Duplicate key in album cache file found: %s", key);
-                album_free(album);
-            }
-        }
-    }
-    FREE_SDS(key);
-    // clean up and check for errors
-    bool rc = mpack_tree_destroy(&tree) != mpack_ok
-        ? false
-        : true;
+    album_cache->cache = album_bin_load(album_bin);
+    album_cache->index = NULL;
+    album_cache->pool = NULL;
+    album_cache->map = album_bin;
+    bool rc = album_cache->cache != NULL;
     if (rc == false) {
         MYMPD_LOG_ERROR("default", "Reading album cache failed, discarding cache");
         album_cache_remove(workdir);
@@ -197,8 +146,8 @@ bool album_cache_read(struct t_cache *album_cache, sds workdir, const struct t_a
     }
     else {
         MYMPD_LOG_INFO(NULL, "Read %" PRIu64 " album(s) from disc", album_cache->cache->numele);
+        album_cache_normalize(album_cache);
     }
-    FREE_PTR(album_tags);
     album_cache->building = false;
     #ifdef MYMPD_DEBUG
         MEASURE_END
@@ -208,7 +157,37 @@ bool album_cache_read(struct t_cache *album_cache, sds workdir, const struct t_a
 }
 
 /**
- * Saves the album cache to disc in mpack format
+ * Converts the mpack album cache of older myMPD versions to the binary format.
+ * The mpack file is removed.
+ * @param workdir myMPD working directory
+ * @param album_config album configuration
+ * @return true on success, else false
+ */
+bool album_cache_convert(sds workdir, const struct t_albums_config *album_config) {
+    sds filepath = sdscatfmt(sdsempty(), "%S/%s/%s", workdir, DIR_WORK_TAGS, FILENAME_ALBUMCACHE_MPACK);
+    if (testfile_read(filepath) == false) {
+        FREE_SDS(filepath);
+        return false;
+    }
+    MYMPD_LOG_INFO(NULL, "Converting album cache to the binary format");
+    struct t_mympd_mpd_tags album_tags;
+    mympd_mpd_tags_reset(&album_tags);
+    rax *cache = album_cache_read_mpack(filepath, album_config, &album_tags);
+    bool rc = false;
+    if (cache != NULL) {
+        sds bin_filepath = sdscatfmt(sdsempty(), "%S/%s/%s", workdir, DIR_WORK_TAGS, FILENAME_ALBUMCACHE);
+        rc = album_bin_write(cache, bin_filepath, &album_tags, album_config, true);
+        raxFree(cache);
+        FREE_SDS(bin_filepath);
+    }
+    // the mpack file is not used anymore
+    rm_file(filepath);
+    FREE_SDS(filepath);
+    return rc;
+}
+
+/**
+ * Saves the album cache to disc
  * @param album_cache pointer to t_cache struct
  * @param workdir myMPD working directory
  * @param album_tags album tags to write
@@ -224,100 +203,20 @@ bool album_cache_write(struct t_cache *album_cache, sds workdir, const struct t_
         return true;
     }
     MYMPD_LOG_INFO(NULL, "Saving album cache to disc");
-    mpack_writer_t writer;
-    sds tmp_file = sdscatfmt(sdsempty(), "%S/%s/%s.XXXXXX", workdir, DIR_WORK_TAGS, FILENAME_ALBUMCACHE);
-    FILE *fp = open_tmp_file(tmp_file);
-    if (fp == NULL) {
-        FREE_SDS(tmp_file);
-        return false;
-    }
-    // init mpack
-    mpack_writer_init_stdfile(&writer, fp, true);
-    mpack_writer_set_error_handler(&writer, log_mpack_write_error);
-    mpack_build_map(&writer);
-    mpack_write_kv(&writer, "cacheVersion", ALBUM_CACHE_VERSION);
-    mpack_write_kv(&writer, "albumMode", album_config->mode);
-    mpack_write_kv(&writer, "albumGroupTag", album_config->group_tag);
-    mpack_write_kv(&writer, "albumUnknown", album_config->unknown);
-    mpack_write_cstr(&writer, "tags");
-    mpack_start_array(&writer, (uint32_t)album_tags->len);
-    for (unsigned tagnr = 0; tagnr < album_tags->len; ++tagnr) {
-        mpack_write_cstr(&writer, mpd_tag_name(album_tags->tags[tagnr]));
-    }
-    mpack_finish_array(&writer);
-    mpack_write_cstr(&writer, "albums");
-    mpack_start_array(&writer, (uint32_t)album_cache->cache->numele);
-    raxIterator iter;
-    raxStart(&iter, album_cache->cache);
-    raxSeek(&iter, "^", NULL, 0);
-    while (raxNext(&iter)) {
-        const struct t_album *album = (struct t_album *)iter.data;
-        mpack_build_map(&writer);
-        mpack_write_kv(&writer, "uri", album_get_uri(album));
-        if (album_config->unknown == true) {
-            mpack_write_kv(&writer, "Unknown", album_get_unknown(album));
-        }
-        mpack_write_kv(&writer, "Discs", album_get_disc_count(album));
-        mpack_write_kv(&writer, "Songs", album_get_song_count(album));
-        mpack_write_kv(&writer, "Duration", album_get_total_time(album));
-        mpack_write_kv(&writer, "Last-Modified", (uint64_t)album_get_last_modified(album));
-        mpack_write_kv(&writer, "Added", (uint64_t)album_get_added(album));
-        mpack_write_cstr(&writer, "AlbumId");
-        mpack_write_str(&writer, (char *)iter.key, (uint32_t)iter.key_len);
-        for (unsigned tagnr = 0; tagnr < album_tags->len; ++tagnr) {
-            enum mpd_tag_type tag = album_tags->tags[tagnr];
-            if (album_get_tag(album, tag, 0) == NULL) {
-                // do not write empty tags
-                continue;
-            }
-            if (is_multivalue_tag(tag) == true) {
-                const char *value;
-                unsigned count = 0;
-                mpack_write_cstr(&writer, mpd_tag_name(tag));
-                mpack_build_array(&writer);
-                while ((value = album_get_tag(album, tag, count)) != NULL) {
-                    mpack_write_cstr(&writer, value);
-                    count++;
-                }
-                mpack_complete_array(&writer);
-            }
-            else {
-                mpack_write_kv(&writer, mpd_tag_name(tag), album_get_tag(album, tag, 0));
-            }
-        }
-        mpack_complete_map(&writer);
-        if (free_data == true) {
-            album_free((struct t_album *)iter.data);
-        }
-    }
-    raxStop(&iter);
-    mpack_finish_array(&writer);
-    mpack_complete_map(&writer);
+    // a mapped album cache file stays valid, the new file is renamed over it
+    sds filepath = sdscatfmt(sdsempty(), "%S/%s/%s", workdir, DIR_WORK_TAGS, FILENAME_ALBUMCACHE);
+    bool rc = album_bin_write(album_cache->cache, filepath, album_tags, album_config, free_data);
+    FREE_SDS(filepath);
     if (free_data == true) {
         raxFree(album_cache->cache);
         album_cache->cache = NULL;
+        album_index_free(album_cache->index);
+        album_cache->index = NULL;
+        str_pool_free(album_cache->pool);
+        album_cache->pool = NULL;
+        album_bin_close(album_cache->map);
+        album_cache->map = NULL;
     }
-    // finish writing
-    bool rc = mpack_writer_destroy(&writer) != mpack_ok
-        ? false
-        : true;
-    if (rc == false) {
-        rm_file(tmp_file);
-        MYMPD_LOG_ERROR("default", "An error occurred encoding the data");
-        FREE_SDS(tmp_file);
-        return false;
-    }
-    // rename tmp file
-    sds filepath = sdscatlen(sdsempty(), tmp_file, sdslen(tmp_file) - 7);
-    errno = 0;
-    if (rename(tmp_file, filepath) == -1) {
-        MYMPD_LOG_ERROR(NULL, "Rename file from \"%s\" to \"%s\" failed", tmp_file, filepath);
-        MYMPD_LOG_ERRNO(NULL, errno);
-        rm_file(tmp_file);
-        rc = false;
-    }
-    FREE_SDS(filepath);
-    FREE_SDS(tmp_file);
     return rc;
 }
 
@@ -469,16 +368,102 @@ struct t_album *album_cache_get_album(struct t_cache *album_cache, sds key) {
     return (struct t_album *) data;
 }
 
+/**
+ * Normalizes the tag values of all albums for searching.
+ * The normalized values are stored in the string pool of the album cache.
+ * @param album_cache pointer to t_cache struct
+ */
+void album_cache_normalize(struct t_cache *album_cache) {
+    #ifdef MYMPD_DEBUG
+        MEASURE_INIT
+        MEASURE_START
+    #endif
+    str_pool_free(album_cache->pool);
+    album_cache->pool = str_pool_new();
+    raxIterator iter;
+    raxStart(&iter, album_cache->cache);
+    raxSeek(&iter, "^", NULL, 0);
+    while (raxNext(&iter)) {
+        album_normalize_tags((struct t_album *)iter.data, album_cache->pool);
+    }
+    raxStop(&iter);
+    MYMPD_LOG_DEBUG(NULL, "Album cache string pool: %" PRIu64 " values, %lu bytes",
+        album_cache->pool->values->numele, (unsigned long)album_cache->pool->bytes);
+    #ifdef MYMPD_DEBUG
+        MEASURE_END
+        MEASURE_PRINT(NULL, "Album cache normalize")
+    #endif
+}
+
+/**
+ * Prints the memory usage of the album cache as json object
+ * @param buffer already allocated sds string to append the object
+ * @param album_cache pointer to t_cache struct
+ * @return pointer to buffer
+ */
+sds album_cache_memory_stats(sds buffer, const struct t_cache *album_cache) {
+    uint64_t albums = 0;
+    size_t album_bytes = 0;
+    if (album_cache->cache != NULL) {
+        albums = album_cache->cache->numele;
+        raxIterator iter;
+        raxStart(&iter, album_cache->cache);
+        raxSeek(&iter, "^", NULL, 0);
+        while (raxNext(&iter)) {
+            album_bytes += album_get_memory_size((struct t_album *)iter.data);
+        }
+        raxStop(&iter);
+    }
+    size_t normalized_bytes = album_cache->pool != NULL
+        ? album_cache->pool->bytes
+        : 0;
+    struct t_str_pool_stats intern_stats;
+    str_pool_get_stats(&intern_stats);
+    size_t mapped_bytes = album_cache->map != NULL
+        ? album_bin_get_size(album_cache->map)
+        : 0;
+    size_t total_bytes = album_bytes + normalized_bytes + intern_stats.bytes;
+    uint64_t bytes_per_album = albums > 0
+        ? total_bytes / albums
+        : 0;
+    buffer = sdscatlen(buffer, "{", 1);
+    buffer = tojson_uint64(buffer, "albums", albums, true);
+    buffer = tojson_uint64(buffer, "albumBytes", album_bytes, true);
+    buffer = tojson_uint64(buffer, "normalizedBytes", normalized_bytes, true);
+    buffer = tojson_uint(buffer, "internedValues", intern_stats.values, true);
+    buffer = tojson_uint64(buffer, "internedBytes", intern_stats.bytes, true);
+    buffer = tojson_uint64(buffer, "internedRefs", intern_stats.refs, true);
+    buffer = tojson_uint64(buffer, "mappedBytes", mapped_bytes, true);
+    buffer = tojson_uint64(buffer, "bytesPerAlbum", bytes_per_album, false);
+    buffer = sdscatlen(buffer, "}", 1);
+    return buffer;
+}
+
 /**
  * Frees the album cache
  * @param album_cache pointer to t_cache struct
  */
 void album_cache_free(struct t_cache *album_cache) {
-    if (album_cache->cache == NULL) {
-        return;
+    album_index_free(album_cache->index);
+    album_cache->index = NULL;
+    if (album_cache->cache != NULL) {
+        album_cache_free_rt(album_cache->cache);
+        album_cache->cache = NULL;
     }
-    album_cache_free_rt(album_cache->cache);
-    album_cache->cache = NULL;
+    // the albums reference the pool strings and the mapped file
+    str_pool_free(album_cache->pool);
+    album_cache->pool = NULL;
+    album_bin_close(album_cache->map);
+    album_cache->map = NULL;
+}
+
+/**
+ * Frees an allocated album cache struct and its content
+ * @param album_cache Pointer to allocated t_cache struct
+ */
+void album_cache_free_void(void *album_cache) {
+    album_cache_free((struct t_cache *)album_cache);
+    FREE_PTR(album_cache);
 }
 
 /**
@@ -498,16 +483,82 @@ void album_cache_free_rt(rax *album_cache_rt) {
 }
 
 /**
- * Frees the album cache radix tree
- * @param album_cache_rt Pointer to album cache radix tree
+ * Private functions
  */
-void album_cache_free_rt_void(void *album_cache_rt) {
-    album_cache_free_rt((rax *)album_cache_rt);
-}
 
 /**
- * Private functions
+ * Reads the mpack album cache file of older myMPD versions
+ * @param filepath album cache file
+ * @param album_config album configuration
+ * @param album_tags pointer to t_mympd_mpd_tags struct to populate with the album tags of the file
+ * @return the album cache or NULL on error
  */
+static rax *album_cache_read_mpack(const char *filepath, const struct t_albums_config *album_config,
+        struct t_mympd_mpd_tags *album_tags)
+{
+    mpack_tree_t tree;
+    mpack_tree_init_filename(&tree, filepath, 0);
+    mpack_tree_set_error_handler(&tree, log_mpack_node_error);
+    mpack_tree_parse(&tree);
+    mpack_node_t root = mpack_tree_root(&tree);
+
+    // check for expected cache version and album settings
+    int album_cache_version = mpack_node_int(mpack_node_map_cstr(root, "cacheVersion"));
+    enum album_modes album_mode = (enum album_modes)mpack_node_int(mpack_node_map_cstr(root, "albumMode"));
+    enum mpd_tag_type group_tag = (enum mpd_tag_type)mpack_node_int(mpack_node_map_cstr(root, "albumGroupTag"));
+    bool album_unknown = mpack_node_bool(mpack_node_map_cstr(root, "albumUnknown"));
+    if (album_cache_version != ALBUM_CACHE_VERSION ||
+        album_mode != album_config->mode ||
+        group_tag != album_config->group_tag ||
+        album_unknown != album_config->unknown)
+    {
+        mpack_tree_destroy(&tree);
+        MYMPD_LOG_WARN(NULL, "Unexpected cache version or album settings, discarding cache");
+        return NULL;
+    }
+
+    // read tags array
+    mpack_node_t tags_node = mpack_node_map_cstr(root, "tags");
+    size_t len = mpack_node_array_length(tags_node);
+    for (size_t i = 0; i < len; i++) {
+        mpack_node_t value_node = mpack_node_array_at(tags_node, i);
+        char *value = mpack_node_cstr_alloc(value_node, JSONRPC_STR_MAX);
+        if (value == NULL) {
+            break;
+        }
+        enum mpd_tag_type tag = mpd_tag_name_parse(value);
+        if (tag != MPD_TAG_UNKNOWN) {
+            album_tags->tags[album_tags->len++] = tag;
+        }
+        else {
+            MYMPD_LOG_ERROR(NULL, "Unkown MPD tag type: \"%s\"", value);
+        }
+        MPACK_FREE(value);
+    }
+
+    // read albums array
+    mpack_node_t albums_node = mpack_node_map_cstr(root, "albums");
+    len = mpack_node_array_length(albums_node);
+    sds key = sdsempty();
+    rax *cache = raxNew();
+    for (size_t i = 0; i < len; i++) {
+        mpack_node_t album_node = mpack_node_array_at(albums_node, i);
+        struct t_album *album = album_from_mpack_node(album_node, album_tags, &key, album_config);
+        if (album != NULL) {
+            if (raxTryInsert(cache, (unsigned char *)key, sdslen(key), album, NULL) == 0) {
+                MYMPD_LOG_ERROR(NULL, "Duplicate key in album cache file found: %s", key);
+                album_free(album);
+            }
+        }
+    }
+    FREE_SDS(key);
+    if (mpack_tree_destroy(&tree) != mpack_ok) {
+        MYMPD_LOG_ERROR("default", "Reading album cache failed");
+        album_cache_free_rt(cache);
+        return NULL;
+    }
+    return cache;
+}
 
 /**
  * Creates a mpd_song struct from cache
@@ -0,0 +1,405 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2026 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+/*! \file
+ * \brief Memory mapped binary album cache file
+ *
+ * The file consists of a fixed header, the album records sorted by album key,
+ * the tag values of the albums and a string table. All references are offsets,
+ * the file is mapped read-only and the albums reference the strings in place.
+ * Changes to the albums are made in memory, the mapping is never written.
+ */
+
+#include "compile_time.h"
+#include "src/lib/cache/cache_rax_album_bin.h"
+
+#include "src/lib/album.h"
+#include "src/lib/cache/cache_rax_album.h"
+#include "src/lib/filehandler.h"
+#include "src/lib/log.h"
+#include "src/lib/mem.h"
+#include "src/lib/sds/sds_extras.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * Private definitions
+ */
+
+#define ALBUM_BIN_MAGIC "MYMPDALB"      //!< File magic
+enum { ALBUM_BIN_VERSION = 1 };         //!< File format version
+
+/**
+ * File header
+ */
+struct t_album_bin_header {
+    char magic[8];            //!< ALBUM_BIN_MAGIC without terminating null
+    uint32_t version;         //!< ALBUM_BIN_VERSION
+    uint32_t album_mode;      //!< album mode of the cache
+    int32_t group_tag;        //!< album group tag of the cache
+    uint32_t unknown;         //!< 1 if the unknown album is enabled
+    uint32_t album_count;     //!< number of album records
+    uint32_t value_count;     //!< number of tag value records
+    uint64_t albums_offset;   //!< file offset of the album records
+    uint64_t values_offset;   //!< file offset of the tag value records
+    uint64_t strings_offset;  //!< file offset of the string table
+    uint64_t strings_size;    //!< size of the string table
+};
+
+/**
+ * Album record, the records are sorted by key
+ */
+struct t_album_bin_record {
+    uint32_t key;            //!< string offset of the album key
+    uint32_t key_len;        //!< length of the album key
+    uint32_t uri;            //!< string offset of the first song uri
+    uint32_t values_start;   //!< index of the first tag value record
+    uint32_t values_len;     //!< number of tag value records
+    uint32_t disc_count;     //!< number of discs
+    uint32_t song_count;     //!< number of songs
+    uint32_t total_time;     //!< total playtime
+    uint32_t unknown;        //!< 1 if this is the unknown album
+    uint32_t reserved;       //!< padding, always 0
+    int64_t last_modified;   //!< last-modified timestamp
+    int64_t added;           //!< added timestamp
+};
+
+/**
+ * Tag value record
+ */
+struct t_album_bin_value {
+    uint32_t tag;    //!< mpd tag type
+    uint32_t value;  //!< string offset of the value
+};
+
+/**
+ * Memory mapped album cache file
+ */
+struct t_album_bin {
+    void *data;                                //!< start of the mapping
+    size_t size;                               //!< size of the mapping
+    const struct t_album_bin_header *header;   //!< file header
+    const struct t_album_bin_record *albums;   //!< album records
+    const struct t_album_bin_value *values;    //!< tag value records
+    const char *strings;                       //!< string table
+};
+
+static bool check_section(uint64_t offset, uint64_t count, uint64_t size, uint64_t file_size);
+static uint32_t add_string(rax *strings, sds *table, const char *value, size_t len, bool *overflow);
+
+/**
+ * Public functions
+ */
+
+/**
+ * Maps an album cache file read-only and validates its structure
+ * @param filepath path of the album cache file
+ * @return the mapped file or NULL on error
+ */
+struct t_album_bin *album_bin_open(const char *filepath) {
+    errno = 0;
+    int fd = open(filepath, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        MYMPD_LOG_ERROR(NULL, "Can not open file \"%s\"", filepath);
+        MYMPD_LOG_ERRNO(NULL, errno);
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == -1 ||
+        (size_t)st.st_size < sizeof(struct t_album_bin_header))
+    {
+        MYMPD_LOG_ERROR(NULL, "Invalid album cache file \"%s\"", filepath);
+        close(fd);
+        return NULL;
+    }
+    size_t size = (size_t)st.st_size;
+    void *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // the mapping stays valid after closing the file descriptor
+    close(fd);
+    if (data == MAP_FAILED) {
+        MYMPD_LOG_ERROR(NULL, "Can not map file \"%s\"", filepath);
+        MYMPD_LOG_ERRNO(NULL, errno);
+        return NULL;
+    }
+    const struct t_album_bin_header *header = (const struct t_album_bin_header *)data;
+    if (memcmp(header->magic, ALBUM_BIN_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != ALBUM_BIN_VERSION ||
+        check_section(header->albums_offset, header->album_count, sizeof(struct t_album_bin_record), size) == false ||
+        check_section(header->values_offset, header->value_count, sizeof(struct t_album_bin_value), size) == false ||
+        check_section(header->strings_offset, header->strings_size, 1, size) == false ||
+        header->strings_size == 0 ||
+        ((const char *)data)[header->strings_offset + header->strings_size - 1] != '\0')
+    {
+        MYMPD_LOG_WARN(NULL, "Unexpected album cache file format");
+        munmap(data, size);
+        return NULL;
+    }
+    struct t_album_bin *album_bin = malloc_assert(sizeof(struct t_album_bin));
+    album_bin->data = data;
+    album_bin->size = size;
+    album_bin->header = header;
+    album_bin->albums = (const struct t_album_bin_record *)((const char *)data + header->albums_offset);
+    album_bin->values = (const struct t_album_bin_value *)((const char *)data + header->values_offset);
+    album_bin->strings = (const char *)data + header->strings_offset;
+    return album_bin;
+}
+
+/**
+ * Unmaps the album cache file.
+ * All albums loaded from the file must be freed before.
+ * @param album_bin the mapped file, can be NULL
+ */
+void album_bin_close(struct t_album_bin *album_bin) {
+    if (album_bin == NULL) {
+        return;
+    }
+    munmap(album_bin->data, album_bin->size);
+    FREE_PTR(album_bin);
+}
+
+/**
+ * Gets the size of the mapped file
+ * @param album_bin the mapped file, can be NULL
+ * @return size in bytes
+ */
+size_t album_bin_get_size(const struct t_album_bin *album_bin) {
+    return album_bin != NULL
+        ? album_bin->size
+        : 0;
+}
+
+/**
+ * Checks if the album cache file was created with the album configuration
+ * @param album_bin the mapped file
+ * @param album_config album configuration
+ * @return true if the configuration matches, else false
+ */
+bool album_bin_check_config(const struct t_album_bin *album_bin, const struct t_albums_config *album_config) {
+    if (album_bin->header->album_mode != (uint32_t)album_config->mode) {
+        MYMPD_LOG_WARN(NULL, "Unexpected album mode, discarding cache");
+        return false;
+    }
+    if (album_bin->header->group_tag != (int32_t)album_config->group_tag) {
+        MYMPD_LOG_WARN(NULL, "Unexpected album group tag, discarding cache");
+        return false;
+    }
+    if ((album_bin->header->unknown == 1) != album_config->unknown) {
+        MYMPD_LOG_WARN(NULL, "Unexpected album_unknown setting, discarding cache");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Creates the album cache from the mapped file.
+ * The tag values of the albums point into the mapping,
+ * the mapping must be closed after the albums are freed.
+ * @param album_bin the mapped file
+ * @return the album cache or NULL if the file is corrupt
+ */
+rax *album_bin_load(const struct t_album_bin *album_bin) {
+    const struct t_album_bin_header *header = album_bin->header;
+    rax *album_cache = raxNew();
+    for (uint32_t i = 0; i < header->album_count; i++) {
+        const struct t_album_bin_record *record = &album_bin->albums[i];
+        if ((uint64_t)record->key + record->key_len >= header->strings_size ||
+            record->uri >= header->strings_size ||
+            (uint64_t)record->values_start + record->values_len > header->value_count)
+        {
+            MYMPD_LOG_ERROR(NULL, "Invalid album record in album cache file");
+            album_cache_free_rt(album_cache);
+            return NULL;
+        }
+        struct t_album *album = album_new_uri(album_bin->strings + record->uri);
+        album_set_unknown(album, record->unknown == 1);
+        album_set_disc_count(album, record->disc_count);
+        album_set_song_count(album, record->song_count);
+        album_set_total_time(album, record->total_time);
+        album_set_last_modified(album, (time_t)record->last_modified);
+        album_set_added(album, (time_t)record->added);
+        album_reserve_tags(album, record->values_len);
+        for (uint32_t j = record->values_start; j < record->values_start + record->values_len; j++) {
+            const struct t_album_bin_value *value = &album_bin->values[j];
+            if (value->value >= header->strings_size ||
+                album_append_tag_mapped(album, (enum mpd_tag_type)value->tag, album_bin->strings + value->value) == false)
+            {
+                MYMPD_LOG_ERROR(NULL, "Invalid tag value in album cache file");
+                album_free(album);
+                album_cache_free_rt(album_cache);
+                return NULL;
+            }
+        }
+        if (raxTryInsert(album_cache, (unsigned char *)album_bin->strings + record->key, record->key_len, album, NULL) == 0) {
+            MYMPD_LOG_ERROR(NULL, "Duplicate key in album cache file found");
+            album_free(album);
+        }
+    }
+    return album_cache;
+}
+
+/**
+ * Saves the album cache in the binary format
+ * @param album_cache the album cache
+ * @param filepath path of the album cache file
+ * @param album_tags album tags to write
+ * @param album_config album configuration
+ * @param free_data true=free the albums while writing, the radix tree must be freed by the caller
+ * @return true on success, else false
+ */
+bool album_bin_write(rax *album_cache, const char *filepath, const struct t_mympd_mpd_tags *album_tags,
+        const struct t_albums_config *album_config, bool free_data)
+{
+    struct t_album_bin_header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, ALBUM_BIN_MAGIC, sizeof(header.magic));
+    header.version = ALBUM_BIN_VERSION;
+    header.album_mode = (uint32_t)album_config->mode;
+    header.group_tag = (int32_t)album_config->group_tag;
+    header.unknown = album_config->unknown == true
+        ? 1
+        : 0;
+    header.album_count = (uint32_t)album_cache->numele;
+
+    struct t_album_bin_record *records = malloc_assert(album_cache->numele * sizeof(struct t_album_bin_record) + 1);
+    size_t values_size = album_cache->numele * 4 + 1;
+    struct t_album_bin_value *values = malloc_assert(values_size * sizeof(struct t_album_bin_value));
+    rax *strings = raxNew();
+    sds table = sdsempty();
+    // string offsets and the number of tag values are 32 bit values,
+    // the string table is limited to 4 GiB
+    bool overflow = false;
+
+    // rax iterates in key order, the records are sorted by key
+    raxIterator iter;
+    raxStart(&iter, album_cache);
+    raxSeek(&iter, "^", NULL, 0);
+    uint32_t i = 0;
+    while (raxNext(&iter)) {
+        struct t_album *album = (struct t_album *)iter.data;
+        struct t_album_bin_record *record = &records[i++];
+        const char *uri = album_get_uri(album);
+        record->key = add_string(strings, &table, (const char *)iter.key, iter.key_len, &overflow);
+        record->key_len = (uint32_t)iter.key_len;
+        record->uri = add_string(strings, &table, uri, strlen(uri), &overflow);
+        record->values_start = header.value_count;
+        record->disc_count = album_get_disc_count(album);
+        record->song_count = album_get_song_count(album);
+        record->total_time = album_get_total_time(album);
+        record->unknown = album_get_unknown(album) == true
+            ? 1
+            : 0;
+        record->reserved = 0;
+        record->last_modified = (int64_t)album_get_last_modified(album);
+        record->added = (int64_t)album_get_added(album);
+        for (unsigned tagnr = 0; tagnr < album_tags->len; ++tagnr) {
+            enum mpd_tag_type tag = album_tags->tags[tagnr];
+            const char *value;
+            unsigned value_nr = 0;
+            while ((value = album_get_tag(album, tag, value_nr)) != NULL) {
+                if (header.value_count == UINT32_MAX) {
+                    overflow = true;
+                    break;
+                }
+                if (header.value_count == values_size) {
+                    values_size *= 2;
+                    values = realloc_assert(values, values_size * sizeof(struct t_album_bin_value));
+                }
+                values[header.value_count].tag = (uint32_t)tag;
+                values[header.value_count].value = add_string(strings, &table, value, strlen(value), &overflow);
+                header.value_count++;
+                value_nr++;
+            }
+        }
+        record->values_len = header.value_count - record->values_start;
+        if (free_data == true) {
+            album_free(album);
+        }
+    }
+    raxStop(&iter);
+    raxFree(strings);
+    if (overflow == true) {
+        MYMPD_LOG_ERROR(NULL, "Writing album cache file \"%s\" failed, the offsets exceed 32 bits", filepath);
+        FREE_SDS(table);
+        FREE_PTR(records);
+        FREE_PTR(values);
+        return false;
+    }
+
+    header.albums_offset = sizeof(header);
+    header.values_offset = header.albums_offset + (uint64_t)header.album_count * sizeof(struct t_album_bin_record);
+    header.strings_offset = header.values_offset + (uint64_t)header.value_count * sizeof(struct t_album_bin_value);
+    header.strings_size = sdslen(table);
+
+    sds tmp_file = sdscatfmt(sdsempty(), "%s.XXXXXX", filepath);
+    FILE *fp = open_tmp_file(tmp_file);
+    bool rc = false;
+    if (fp != NULL) {
+        rc = fwrite(&header, sizeof(header), 1, fp) == 1 &&
+            fwrite(records, sizeof(struct t_album_bin_record), header.album_count, fp) == header.album_count &&
+            fwrite(values, sizeof(struct t_album_bin_value), header.value_count, fp) == header.value_count &&
+            fwrite(table, 1, sdslen(table), fp) == sdslen(table);
+        rc = rename_tmp_file(fp, tmp_file, rc);
+    }
+    if (rc == false) {
+        MYMPD_LOG_ERROR(NULL, "Writing album cache file \"%s\" failed", filepath);
+    }
+    FREE_SDS(tmp_file);
+    FREE_SDS(table);
+    FREE_PTR(records);
+    FREE_PTR(values);
+    return rc;
+}
+
+/**
+ * Private functions
+ */
+
+/**
+ * Checks if a section is inside the file and aligned to its record size
+ * @param offset file offset of the section
+ * @param count number of records
+ * @param record_size size of a record
+ * @param file_size size of the file
+ * @return true if the section is valid, else false
+ */
+static bool check_section(uint64_t offset, uint64_t count, uint64_t record_size, uint64_t file_size) {
+    return offset % 8 == 0 &&
+        offset <= file_size &&
+        count <= (file_size - offset) / record_size;
+}
+
+/**
+ * Adds a string to the string table if it is not already there
+ * @param strings radix tree of the string offsets by value
+ * @param table pointer to the string table
+ * @param value string to add
+ * @param len length of the string
+ * @param overflow set to true if the string offset does not fit in 32 bits
+ * @return offset of the string in the string table
+ */
+static uint32_t add_string(rax *strings, sds *table, const char *value, size_t len, bool *overflow) {
+    void *data;
+    if (raxFind(strings, (unsigned char *)value, len, &data) == 1) {
+        return (uint32_t)(uintptr_t)data;
+    }
+    if (*overflow == true ||
+        sdslen(*table) > UINT32_MAX)
+    {
+        *overflow = true;
+        return 0;
+    }
+    uint32_t offset = (uint32_t)sdslen(*table);
+    *table = sdscatlen(*table, value, len);
+    *table = sdscatlen(*table, "\0", 1);
+    raxInsert(strings, (unsigned char *)value, len, (void *)(uintptr_t)offset, NULL);
+    return offset;
+}
@@ -0,0 +1,34 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2026 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+/*! \file
+ * \brief Memory mapped binary album cache file
+ */
+
+#ifndef MYMPD_CACHE_RAX_ALBUM_BIN_H
+#define MYMPD_CACHE_RAX_ALBUM_BIN_H
+
+#include "dist/rax/rax.h"
+#include "src/lib/album.h"
+#include "src/lib/fields.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * An opaque handle for a memory mapped album cache file
+ */
+struct t_album_bin;
+
+struct t_album_bin *album_bin_open(const char *filepath);
+void album_bin_close(struct t_album_bin *album_bin);
+size_t album_bin_get_size(const struct t_album_bin *album_bin);
+bool album_bin_check_config(const struct t_album_bin *album_bin, const struct t_albums_config *album_config);
+rax *album_bin_load(const struct t_album_bin *album_bin);
+bool album_bin_write(rax *album_cache, const char *filepath, const struct t_mympd_mpd_tags *album_tags,
+        const struct t_albums_config *album_config, bool free_data);
+
+#endif
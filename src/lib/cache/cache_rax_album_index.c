@@ -0,0 +1,281 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2026 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+/*! \file
+ * \brief Sort indexes for the album cache
+ */
+
+#include "compile_time.h"
+#include "src/lib/cache/cache_rax_album_index.h"
+
+#include "src/lib/log.h"
+#include "src/lib/mem.h"
+#include "src/lib/sds/sds_extras.h"
+#include "src/lib/sds/sds_utf8.h"
+#include "src/lib/utility.h"
+#include "src/mympd_client/tags.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Private definitions
+ */
+
+/**
+ * Temporary struct for sorting the albums
+ */
+struct t_album_sort_entry {
+    sds key;                 //!< sort key
+    struct t_album *album;   //!< pointer to the album in the album cache
+    size_t pos;              //!< position in the album cache, used as tie breaker
+};
+
+static struct t_album_sort_index **get_index_slot(struct t_album_index *album_index,
+        enum sort_by_type sort_by, enum mpd_tag_type sort_tag);
+static struct t_album_sort_index *sort_index_create(rax *album_cache, enum sort_by_type sort_by,
+        enum mpd_tag_type sort_tag);
+static void sort_index_free(struct t_album_sort_index *sort_index);
+static int sort_entry_cmp(const void *a, const void *b);
+
+/**
+ * Public functions
+ */
+
+/**
+ * Creates a new empty album index
+ * @return newly allocated album index
+ */
+struct t_album_index *album_index_new(void) {
+    struct t_album_index *album_index = malloc_assert(sizeof(struct t_album_index));
+    for (unsigned i = 0; i < MPD_TAG_COUNT; i++) {
+        album_index->tags[i] = NULL;
+    }
+    album_index->added = NULL;
+    album_index->last_modified = NULL;
+    return album_index;
+}
+
+/**
+ * Frees the album index
+ * @param album_index pointer to album index, can be NULL
+ */
+void album_index_free(struct t_album_index *album_index) {
+    if (album_index == NULL) {
+        return;
+    }
+    for (unsigned i = 0; i < MPD_TAG_COUNT; i++) {
+        sort_index_free(album_index->tags[i]);
+    }
+    sort_index_free(album_index->added);
+    sort_index_free(album_index->last_modified);
+    FREE_PTR(album_index);
+}
+
+/**
+ * Creates the sort indexes for the common sort keys of the album list view.
+ * This is called by the mympd_worker thread after creating the album cache.
+ * @param album_index pointer to album index
+ * @param album_cache album cache to index
+ * @param tags_mympd enabled tags, used to map tags to their sort tags
+ * @param album_config album configuration
+ */
+void album_index_create_default(struct t_album_index *album_index, rax *album_cache,
+        const struct t_mympd_mpd_tags *tags_mympd, const struct t_albums_config *album_config)
+{
+    #ifdef MYMPD_DEBUG
+        MEASURE_INIT
+        MEASURE_START
+    #endif
+    const enum mpd_tag_type default_tags[] = {
+        MPD_TAG_ALBUM,
+        MPD_TAG_ALBUM_ARTIST,
+        MPD_TAG_DATE,
+        album_config->group_tag
+    };
+    for (size_t i = 0; i < sizeof(default_tags) / sizeof(default_tags[0]); i++) {
+        if (default_tags[i] == MPD_TAG_UNKNOWN) {
+            continue;
+        }
+        enum mpd_tag_type sort_tag = get_sort_tag(default_tags[i], tags_mympd);
+        struct t_album_sort_index **slot = get_index_slot(album_index, SORT_BY_TAG, sort_tag);
+        if (*slot == NULL) {
+            *slot = sort_index_create(album_cache, SORT_BY_TAG, sort_tag);
+        }
+    }
+    if (album_config->mode == ALBUM_MODE_ADV) {
+        // simple album mode has no timestamps
+        album_index->added = sort_index_create(album_cache, SORT_BY_ADDED, MPD_TAG_ALBUM);
+        album_index->last_modified = sort_index_create(album_cache, SORT_BY_LAST_MODIFIED, MPD_TAG_ALBUM);
+    }
+    #ifdef MYMPD_DEBUG
+        MEASURE_END
+        MEASURE_PRINT(NULL, "Album cache sort indexes")
+    #endif
+}
+
+/**
+ * Gets the sort index for the album cache, creates it if it does not exist.
+ * Must be called from the mympd_api thread only.
+ * @param album_cache pointer to album cache
+ * @param sort_by sort by type
+ * @param sort_tag mpd tag to sort by
+ * @return the sort index or NULL if album cache does not exist
+ */
+const struct t_album_sort_index *album_index_get(struct t_cache *album_cache,
+        enum sort_by_type sort_by, enum mpd_tag_type sort_tag)
+{
+    if (album_cache->cache == NULL) {
+        return NULL;
+    }
+    if (album_cache->index == NULL) {
+        album_cache->index = album_index_new();
+    }
+    if (sort_tag <= MPD_TAG_UNKNOWN ||
+        sort_tag >= MPD_TAG_COUNT)
+    {
+        sort_tag = MPD_TAG_ALBUM;
+    }
+    struct t_album_sort_index **slot = get_index_slot(album_cache->index, sort_by, sort_tag);
+    if (*slot == NULL) {
+        MYMPD_LOG_DEBUG(NULL, "Creating album sort index for \"%s\"",
+            sort_by == SORT_BY_TAG ? mpd_tag_name(sort_tag) : "timestamp");
+        *slot = sort_index_create(album_cache->cache, sort_by, sort_tag);
+    }
+    return *slot;
+}
+
+/**
+ * Gets an alphanumeric string for sorting
+ * @param key already allocated sds string to append
+ * @param sort_by enum sort_by
+ * @param sort_tag mpd tag to sort by
+ * @param album pointer to t_album
+ * @return pointer to key
+ */
+sds album_index_get_sort_key(sds key, enum sort_by_type sort_by, enum mpd_tag_type sort_tag,
+        const struct t_album *album)
+{
+    if (sort_by == SORT_BY_LAST_MODIFIED) {
+        key = sds_pad_int((int64_t)album_get_last_modified(album), key);
+    }
+    else if (sort_by == SORT_BY_ADDED) {
+        key = sds_pad_int((int64_t)album_get_added(album), key);
+    }
+    else if (is_numeric_tag(sort_tag) == true) {
+        key = album_get_tag_value_padded(album, sort_tag, '0', PADDING_LENGTH, key);
+    }
+    else if (sort_tag > MPD_TAG_UNKNOWN) {
+        key = album_get_tag_value_string(album, sort_tag, key);
+        if (sdslen(key) == 0) {
+            key = sdscatlen(key, "zzzzzzzzzz", 10);
+        }
+    }
+    enum mpd_tag_type secondary_sort_tag = sort_tag == MPD_TAG_ALBUM
+        ? MPD_TAG_ALBUM_ARTIST
+        : MPD_TAG_ALBUM;
+    key = sdscatfmt(key, "::%s::%s", album_get_tag(album, secondary_sort_tag, 0), album_get_uri(album));
+    key = sds_utf8_normalize(key);
+    return key;
+}
+
+/**
+ * Private functions
+ */
+
+/**
+ * Returns the slot for the sort index
+ * @param album_index pointer to album index
+ * @param sort_by sort by type
+ * @param sort_tag mpd tag to sort by
+ * @return pointer to the slot
+ */
+static struct t_album_sort_index **get_index_slot(struct t_album_index *album_index,
+        enum sort_by_type sort_by, enum mpd_tag_type sort_tag)
+{
+    switch(sort_by) {
+        case SORT_BY_ADDED:
+            return &album_index->added;
+        case SORT_BY_LAST_MODIFIED:
+            return &album_index->last_modified;
+        case SORT_BY_TAG:
+        case SORT_BY_FILENAME:
+            break;
+    }
+    return &album_index->tags[sort_tag];
+}
+
+/**
+ * Creates a sort index for the album cache
+ * @param album_cache album cache to index
+ * @param sort_by sort by type
+ * @param sort_tag mpd tag to sort by
+ * @return newly allocated sort index
+ */
+static struct t_album_sort_index *sort_index_create(rax *album_cache, enum sort_by_type sort_by,
+        enum mpd_tag_type sort_tag)
+{
+    struct t_album_sort_index *sort_index = malloc_assert(sizeof(struct t_album_sort_index));
+    sort_index->len = (size_t)album_cache->numele;
+    sort_index->albums = NULL;
+    if (sort_index->len == 0) {
+        return sort_index;
+    }
+    struct t_album_sort_entry *entries = malloc_assert(sort_index->len * sizeof(struct t_album_sort_entry));
+    raxIterator iter;
+    raxStart(&iter, album_cache);
+    raxSeek(&iter, "^", NULL, 0);
+    size_t i = 0;
+    while (raxNext(&iter)) {
+        entries[i].album = (struct t_album *)iter.data;
+        entries[i].key = album_index_get_sort_key(sdsempty(), sort_by, sort_tag, entries[i].album);
+        entries[i].pos = i;
+        i++;
+    }
+    raxStop(&iter);
+    qsort(entries, sort_index->len, sizeof(struct t_album_sort_entry), sort_entry_cmp);
+
+    sort_index->albums = malloc_assert(sort_index->len * sizeof(struct t_album *));
+    for (i = 0; i < sort_index->len; i++) {
+        sort_index->albums[i] = entries[i].album;
+        FREE_SDS(entries[i].key);
+    }
+    FREE_PTR(entries);
+    return sort_index;
+}
+
+/**
+ * Frees a sort index
+ * @param sort_index pointer to sort index, can be NULL
+ */
+static void sort_index_free(struct t_album_sort_index *sort_index) {
+    if (sort_index == NULL) {
+        return;
+    }
+    FREE_PTR(sort_index->albums);
+    FREE_PTR(sort_index);
+}
+
+/**
+ * Compares two sort entries by key and falls back to the position in the album cache
+ * @param a pointer to first entry
+ * @param b pointer to second entry
+ * @return less than, equal to, or greater than zero
+ */
+static int sort_entry_cmp(const void *a, const void *b) {
+    const struct t_album_sort_entry *entry1 = (const struct t_album_sort_entry *)a;
+    const struct t_album_sort_entry *entry2 = (const struct t_album_sort_entry *)b;
+    int rc = strcmp(entry1->key, entry2->key);
+    if (rc != 0) {
+        return rc;
+    }
+    if (entry1->pos == entry2->pos) {
+        return 0;
+    }
+    return entry1->pos < entry2->pos
+        ? -1
+        : 1;
+}
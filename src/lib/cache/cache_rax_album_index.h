@@ -0,0 +1,50 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2026 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+/*! \file
+ * \brief Sort indexes for the album cache
+ */
+
+#ifndef MYMPD_CACHE_RAX_ALBUM_INDEX_H
+#define MYMPD_CACHE_RAX_ALBUM_INDEX_H
+
+#include "dist/rax/rax.h"
+#include "dist/sds/sds.h"
+#include "src/lib/album.h"
+#include "src/lib/cache/cache_rax.h"
+#include "src/lib/fields.h"
+
+#include <stddef.h>
+
+/**
+ * Albums of the album cache sorted by one sort key
+ */
+struct t_album_sort_index {
+    struct t_album **albums;  //!< albums sorted ascending
+    size_t len;               //!< number of albums
+};
+
+/**
+ * Sort indexes for the album cache.
+ * Indexes are created on album cache creation for the common sort keys
+ * and lazily on first request for all other sort keys.
+ */
+struct t_album_index {
+    struct t_album_sort_index *tags[MPD_TAG_COUNT];  //!< indexes for sorting by tag
+    struct t_album_sort_index *added;                //!< index for sorting by added
+    struct t_album_sort_index *last_modified;        //!< index for sorting by last-modified
+};
+
+struct t_album_index *album_index_new(void);
+void album_index_free(struct t_album_index *album_index);
+void album_index_create_default(struct t_album_index *album_index, rax *album_cache,
+        const struct t_mympd_mpd_tags *tags_mympd, const struct t_albums_config *album_config);
+const struct t_album_sort_index *album_index_get(struct t_cache *album_cache,
+        enum sort_by_type sort_by, enum mpd_tag_type sort_tag);
+sds album_index_get_sort_key(sds key, enum sort_by_type sort_by, enum mpd_tag_type sort_tag,
+        const struct t_album *album);
+
+#endif
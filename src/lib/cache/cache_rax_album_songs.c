@@ -0,0 +1,584 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2026 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+/*! \file
+ * \brief Song index for incremental album cache updates
+ *
+ * The index maps all song uris of the mpd database to their album keys
+ * and holds the song values and album tags that are aggregated in the album cache.
+ * It is written next to the album cache and allows to recalculate
+ * single albums without fetching all songs from mpd.
+ */
+
+#include "compile_time.h"
+#include "src/lib/cache/cache_rax_album_songs.h"
+
+#include "dist/mpack/mpack.h"
+#include "src/lib/album.h"
+#include "src/lib/convert.h"
+#include "src/lib/filehandler.h"
+#include "src/lib/log.h"
+#include "src/lib/mem.h"
+#include "src/lib/mpack.h"
+#include "src/lib/sds/sds_extras.h"
+#include "src/lib/str_pool.h"
+#include "src/mympd_client/tags.h"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * Private definitions
+ */
+
+enum { ALBUM_SONGS_VERSION = 2 }; //!< Internal song index version
+
+/**
+ * Aggregated values of an album
+ */
+struct t_album_stats {
+    unsigned song_count;                    //!< number of songs
+    unsigned total_time;                    //!< sum of song durations
+    unsigned disc_count;                    //!< highest disc number
+    time_t added;                           //!< oldest added timestamp
+    time_t last_modified;                   //!< latest last-modified timestamp
+    sds uri;                                //!< first song uri of the album
+    const char *album_uri;                  //!< current uri of the album in the album cache
+    const struct t_album_song *uri_song;    //!< song of the current album uri
+    const struct t_album_song *first_song;  //!< first song of the album
+    struct t_album *multi_tags;             //!< multivalue tags of all songs
+};
+
+static void album_song_set_tags(struct t_album_song *album_song, const struct mpd_song *song,
+        const struct t_mympd_mpd_tags *album_tags);
+static sds album_song_free_keep_key(struct t_album_song *album_song);
+static void patch_album_tags(struct t_album *album, const struct t_album_stats *album_stats,
+        const struct t_mympd_mpd_tags *album_tags);
+static void free_album_song(void *data);
+
+/**
+ * Public functions
+ */
+
+/**
+ * Initializes an empty song index
+ * @param album_songs pointer to song index
+ */
+void album_songs_init(struct t_album_songs *album_songs) {
+    album_songs->songs = raxNew();
+    album_songs->db_mtime = 0;
+    album_songs->db_songs = 0;
+}
+
+/**
+ * Frees the content of the song index
+ * @param album_songs pointer to song index
+ */
+void album_songs_clear(struct t_album_songs *album_songs) {
+    if (album_songs->songs != NULL) {
+        raxFreeWithCallback(album_songs->songs, free_album_song);
+        album_songs->songs = NULL;
+    }
+}
+
+/**
+ * Adds or replaces a song in the song index
+ * @param album_songs pointer to song index
+ * @param song mpd song
+ * @param key album key of the song, empty if the song is not part of an album
+ * @param album_tags album tags to save for songs that are part of an album
+ * @return the previous album key as newly allocated sds string,
+ *         NULL if the song was not indexed
+ */
+sds album_songs_set(struct t_album_songs *album_songs, const struct mpd_song *song, sds key,
+        const struct t_mympd_mpd_tags *album_tags)
+{
+    struct t_album_song *album_song = malloc_assert(sizeof(struct t_album_song));
+    album_song->key = sdsdup(key);
+    album_song->duration = mpd_song_get_duration(song);
+    album_song->disc = 0;
+    const char *disc = mpd_song_get_tag(song, MPD_TAG_DISC, 0);
+    if (disc != NULL &&
+        str2uint(&album_song->disc, disc) != STR2INT_SUCCESS)
+    {
+        album_song->disc = 0;
+    }
+    album_song->added = mpd_song_get_added(song);
+    album_song->last_modified = mpd_song_get_last_modified(song);
+    album_song->mark = false;
+    album_song_set_tags(album_song, song, album_tags);
+
+    const char *uri = mpd_song_get_uri(song);
+    void *old = NULL;
+    if (raxInsert(album_songs->songs, (unsigned char *)uri, strlen(uri), album_song, &old) == 0) {
+        // uri already exists, raxInsert has replaced the old entry
+        return album_song_free_keep_key((struct t_album_song *)old);
+    }
+    return NULL;
+}
+
+/**
+ * Removes a song from the song index
+ * @param album_songs pointer to song index
+ * @param uri song uri
+ * @param uri_len length of the uri
+ * @return the album key of the removed song as newly allocated sds string,
+ *         NULL if the song was not indexed
+ */
+sds album_songs_remove(struct t_album_songs *album_songs, const char *uri, size_t uri_len) {
+    void *old = NULL;
+    if (raxRemove(album_songs->songs, (unsigned char *)uri, uri_len, &old) == 0) {
+        return NULL;
+    }
+    return album_song_free_keep_key((struct t_album_song *)old);
+}
+
+/**
+ * Marks a song of the song index as present in the mpd database
+ * @param album_songs pointer to song index
+ * @param uri song uri
+ * @param uri_len length of the uri
+ * @return true if the song is indexed, else false
+ */
+bool album_songs_mark(struct t_album_songs *album_songs, const char *uri, size_t uri_len) {
+    void *data;
+    if (raxFind(album_songs->songs, (unsigned char *)uri, uri_len, &data) == 0) {
+        return false;
+    }
+    ((struct t_album_song *)data)->mark = true;
+    return true;
+}
+
+/**
+ * Removes all songs that are not marked and clears the marks of the remaining songs
+ * @param album_songs pointer to song index
+ * @param affected radix tree to add the album keys of the removed songs
+ * @return number of removed songs
+ */
+unsigned album_songs_sweep(struct t_album_songs *album_songs, rax *affected) {
+    unsigned removed = 0;
+    raxIterator iter;
+    raxStart(&iter, album_songs->songs);
+    raxSeek(&iter, "^", NULL, 0);
+    while (raxNext(&iter)) {
+        struct t_album_song *album_song = (struct t_album_song *)iter.data;
+        if (album_song->mark == true) {
+            album_song->mark = false;
+            continue;
+        }
+        if (sdslen(album_song->key) > 0) {
+            raxInsert(affected, (unsigned char *)album_song->key, sdslen(album_song->key), NULL, NULL);
+        }
+        raxRemove(album_songs->songs, iter.key, iter.key_len, NULL);
+        free_album_song(album_song);
+        // removing invalidates the iterator
+        raxSeek(&iter, ">", iter.key, iter.key_len);
+        removed++;
+    }
+    raxStop(&iter);
+    return removed;
+}
+
+/**
+ * Recalculates song count, duration, discs, added, last-modified and the tags of the affected albums
+ * from the song index. Albums without songs are removed from the album cache.
+ * Albums for new keys must already be inserted in the album cache.
+ * @param album_songs pointer to song index
+ * @param affected radix tree with the keys of the albums to recalculate
+ * @param album_cache the album cache to patch
+ * @param album_tags album tags of the album cache
+ * @param disc_empty_is_first handle empty disc tag as disc one
+ */
+void album_songs_patch_albums(const struct t_album_songs *album_songs, rax *affected, rax *album_cache,
+        const struct t_mympd_mpd_tags *album_tags, bool disc_empty_is_first)
+{
+    rax *stats = raxNew();
+    raxIterator iter;
+    raxStart(&iter, affected);
+    raxSeek(&iter, "^", NULL, 0);
+    while (raxNext(&iter)) {
+        struct t_album_stats *album_stats = malloc_assert(sizeof(struct t_album_stats));
+        memset(album_stats, 0, sizeof(struct t_album_stats));
+        if (disc_empty_is_first == true) {
+            album_stats->disc_count = 1;
+        }
+        void *data;
+        if (raxFind(album_cache, iter.key, iter.key_len, &data) == 1) {
+            album_stats->album_uri = album_get_uri((struct t_album *)data);
+        }
+        album_stats->multi_tags = album_new();
+        raxInsert(stats, iter.key, iter.key_len, album_stats, NULL);
+    }
+    raxStop(&iter);
+
+    // aggregate the song values of the affected albums
+    raxStart(&iter, album_songs->songs);
+    raxSeek(&iter, "^", NULL, 0);
+    while (raxNext(&iter)) {
+        const struct t_album_song *album_song = (struct t_album_song *)iter.data;
+        void *data;
+        if (sdslen(album_song->key) == 0 ||
+            raxFind(stats, (unsigned char *)album_song->key, sdslen(album_song->key), &data) == 0)
+        {
+            continue;
+        }
+        struct t_album_stats *album_stats = (struct t_album_stats *)data;
+        if (album_stats->song_count == 0) {
+            album_stats->uri = sdsnewlen(iter.key, iter.key_len);
+            album_stats->first_song = album_song;
+        }
+        if (album_stats->album_uri != NULL &&
+            strlen(album_stats->album_uri) == iter.key_len &&
+            memcmp(album_stats->album_uri, iter.key, iter.key_len) == 0)
+        {
+            album_stats->uri_song = album_song;
+        }
+        for (unsigned i = 0; i < album_song->tags_len; i++) {
+            if (is_multivalue_tag(album_song->tags[i].tag) == true) {
+                album_append_tag(album_stats->multi_tags, album_song->tags[i].tag, album_song->tags[i].value);
+            }
+        }
+        album_stats->song_count++;
+        album_stats->total_time += album_song->duration;
+        if (album_song->disc > album_stats->disc_count) {
+            album_stats->disc_count = album_song->disc;
+        }
+        if (album_song->added > 0 &&
+            (album_stats->added == 0 || album_song->added < album_stats->added))
+        {
+            album_stats->added = album_song->added;
+        }
+        if (album_song->last_modified > album_stats->last_modified) {
+            album_stats->last_modified = album_song->last_modified;
+        }
+    }
+    raxStop(&iter);
+
+    // patch the album cache
+    raxStart(&iter, stats);
+    raxSeek(&iter, "^", NULL, 0);
+    while (raxNext(&iter)) {
+        struct t_album_stats *album_stats = (struct t_album_stats *)iter.data;
+        void *data;
+        if (raxFind(album_cache, iter.key, iter.key_len, &data) == 1) {
+            struct t_album *album = (struct t_album *)data;
+            if (album_stats->song_count == 0) {
+                raxRemove(album_cache, iter.key, iter.key_len, NULL);
+                album_free(album);
+            }
+            else {
+                album_set_song_count(album, album_stats->song_count);
+                album_set_total_time(album, album_stats->total_time);
+                album_set_disc_count(album, album_stats->disc_count);
+                album_reset_timestamps(album);
+                album_set_added(album, album_stats->added);
+                album_set_last_modified(album, album_stats->last_modified);
+                // the album uri must point to a song of the album
+                if (album_stats->uri_song == NULL) {
+                    album_set_uri(album, album_stats->uri);
+                }
+                patch_album_tags(album, album_stats, album_tags);
+            }
+        }
+        album_free(album_stats->multi_tags);
+        FREE_SDS(album_stats->uri);
+        FREE_PTR(album_stats);
+    }
+    raxStop(&iter);
+    raxFree(stats);
+}
+
+/**
+ * Reads the song index from disc
+ * @param album_songs pointer to initialized song index
+ * @param workdir myMPD working directory
+ * @param album_tags expected album tags, the index is discarded if the tags have changed
+ * @return true on success, else false
+ */
+bool album_songs_read(struct t_album_songs *album_songs, sds workdir, const struct t_mympd_mpd_tags *album_tags) {
+    sds filepath = sdscatfmt(sdsempty(), "%S/%s/%s", workdir, DIR_WORK_TAGS, FILENAME_ALBUMCACHE_SONGS);
+    if (testfile_read(filepath) == false) {
+        FREE_SDS(filepath);
+        return false;
+    }
+    mpack_tree_t tree;
+    mpack_tree_init_filename(&tree, filepath, 0);
+    mpack_tree_set_error_handler(&tree, log_mpack_node_error);
+    FREE_SDS(filepath);
+    mpack_tree_parse(&tree);
+    mpack_node_t root = mpack_tree_root(&tree);
+
+    int version = mpack_node_int(mpack_node_map_cstr(root, "cacheVersion"));
+    if (version != ALBUM_SONGS_VERSION) {
+        mpack_tree_destroy(&tree);
+        MYMPD_LOG_WARN(NULL, "Unexpected song index version");
+        return false;
+    }
+    // the albums of unchanged songs keep the tags of the last full rebuild
+    mpack_node_t tags_node = mpack_node_map_cstr(root, "tags");
+    bool tags_match = mpack_node_array_length(tags_node) == album_tags->len;
+    for (size_t i = 0; tags_match == true && i < album_tags->len; i++) {
+        mpack_node_t value_node = mpack_node_array_at(tags_node, i);
+        const char *name = mpd_tag_name(album_tags->tags[i]);
+        tags_match = mpack_node_strlen(value_node) == strlen(name) &&
+            memcmp(mpack_node_str(value_node), name, strlen(name)) == 0;
+    }
+    if (tags_match == false) {
+        mpack_tree_destroy(&tree);
+        MYMPD_LOG_INFO(NULL, "Album tags have changed, discarding song index");
+        return false;
+    }
+
+    album_songs->db_mtime = (time_t)mpack_node_i64(mpack_node_map_cstr(root, "dbMtime"));
+    album_songs->db_songs = mpack_node_uint(mpack_node_map_cstr(root, "dbSongs"));
+
+    mpack_node_t songs_node = mpack_node_map_cstr(root, "songs");
+    size_t len = mpack_node_array_length(songs_node);
+    for (size_t i = 0; i < len; i++) {
+        mpack_node_t song_node = mpack_node_array_at(songs_node, i);
+        mpack_node_t uri_node = mpack_node_array_at(song_node, 0);
+        mpack_node_t key_node = mpack_node_array_at(song_node, 1);
+        if (mpack_node_error(song_node) != mpack_ok) {
+            break;
+        }
+        struct t_album_song *album_song = malloc_assert(sizeof(struct t_album_song));
+        album_song->key = sdsnewlen(mpack_node_str(key_node), mpack_node_strlen(key_node));
+        album_song->duration = mpack_node_uint(mpack_node_array_at(song_node, 2));
+        album_song->disc = mpack_node_uint(mpack_node_array_at(song_node, 3));
+        album_song->added = (time_t)mpack_node_i64(mpack_node_array_at(song_node, 4));
+        album_song->last_modified = (time_t)mpack_node_i64(mpack_node_array_at(song_node, 5));
+        album_song->mark = false;
+        mpack_node_t song_tags_node = mpack_node_array_at(song_node, 6);
+        size_t tags_len = mpack_node_array_length(song_tags_node);
+        album_song->tags = tags_len > 0
+            ? malloc_assert(tags_len * sizeof(struct t_album_song_tag))
+            : NULL;
+        album_song->tags_len = 0;
+        for (size_t j = 0; j < tags_len; j++) {
+            mpack_node_t tag_node = mpack_node_array_at(song_tags_node, j);
+            unsigned tagnr = mpack_node_uint(mpack_node_array_at(tag_node, 0));
+            mpack_node_t value_node = mpack_node_array_at(tag_node, 1);
+            if (mpack_node_error(value_node) != mpack_ok ||
+                tagnr >= album_tags->len)
+            {
+                break;
+            }
+            album_song->tags[album_song->tags_len].tag = album_tags->tags[tagnr];
+            album_song->tags[album_song->tags_len].value = str_pool_intern(mpack_node_str(value_node), mpack_node_strlen(value_node));
+            album_song->tags_len++;
+        }
+        if (raxTryInsert(album_songs->songs, (unsigned char *)mpack_node_str(uri_node), mpack_node_strlen(uri_node), album_song, NULL) == 0) {
+            free_album_song(album_song);
+        }
+    }
+    bool rc = mpack_tree_destroy(&tree) != mpack_ok
+        ? false
+        : true;
+    if (rc == false) {
+        MYMPD_LOG_ERROR(NULL, "Reading song index failed");
+    }
+    else {
+        MYMPD_LOG_INFO(NULL, "Read %" PRIu64 " song(s) of the song index from disc", album_songs->songs->numele);
+    }
+    return rc;
+}
+
+/**
+ * Saves the song index to disc in mpack format
+ * @param album_songs pointer to song index
+ * @param workdir myMPD working directory
+ * @param album_tags album tags of the album cache
+ * @return true on success, else false
+ */
+bool album_songs_write(const struct t_album_songs *album_songs, sds workdir, const struct t_mympd_mpd_tags *album_tags) {
+    MYMPD_LOG_INFO(NULL, "Saving song index to disc");
+    mpack_writer_t writer;
+    sds tmp_file = sdscatfmt(sdsempty(), "%S/%s/%s.XXXXXX", workdir, DIR_WORK_TAGS, FILENAME_ALBUMCACHE_SONGS);
+    FILE *fp = open_tmp_file(tmp_file);
+    if (fp == NULL) {
+        FREE_SDS(tmp_file);
+        return false;
+    }
+    mpack_writer_init_stdfile(&writer, fp, true);
+    mpack_writer_set_error_handler(&writer, log_mpack_write_error);
+    mpack_build_map(&writer);
+    mpack_write_kv(&writer, "cacheVersion", ALBUM_SONGS_VERSION);
+    mpack_write_kv(&writer, "dbMtime", (int64_t)album_songs->db_mtime);
+    mpack_write_kv(&writer, "dbSongs", album_songs->db_songs);
+    mpack_write_cstr(&writer, "tags");
+    mpack_start_array(&writer, (uint32_t)album_tags->len);
+    for (unsigned tagnr = 0; tagnr < album_tags->len; ++tagnr) {
+        mpack_write_cstr(&writer, mpd_tag_name(album_tags->tags[tagnr]));
+    }
+    mpack_finish_array(&writer);
+    mpack_write_cstr(&writer, "songs");
+    mpack_start_array(&writer, (uint32_t)album_songs->songs->numele);
+    raxIterator iter;
+    raxStart(&iter, album_songs->songs);
+    raxSeek(&iter, "^", NULL, 0);
+    while (raxNext(&iter)) {
+        const struct t_album_song *album_song = (struct t_album_song *)iter.data;
+        mpack_start_array(&writer, 7);
+        mpack_write_str(&writer, (char *)iter.key, (uint32_t)iter.key_len);
+        mpack_write_str(&writer, album_song->key, (uint32_t)sdslen(album_song->key));
+        mpack_write_uint(&writer, album_song->duration);
+        mpack_write_uint(&writer, album_song->disc);
+        mpack_write_i64(&writer, (int64_t)album_song->added);
+        mpack_write_i64(&writer, (int64_t)album_song->last_modified);
+        mpack_start_array(&writer, album_song->tags_len);
+        for (unsigned i = 0; i < album_song->tags_len; i++) {
+            // the tag is saved as index of the album tags
+            unsigned tagnr = 0;
+            while (album_tags->tags[tagnr] != album_song->tags[i].tag) {
+                tagnr++;
+            }
+            mpack_start_array(&writer, 2);
+            mpack_write_uint(&writer, tagnr);
+            mpack_write_cstr(&writer, album_song->tags[i].value);
+            mpack_finish_array(&writer);
+        }
+        mpack_finish_array(&writer);
+        mpack_finish_array(&writer);
+    }
+    raxStop(&iter);
+    mpack_finish_array(&writer);
+    mpack_complete_map(&writer);
+    bool rc = mpack_writer_destroy(&writer) != mpack_ok
+        ? false
+        : true;
+    if (rc == false) {
+        rm_file(tmp_file);
+        MYMPD_LOG_ERROR(NULL, "An error occurred encoding the data");
+        FREE_SDS(tmp_file);
+        return false;
+    }
+    // rename tmp file
+    sds filepath = sdscatlen(sdsempty(), tmp_file, sdslen(tmp_file) - 7);
+    errno = 0;
+    if (rename(tmp_file, filepath) == -1) {
+        MYMPD_LOG_ERROR(NULL, "Rename file from \"%s\" to \"%s\" failed", tmp_file, filepath);
+        MYMPD_LOG_ERRNO(NULL, errno);
+        rm_file(tmp_file);
+        rc = false;
+    }
+    FREE_SDS(filepath);
+    FREE_SDS(tmp_file);
+    return rc;
+}
+
+/**
+ * Removes the song index file
+ * @param workdir myMPD working directory
+ * @return bool true on success, else false
+ */
+bool album_songs_remove_file(sds workdir) {
+    sds filepath = sdscatfmt(sdsempty(), "%S/%s/%s", workdir, DIR_WORK_TAGS, FILENAME_ALBUMCACHE_SONGS);
+    int rc = try_rm_file(filepath);
+    FREE_SDS(filepath);
+    return rc == RM_FILE_ERROR
+        ? false
+        : true;
+}
+
+/**
+ * Private functions
+ */
+
+/**
+ * Saves the album tag values of a song
+ * @param album_song pointer to the song index entry
+ * @param song mpd song
+ * @param album_tags album tags to save, only saved for songs that are part of an album
+ */
+static void album_song_set_tags(struct t_album_song *album_song, const struct mpd_song *song,
+        const struct t_mympd_mpd_tags *album_tags)
+{
+    album_song->tags = NULL;
+    album_song->tags_len = 0;
+    if (sdslen(album_song->key) == 0) {
+        return;
+    }
+    unsigned count = 0;
+    for (unsigned tagnr = 0; tagnr < album_tags->len; ++tagnr) {
+        unsigned value_nr = 0;
+        while (mpd_song_get_tag(song, album_tags->tags[tagnr], value_nr) != NULL) {
+            value_nr++;
+        }
+        count += value_nr;
+    }
+    if (count == 0) {
+        return;
+    }
+    album_song->tags = malloc_assert(count * sizeof(struct t_album_song_tag));
+    for (unsigned tagnr = 0; tagnr < album_tags->len; ++tagnr) {
+        const char *value;
+        unsigned value_nr = 0;
+        while ((value = mpd_song_get_tag(song, album_tags->tags[tagnr], value_nr)) != NULL) {
+            album_song->tags[album_song->tags_len].tag = album_tags->tags[tagnr];
+            album_song->tags[album_song->tags_len].value = str_pool_intern(value, strlen(value));
+            album_song->tags_len++;
+            value_nr++;
+        }
+    }
+}
+
+/**
+ * Frees a song index entry and returns its album key
+ * @param album_song pointer to the song index entry
+ * @return the album key, the caller must free it
+ */
+static sds album_song_free_keep_key(struct t_album_song *album_song) {
+    sds key = album_song->key;
+    for (unsigned i = 0; i < album_song->tags_len; i++) {
+        str_pool_release(album_song->tags[i].value);
+    }
+    FREE_PTR(album_song->tags);
+    FREE_PTR(album_song);
+    return key;
+}
+
+/**
+ * Sets the tags of an album like a full rebuild of the album cache:
+ * all values of the song at the album uri and the multivalue tags of all songs.
+ * @param album album to patch
+ * @param album_stats aggregated values of the album
+ * @param album_tags album tags of the album cache
+ */
+static void patch_album_tags(struct t_album *album, const struct t_album_stats *album_stats,
+        const struct t_mympd_mpd_tags *album_tags)
+{
+    const struct t_album_song *album_song = album_stats->uri_song != NULL
+        ? album_stats->uri_song
+        : album_stats->first_song;
+    album_clear_tags(album);
+    bool unknown = true;
+    for (unsigned i = 0; i < album_song->tags_len; i++) {
+        album_append_tag(album, album_song->tags[i].tag, album_song->tags[i].value);
+        if (album_song->tags[i].tag == MPD_TAG_ALBUM) {
+            unknown = false;
+        }
+    }
+    album_set_unknown(album, unknown);
+    for (unsigned tagnr = 0; tagnr < album_tags->len; ++tagnr) {
+        const char *value;
+        unsigned value_nr = 0;
+        while ((value = album_get_tag(album_stats->multi_tags, album_tags->tags[tagnr], value_nr)) != NULL) {
+            album_append_tag(album, album_tags->tags[tagnr], value);
+            value_nr++;
+        }
+    }
+}
+
+/**
+ * Frees a song index entry
+ * @param data void pointer to the t_album_song struct
+ */
+static void free_album_song(void *data) {
+    sds key = album_song_free_keep_key((struct t_album_song *)data);
+    FREE_SDS(key);
+}
@@ -0,0 +1,66 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2026 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+/*! \file
+ * \brief Song index for incremental album cache updates
+ */
+
+#ifndef MYMPD_CACHE_RAX_ALBUM_SONGS_H
+#define MYMPD_CACHE_RAX_ALBUM_SONGS_H
+
+#include "dist/rax/rax.h"
+#include "dist/sds/sds.h"
+#include "src/lib/fields.h"
+#include "src/lib/mpdclient.h"
+
+#include <stdbool.h>
+#include <time.h>
+
+/**
+ * Album tag value of a song
+ */
+struct t_album_song_tag {
+    enum mpd_tag_type tag;  //!< tag type
+    const char *value;      //!< the value, owned by the shared string pool
+};
+
+/**
+ * Album relevant data of a song
+ */
+struct t_album_song {
+    sds key;                        //!< album key, empty if the song is not part of an album
+    unsigned duration;              //!< song duration in seconds
+    unsigned disc;                  //!< disc number, 0 if not set
+    time_t added;                   //!< added timestamp
+    time_t last_modified;           //!< last-modified timestamp
+    struct t_album_song_tag *tags;  //!< album tag values in the order of the album tags
+    unsigned tags_len;              //!< number of album tag values
+    bool mark;                      //!< set while scanning the mpd database, unmarked songs were removed
+};
+
+/**
+ * Index of all songs in the mpd database with their album keys
+ */
+struct t_album_songs {
+    rax *songs;         //!< t_album_song structs by uri
+    time_t db_mtime;    //!< mpd database update time the index is based on
+    unsigned db_songs;  //!< number of songs in the mpd database the index is based on
+};
+
+void album_songs_init(struct t_album_songs *album_songs);
+void album_songs_clear(struct t_album_songs *album_songs);
+sds album_songs_set(struct t_album_songs *album_songs, const struct mpd_song *song, sds key,
+        const struct t_mympd_mpd_tags *album_tags);
+sds album_songs_remove(struct t_album_songs *album_songs, const char *uri, size_t uri_len);
+bool album_songs_mark(struct t_album_songs *album_songs, const char *uri, size_t uri_len);
+unsigned album_songs_sweep(struct t_album_songs *album_songs, rax *affected);
+void album_songs_patch_albums(const struct t_album_songs *album_songs, rax *affected, rax *album_cache,
+        const struct t_mympd_mpd_tags *album_tags, bool disc_empty_is_first);
+bool album_songs_read(struct t_album_songs *album_songs, sds workdir, const struct t_mympd_mpd_tags *album_tags);
+bool album_songs_write(const struct t_album_songs *album_songs, sds workdir, const struct t_mympd_mpd_tags *album_tags);
+bool album_songs_remove_file(sds workdir);
+
+#endif
@@ -38,11 +38,17 @@ enum config_item {
     CI_ALBUM_UNKNOWN,
     CI_CA_CERT_STORE,
     CI_CACHE_COVER_KEEP_DAYS,
+    CI_CACHE_COVER_SIZE_MAX,
     CI_CACHE_HTTP_KEEP_DAYS,
+    CI_CACHE_HTTP_SIZE_MAX,
     CI_CACHE_LYRICS_KEEP_DAYS,
+    CI_CACHE_LYRICS_SIZE_MAX,
     CI_CACHE_MISC_KEEP_DAYS,
     CI_CACHE_THUMBS_KEEP_DAYS,
+    CI_CACHE_THUMBS_SIZE_MAX,
     CI_CERT_CHECK,
+    CI_COMPRESSION_LEVEL,
+    CI_COMPRESSION_MIN_SIZE,
     CI_CUSTOM_CERT,
     CI_CUSTOM_CSS,
     CI_CUSTOM_JS,
@@ -127,11 +133,17 @@ static const struct t_config_default config_default[] = {
     [CI_ALBUM_UNKNOWN]                  = {"album_unknown",                  {.t = CIT_B, .b = false},           0, 0, NULL},
     [CI_CA_CERT_STORE]                  = {"ca_cert_store",                  {.t = CIT_S, .s = ""},             0, 0, vcb_isfilepath},
     [CI_CACHE_COVER_KEEP_DAYS]          = {"cache_cover_keep_days",          {.t = CIT_I, .i = 31},             CACHE_AGE_MIN, CACHE_AGE_MAX, NULL},
+    [CI_CACHE_COVER_SIZE_MAX]           = {"cache_cover_size_max",           {.t = CIT_I, .i = 0},              0, CACHE_SIZE_MAX, NULL},
     [CI_CACHE_HTTP_KEEP_DAYS]           = {"cache_http_keep_days",           {.t = CIT_I, .i = 31},             CACHE_AGE_MIN, CACHE_AGE_MAX, NULL},
+    [CI_CACHE_HTTP_SIZE_MAX]            = {"cache_http_size_max",            {.t = CIT_I, .i = 0},              0, CACHE_SIZE_MAX, NULL},
     [CI_CACHE_LYRICS_KEEP_DAYS]         = {"cache_lyrics_keep_days",         {.t = CIT_I, .i = 31},             CACHE_AGE_MIN, CACHE_AGE_MAX, NULL},
+    [CI_CACHE_LYRICS_SIZE_MAX]          = {"cache_lyrics_size_max",          {.t = CIT_I, .i = 0},              0, CACHE_SIZE_MAX, NULL},
     [CI_CACHE_MISC_KEEP_DAYS]           = {"cache_misc_keep_days",           {.t = CIT_I, .i = 1},              1, CACHE_AGE_MAX, NULL},
     [CI_CACHE_THUMBS_KEEP_DAYS]         = {"cache_thumbs_keep_days",         {.t = CIT_I, .i = 31},             CACHE_AGE_MIN, CACHE_AGE_MAX, NULL},
+    [CI_CACHE_THUMBS_SIZE_MAX]          = {"cache_thumbs_size_max",          {.t = CIT_I, .i = 0},              0, CACHE_SIZE_MAX, NULL},
     [CI_CERT_CHECK]                     = {"cert_check",                     {.t = CIT_B, .b = true},           0, 0, NULL},
+    [CI_COMPRESSION_LEVEL]              = {"compression_level",              {.t = CIT_I, .i = CFG_COMPRESSION_LEVEL}, 0, 9, NULL},
+    [CI_COMPRESSION_MIN_SIZE]           = {"compression_min_size",           {.t = CIT_I, .i = CFG_COMPRESSION_MIN_SIZE}, 0, CFG_COMPRESSION_MIN_SIZE_MAX, NULL},
     [CI_CUSTOM_CERT]                    = {"custom_cert",                    {.t = CIT_B, .b = false},          0, 0, NULL},
     [CI_CUSTOM_CSS]                     = {"custom_css",                     {.t = CIT_S, .s = ""},             0, 0, vcb_istext},
     [CI_CUSTOM_JS]                      = {"custom_js",                      {.t = CIT_S, .s = ""},             0, 0, vcb_istext},
@@ -254,14 +266,26 @@ static void set_config(struct t_config *config, enum config_item ci, struct t_co
             assert(value->t == CIT_I);
             config->cache_cover_keep_days = value->i;
             break;
+        case CI_CACHE_COVER_SIZE_MAX:
+            assert(value->t == CIT_I);
+            config->cache_cover_size_max = (unsigned)value->i;
+            break;
         case CI_CACHE_LYRICS_KEEP_DAYS:
             assert(value->t == CIT_I);
             config->cache_lyrics_keep_days = value->i;
             break;
+        case CI_CACHE_LYRICS_SIZE_MAX:
+            assert(value->t == CIT_I);
+            config->cache_lyrics_size_max = (unsigned)value->i;
+            break;
         case CI_CACHE_THUMBS_KEEP_DAYS:
             assert(value->t == CIT_I);
             config->cache_thumbs_keep_days = value->i;
             break;
+        case CI_CACHE_THUMBS_SIZE_MAX:
+            assert(value->t == CIT_I);
+            config->cache_thumbs_size_max = (unsigned)value->i;
+            break;
         case CI_CACHE_MISC_KEEP_DAYS:
             assert(value->t == CIT_I);
             config->cache_misc_keep_days = value->i;
@@ -270,10 +294,22 @@ static void set_config(struct t_config *config, enum config_item ci, struct t_co
             assert(value->t == CIT_I);
             config->cache_http_keep_days = value->i;
             break;
+        case CI_CACHE_HTTP_SIZE_MAX:
+            assert(value->t == CIT_I);
+            config->cache_http_size_max = (unsigned)value->i;
+            break;
         case CI_CERT_CHECK:
             assert(value->t == CIT_B);
             config->cert_check = value->b;
             break;
+        case CI_COMPRESSION_LEVEL:
+            assert(value->t == CIT_I);
+            config->compression_level = value->i;
+            break;
+        case CI_COMPRESSION_MIN_SIZE:
+            assert(value->t == CIT_I);
+            config->compression_min_size = (unsigned)value->i;
+            break;
         case CI_CUSTOM_CERT:
             assert(value->t == CIT_B);
             config->custom_cert = value->b;
@@ -41,6 +41,7 @@ struct t_config {
     int cache_lyrics_keep_days;     //!< expiration time for lyrics cache files in days
     int cache_misc_keep_days;       //!< expiration time for misc cache files in days
     int cache_thumbs_keep_days;     //!< expiration time for thumbs cache files in days
+    int compression_level;          //!< zlib compression level for http responses, 0 = disabled
     int http_port;                  //!< http port to listen
     int loglevel;                   //!< loglevel
     int ssl_port;                   //!< https port to listen
@@ -50,6 +51,11 @@ struct t_config {
     unsigned jukebox_queue_length_album_min;  //!< Minimum length of the internal jukebox queue for albums
     unsigned plist_len_max;                   //!< Max. length of a playlist
     unsigned smartpls_per_tag_value_max;      //!< Max. number of tag values to create a smart playlist for
+    unsigned compression_min_size;            //!< Minimum size of a response to compress
+    unsigned cache_cover_size_max;           //!< size limit of the cover cache in MiB, 0 = no limit
+    unsigned cache_http_size_max;            //!< size limit of the HTTP cache in MiB, 0 = no limit
+    unsigned cache_lyrics_size_max;          //!< size limit of the lyrics cache in MiB, 0 = no limit
+    unsigned cache_thumbs_size_max;          //!< size limit of the thumbs cache in MiB, 0 = no limit
     sds acl;                        //!< IPv4 ACL string
     sds ca_certs;                   //!< System CA certificates
     sds ca_cert_store;              //!< System CA certificate store file
@@ -43,6 +43,7 @@ void mympd_mpd_state_default(struct t_mpd_state *mpd_state, struct t_config *con
     //features
     mympd_mpd_state_features_default(&mpd_state->feat);
     list_init(&mpd_state->sticker_types);
+    playlist_catalogue_init(&mpd_state->playlist_catalogue);
 }
 
 /**
@@ -71,6 +72,8 @@ void mympd_mpd_state_copy(struct t_mpd_state *src, struct t_mpd_state *dst) {
     mympd_mpd_state_features_copy(&src->feat, &dst->feat);
     list_init(&dst->sticker_types);
     list_append(&dst->sticker_types, &src->sticker_types);
+    //the catalogue is populated on demand for each connection
+    playlist_catalogue_init(&dst->playlist_catalogue);
 }
 
 /**
@@ -116,6 +119,7 @@ void mympd_mpd_state_free(struct t_mpd_state *mpd_state) {
     FREE_SDS(mpd_state->music_directory_value);
     FREE_SDS(mpd_state->playlist_directory_value);
     list_clear(&mpd_state->sticker_types);
+    playlist_catalogue_free(&mpd_state->playlist_catalogue);
     //struct itself
     FREE_PTR(mpd_state);
 }
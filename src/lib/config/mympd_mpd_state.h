@@ -13,6 +13,7 @@
 
 #include "dist/sds/sds.h"
 #include "src/lib/fields.h"
+#include "src/lib/playlist_catalogue.h"
 
 #include <stdbool.h>
 
@@ -77,6 +78,7 @@ struct t_mpd_state {
     const unsigned *protocol;           //!< mpd protocol version
     struct t_mpd_features feat;         //!< feature flags
     struct t_list sticker_types;        //!< mpd sticker types
+    struct t_playlist_catalogue playlist_catalogue;  //!< stored playlists, populated on demand
 };
 
 /**
@@ -115,6 +115,8 @@ void mympd_state_default(struct t_mympd_state *mympd_state, struct t_config *con
     mympd_state->stickerdb = malloc_assert(sizeof(struct t_stickerdb_state));
     stickerdb_state_default(mympd_state->stickerdb, config);
     mympd_state->stickerdb->repopulate_pfds = &mympd_state->pfds.repopulate;
+    // the mympd_api thread caches the song stickers and flushes the pending writes by a timer
+    mympd_state->stickerdb->cache.enabled = true;
     // do not use the shared mpd_state - we can connect to another mpd server for stickers
     mympd_state->stickerdb->mpd_state = malloc_assert(sizeof(struct t_mpd_state));
     mympd_mpd_state_default(mympd_state->stickerdb->mpd_state, config);
@@ -127,6 +129,10 @@ void mympd_state_default(struct t_mympd_state *mympd_state, struct t_config *con
     mympd_state->timer_list.repopulate_pfds = &mympd_state->pfds.repopulate;
     //album cache
     cache_init(&mympd_state->album_cache);
+    //tag value cache
+    tag_value_cache_init(&mympd_state->tag_value_cache);
+    //directory listing cache
+    dir_cache_init(&mympd_state->dir_cache, DIR_CACHE_MEM_MAX);
     //init last played songs list
     mympd_state->last_played_count = MYMPD_LAST_PLAYED_COUNT;
     //poll fds
@@ -134,6 +140,8 @@ void mympd_state_default(struct t_mympd_state *mympd_state, struct t_config *con
     //webradios
     mympd_state->webradiodb = webradios_new();
     mympd_state->webradio_favorites = webradios_new();
+    //metrics
+    histogram_init(&mympd_state->control_latency);
 }
 
 /**
@@ -162,6 +170,8 @@ void mympd_state_free(struct t_mympd_state *mympd_state) {
     //caches
     album_cache_free(&mympd_state->album_cache);
     cache_free(&mympd_state->album_cache);
+    tag_value_cache_clear(&mympd_state->tag_value_cache);
+    dir_cache_free(&mympd_state->dir_cache);
     //webradioDB
     webradios_free(mympd_state->webradiodb);
     webradios_free(mympd_state->webradio_favorites);
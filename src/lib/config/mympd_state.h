@@ -18,11 +18,14 @@
 #include "src/lib/config/partition_state.h"
 #include "src/lib/config/stickerdb_state.h"
 #include "src/lib/config/timer_state.h"
+#include "src/lib/dir_cache.h"
 #include "src/lib/event.h"
 #include "src/lib/fields.h"
+#include "src/lib/histogram.h"
 #include "src/lib/jukebox.h"
 #include "src/lib/list/list.h"
 #include "src/lib/lyrics.h"
+#include "src/lib/tag_value_cache.h"
 #include "src/lib/webradio.h"
 
 /**
@@ -75,9 +78,12 @@ struct t_mympd_state {
     sds booklet_name;                               //!< name of the booklet files
     sds info_txt_name;                              //!< name of album info files
     struct t_cache album_cache;                     //!< the album cache created by the mympd_worker thread
+    struct t_tag_value_cache tag_value_cache;       //!< sorted tag values for the tag list
+    struct t_dir_cache dir_cache;                   //!< LRU cache of sorted directory listings
     unsigned last_played_count;                     //!< number of songs to keep in the last played list (disk + memory)
     struct t_webradios *webradiodb;                 //!< WebradioDB
     struct t_webradios *webradio_favorites;         //!< webradio favorites
+    struct t_histogram control_latency;             //!< execution time of the mympd_api request handler
 };
 
 /**
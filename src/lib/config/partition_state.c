@@ -48,6 +48,7 @@ void partition_state_default(struct t_partition_state *partition_state, const ch
     partition_state->last_song = NULL;
     partition_state->queue_version = 0;
     partition_state->queue_length = 0;
+    queue_mirror_init(&partition_state->queue_mirror);
     partition_state->song_start_time = 0;
     partition_state->song_end_time = 0;
     partition_state->last_song_start_time = 0;
@@ -106,6 +107,7 @@ void partition_state_free(struct t_partition_state *partition_state) {
     if (partition_state->last_song != NULL) {
         mpd_song_free(partition_state->last_song);
     }
+    queue_mirror_clear(&partition_state->queue_mirror);
     //jukebox
     jukebox_state_free(&partition_state->jukebox);
     //lists
@@ -18,6 +18,7 @@
 #include "src/lib/event.h"
 #include "src/lib/jukebox.h"
 #include "src/lib/list/list.h"
+#include "src/lib/queue_mirror.h"
 
 #include <time.h>
 
@@ -41,6 +42,7 @@ struct t_partition_state {
     struct mpd_song *last_song;            //!< previous song
     unsigned queue_version;                //!< queue version number (increments on queue change)
     unsigned queue_length;                 //!< length of the queue
+    struct t_queue_mirror queue_mirror;    //!< in-memory copy of the queue
     int last_skipped_id;                   //!< last skipped event was fired for this song id
     time_t song_end_time;                  //!< timestamp at which current song should end (starttime + duration)
     time_t last_song_end_time;             //!< timestamp at which previous song should end (starttime + duration)
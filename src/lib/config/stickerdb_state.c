@@ -25,6 +25,8 @@ void stickerdb_state_default(struct t_stickerdb_state *stickerdb, struct t_confi
     stickerdb->mpd_state = NULL;
     stickerdb->conn_state = MPD_DISCONNECTED;
     stickerdb->conn = NULL;
+    stickerdb->idle = false;
+    sticker_cache_init(&stickerdb->cache);
     stickerdb->name = sdsnew("stickerdb");
 }
 
@@ -33,6 +35,7 @@ void stickerdb_state_default(struct t_stickerdb_state *stickerdb, struct t_confi
  * @param stickerdb pointer to struct
  */
 void stickerdb_state_free(struct t_stickerdb_state *stickerdb) {
+    sticker_cache_free(&stickerdb->cache);
     FREE_SDS(stickerdb->name);
     FREE_PTR(stickerdb);
 }
@@ -14,6 +14,7 @@
 #include "dist/sds/sds.h"
 #include "src/lib/config/config_def.h"
 #include "src/lib/config/mympd_mpd_state.h"
+#include "src/lib/sticker_cache.h"
 
 /**
  * Holds stickerdb specific states
@@ -24,6 +25,8 @@ struct t_stickerdb_state {
     //mpd connection
     struct mpd_connection *conn;           //!< mpd connection object from libmpdclient
     enum mympd_mpd_conn_states conn_state; //!< mpd connection state
+    bool idle;                             //!< true if the connection is in idle mode
+    struct t_sticker_cache cache;          //!< song sticker cache
     sds name;                              //!< name for logging
     bool *repopulate_pfds;                 //!< Pointer to repopulate state in mympd_state struct
 };
@@ -0,0 +1,318 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2026 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+/*! \file
+ * \brief Byte budgeted LRU cache of sorted directory listings
+ */
+
+#include "compile_time.h"
+#include "src/lib/dir_cache.h"
+
+#include "src/lib/json/json_print.h"
+#include "src/lib/mem.h"
+#include "src/lib/sds/sds_extras.h"
+#include "src/lib/sds/sds_utf8.h"
+#include "src/lib/utf8_wrapper.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Private definitions
+ */
+
+/**
+ * Approximated fixed size of a libmpdclient song: the tag slots and the numeric attributes
+ */
+#define SONG_SIZE_FIXED (MPD_TAG_COUNT * 2 * sizeof(void *) + 96)
+
+static int dir_cache_entry_cmp(const void *a, const void *b);
+static size_t song_size(const struct mpd_song *song);
+static void listing_remove(struct t_dir_cache *cache, struct t_dir_listing *listing);
+
+/**
+ * Public functions
+ */
+
+/**
+ * Initializes an empty directory listing cache
+ * @param cache pointer to the cache
+ * @param max_size byte budget
+ */
+void dir_cache_init(struct t_dir_cache *cache, size_t max_size) {
+    cache->listings = raxNew();
+    lru_list_init(&cache->lru);
+    cache->size = 0;
+    cache->max_size = max_size;
+    cache->hits = 0;
+    cache->misses = 0;
+}
+
+/**
+ * Frees all listings, the metrics are preserved
+ * @param cache pointer to the cache
+ */
+void dir_cache_clear(struct t_dir_cache *cache) {
+    while (cache->lru.head != NULL) {
+        listing_remove(cache, LRU_LIST_ENTRY(cache->lru.head, struct t_dir_listing, lru));
+    }
+}
+
+/**
+ * Frees all listings and the cache index
+ * @param cache pointer to the cache
+ */
+void dir_cache_free(struct t_dir_cache *cache) {
+    dir_cache_clear(cache);
+    raxFree(cache->listings);
+    cache->listings = NULL;
+}
+
+/**
+ * Gets the listing of a directory and marks it as most recently used
+ * @param cache pointer to the cache
+ * @param path path of the directory
+ * @return the listing or NULL if it is not cached
+ */
+struct t_dir_listing *dir_cache_get(struct t_dir_cache *cache, const char *path) {
+    void *data;
+    if (raxFind(cache->listings, (unsigned char *)path, strlen(path), &data) == 0) {
+        cache->misses++;
+        return NULL;
+    }
+    cache->hits++;
+    struct t_dir_listing *listing = (struct t_dir_listing *)data;
+    lru_list_touch(&cache->lru, &listing->lru);
+    return listing;
+}
+
+/**
+ * Adds a committed listing to the cache,
+ * least recently used listings are evicted to stay in the byte budget
+ * @param cache pointer to the cache
+ * @param listing the listing, the cache takes the ownership on success
+ * @return true if the listing was added, false if it is larger than the byte budget
+ */
+bool dir_cache_add(struct t_dir_cache *cache, struct t_dir_listing *listing) {
+    if (listing->size > cache->max_size) {
+        return false;
+    }
+    void *old;
+    if (raxFind(cache->listings, (unsigned char *)listing->path, sdslen(listing->path), &old) == 1) {
+        listing_remove(cache, (struct t_dir_listing *)old);
+    }
+    while (cache->lru.tail != NULL &&
+        cache->size + listing->size > cache->max_size)
+    {
+        listing_remove(cache, LRU_LIST_ENTRY(cache->lru.tail, struct t_dir_listing, lru));
+    }
+    raxInsert(cache->listings, (unsigned char *)listing->path, sdslen(listing->path), listing, NULL);
+    lru_list_link_head(&cache->lru, &listing->lru);
+    cache->size += listing->size;
+    return true;
+}
+
+/**
+ * Prints the cache metrics as json object
+ * @param buffer already allocated sds string to append
+ * @param cache pointer to the cache
+ * @return pointer to buffer
+ */
+sds dir_cache_stats(sds buffer, const struct t_dir_cache *cache) {
+    buffer = sdscatlen(buffer, "{", 1);
+    buffer = tojson_uint64(buffer, "listings", cache->listings->numele, true);
+    buffer = tojson_uint64(buffer, "bytes", cache->size, true);
+    buffer = tojson_uint64(buffer, "maxBytes", cache->max_size, true);
+    buffer = tojson_uint64(buffer, "hits", cache->hits, true);
+    buffer = tojson_uint64(buffer, "misses", cache->misses, false);
+    buffer = sdscatlen(buffer, "}", 1);
+    return buffer;
+}
+
+/**
+ * Creates an empty directory listing
+ * @param path path of the directory
+ * @return newly allocated listing
+ */
+struct t_dir_listing *dir_listing_new(const char *path) {
+    struct t_dir_listing *listing = malloc_assert(sizeof(struct t_dir_listing));
+    listing->path = sdsnew(path);
+    listing->entries = NULL;
+    listing->length = 0;
+    listing->alloc = 0;
+    listing->size = sizeof(struct t_dir_listing) + sdslen(listing->path);
+    listing->lru.prev = NULL;
+    listing->lru.next = NULL;
+    return listing;
+}
+
+/**
+ * Frees a directory listing that is not in the cache
+ * @param listing the listing
+ */
+void dir_listing_free(struct t_dir_listing *listing) {
+    for (unsigned i = 0; i < listing->length; i++) {
+        struct t_dir_cache_entry *entry = &listing->entries[i];
+        FREE_SDS(entry->key);
+        FREE_SDS(entry->name);
+        FREE_SDS(entry->name_normalized);
+        FREE_SDS(entry->uri);
+        if (entry->song != NULL) {
+            mpd_song_free(entry->song);
+        }
+    }
+    FREE_PTR(listing->entries);
+    FREE_SDS(listing->path);
+    FREE_PTR(listing);
+}
+
+/**
+ * Appends an entry while populating the listing
+ * @param listing the listing
+ * @param type entity type
+ * @param uri path of the directory or playlist, uri of the song
+ * @param name display name, the listing takes the ownership
+ * @param song the song or NULL, the listing takes the ownership
+ */
+void dir_listing_append(struct t_dir_listing *listing, enum mpd_entity_type type, const char *uri,
+        sds name, struct mpd_song *song)
+{
+    if (listing->length == listing->alloc) {
+        listing->alloc = listing->alloc == 0
+            ? 64
+            : listing->alloc * 2;
+        listing->entries = realloc_assert(listing->entries, listing->alloc * sizeof(struct t_dir_cache_entry));
+    }
+    struct t_dir_cache_entry *entry = &listing->entries[listing->length];
+    entry->type = type;
+    // custom order: directories, playlists, songs
+    char prefix = '2';
+    if (type == MPD_ENTITY_TYPE_DIRECTORY) {
+        prefix = '0';
+    }
+    else if (type == MPD_ENTITY_TYPE_PLAYLIST) {
+        prefix = '1';
+    }
+    entry->key = sdscatlen(sdsempty(), &prefix, 1);
+    entry->key = sds_utf8_normalize(sdscat(entry->key, uri));
+    entry->name = name;
+    entry->name_normalized = sds_utf8_normalize(sdsdup(name));
+    entry->song = song;
+    listing->size += sizeof(struct t_dir_cache_entry) + sdslen(entry->name) + sdslen(entry->name_normalized);
+    if (song == NULL) {
+        entry->uri = sdsnew(uri);
+        listing->size += sdslen(entry->uri);
+    }
+    else {
+        entry->uri = NULL;
+        listing->size += song_size(song);
+    }
+    listing->length++;
+}
+
+/**
+ * Sorts the appended entries and frees the sort keys
+ * @param listing the listing
+ */
+void dir_listing_commit(struct t_dir_listing *listing) {
+    if (listing->length > 1) {
+        qsort(listing->entries, listing->length, sizeof(struct t_dir_cache_entry), dir_cache_entry_cmp);
+    }
+    for (unsigned i = 0; i < listing->length; i++) {
+        FREE_SDS(listing->entries[i].key);
+    }
+}
+
+/**
+ * Gets a page of the entries with a display name containing the search string
+ * @param listing the listing
+ * @param searchstr string to search, it is normalized before matching
+ * @param searchstr_len length of searchstr
+ * @param offset offset of the page
+ * @param limit max number of entries in the page
+ * @param page array of at least limit elements, set to the indexes of the returned entries
+ * @param returned pointer to set the number of returned entries
+ * @return total number of matching entries
+ */
+unsigned dir_listing_page(const struct t_dir_listing *listing, const char *searchstr, size_t searchstr_len,
+        unsigned offset, unsigned limit, unsigned *page, unsigned *returned)
+{
+    *returned = 0;
+    size_t search_len = 0;
+    char *search = searchstr_len > 0
+        ? utf8_wrap_normalize(searchstr, searchstr_len, &search_len)
+        : NULL;
+    if (search_len == 0) {
+        for (unsigned i = offset; i < listing->length && *returned < limit; i++) {
+            page[(*returned)++] = i;
+        }
+        FREE_PTR(search);
+        return listing->length;
+    }
+    unsigned total = 0;
+    for (unsigned i = 0; i < listing->length; i++) {
+        if (strstr(listing->entries[i].name_normalized, search) == NULL) {
+            continue;
+        }
+        if (total >= offset &&
+            *returned < limit)
+        {
+            page[(*returned)++] = i;
+        }
+        total++;
+    }
+    FREE_PTR(search);
+    return total;
+}
+
+/**
+ * Private functions
+ */
+
+/**
+ * Compares two entries by the sort key and then by the display name
+ * @param a first entry
+ * @param b second entry
+ * @return result of the string comparison
+ */
+static int dir_cache_entry_cmp(const void *a, const void *b) {
+    const struct t_dir_cache_entry *entry1 = (const struct t_dir_cache_entry *)a;
+    const struct t_dir_cache_entry *entry2 = (const struct t_dir_cache_entry *)b;
+    int rc = strcmp(entry1->key, entry2->key);
+    return rc != 0
+        ? rc
+        : strcmp(entry1->name, entry2->name);
+}
+
+/**
+ * Approximates the memory usage of a song
+ * @param song the song
+ * @return size in bytes
+ */
+static size_t song_size(const struct mpd_song *song) {
+    size_t size = SONG_SIZE_FIXED + strlen(mpd_song_get_uri(song)) + 1;
+    for (int tag = 0; tag < MPD_TAG_COUNT; tag++) {
+        const char *value;
+        unsigned idx = 0;
+        while ((value = mpd_song_get_tag(song, (enum mpd_tag_type)tag, idx)) != NULL) {
+            size += strlen(value) + 1 + 2 * sizeof(void *);
+            idx++;
+        }
+    }
+    return size;
+}
+
+/**
+ * Removes and frees a listing
+ * @param cache pointer to the cache
+ * @param listing the listing
+ */
+static void listing_remove(struct t_dir_cache *cache, struct t_dir_listing *listing) {
+    raxRemove(cache->listings, (unsigned char *)listing->path, sdslen(listing->path), NULL);
+    lru_list_unlink(&cache->lru, &listing->lru);
+    cache->size -= listing->size;
+    dir_listing_free(listing);
+}
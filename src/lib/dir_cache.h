@@ -0,0 +1,74 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2026 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+/*! \file
+ * \brief Byte budgeted LRU cache of sorted directory listings
+ */
+
+#ifndef MYMPD_DIR_CACHE_H
+#define MYMPD_DIR_CACHE_H
+
+#include "dist/rax/rax.h"
+#include "dist/sds/sds.h"
+#include "src/lib/lru_list.h"
+#include "src/lib/mpdclient.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Entry of a directory listing
+ */
+struct t_dir_cache_entry {
+    enum mpd_entity_type type;  //!< directory, playlist or song
+    sds key;                    //!< normalized sort key, only set while populating
+    sds name;                   //!< display name
+    sds name_normalized;        //!< normalized display name for the search
+    sds uri;                    //!< path of the directory or playlist, NULL for songs
+    struct mpd_song *song;      //!< the song, NULL for directories and playlists
+};
+
+/**
+ * Sorted listing of a directory: directories, playlists, songs
+ */
+struct t_dir_listing {
+    sds path;                           //!< path of the directory
+    struct t_dir_cache_entry *entries;  //!< the sorted entries
+    unsigned length;                    //!< number of entries
+    unsigned alloc;                     //!< allocated number of entries
+    size_t size;                        //!< accounted bytes
+    struct t_lru_node lru;              //!< node in the recency list
+};
+
+/**
+ * LRU cache of directory listings keyed by path
+ */
+struct t_dir_cache {
+    rax *listings;               //!< listings by path
+    struct t_lru_list lru;       //!< listings by recency
+    size_t size;                 //!< accounted bytes of all listings
+    size_t max_size;             //!< byte budget
+    uint64_t hits;               //!< number of cache hits
+    uint64_t misses;             //!< number of cache misses
+};
+
+void dir_cache_init(struct t_dir_cache *cache, size_t max_size);
+void dir_cache_clear(struct t_dir_cache *cache);
+void dir_cache_free(struct t_dir_cache *cache);
+struct t_dir_listing *dir_cache_get(struct t_dir_cache *cache, const char *path);
+bool dir_cache_add(struct t_dir_cache *cache, struct t_dir_listing *listing);
+sds dir_cache_stats(sds buffer, const struct t_dir_cache *cache);
+
+struct t_dir_listing *dir_listing_new(const char *path);
+void dir_listing_free(struct t_dir_listing *listing);
+void dir_listing_append(struct t_dir_listing *listing, enum mpd_entity_type type, const char *uri,
+        sds name, struct mpd_song *song);
+void dir_listing_commit(struct t_dir_listing *listing);
+unsigned dir_listing_page(const struct t_dir_listing *listing, const char *searchstr, size_t searchstr_len,
+        unsigned offset, unsigned limit, unsigned *page, unsigned *returned);
+
+#endif
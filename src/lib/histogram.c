@@ -0,0 +1,182 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2026 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+/*! \file
+ * \brief Latency histograms
+ */
+
+#include "compile_time.h"
+#include "src/lib/histogram.h"
+
+#include "src/lib/json/json_print.h"
+
+#include <string.h>
+
+/**
+ * Public functions
+ */
+
+/**
+ * Initializes or resets the histogram
+ * @param histogram pointer to histogram
+ */
+void histogram_init(struct t_histogram *histogram) {
+    memset(histogram, 0, sizeof(struct t_histogram));
+}
+
+/**
+ * Adds a value to the histogram
+ * @param histogram pointer to histogram
+ * @param value_us value in microseconds
+ */
+void histogram_add(struct t_histogram *histogram, uint64_t value_us) {
+    histogram->buckets[histogram_bucket(value_us)]++;
+    histogram->count++;
+    histogram->sum_us += value_us;
+    if (value_us > histogram->max_us) {
+        histogram->max_us = value_us;
+    }
+}
+
+/**
+ * Adds the elapsed time since start to the histogram
+ * @param histogram pointer to histogram
+ * @param start start time from CLOCK_MONOTONIC
+ */
+void histogram_add_since(struct t_histogram *histogram, const struct timespec *start) {
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    histogram_add(histogram, histogram_elapsed_us(start, &now));
+}
+
+/**
+ * Adds all values of a histogram to another histogram
+ * @param dst histogram to merge into
+ * @param src histogram to merge
+ */
+void histogram_merge(struct t_histogram *dst, const struct t_histogram *src) {
+    for (unsigned i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        dst->buckets[i] += src->buckets[i];
+    }
+    dst->count += src->count;
+    dst->sum_us += src->sum_us;
+    if (src->max_us > dst->max_us) {
+        dst->max_us = src->max_us;
+    }
+}
+
+/**
+ * Returns the bucket for a value
+ * @param value_us value in microseconds
+ * @return bucket number
+ */
+unsigned histogram_bucket(uint64_t value_us) {
+    unsigned bucket = 0;
+    uint64_t bound = HISTOGRAM_FIRST_BOUND_US;
+    while (bucket < HISTOGRAM_BUCKETS - 1 &&
+        value_us > bound)
+    {
+        bucket++;
+        bound <<= 1;
+    }
+    return bucket;
+}
+
+/**
+ * Returns the upper bound of a bucket
+ * @param bucket bucket number
+ * @return upper bound in microseconds, UINT64_MAX for the last bucket
+ */
+uint64_t histogram_bucket_bound(unsigned bucket) {
+    if (bucket >= HISTOGRAM_BUCKETS - 1) {
+        return UINT64_MAX;
+    }
+    return (uint64_t)HISTOGRAM_FIRST_BOUND_US << bucket;
+}
+
+/**
+ * Estimates a percentile as the upper bound of the bucket that contains it.
+ * The estimate is capped by the maximum value.
+ * @param histogram pointer to histogram
+ * @param percentile percentile (0 - 100)
+ * @return percentile in microseconds, 0 for an empty histogram
+ */
+uint64_t histogram_percentile(const struct t_histogram *histogram, unsigned percentile) {
+    if (histogram->count == 0) {
+        return 0;
+    }
+    if (percentile > 100) {
+        percentile = 100;
+    }
+    // rank of the value, rounded up
+    uint64_t rank = (histogram->count * percentile + 99) / 100;
+    if (rank == 0) {
+        rank = 1;
+    }
+    uint64_t seen = 0;
+    for (unsigned i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        seen += histogram->buckets[i];
+        if (seen >= rank) {
+            uint64_t bound = histogram_bucket_bound(i);
+            return bound < histogram->max_us
+                ? bound
+                : histogram->max_us;
+        }
+    }
+    return histogram->max_us;
+}
+
+/**
+ * Prints the histogram as json object
+ * @param buffer already allocated sds string to append
+ * @param key json key for the object
+ * @param histogram pointer to histogram
+ * @param comma true to print a comma after the object
+ * @return pointer to buffer
+ */
+sds histogram_tojson(sds buffer, const char *key, const struct t_histogram *histogram, bool comma) {
+    buffer = sdscatfmt(buffer, "\"%s\":{", key);
+    buffer = tojson_uint64(buffer, "count", histogram->count, true);
+    buffer = tojson_uint64(buffer, "avgUs", (histogram->count > 0 ? histogram->sum_us / histogram->count : 0), true);
+    buffer = tojson_uint64(buffer, "maxUs", histogram->max_us, true);
+    buffer = tojson_uint64(buffer, "p50Us", histogram_percentile(histogram, 50), true);
+    buffer = tojson_uint64(buffer, "p95Us", histogram_percentile(histogram, 95), true);
+    buffer = tojson_uint64(buffer, "p99Us", histogram_percentile(histogram, 99), true);
+    buffer = sdscat(buffer, "\"buckets\":[");
+    for (unsigned i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        if (i > 0) {
+            buffer = sdscatlen(buffer, ",", 1);
+        }
+        buffer = sdscatlen(buffer, "{", 1);
+        if (i < HISTOGRAM_BUCKETS - 1) {
+            buffer = tojson_uint64(buffer, "leUs", histogram_bucket_bound(i), true);
+        }
+        else {
+            buffer = tojson_raw(buffer, "leUs", "null", true);
+        }
+        buffer = tojson_uint64(buffer, "count", histogram->buckets[i], false);
+        buffer = sdscatlen(buffer, "}", 1);
+    }
+    buffer = sdscatlen(buffer, "]}", 2);
+    if (comma == true) {
+        buffer = sdscatlen(buffer, ",", 1);
+    }
+    return buffer;
+}
+
+/**
+ * Calculates the elapsed time
+ * @param start start time
+ * @param end end time
+ * @return elapsed time in microseconds
+ */
+uint64_t histogram_elapsed_us(const struct timespec *start, const struct timespec *end) {
+    int64_t us = ((int64_t)end->tv_sec - (int64_t)start->tv_sec) * 1000000 +
+        ((int64_t)end->tv_nsec - (int64_t)start->tv_nsec) / 1000;
+    return us > 0
+        ? (uint64_t)us
+        : 0;
+}
@@ -0,0 +1,51 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2026 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+/*! \file
+ * \brief Latency histograms
+ */
+
+#ifndef MYMPD_LIB_HISTOGRAM_H
+#define MYMPD_LIB_HISTOGRAM_H
+
+#include "dist/sds/sds.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+/**
+ * Number of histogram buckets, the last bucket has no upper bound
+ */
+#define HISTOGRAM_BUCKETS 16
+
+/**
+ * Upper bound of the first bucket in microseconds,
+ * the upper bound doubles with each bucket
+ */
+#define HISTOGRAM_FIRST_BOUND_US 250
+
+/**
+ * Latency histogram with exponential buckets
+ */
+struct t_histogram {
+    uint64_t buckets[HISTOGRAM_BUCKETS];  //!< number of values in each bucket
+    uint64_t count;                       //!< number of values
+    uint64_t sum_us;                      //!< sum of all values in microseconds
+    uint64_t max_us;                      //!< maximum value in microseconds
+};
+
+void histogram_init(struct t_histogram *histogram);
+void histogram_add(struct t_histogram *histogram, uint64_t value_us);
+void histogram_add_since(struct t_histogram *histogram, const struct timespec *start);
+void histogram_merge(struct t_histogram *dst, const struct t_histogram *src);
+unsigned histogram_bucket(uint64_t value_us);
+uint64_t histogram_bucket_bound(unsigned bucket);
+uint64_t histogram_percentile(const struct t_histogram *histogram, unsigned percentile);
+sds histogram_tojson(sds buffer, const char *key, const struct t_histogram *histogram, bool comma);
+uint64_t histogram_elapsed_us(const struct timespec *start, const struct timespec *end);
+
+#endif
@@ -6,23 +6,99 @@
 
 /*! \file
  * \brief HTTP client cache
+ *
+ * The cache has two tiers: a byte budgeted in-memory LRU of decoded responses
+ * in front of the cache files. Memory hits do not touch the disk, the mtimes
+ * of the cache files are updated in a batch before the cache is cropped.
+ *
+ * Cache file layout:
+ * - magic (4 bytes)
+ * - length of the head block (4 bytes, big endian)
+ * - head block: mpack map with the response code and headers
+ * - body: raw bytes up to the end of the file
+ *
+ * Files without the magic are in the mpack format of older myMPD versions.
  */
 
 #include "compile_time.h"
 #include "src/lib/http_client/http_client_cache.h"
 
 #include "dist/mpack/mpack.h"
+#include "dist/rax/rax.h"
 #include "src/lib/cache/cache_disk.h"
+#include "src/lib/cache/cache_disk_index.h"
 #include "src/lib/config/config_def.h"
 #include "src/lib/filehandler.h"
 #include "src/lib/http_client/http_client.h"
 #include "src/lib/log.h"
+#include "src/lib/lru_list.h"
 #include "src/lib/mem.h"
 #include "src/lib/mpack.h"
 #include "src/lib/sds/sds_extras.h"
 #include "src/lib/sds/sds_hash.h"
 
+#include <errno.h>
 #include <inttypes.h>
+#include <pthread.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+/**
+ * Private definitions
+ */
+
+/**
+ * Magic of the cache files, 0xc1 is never used by msgpack
+ * and distinguishes the files from the old format
+ */
+static const char cache_magic[4] = {'\xc1', 'M', 'H', 'C'};
+
+/**
+ * Length of the cache file preamble: magic and head block length
+ */
+#define CACHE_PREAMBLE_LEN 8
+
+/**
+ * A cached response in memory
+ */
+struct t_http_cache_entry {
+    sds key;                                //!< sha256 hash of the uri
+    sds filepath;                           //!< path of the cache file
+    struct mg_client_response_t response;   //!< the decoded response
+    size_t size;                            //!< accounted bytes
+    time_t mtime;                           //!< last known mtime of the cache file
+    bool dirty;                             //!< mtime of the cache file must be updated
+    struct t_lru_node lru;                  //!< node in the recency list
+};
+
+/**
+ * The in-memory tier, shared by all script threads
+ */
+static struct {
+    pthread_mutex_t mutex;              //!< protects all other members
+    rax *entries;                       //!< entries by key, created on first use
+    struct t_lru_list lru;              //!< entries by recency
+    size_t size;                        //!< accounted bytes of all entries
+} mem = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .entries = NULL,
+    .lru = LRU_LIST_INIT,
+    .size = 0
+};
+
+static struct mg_client_response_t *cache_file_read(const char *filepath);
+static struct mg_client_response_t *cache_file_read_mpack(const char *filepath);
+static bool read_head(const char *data, size_t len, struct mg_client_response_t *response);
+static bool cache_file_write(sds tmp_file, struct mg_client_response_t *mg_client_response);
+static void response_copy(struct mg_client_response_t *dst, const struct mg_client_response_t *src);
+static struct mg_client_response_t *mem_get(const char *key);
+static void mem_set(const char *key, const char *filepath, const struct mg_client_response_t *response);
+static void mem_remove(struct t_http_cache_entry *entry);
+
+/**
+ * Public functions
+ */
 
 /**
  * Checks the http client cache for uri
@@ -37,33 +113,230 @@ struct mg_client_response_t *http_client_cache_check(struct t_config *config, co
     }
     sds hash = sds_hash_sha256(uri);
     sds filepath = sdscatfmt(sdsempty(), "%s/%s/%s", config->cachedir, DIR_CACHE_HTTP, hash);
-    FREE_SDS(hash);
-    if (testfile_read(filepath) == false) {
-        FREE_SDS(filepath);
-        return NULL;
+    struct mg_client_response_t *response = mem_get(hash);
+    if (response != NULL) {
+        MYMPD_LOG_INFO(NULL, "Found cached response in memory for %s", uri);
+    }
+    else if (testfile_read(filepath) == true) {
+        response = http_client_cache_read(filepath);
+        if (response != NULL) {
+            MYMPD_LOG_INFO(NULL, "Found cached response for %s", uri);
+            mem_set(hash, filepath, response);
+        }
     }
-    struct mg_client_response_t *response = http_client_cache_read(filepath);
-    FREE_SDS(filepath);
     if (response != NULL) {
-        MYMPD_LOG_INFO(NULL, "Found cached response for %s", uri);
-        return response;
+        cache_disk_index_touch(filepath);
     }
-    return NULL;
+    cache_disk_index_count(CACHE_DISK_TYPE_HTTP, response != NULL);
+    FREE_SDS(hash);
+    FREE_SDS(filepath);
+    return response;
 }
 
 /**
- * Reads a response from the http client cache
+ * Reads a response from the http client cache file
  * @param filepath Cache filename
  * @return struct mg_client_response_t* or NULL on error
  */
 struct mg_client_response_t *http_client_cache_read(const char *filepath) {
+    update_mtime(filepath);
+    struct mg_client_response_t *response = cache_file_read(filepath);
+    if (response == NULL) {
+        rm_file(filepath);
+    }
+    return response;
+}
+
+/**
+ * Writes a http client cache file and adds the response to the in-memory tier
+ * @param config Pointer to config
+ * @param uri URI to write the cache for
+ * @param mg_client_response The http response to cache
+ * @return true on success, else false
+ */
+bool http_client_cache_write(struct t_config *config, const char *uri, struct mg_client_response_t *mg_client_response) {
+    if (config->cache_http_keep_days == CACHE_DISK_DISABLED) {
+        MYMPD_LOG_DEBUG(NULL, "HTTP client cache disabled");
+        return true;
+    }
+    sds hash = sds_hash_sha256(uri);
+    sds tmp_file = sdscatfmt(sdsempty(), "%S/%s/%s.XXXXXX", config->cachedir, DIR_CACHE_HTTP, hash);
+    if (cache_file_write(tmp_file, mg_client_response) == false) {
+        FREE_SDS(hash);
+        FREE_SDS(tmp_file);
+        return false;
+    }
+    // rename tmp file
+    sds filepath = sdscatlen(sdsempty(), tmp_file, sdslen(tmp_file) - 7);
+    bool rc = true;
+    errno = 0;
+    if (rename(tmp_file, filepath) == -1) {
+        MYMPD_LOG_ERROR(NULL, "Rename file from \"%s\" to \"%s\" failed", tmp_file, filepath);
+        MYMPD_LOG_ERRNO(NULL, errno);
+        rm_file(tmp_file);
+        rc = false;
+    }
+    else {
+        cache_disk_index_add(filepath);
+        mem_set(hash, filepath, mg_client_response);
+    }
+    FREE_SDS(hash);
+    FREE_SDS(filepath);
+    FREE_SDS(tmp_file);
+    return rc;
+}
+
+/**
+ * Writes the pending mtime updates of the in-memory tier to the cache files
+ * and drops entries whose cache files expire.
+ * Must be called before the http cache directory is cropped.
+ * @param keep_days expiration of the cache files in days
+ */
+void http_client_cache_mem_flush(int keep_days) {
+    time_t now = time(NULL);
+    time_t expire_time = now - (time_t)keep_days * 24 * 60 * 60;
+    unsigned updated = 0;
+    unsigned dropped = 0;
+    pthread_mutex_lock(&mem.mutex);
+    struct t_lru_node *node = mem.lru.head;
+    while (node != NULL) {
+        struct t_lru_node *next = node->next;
+        struct t_http_cache_entry *current = LRU_LIST_ENTRY(node, struct t_http_cache_entry, lru);
+        if (current->dirty == true) {
+            if (update_mtime(current->filepath) == true) {
+                current->mtime = now;
+                current->dirty = false;
+                updated++;
+            }
+            else {
+                // cache file was removed
+                mem_remove(current);
+                dropped++;
+            }
+        }
+        else if (current->mtime < expire_time) {
+            mem_remove(current);
+            dropped++;
+        }
+        node = next;
+    }
+    pthread_mutex_unlock(&mem.mutex);
+    MYMPD_LOG_DEBUG(NULL, "HTTP client cache: updated mtime of %u files, dropped %u entries from memory", updated, dropped);
+}
+
+/**
+ * Removes all entries from the in-memory tier
+ */
+void http_client_cache_mem_clear(void) {
+    pthread_mutex_lock(&mem.mutex);
+    while (mem.lru.head != NULL) {
+        mem_remove(LRU_LIST_ENTRY(mem.lru.head, struct t_http_cache_entry, lru));
+    }
+    if (mem.entries != NULL) {
+        raxFree(mem.entries);
+        mem.entries = NULL;
+    }
+    pthread_mutex_unlock(&mem.mutex);
+}
+
+/**
+ * Removes an entry from the in-memory tier
+ * @param key sha256 hash of the uri, the name of the cache file
+ */
+void http_client_cache_mem_remove(const char *key) {
+    pthread_mutex_lock(&mem.mutex);
+    void *data;
+    if (mem.entries != NULL &&
+        raxFind(mem.entries, (unsigned char *)key, strlen(key), &data) == 1)
+    {
+        mem_remove((struct t_http_cache_entry *)data);
+    }
+    pthread_mutex_unlock(&mem.mutex);
+}
+
+/**
+ * Returns the accounted bytes of the in-memory tier
+ * @return size in bytes
+ */
+size_t http_client_cache_mem_size(void) {
+    pthread_mutex_lock(&mem.mutex);
+    size_t size = mem.size;
+    pthread_mutex_unlock(&mem.mutex);
+    return size;
+}
+
+/**
+ * Private functions
+ */
+
+/**
+ * Reads a cache file, the head block is parsed and the body is read as is
+ * @param filepath Cache filename
+ * @return struct mg_client_response_t* or NULL on error
+ */
+static struct mg_client_response_t *cache_file_read(const char *filepath) {
+    errno = 0;
+    FILE *fp = fopen(filepath, OPEN_FLAGS_READ_BIN);
+    if (fp == NULL) {
+        MYMPD_LOG_ERROR(NULL, "Error opening file \"%s\"", filepath);
+        MYMPD_LOG_ERRNO(NULL, errno);
+        return NULL;
+    }
+    unsigned char preamble[CACHE_PREAMBLE_LEN];
+    if (fread(preamble, 1, CACHE_PREAMBLE_LEN, fp) != CACHE_PREAMBLE_LEN ||
+        memcmp(preamble, cache_magic, sizeof(cache_magic)) != 0)
+    {
+        (void) fclose(fp);
+        return cache_file_read_mpack(filepath);
+    }
+    size_t head_len = ((size_t)preamble[4] << 24) | ((size_t)preamble[5] << 16) |
+        ((size_t)preamble[6] << 8) | (size_t)preamble[7];
+    struct stat status;
+    if (fstat(fileno(fp), &status) != 0 ||
+        (size_t)status.st_size < CACHE_PREAMBLE_LEN + head_len)
+    {
+        MYMPD_LOG_ERROR(NULL, "Invalid http client cache file \"%s\"", filepath);
+        (void) fclose(fp);
+        return NULL;
+    }
+    size_t body_len = (size_t)status.st_size - CACHE_PREAMBLE_LEN - head_len;
+    struct mg_client_response_t *response = malloc_assert(sizeof(struct mg_client_response_t));
+    http_client_response_init(response);
+    response->rc = 0;
+    char *head = malloc_assert(head_len);
+    bool rc = fread(head, 1, head_len, fp) == head_len &&
+        read_head(head, head_len, response) == true;
+    FREE_PTR(head);
+    if (rc == true) {
+        // stream the body directly into the response
+        response->body = sdsMakeRoomFor(response->body, body_len);
+        rc = fread(response->body, 1, body_len, fp) == body_len;
+        if (rc == true) {
+            sdsIncrLen(response->body, (ssize_t)body_len);
+        }
+    }
+    (void) fclose(fp);
+    if (rc == false) {
+        MYMPD_LOG_ERROR(NULL, "Error reading http client cache file \"%s\"", filepath);
+        http_client_response_clear(response);
+        FREE_PTR(response);
+        return NULL;
+    }
+    return response;
+}
+
+/**
+ * Reads a cache file in the mpack format of older myMPD versions
+ * @param filepath Cache filename
+ * @return struct mg_client_response_t* or NULL on error
+ */
+static struct mg_client_response_t *cache_file_read_mpack(const char *filepath) {
     struct mg_client_response_t *mg_client_response = malloc_assert(sizeof(struct mg_client_response_t));
     http_client_response_init(mg_client_response);
     mg_client_response->rc = 0;
     mpack_tree_t tree;
     mpack_tree_init_filename(&tree, filepath, 0);
     mpack_tree_set_error_handler(&tree, log_mpack_node_error);
-    update_mtime(filepath);
     mpack_tree_parse(&tree);
     mpack_node_t root = mpack_tree_root(&tree);
     mg_client_response->response_code = mpack_node_int(mpack_node_map_cstr(root, "code"));
@@ -91,34 +364,47 @@ struct mg_client_response_t *http_client_cache_read(const char *filepath) {
         return mg_client_response;
     }
     // Return NULL on error
-    rm_file(filepath);
     http_client_response_clear(mg_client_response);
     FREE_PTR(mg_client_response);
     return NULL;
 }
 
 /**
- * Writes a http client cache file
- * @param config Pointer to config
- * @param uri URI to write the cache for
- * @param mg_client_response The http response to cache
+ * Parses the head block of a cache file
+ * @param data the head block
+ * @param len length of the head block
+ * @param response response to populate
  * @return true on success, else false
  */
-bool http_client_cache_write(struct t_config *config, const char *uri, struct mg_client_response_t *mg_client_response) {
-    if (config->cache_http_keep_days == CACHE_DISK_DISABLED) {
-        MYMPD_LOG_DEBUG(NULL, "HTTP client cache disabled");
-        return true;
-    }
-    sds hash = sds_hash_sha256(uri);
-    sds tmp_file = sdscatfmt(sdsempty(), "%S/%s/%s.XXXXXX", config->cachedir, DIR_CACHE_HTTP, hash);
-    FREE_SDS(hash);
-    FILE *fp = open_tmp_file(tmp_file);
-    if (fp == NULL) {
-        FREE_SDS(tmp_file);
-        return false;
+static bool read_head(const char *data, size_t len, struct mg_client_response_t *response) {
+    mpack_tree_t tree;
+    mpack_tree_init_data(&tree, data, len);
+    mpack_tree_set_error_handler(&tree, log_mpack_node_error);
+    mpack_tree_parse(&tree);
+    mpack_node_t root = mpack_tree_root(&tree);
+    response->response_code = mpack_node_int(mpack_node_map_cstr(root, "code"));
+    mpack_node_t header_node = mpack_node_map_cstr(root, "header");
+    size_t header_len = mpack_node_array_length(header_node);
+    for (size_t i = 0; i + 1 < header_len; i += 2) {
+        mpack_node_t key_node = mpack_node_array_at(header_node, i);
+        mpack_node_t value_node = mpack_node_array_at(header_node, i + 1);
+        list_push_len(&response->header, mpack_node_str(key_node), mpack_node_strlen(key_node), 0,
+            mpack_node_str(value_node), mpack_node_strlen(value_node), NULL);
     }
+    return mpack_tree_destroy(&tree) == mpack_ok;
+}
+
+/**
+ * Writes the response to a new temporary cache file
+ * @param tmp_file template for the temporary file, it is populated with the real name
+ * @param mg_client_response The http response to write
+ * @return true on success, else false
+ */
+static bool cache_file_write(sds tmp_file, struct mg_client_response_t *mg_client_response) {
+    char *head;
+    size_t head_len;
     mpack_writer_t writer;
-    mpack_writer_init_stdfile(&writer, fp, true);
+    mpack_writer_init_growable(&writer, &head, &head_len);
     mpack_writer_set_error_handler(&writer, log_mpack_write_error);
     mpack_build_map(&writer);
     mpack_write_kv(&writer, "code", mg_client_response->response_code);
@@ -132,30 +418,139 @@ bool http_client_cache_write(struct t_config *config, const char *uri, struct mg
         current = current->next;
     }
     mpack_finish_array(&writer);
-    //write body
-    mpack_write_cstr(&writer, "body");
-    mpack_write_bin(&writer, mg_client_response->body, (uint32_t)sdslen(mg_client_response->body));
     mpack_complete_map(&writer);
-    // finish writing
-    bool rc = mpack_writer_destroy(&writer) != mpack_ok
-        ? false
-        : true;
-    if (rc == false) {
-        rm_file(tmp_file);
+    if (mpack_writer_destroy(&writer) != mpack_ok ||
+        head_len > UINT32_MAX)
+    {
         MYMPD_LOG_ERROR("default", "An error occurred encoding the data");
-        FREE_SDS(tmp_file);
+        FREE_PTR(head);
         return false;
     }
-    // rename tmp file
-    sds filepath = sdscatlen(sdsempty(), tmp_file, sdslen(tmp_file) - 7);
-    errno = 0;
-    if (rename(tmp_file, filepath) == -1) {
-        MYMPD_LOG_ERROR(NULL, "Rename file from \"%s\" to \"%s\" failed", tmp_file, filepath);
-        MYMPD_LOG_ERRNO(NULL, errno);
+    FILE *fp = open_tmp_file(tmp_file);
+    if (fp == NULL) {
+        FREE_PTR(head);
+        return false;
+    }
+    unsigned char preamble[CACHE_PREAMBLE_LEN];
+    memcpy(preamble, cache_magic, sizeof(cache_magic));
+    preamble[4] = (unsigned char)(head_len >> 24);
+    preamble[5] = (unsigned char)(head_len >> 16);
+    preamble[6] = (unsigned char)(head_len >> 8);
+    preamble[7] = (unsigned char)head_len;
+    size_t body_len = sdslen(mg_client_response->body);
+    bool rc = fwrite(preamble, 1, CACHE_PREAMBLE_LEN, fp) == CACHE_PREAMBLE_LEN &&
+        fwrite(head, 1, head_len, fp) == head_len &&
+        fwrite(mg_client_response->body, 1, body_len, fp) == body_len;
+    FREE_PTR(head);
+    if (fclose(fp) != 0 ||
+        rc == false)
+    {
+        MYMPD_LOG_ERROR(NULL, "Error writing data to file \"%s\"", tmp_file);
         rm_file(tmp_file);
-        rc = false;
+        return false;
     }
-    FREE_SDS(filepath);
-    FREE_SDS(tmp_file);
-    return rc;
+    return true;
+}
+
+/**
+ * Copies the response code, headers and body of a response
+ * @param dst initialized response to populate
+ * @param src response to copy
+ */
+static void response_copy(struct mg_client_response_t *dst, const struct mg_client_response_t *src) {
+    dst->rc = src->rc;
+    dst->response_code = src->response_code;
+    struct t_list_node *current = src->header.head;
+    while (current != NULL) {
+        list_push(&dst->header, current->key, 0, current->value_p, NULL);
+        current = current->next;
+    }
+    dst->body = sdscatsds(dst->body, src->body);
+}
+
+/**
+ * Looks up a response in the in-memory tier
+ * @param key sha256 hash of the uri
+ * @return copy of the cached response or NULL if not found
+ */
+static struct mg_client_response_t *mem_get(const char *key) {
+    struct mg_client_response_t *response = NULL;
+    pthread_mutex_lock(&mem.mutex);
+    void *data;
+    if (mem.entries != NULL &&
+        raxFind(mem.entries, (unsigned char *)key, strlen(key), &data) == 1)
+    {
+        struct t_http_cache_entry *entry = (struct t_http_cache_entry *)data;
+        lru_list_touch(&mem.lru, &entry->lru);
+        entry->dirty = true;
+        response = malloc_assert(sizeof(struct mg_client_response_t));
+        http_client_response_init(response);
+        response_copy(response, &entry->response);
+    }
+    pthread_mutex_unlock(&mem.mutex);
+    return response;
+}
+
+/**
+ * Adds or replaces a response in the in-memory tier,
+ * least recently used entries are evicted to stay in the byte budget
+ * @param key sha256 hash of the uri
+ * @param filepath path of the cache file
+ * @param response response to add, it is copied
+ */
+static void mem_set(const char *key, const char *filepath, const struct mg_client_response_t *response) {
+    size_t size = sizeof(struct t_http_cache_entry) + sdslen(response->body);
+    struct t_list_node *current = response->header.head;
+    while (current != NULL) {
+        size += sdslen(current->key) + sdslen(current->value_p) + sizeof(struct t_list_node);
+        current = current->next;
+    }
+    if (size > HTTP_CLIENT_CACHE_MEM_ENTRY_MAX) {
+        MYMPD_LOG_DEBUG(NULL, "Response is too large for the in-memory http client cache");
+        return;
+    }
+    struct t_http_cache_entry *entry = malloc_assert(sizeof(struct t_http_cache_entry));
+    entry->key = sdsnew(key);
+    entry->filepath = sdsnew(filepath);
+    http_client_response_init(&entry->response);
+    response_copy(&entry->response, response);
+    entry->size = size;
+    entry->mtime = time(NULL);
+    entry->dirty = false;
+
+    pthread_mutex_lock(&mem.mutex);
+    if (mem.entries == NULL) {
+        mem.entries = raxNew();
+    }
+    void *old;
+    if (raxFind(mem.entries, (unsigned char *)key, strlen(key), &old) == 1) {
+        mem_remove((struct t_http_cache_entry *)old);
+    }
+    while (mem.lru.tail != NULL &&
+        mem.size + size > HTTP_CLIENT_CACHE_MEM_MAX)
+    {
+        struct t_http_cache_entry *evict = LRU_LIST_ENTRY(mem.lru.tail, struct t_http_cache_entry, lru);
+        if (evict->dirty == true) {
+            update_mtime(evict->filepath);
+        }
+        mem_remove(evict);
+    }
+    raxInsert(mem.entries, (unsigned char *)entry->key, sdslen(entry->key), entry, NULL);
+    lru_list_link_head(&mem.lru, &entry->lru);
+    mem.size += size;
+    pthread_mutex_unlock(&mem.mutex);
+}
+
+/**
+ * Removes and frees an entry, the mutex must be held
+ * @param entry the entry
+ */
+static void mem_remove(struct t_http_cache_entry *entry) {
+    raxRemove(mem.entries, (unsigned char *)entry->key, sdslen(entry->key), NULL);
+    lru_list_unlink(&mem.lru, &entry->lru);
+    mem.size -= entry->size;
+    FREE_SDS(entry->key);
+    FREE_SDS(entry->filepath);
+    http_client_response_clear(&entry->response);
+    FREE_PTR(entry);
 }
@@ -13,8 +13,14 @@
 
 #include "src/lib/config/config_def.h"
 
+#include <stddef.h>
+
 struct mg_client_response_t *http_client_cache_check(struct t_config *config, const char *uri);
 struct mg_client_response_t *http_client_cache_read(const char *filepath);
 bool http_client_cache_write(struct t_config *config, const char *uri, struct mg_client_response_t *mg_client_response);
+void http_client_cache_mem_flush(int keep_days);
+void http_client_cache_mem_clear(void);
+void http_client_cache_mem_remove(const char *key);
+size_t http_client_cache_mem_size(void);
 
 #endif
@@ -0,0 +1,211 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2026 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+/*! \file
+ * \brief In-memory index of resolved image paths
+ *
+ * Entries are validated against generation counters instead of the filesystem.
+ * Adding files invalidates the negative entries of a scope,
+ * removing files invalidates all entries of a scope.
+ * Negative entries for the music directory expire additionally after
+ * IMAGE_INDEX_NEGATIVE_TTL seconds, because images can be added without
+ * a database update.
+ */
+
+#include "compile_time.h"
+#include "src/lib/image_index.h"
+
+#include "src/lib/json/json_print.h"
+#include "src/lib/log.h"
+#include "src/lib/mem.h"
+#include "src/lib/sds/sds_extras.h"
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <time.h>
+
+/**
+ * Private definitions
+ */
+
+/**
+ * An index entry
+ */
+struct t_image_index_entry {
+    sds path;                      //!< resolved path, empty for a negative entry
+    enum image_index_scope scope;  //!< invalidation scope
+    unsigned generation;           //!< generation of the scope at creation time
+    time_t expires;                //!< expiration time, 0 for no expiration
+};
+
+static _Atomic unsigned added_generation[IMAGE_INDEX_SCOPE_COUNT];    //!< incremented if files are added
+static _Atomic unsigned removed_generation[IMAGE_INDEX_SCOPE_COUNT];  //!< incremented if files are removed
+static _Atomic uint64_t index_hits;      //!< lookups answered by the index
+static _Atomic uint64_t index_misses;    //!< lookups not answered by the index
+static _Atomic unsigned index_entries;   //!< number of entries
+
+static bool entry_is_valid(const struct t_image_index_entry *entry);
+static void free_entry(void *data);
+
+/**
+ * Public functions
+ */
+
+/**
+ * Creates a new image index
+ * @return newly allocated image index
+ */
+struct t_image_index *image_index_new(void) {
+    struct t_image_index *image_index = malloc_assert(sizeof(struct t_image_index));
+    image_index->entries = raxNew();
+    return image_index;
+}
+
+/**
+ * Frees the image index
+ * @param image_index pointer to image index, can be NULL
+ */
+void image_index_free(struct t_image_index *image_index) {
+    if (image_index == NULL) {
+        return;
+    }
+    index_entries -= (unsigned)image_index->entries->numele;
+    raxFreeWithCallback(image_index->entries, free_entry);
+    FREE_PTR(image_index);
+}
+
+/**
+ * Removes all entries from the image index
+ * @param image_index pointer to image index
+ */
+void image_index_clear(struct t_image_index *image_index) {
+    index_entries -= (unsigned)image_index->entries->numele;
+    raxFreeWithCallback(image_index->entries, free_entry);
+    image_index->entries = raxNew();
+}
+
+/**
+ * Looks up a key in the image index
+ * @param image_index pointer to image index
+ * @param key lookup key
+ * @param key_len length of the key
+ * @return the resolved path, an empty string for a negative entry,
+ *         NULL if the key is not indexed
+ */
+sds image_index_get(struct t_image_index *image_index, const char *key, size_t key_len) {
+    void *data;
+    if (raxFind(image_index->entries, (unsigned char *)key, key_len, &data) == 1) {
+        struct t_image_index_entry *entry = (struct t_image_index_entry *)data;
+        if (entry_is_valid(entry) == true) {
+            index_hits++;
+            return entry->path;
+        }
+        raxRemove(image_index->entries, (unsigned char *)key, key_len, NULL);
+        free_entry(entry);
+        index_entries--;
+    }
+    index_misses++;
+    return NULL;
+}
+
+/**
+ * Adds or replaces an entry in the image index.
+ * The index is cleared if it reaches IMAGE_INDEX_MAX_ENTRIES.
+ * @param image_index pointer to image index
+ * @param scope invalidation scope
+ * @param key lookup key
+ * @param key_len length of the key
+ * @param path resolved path, empty for a negative entry
+ * @param path_len length of the path
+ */
+void image_index_set(struct t_image_index *image_index, enum image_index_scope scope,
+        const char *key, size_t key_len, const char *path, size_t path_len)
+{
+    if (image_index->entries->numele >= IMAGE_INDEX_MAX_ENTRIES) {
+        MYMPD_LOG_DEBUG(NULL, "Image index is full, clearing it");
+        image_index_clear(image_index);
+    }
+    struct t_image_index_entry *entry = malloc_assert(sizeof(struct t_image_index_entry));
+    entry->path = sdsnewlen(path, path_len);
+    entry->scope = scope;
+    entry->generation = path_len == 0
+        ? added_generation[scope] + removed_generation[scope]
+        : removed_generation[scope];
+    entry->expires = path_len == 0 && scope == IMAGE_INDEX_SCOPE_MUSIC
+        ? time(NULL) + IMAGE_INDEX_NEGATIVE_TTL
+        : 0;
+    void *old = NULL;
+    if (raxInsert(image_index->entries, (unsigned char *)key, key_len, entry, &old) == 0) {
+        // key already exists, raxInsert has replaced the old entry
+        free_entry(old);
+    }
+    else {
+        index_entries++;
+    }
+}
+
+/**
+ * Invalidates the negative entries of a scope.
+ * This function is thread safe.
+ * @param scope invalidation scope
+ */
+void image_index_files_added(enum image_index_scope scope) {
+    added_generation[scope]++;
+}
+
+/**
+ * Invalidates all entries of a scope.
+ * This function is thread safe.
+ * @param scope invalidation scope
+ */
+void image_index_files_removed(enum image_index_scope scope) {
+    removed_generation[scope]++;
+}
+
+/**
+ * Prints the image index metrics as json object
+ * @param buffer already allocated sds string to append
+ * @return pointer to buffer
+ */
+sds image_index_stats(sds buffer) {
+    buffer = sdscatlen(buffer, "{", 1);
+    buffer = tojson_uint(buffer, "entries", index_entries, true);
+    buffer = tojson_uint64(buffer, "hits", index_hits, true);
+    buffer = tojson_uint64(buffer, "misses", index_misses, false);
+    buffer = sdscatlen(buffer, "}", 1);
+    return buffer;
+}
+
+/**
+ * Private functions
+ */
+
+/**
+ * Checks the generation and the expiration time of an entry
+ * @param entry the entry to check
+ * @return true if the entry is valid, else false
+ */
+static bool entry_is_valid(const struct t_image_index_entry *entry) {
+    if (entry->expires > 0 &&
+        entry->expires < time(NULL))
+    {
+        return false;
+    }
+    unsigned generation = sdslen(entry->path) == 0
+        ? added_generation[entry->scope] + removed_generation[entry->scope]
+        : removed_generation[entry->scope];
+    return entry->generation == generation;
+}
+
+/**
+ * Frees an index entry
+ * @param data void pointer to the entry
+ */
+static void free_entry(void *data) {
+    struct t_image_index_entry *entry = (struct t_image_index_entry *)data;
+    FREE_SDS(entry->path);
+    FREE_PTR(entry);
+}
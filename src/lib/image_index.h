@@ -0,0 +1,47 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2026 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+/*! \file
+ * \brief In-memory index of resolved image paths
+ */
+
+#ifndef MYMPD_LIB_IMAGE_INDEX_H
+#define MYMPD_LIB_IMAGE_INDEX_H
+
+#include "dist/rax/rax.h"
+#include "dist/sds/sds.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * Invalidation scopes for the image index
+ */
+enum image_index_scope {
+    IMAGE_INDEX_SCOPE_CACHE = 0,  //!< covercache and thumbs cache, written and cropped by myMPD
+    IMAGE_INDEX_SCOPE_MUSIC,      //!< mpd music directory, changes are signaled by the mpd database idle event, negative entries expire
+    IMAGE_INDEX_SCOPE_COUNT
+};
+
+/**
+ * Index of resolved image paths including negative entries.
+ * The index is not thread safe, only the invalidation functions can be called from any thread.
+ */
+struct t_image_index {
+    rax *entries;  //!< the index entries by lookup key
+};
+
+struct t_image_index *image_index_new(void);
+void image_index_free(struct t_image_index *image_index);
+void image_index_clear(struct t_image_index *image_index);
+sds image_index_get(struct t_image_index *image_index, const char *key, size_t key_len);
+void image_index_set(struct t_image_index *image_index, enum image_index_scope scope,
+        const char *key, size_t key_len, const char *path, size_t path_len);
+void image_index_files_added(enum image_index_scope scope);
+void image_index_files_removed(enum image_index_scope scope);
+sds image_index_stats(sds buffer);
+
+#endif
@@ -0,0 +1,432 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2026 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+/*! \file
+ * \brief Token index for json documents
+ */
+
+#include "compile_time.h"
+#include "src/lib/json/json_index.h"
+
+#include "src/lib/mem.h"
+
+#include <limits.h>
+#include <string.h>
+
+/**
+ * This unit tokenizes a json document once,
+ * json paths are resolved against the token array.
+ */
+
+/**
+ * Private definitions
+ */
+
+/**
+ * Maximum nesting depth, same as for the mongoose json parser
+ */
+#define JSON_INDEX_MAX_DEPTH 30
+
+/**
+ * Parser state
+ */
+struct t_json_parser {
+    struct t_json_index *index;  //!< index to populate
+    const char *json;            //!< json document
+    size_t len;                  //!< length of the json document
+    size_t pos;                  //!< current position
+};
+
+static bool parse_value(struct t_json_parser *p, unsigned parent, unsigned key_off, unsigned key_len, unsigned depth);
+static bool parse_string(struct t_json_parser *p);
+static bool parse_number(struct t_json_parser *p);
+static bool parse_literal(struct t_json_parser *p, const char *literal, size_t literal_len);
+static void skip_whitespace(struct t_json_parser *p);
+static unsigned add_token(struct t_json_index *index);
+
+/**
+ * Public functions
+ */
+
+/**
+ * Initializes an empty token index
+ * @param index pointer to token index
+ */
+void json_index_init(struct t_json_index *index) {
+    index->json = NULL;
+    index->json_len = 0;
+    index->tokens = NULL;
+    index->count = 0;
+    index->capacity = 0;
+}
+
+/**
+ * Frees the tokens and resets the token index
+ * @param index pointer to token index
+ */
+void json_index_clear(struct t_json_index *index) {
+    FREE_PTR(index->tokens);
+    json_index_init(index);
+}
+
+/**
+ * Tokenizes a json document in one pass.
+ * The document must be valid json and must not change while the index is used.
+ * @param index pointer to initialized token index
+ * @param json json document
+ * @param len length of the json document
+ * @return true on success, false on invalid json
+ */
+bool json_index_parse(struct t_json_index *index, const char *json, size_t len) {
+    index->json = NULL;
+    index->json_len = 0;
+    index->count = 0;
+    if (len > UINT_MAX) {
+        return false;
+    }
+    struct t_json_parser p = {
+        .index = index,
+        .json = json,
+        .len = len,
+        .pos = 0
+    };
+    skip_whitespace(&p);
+    if (parse_value(&p, 0, 0, 0, 0) == false) {
+        index->count = 0;
+        return false;
+    }
+    skip_whitespace(&p);
+    if (p.pos != len) {
+        index->count = 0;
+        return false;
+    }
+    index->json = json;
+    index->json_len = len;
+    return true;
+}
+
+/**
+ * Resolves a json path against the token index.
+ * Supported are object keys and array indexes, e.g. $.params.uris[0]
+ * @param index pointer to token index
+ * @param path json path
+ * @return index of the token, JSON_INDEX_NOT_FOUND or JSON_INDEX_UNSUPPORTED
+ */
+int json_index_find(const struct t_json_index *index, const char *path) {
+    if (index->count == 0 ||
+        path[0] != '$')
+    {
+        return JSON_INDEX_UNSUPPORTED;
+    }
+    unsigned cur = 0;
+    const char *p = path + 1;
+    while (*p != '\0') {
+        const struct t_json_token *token = &index->tokens[cur];
+        unsigned child = cur + 1;
+        if (*p == '.') {
+            p++;
+            size_t key_len = strcspn(p, ".[");
+            if (key_len == 0 ||
+                memchr(p, '*', key_len) != NULL)
+            {
+                return JSON_INDEX_UNSUPPORTED;
+            }
+            if (token->type != JSON_TOK_OBJECT) {
+                return JSON_INDEX_NOT_FOUND;
+            }
+            while (child < token->next) {
+                if (index->tokens[child].key_len == key_len &&
+                    memcmp(index->json + index->tokens[child].key_off, p, key_len) == 0)
+                {
+                    break;
+                }
+                child = index->tokens[child].next;
+            }
+            p += key_len;
+        }
+        else if (*p == '[') {
+            p++;
+            if (*p < '0' || *p > '9') {
+                return JSON_INDEX_UNSUPPORTED;
+            }
+            unsigned n = 0;
+            while (*p >= '0' && *p <= '9') {
+                n = n * 10 + (unsigned)(*p - '0');
+                p++;
+            }
+            if (*p != ']') {
+                return JSON_INDEX_UNSUPPORTED;
+            }
+            p++;
+            if (token->type != JSON_TOK_ARRAY) {
+                return JSON_INDEX_NOT_FOUND;
+            }
+            while (child < token->next &&
+                n > 0)
+            {
+                child = index->tokens[child].next;
+                n--;
+            }
+        }
+        else {
+            return JSON_INDEX_UNSUPPORTED;
+        }
+        if (child >= token->next) {
+            return JSON_INDEX_NOT_FOUND;
+        }
+        cur = child;
+    }
+    return (int)cur;
+}
+
+/**
+ * Private functions
+ */
+
+/**
+ * Parses a json value and its children
+ * @param p parser state
+ * @param parent index of the parent token
+ * @param key_off offset of the object key
+ * @param key_len length of the object key
+ * @param depth current nesting depth
+ * @return true on success, else false
+ */
+static bool parse_value(struct t_json_parser *p, unsigned parent, unsigned key_off, unsigned key_len, unsigned depth) {
+    if (p->pos >= p->len ||
+        depth > JSON_INDEX_MAX_DEPTH)
+    {
+        return false;
+    }
+    unsigned idx = add_token(p->index);
+    struct t_json_token *token = &p->index->tokens[idx];
+    token->off = (unsigned)p->pos;
+    token->key_off = key_off;
+    token->key_len = key_len;
+    token->parent = parent;
+    bool rc;
+    char c = p->json[p->pos];
+    switch(c) {
+        case '{':
+        case '[': {
+            char close = c == '{'
+                ? '}'
+                : ']';
+            token->type = c == '{'
+                ? JSON_TOK_OBJECT
+                : JSON_TOK_ARRAY;
+            p->pos++;
+            skip_whitespace(p);
+            rc = true;
+            if (p->pos < p->len &&
+                p->json[p->pos] == close)
+            {
+                p->pos++;
+                break;
+            }
+            while (rc == true) {
+                unsigned child_key_off = 0;
+                unsigned child_key_len = 0;
+                if (close == '}') {
+                    size_t key_start = p->pos;
+                    if (p->pos >= p->len ||
+                        p->json[p->pos] != '"' ||
+                        parse_string(p) == false)
+                    {
+                        rc = false;
+                        break;
+                    }
+                    child_key_off = (unsigned)key_start + 1;
+                    child_key_len = (unsigned)(p->pos - key_start - 2);
+                    skip_whitespace(p);
+                    if (p->pos >= p->len ||
+                        p->json[p->pos] != ':')
+                    {
+                        rc = false;
+                        break;
+                    }
+                    p->pos++;
+                    skip_whitespace(p);
+                }
+                rc = parse_value(p, idx, child_key_off, child_key_len, depth + 1);
+                if (rc == false) {
+                    break;
+                }
+                skip_whitespace(p);
+                if (p->pos >= p->len) {
+                    rc = false;
+                    break;
+                }
+                if (p->json[p->pos] == ',') {
+                    p->pos++;
+                    skip_whitespace(p);
+                    continue;
+                }
+                if (p->json[p->pos] == close) {
+                    p->pos++;
+                    break;
+                }
+                rc = false;
+            }
+            break;
+        }
+        case '"':
+            token->type = JSON_TOK_STRING;
+            rc = parse_string(p);
+            break;
+        case 't':
+            token->type = JSON_TOK_TRUE;
+            rc = parse_literal(p, "true", 4);
+            break;
+        case 'f':
+            token->type = JSON_TOK_FALSE;
+            rc = parse_literal(p, "false", 5);
+            break;
+        case 'n':
+            token->type = JSON_TOK_NULL;
+            rc = parse_literal(p, "null", 4);
+            break;
+        default:
+            token->type = JSON_TOK_NUMBER;
+            rc = parse_number(p);
+    }
+    // the token array could be reallocated by the children
+    token = &p->index->tokens[idx];
+    token->len = (unsigned)(p->pos - token->off);
+    token->next = p->index->count;
+    return rc;
+}
+
+/**
+ * Skips a json string including the quotes
+ * @param p parser state, pos must point to the opening quote
+ * @return true on success, else false
+ */
+static bool parse_string(struct t_json_parser *p) {
+    p->pos++;
+    while (p->pos < p->len) {
+        unsigned char c = (unsigned char)p->json[p->pos];
+        if (c == '"') {
+            p->pos++;
+            return true;
+        }
+        if (c < 0x20) {
+            return false;
+        }
+        if (c == '\\') {
+            p->pos++;
+            if (p->pos >= p->len ||
+                strchr("\"\\/bfnrtu", p->json[p->pos]) == NULL)
+            {
+                return false;
+            }
+        }
+        p->pos++;
+    }
+    return false;
+}
+
+/**
+ * Skips a json number
+ * @param p parser state
+ * @return true on success, else false
+ */
+static bool parse_number(struct t_json_parser *p) {
+    size_t start = p->pos;
+    if (p->pos < p->len &&
+        p->json[p->pos] == '-')
+    {
+        p->pos++;
+    }
+    size_t digits = p->pos;
+    while (p->pos < p->len &&
+        p->json[p->pos] >= '0' && p->json[p->pos] <= '9')
+    {
+        p->pos++;
+    }
+    if (p->pos == digits) {
+        return false;
+    }
+    if (p->pos < p->len &&
+        p->json[p->pos] == '.')
+    {
+        p->pos++;
+        digits = p->pos;
+        while (p->pos < p->len &&
+            p->json[p->pos] >= '0' && p->json[p->pos] <= '9')
+        {
+            p->pos++;
+        }
+        if (p->pos == digits) {
+            return false;
+        }
+    }
+    if (p->pos < p->len &&
+        (p->json[p->pos] == 'e' || p->json[p->pos] == 'E'))
+    {
+        p->pos++;
+        if (p->pos < p->len &&
+            (p->json[p->pos] == '+' || p->json[p->pos] == '-'))
+        {
+            p->pos++;
+        }
+        digits = p->pos;
+        while (p->pos < p->len &&
+            p->json[p->pos] >= '0' && p->json[p->pos] <= '9')
+        {
+            p->pos++;
+        }
+        if (p->pos == digits) {
+            return false;
+        }
+    }
+    return p->pos > start;
+}
+
+/**
+ * Skips a json literal
+ * @param p parser state
+ * @param literal literal to skip
+ * @param literal_len length of the literal
+ * @return true on success, else false
+ */
+static bool parse_literal(struct t_json_parser *p, const char *literal, size_t literal_len) {
+    if (p->len - p->pos < literal_len ||
+        memcmp(p->json + p->pos, literal, literal_len) != 0)
+    {
+        return false;
+    }
+    p->pos += literal_len;
+    return true;
+}
+
+/**
+ * Skips json whitespace
+ * @param p parser state
+ */
+static void skip_whitespace(struct t_json_parser *p) {
+    while (p->pos < p->len &&
+        (p->json[p->pos] == ' ' || p->json[p->pos] == '\t' ||
+         p->json[p->pos] == '\n' || p->json[p->pos] == '\r'))
+    {
+        p->pos++;
+    }
+}
+
+/**
+ * Appends a token, the token array grows on demand
+ * @param index pointer to token index
+ * @return index of the new token
+ */
+static unsigned add_token(struct t_json_index *index) {
+    if (index->count == index->capacity) {
+        index->capacity = index->capacity == 0
+            ? 64
+            : index->capacity * 2;
+        index->tokens = realloc_assert(index->tokens, index->capacity * sizeof(struct t_json_token));
+    }
+    return index->count++;
+}
@@ -0,0 +1,56 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2026 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+/*! \file
+ * \brief Token index for json documents
+ */
+
+#ifndef MYMPD_JSON_INDEX_H
+#define MYMPD_JSON_INDEX_H
+
+#include "src/lib/json/json_query.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * Return values of json_index_find
+ */
+enum json_index_find_rc {
+    JSON_INDEX_NOT_FOUND = -1,
+    JSON_INDEX_UNSUPPORTED = -2
+};
+
+/**
+ * A json value
+ */
+struct t_json_token {
+    unsigned off;         //!< offset of the value
+    unsigned len;         //!< length of the value
+    unsigned key_off;     //!< offset of the raw object key, without quotes
+    unsigned key_len;     //!< length of the raw object key, 0 for array elements and the root
+    unsigned parent;      //!< index of the parent token
+    unsigned next;        //!< index of the token after this value and all its children
+    enum json_vtype type; //!< value type
+};
+
+/**
+ * Token index of a json document, tokens are in document order
+ */
+struct t_json_index {
+    const char *json;             //!< the indexed json document
+    size_t json_len;              //!< length of the json document
+    struct t_json_token *tokens;  //!< the tokens
+    unsigned count;               //!< number of tokens
+    unsigned capacity;            //!< allocated tokens
+};
+
+void json_index_init(struct t_json_index *index);
+void json_index_clear(struct t_json_index *index);
+bool json_index_parse(struct t_json_index *index, const char *json, size_t len);
+int json_index_find(const struct t_json_index *index, const char *path);
+
+#endif
@@ -13,6 +13,7 @@
 
 #include "dist/mongoose/mongoose.h"
 #include "src/lib/convert.h"
+#include "src/lib/json/json_index.h"
 #include "src/lib/json/json_print.h"
 #include "src/lib/log.h"
 #include "src/lib/mem.h"
@@ -24,12 +25,22 @@
 
 /**
  * This unit provides functions for json parsing
- * Json parsing is done by mjson
+ * Json parsing is done by mjson, paths in the bound document
+ * are resolved against a token index.
  */
 
 /**
  * private definitions
  */
+
+/**
+ * Token index of the document bound by json_query_bind.
+ * The request handlers bind the request data and unbind it at request end,
+ * free_request releases it if the request is freed before.
+ */
+static _Thread_local struct t_json_index bound_index;
+
+static struct mg_str json_get_tok(sds s, const char *path);
 static enum json_vtype get_vtype(char p);
 static bool icb_json_get_field(const char *path, sds key, sds value, enum json_vtype vtype, validate_callback vcb, void *userdata, struct t_json_parse_error *error);
 static bool json_get_string_unescape(sds s, const char *path, size_t min, size_t max, sds *result, validate_callback vcb, struct t_json_parse_error *error);
@@ -57,6 +68,42 @@ void json_parse_error_clear(struct t_json_parse_error *parse_error) {
     FREE_SDS(parse_error->path);
 }
 
+/**
+ * Tokenizes the json document once, the json_get_* functions
+ * resolve paths for this document against the token index.
+ * The document must not be modified until json_query_unbind is called.
+ * @param s json document to bind
+ * @return true on success, false on invalid json
+ */
+bool json_query_bind(sds s) {
+    if (bound_index.json != NULL) {
+        MYMPD_LOG_WARN(NULL, "Json document was not unbound");
+    }
+    if (json_index_parse(&bound_index, s, sdslen(s)) == true) {
+        return true;
+    }
+    json_query_unbind();
+    return false;
+}
+
+/**
+ * Releases the token index of the bound json document
+ */
+void json_query_unbind(void) {
+    json_index_clear(&bound_index);
+}
+
+/**
+ * Releases the token index if it belongs to the json document.
+ * Must be called before a json document that could be bound is freed.
+ * @param s json document that is freed
+ */
+void json_query_release(const char *s) {
+    if (bound_index.json == s) {
+        json_index_clear(&bound_index);
+    }
+}
+
 /**
  * Helper function to get myMPD fields out of a jsonrpc request
  * and return a validated json array
@@ -86,7 +133,7 @@ bool json_get_fields_as_string(sds s, sds *fields, struct t_json_parse_error *er
  */
 bool json_get_bool(sds s, const char *path, bool *result, struct t_json_parse_error *error) {
     bool v = false;
-    if (mg_json_get_bool(mg_str_n(s, sdslen(s)), path, &v) == true) {
+    if (mg_json_get_bool(json_get_tok(s, path), "$", &v) == true) {
         *result = v;
         return true;
     }
@@ -118,7 +165,7 @@ bool json_get_int_max(sds s, const char *path, int *result, struct t_json_parse_
  */
 bool json_get_int(sds s, const char *path, int min, int max, int *result, struct t_json_parse_error *error) {
     double value;
-    if (mg_json_get_num(mg_str_n(s, sdslen(s)), path, &value) == true) {
+    if (mg_json_get_num(json_get_tok(s, path), "$", &value) == true) {
         if (value >= JSONRPC_INT_MIN &&
             value <= JSONRPC_INT_MAX)
         {
@@ -148,7 +195,7 @@ bool json_get_int(sds s, const char *path, int min, int max, int *result, struct
  */
 bool json_get_time_max(sds s, const char *path, time_t *result, struct t_json_parse_error *error) {
     double value;
-    if (mg_json_get_num(mg_str_n(s, sdslen(s)), path, &value) == true) {
+    if (mg_json_get_num(json_get_tok(s, path), "$", &value) == true) {
         if (value >= JSONRPC_TIME_MIN &&
             value <= JSONRPC_TIME_MAX)
         {
@@ -188,7 +235,7 @@ bool json_get_int64_max(sds s, const char *path, int64_t *result, struct t_json_
  */
 bool json_get_int64(sds s, const char *path, int64_t min, int64_t max, int64_t *result, struct t_json_parse_error *error) {
     double value;
-    if (mg_json_get_num(mg_str_n(s, sdslen(s)), path, &value) == true) {
+    if (mg_json_get_num(json_get_tok(s, path), "$", &value) == true) {
         if (value >= (double)JSONRPC_INT64_MIN &&
             value <= (double)JSONRPC_INT64_MAX)
         {
@@ -230,7 +277,7 @@ bool json_get_uint_max(sds s, const char *path, unsigned *result, struct t_json_
  */
 bool json_get_uint(sds s, const char *path, unsigned min, unsigned max, unsigned *result, struct t_json_parse_error *error) {
     double value;
-    if (mg_json_get_num(mg_str_n(s, sdslen(s)), path, &value) == true) {
+    if (mg_json_get_num(json_get_tok(s, path), "$", &value) == true) {
         if (value >= JSONRPC_UINT_MIN &&
             value <= JSONRPC_UINT_MAX)
         {
@@ -330,7 +377,7 @@ bool json_iterate_object(sds s, const char *path, iterate_callback icb, void *ic
     if (vcb_key == NULL) {
         vcb_key = vcb_isalnum;
     }
-    struct mg_str obj = mg_json_get_tok(mg_str_n(s, sdslen(s)), path);
+    struct mg_str obj = json_get_tok(s, path);
     if (obj.buf == NULL) {
         set_parse_error(error, path, "", "JSON path \"%s\" not found", path);
         return false;
@@ -576,10 +623,7 @@ bool json_get_fields(sds s, const char *path, struct t_fields *tags, int max_ele
  * @return true on success, else false
  */
 bool json_find_key(sds s, const char *path) {
-    int off = mg_json_get(mg_str_n(s, sdslen(s)), path, NULL);
-    return off < 0
-        ? false
-        : true;
+    return json_get_tok(s, path).buf != NULL;
 }
 
 /**
@@ -589,7 +633,7 @@ bool json_find_key(sds s, const char *path) {
  * @return Key value as sds or NULL on error
  */
 sds json_get_key_as_sds(sds s, const char *path) {
-    struct mg_str val = mg_json_get_tok(mg_str_n(s, sdslen(s)), path);
+    struct mg_str val = json_get_tok(s, path);
     if (val.buf == NULL) {
         return NULL;
     }
@@ -617,6 +661,28 @@ const char *get_mjson_toktype_name(enum json_vtype vtype) {
 
 //private functions
 
+/**
+ * Gets the json token for a path.
+ * Uses the token index if the document is bound, else mjson.
+ * @param s json document
+ * @param path mjson path expression
+ * @return the token, buf is NULL if the path was not found
+ */
+static struct mg_str json_get_tok(sds s, const char *path) {
+    if (bound_index.json == s &&
+        bound_index.json_len == sdslen(s))
+    {
+        int idx = json_index_find(&bound_index, path);
+        if (idx >= 0) {
+            return mg_str_n(s + bound_index.tokens[idx].off, bound_index.tokens[idx].len);
+        }
+        if (idx == JSON_INDEX_NOT_FOUND) {
+            return mg_str_n(NULL, 0);
+        }
+    }
+    return mg_json_get_tok(mg_str_n(s, sdslen(s)), path);
+}
+
 /**
  * Iteration callback to populate a t_fields struct
  * @param path json path
@@ -699,7 +765,7 @@ static bool json_get_string_unescape(sds s, const char *path, size_t min, size_t
         return false;
     }
 
-    char *str = mg_json_get_str(mg_str_n(s, sdslen(s)), path);
+    char *str = mg_json_get_str(json_get_tok(s, path), "$");
     if (str == NULL) {
         *result = NULL;
         set_parse_error(error, path, "", "JSON path \"%s\" not found or value is not string", path);
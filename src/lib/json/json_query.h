@@ -45,6 +45,10 @@ struct t_json_parse_error {
  */
 typedef bool (*iterate_callback) (const char *, sds, sds, enum json_vtype, validate_callback, void *, struct t_json_parse_error *);
 
+bool json_query_bind(sds s);
+void json_query_unbind(void);
+void json_query_release(const char *s);
+
 void json_parse_error_init(struct t_json_parse_error *parse_error);
 void json_parse_error_clear(struct t_json_parse_error *parse_error);
 
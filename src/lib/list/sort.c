@@ -13,8 +13,12 @@
 #include "dist/sds/sds.h"
 #include "src/lib/list/list.h"
 #include "src/lib/mem.h"
+#include "src/lib/sds/sds_extras.h"
 #include "src/lib/utf8_wrapper.h"
 
+#include <stdlib.h>
+#include <string.h>
+
 // Private definitions
 
 /**
@@ -25,9 +29,32 @@ struct t_merge_result {
     struct t_list_node *tail;  //!< Tail pointer
 };
 
+/**
+ * Precomputed sort key for a list node
+ */
+struct t_sort_key {
+    uint64_t prefix;            //!< First 8 bytes of the key in big endian order
+    const char *key;            //!< Lowercased key, points into the key buffer
+    size_t key_len;             //!< Length of key
+    size_t key_offset;          //!< Offset of key in the key buffer
+    size_t pos;                 //!< Original position, makes the sort stable
+    struct t_list_node *node;   //!< List node
+};
+
+/**
+ * Node field to sort by
+ */
+enum sort_key_field {
+    SORT_KEY_FIELD_KEY,
+    SORT_KEY_FIELD_VALUE_P
+};
+
 static bool sort_cb_value_i(struct t_list_node *first, struct t_list_node *second, enum list_sort_direction direction);
-static bool sort_cb_value_p(struct t_list_node *first, struct t_list_node *second, enum list_sort_direction direction);
-static bool sort_cb_key(struct t_list_node *first, struct t_list_node *second, enum list_sort_direction direction);
+static bool list_sort_by_precomputed_key(struct t_list *l, enum list_sort_direction direction, enum sort_key_field field);
+static uint64_t get_key_prefix(const char *key, size_t len);
+static int sort_key_cmp(const struct t_sort_key *first, const struct t_sort_key *second);
+static int sort_key_cmp_asc(const void *a, const void *b);
+static int sort_key_cmp_desc(const void *a, const void *b);
 static void merge(struct t_list_node *first, struct t_list_node *first_end,
         struct t_list_node *second, struct t_list_node *second_end,
         enum list_sort_direction direction, list_sort_callback sort_cb,
@@ -143,23 +170,25 @@ bool list_sort_by_value_i(struct t_list *l, enum list_sort_direction direction)
 }
 
 /**
- * Sorts the list by value_p. It uses the merge sort algorithm.
+ * Sorts the list case insensitive by value_p.
+ * The sort keys are calculated once for each node.
  * @param l pointer to list to sort
  * @param direction sort direction
  * @return Always true
  */
 bool list_sort_by_value_p(struct t_list *l, enum list_sort_direction direction) {
-    return list_sort_by_callback(l, direction, sort_cb_value_p);
+    return list_sort_by_precomputed_key(l, direction, SORT_KEY_FIELD_VALUE_P);
 }
 
 /**
- * Sorts the list by key. It uses the merge sort algorithm.
+ * Sorts the list case insensitive by key.
+ * The sort keys are calculated once for each node.
  * @param l pointer to list to sort
  * @param direction sort direction
  * @return Always true
  */
 bool list_sort_by_key(struct t_list *l, enum list_sort_direction direction) {
-    return list_sort_by_callback(l, direction, sort_cb_key);
+    return list_sort_by_precomputed_key(l, direction, SORT_KEY_FIELD_KEY);
 }
 
 // Internal functions
@@ -181,37 +210,149 @@ static bool sort_cb_value_i(struct t_list_node *first, struct t_list_node *secon
 }
 
 /**
- * Compare callback to sort by value_p
- * @param first first list node
- * @param second second list node
+ * Sorts the list by precomputed lowercased keys (Schwartzian transform).
+ * The keys are lowercased once into a shared buffer, the array of keys
+ * is sorted and the list is relinked in the sorted order.
+ * The order is the same as comparing with utf8_wrap_casecmp and the sort is stable.
+ * @param l pointer to list to sort
  * @param direction sort direction
- * @return true if first is greater than second
+ * @param field node field to sort by
+ * @return Always true
  */
-static bool sort_cb_value_p(struct t_list_node *first, struct t_list_node *second, enum list_sort_direction direction) {
-    int result = utf8_wrap_casecmp(first->value_p, sdslen(first->value_p), second->value_p, sdslen(second->value_p));
-    if ((direction == LIST_SORT_ASC && result > 0) ||
-        (direction == LIST_SORT_DESC && result < 0))
-    {
+static bool list_sort_by_precomputed_key(struct t_list *l, enum list_sort_direction direction, enum sort_key_field field) {
+    if (l->length < 2) {
         return true;
     }
-    return false;
+    struct t_sort_key *keys = malloc_assert(l->length * sizeof(struct t_sort_key));
+    sds buffer = sdsempty();
+    struct t_list_node *current = l->head;
+    size_t i = 0;
+    while (current != NULL) {
+        sds value = field == SORT_KEY_FIELD_KEY
+            ? current->key
+            : current->value_p;
+        size_t value_len = value != NULL
+            ? sdslen(value)
+            : 0;
+        buffer = sdsMakeRoomFor(buffer, UTF8_TOLOWER_MAX_LEN(value_len));
+        keys[i].key_offset = sdslen(buffer);
+        keys[i].key_len = value_len > 0
+            ? utf8_wrap_tolower(value, value_len, buffer + keys[i].key_offset)
+            : 0;
+        sdsIncrLen(buffer, (ssize_t)keys[i].key_len);
+        keys[i].pos = i;
+        keys[i].node = current;
+        current = current->next;
+        i++;
+    }
+    // the buffer is not reallocated anymore
+    for (i = 0; i < l->length; i++) {
+        keys[i].key = buffer + keys[i].key_offset;
+        keys[i].prefix = get_key_prefix(keys[i].key, keys[i].key_len);
+    }
+    qsort(keys, l->length, sizeof(struct t_sort_key), direction == LIST_SORT_ASC
+        ? sort_key_cmp_asc
+        : sort_key_cmp_desc);
+
+    // relink the list
+    l->head = keys[0].node;
+    l->tail = keys[l->length - 1].node;
+    for (i = 0; i < l->length; i++) {
+        keys[i].node->prev = i > 0
+            ? keys[i - 1].node
+            : NULL;
+        keys[i].node->next = i + 1 < l->length
+            ? keys[i + 1].node
+            : NULL;
+    }
+    FREE_SDS(buffer);
+    FREE_PTR(keys);
+    return true;
 }
 
 /**
- * Compare callback to sort by key
- * @param first first list node
- * @param second second list node
- * @param direction sort direction
- * @return true if first is greater than second
+ * Gets the first 8 bytes of the key as big endian integer.
+ * Comparing the prefixes gives the same order as comparing the first 8 bytes.
+ * @param key key
+ * @param len key length
+ * @return key prefix
+ */
+static uint64_t get_key_prefix(const char *key, size_t len) {
+    uint64_t prefix = 0;
+    for (size_t i = 0; i < 8; i++) {
+        prefix <<= 8;
+        if (i < len) {
+            prefix |= (unsigned char)key[i];
+        }
+    }
+    return prefix;
+}
+
+/**
+ * Compares two precomputed sort keys bytewise
+ * @param first first sort key
+ * @param second second sort key
+ * @return less than, equal to, or greater than zero
  */
-static bool sort_cb_key(struct t_list_node *first, struct t_list_node *second, enum list_sort_direction direction) {
-    int result = utf8_wrap_casecmp(first->key, sdslen(first->key), second->key, sdslen(second->key));
-    if ((direction == LIST_SORT_ASC && result > 0) ||
-        (direction == LIST_SORT_DESC && result < 0))
+static int sort_key_cmp(const struct t_sort_key *first, const struct t_sort_key *second) {
+    if (first->prefix != second->prefix) {
+        return first->prefix < second->prefix
+            ? -1
+            : 1;
+    }
+    if (first->key_len > 8 &&
+        second->key_len > 8)
     {
-        return true;
+        size_t len = first->key_len < second->key_len
+            ? first->key_len
+            : second->key_len;
+        int rc = memcmp(first->key + 8, second->key + 8, len - 8);
+        if (rc != 0) {
+            return rc;
+        }
     }
-    return false;
+    if (first->key_len != second->key_len) {
+        return first->key_len < second->key_len
+            ? -1
+            : 1;
+    }
+    return 0;
+}
+
+/**
+ * qsort callback to sort ascending, equal keys keep their original order
+ * @param a pointer to first sort key
+ * @param b pointer to second sort key
+ * @return less than, equal to, or greater than zero
+ */
+static int sort_key_cmp_asc(const void *a, const void *b) {
+    const struct t_sort_key *first = (const struct t_sort_key *)a;
+    const struct t_sort_key *second = (const struct t_sort_key *)b;
+    int rc = sort_key_cmp(first, second);
+    if (rc != 0) {
+        return rc;
+    }
+    return first->pos < second->pos
+        ? -1
+        : (first->pos > second->pos ? 1 : 0);
+}
+
+/**
+ * qsort callback to sort descending, equal keys keep their original order
+ * @param a pointer to first sort key
+ * @param b pointer to second sort key
+ * @return less than, equal to, or greater than zero
+ */
+static int sort_key_cmp_desc(const void *a, const void *b) {
+    const struct t_sort_key *first = (const struct t_sort_key *)a;
+    const struct t_sort_key *second = (const struct t_sort_key *)b;
+    int rc = sort_key_cmp(second, first);
+    if (rc != 0) {
+        return rc;
+    }
+    return first->pos < second->pos
+        ? -1
+        : (first->pos > second->pos ? 1 : 0);
 }
 
 /**
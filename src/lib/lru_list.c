@@ -0,0 +1,77 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2026 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+/*! \file
+ * \brief Intrusive recency list for LRU caches
+ */
+
+#include "compile_time.h"
+#include "src/lib/lru_list.h"
+
+/**
+ * Public functions
+ */
+
+/**
+ * Initializes an empty list
+ * @param list pointer to the list
+ */
+void lru_list_init(struct t_lru_list *list) {
+    list->head = NULL;
+    list->tail = NULL;
+}
+
+/**
+ * Unlinks a node from the list
+ * @param list pointer to the list
+ * @param node the node
+ */
+void lru_list_unlink(struct t_lru_list *list, struct t_lru_node *node) {
+    if (node->prev != NULL) {
+        node->prev->next = node->next;
+    }
+    else {
+        list->head = node->next;
+    }
+    if (node->next != NULL) {
+        node->next->prev = node->prev;
+    }
+    else {
+        list->tail = node->prev;
+    }
+    node->prev = NULL;
+    node->next = NULL;
+}
+
+/**
+ * Links a node as most recently used
+ * @param list pointer to the list
+ * @param node the node, it must not be linked
+ */
+void lru_list_link_head(struct t_lru_list *list, struct t_lru_node *node) {
+    node->prev = NULL;
+    node->next = list->head;
+    if (list->head != NULL) {
+        list->head->prev = node;
+    }
+    list->head = node;
+    if (list->tail == NULL) {
+        list->tail = node;
+    }
+}
+
+/**
+ * Marks a linked node as most recently used
+ * @param list pointer to the list
+ * @param node the node
+ */
+void lru_list_touch(struct t_lru_list *list, struct t_lru_node *node) {
+    if (list->head == node) {
+        return;
+    }
+    lru_list_unlink(list, node);
+    lru_list_link_head(list, node);
+}
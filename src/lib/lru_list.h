@@ -0,0 +1,50 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2026 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+/*! \file
+ * \brief Intrusive recency list for LRU caches
+ */
+
+#ifndef MYMPD_LIB_LRU_LIST_H
+#define MYMPD_LIB_LRU_LIST_H
+
+#include <stddef.h>
+
+/**
+ * Gets the entry that embeds a list node
+ * @param node pointer to the embedded node
+ * @param type type of the entry
+ * @param member name of the node member in the entry
+ */
+#define LRU_LIST_ENTRY(node, type, member) ((type *)(void *)((char *)(node) - offsetof(type, member)))
+
+/**
+ * Node of the recency list, embedded in the cache entries
+ */
+struct t_lru_node {
+    struct t_lru_node *prev;  //!< more recently used node
+    struct t_lru_node *next;  //!< less recently used node
+};
+
+/**
+ * Recency list, the head is the most recently used node
+ */
+struct t_lru_list {
+    struct t_lru_node *head;  //!< most recently used node
+    struct t_lru_node *tail;  //!< least recently used node
+};
+
+/**
+ * Static initializer for an empty list
+ */
+#define LRU_LIST_INIT { .head = NULL, .tail = NULL }
+
+void lru_list_init(struct t_lru_list *list);
+void lru_list_unlink(struct t_lru_list *list, struct t_lru_node *node);
+void lru_list_link_head(struct t_lru_list *list, struct t_lru_node *node);
+void lru_list_touch(struct t_lru_list *list, struct t_lru_node *node);
+
+#endif
@@ -0,0 +1,347 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2026 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+/*! \file
+ * \brief Always-on request metrics for the api methods
+ *
+ * Each recording thread owns a shard of counters, written with relaxed atomics.
+ * Readers merge the shards without locking.
+ */
+
+#include "compile_time.h"
+#include "src/lib/metrics.h"
+
+#include "src/lib/json/json_print.h"
+#include "src/lib/mem.h"
+#include "src/lib/sds/sds_extras.h"
+
+#include <stdatomic.h>
+#include <string.h>
+
+/**
+ * Private definitions
+ */
+
+/**
+ * Histogram with atomic counters
+ */
+struct t_metrics_histogram {
+    _Atomic uint64_t buckets[HISTOGRAM_BUCKETS];  //!< number of values in each bucket
+    _Atomic uint64_t count;                       //!< number of values
+    _Atomic uint64_t sum_us;                      //!< sum of all values in microseconds
+    _Atomic uint64_t max_us;                      //!< maximum value in microseconds
+};
+
+/**
+ * Counters of an api method
+ */
+struct t_metrics_counters {
+    struct t_metrics_histogram latency;  //!< execution time of the request
+    struct t_metrics_histogram wait;     //!< time the request waited in the queues
+    _Atomic uint64_t mpd_roundtrips;     //!< number of MPD round trips
+    _Atomic uint64_t response_bytes;     //!< number of response bytes
+};
+
+/**
+ * Counters of all api methods for one thread
+ */
+struct t_metrics_shard {
+    struct t_metrics_counters methods[TOTAL_API_COUNT];  //!< counters by method
+};
+
+/**
+ * Metrics of the current thread
+ */
+struct t_metrics_thread {
+    struct t_metrics_shard *shard;  //!< the shard of this thread
+    uint64_t mpd_roundtrips;        //!< MPD round trips of this thread
+    uint64_t response_bytes;        //!< response bytes pushed by this thread
+};
+
+static _Atomic(struct t_metrics_shard *) shards[METRICS_SHARDS_MAX];  //!< shards owned by a thread
+static _Atomic unsigned shards_used;                                  //!< number of claimed shards
+static struct t_metrics_shard shared_shard;                           //!< shard for additional threads
+static _Thread_local struct t_metrics_thread thread_metrics;          //!< metrics of the current thread
+
+static struct t_metrics_shard *get_shard(void);
+static void histogram_record(struct t_metrics_histogram *histogram, uint64_t value_us);
+static void histogram_collect(struct t_histogram *dst, struct t_metrics_histogram *src);
+static void shard_collect(struct t_metrics_method *method, struct t_metrics_shard *shard, enum mympd_cmd_ids cmd_id);
+static sds print_prometheus_histogram(sds buffer, const char *name, const char *help,
+        struct t_metrics_method *methods, size_t offset);
+static sds print_prometheus_counter(sds buffer, const char *name, const char *help,
+        struct t_metrics_method *methods, size_t offset);
+
+/**
+ * Public functions
+ */
+
+/**
+ * Starts the measurement of a request
+ * @param request_metrics measurement to start
+ * @param queued time the request was queued from CLOCK_MONOTONIC
+ */
+void metrics_request_begin(struct t_metrics_request *request_metrics, const struct timespec *queued) {
+    (void)clock_gettime(CLOCK_MONOTONIC, &request_metrics->started);
+    request_metrics->wait_us = histogram_elapsed_us(queued, &request_metrics->started);
+    request_metrics->mpd_roundtrips = thread_metrics.mpd_roundtrips;
+    request_metrics->response_bytes = thread_metrics.response_bytes;
+}
+
+/**
+ * Ends the measurement of a request and records it in the shard of the thread
+ * @param request_metrics measurement started with metrics_request_begin
+ * @param cmd_id api method of the request
+ */
+void metrics_request_end(const struct t_metrics_request *request_metrics, enum mympd_cmd_ids cmd_id) {
+    if ((unsigned)cmd_id >= TOTAL_API_COUNT) {
+        return;
+    }
+    struct timespec finished;
+    (void)clock_gettime(CLOCK_MONOTONIC, &finished);
+    struct t_metrics_counters *counters = &get_shard()->methods[cmd_id];
+    histogram_record(&counters->latency, histogram_elapsed_us(&request_metrics->started, &finished));
+    histogram_record(&counters->wait, request_metrics->wait_us);
+    atomic_fetch_add_explicit(&counters->mpd_roundtrips,
+        thread_metrics.mpd_roundtrips - request_metrics->mpd_roundtrips, memory_order_relaxed);
+    atomic_fetch_add_explicit(&counters->response_bytes,
+        thread_metrics.response_bytes - request_metrics->response_bytes, memory_order_relaxed);
+}
+
+/**
+ * Counts a MPD round trip for the current thread
+ */
+void metrics_count_mpd_roundtrip(void) {
+    thread_metrics.mpd_roundtrips++;
+}
+
+/**
+ * Counts the bytes of a response pushed by the current thread
+ * @param bytes response length
+ */
+void metrics_count_response_bytes(size_t bytes) {
+    thread_metrics.response_bytes += bytes;
+}
+
+/**
+ * Merges the metrics of all threads for an api method
+ * @param cmd_id api method
+ * @param method pointer to struct to populate
+ */
+void metrics_get(enum mympd_cmd_ids cmd_id, struct t_metrics_method *method) {
+    histogram_init(&method->latency);
+    histogram_init(&method->wait);
+    method->mpd_roundtrips = 0;
+    method->response_bytes = 0;
+    if ((unsigned)cmd_id >= TOTAL_API_COUNT) {
+        return;
+    }
+    for (unsigned i = 0; i < METRICS_SHARDS_MAX; i++) {
+        struct t_metrics_shard *shard = atomic_load_explicit(&shards[i], memory_order_acquire);
+        if (shard != NULL) {
+            shard_collect(method, shard, cmd_id);
+        }
+    }
+    shard_collect(method, &shared_shard, cmd_id);
+}
+
+/**
+ * Prints the metrics of all called api methods as json array
+ * @param buffer already allocated sds string to append
+ * @return pointer to buffer
+ */
+sds metrics_print_json(sds buffer) {
+    buffer = sdscatlen(buffer, "[", 1);
+    bool first = true;
+    struct t_metrics_method method;
+    for (unsigned i = 0; i < TOTAL_API_COUNT; i++) {
+        metrics_get((enum mympd_cmd_ids)i, &method);
+        if (method.latency.count == 0) {
+            continue;
+        }
+        if (first == false) {
+            buffer = sdscatlen(buffer, ",", 1);
+        }
+        first = false;
+        buffer = sdscatlen(buffer, "{", 1);
+        buffer = tojson_char(buffer, "method", get_cmd_id_method_name((enum mympd_cmd_ids)i), true);
+        buffer = tojson_uint64(buffer, "mpdRoundtrips", method.mpd_roundtrips, true);
+        buffer = tojson_uint64(buffer, "responseBytes", method.response_bytes, true);
+        buffer = histogram_tojson(buffer, "latency", &method.latency, true);
+        buffer = histogram_tojson(buffer, "wait", &method.wait, false);
+        buffer = sdscatlen(buffer, "}", 1);
+    }
+    buffer = sdscatlen(buffer, "]", 1);
+    return buffer;
+}
+
+/**
+ * Prints the metrics of all called api methods in the Prometheus text format
+ * @param buffer already allocated sds string to append
+ * @return pointer to buffer
+ */
+sds metrics_print_prometheus(sds buffer) {
+    struct t_metrics_method *methods = malloc_assert(TOTAL_API_COUNT * sizeof(struct t_metrics_method));
+    for (unsigned i = 0; i < TOTAL_API_COUNT; i++) {
+        metrics_get((enum mympd_cmd_ids)i, &methods[i]);
+    }
+    buffer = print_prometheus_histogram(buffer, "mympd_request_duration_seconds",
+        "Execution time of the api methods", methods, offsetof(struct t_metrics_method, latency));
+    buffer = print_prometheus_histogram(buffer, "mympd_request_wait_seconds",
+        "Time the requests waited in the queues", methods, offsetof(struct t_metrics_method, wait));
+    buffer = print_prometheus_counter(buffer, "mympd_request_mpd_roundtrips_total",
+        "MPD round trips of the api methods", methods, offsetof(struct t_metrics_method, mpd_roundtrips));
+    buffer = print_prometheus_counter(buffer, "mympd_response_bytes_total",
+        "Response bytes of the api methods", methods, offsetof(struct t_metrics_method, response_bytes));
+    FREE_PTR(methods);
+    return buffer;
+}
+
+/**
+ * Frees the shards, all recording threads must be stopped
+ */
+void metrics_free(void) {
+    for (unsigned i = 0; i < METRICS_SHARDS_MAX; i++) {
+        struct t_metrics_shard *shard = atomic_exchange_explicit(&shards[i], NULL, memory_order_acq_rel);
+        FREE_PTR(shard);
+    }
+    atomic_store_explicit(&shards_used, 0, memory_order_relaxed);
+    memset(&shared_shard, 0, sizeof(shared_shard));
+    thread_metrics.shard = NULL;
+}
+
+/**
+ * Private functions
+ */
+
+/**
+ * Returns the shard of the current thread and claims a new shard on first use
+ * @return pointer to the shard
+ */
+static struct t_metrics_shard *get_shard(void) {
+    if (thread_metrics.shard != NULL) {
+        return thread_metrics.shard;
+    }
+    unsigned idx = atomic_fetch_add_explicit(&shards_used, 1, memory_order_relaxed);
+    if (idx < METRICS_SHARDS_MAX) {
+        struct t_metrics_shard *shard = malloc_assert(sizeof(struct t_metrics_shard));
+        memset(shard, 0, sizeof(struct t_metrics_shard));
+        atomic_store_explicit(&shards[idx], shard, memory_order_release);
+        thread_metrics.shard = shard;
+    }
+    else {
+        thread_metrics.shard = &shared_shard;
+    }
+    return thread_metrics.shard;
+}
+
+/**
+ * Adds a value to an atomic histogram
+ * @param histogram pointer to histogram
+ * @param value_us value in microseconds
+ */
+static void histogram_record(struct t_metrics_histogram *histogram, uint64_t value_us) {
+    atomic_fetch_add_explicit(&histogram->buckets[histogram_bucket(value_us)], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&histogram->count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&histogram->sum_us, value_us, memory_order_relaxed);
+    uint64_t max_us = atomic_load_explicit(&histogram->max_us, memory_order_relaxed);
+    while (value_us > max_us &&
+        atomic_compare_exchange_weak_explicit(&histogram->max_us, &max_us, value_us,
+            memory_order_relaxed, memory_order_relaxed) == false)
+    {
+        // max_us was updated by the failed exchange
+    }
+}
+
+/**
+ * Adds the values of an atomic histogram to a histogram
+ * @param dst histogram to merge into
+ * @param src atomic histogram to merge
+ */
+static void histogram_collect(struct t_histogram *dst, struct t_metrics_histogram *src) {
+    for (unsigned i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        dst->buckets[i] += atomic_load_explicit(&src->buckets[i], memory_order_relaxed);
+    }
+    dst->count += atomic_load_explicit(&src->count, memory_order_relaxed);
+    dst->sum_us += atomic_load_explicit(&src->sum_us, memory_order_relaxed);
+    uint64_t max_us = atomic_load_explicit(&src->max_us, memory_order_relaxed);
+    if (max_us > dst->max_us) {
+        dst->max_us = max_us;
+    }
+}
+
+/**
+ * Adds the counters of a shard to the merged metrics
+ * @param method merged metrics
+ * @param shard shard to merge
+ * @param cmd_id api method
+ */
+static void shard_collect(struct t_metrics_method *method, struct t_metrics_shard *shard, enum mympd_cmd_ids cmd_id) {
+    struct t_metrics_counters *counters = &shard->methods[cmd_id];
+    histogram_collect(&method->latency, &counters->latency);
+    histogram_collect(&method->wait, &counters->wait);
+    method->mpd_roundtrips += atomic_load_explicit(&counters->mpd_roundtrips, memory_order_relaxed);
+    method->response_bytes += atomic_load_explicit(&counters->response_bytes, memory_order_relaxed);
+}
+
+/**
+ * Prints a histogram metric for all called api methods
+ * @param buffer already allocated sds string to append
+ * @param name metric name
+ * @param help metric description
+ * @param methods merged metrics of all api methods
+ * @param offset offset of the histogram in struct t_metrics_method
+ * @return pointer to buffer
+ */
+static sds print_prometheus_histogram(sds buffer, const char *name, const char *help,
+        struct t_metrics_method *methods, size_t offset)
+{
+    buffer = sdscatfmt(buffer, "# HELP %s %s\n# TYPE %s histogram\n", name, help, name);
+    for (unsigned i = 0; i < TOTAL_API_COUNT; i++) {
+        const struct t_histogram *histogram = (const struct t_histogram *)((char *)&methods[i] + offset);
+        if (methods[i].latency.count == 0) {
+            continue;
+        }
+        const char *method = get_cmd_id_method_name((enum mympd_cmd_ids)i);
+        uint64_t cumulative = 0;
+        for (unsigned j = 0; j < HISTOGRAM_BUCKETS - 1; j++) {
+            cumulative += histogram->buckets[j];
+            buffer = sdscatprintf(buffer, "%s_bucket{method=\"%s\",le=\"%.6f\"} %llu\n", name, method,
+                (double)histogram_bucket_bound(j) / 1000000, (unsigned long long)cumulative);
+        }
+        buffer = sdscatprintf(buffer, "%s_bucket{method=\"%s\",le=\"+Inf\"} %llu\n", name, method,
+            (unsigned long long)histogram->count);
+        buffer = sdscatprintf(buffer, "%s_sum{method=\"%s\"} %.6f\n", name, method,
+            (double)histogram->sum_us / 1000000);
+        buffer = sdscatprintf(buffer, "%s_count{method=\"%s\"} %llu\n", name, method,
+            (unsigned long long)histogram->count);
+    }
+    return buffer;
+}
+
+/**
+ * Prints a counter metric for all called api methods
+ * @param buffer already allocated sds string to append
+ * @param name metric name
+ * @param help metric description
+ * @param methods merged metrics of all api methods
+ * @param offset offset of the counter in struct t_metrics_method
+ * @return pointer to buffer
+ */
+static sds print_prometheus_counter(sds buffer, const char *name, const char *help,
+        struct t_metrics_method *methods, size_t offset)
+{
+    buffer = sdscatfmt(buffer, "# HELP %s %s\n# TYPE %s counter\n", name, help, name);
+    for (unsigned i = 0; i < TOTAL_API_COUNT; i++) {
+        if (methods[i].latency.count == 0) {
+            continue;
+        }
+        const uint64_t *counter = (const uint64_t *)((char *)&methods[i] + offset);
+        buffer = sdscatprintf(buffer, "%s{method=\"%s\"} %llu\n", name,
+            get_cmd_id_method_name((enum mympd_cmd_ids)i), (unsigned long long)*counter);
+    }
+    return buffer;
+}
@@ -0,0 +1,57 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2026 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+/*! \file
+ * \brief Always-on request metrics for the api methods
+ */
+
+#ifndef MYMPD_LIB_METRICS_H
+#define MYMPD_LIB_METRICS_H
+
+#include "dist/sds/sds.h"
+#include "src/lib/api.h"
+#include "src/lib/histogram.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+/**
+ * Maximum number of threads with their own metrics shard,
+ * additional threads share one shard
+ */
+#define METRICS_SHARDS_MAX 16
+
+/**
+ * Measurement of a single request
+ */
+struct t_metrics_request {
+    struct timespec started;   //!< start of the request handling
+    uint64_t wait_us;          //!< time the request waited in the queues
+    uint64_t mpd_roundtrips;   //!< MPD round trips of the thread at start
+    uint64_t response_bytes;   //!< response bytes of the thread at start
+};
+
+/**
+ * Merged metrics of an api method
+ */
+struct t_metrics_method {
+    struct t_histogram latency;  //!< execution time of the request
+    struct t_histogram wait;     //!< time the request waited in the queues
+    uint64_t mpd_roundtrips;     //!< number of MPD round trips
+    uint64_t response_bytes;     //!< number of response bytes
+};
+
+void metrics_request_begin(struct t_metrics_request *request_metrics, const struct timespec *queued);
+void metrics_request_end(const struct t_metrics_request *request_metrics, enum mympd_cmd_ids cmd_id);
+void metrics_count_mpd_roundtrip(void);
+void metrics_count_response_bytes(size_t bytes);
+void metrics_get(enum mympd_cmd_ids cmd_id, struct t_metrics_method *method);
+sds metrics_print_json(sds buffer);
+sds metrics_print_prometheus(sds buffer);
+void metrics_free(void);
+
+#endif
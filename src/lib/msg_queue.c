@@ -17,6 +17,7 @@
 #include "src/lib/mem.h"
 
 #include <errno.h>
+#include <stdatomic.h>
 
 /*
  Message queue implementation to transfer messages between threads asynchronously
@@ -31,7 +32,22 @@ struct t_mympd_queue *mympd_api_queue;  //!< Message queue read by mympd_api thr
 #endif
 
 //private definitions
-static bool check_for_queue_id(struct t_mympd_queue *queue, unsigned id);
+static struct t_mympd_queue *queue_new(const char *name, enum mympd_queue_types type, bool event);
+static void *shift_locked(struct t_mympd_queue *queue, unsigned id);
+static void *shift_ring(struct t_mympd_queue *queue, unsigned id);
+static bool wait_for_entry(struct t_mympd_queue *queue, int timeout_ms, unsigned id);
+static bool has_entry(struct t_mympd_queue *queue, unsigned id);
+static void send_wakeup(struct t_mympd_queue *queue);
+static void depth_inc(struct t_mympd_queue *queue);
+static void depth_dec(struct t_mympd_queue *queue);
+static bool ring_push(struct t_mympd_ring *ring, void *data, unsigned id);
+static bool ring_pop(struct t_mympd_ring *ring, struct t_mympd_msg *msg);
+static bool ring_peek(struct t_mympd_ring *ring);
+static void ring_move_to_list(struct t_mympd_queue *queue);
+static struct t_mympd_msg *msg_list_node_new(void *data, unsigned id, time_t timestamp);
+static void msg_list_append(struct t_mympd_queue *queue, struct t_mympd_msg *node);
+static void msg_list_remove(struct t_mympd_queue *queue, struct t_mympd_msg *node);
+static struct t_mympd_msg *msg_list_find(struct t_mympd_queue *queue, unsigned id);
 static void free_queue_node(struct t_mympd_msg *n, enum mympd_queue_types type);
 static int unlock_mutex(pthread_mutex_t *mutex);
 static void set_wait_time(int timeout_ms, struct timespec *max_wait);
@@ -46,20 +62,41 @@ static void set_wait_time(int timeout_ms, struct timespec *max_wait);
  * @return pointer to allocated and initialized queue struct
  */
 struct t_mympd_queue *mympd_queue_create(const char *name, enum mympd_queue_types type,
-        bool event) {
-    struct t_mympd_queue *queue = malloc_assert(sizeof(struct t_mympd_queue));
-    queue->head = NULL;
-    queue->tail = NULL;
-    queue->length = 0;
-    queue->name = name;
-    queue->type = type;
-    queue->mutex = (pthread_mutex_t)PTHREAD_MUTEX_INITIALIZER;
-    queue->wakeup = (pthread_cond_t)PTHREAD_COND_INITIALIZER;
-    queue->event_fd = event == true
-        ? event_eventfd_create()
-        : -1;
-    queue->mg_mgr = NULL;
-    queue->mg_conn_id = 0;
+        bool event)
+{
+    return queue_new(name, type, event);
+}
+
+/**
+ * Creates a message queue backed by a bounded lock-free ring buffer.
+ * Any thread can push, but only one thread is allowed to shift.
+ * Messages that do not fit in the ring buffer are appended to the
+ * mutex protected list. All following messages are appended to the
+ * list until it is drained, this keeps the FIFO order.
+ * @param name description of the queue
+ * @param type type of the queue QUEUE_TYPE_REQUEST or QUEUE_TYPE_RESPONSE
+ * @param event create an eventfd?
+ * @param slots number of slots, rounded up to a power of two
+ * @return pointer to allocated and initialized queue struct
+ */
+struct t_mympd_queue *mympd_queue_create_ring(const char *name, enum mympd_queue_types type,
+        bool event, size_t slots)
+{
+    struct t_mympd_queue *queue = queue_new(name, type, event);
+    size_t size = 2;
+    while (size < slots) {
+        size <<= 1;
+    }
+    struct t_mympd_ring *ring = malloc_assert(sizeof(struct t_mympd_ring));
+    ring->slots = malloc_assert(size * sizeof(struct t_mympd_ring_slot));
+    for (size_t i = 0; i < size; i++) {
+        atomic_init(&ring->slots[i].sequence, i);
+        ring->slots[i].data = NULL;
+    }
+    ring->mask = size - 1;
+    atomic_init(&ring->enqueue_pos, 0);
+    ring->dequeue_pos = 0;
+    queue->ring = ring;
     return queue;
 }
 
@@ -71,6 +108,11 @@ struct t_mympd_queue *mympd_queue_create(const char *name, enum mympd_queue_type
 void *mympd_queue_free(struct t_mympd_queue *queue) {
     mympd_queue_expire_age(queue, 0);
     event_fd_close(queue->event_fd);
+    raxFree(queue->ids);
+    if (queue->ring != NULL) {
+        FREE_PTR(queue->ring->slots);
+        FREE_PTR(queue->ring);
+    }
     FREE_PTR(queue);
     return NULL;
 }
@@ -83,26 +125,35 @@ void *mympd_queue_free(struct t_mympd_queue *queue) {
  * @return true on success else false
  */
 bool mympd_queue_push(struct t_mympd_queue *queue, void *data, unsigned id) {
+    // the list entries are newer than the ring buffer entries
+    if (queue->ring != NULL &&
+        atomic_load(&queue->length) == 0 &&
+        ring_push(queue->ring, data, id) == true)
+    {
+        depth_inc(queue);
+        // pairs with the waiters increment in wait_for_entry
+        atomic_thread_fence(memory_order_seq_cst);
+        if (atomic_load(&queue->waiters) > 0) {
+            // wakeup a consumer blocked in mympd_queue_shift
+            if (pthread_mutex_lock(&queue->mutex) == 0) {
+                unlock_mutex(&queue->mutex);
+            }
+            pthread_cond_signal(&queue->wakeup);
+        }
+        send_wakeup(queue);
+        return true;
+    }
+    if (queue->ring != NULL) {
+        atomic_fetch_add(&queue->overflows, 1);
+        MYMPD_LOG_DEBUG(NULL, "Queue \"%s\": appending to the overflow list", queue->name);
+    }
     int rc = pthread_mutex_lock(&queue->mutex);
     if (rc != 0) {
         MYMPD_LOG_ERROR(NULL, "Error in pthread_mutex_lock: %d", rc);
         return false;
     }
-    struct t_mympd_msg* new_node = malloc_assert(sizeof(struct t_mympd_msg));
-    new_node->data = data;
-    new_node->id = id;
-    new_node->timestamp = time(NULL);
-    new_node->next = NULL;
-    queue->length++;
-    if (queue->head == NULL &&
-        queue->tail == NULL)
-    {
-        queue->head = queue->tail = new_node;
-    }
-    else {
-        queue->tail->next = new_node;
-        queue->tail = new_node;
-    }
+    msg_list_append(queue, msg_list_node_new(data, id, time(NULL)));
+    depth_inc(queue);
     if (unlock_mutex(&queue->mutex) != 0) {
         return false;
     }
@@ -111,12 +162,7 @@ bool mympd_queue_push(struct t_mympd_queue *queue, void *data, unsigned id) {
         MYMPD_LOG_ERROR(NULL, "Error in pthread_cond_signal: %d", rc);
         return 0;
     }
-    if (queue->event_fd > -1) {
-        event_eventfd_write(queue->event_fd);
-    }
-    else if (queue->mg_mgr != NULL) {
-        mympd_mg_wakeup_send("Q");
-    }
+    send_wakeup(queue);
     return true;
 }
 
@@ -130,6 +176,18 @@ bool mympd_queue_push(struct t_mympd_queue *queue, void *data, unsigned id) {
  * @return t_work_request or t_work_response
  */
 void *mympd_queue_shift(struct t_mympd_queue *queue, int timeout_ms, unsigned id) {
+    // messages pushed from now on must wakeup the consumer again
+    atomic_store(&queue->wakeup_pending, false);
+    if (queue->ring != NULL) {
+        void *data = shift_ring(queue, id);
+        if (data == NULL &&
+            timeout_ms > -1 &&
+            wait_for_entry(queue, timeout_ms, id) == true)
+        {
+            data = shift_ring(queue, id);
+        }
+        return data;
+    }
     //lock the queue
     int rc = pthread_mutex_lock(&queue->mutex);
     if (rc != 0) {
@@ -137,7 +195,7 @@ void *mympd_queue_shift(struct t_mympd_queue *queue, int timeout_ms, unsigned id
         assert(NULL);
     }
     if (timeout_ms > -1) {
-        if (check_for_queue_id(queue, id) == false) {
+        if (has_entry(queue, id) == false) {
             //check and wait for entries
             if (timeout_ms > 0) {
                 struct timespec max_wait = {0, 0};
@@ -160,43 +218,69 @@ void *mympd_queue_shift(struct t_mympd_queue *queue, int timeout_ms, unsigned id
             }
         }
     }
-    if (queue->head != NULL) {
-        //queue has entry
-        struct t_mympd_msg *current = NULL;
-        struct t_mympd_msg *previous = NULL;
+    void *data = shift_locked(queue, id);
+    unlock_mutex(&queue->mutex);
+    return data;
+}
 
-        for (current = queue->head; current != NULL; previous = current, current = current->next) {
-            if (id == 0 ||
-                id == current->id)
-            {
-                void *data = current->data;
-                if (previous == NULL) {
-                    //Fix beginning pointer
-                    queue->head = current->next;
-                }
-                else {
-                    //Fix previous nodes next to skip over the removed node.
-                    previous->next = current->next;
-                }
-                //Fix tail
-                if (queue->tail == current) {
-                    queue->tail = previous;
-                }
-                FREE_PTR(current);
-                queue->length--;
-                MYMPD_LOG_DEBUG(NULL, "Queue \"%s\": %u entries", queue->name, queue->length);
-                unlock_mutex(&queue->mutex);
-                return data;
-            }
-            MYMPD_LOG_DEBUG(NULL, "Skipping queue entry with id %u", current->id);
+/**
+ * Gets up to max entries from the queue without waiting.
+ * The mutex is acquired only once for the whole batch.
+ * @param queue pointer to the queue
+ * @param data array to populate with t_work_request or t_work_response entries
+ * @param max size of the data array
+ * @return number of entries
+ */
+size_t mympd_queue_shift_batch(struct t_mympd_queue *queue, void **data, size_t max) {
+    atomic_store(&queue->wakeup_pending, false);
+    size_t count = 0;
+    if (queue->ring != NULL) {
+        while (count < max &&
+            (data[count] = shift_ring(queue, 0)) != NULL)
+        {
+            count++;
         }
+        return count;
+    }
+    int rc = pthread_mutex_lock(&queue->mutex);
+    if (rc != 0) {
+        MYMPD_LOG_ERROR(NULL, "Error in pthread_mutex_lock: %d", rc);
+        return 0;
+    }
+    while (count < max &&
+        (data[count] = shift_locked(queue, 0)) != NULL)
+    {
+        count++;
     }
     unlock_mutex(&queue->mutex);
-    return NULL;
+    return count;
 }
 
 /**
- * Expire entries from the queue by age
+ * Returns the number of entries in the queue
+ * @param queue pointer to the queue
+ * @return number of entries
+ */
+unsigned mympd_queue_length(struct t_mympd_queue *queue) {
+    return atomic_load(&queue->depth);
+}
+
+/**
+ * Gets the queue metrics
+ * @param queue pointer to the queue
+ * @param stats struct to populate
+ */
+void mympd_queue_get_stats(struct t_mympd_queue *queue, struct t_mympd_queue_stats *stats) {
+    stats->length = atomic_load(&queue->depth);
+    stats->high_water = atomic_load(&queue->high_water);
+    stats->pushed = atomic_load(&queue->pushed);
+    stats->overflows = atomic_load(&queue->overflows);
+    stats->wakeups = atomic_load(&queue->wakeups);
+}
+
+/**
+ * Expire entries from the queue by age.
+ * For ring buffer queues this must be called by the consumer thread.
  * @param queue pointer to the queue
  * @param max_age_s max age of nodes in seconds
  * @return number of expired nodes
@@ -207,47 +291,24 @@ int mympd_queue_expire_age(struct t_mympd_queue *queue, time_t max_age_s) {
         MYMPD_LOG_ERROR(NULL, "Error in pthread_mutex_lock: %d", rc);
         return 0;
     }
+    if (queue->ring != NULL) {
+        ring_move_to_list(queue);
+    }
     int expired_count = 0;
-    if (queue->head != NULL) {
-        //queue has entry
-        struct t_mympd_msg *current = NULL;
-        struct t_mympd_msg *previous = NULL;
-
-        time_t expire_time = time(NULL) - max_age_s;
-
-        for (current = queue->head; current != NULL;) {
-            if (max_age_s == 0 ||
-                current->timestamp < expire_time)
-            {
-                struct t_mympd_msg *to_remove = current;
-                if (queue->tail == current) {
-                    //Fix tail
-                    queue->tail = previous;
-                }
-                if (previous == NULL) {
-                    //Fix beginning pointer
-                    queue->head = current->next;
-                    //Set current to queue head
-                    current = queue->head;
-                }
-                else {
-                    //Fix previous nodes next to skip over the removed node.
-                    previous->next = current->next;
-                    //Set current to previous
-                    current = previous;
-                }
-                free_queue_node(to_remove, queue->type);
-                queue->length--;
-                expired_count++;
-            }
-            else {
-                //skip this node
-                previous = current;
-                current = current->next;
-            }
+    time_t expire_time = time(NULL) - max_age_s;
+    struct t_mympd_msg *current = queue->head;
+    while (current != NULL) {
+        struct t_mympd_msg *next = current->next;
+        if (max_age_s == 0 ||
+            current->timestamp < expire_time)
+        {
+            msg_list_remove(queue, current);
+            depth_dec(queue);
+            free_queue_node(current, queue->type);
+            expired_count++;
         }
+        current = next;
     }
-
     unlock_mutex(&queue->mutex);
     return expired_count;
 }
@@ -265,33 +326,406 @@ bool mympd_mg_wakeup_send(const void *data) {
     return rc;
 }
 
-//privat functions
+//private functions
 
 /**
- * Checks if queue has a entry with requested id
- * @param queue Pointer to the queue
+ * Allocates and initializes the queue struct
+ * @param name description of the queue
+ * @param type type of the queue QUEUE_TYPE_REQUEST or QUEUE_TYPE_RESPONSE
+ * @param event create an eventfd?
+ * @return pointer to allocated and initialized queue struct
+ */
+static struct t_mympd_queue *queue_new(const char *name, enum mympd_queue_types type, bool event) {
+    struct t_mympd_queue *queue = malloc_assert(sizeof(struct t_mympd_queue));
+    queue->head = NULL;
+    queue->tail = NULL;
+    queue->length = 0;
+    queue->ids = raxNew();
+    queue->ring = NULL;
+    queue->name = name;
+    queue->type = type;
+    queue->mutex = (pthread_mutex_t)PTHREAD_MUTEX_INITIALIZER;
+    queue->wakeup = (pthread_cond_t)PTHREAD_COND_INITIALIZER;
+    queue->event_fd = event == true
+        ? event_eventfd_create()
+        : -1;
+    queue->mg_mgr = NULL;
+    queue->mg_conn_id = 0;
+    atomic_init(&queue->wakeup_pending, false);
+    atomic_init(&queue->waiters, 0);
+    atomic_init(&queue->depth, 0);
+    atomic_init(&queue->high_water, 0);
+    atomic_init(&queue->pushed, 0);
+    atomic_init(&queue->overflows, 0);
+    atomic_init(&queue->wakeups, 0);
+    return queue;
+}
+
+/**
+ * Removes the first entry or the first entry with specific id from the locked list.
+ * Caller must hold the mutex.
+ * @param queue pointer to the queue
  * @param id 0 for first entry or specific id
- * @return true if there is an entry, else false
+ * @return t_work_request or t_work_response or NULL
  */
-static bool check_for_queue_id(struct t_mympd_queue *queue, unsigned id) {
-    if (queue->length == 0) {
-        MYMPD_LOG_DEBUG(NULL, "Queue %s is empty", queue->name);
-        return false;
+static void *shift_locked(struct t_mympd_queue *queue, unsigned id) {
+    struct t_mympd_msg *node = msg_list_find(queue, id);
+    if (node == NULL) {
+        return NULL;
     }
+    void *data = node->data;
+    msg_list_remove(queue, node);
+    depth_dec(queue);
+    FREE_PTR(node);
+    MYMPD_LOG_DEBUG(NULL, "Queue \"%s\": %u entries", queue->name, atomic_load(&queue->depth));
+    return data;
+}
+
+/**
+ * Removes the first entry or the first entry with specific id from a ring buffer queue.
+ * Entries from the ring buffer are served first, followed by the locked list,
+ * that holds only newer entries.
+ * Looking up an id moves the ring buffer content to the indexed list.
+ * @param queue pointer to the queue
+ * @param id 0 for first entry or specific id
+ * @return t_work_request or t_work_response or NULL
+ */
+static void *shift_ring(struct t_mympd_queue *queue, unsigned id) {
     if (id == 0) {
-        return true;
+        struct t_mympd_msg msg;
+        if (ring_pop(queue->ring, &msg) == true) {
+            depth_dec(queue);
+            return msg.data;
+        }
+        if (atomic_load(&queue->depth) == 0) {
+            return NULL;
+        }
     }
-    struct t_mympd_msg *current = queue->head;
-    while (current != NULL) {
-        if (current->id == id) {
-            return true;
+    int rc = pthread_mutex_lock(&queue->mutex);
+    if (rc != 0) {
+        MYMPD_LOG_ERROR(NULL, "Error in pthread_mutex_lock: %d", rc);
+        return NULL;
+    }
+    if (id != 0) {
+        ring_move_to_list(queue);
+    }
+    void *data = shift_locked(queue, id);
+    unlock_mutex(&queue->mutex);
+    return data;
+}
+
+/**
+ * Waits for a new entry in a ring buffer queue
+ * @param queue pointer to the queue
+ * @param timeout_ms timeout in ms, 0 to wait infinite
+ * @param id 0 for first entry or specific id
+ * @return true if woken up, false on timeout or error
+ */
+static bool wait_for_entry(struct t_mympd_queue *queue, int timeout_ms, unsigned id) {
+    int rc = pthread_mutex_lock(&queue->mutex);
+    if (rc != 0) {
+        MYMPD_LOG_ERROR(NULL, "Error in pthread_mutex_lock: %d", rc);
+        return false;
+    }
+    atomic_fetch_add(&queue->waiters, 1);
+    if (ring_peek(queue->ring) == false &&
+        has_entry(queue, id) == false)
+    {
+        if (timeout_ms > 0) {
+            struct timespec max_wait = {0, 0};
+            set_wait_time(timeout_ms, &max_wait);
+            rc = pthread_cond_timedwait(&queue->wakeup, &queue->mutex, &max_wait);
+        }
+        else {
+            rc = pthread_cond_wait(&queue->wakeup, &queue->mutex);
+        }
+        if (rc != 0 &&
+            rc != ETIMEDOUT)
+        {
+            MYMPD_LOG_ERROR(NULL, "Error in pthread_cond_timedwait: %d", rc);
         }
-        current = current->next;
+    }
+    atomic_fetch_sub(&queue->waiters, 1);
+    unlock_mutex(&queue->mutex);
+    return rc == 0;
+}
+
+/**
+ * Checks if the locked list has an entry with requested id.
+ * Caller must hold the mutex.
+ * @param queue Pointer to the queue
+ * @param id 0 for first entry or specific id
+ * @return true if there is an entry, else false
+ */
+static bool has_entry(struct t_mympd_queue *queue, unsigned id) {
+    if (msg_list_find(queue, id) != NULL) {
+        return true;
     }
     MYMPD_LOG_DEBUG(NULL, "No entry with id %u found in queue %s", id, queue->name);
     return false;
 }
 
+/**
+ * Wakes up the consumer event loop.
+ * Only the first message after the consumer started to shift sends a wakeup.
+ * @param queue Pointer to the queue
+ */
+static void send_wakeup(struct t_mympd_queue *queue) {
+    if (queue->event_fd == -1 &&
+        queue->mg_mgr == NULL)
+    {
+        return;
+    }
+    if (atomic_exchange(&queue->wakeup_pending, true) == true) {
+        return;
+    }
+    atomic_fetch_add(&queue->wakeups, 1);
+    if (queue->event_fd > -1) {
+        event_eventfd_write(queue->event_fd);
+    }
+    else {
+        mympd_mg_wakeup_send("Q");
+    }
+}
+
+/**
+ * Increments the queue depth and updates the high-water mark
+ * @param queue Pointer to the queue
+ */
+static void depth_inc(struct t_mympd_queue *queue) {
+    atomic_fetch_add(&queue->pushed, 1);
+    unsigned depth = atomic_fetch_add(&queue->depth, 1) + 1;
+    unsigned high_water = atomic_load(&queue->high_water);
+    while (depth > high_water &&
+        atomic_compare_exchange_weak(&queue->high_water, &high_water, depth) == false)
+    {
+        // high_water was updated by the failed exchange
+    }
+}
+
+/**
+ * Decrements the queue depth
+ * @param queue Pointer to the queue
+ */
+static void depth_dec(struct t_mympd_queue *queue) {
+    atomic_fetch_sub(&queue->depth, 1);
+}
+
+/**
+ * Claims a slot in the ring buffer and fills it
+ * @param ring Pointer to the ring buffer
+ * @param data t_work_request or t_work_response
+ * @param id id of the queue entry
+ * @return true on success, false if the ring buffer is full
+ */
+static bool ring_push(struct t_mympd_ring *ring, void *data, unsigned id) {
+    size_t pos = atomic_load_explicit(&ring->enqueue_pos, memory_order_relaxed);
+    struct t_mympd_ring_slot *slot;
+    for (;;) {
+        slot = &ring->slots[pos & ring->mask];
+        size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        if (sequence == pos) {
+            // slot is free, try to claim it
+            if (atomic_compare_exchange_weak_explicit(&ring->enqueue_pos, &pos, pos + 1,
+                    memory_order_relaxed, memory_order_relaxed) == true)
+            {
+                break;
+            }
+        }
+        else if (sequence < pos) {
+            // slot was not consumed yet
+            return false;
+        }
+        else {
+            // another producer claimed the slot
+            pos = atomic_load_explicit(&ring->enqueue_pos, memory_order_relaxed);
+        }
+    }
+    slot->data = data;
+    slot->id = id;
+    slot->timestamp = time(NULL);
+    // publish the slot to the consumer
+    atomic_store_explicit(&slot->sequence, pos + 1, memory_order_release);
+    return true;
+}
+
+/**
+ * Reads the next slot from the ring buffer and releases it for the producers
+ * @param ring Pointer to the ring buffer
+ * @param msg message to populate
+ * @return true on success, false if the ring buffer is empty
+ */
+static bool ring_pop(struct t_mympd_ring *ring, struct t_mympd_msg *msg) {
+    struct t_mympd_ring_slot *slot = &ring->slots[ring->dequeue_pos & ring->mask];
+    size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+    if (sequence != ring->dequeue_pos + 1) {
+        return false;
+    }
+    msg->data = slot->data;
+    msg->id = slot->id;
+    msg->timestamp = slot->timestamp;
+    atomic_store_explicit(&slot->sequence, ring->dequeue_pos + ring->mask + 1, memory_order_release);
+    ring->dequeue_pos++;
+    return true;
+}
+
+/**
+ * Checks if the next slot in the ring buffer is filled
+ * @param ring Pointer to the ring buffer
+ * @return true if the ring buffer has an entry, else false
+ */
+static bool ring_peek(struct t_mympd_ring *ring) {
+    const struct t_mympd_ring_slot *slot = &ring->slots[ring->dequeue_pos & ring->mask];
+    return atomic_load_explicit(&slot->sequence, memory_order_acquire) == ring->dequeue_pos + 1;
+}
+
+/**
+ * Moves all entries from the ring buffer to the locked list.
+ * Caller must be the consumer and hold the mutex.
+ * @param queue Pointer to the queue
+ */
+static void ring_move_to_list(struct t_mympd_queue *queue) {
+    if (ring_peek(queue->ring) == false) {
+        return;
+    }
+    // the ring buffer entries are older than the list entries,
+    // the length is not reset to keep the producers on the list
+    struct t_mympd_msg *newer = queue->head;
+    unsigned newer_length = queue->length;
+    if (newer != NULL) {
+        queue->head = NULL;
+        queue->tail = NULL;
+        raxFree(queue->ids);
+        queue->ids = raxNew();
+    }
+    struct t_mympd_msg msg;
+    while (ring_pop(queue->ring, &msg) == true) {
+        msg_list_append(queue, msg_list_node_new(msg.data, msg.id, msg.timestamp));
+    }
+    while (newer != NULL) {
+        struct t_mympd_msg *next = newer->next;
+        newer->next = NULL;
+        newer->next_id = NULL;
+        msg_list_append(queue, newer);
+        newer = next;
+    }
+    queue->length -= newer_length;
+}
+
+/**
+ * Creates a new list node
+ * @param data t_work_request or t_work_response
+ * @param id id of the queue entry
+ * @param timestamp timestamp of the queue entry
+ * @return newly allocated node
+ */
+static struct t_mympd_msg *msg_list_node_new(void *data, unsigned id, time_t timestamp) {
+    struct t_mympd_msg *node = malloc_assert(sizeof(struct t_mympd_msg));
+    node->data = data;
+    node->id = id;
+    node->timestamp = timestamp;
+    node->next = NULL;
+    node->prev = NULL;
+    node->next_id = NULL;
+    return node;
+}
+
+/**
+ * Appends a node to the locked list and indexes its id.
+ * Caller must hold the mutex.
+ * @param queue Pointer to the queue
+ * @param node Node to append
+ */
+static void msg_list_append(struct t_mympd_queue *queue, struct t_mympd_msg *node) {
+    node->prev = queue->tail;
+    if (queue->tail == NULL) {
+        queue->head = node;
+    }
+    else {
+        queue->tail->next = node;
+    }
+    queue->tail = node;
+    queue->length++;
+    if (node->id == 0) {
+        return;
+    }
+    void *first;
+    if (raxFind(queue->ids, (unsigned char *)&node->id, sizeof(node->id), &first) == 1) {
+        struct t_mympd_msg *current = first;
+        while (current->next_id != NULL) {
+            current = current->next_id;
+        }
+        current->next_id = node;
+    }
+    else {
+        raxInsert(queue->ids, (unsigned char *)&node->id, sizeof(node->id), node, NULL);
+    }
+}
+
+/**
+ * Detaches a node from the locked list and the id index.
+ * Caller must hold the mutex.
+ * @param queue Pointer to the queue
+ * @param node Node to remove
+ */
+static void msg_list_remove(struct t_mympd_queue *queue, struct t_mympd_msg *node) {
+    if (node->prev == NULL) {
+        queue->head = node->next;
+    }
+    else {
+        node->prev->next = node->next;
+    }
+    if (node->next == NULL) {
+        queue->tail = node->prev;
+    }
+    else {
+        node->next->prev = node->prev;
+    }
+    queue->length--;
+    if (node->id == 0) {
+        return;
+    }
+    void *first;
+    if (raxFind(queue->ids, (unsigned char *)&node->id, sizeof(node->id), &first) == 0) {
+        return;
+    }
+    if (first == node) {
+        if (node->next_id == NULL) {
+            raxRemove(queue->ids, (unsigned char *)&node->id, sizeof(node->id), NULL);
+        }
+        else {
+            raxInsert(queue->ids, (unsigned char *)&node->id, sizeof(node->id), node->next_id, NULL);
+        }
+        return;
+    }
+    struct t_mympd_msg *current = first;
+    while (current->next_id != NULL) {
+        if (current->next_id == node) {
+            current->next_id = node->next_id;
+            return;
+        }
+        current = current->next_id;
+    }
+}
+
+/**
+ * Finds the first node or the first node with specific id in the locked list.
+ * Caller must hold the mutex.
+ * @param queue Pointer to the queue
+ * @param id 0 for first entry or specific id
+ * @return the node or NULL if not found
+ */
+static struct t_mympd_msg *msg_list_find(struct t_mympd_queue *queue, unsigned id) {
+    if (id == 0) {
+        return queue->head;
+    }
+    void *node;
+    if (raxFind(queue->ids, (unsigned char *)&id, sizeof(id), &node) == 1) {
+        return node;
+    }
+    return NULL;
+}
+
 /**
  * Frees a queue node, node must be detached from queue
  * @param node to free
@@ -352,6 +786,6 @@ static void set_wait_time(int timeout_ms, struct timespec *max_wait) {
         max_wait->tv_nsec = (long)(timeout_ns % SEC_NSEC);
     }
     else {
-        max_wait->tv_nsec += (long)timeout_ns;
+        max_wait->tv_nsec = (long)timeout_ns;
     }
 }
@@ -11,10 +11,24 @@
 #ifndef MYMPD_QUEUE_H
 #define MYMPD_QUEUE_H
 
+#include "dist/rax/rax.h"
+
 #include <pthread.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <time.h>
 
+/**
+ * Default number of slots for ring buffer queues, must be a power of two
+ */
+#define MYMPD_QUEUE_RING_SIZE 1024
+
+/**
+ * Maximum number of messages a consumer handles per wakeup
+ */
+#define MYMPD_QUEUE_BATCH_SIZE 32
+
 extern struct t_mympd_queue *webserver_queue;
 extern struct t_mympd_queue *mympd_api_queue;
 #ifdef MYMPD_ENABLE_LUA
@@ -30,6 +44,39 @@ struct t_mympd_msg {
     unsigned id;               //!< id of the message
     time_t timestamp;          //!< messages added timestamp
     struct t_mympd_msg *next;  //!< pointer to next message
+    struct t_mympd_msg *prev;  //!< pointer to previous message
+    struct t_mympd_msg *next_id;  //!< pointer to next message with the same id
+};
+
+/**
+ * A preallocated slot in the ring buffer
+ */
+struct t_mympd_ring_slot {
+    _Atomic size_t sequence;  //!< sequence number, marks the slot as free or filled
+    void *data;               //!< data t_work_request or t_work_response
+    unsigned id;              //!< id of the message
+    time_t timestamp;         //!< messages added timestamp
+};
+
+/**
+ * Bounded lock-free multi-producer/single-consumer ring buffer
+ */
+struct t_mympd_ring {
+    struct t_mympd_ring_slot *slots;  //!< preallocated slots
+    size_t mask;                      //!< number of slots - 1
+    _Atomic size_t enqueue_pos;       //!< next slot to fill, shared by the producers
+    size_t dequeue_pos;               //!< next slot to read, owned by the consumer
+};
+
+/**
+ * Queue metrics
+ */
+struct t_mympd_queue_stats {
+    unsigned length;      //!< current number of messages
+    unsigned high_water;  //!< maximum number of messages
+    uint64_t pushed;      //!< number of pushed messages
+    uint64_t overflows;   //!< number of messages that did not fit in the ring buffer
+    uint64_t wakeups;     //!< number of consumer wakeups sent
 };
 
 /**
@@ -44,9 +91,11 @@ enum mympd_queue_types {
  * Struct for the thread save message queue
  */
 struct t_mympd_queue {
-    unsigned length;              //!< length of the queue
+    _Atomic unsigned length;      //!< length of the locked message list
     struct t_mympd_msg *head;     //!< pointer to first message
     struct t_mympd_msg *tail;     //!< pointer to last message
+    rax *ids;                     //!< first message in the locked list for each id
+    struct t_mympd_ring *ring;    //!< lock-free ring buffer or NULL for a mutex only queue
     pthread_mutex_t mutex;        //!< the mutex
     pthread_cond_t wakeup;        //!< condition variable for the mutex
     const char *name;             //!< descriptive name
@@ -56,13 +105,26 @@ struct t_mympd_queue {
     // to wakeup the mongoose event loop
     unsigned long mg_conn_id;     //!< mongoose listener id
     void *mg_mgr;                 //!< mongoose mgr
+    // wakeup coalescing and metrics
+    _Atomic bool wakeup_pending;  //!< consumer was already woken up
+    _Atomic unsigned waiters;     //!< number of consumers blocked on the condition variable
+    _Atomic unsigned depth;       //!< current number of messages
+    _Atomic unsigned high_water;  //!< maximum number of messages
+    _Atomic uint64_t pushed;      //!< number of pushed messages
+    _Atomic uint64_t overflows;   //!< number of messages that did not fit in the ring buffer
+    _Atomic uint64_t wakeups;     //!< number of consumer wakeups sent
 };
 
 struct t_mympd_queue *mympd_queue_create(const char *name, enum mympd_queue_types type,
         bool event);
+struct t_mympd_queue *mympd_queue_create_ring(const char *name, enum mympd_queue_types type,
+        bool event, size_t slots);
 void *mympd_queue_free(struct t_mympd_queue *queue);
 bool mympd_queue_push(struct t_mympd_queue *queue, void *data, unsigned id);
 void *mympd_queue_shift(struct t_mympd_queue *queue, int timeout_ms, unsigned id);
+size_t mympd_queue_shift_batch(struct t_mympd_queue *queue, void **data, size_t max);
+unsigned mympd_queue_length(struct t_mympd_queue *queue);
+void mympd_queue_get_stats(struct t_mympd_queue *queue, struct t_mympd_queue_stats *stats);
 int mympd_queue_expire_age(struct t_mympd_queue *queue, time_t max_age_s);
 bool mympd_mg_wakeup_send(const void *data);
 
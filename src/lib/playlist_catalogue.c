@@ -0,0 +1,100 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2026 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+/*! \file
+ * \brief In-memory catalogue of the MPD stored playlists
+ */
+
+#include "compile_time.h"
+#include "src/lib/playlist_catalogue.h"
+
+#include "src/lib/mem.h"
+#include "src/lib/rax_extras.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Public functions
+ */
+
+/**
+ * Initializes an empty and invalid playlist catalogue
+ * @param catalogue pointer to the playlist catalogue
+ */
+void playlist_catalogue_init(struct t_playlist_catalogue *catalogue) {
+    catalogue->playlists = raxNew();
+    catalogue->valid = false;
+}
+
+/**
+ * Frees all entries and invalidates the catalogue
+ * @param catalogue pointer to the playlist catalogue
+ */
+void playlist_catalogue_clear(struct t_playlist_catalogue *catalogue) {
+    if (catalogue->playlists->numele > 0) {
+        rax_free_data(catalogue->playlists, NULL);
+        catalogue->playlists = raxNew();
+    }
+    catalogue->valid = false;
+}
+
+/**
+ * Frees all entries and the index
+ * @param catalogue pointer to the playlist catalogue
+ */
+void playlist_catalogue_free(struct t_playlist_catalogue *catalogue) {
+    rax_free_data(catalogue->playlists, NULL);
+    catalogue->playlists = NULL;
+    catalogue->valid = false;
+}
+
+/**
+ * Adds or replaces a playlist
+ * @param catalogue pointer to the playlist catalogue
+ * @param name playlist name
+ * @param last_modified last modification time reported by MPD
+ * @param smartpls true if a smart playlist definition exists
+ */
+void playlist_catalogue_add(struct t_playlist_catalogue *catalogue, const char *name,
+        time_t last_modified, bool smartpls)
+{
+    struct t_playlist_catalogue_entry *entry = malloc_assert(sizeof(struct t_playlist_catalogue_entry));
+    entry->last_modified = last_modified;
+    entry->smartpls = smartpls;
+    entry->enumerated = false;
+    entry->count = 0;
+    entry->duration = 0;
+    void *old = NULL;
+    raxInsert(catalogue->playlists, (unsigned char *)name, strlen(name), entry, &old);
+    FREE_PTR(old);
+}
+
+/**
+ * Gets the metadata of a playlist
+ * @param catalogue pointer to the playlist catalogue
+ * @param name playlist name
+ * @return the entry or NULL if the playlist does not exist
+ */
+struct t_playlist_catalogue_entry *playlist_catalogue_get(struct t_playlist_catalogue *catalogue, const char *name) {
+    void *data;
+    if (raxFind(catalogue->playlists, (unsigned char *)name, strlen(name), &data) == 1) {
+        return (struct t_playlist_catalogue_entry *)data;
+    }
+    return NULL;
+}
+
+/**
+ * Removes a playlist
+ * @param catalogue pointer to the playlist catalogue
+ * @param name playlist name
+ */
+void playlist_catalogue_remove(struct t_playlist_catalogue *catalogue, const char *name) {
+    void *old = NULL;
+    if (raxRemove(catalogue->playlists, (unsigned char *)name, strlen(name), &old) == 1) {
+        FREE_PTR(old);
+    }
+}
@@ -0,0 +1,46 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2026 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+/*! \file
+ * \brief In-memory catalogue of the MPD stored playlists
+ */
+
+#ifndef MYMPD_PLAYLIST_CATALOGUE_H
+#define MYMPD_PLAYLIST_CATALOGUE_H
+
+#include "dist/rax/rax.h"
+
+#include <stdbool.h>
+#include <time.h>
+
+/**
+ * Metadata of a stored playlist
+ */
+struct t_playlist_catalogue_entry {
+    time_t last_modified;  //!< last modification time reported by MPD
+    bool smartpls;         //!< true if a smart playlist definition exists
+    bool enumerated;       //!< true if count and duration are set
+    unsigned count;        //!< number of songs
+    unsigned duration;     //!< total playtime in seconds
+};
+
+/**
+ * Stored playlists by name, populated on demand
+ */
+struct t_playlist_catalogue {
+    rax *playlists;  //!< entries by playlist name
+    bool valid;      //!< true if the entries are in sync with MPD
+};
+
+void playlist_catalogue_init(struct t_playlist_catalogue *catalogue);
+void playlist_catalogue_clear(struct t_playlist_catalogue *catalogue);
+void playlist_catalogue_free(struct t_playlist_catalogue *catalogue);
+void playlist_catalogue_add(struct t_playlist_catalogue *catalogue, const char *name,
+        time_t last_modified, bool smartpls);
+struct t_playlist_catalogue_entry *playlist_catalogue_get(struct t_playlist_catalogue *catalogue, const char *name);
+void playlist_catalogue_remove(struct t_playlist_catalogue *catalogue, const char *name);
+
+#endif
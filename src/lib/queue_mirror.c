@@ -0,0 +1,238 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2026 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+/*! \file
+ * \brief In-memory mirror of the MPD queue
+ */
+
+#include "compile_time.h"
+#include "src/lib/queue_mirror.h"
+
+#include "dist/rax/rax.h"
+#include "src/lib/mem.h"
+
+#include <limits.h>
+#include <string.h>
+
+/**
+ * Private definitions
+ */
+
+static void free_entries(struct t_queue_mirror_entry *entries, unsigned length);
+
+/**
+ * Public functions
+ */
+
+/**
+ * Initializes an empty and invalid queue mirror
+ * @param mirror pointer to queue mirror
+ */
+void queue_mirror_init(struct t_queue_mirror *mirror) {
+    mirror->entries = NULL;
+    mirror->length = 0;
+    mirror->version = 0;
+    mirror->valid = false;
+    mirror->total_time = 0;
+}
+
+/**
+ * Frees all songs and invalidates the queue mirror
+ * @param mirror pointer to queue mirror
+ */
+void queue_mirror_clear(struct t_queue_mirror *mirror) {
+    free_entries(mirror->entries, mirror->length);
+    queue_mirror_init(mirror);
+}
+
+/**
+ * Appends a song while loading the complete queue.
+ * The mirror takes the ownership of the song.
+ * @param mirror pointer to queue mirror
+ * @param song song to append, the position must be the current length of the mirror
+ * @return true on success, else false
+ */
+bool queue_mirror_append(struct t_queue_mirror *mirror, struct mpd_song *song) {
+    if (mpd_song_get_pos(song) != mirror->length) {
+        mpd_song_free(song);
+        return false;
+    }
+    mirror->entries = realloc_assert(mirror->entries, (mirror->length + 1) * sizeof(struct t_queue_mirror_entry));
+    mirror->entries[mirror->length].song = song;
+    mirror->entries[mirror->length].id = mpd_song_get_id(song);
+    mirror->length++;
+    return true;
+}
+
+/**
+ * Applies the position changes reported by plchangesposid.
+ * Songs that were only moved are reused, songs that are new or were modified
+ * in place are marked as pending and must be set with queue_mirror_set_song.
+ * The mirror is invalid until queue_mirror_commit is called.
+ * @param mirror pointer to queue mirror
+ * @param changes changed positions
+ * @param count number of changes
+ * @param length new queue length
+ * @param first_pending set to the first position that must be fetched
+ * @param last_pending set to the last position that must be fetched
+ * @return number of positions that must be fetched
+ */
+unsigned queue_mirror_patch(struct t_queue_mirror *mirror, const struct t_queue_change *changes, unsigned count,
+        unsigned length, unsigned *first_pending, unsigned *last_pending)
+{
+    mirror->valid = false;
+    struct t_queue_mirror_entry *entries = length > 0
+        ? malloc_assert(length * sizeof(struct t_queue_mirror_entry))
+        : NULL;
+    bool *used = NULL;
+    if (mirror->length > 0) {
+        used = malloc_assert(mirror->length * sizeof(bool));
+        memset(used, 0, mirror->length * sizeof(bool));
+    }
+    // unchanged positions keep their songs
+    for (unsigned pos = 0; pos < length; pos++) {
+        entries[pos].song = NULL;
+        entries[pos].id = UINT_MAX;
+    }
+    for (unsigned i = 0; i < count; i++) {
+        if (changes[i].pos < length) {
+            entries[changes[i].pos].id = changes[i].id;
+        }
+    }
+    for (unsigned pos = 0; pos < length && pos < mirror->length; pos++) {
+        if (entries[pos].id == UINT_MAX) {
+            entries[pos] = mirror->entries[pos];
+            used[pos] = true;
+        }
+    }
+    // moved songs are reused
+    rax *old_ids = raxNew();
+    for (unsigned pos = 0; pos < mirror->length; pos++) {
+        if (used[pos] == false) {
+            raxInsert(old_ids, (unsigned char *)&mirror->entries[pos].id, sizeof(unsigned), &mirror->entries[pos], NULL);
+        }
+    }
+    for (unsigned i = 0; i < count; i++) {
+        unsigned pos = changes[i].pos;
+        if (pos >= length) {
+            continue;
+        }
+        void *data;
+        if (raxFind(old_ids, (unsigned char *)&changes[i].id, sizeof(unsigned), &data) == 1) {
+            struct t_queue_mirror_entry *old = (struct t_queue_mirror_entry *)data;
+            unsigned old_pos = (unsigned)(old - mirror->entries);
+            // a song modified in place is fetched again
+            if (old_pos != pos &&
+                used[old_pos] == false)
+            {
+                entries[pos].song = old->song;
+                mpd_song_set_pos(entries[pos].song, pos);
+                used[old_pos] = true;
+            }
+        }
+    }
+    raxFree(old_ids);
+    // free the removed and modified songs
+    for (unsigned pos = 0; pos < mirror->length; pos++) {
+        if (used[pos] == false &&
+            mirror->entries[pos].song != NULL)
+        {
+            mpd_song_free(mirror->entries[pos].song);
+        }
+    }
+    FREE_PTR(used);
+    FREE_PTR(mirror->entries);
+    mirror->entries = entries;
+    mirror->length = length;
+
+    unsigned pending = 0;
+    *first_pending = UINT_MAX;
+    *last_pending = 0;
+    for (unsigned pos = 0; pos < length; pos++) {
+        if (entries[pos].song == NULL) {
+            if (pending == 0) {
+                *first_pending = pos;
+            }
+            *last_pending = pos;
+            pending++;
+        }
+    }
+    return pending;
+}
+
+/**
+ * Sets the song for a position after patching the mirror.
+ * The mirror takes the ownership of the song.
+ * @param mirror pointer to queue mirror
+ * @param song song to set, the song id must match the id of the queue position
+ * @return true on success, false if the queue has changed in the meantime
+ */
+bool queue_mirror_set_song(struct t_queue_mirror *mirror, struct mpd_song *song) {
+    unsigned pos = mpd_song_get_pos(song);
+    if (pos >= mirror->length ||
+        mirror->entries[pos].id != mpd_song_get_id(song))
+    {
+        mpd_song_free(song);
+        return false;
+    }
+    if (mirror->entries[pos].song != NULL) {
+        mpd_song_free(mirror->entries[pos].song);
+    }
+    mirror->entries[pos].song = song;
+    return true;
+}
+
+/**
+ * Validates the mirror and sets the queue version.
+ * An incomplete mirror is cleared.
+ * @param mirror pointer to queue mirror
+ * @param version MPD queue version
+ * @return true if the mirror is complete, else false
+ */
+bool queue_mirror_commit(struct t_queue_mirror *mirror, unsigned version) {
+    uint64_t total_time = 0;
+    for (unsigned pos = 0; pos < mirror->length; pos++) {
+        if (mirror->entries[pos].song == NULL) {
+            queue_mirror_clear(mirror);
+            return false;
+        }
+        total_time += mpd_song_get_duration(mirror->entries[pos].song);
+    }
+    mirror->total_time = total_time;
+    mirror->version = version;
+    mirror->valid = true;
+    return true;
+}
+
+/**
+ * Gets the song at a queue position
+ * @param mirror pointer to queue mirror
+ * @param pos queue position
+ * @return the song or NULL if pos is out of range
+ */
+const struct mpd_song *queue_mirror_get(const struct t_queue_mirror *mirror, unsigned pos) {
+    return pos < mirror->length
+        ? mirror->entries[pos].song
+        : NULL;
+}
+
+/**
+ * Private functions
+ */
+
+/**
+ * Frees the songs of the entries array and the array itself
+ * @param entries entries array
+ * @param length length of the array
+ */
+static void free_entries(struct t_queue_mirror_entry *entries, unsigned length) {
+    for (unsigned pos = 0; pos < length; pos++) {
+        if (entries[pos].song != NULL) {
+            mpd_song_free(entries[pos].song);
+        }
+    }
+    FREE_PTR(entries);
+}
@@ -0,0 +1,55 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2026 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+/*! \file
+ * \brief In-memory mirror of the MPD queue
+ */
+
+#ifndef MYMPD_QUEUE_MIRROR_H
+#define MYMPD_QUEUE_MIRROR_H
+
+#include "src/lib/mpdclient.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Change of a queue position reported by plchangesposid
+ */
+struct t_queue_change {
+    unsigned pos;  //!< queue position
+    unsigned id;   //!< song id at this position
+};
+
+/**
+ * Entry of the queue mirror
+ */
+struct t_queue_mirror_entry {
+    struct mpd_song *song;  //!< the song, NULL if it must be fetched from MPD
+    unsigned id;            //!< song id
+};
+
+/**
+ * Mirror of the MPD queue, kept in sync with plchanges deltas
+ */
+struct t_queue_mirror {
+    struct t_queue_mirror_entry *entries;  //!< entries by queue position
+    unsigned length;                       //!< number of entries
+    unsigned version;                      //!< MPD queue version the mirror is based on
+    bool valid;                            //!< true if the mirror is complete
+    uint64_t total_time;                   //!< summed up duration of all songs
+};
+
+void queue_mirror_init(struct t_queue_mirror *mirror);
+void queue_mirror_clear(struct t_queue_mirror *mirror);
+bool queue_mirror_append(struct t_queue_mirror *mirror, struct mpd_song *song);
+unsigned queue_mirror_patch(struct t_queue_mirror *mirror, const struct t_queue_change *changes, unsigned count,
+        unsigned length, unsigned *first_pending, unsigned *last_pending);
+bool queue_mirror_set_song(struct t_queue_mirror *mirror, struct mpd_song *song);
+bool queue_mirror_commit(struct t_queue_mirror *mirror, unsigned version);
+const struct mpd_song *queue_mirror_get(const struct t_queue_mirror *mirror, unsigned pos);
+
+#endif
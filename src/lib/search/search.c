@@ -62,13 +62,14 @@ enum search_filters {
  * Struct to hold a parsed search expression triple
  */
 struct t_search_expression {
-    int tag;                    //!< Tag to search in
-    enum search_operators op;   //!< Search operator
-    sds value;                  //!< Value
-    char *value_utf8;           //!< Normalized utf8 value to match
-    size_t value_utf8_len;      //!< Length of value_utf8
-    int64_t value_i;            //!< Integer value to match
-    pcre2_code *re_compiled;    //!< Compiled regex if operator is a regex
+    int tag;                       //!< Tag to search in
+    enum search_operators op;      //!< Search operator
+    sds value;                     //!< Value
+    char *value_utf8;              //!< Normalized utf8 value to match
+    size_t value_utf8_len;         //!< Length of value_utf8
+    int64_t value_i;               //!< Integer value to match
+    struct t_search_pcre *re;      //!< Compiled regex if operator is a regex
+    struct t_search_fuzzy *fuzzy;  //!< Compiled needle if operator is fuzzy
 };
 
 static int expr_get_tag_song(const char *p, size_t *len);
@@ -79,6 +80,7 @@ static bool expr_parse_value(struct t_search_expression *expr);
 static void *free_search_expression_struct(struct t_search_expression *expr);
 static void free_search_expression_node(struct t_list_node *current);
 static bool match_tag(const char *value, size_t value_len, struct t_search_expression *expr);
+static bool match_tag_normalize(const char *value, struct t_search_expression *expr);
 static bool exit_search_loop(bool rc, struct t_search_expression *expr);
 
 /**
@@ -102,7 +104,8 @@ struct t_list *search_expression_parse(const char *expression, enum search_type
         expr->value = sdsempty();
         expr->value_utf8 = NULL;
         expr->value_utf8_len = 0;
-        expr->re_compiled = NULL;
+        expr->re = NULL;
+        expr->fuzzy = NULL;
         char *p = tokens[j];
         char *end = p + sdslen(tokens[j]) - 1;
         // Tag
@@ -147,6 +150,9 @@ struct t_list *search_expression_parse(const char *expression, enum search_type
             break;
         }
         expr->value_utf8 = utf8_wrap_normalize(expr->value, sdslen(expr->value), &expr->value_utf8_len);
+        if (expr->op == SEARCH_OP_FUZZY) {
+            expr->fuzzy = mympd_search_fuzzy_compile(expr->value_utf8, expr->value_utf8_len);
+        }
         list_push(expr_list, "", 0, NULL, expr);
         MYMPD_LOG_DEBUG(NULL, "Parsed expression tag: \"%d\", op: \"%d\", value:\"%s\"", expr->tag, expr->op, expr->value);
     }
@@ -217,17 +223,12 @@ bool search_expression_song(const struct mpd_song *song, const struct t_list *ex
                     rc = false;
                     unsigned value_count = 0;
                     const char *value = NULL;
-                    char *value_utf8 = NULL;
-                    size_t value_utf8_len;
                     while ((value = mpd_song_get_tag(song, tags->tags[tag_count], value_count)) != NULL) {
-                        value_utf8 = utf8_wrap_normalize(value, strlen(value), &value_utf8_len);
                         value_count++;
-                        rc = match_tag(value_utf8, value_utf8_len, expr);
+                        rc = match_tag_normalize(value, expr);
                         if (exit_search_loop(rc, expr) == true) {
-                            FREE_PTR(value_utf8);
                             break;
                         }
-                        FREE_PTR(value_utf8);
                     }
                     if (value_count == 0) {
                         //no tag value found
@@ -292,17 +293,16 @@ bool search_expression_album(const struct t_album *album, const struct t_list *e
                     rc = false;
                     unsigned value_count = 0;
                     const char *value = NULL;
-                    char *value_utf8 = NULL;
-                    size_t value_utf8_len;
                     while ((value = album_get_tag(album, tags->tags[tag_count], value_count)) != NULL) {
-                        value_utf8 = utf8_wrap_normalize(value, strlen(value), &value_utf8_len);
+                        // use the normalized value from the album cache string pool
+                        sds value_norm = album_get_tag_normalized(album, tags->tags[tag_count], value_count);
                         value_count++;
-                        rc = match_tag(value_utf8, value_utf8_len, expr);
+                        rc = value_norm != NULL
+                            ? match_tag(value_norm, sdslen(value_norm), expr)
+                            : match_tag_normalize(value, expr);
                         if (exit_search_loop(rc, expr) == true) {
-                            FREE_PTR(value_utf8);
                             break;
                         }
-                        FREE_PTR(value_utf8);
                     }
                     if (value_count == 0) {
                         //no tag value found
@@ -366,17 +366,16 @@ bool search_expression_webradio(const struct t_webradio_data *webradio, const st
                     rc = false;
                     unsigned value_count = 0;
                     const char *value = NULL;
-                    char *value_utf8 = NULL;
-                    size_t value_utf8_len;
                     while ((value = webradio_get_tag(webradio, tags->tags[tag_count], value_count)) != NULL) {
-                        value_utf8 = utf8_wrap_normalize(value, strlen(value), &value_utf8_len);
+                        // use the normalized value from the webradios string pool
+                        sds value_norm = webradio_get_tag_normalized(webradio, tags->tags[tag_count], value_count);
                         value_count++;
-                        rc = match_tag(value_utf8, value_utf8_len, expr);
+                        rc = value_norm != NULL
+                            ? match_tag(value_norm, sdslen(value_norm), expr)
+                            : match_tag_normalize(value, expr);
                         if (exit_search_loop(rc, expr) == true) {
-                            FREE_PTR(value_utf8);
                             break;
                         }
-                        FREE_PTR(value_utf8);
                     }
                     if (value_count == 0) {
                         //no tag value found
@@ -416,14 +415,28 @@ static bool match_tag(const char *value, size_t value_len, struct t_search_expre
         case SEARCH_OP_CONTAINS:    return strstr(value, expr->value_utf8) != NULL;
         case SEARCH_OP_STARTS_WITH: return strncmp(value, expr->value_utf8, expr->value_utf8_len) == 0;
         case SEARCH_OP_EQUAL:       return strcmp(value, expr->value_utf8) == 0;
-        case SEARCH_OP_REGEX:       return mympd_search_pcre_match(value, value_len, expr->re_compiled);
-        case SEARCH_OP_FUZZY:       return mympd_search_fuzzy_match(value, value_len, expr->value_utf8, expr->value_utf8_len);
+        case SEARCH_OP_REGEX:       return mympd_search_pcre_match(value, value_len, expr->re);
+        case SEARCH_OP_FUZZY:       return mympd_search_fuzzy_match_compiled(value, value_len, expr->fuzzy);
         case SEARCH_OP_NOT_EQUAL:   return strcmp(value, expr->value_utf8) != 0;
-        case SEARCH_OP_NOT_REGEX:   return mympd_search_pcre_match(value, value_len, expr->re_compiled) == false;
+        case SEARCH_OP_NOT_REGEX:   return mympd_search_pcre_match(value, value_len, expr->re) == false;
         default:                    return false;
     }
 }
 
+/**
+ * Normalizes the tag value and matches the search expression against it
+ * @param value Value to normalize and match search expression against
+ * @param expr Search expression
+ * @return true if search expression matches, else false
+ */
+static bool match_tag_normalize(const char *value, struct t_search_expression *expr) {
+    size_t value_utf8_len;
+    char *value_utf8 = utf8_wrap_normalize(value, strlen(value), &value_utf8_len);
+    bool rc = match_tag(value_utf8, value_utf8_len, expr);
+    FREE_PTR(value_utf8);
+    return rc;
+}
+
 /**
  * Determines if the search loop can end
  * @param rc Result of match_tag function
@@ -672,8 +685,8 @@ static bool expr_parse_value(struct t_search_expression *expr) {
              expr->op == SEARCH_OP_NOT_REGEX)
     {
         // Compile regex
-        expr->re_compiled = mympd_search_pcre_compile(expr->value);
-        if (expr->re_compiled == NULL) {
+        expr->re = mympd_search_pcre_compile(expr->value, true);
+        if (expr->re == NULL) {
             return false;
         }
     }
@@ -688,7 +701,8 @@ static bool expr_parse_value(struct t_search_expression *expr) {
 static void *free_search_expression_struct(struct t_search_expression *expr) {
     FREE_SDS(expr->value);
     FREE_PTR(expr->value_utf8);
-    FREE_PTR(expr->re_compiled);
+    mympd_search_pcre_free(expr->re);
+    mympd_search_fuzzy_free(expr->fuzzy);
     FREE_PTR(expr);
     return NULL;
 }
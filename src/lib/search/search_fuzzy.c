@@ -10,105 +10,247 @@
 
 #include "src/lib/search/search_fuzzy.h"
 
-#include <stdlib.h>
+#include "src/lib/mem.h"
+
 #include <string.h>
 
 /**
  * Private definitions
  */
 
- static size_t levenshtein(const char *a, size_t a_len, const char *b, size_t b_len,
-        size_t *cache, size_t max_distance);
+/**
+ * Number of bits in a bit-vector word
+ */
+#define FUZZY_WORD_BITS 64
+
+/**
+ * Highest bit in a bit-vector word
+ */
+#define FUZZY_WORD_HIGH ((uint64_t)1 << (FUZZY_WORD_BITS - 1))
+
+static bool match_column(const struct t_search_fuzzy *pattern, const uint64_t *pv, const uint64_t *mv, size_t score);
+static size_t advance_column(const struct t_search_fuzzy *pattern, uint64_t *pv, uint64_t *mv, unsigned char c, int hin);
+static bool match_window(struct t_search_fuzzy *pattern, const unsigned char *window);
+static int advance_block(uint64_t *pv_block, uint64_t *mv_block, uint64_t eq, int hin, uint64_t last_bit);
 
 /**
  * Public functions
  */
 
 /**
- * Fuzzy substring matching using the levenshtein distance
- * @param haystack Haystack
- * @param haystack_len Haystack length
+ * Builds the bit-vectors for the fuzzy matcher.
+ * The maximum edit distance is 1 for needles shorter than 10 bytes,
+ * else one edit for each started 10 bytes.
  * @param needle Needle
  * @param needle_len Needle length
+ * @return Newly allocated pattern, free it with mympd_search_fuzzy_free
+ */
+struct t_search_fuzzy *mympd_search_fuzzy_compile(const char *needle, size_t needle_len) {
+    struct t_search_fuzzy *pattern = malloc_assert(sizeof(struct t_search_fuzzy));
+    pattern->len = needle_len;
+    pattern->max_distance = needle_len < 10
+        ? 1
+        : (needle_len / 10) + 1;
+    pattern->words = needle_len == 0
+        ? 1
+        : (needle_len + FUZZY_WORD_BITS - 1) / FUZZY_WORD_BITS;
+    size_t peq_size = 256 * pattern->words * sizeof(uint64_t);
+    pattern->peq = malloc_assert(peq_size);
+    memset(pattern->peq, 0, peq_size);
+    const unsigned char *p = (const unsigned char *)needle;
+    for (size_t i = 0; i < needle_len; i++) {
+        pattern->peq[(size_t)p[i] * pattern->words + i / FUZZY_WORD_BITS] |= (uint64_t)1 << (i % FUZZY_WORD_BITS);
+    }
+    // matching state, allocated once to keep matching allocation free
+    pattern->pv = malloc_assert(pattern->words * sizeof(uint64_t));
+    pattern->mv = malloc_assert(pattern->words * sizeof(uint64_t));
+    pattern->window_pv = malloc_assert(pattern->words * sizeof(uint64_t));
+    pattern->window_mv = malloc_assert(pattern->words * sizeof(uint64_t));
+    pattern->needle = malloc_assert(needle_len + 1);
+    memcpy(pattern->needle, needle, needle_len);
+    pattern->needle[needle_len] = '\0';
+    return pattern;
+}
+
+/**
+ * Frees the fuzzy pattern
+ * @param pattern Pattern to free, can be NULL
+ */
+void mympd_search_fuzzy_free(struct t_search_fuzzy *pattern) {
+    if (pattern == NULL) {
+        return;
+    }
+    FREE_PTR(pattern->peq);
+    FREE_PTR(pattern->pv);
+    FREE_PTR(pattern->mv);
+    FREE_PTR(pattern->window_pv);
+    FREE_PTR(pattern->window_mv);
+    FREE_PTR(pattern->needle);
+    FREE_PTR(pattern);
+}
+
+/**
+ * Fuzzy substring matching using the levenshtein distance.
+ * Matches if a substring of the haystack with the length of the needle
+ * has an edit distance lower or equal the maximum distance to the needle
+ * or to a prefix of the needle.
+ * The bit-parallel algorithm of Myers finds the substrings that end
+ * at a matching position in one pass over the haystack,
+ * only this substrings are compared with the needle prefixes.
+ * @param haystack Haystack
+ * @param haystack_len Haystack length
+ * @param pattern Pattern from mympd_search_fuzzy_compile
  * @return true on match, else false
  */
-bool mympd_search_fuzzy_match(const char *haystack, size_t haystack_len,
-        const char *needle, size_t needle_len)
+bool mympd_search_fuzzy_match_compiled(const char *haystack, size_t haystack_len,
+        struct t_search_fuzzy *pattern)
 {
-    if (needle_len <= 1) {
+    if (pattern->len <= 1) {
         return true;
     }
-    if (needle_len > haystack_len) {
+    if (pattern->len > haystack_len) {
         return false;
     }
-    if (strstr(haystack, needle) != NULL) {
+    if (strstr(haystack, pattern->needle) != NULL) {
         return true;
     }
-    const size_t max_distance = needle_len < 10
-        ? 1
-        : (needle_len / 10) + 1;
-    size_t *cache = calloc(needle_len + 1, sizeof(size_t));
-    const char *p = haystack;
-    while (*p != '\0' &&
-           haystack_len >= needle_len)
-    {
-        if (levenshtein(p, needle_len, needle, needle_len, cache, max_distance) <= max_distance) {
-            free(cache);
+    const unsigned char *p = (const unsigned char *)haystack;
+    for (size_t w = 0; w < pattern->words; w++) {
+        pattern->pv[w] = ~(uint64_t)0;
+        pattern->mv[w] = 0;
+    }
+    size_t score = pattern->len;
+    for (size_t i = 0; i < haystack_len; i++) {
+        // a match can start at each position of the haystack
+        score = score + advance_column(pattern, pattern->pv, pattern->mv, p[i], 0) - 1;
+        if (i + 1 >= pattern->len &&
+            match_column(pattern, pattern->pv, pattern->mv, score) == true &&
+            match_window(pattern, p + i + 1 - pattern->len) == true)
+        {
             return true;
         }
-        p++;
-        haystack_len--;
     }
-    free(cache);
     return false;
 }
 
 /**
- * Private functions
+ * Fuzzy substring matching for a single needle
+ * @param haystack Haystack
+ * @param haystack_len Haystack length
+ * @param needle Needle
+ * @param needle_len Needle length
+ * @return true on match, else false
  */
+bool mympd_search_fuzzy_match(const char *haystack, size_t haystack_len,
+        const char *needle, size_t needle_len)
+{
+    struct t_search_fuzzy *pattern = mympd_search_fuzzy_compile(needle, needle_len);
+    bool rc = mympd_search_fuzzy_match_compiled(haystack, haystack_len, pattern);
+    mympd_search_fuzzy_free(pattern);
+    return rc;
+}
 
 /**
- * Return the minimum of 3 integers
+ * Private functions
  */
-#define MIN3(a, b, c) ((a) < (b) ? ((a) < (c) ? (a) : (c)) : ((b) < (c) ? (b) : (c)))
 
 /**
- * Calculate the levenshtein distance
- * https://en.wikibooks.org/wiki/Algorithm_Implementation/Strings/Levenshtein_distance#C
- * @param a String 1
- * @param a_len Length of a
- * @param b String 2
- * @param b_len Length of b
- * @param cache Matrix cache
- * @param max_distance Return as soon as the calculated distance is smaller than this value
- * @return Calculated distance
+ * Checks the edit distances of the needle prefixes that can be within the maximum distance.
+ * Shorter prefixes differ too much in length from the compared substring.
+ * @param pattern Compiled pattern
+ * @param pv Positive vertical delta bits
+ * @param mv Negative vertical delta bits
+ * @param score Edit distance of the whole needle
+ * @return true if a needle prefix is within the maximum distance, else false
  */
-static size_t levenshtein(const char *a, size_t a_len, const char *b, size_t b_len,
-        size_t *cache, size_t max_distance)
-{
-    size_t a_idx;
-    size_t b_idx;
-    size_t lastdiag;
-    size_t olddiag;
-    for (a_idx = 1; a_idx <= a_len; a_idx++) {
-        cache[a_idx] = a_idx;
+static bool match_column(const struct t_search_fuzzy *pattern, const uint64_t *pv, const uint64_t *mv, size_t score) {
+    if (score <= pattern->max_distance) {
+        return true;
     }
-    for (b_idx = 1; b_idx <= b_len; b_idx++) {
-        cache[0] = b_idx;
-        for (a_idx = 1, lastdiag = b_idx - 1; a_idx <= a_len; a_idx++) {
-            olddiag = cache[a_idx];
-            cache[a_idx] = MIN3(cache[a_idx] + 1, cache[a_idx - 1] + 1, lastdiag + (a[a_idx - 1] == b[b_idx - 1] ? 0 : 1));
-            lastdiag = olddiag;
-            // Check if distance is too high to become lower equal the max distance value in the remaining iterations
-            if (cache[a_idx] > a_len - a_idx + max_distance) {
-                break;
-            }
+    for (size_t row = pattern->len - 1; row + pattern->max_distance >= pattern->len; row--) {
+        // distance of the prefix without this row
+        const uint64_t bit = (uint64_t)1 << (row % FUZZY_WORD_BITS);
+        if (pv[row / FUZZY_WORD_BITS] & bit) {
+            score--;
+        }
+        else if (mv[row / FUZZY_WORD_BITS] & bit) {
+            score++;
         }
-        // We do not require the minimum distance, a distance lower equal the max distance is good enough
-        if (cache[a_len] <= max_distance) {
-            //MYMPD_LOG_DEBUG(NULL, "levenshtein return early %lu/%lu: %.*s - %.*s", x, b_len, (int)a_len, a, (int)b_len, b);
-            return cache[a_len];
+        if (score <= pattern->max_distance) {
+            return true;
         }
     }
-    return cache[a_len];
+    return false;
+}
+
+/**
+ * Advances the matching state by one haystack character
+ * @param pattern Compiled pattern
+ * @param pv Positive vertical delta bits
+ * @param mv Negative vertical delta bits
+ * @param c Haystack character
+ * @param hin Horizontal delta of the first row,
+ *            0 if a match can start at each position, 1 for a fixed start
+ * @return Horizontal delta of the last row incremented by one (0, 1, 2)
+ */
+static size_t advance_column(const struct t_search_fuzzy *pattern, uint64_t *pv, uint64_t *mv, unsigned char c, int hin) {
+    const size_t last_word = pattern->words - 1;
+    const uint64_t last_bit = (uint64_t)1 << ((pattern->len - 1) % FUZZY_WORD_BITS);
+    const uint64_t *eq = &pattern->peq[(size_t)c * pattern->words];
+    for (size_t w = 0; w < last_word; w++) {
+        hin = advance_block(&pv[w], &mv[w], eq[w], hin, FUZZY_WORD_HIGH);
+    }
+    hin = advance_block(&pv[last_word], &mv[last_word], eq[last_word], hin, last_bit);
+    return (size_t)(hin + 1);
+}
+
+/**
+ * Compares a substring with the length of the needle with all needle prefixes
+ * @param pattern Compiled pattern
+ * @param window Substring of the haystack
+ * @return true if a needle prefix is within the maximum distance, else false
+ */
+static bool match_window(struct t_search_fuzzy *pattern, const unsigned char *window) {
+    for (size_t w = 0; w < pattern->words; w++) {
+        pattern->window_pv[w] = ~(uint64_t)0;
+        pattern->window_mv[w] = 0;
+    }
+    size_t score = pattern->len;
+    for (size_t i = 0; i < pattern->len; i++) {
+        score = score + advance_column(pattern, pattern->window_pv, pattern->window_mv, window[i], 1) - 1;
+    }
+    return match_column(pattern, pattern->window_pv, pattern->window_mv, score);
+}
+
+/**
+ * Advances one block of the matching state by one haystack character
+ * @param pv_block Positive vertical delta bits of the block
+ * @param mv_block Negative vertical delta bits of the block
+ * @param eq Match bits of the haystack character for this block
+ * @param hin Horizontal delta carried in from the block above (-1, 0, 1)
+ * @param last_bit Bit to read the horizontal delta carried out
+ * @return Horizontal delta at last_bit (-1, 0, 1)
+ */
+static int advance_block(uint64_t *pv_block, uint64_t *mv_block, uint64_t eq, int hin, uint64_t last_bit) {
+    const uint64_t pv = *pv_block;
+    const uint64_t mv = *mv_block;
+    const uint64_t hin_neg = hin < 0 ? 1U : 0U;
+    const uint64_t hin_pos = hin > 0 ? 1U : 0U;
+    uint64_t xv = eq | mv;
+    eq |= hin_neg;
+    uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+    uint64_t ph = mv | ~(xh | pv);
+    uint64_t mh = pv & xh;
+    int hout = 0;
+    if (ph & last_bit) {
+        hout = 1;
+    }
+    else if (mh & last_bit) {
+        hout = -1;
+    }
+    ph = (ph << 1) | hin_pos;
+    mh = (mh << 1) | hin_neg;
+    *pv_block = mh | ~(xv | ph);
+    *mv_block = ph & xv;
+    return hout;
 }
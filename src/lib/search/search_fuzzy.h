@@ -13,7 +13,27 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
+/**
+ * Compiled needle for the bit-parallel fuzzy matcher
+ */
+struct t_search_fuzzy {
+    char *needle;         //!< Needle
+    size_t len;           //!< Needle length
+    size_t max_distance;  //!< Maximum edit distance for a match
+    size_t words;         //!< Number of 64 bit words for the needle
+    uint64_t *peq;        //!< Match bit-vectors, words per byte value
+    uint64_t *pv;         //!< Matching state, positive vertical deltas
+    uint64_t *mv;         //!< Matching state, negative vertical deltas
+    uint64_t *window_pv;  //!< State for the comparison of a substring with the needle prefixes
+    uint64_t *window_mv;  //!< State for the comparison of a substring with the needle prefixes
+};
+
+struct t_search_fuzzy *mympd_search_fuzzy_compile(const char *needle, size_t needle_len);
+void mympd_search_fuzzy_free(struct t_search_fuzzy *pattern);
+bool mympd_search_fuzzy_match_compiled(const char *haystack, size_t haystack_len,
+        struct t_search_fuzzy *pattern);
 bool mympd_search_fuzzy_match(const char *haystack, size_t haystack_len,
         const char *needle, size_t needle_len);
 
@@ -16,12 +16,34 @@
 
 #include <string.h>
 
+/**
+ * Private definitions
+ */
+
+/**
+ * Start size of the JIT stack
+ */
+#define JIT_STACK_START (32 * 1024)
+
+/**
+ * Maximum size of the JIT stack
+ */
+#define JIT_STACK_MAX (512 * 1024)
+
+static bool pcre_jit_compile(struct t_search_pcre *re);
+static void log_pcre_error(const char *msg, int rc);
+
+/**
+ * Public functions
+ */
+
 /**
  * Compiles a string to regex code
  * @param regex_str regex string
- * @return regex code
+ * @param use_jit true = JIT compile the regex if supported, false = use the interpreter
+ * @return compiled regex or NULL on error
  */
-pcre2_code *mympd_search_pcre_compile(sds regex_str) {
+struct t_search_pcre *mympd_search_pcre_compile(sds regex_str, bool use_jit) {
     MYMPD_LOG_DEBUG(NULL, "Compiling regex: \"%s\"", regex_str);
     size_t new_len;
     char *regex_utf8 = utf8_wrap_casefold(regex_str, sdslen(regex_str), &new_len);
@@ -35,50 +57,140 @@ pcre2_code *mympd_search_pcre_compile(sds regex_str) {
         &erroroffset,          /* for error offset */
         NULL                   /* use default compile context */
     );
+    FREE_PTR(regex_utf8);
     if (re_compiled == NULL){
         //Compilation failed
         PCRE2_UCHAR buffer[256];
         pcre2_get_error_message(rc, buffer, sizeof(buffer));
         MYMPD_LOG_ERROR(NULL, "PCRE2 compilation failed at offset %lu: \"%s\"", (unsigned long)erroroffset, buffer);
+        return NULL;
     }
-    FREE_PTR(regex_utf8);
-    return re_compiled;
+    // we need only the information if the regex matches
+    pcre2_match_data *match_data = pcre2_match_data_create(1, NULL);
+    if (match_data == NULL) {
+        MYMPD_LOG_ERROR(NULL, "PCRE2 match data creation failed");
+        pcre2_code_free(re_compiled);
+        return NULL;
+    }
+    struct t_search_pcre *re = malloc_assert(sizeof(struct t_search_pcre));
+    re->code = re_compiled;
+    re->match_data = match_data;
+    re->match_context = NULL;
+    re->jit_stack = NULL;
+    re->jit = use_jit == true
+        ? pcre_jit_compile(re)
+        : false;
+    return re;
+}
+
+/**
+ * Frees the compiled regex
+ * @param re compiled regex, can be NULL
+ */
+void mympd_search_pcre_free(struct t_search_pcre *re) {
+    if (re == NULL) {
+        return;
+    }
+    pcre2_code_free(re->code);
+    pcre2_match_data_free(re->match_data);
+    if (re->match_context != NULL) {
+        pcre2_match_context_free(re->match_context);
+    }
+    if (re->jit_stack != NULL) {
+        pcre2_jit_stack_free(re->jit_stack);
+    }
+    FREE_PTR(re);
 }
 
 /**
  * Matches the regex against a string
- * @param re_compiled the compiled regex from compile_regex
  * @param value String value to match against
  * @param value_len Value length
+ * @param re the compiled regex from mympd_search_pcre_compile
  * @return true if regex matches else false
  */
-bool mympd_search_pcre_match(const char *value, size_t value_len, pcre2_code *re_compiled) {
-    if (re_compiled == NULL) {
+bool mympd_search_pcre_match(const char *value, size_t value_len, struct t_search_pcre *re) {
+    if (re == NULL) {
         return false;
     }
-    pcre2_match_data *match_data = pcre2_match_data_create_from_pattern(re_compiled, NULL);
-    int rc = pcre2_match(
-        re_compiled,          /* the compiled pattern */
-        (PCRE2_SPTR)value,    /* the subject string */
-        value_len,            /* the length of the subject */
-        0,                    /* start at offset 0 in the subject */
-        0,                    /* default options */
-        match_data,           /* block for storing the result */
-        NULL                  /* use default match context */
-    );
-    pcre2_match_data_free(match_data);
+    int rc;
+    if (re->jit == true) {
+        rc = pcre2_jit_match(
+            re->code,             /* the compiled pattern */
+            (PCRE2_SPTR)value,    /* the subject string */
+            value_len,            /* the length of the subject */
+            0,                    /* start at offset 0 in the subject */
+            0,                    /* default options */
+            re->match_data,       /* block for storing the result */
+            re->match_context     /* match context with the JIT stack */
+        );
+        if (rc == PCRE2_ERROR_JIT_STACKLIMIT) {
+            MYMPD_LOG_DEBUG(NULL, "PCRE2 JIT stack limit reached, using the interpreter");
+            rc = pcre2_match(re->code, (PCRE2_SPTR)value, value_len, 0, 0, re->match_data, NULL);
+        }
+    }
+    else {
+        rc = pcre2_match(
+            re->code,             /* the compiled pattern */
+            (PCRE2_SPTR)value,    /* the subject string */
+            value_len,            /* the length of the subject */
+            0,                    /* start at offset 0 in the subject */
+            0,                    /* default options */
+            re->match_data,       /* block for storing the result */
+            NULL                  /* use default match context */
+        );
+    }
     if (rc >= 0) {
         return true;
     }
     //Matching failed: handle error cases
-    switch(rc) {
-        case PCRE2_ERROR_NOMATCH: 
-            break;
-        default: {
-            PCRE2_UCHAR buffer[256];
-            pcre2_get_error_message(rc, buffer, sizeof(buffer));
-            MYMPD_LOG_ERROR(NULL, "PCRE2 matching error %d: \"%s\"", rc, buffer);
-        }
+    if (rc != PCRE2_ERROR_NOMATCH) {
+        log_pcre_error("PCRE2 matching error", rc);
     }
     return false;
 }
+
+/**
+ * Private functions
+ */
+
+/**
+ * JIT compiles the regex and creates the JIT stack
+ * @param re compiled regex
+ * @return true on success, false if JIT is not available
+ */
+static bool pcre_jit_compile(struct t_search_pcre *re) {
+    uint32_t jit_support = 0;
+    if (pcre2_config(PCRE2_CONFIG_JIT, &jit_support) < 0 ||
+        jit_support == 0)
+    {
+        MYMPD_LOG_DEBUG(NULL, "PCRE2 JIT is not supported");
+        return false;
+    }
+    int rc = pcre2_jit_compile(re->code, PCRE2_JIT_COMPLETE);
+    if (rc != 0) {
+        log_pcre_error("PCRE2 JIT compilation failed", rc);
+        return false;
+    }
+    re->jit_stack = pcre2_jit_stack_create(JIT_STACK_START, JIT_STACK_MAX, NULL);
+    re->match_context = pcre2_match_context_create(NULL);
+    if (re->jit_stack == NULL ||
+        re->match_context == NULL)
+    {
+        MYMPD_LOG_WARN(NULL, "Can not create the PCRE2 JIT stack");
+        return false;
+    }
+    pcre2_jit_stack_assign(re->match_context, NULL, re->jit_stack);
+    return true;
+}
+
+/**
+ * Logs a PCRE2 error
+ * @param msg message prefix
+ * @param rc PCRE2 error code
+ */
+static void log_pcre_error(const char *msg, int rc) {
+    PCRE2_UCHAR buffer[256];
+    pcre2_get_error_message(rc, buffer, sizeof(buffer));
+    MYMPD_LOG_ERROR(NULL, "%s %d: \"%s\"", msg, rc, buffer);
+}
@@ -21,7 +21,20 @@
 #include <pcre2.h>
 #include <stdbool.h>
 
-pcre2_code *mympd_search_pcre_compile(sds regex_str);
-bool mympd_search_pcre_match(const char *value, size_t value_len, pcre2_code *re_compiled);
+/**
+ * Compiled regex with its reusable match blocks.
+ * It is owned by a search expression and must be used only by one thread.
+ */
+struct t_search_pcre {
+    pcre2_code *code;                    //!< Compiled regex
+    pcre2_match_data *match_data;        //!< Reusable match data block
+    pcre2_match_context *match_context;  //!< Match context with the JIT stack, NULL if not JIT compiled
+    pcre2_jit_stack *jit_stack;          //!< JIT stack, NULL if not JIT compiled
+    bool jit;                            //!< true if the regex is JIT compiled
+};
+
+struct t_search_pcre *mympd_search_pcre_compile(sds regex_str, bool use_jit);
+void mympd_search_pcre_free(struct t_search_pcre *re);
+bool mympd_search_pcre_match(const char *value, size_t value_len, struct t_search_pcre *re);
 
 #endif
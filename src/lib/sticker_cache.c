@@ -0,0 +1,381 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2026 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+/*! \file
+ * \brief In-process cache for song stickers with pending writes
+ */
+
+#include "compile_time.h"
+#include "src/lib/sticker_cache.h"
+
+#include "src/lib/convert.h"
+#include "src/lib/mem.h"
+#include "src/lib/sds/sds_extras.h"
+
+#include <string.h>
+
+/**
+ * Private definitions
+ */
+
+/**
+ * Cached stickers of a song
+ */
+struct t_sticker_cache_entry {
+    struct t_sticker sticker;  //!< the stickers
+    unsigned present;          //!< bitmask of the myMPD stickers that are set
+};
+
+static struct t_sticker_cache_entry *get_entry(struct t_sticker_cache *cache, const char *uri, bool create);
+static sds get_pending_key(sds key, const char *uri, const char *name);
+static void free_entries(rax *songs);
+
+/**
+ * Public functions
+ */
+
+/**
+ * Initializes an empty and invalid sticker cache
+ * @param cache pointer to sticker cache
+ */
+void sticker_cache_init(struct t_sticker_cache *cache) {
+    cache->songs = raxNew();
+    cache->pending = raxNew();
+    cache->enabled = false;
+    cache->valid = false;
+    cache->user_defined = false;
+}
+
+/**
+ * Removes all cached stickers and invalidates the cache.
+ * Pending writes are preserved.
+ * @param cache pointer to sticker cache
+ */
+void sticker_cache_clear(struct t_sticker_cache *cache) {
+    free_entries(cache->songs);
+    cache->songs = raxNew();
+    cache->valid = false;
+    cache->user_defined = false;
+}
+
+/**
+ * Frees the cached stickers and the pending writes
+ * @param cache pointer to sticker cache
+ */
+void sticker_cache_free(struct t_sticker_cache *cache) {
+    sticker_cache_pending_clear(cache);
+    raxFree(cache->pending);
+    cache->pending = NULL;
+    free_entries(cache->songs);
+    cache->songs = NULL;
+    cache->valid = false;
+}
+
+/**
+ * Sets a sticker value
+ * @param cache pointer to sticker cache
+ * @param uri song uri
+ * @param name sticker name
+ * @param value sticker value
+ */
+void sticker_cache_set(struct t_sticker_cache *cache, const char *uri, const char *name, const char *value) {
+    enum mympd_sticker_names sticker_name = sticker_name_parse(name);
+    if (sticker_name != STICKER_UNKNOWN) {
+        int64_t num;
+        if (str2int64(&num, value) != STR2INT_SUCCESS) {
+            num = 0;
+        }
+        sticker_cache_set_int64(cache, uri, name, num);
+        return;
+    }
+    struct t_sticker_cache_entry *entry = get_entry(cache, uri, true);
+    struct t_list_node *node = list_get_node(&entry->sticker.user, name);
+    if (node != NULL) {
+        node->value_p = sds_replace(node->value_p, value);
+    }
+    else {
+        list_push(&entry->sticker.user, name, 0, value, NULL);
+    }
+}
+
+/**
+ * Sets a sticker number value
+ * @param cache pointer to sticker cache
+ * @param uri song uri
+ * @param name sticker name
+ * @param value sticker value
+ */
+void sticker_cache_set_int64(struct t_sticker_cache *cache, const char *uri, const char *name, int64_t value) {
+    enum mympd_sticker_names sticker_name = sticker_name_parse(name);
+    if (sticker_name == STICKER_UNKNOWN) {
+        sds value_str = sdsfromlonglong((long long)value);
+        sticker_cache_set(cache, uri, name, value_str);
+        FREE_SDS(value_str);
+        return;
+    }
+    struct t_sticker_cache_entry *entry = get_entry(cache, uri, true);
+    entry->sticker.mympd[sticker_name] = value;
+    entry->present |= 1U << sticker_name;
+}
+
+/**
+ * Increments a sticker number value
+ * @param cache pointer to sticker cache
+ * @param uri song uri
+ * @param name sticker name
+ * @param value value to add, can be negative
+ */
+void sticker_cache_inc(struct t_sticker_cache *cache, const char *uri, const char *name, int64_t value) {
+    int64_t current = 0;
+    sticker_cache_get_int64(cache, uri, name, &current);
+    sticker_cache_set_int64(cache, uri, name, current + value);
+}
+
+/**
+ * Removes a sticker
+ * @param cache pointer to sticker cache
+ * @param uri song uri
+ * @param name sticker name
+ */
+void sticker_cache_remove(struct t_sticker_cache *cache, const char *uri, const char *name) {
+    struct t_sticker_cache_entry *entry = get_entry(cache, uri, false);
+    if (entry == NULL) {
+        return;
+    }
+    enum mympd_sticker_names sticker_name = sticker_name_parse(name);
+    if (sticker_name != STICKER_UNKNOWN) {
+        // reset to the default value
+        entry->sticker.mympd[sticker_name] = sticker_name == STICKER_LIKE
+            ? STICKER_LIKE_NEUTRAL
+            : 0;
+        entry->present &= ~(1U << sticker_name);
+    }
+    else {
+        list_remove_node_by_key(&entry->sticker.user, name);
+    }
+}
+
+/**
+ * Gets all stickers of a song from the cache
+ * @param cache pointer to sticker cache
+ * @param uri song uri
+ * @param sticker pointer to t_sticker struct to initialize and populate
+ * @param user_defined get user defined stickers?
+ * @return true if the stickers were served from the cache, else false
+ */
+bool sticker_cache_get_all(struct t_sticker_cache *cache, const char *uri, struct t_sticker *sticker, bool user_defined) {
+    if (cache->valid == false ||
+        (user_defined == true && cache->user_defined == false))
+    {
+        return false;
+    }
+    sticker_struct_init(sticker);
+    struct t_sticker_cache_entry *entry = get_entry(cache, uri, false);
+    if (entry == NULL) {
+        return true;
+    }
+    memcpy(sticker->mympd, entry->sticker.mympd, sizeof(sticker->mympd));
+    if (user_defined == true) {
+        struct t_list_node *current = entry->sticker.user.head;
+        while (current != NULL) {
+            list_push(&sticker->user, current->key, 0, current->value_p, NULL);
+            current = current->next;
+        }
+    }
+    return true;
+}
+
+/**
+ * Gets a sticker value from the cache
+ * @param cache pointer to sticker cache
+ * @param uri song uri
+ * @param name sticker name
+ * @return newly allocated sds string, empty if the sticker is not set,
+ *         NULL if the sticker can not be served from the cache
+ */
+sds sticker_cache_get(struct t_sticker_cache *cache, const char *uri, const char *name) {
+    enum mympd_sticker_names sticker_name = sticker_name_parse(name);
+    if (cache->valid == false ||
+        (sticker_name == STICKER_UNKNOWN && cache->user_defined == false))
+    {
+        return NULL;
+    }
+    struct t_sticker_cache_entry *entry = get_entry(cache, uri, false);
+    if (entry == NULL) {
+        return sdsempty();
+    }
+    if (sticker_name != STICKER_UNKNOWN) {
+        return (entry->present & (1U << sticker_name)) != 0
+            ? sdsfromlonglong((long long)entry->sticker.mympd[sticker_name])
+            : sdsempty();
+    }
+    struct t_list_node *node = list_get_node(&entry->sticker.user, name);
+    return node != NULL
+        ? sdsdup(node->value_p)
+        : sdsempty();
+}
+
+/**
+ * Gets a sticker number value from the cache
+ * @param cache pointer to sticker cache
+ * @param uri song uri
+ * @param name sticker name
+ * @param value pointer to set the value, 0 if the sticker is not set
+ * @return true if the sticker was served from the cache, else false
+ */
+bool sticker_cache_get_int64(struct t_sticker_cache *cache, const char *uri, const char *name, int64_t *value) {
+    *value = 0;
+    sds value_str = sticker_cache_get(cache, uri, name);
+    if (value_str == NULL) {
+        return false;
+    }
+    str2int64(value, value_str);
+    FREE_SDS(value_str);
+    return true;
+}
+
+/**
+ * Queues a sticker write and applies it to the cache.
+ * Writes to the same sticker are coalesced.
+ * @param cache pointer to sticker cache
+ * @param uri song uri
+ * @param name sticker name
+ * @param value value to set or to increment
+ * @param inc true to increment the sticker, false to set it
+ */
+void sticker_cache_queue(struct t_sticker_cache *cache, const char *uri, const char *name, int64_t value, bool inc) {
+    if (inc == true) {
+        sticker_cache_inc(cache, uri, name, value);
+    }
+    else {
+        sticker_cache_set_int64(cache, uri, name, value);
+    }
+    sds key = get_pending_key(sdsempty(), uri, name);
+    void *data;
+    if (raxFind(cache->pending, (unsigned char *)key, sdslen(key), &data) == 1) {
+        struct t_sticker_cache_write *write = (struct t_sticker_cache_write *)data;
+        if (inc == true) {
+            // an increment keeps the type of the pending write
+            write->value += value;
+        }
+        else {
+            write->value = value;
+            write->inc = false;
+        }
+    }
+    else {
+        struct t_sticker_cache_write *write = malloc_assert(sizeof(struct t_sticker_cache_write));
+        write->uri = sdsnew(uri);
+        write->name = sdsnew(name);
+        write->value = value;
+        write->inc = inc;
+        raxInsert(cache->pending, (unsigned char *)key, sdslen(key), write, NULL);
+    }
+    FREE_SDS(key);
+}
+
+/**
+ * Removes all pending writes
+ * @param cache pointer to sticker cache
+ */
+void sticker_cache_pending_clear(struct t_sticker_cache *cache) {
+    raxIterator iter;
+    raxStart(&iter, cache->pending);
+    raxSeek(&iter, "^", NULL, 0);
+    while (raxNext(&iter)) {
+        struct t_sticker_cache_write *write = (struct t_sticker_cache_write *)iter.data;
+        FREE_SDS(write->uri);
+        FREE_SDS(write->name);
+        FREE_PTR(write);
+    }
+    raxStop(&iter);
+    raxFree(cache->pending);
+    cache->pending = raxNew();
+}
+
+/**
+ * Removes the first pending writes in key order,
+ * this is the order in that they are sent to MPD
+ * @param cache pointer to sticker cache
+ * @param count number of writes to remove
+ */
+void sticker_cache_pending_drop(struct t_sticker_cache *cache, size_t count) {
+    raxIterator iter;
+    raxStart(&iter, cache->pending);
+    while (count > 0) {
+        raxSeek(&iter, "^", NULL, 0);
+        if (raxNext(&iter) == 0) {
+            break;
+        }
+        struct t_sticker_cache_write *write = (struct t_sticker_cache_write *)iter.data;
+        raxRemove(cache->pending, iter.key, iter.key_len, NULL);
+        FREE_SDS(write->uri);
+        FREE_SDS(write->name);
+        FREE_PTR(write);
+        count--;
+    }
+    raxStop(&iter);
+}
+
+/**
+ * Private functions
+ */
+
+/**
+ * Gets the cache entry for a song
+ * @param cache pointer to sticker cache
+ * @param uri song uri
+ * @param create create a missing entry?
+ * @return the cache entry or NULL if not found
+ */
+static struct t_sticker_cache_entry *get_entry(struct t_sticker_cache *cache, const char *uri, bool create) {
+    void *data;
+    size_t uri_len = strlen(uri);
+    if (raxFind(cache->songs, (unsigned char *)uri, uri_len, &data) == 1) {
+        return (struct t_sticker_cache_entry *)data;
+    }
+    if (create == false) {
+        return NULL;
+    }
+    struct t_sticker_cache_entry *entry = malloc_assert(sizeof(struct t_sticker_cache_entry));
+    sticker_struct_init(&entry->sticker);
+    entry->present = 0;
+    raxInsert(cache->songs, (unsigned char *)uri, uri_len, entry, NULL);
+    return entry;
+}
+
+/**
+ * Creates the key for a pending write
+ * @param key sds string to append the key
+ * @param uri song uri
+ * @param name sticker name
+ * @return pointer to key
+ */
+static sds get_pending_key(sds key, const char *uri, const char *name) {
+    key = sdscat(key, uri);
+    key = sdscatlen(key, "\0", 1);
+    return sdscat(key, name);
+}
+
+/**
+ * Frees the song entries and the radix tree
+ * @param songs radix tree to free
+ */
+static void free_entries(rax *songs) {
+    if (songs == NULL) {
+        return;
+    }
+    raxIterator iter;
+    raxStart(&iter, songs);
+    raxSeek(&iter, "^", NULL, 0);
+    while (raxNext(&iter)) {
+        struct t_sticker_cache_entry *entry = (struct t_sticker_cache_entry *)iter.data;
+        list_clear(&entry->sticker.user);
+        FREE_PTR(entry);
+    }
+    raxStop(&iter);
+    raxFree(songs);
+}
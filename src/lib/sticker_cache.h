@@ -0,0 +1,60 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2026 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+/*! \file
+ * \brief In-process cache for song stickers with pending writes
+ */
+
+#ifndef MYMPD_STICKER_CACHE_H
+#define MYMPD_STICKER_CACHE_H
+
+#include "dist/rax/rax.h"
+#include "dist/sds/sds.h"
+#include "src/lib/sticker.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * A sticker write that is not yet sent to MPD
+ */
+struct t_sticker_cache_write {
+    sds uri;        //!< song uri
+    sds name;       //!< sticker name
+    int64_t value;  //!< value to set or to increment
+    bool inc;       //!< true to increment the sticker, false to set it
+};
+
+/**
+ * Song sticker cache
+ */
+struct t_sticker_cache {
+    rax *songs;         //!< uri -> struct t_sticker
+    rax *pending;       //!< uri + name -> struct t_sticker_cache_write
+    bool enabled;       //!< enables the cache for this stickerdb connection
+    bool valid;         //!< true if the cache is warm and coherent with MPD
+    bool user_defined;  //!< true if user defined stickers are cached
+};
+
+void sticker_cache_init(struct t_sticker_cache *cache);
+void sticker_cache_clear(struct t_sticker_cache *cache);
+void sticker_cache_free(struct t_sticker_cache *cache);
+
+void sticker_cache_set(struct t_sticker_cache *cache, const char *uri, const char *name, const char *value);
+void sticker_cache_set_int64(struct t_sticker_cache *cache, const char *uri, const char *name, int64_t value);
+void sticker_cache_inc(struct t_sticker_cache *cache, const char *uri, const char *name, int64_t value);
+void sticker_cache_remove(struct t_sticker_cache *cache, const char *uri, const char *name);
+
+bool sticker_cache_get_all(struct t_sticker_cache *cache, const char *uri, struct t_sticker *sticker, bool user_defined);
+sds sticker_cache_get(struct t_sticker_cache *cache, const char *uri, const char *name);
+bool sticker_cache_get_int64(struct t_sticker_cache *cache, const char *uri, const char *name, int64_t *value);
+
+void sticker_cache_queue(struct t_sticker_cache *cache, const char *uri, const char *name, int64_t value, bool inc);
+void sticker_cache_pending_clear(struct t_sticker_cache *cache);
+void sticker_cache_pending_drop(struct t_sticker_cache *cache, size_t count);
+
+#endif
@@ -0,0 +1,162 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2026 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+/*! \file
+ * \brief Interned pools of tag values and their normalized forms
+ *
+ * The album cache stores many identical tag values, e.g. artists and genres.
+ * The shared pool holds one reference counted copy of each value for all albums
+ * and all album caches that are alive at the same time.
+ * The pools created with str_pool_new hold the normalized forms of the values
+ * for the searches of one cache.
+ */
+
+#include "compile_time.h"
+#include "src/lib/str_pool.h"
+
+#include "src/lib/mem.h"
+#include "src/lib/rax_extras.h"
+#include "src/lib/utf8_wrapper.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Private definitions
+ */
+
+/**
+ * An interned string of the shared pool
+ */
+struct t_str_pool_value {
+    size_t refcount;  //!< number of references
+    size_t len;       //!< length of the string
+    char value[];     //!< the null terminated string
+};
+
+static pthread_mutex_t shared_lock = PTHREAD_MUTEX_INITIALIZER;  //!< guards the shared pool and the counters
+static rax *shared_values;    //!< interned strings by value, NULL if empty
+static size_t shared_bytes;   //!< bytes allocated for the strings
+static size_t shared_refs;    //!< number of references
+
+/**
+ * Public functions
+ */
+
+/**
+ * Creates a new empty string pool
+ * @return newly allocated string pool
+ */
+struct t_str_pool *str_pool_new(void) {
+    struct t_str_pool *pool = malloc_assert(sizeof(struct t_str_pool));
+    pool->values = raxNew();
+    pool->bytes = 0;
+    return pool;
+}
+
+/**
+ * Frees the string pool and all normalized strings
+ * @param pool pointer to string pool, can be NULL
+ */
+void str_pool_free(struct t_str_pool *pool) {
+    if (pool == NULL) {
+        return;
+    }
+    rax_free_sds_data(pool->values);
+    FREE_PTR(pool);
+}
+
+/**
+ * Gets the normalized and casefolded form of value from the pool.
+ * The value is normalized and added to the pool if it is not already there.
+ * @param pool pointer to string pool
+ * @param value string to normalize
+ * @param len length of value
+ * @return normalized string, owned by the pool
+ */
+sds str_pool_get_normalized(struct t_str_pool *pool, const char *value, size_t len) {
+    void *data;
+    if (raxFind(pool->values, (unsigned char *)value, len, &data) == 1) {
+        return (sds)data;
+    }
+    size_t norm_len;
+    char *norm = utf8_wrap_normalize(value, len, &norm_len);
+    sds norm_sds = sdsnewlen(norm, norm_len);
+    FREE_PTR(norm);
+    raxInsert(pool->values, (unsigned char *)value, len, norm_sds, NULL);
+    pool->bytes += sdsAllocSize(norm_sds);
+    return norm_sds;
+}
+
+/**
+ * Gets the interned copy of a string from the shared pool and increments its reference count.
+ * Each call must be paired with a call to str_pool_release.
+ * @param value string to intern
+ * @param len length of value
+ * @return the interned string, it is valid until the last reference is released
+ */
+const char *str_pool_intern(const char *value, size_t len) {
+    pthread_mutex_lock(&shared_lock);
+    if (shared_values == NULL) {
+        shared_values = raxNew();
+    }
+    void *data;
+    struct t_str_pool_value *interned;
+    if (raxFind(shared_values, (unsigned char *)value, len, &data) == 1) {
+        interned = (struct t_str_pool_value *)data;
+    }
+    else {
+        size_t size = sizeof(struct t_str_pool_value) + len + 1;
+        interned = malloc_assert(size);
+        interned->refcount = 0;
+        interned->len = len;
+        memcpy(interned->value, value, len);
+        interned->value[len] = '\0';
+        raxInsert(shared_values, (unsigned char *)value, len, interned, NULL);
+        shared_bytes += size;
+    }
+    interned->refcount++;
+    shared_refs++;
+    pthread_mutex_unlock(&shared_lock);
+    return interned->value;
+}
+
+/**
+ * Releases a reference to an interned string.
+ * The string is freed if this was the last reference.
+ * @param value string returned by str_pool_intern
+ */
+void str_pool_release(const char *value) {
+    struct t_str_pool_value *interned = (struct t_str_pool_value *)(void *)
+        (value - offsetof(struct t_str_pool_value, value));
+    pthread_mutex_lock(&shared_lock);
+    shared_refs--;
+    if (--interned->refcount == 0) {
+        raxRemove(shared_values, (unsigned char *)interned->value, interned->len, NULL);
+        shared_bytes -= sizeof(struct t_str_pool_value) + interned->len + 1;
+        FREE_PTR(interned);
+        if (shared_values->numele == 0) {
+            raxFree(shared_values);
+            shared_values = NULL;
+        }
+    }
+    pthread_mutex_unlock(&shared_lock);
+}
+
+/**
+ * Gets the usage statistics of the shared pool
+ * @param stats pointer to struct to populate
+ */
+void str_pool_get_stats(struct t_str_pool_stats *stats) {
+    pthread_mutex_lock(&shared_lock);
+    stats->values = shared_values != NULL
+        ? (unsigned)shared_values->numele
+        : 0;
+    stats->bytes = shared_bytes;
+    stats->refs = shared_refs;
+    pthread_mutex_unlock(&shared_lock);
+}
@@ -0,0 +1,46 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2026 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+/*! \file
+ * \brief Interned pools of tag values and their normalized forms
+ */
+
+#ifndef MYMPD_STR_POOL_H
+#define MYMPD_STR_POOL_H
+
+#include "dist/rax/rax.h"
+#include "dist/sds/sds.h"
+
+#include <stddef.h>
+
+/**
+ * Pool of normalized and casefolded strings.
+ * Each distinct source string is normalized only once, all users
+ * of the same source string share the normalized copy.
+ */
+struct t_str_pool {
+    rax *values;   //!< source string -> normalized sds string
+    size_t bytes;  //!< bytes allocated for the normalized strings
+};
+
+/**
+ * Usage statistics of the shared pool of interned strings
+ */
+struct t_str_pool_stats {
+    unsigned values;  //!< number of distinct strings
+    size_t bytes;     //!< bytes allocated for the strings
+    size_t refs;      //!< number of references to the strings
+};
+
+struct t_str_pool *str_pool_new(void);
+void str_pool_free(struct t_str_pool *pool);
+sds str_pool_get_normalized(struct t_str_pool *pool, const char *value, size_t len);
+
+const char *str_pool_intern(const char *value, size_t len);
+void str_pool_release(const char *value);
+void str_pool_get_stats(struct t_str_pool_stats *stats);
+
+#endif
@@ -0,0 +1,241 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2026 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+/*! \file
+ * \brief In-memory cache of the MPD tag values for the tag list
+ */
+
+#include "compile_time.h"
+#include "src/lib/tag_value_cache.h"
+
+#include "src/lib/mem.h"
+#include "src/lib/sds/sds_extras.h"
+#include "src/lib/sds/sds_utf8.h"
+#include "src/lib/utf8_wrapper.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Private definitions
+ */
+
+static int tag_value_cmp(const void *a, const void *b);
+static unsigned lower_bound(const struct t_tag_values *values, const char *key);
+static unsigned upper_bound(const struct t_tag_values *values, const char *key);
+
+/**
+ * Public functions
+ */
+
+/**
+ * Initializes an empty tag value cache
+ * @param cache pointer to the tag value cache
+ */
+void tag_value_cache_init(struct t_tag_value_cache *cache) {
+    for (unsigned i = 0; i < MPD_TAG_COUNT; i++) {
+        struct t_tag_values *values = &cache->tags[i];
+        values->values = NULL;
+        values->length = 0;
+        values->size = 0;
+        values->valid = false;
+    }
+}
+
+/**
+ * Frees the values of all tags and invalidates the cache
+ * @param cache pointer to the tag value cache
+ */
+void tag_value_cache_clear(struct t_tag_value_cache *cache) {
+    for (unsigned i = 0; i < MPD_TAG_COUNT; i++) {
+        tag_values_clear(&cache->tags[i]);
+    }
+}
+
+/**
+ * Gets the values of a tag
+ * @param cache pointer to the tag value cache
+ * @param tag mpd tag type
+ * @return pointer to the values, check the valid flag before using them,
+ *         NULL for an invalid tag type
+ */
+struct t_tag_values *tag_value_cache_get(struct t_tag_value_cache *cache, enum mpd_tag_type tag) {
+    if (tag <= MPD_TAG_UNKNOWN ||
+        tag >= MPD_TAG_COUNT)
+    {
+        return NULL;
+    }
+    return &cache->tags[tag];
+}
+
+/**
+ * Frees the values of a tag and invalidates them
+ * @param values pointer to the tag values
+ */
+void tag_values_clear(struct t_tag_values *values) {
+    for (unsigned i = 0; i < values->length; i++) {
+        FREE_SDS(values->values[i].key);
+        FREE_SDS(values->values[i].value);
+    }
+    FREE_PTR(values->values);
+    values->length = 0;
+    values->size = 0;
+    values->valid = false;
+}
+
+/**
+ * Appends a value while populating the tag values
+ * @param values pointer to the tag values
+ * @param value tag value to append
+ */
+void tag_values_append(struct t_tag_values *values, const char *value) {
+    if (values->length == values->size) {
+        values->size = values->size == 0
+            ? 256
+            : values->size * 2;
+        values->values = realloc_assert(values->values, values->size * sizeof(struct t_tag_value));
+    }
+    struct t_tag_value *entry = &values->values[values->length];
+    entry->value = sdsnew(value);
+    entry->key = sds_utf8_normalize(sdsdup(entry->value));
+    values->length++;
+}
+
+/**
+ * Sorts the appended values and marks them as valid.
+ * Values with the same normalized key, e.g. "Rock" and "rock", are not collapsed.
+ * They are distinct values in MPD and each one is needed to filter its songs,
+ * the count of all values is reported as totalEntities like before the cache.
+ * @param values pointer to the tag values
+ */
+void tag_values_commit(struct t_tag_values *values) {
+    if (values->length > 1) {
+        qsort(values->values, values->length, sizeof(struct t_tag_value), tag_value_cmp);
+    }
+    values->valid = true;
+}
+
+/**
+ * Gets a page of the values matching the search string.
+ * Search strings with up to two characters must match the whole value,
+ * longer search strings must be a substring of the value.
+ * @param values pointer to the tag values
+ * @param searchstr string to search, it is normalized before matching
+ * @param searchstr_len length of searchstr
+ * @param sortdesc true to sort descending, false to sort ascending
+ * @param offset offset of the page
+ * @param limit max number of values in the page
+ * @param page array of at least limit elements, set to the indexes of the returned values
+ * @param returned pointer to set the number of returned values
+ * @return total number of matching values
+ */
+unsigned tag_values_page(const struct t_tag_values *values, const char *searchstr, size_t searchstr_len,
+        bool sortdesc, unsigned offset, unsigned limit, unsigned *page, unsigned *returned)
+{
+    *returned = 0;
+    unsigned first = 0;
+    unsigned last = values->length;
+    char *search = NULL;
+    if (searchstr_len > 0) {
+        size_t search_len;
+        search = utf8_wrap_normalize(searchstr, searchstr_len, &search_len);
+        if (search_len <= 2) {
+            if (search_len > 0) {
+                // exact matches are adjacent in the sorted values
+                first = lower_bound(values, search);
+                last = upper_bound(values, search);
+            }
+            FREE_PTR(search);
+        }
+    }
+    if (search == NULL) {
+        unsigned total = last - first;
+        for (unsigned pos = offset; pos < total && *returned < limit; pos++) {
+            page[(*returned)++] = sortdesc == false
+                ? first + pos
+                : last - 1 - pos;
+        }
+        return total;
+    }
+    unsigned total = 0;
+    for (unsigned i = 0; i < values->length; i++) {
+        unsigned idx = sortdesc == false
+            ? i
+            : values->length - 1 - i;
+        if (strstr(values->values[idx].key, search) == NULL) {
+            continue;
+        }
+        if (total >= offset &&
+            *returned < limit)
+        {
+            page[(*returned)++] = idx;
+        }
+        total++;
+    }
+    FREE_PTR(search);
+    return total;
+}
+
+/**
+ * Private functions
+ */
+
+/**
+ * Compares two tag values by the normalized key and then by the value
+ * @param a first tag value
+ * @param b second tag value
+ * @return result of the string comparison
+ */
+static int tag_value_cmp(const void *a, const void *b) {
+    const struct t_tag_value *value1 = (const struct t_tag_value *)a;
+    const struct t_tag_value *value2 = (const struct t_tag_value *)b;
+    int rc = strcmp(value1->key, value2->key);
+    return rc != 0
+        ? rc
+        : strcmp(value1->value, value2->value);
+}
+
+/**
+ * Finds the first value with a key not less than key
+ * @param values pointer to the sorted tag values
+ * @param key normalized key
+ * @return index of the value
+ */
+static unsigned lower_bound(const struct t_tag_values *values, const char *key) {
+    unsigned low = 0;
+    unsigned high = values->length;
+    while (low < high) {
+        unsigned mid = low + (high - low) / 2;
+        if (strcmp(values->values[mid].key, key) < 0) {
+            low = mid + 1;
+        }
+        else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+/**
+ * Finds the first value with a key greater than key
+ * @param values pointer to the sorted tag values
+ * @param key normalized key
+ * @return index of the value
+ */
+static unsigned upper_bound(const struct t_tag_values *values, const char *key) {
+    unsigned low = 0;
+    unsigned high = values->length;
+    while (low < high) {
+        unsigned mid = low + (high - low) / 2;
+        if (strcmp(values->values[mid].key, key) <= 0) {
+            low = mid + 1;
+        }
+        else {
+            high = mid;
+        }
+    }
+    return low;
+}
@@ -0,0 +1,54 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2026 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+/*! \file
+ * \brief In-memory cache of the MPD tag values for the tag list
+ */
+
+#ifndef MYMPD_TAG_VALUE_CACHE_H
+#define MYMPD_TAG_VALUE_CACHE_H
+
+#include "dist/sds/sds.h"
+#include "src/lib/mpdclient.h"
+
+#include <stdbool.h>
+
+/**
+ * Tag value with its normalized form
+ */
+struct t_tag_value {
+    sds key;    //!< normalized value for sorting and filtering
+    sds value;  //!< value to display
+};
+
+/**
+ * Values of one tag, sorted by the normalized key
+ */
+struct t_tag_values {
+    struct t_tag_value *values;  //!< the values
+    unsigned length;             //!< number of values
+    unsigned size;               //!< allocated number of values
+    bool valid;                  //!< true if the values are in sync with the MPD database
+};
+
+/**
+ * Tag values of all tags, populated on demand
+ */
+struct t_tag_value_cache {
+    struct t_tag_values tags[MPD_TAG_COUNT];  //!< values by mpd tag type
+};
+
+void tag_value_cache_init(struct t_tag_value_cache *cache);
+void tag_value_cache_clear(struct t_tag_value_cache *cache);
+struct t_tag_values *tag_value_cache_get(struct t_tag_value_cache *cache, enum mpd_tag_type tag);
+
+void tag_values_clear(struct t_tag_values *values);
+void tag_values_append(struct t_tag_values *values, const char *value);
+void tag_values_commit(struct t_tag_values *values);
+unsigned tag_values_page(const struct t_tag_values *values, const char *searchstr, size_t searchstr_len,
+        bool sortdesc, unsigned offset, unsigned limit, unsigned *page, unsigned *returned);
+
+#endif
@@ -0,0 +1,394 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2026 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+/*! \file
+ * \brief Thumbnail creation for jpeg and png images
+ *
+ * Images are decoded once to rgb and can then be encoded to multiple
+ * jpeg thumbnails with different sizes.
+ */
+
+#include "compile_time.h"
+#include "src/lib/thumbnail.h"
+
+#include "src/lib/log.h"
+#include "src/lib/mem.h"
+
+#include <stdio.h>  // must be included before jpeglib.h
+#include <jpeglib.h>
+#include <png.h>
+#include <setjmp.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * Private definitions
+ */
+
+/**
+ * Libjpeg error manager that returns control to the caller
+ */
+struct t_jpeg_error {
+    struct jpeg_error_mgr pub;  //!< libjpeg error manager
+    jmp_buf jmp;                //!< jump buffer to return on errors
+};
+
+/**
+ * Libjpeg destination manager that appends to a sds string
+ */
+struct t_jpeg_dest {
+    struct jpeg_destination_mgr pub;  //!< libjpeg destination manager
+    sds *jpeg;                        //!< pointer to sds string to append
+    JOCTET buffer[4096];              //!< output buffer
+};
+
+static bool decode_jpeg(const char *data, size_t len, unsigned min_size, struct t_thumbnail_image *image);
+static bool decode_png(const char *data, size_t len, struct t_thumbnail_image *image);
+static bool encode_jpeg(const struct t_thumbnail_image *image, sds *jpeg);
+static void resize_box(const struct t_thumbnail_image *src, struct t_thumbnail_image *dst);
+static void jpeg_dest_init(j_compress_ptr cinfo);
+static boolean jpeg_dest_empty(j_compress_ptr cinfo);
+static void jpeg_dest_term(j_compress_ptr cinfo);
+static void jpeg_error_exit(j_common_ptr cinfo);
+static void jpeg_output_message(j_common_ptr cinfo);
+
+/**
+ * Public functions
+ */
+
+/**
+ * Decodes a jpeg or png image to rgb pixels.
+ * Jpeg images are downscaled while decoding as long as
+ * the longer side stays greater or equal than min_size.
+ * @param data image data
+ * @param len length of the image data
+ * @param min_size minimum size of the longer side for downscaling while decoding
+ * @param image pointer to image struct to populate
+ * @return true on success, else false
+ */
+bool thumbnail_decode(const char *data, size_t len, unsigned min_size, struct t_thumbnail_image *image) {
+    image->pixels = NULL;
+    image->width = 0;
+    image->height = 0;
+    if (len > 3 &&
+        (unsigned char)data[0] == 0xFF &&
+        (unsigned char)data[1] == 0xD8 &&
+        (unsigned char)data[2] == 0xFF)
+    {
+        return decode_jpeg(data, len, min_size, image);
+    }
+    if (len > 8 &&
+        memcmp(data, "\x89PNG\r\n\x1a\n", 8) == 0)
+    {
+        return decode_png(data, len, image);
+    }
+    MYMPD_LOG_DEBUG(NULL, "Unsupported image format for thumbnail");
+    return false;
+}
+
+/**
+ * Resizes the image to fit into max_size and encodes it as jpeg.
+ * Images are not upscaled.
+ * @param image decoded image
+ * @param max_size maximum width and height of the thumbnail
+ * @param jpeg pointer to already allocated sds string to append the jpeg
+ * @return true on success, else false
+ */
+bool thumbnail_encode(const struct t_thumbnail_image *image, unsigned max_size, sds *jpeg) {
+    struct t_thumbnail_image resized = {
+        .pixels = NULL,
+        .width = image->width,
+        .height = image->height
+    };
+    const struct t_thumbnail_image *src = image;
+    if (image->width > max_size ||
+        image->height > max_size)
+    {
+        if (image->width >= image->height) {
+            resized.width = max_size;
+            resized.height = (unsigned)(((uint64_t)image->height * max_size + image->width / 2) / image->width);
+        }
+        else {
+            resized.height = max_size;
+            resized.width = (unsigned)(((uint64_t)image->width * max_size + image->height / 2) / image->height);
+        }
+        if (resized.width == 0) {
+            resized.width = 1;
+        }
+        if (resized.height == 0) {
+            resized.height = 1;
+        }
+        resize_box(image, &resized);
+        src = &resized;
+    }
+
+    bool rc = encode_jpeg(src, jpeg);
+    FREE_PTR(resized.pixels);
+    return rc;
+}
+
+/**
+ * Frees the pixel data of a decoded image
+ * @param image pointer to image struct
+ */
+void thumbnail_image_clear(struct t_thumbnail_image *image) {
+    FREE_PTR(image->pixels);
+    image->width = 0;
+    image->height = 0;
+}
+
+/**
+ * Private functions
+ */
+
+/**
+ * Decodes a jpeg image using the dct scaling of libjpeg
+ * @param data image data
+ * @param len length of the image data
+ * @param min_size minimum size of the longer side for downscaling while decoding
+ * @param image pointer to image struct to populate
+ * @return true on success, else false
+ */
+static bool decode_jpeg(const char *data, size_t len, unsigned min_size, struct t_thumbnail_image *image) {
+    struct jpeg_decompress_struct cinfo;
+    struct t_jpeg_error jerr;
+    unsigned char *volatile row = NULL;
+    cinfo.err = jpeg_std_error(&jerr.pub);
+    jerr.pub.error_exit = jpeg_error_exit;
+    jerr.pub.output_message = jpeg_output_message;
+    if (setjmp(jerr.jmp)) {
+        jpeg_destroy_decompress(&cinfo);
+        free(row);
+        thumbnail_image_clear(image);
+        return false;
+    }
+    jpeg_create_decompress(&cinfo);
+    jpeg_mem_src(&cinfo, (const unsigned char *)data, (unsigned long)len);
+    jpeg_read_header(&cinfo, TRUE);
+    if ((uint64_t)cinfo.image_width * cinfo.image_height > THUMBNAIL_MAX_PIXELS) {
+        MYMPD_LOG_WARN(NULL, "Jpeg image is too large for thumbnailing");
+        jpeg_destroy_decompress(&cinfo);
+        return false;
+    }
+    if (cinfo.jpeg_color_space == JCS_CMYK ||
+        cinfo.jpeg_color_space == JCS_YCCK)
+    {
+        MYMPD_LOG_DEBUG(NULL, "Cmyk jpeg images are not thumbnailed");
+        jpeg_destroy_decompress(&cinfo);
+        return false;
+    }
+    cinfo.out_color_space = cinfo.num_components == 1
+        ? JCS_GRAYSCALE
+        : JCS_RGB;
+    unsigned longer = cinfo.image_width > cinfo.image_height
+        ? cinfo.image_width
+        : cinfo.image_height;
+    cinfo.scale_num = 1;
+    cinfo.scale_denom = 1;
+    while (cinfo.scale_denom < 8 &&
+           longer / (cinfo.scale_denom * 2) >= min_size)
+    {
+        cinfo.scale_denom *= 2;
+    }
+    jpeg_start_decompress(&cinfo);
+    image->width = cinfo.output_width;
+    image->height = cinfo.output_height;
+    image->pixels = malloc_assert((size_t)image->width * image->height * 3);
+    size_t stride = (size_t)image->width * 3;
+    row = malloc_assert((size_t)image->width * (size_t)cinfo.output_components);
+    JSAMPROW rows[1] = {row};
+    while (cinfo.output_scanline < cinfo.output_height) {
+        unsigned char *dst = image->pixels + cinfo.output_scanline * stride;
+        jpeg_read_scanlines(&cinfo, rows, 1);
+        if (cinfo.output_components == 1) {
+            for (unsigned x = 0; x < image->width; x++) {
+                dst[x * 3] = dst[x * 3 + 1] = dst[x * 3 + 2] = row[x];
+            }
+        }
+        else {
+            memcpy(dst, row, stride);
+        }
+    }
+    free(row);
+    jpeg_finish_decompress(&cinfo);
+    jpeg_destroy_decompress(&cinfo);
+    return true;
+}
+
+/**
+ * Encodes an image as jpeg
+ * @param image image to encode
+ * @param jpeg pointer to already allocated sds string to append the jpeg
+ * @return true on success, else false
+ */
+static bool encode_jpeg(const struct t_thumbnail_image *image, sds *jpeg) {
+    struct jpeg_compress_struct cinfo;
+    struct t_jpeg_error jerr;
+    struct t_jpeg_dest dest = {
+        .pub = {
+            .init_destination = jpeg_dest_init,
+            .empty_output_buffer = jpeg_dest_empty,
+            .term_destination = jpeg_dest_term
+        },
+        .jpeg = jpeg
+    };
+    size_t jpeg_len = sdslen(*jpeg);
+    cinfo.err = jpeg_std_error(&jerr.pub);
+    jerr.pub.error_exit = jpeg_error_exit;
+    jerr.pub.output_message = jpeg_output_message;
+    if (setjmp(jerr.jmp)) {
+        jpeg_destroy_compress(&cinfo);
+        sdssubstr(*jpeg, 0, jpeg_len);
+        return false;
+    }
+    jpeg_create_compress(&cinfo);
+    cinfo.dest = &dest.pub;
+    cinfo.image_width = image->width;
+    cinfo.image_height = image->height;
+    cinfo.input_components = 3;
+    cinfo.in_color_space = JCS_RGB;
+    jpeg_set_defaults(&cinfo);
+    jpeg_set_quality(&cinfo, THUMBNAIL_JPEG_QUALITY, TRUE);
+    jpeg_start_compress(&cinfo, TRUE);
+    size_t stride = (size_t)image->width * 3;
+    while (cinfo.next_scanline < cinfo.image_height) {
+        JSAMPROW row = image->pixels + cinfo.next_scanline * stride;
+        jpeg_write_scanlines(&cinfo, &row, 1);
+    }
+    jpeg_finish_compress(&cinfo);
+    jpeg_destroy_compress(&cinfo);
+    return true;
+}
+
+/**
+ * Decodes a png image with the simplified libpng api,
+ * transparent pixels are composed on white background.
+ * @param data image data
+ * @param len length of the image data
+ * @param image pointer to image struct to populate
+ * @return true on success, else false
+ */
+static bool decode_png(const char *data, size_t len, struct t_thumbnail_image *image) {
+    png_image png;
+    memset(&png, 0, sizeof(png));
+    png.version = PNG_IMAGE_VERSION;
+    if (png_image_begin_read_from_memory(&png, data, len) == 0) {
+        MYMPD_LOG_WARN(NULL, "Failed to read png image: %s", png.message);
+        return false;
+    }
+    if ((uint64_t)png.width * png.height > THUMBNAIL_MAX_PIXELS) {
+        MYMPD_LOG_WARN(NULL, "Png image is too large for thumbnailing");
+        png_image_free(&png);
+        return false;
+    }
+    png.format = PNG_FORMAT_RGB;
+    image->width = png.width;
+    image->height = png.height;
+    image->pixels = malloc_assert(PNG_IMAGE_SIZE(png));
+    png_color background = {
+        .red = 255,
+        .green = 255,
+        .blue = 255
+    };
+    if (png_image_finish_read(&png, &background, image->pixels, 0, NULL) == 0) {
+        MYMPD_LOG_WARN(NULL, "Failed to decode png image: %s", png.message);
+        png_image_free(&png);
+        thumbnail_image_clear(image);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Downscales an image by averaging all source pixels covered by a destination pixel
+ * @param src source image
+ * @param dst destination image with width and height set, pixels are allocated
+ */
+static void resize_box(const struct t_thumbnail_image *src, struct t_thumbnail_image *dst) {
+    dst->pixels = malloc_assert((size_t)dst->width * dst->height * 3);
+    size_t src_stride = (size_t)src->width * 3;
+    unsigned char *out = dst->pixels;
+    for (unsigned oy = 0; oy < dst->height; oy++) {
+        unsigned y0 = (unsigned)((uint64_t)oy * src->height / dst->height);
+        unsigned y1 = (unsigned)((uint64_t)(oy + 1) * src->height / dst->height);
+        if (y1 == y0) {
+            y1 = y0 + 1;
+        }
+        for (unsigned ox = 0; ox < dst->width; ox++) {
+            unsigned x0 = (unsigned)((uint64_t)ox * src->width / dst->width);
+            unsigned x1 = (unsigned)((uint64_t)(ox + 1) * src->width / dst->width);
+            if (x1 == x0) {
+                x1 = x0 + 1;
+            }
+            unsigned sum[3] = {0, 0, 0};
+            for (unsigned y = y0; y < y1; y++) {
+                const unsigned char *p = src->pixels + y * src_stride + (size_t)x0 * 3;
+                for (unsigned x = x0; x < x1; x++) {
+                    sum[0] += p[0];
+                    sum[1] += p[1];
+                    sum[2] += p[2];
+                    p += 3;
+                }
+            }
+            unsigned count = (y1 - y0) * (x1 - x0);
+            *out++ = (unsigned char)((sum[0] + count / 2) / count);
+            *out++ = (unsigned char)((sum[1] + count / 2) / count);
+            *out++ = (unsigned char)((sum[2] + count / 2) / count);
+        }
+    }
+}
+
+/**
+ * Initializes the libjpeg destination manager
+ * @param cinfo libjpeg compress struct
+ */
+static void jpeg_dest_init(j_compress_ptr cinfo) {
+    struct t_jpeg_dest *dest = (struct t_jpeg_dest *)cinfo->dest;
+    dest->pub.next_output_byte = dest->buffer;
+    dest->pub.free_in_buffer = sizeof(dest->buffer);
+}
+
+/**
+ * Appends the full output buffer to the sds string
+ * @param cinfo libjpeg compress struct
+ * @return TRUE
+ */
+static boolean jpeg_dest_empty(j_compress_ptr cinfo) {
+    struct t_jpeg_dest *dest = (struct t_jpeg_dest *)cinfo->dest;
+    *dest->jpeg = sdscatlen(*dest->jpeg, dest->buffer, sizeof(dest->buffer));
+    dest->pub.next_output_byte = dest->buffer;
+    dest->pub.free_in_buffer = sizeof(dest->buffer);
+    return TRUE;
+}
+
+/**
+ * Appends the remaining output buffer to the sds string
+ * @param cinfo libjpeg compress struct
+ */
+static void jpeg_dest_term(j_compress_ptr cinfo) {
+    struct t_jpeg_dest *dest = (struct t_jpeg_dest *)cinfo->dest;
+    *dest->jpeg = sdscatlen(*dest->jpeg, dest->buffer, sizeof(dest->buffer) - dest->pub.free_in_buffer);
+}
+
+/**
+ * Libjpeg error handler, jumps back to the caller
+ * @param cinfo libjpeg common struct
+ */
+static void jpeg_error_exit(j_common_ptr cinfo) {
+    (*cinfo->err->output_message)(cinfo);
+    struct t_jpeg_error *jerr = (struct t_jpeg_error *)cinfo->err;
+    longjmp(jerr->jmp, 1);
+}
+
+/**
+ * Logs libjpeg messages
+ * @param cinfo libjpeg common struct
+ */
+static void jpeg_output_message(j_common_ptr cinfo) {
+    char buffer[JMSG_LENGTH_MAX];
+    (*cinfo->err->format_message)(cinfo, buffer);
+    MYMPD_LOG_WARN(NULL, "Libjpeg: %s", buffer);
+}
@@ -0,0 +1,32 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2026 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+/*! \file
+ * \brief Thumbnail creation for jpeg and png images
+ */
+
+#ifndef MYMPD_LIB_THUMBNAIL_H
+#define MYMPD_LIB_THUMBNAIL_H
+
+#include "dist/sds/sds.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * A decoded image with 8 bit rgb pixels
+ */
+struct t_thumbnail_image {
+    unsigned char *pixels;  //!< rgb pixel data, 3 bytes per pixel
+    unsigned width;         //!< image width
+    unsigned height;        //!< image height
+};
+
+bool thumbnail_decode(const char *data, size_t len, unsigned min_size, struct t_thumbnail_image *image);
+bool thumbnail_encode(const struct t_thumbnail_image *image, unsigned max_size, sds *jpeg);
+void thumbnail_image_clear(struct t_thumbnail_image *image);
+
+#endif
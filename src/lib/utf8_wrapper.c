@@ -12,6 +12,7 @@
 #include "src/lib/utf8_wrapper.h"
 
 #include <assert.h>
+#include <limits.h>
 #include <stdbool.h>
 #include <string.h>
 
@@ -188,3 +189,47 @@ int utf8_wrap_casecmp(const char *str1, size_t str1_len, const char *str2, size_
         return strcasecmp(str1, str2);
     #endif
 }
+
+/**
+ * Lowercases the string codepoint by codepoint.
+ * Comparing the results bytewise gives the same order as utf8_wrap_casecmp.
+ * Invalid utf8 sequences are copied unchanged.
+ * @param str String to lowercase
+ * @param len String length
+ * @param dst Destination buffer, must have room for UTF8_TOLOWER_MAX_LEN(len) bytes
+ * @return Number of bytes written to dst
+ */
+size_t utf8_wrap_tolower(const char *str, size_t len, char *dst) {
+    assert(str);
+    assert(len < INT_MAX);
+    #ifdef MYMPD_ENABLE_UTF8
+        const utf8proc_uint8_t *utf8_str = (const utf8proc_uint8_t *)str;
+        const utf8proc_ssize_t utf8_len = (utf8proc_ssize_t)len;
+        utf8proc_ssize_t pos = 0;
+        size_t written = 0;
+        utf8proc_int32_t codepoint;
+        while (pos < utf8_len) {
+            if (utf8_str[pos] < 0x80) {
+                // fast path for ascii
+                dst[written++] = utf8_str[pos] >= 'A' && utf8_str[pos] <= 'Z'
+                    ? (char)(utf8_str[pos] + 32)
+                    : (char)utf8_str[pos];
+                pos++;
+                continue;
+            }
+            utf8proc_ssize_t bytes = utf8proc_iterate(&utf8_str[pos], utf8_len - pos, &codepoint);
+            if (codepoint < 0) {
+                memcpy(dst + written, str + pos, (size_t)(utf8_len - pos));
+                return written + (size_t)(utf8_len - pos);
+            }
+            written += (size_t)utf8proc_encode_char(utf8proc_tolower(codepoint), (utf8proc_uint8_t *)dst + written);
+            pos += bytes;
+        }
+        return written;
+    #else
+        for (size_t i = 0; i < len; i++) {
+            dst[i] = (char)tolower((unsigned char)str[i]);
+        }
+        return len;
+    #endif
+}
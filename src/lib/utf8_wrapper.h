@@ -15,9 +15,15 @@
 #include <stddef.h>
 #include <stdint.h>
 
+/**
+ * Maximum length of the utf8_wrap_tolower result for a string of len bytes
+ */
+#define UTF8_TOLOWER_MAX_LEN(len) ((len) * 4)
+
 bool utf8_wrap_validate(const char *str, size_t str_len);
 char *utf8_wrap_casefold(const char *str, size_t len, size_t *newlen);
 char *utf8_wrap_normalize(const char *str, size_t len, size_t *newlen);
 int utf8_wrap_casecmp(const char *str1, size_t str1_len, const char *str2, size_t str2_len);
+size_t utf8_wrap_tolower(const char *str, size_t len, char *dst);
 
 #endif
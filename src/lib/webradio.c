@@ -21,6 +21,13 @@
 #include "src/lib/utility.h"
 #include <pthread.h>
 
+// Private definitions
+
+static sds normalize_value(struct t_str_pool *pool, sds value);
+static void normalize_list(struct t_str_pool *pool, struct t_list *list);
+
+// Public functions
+
 /**
  * Search webradio by uri in favorites and WebradioDB
  * @param webradio_favorites Pointer to webradio favorites
@@ -82,6 +89,10 @@ struct t_webradio_data *webradio_data_new(enum webradio_type type) {
     data->type = type;
     data->added = -1;
     data->last_modified = -1;
+    data->name_norm = NULL;
+    data->country_norm = NULL;
+    data->region_norm = NULL;
+    data->description_norm = NULL;
     return data;
 }
 
@@ -106,6 +117,20 @@ void webradio_data_free(struct t_webradio_data *data) {
     FREE_PTR(data);
 }
 
+/**
+ * Sets the normalized values for the searchable tags of the webradio
+ * @param data webradio data struct
+ * @param pool string pool for the normalized values
+ */
+void webradio_data_normalize(struct t_webradio_data *data, struct t_str_pool *pool) {
+    data->name_norm = normalize_value(pool, data->name);
+    data->country_norm = normalize_value(pool, data->country);
+    data->region_norm = normalize_value(pool, data->region);
+    data->description_norm = normalize_value(pool, data->description);
+    normalize_list(pool, &data->genres);
+    normalize_list(pool, &data->languages);
+}
+
 /**
  * Returns the uri for the webradio image
  * @param webradio Webradio struct
@@ -242,6 +267,42 @@ const char *webradio_get_tag(const struct t_webradio_data *webradio, enum webrad
     return NULL;
 }
 
+/**
+ * Returns the normalized value of a searchable webradio tag
+ * @param webradio Webdadio
+ * @param tag_type Webradio tag
+ * @param idx Index of tag
+ * @return Normalized tag value or NULL if not exists or not normalized
+ */
+sds webradio_get_tag_normalized(const struct t_webradio_data *webradio, enum webradio_tag_type tag_type, unsigned int idx) {
+    switch(tag_type) {
+        case WEBRADIO_TAG_NAME:
+            return idx == 0 ? webradio->name_norm : NULL;
+        case WEBRADIO_TAG_COUNTRY:
+            return idx == 0 ? webradio->country_norm : NULL;
+        case WEBRADIO_TAG_REGION:
+            return idx == 0 ? webradio->region_norm : NULL;
+        case WEBRADIO_TAG_DESCRIPTION:
+            return idx == 0 ? webradio->description_norm : NULL;
+        case WEBRADIO_TAG_GENRES: {
+            struct t_list_node *node = list_node_at(&webradio->genres, idx);
+            if (node == NULL) {
+                return NULL;
+            }
+            return (sds)node->user_data;
+        }
+        case WEBRADIO_TAG_LANGUAGES: {
+            struct t_list_node *node = list_node_at(&webradio->languages, idx);
+            if (node == NULL) {
+                return NULL;
+            }
+            return (sds)node->user_data;
+        }
+        default:
+            return NULL;
+    }
+}
+
 /**
  * Returns an extm3u for a webradio
  * @param webradio Pointer to webradio struct
@@ -269,6 +330,7 @@ struct t_webradios *webradios_new(void) {
     if (rc == 0) {
         webradios->db = raxNew();
         webradios->idx_uris = raxNew();
+        webradios->pool = NULL;
         return webradios;
     }
     MYMPD_LOG_ERROR(NULL, "Can not init lock");
@@ -315,6 +377,25 @@ void webradios_clear(struct t_webradios *webradios, bool init_rax) {
             webradios->idx_uris = NULL;
         }
     }
+    str_pool_free(webradios->pool);
+    webradios->pool = NULL;
+}
+
+/**
+ * Normalizes the searchable tags of all webradios.
+ * The normalized values are stored in the string pool of the webradios struct.
+ * @param webradios webradios struct
+ */
+void webradios_normalize(struct t_webradios *webradios) {
+    str_pool_free(webradios->pool);
+    webradios->pool = str_pool_new();
+    raxIterator iter;
+    raxStart(&iter, webradios->db);
+    raxSeek(&iter, "^", NULL, 0);
+    while (raxNext(&iter)) {
+        webradio_data_normalize((struct t_webradio_data *)iter.data, webradios->pool);
+    }
+    raxStop(&iter);
 }
 
 /**
@@ -572,5 +653,34 @@ bool webradios_read_from_disk(struct t_config *config, struct t_webradios *webra
     }
 
     MYMPD_LOG_INFO(NULL, "Read %" PRIu64 " webradios from %s", webradios->db->numele, filename);
+    webradios_normalize(webradios);
     return rc;
 }
+
+// Private functions
+
+/**
+ * Gets the normalized value from the string pool
+ * @param pool string pool
+ * @param value value to normalize, can be NULL
+ * @return normalized value owned by the pool or NULL
+ */
+static sds normalize_value(struct t_str_pool *pool, sds value) {
+    if (value == NULL) {
+        return NULL;
+    }
+    return str_pool_get_normalized(pool, value, sdslen(value));
+}
+
+/**
+ * Saves the normalized keys of the list in the user_data pointer
+ * @param pool string pool
+ * @param list list to normalize
+ */
+static void normalize_list(struct t_str_pool *pool, struct t_list *list) {
+    struct t_list_node *current = list->head;
+    while (current != NULL) {
+        current->user_data = normalize_value(pool, current->key);
+        current = current->next;
+    }
+}
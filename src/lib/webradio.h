@@ -15,6 +15,7 @@
 #include "dist/sds/sds.h"
 #include "src/lib/config/config_def.h"
 #include "src/lib/list/list.h"
+#include "src/lib/str_pool.h"
 
 /**
  * Webradio Types
@@ -31,6 +32,7 @@ enum webradio_type {
 struct t_webradios {
     rax *db;                  //!< Index by name
     rax *idx_uris;            //!< Index by uri
+    struct t_str_pool *pool;  //!< Normalized tag values for searching
     pthread_rwlock_t rwlock;  //!< pthreads read-write lock object
 };
 
@@ -64,7 +66,9 @@ struct t_webradio_tags {
 };
 
 /**
- * Holds the webradio data
+ * Holds the webradio data.
+ * The normalized values are owned by the string pool of the webradios struct,
+ * normalized genres and languages are saved in the user_data of the list nodes.
  */
 struct t_webradio_data {
     sds name;                   //!< Station name
@@ -79,6 +83,10 @@ struct t_webradio_data {
     enum webradio_type type;    //!< Type of the webradio
     time_t added;               //!< Added timestamp
     time_t last_modified;       //!< Last modified timestamp
+    sds name_norm;              //!< Normalized station name
+    sds country_norm;           //!< Normalized country
+    sds region_norm;            //!< Normalized state or region
+    sds description_norm;       //!< Normalized description
 };
 
 struct t_webradio_data *webradio_by_uri(struct t_webradios *webradio_favorites, struct t_webradios *webradiodb,
@@ -86,17 +94,20 @@ struct t_webradio_data *webradio_by_uri(struct t_webradios *webradio_favorites,
 sds webradio_get_extm3u(struct t_webradios *webradio_favorites, struct t_webradios *webradiodb, sds buffer, sds uri);
 struct t_webradio_data *webradio_data_new(enum webradio_type type);
 void webradio_data_free(struct t_webradio_data *data);
+void webradio_data_normalize(struct t_webradio_data *data, struct t_str_pool *pool);
 sds webradio_get_cover_uri(struct t_webradio_data *webradio, sds buffer);
 enum webradio_tag_type webradio_tag_name_parse(const char *name);
 void webradio_tags_search(struct t_webradio_tags *tags);
 const char *webradio_type_name(enum webradio_type type);
 const char *webradio_get_tag(const struct t_webradio_data *webradio, enum webradio_tag_type tag_type, unsigned int idx);
+sds webradio_get_tag_normalized(const struct t_webradio_data *webradio, enum webradio_tag_type tag_type, unsigned int idx);
 sds webradio_to_extm3u(const struct t_webradio_data *webradio, sds buffer, const char *uri);
 
 struct t_webradios *webradios_new(void);
 void webradios_clear(struct t_webradios *webradios, bool init_rax);
 void webradios_free(struct t_webradios *webradios);
 void webradios_free_void(void *webradios);
+void webradios_normalize(struct t_webradios *webradios);
 bool webradios_get_read_lock(struct t_webradios *webradios);
 bool webradios_get_write_lock(struct t_webradios *webradios);
 bool webradios_release_lock(struct t_webradios *webradios);
@@ -9,14 +9,18 @@
 #include "dist/mongoose/mongoose.h"
 #include "dist/sds/sds.h"
 
+#include "src/lib/cache/cache_disk.h"
+#include "src/lib/cache/cache_disk_index.h"
 #include "src/lib/config/cacertstore.h"
 #include "src/lib/config/cert.h"
 #include "src/lib/config/config.h"
 #include "src/lib/config/config_def.h"
 #include "src/lib/config/handle_options.h"
 #include "src/lib/filehandler.h"
+#include "src/lib/http_client/http_client_cache.h"
 #include "src/lib/log.h"
 #include "src/lib/mem.h"
+#include "src/lib/metrics.h"
 #include "src/lib/mpdclient.h"
 #include "src/lib/msg_queue.h"
 #include "src/lib/sds/sds_extras.h"
@@ -208,8 +212,8 @@ int main(int argc, char **argv) {
     umask(0077);
 
     // Message queues
-    mympd_api_queue = mympd_queue_create("mympd_api_queue", QUEUE_TYPE_REQUEST, true);
-    webserver_queue = mympd_queue_create("webserver_queue", QUEUE_TYPE_RESPONSE, false);
+    mympd_api_queue = mympd_queue_create_ring("mympd_api_queue", QUEUE_TYPE_REQUEST, true, MYMPD_QUEUE_RING_SIZE);
+    webserver_queue = mympd_queue_create_ring("webserver_queue", QUEUE_TYPE_RESPONSE, false, MYMPD_QUEUE_RING_SIZE);
     #ifdef MYMPD_ENABLE_LUA
         script_queue = mympd_queue_create("script_queue", QUEUE_TYPE_REQUEST, false);
         script_worker_queue = mympd_queue_create("script_worker_queue", QUEUE_TYPE_RESPONSE, false);
@@ -422,6 +426,15 @@ int main(int argc, char **argv) {
         mympd_queue_free(script_worker_queue);
     #endif
 
+    // Free the in-memory http client cache, the disk cache index and the metrics
+    if (config->cache_http_keep_days > CACHE_DISK_DISABLED) {
+        // write the pending mtime updates, else the files expire too early
+        http_client_cache_mem_flush(config->cache_http_keep_days);
+    }
+    http_client_cache_mem_clear();
+    cache_disk_index_free();
+    metrics_free();
+
     // Free config
     mympd_config_free(config);
 
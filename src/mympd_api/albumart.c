@@ -13,14 +13,11 @@
 
 #include "src/lib/album.h"
 #include "src/lib/api.h"
-#include "src/lib/cache/cache_disk.h"
-#include "src/lib/cache/cache_disk_images.h"
 #include "src/lib/cache/cache_rax_album.h"
 #include "src/lib/json/json_print.h"
 #include "src/lib/json/json_rpc.h"
 #include "src/lib/log.h"
 #include "src/lib/mem.h"
-#include "src/lib/mimetype.h"
 #include "src/lib/sds/sds_extras.h"
 #include "src/mympd_api/trigger.h"
 #include "src/mympd_client/errorhandler.h"
@@ -101,19 +98,15 @@ sds mympd_api_albumart_getcover_by_album_id(struct t_partition_state *partition_
 }
 
 /**
- * Reads the albumart from mpd by song uri
- * @param mympd_state pointer to mympd state
+ * Reads the albumart for a song from mpd.
+ * Tries the albumart command first and falls back to readpicture.
+ * This is called from the albumart fetch threads with their own mpd connection.
  * @param partition_state pointer to partition specific states
- * @param buffer already allocated sds string for the jsonrpc response
- * @param request_id request id
- * @param conn_id mongoose connection id
  * @param uri uri to get cover for
- * @param binary pointer to an already allocated sds string for the binary response
- * @return jsonrpc response
+ * @param binary pointer to an already allocated sds string for the image
+ * @return true if albumart was found, else false
  */
-sds mympd_api_albumart_getcover_by_uri(struct t_mympd_state *mympd_state, struct t_partition_state *partition_state,
-    sds buffer, unsigned request_id, unsigned long conn_id, sds uri, void **binary)
-{
+bool mympd_api_albumart_read_mpd(struct t_partition_state *partition_state, const char *uri, sds *binary) {
     unsigned offset = 0;
     void *binary_buffer = malloc_assert(partition_state->mpd_state->mpd_binarylimit);
     int recv_len = 0;
@@ -160,24 +153,26 @@ sds mympd_api_albumart_getcover_by_uri(struct t_mympd_state *mympd_state, struct
     if (offset == 0) {
         // Silently clear the error if no albumart was found
         mympd_clear_finish(partition_state);
+        return false;
     }
-    else {
-        // Return albumart
-        MYMPD_LOG_DEBUG(partition_state->name, "Albumart found by mpd for uri \"%s\" (%lu bytes)", uri, (unsigned long)sdslen(*binary));
-        const char *mime_type = get_mime_type_by_magic_stream(*binary);
-        buffer = jsonrpc_respond_start(buffer, INTERNAL_API_ALBUMART_BY_URI, request_id);
-        buffer = tojson_char(buffer, "mime_type", mime_type, false);
-        buffer = jsonrpc_end(buffer);
-        if (partition_state->config->cache_cover_keep_days != CACHE_DISK_DISABLED) {
-            sds filename = cache_disk_images_write_file(partition_state->config->cachedir, DIR_CACHE_COVER, uri, mime_type, *binary, 0);
-            FREE_SDS(filename);
-        }
-        else {
-            MYMPD_LOG_DEBUG(partition_state->name, "Covercache is disabled");
-        }
-        return buffer;
-    }
+    MYMPD_LOG_DEBUG(partition_state->name, "Albumart found by mpd for uri \"%s\" (%lu bytes)", uri, (unsigned long)sdslen(*binary));
+    return true;
+}
 
+/**
+ * Handles songs without albumart in mpd.
+ * Executes the albumart trigger or responds with an error.
+ * @param mympd_state pointer to mympd state
+ * @param partition_state pointer to partition specific states
+ * @param buffer already allocated sds string for the jsonrpc response
+ * @param request_id request id
+ * @param conn_id mongoose connection id
+ * @param uri uri to get cover for
+ * @return jsonrpc response, an empty buffer if the response is sent by a triggered script
+ */
+sds mympd_api_albumart_not_found(struct t_mympd_state *mympd_state, struct t_partition_state *partition_state,
+    sds buffer, unsigned request_id, unsigned long conn_id, sds uri)
+{
     // Albumart by script
     #ifdef MYMPD_ENABLE_LUA
         // no albumart found, check if there is a trigger to fetch albumart
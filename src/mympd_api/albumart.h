@@ -15,7 +15,8 @@
 
 sds mympd_api_albumart_getcover_by_album_id(struct t_partition_state *partition_state, struct t_cache *album_cache,
         sds buffer, unsigned request_id, sds albumid, unsigned size);
-sds mympd_api_albumart_getcover_by_uri(struct t_mympd_state *mympd_state, struct t_partition_state *partition_state,
-    sds buffer, unsigned request_id, unsigned long conn_id, sds uri, void **binary);
+bool mympd_api_albumart_read_mpd(struct t_partition_state *partition_state, const char *uri, sds *binary);
+sds mympd_api_albumart_not_found(struct t_mympd_state *mympd_state, struct t_partition_state *partition_state,
+    sds buffer, unsigned request_id, unsigned long conn_id, sds uri);
 
 #endif
@@ -0,0 +1,522 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2026 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+/*! \file
+ * \brief Fetches albumart from mpd outside of the mympd_api thread
+ *
+ * Reading albumart from mpd transfers the image in chunks of binarylimit bytes.
+ * This is done by dedicated threads with their own mpd connections,
+ * the mympd_api thread only queues the requests.
+ * Concurrent requests for the same uri are answered by one fetch.
+ */
+
+#include "compile_time.h"
+#include "src/mympd_api/albumart_fetch.h"
+
+#include "dist/rax/rax.h"
+#include "src/lib/cache/cache_disk.h"
+#include "src/lib/cache/cache_disk_images.h"
+#include "src/lib/histogram.h"
+#include "src/lib/json/json_print.h"
+#include "src/lib/json/json_rpc.h"
+#include "src/lib/list/list.h"
+#include "src/lib/log.h"
+#include "src/lib/mem.h"
+#include "src/lib/mimetype.h"
+#include "src/lib/msg_queue.h"
+#include "src/lib/sds/sds_extras.h"
+#include "src/lib/thread.h"
+#include "src/mympd_api/albumart.h"
+#include "src/mympd_client/connection.h"
+#include "src/mympd_worker/mympd_worker.h"
+
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * Private definitions
+ */
+
+/**
+ * A queued or running albumart fetch
+ */
+struct t_albumart_fetch_job {
+    sds uri;                 //!< song uri
+    struct t_list waiters;   //!< waiting requests, value_i is the queue time in microseconds
+    bool covercache;         //!< write the albumart to the covercache
+    bool thumbs;             //!< create the thumbnail variants
+    sds cachedir;            //!< pointer to the cache directory from the static config
+};
+
+/**
+ * Connection of a fetch thread
+ */
+struct t_albumart_fetch_conn {
+    struct t_partition_state *partition_state;  //!< partition state for the mpd connection
+    struct t_mpd_state *mpd_state;              //!< copy of the connection settings
+    unsigned generation;                        //!< generation of the connection settings
+    bool repopulate_pfds;                       //!< unused, required by the connection functions
+};
+
+/**
+ * The albumart fetch threads
+ */
+struct t_albumart_fetch {
+    pthread_mutex_t mutex;           //!< protects all other members
+    pthread_cond_t wakeup;           //!< signaled for new jobs
+    pthread_t threads[MAX_ALBUMART_FETCH_THREADS];  //!< the fetch threads
+    unsigned thread_count;           //!< number of started threads
+    bool stop;                       //!< true if the threads should stop
+    struct t_list jobs;              //!< queued jobs
+    rax *pending;                    //!< queued and running jobs by uri
+    struct t_config *config;         //!< pointer to static config
+    struct t_mpd_state *mpd_state;   //!< current connection settings
+    sds conn_key;                    //!< key of the current connection settings
+    unsigned generation;             //!< incremented on changed connection settings
+    unsigned running;                //!< number of running fetches
+    uint64_t found;                  //!< number of uris with albumart
+    uint64_t not_found;              //!< number of uris without albumart
+    uint64_t coalesced;              //!< number of requests answered by an already queued fetch
+    uint64_t rejected;               //!< number of requests rejected because of a full queue
+    struct t_histogram latency;      //!< latency from queuing to response
+};
+
+static struct t_albumart_fetch fetch;  //!< The albumart fetch state
+
+static void *albumart_fetch_thread(void *arg);
+static bool fetch_albumart(struct t_albumart_fetch_conn *conn, const char *uri, sds *binary);
+static bool conn_open(struct t_albumart_fetch_conn *conn);
+static void conn_idle(struct t_albumart_fetch_conn *conn);
+static void conn_update(struct t_albumart_fetch_conn *conn);
+static void respond(struct t_albumart_fetch_job *job, struct t_list *waiters, sds binary, bool found,
+        struct t_histogram *latency);
+static void free_job(struct t_albumart_fetch_job *job);
+static void free_waiter(struct t_list_node *current);
+static sds get_conn_key(sds key, const struct t_mpd_state *mpd_state);
+static int64_t now_us(void);
+
+/**
+ * Public functions
+ */
+
+/**
+ * Starts the albumart fetch threads.
+ * This is called from the mympd_api thread.
+ * @return true on success, else false
+ */
+bool mympd_api_albumart_fetch_start(void) {
+    fetch.mutex = (pthread_mutex_t)PTHREAD_MUTEX_INITIALIZER;
+    fetch.wakeup = (pthread_cond_t)PTHREAD_COND_INITIALIZER;
+    fetch.thread_count = 0;
+    fetch.stop = false;
+    list_init(&fetch.jobs);
+    fetch.pending = raxNew();
+    fetch.config = NULL;
+    fetch.mpd_state = NULL;
+    fetch.conn_key = sdsempty();
+    fetch.generation = 0;
+    fetch.running = 0;
+    fetch.found = 0;
+    fetch.not_found = 0;
+    fetch.coalesced = 0;
+    fetch.rejected = 0;
+    histogram_init(&fetch.latency);
+    for (unsigned i = 0; i < MAX_ALBUMART_FETCH_THREADS; i++) {
+        if (pthread_create(&fetch.threads[i], NULL, albumart_fetch_thread, NULL) != 0) {
+            MYMPD_LOG_ERROR(NULL, "Can not create albumart fetch thread");
+            break;
+        }
+        fetch.thread_count++;
+    }
+    MYMPD_LOG_INFO(NULL, "Started %u albumart fetch threads", fetch.thread_count);
+    return fetch.thread_count > 0;
+}
+
+/**
+ * Stops the albumart fetch threads and discards queued jobs.
+ * This is called from the mympd_api thread.
+ */
+void mympd_api_albumart_fetch_stop(void) {
+    pthread_mutex_lock(&fetch.mutex);
+    fetch.stop = true;
+    pthread_cond_broadcast(&fetch.wakeup);
+    pthread_mutex_unlock(&fetch.mutex);
+    for (unsigned i = 0; i < fetch.thread_count; i++) {
+        pthread_join(fetch.threads[i], NULL);
+    }
+    fetch.thread_count = 0;
+    struct t_list_node *current;
+    while ((current = list_shift_first(&fetch.jobs)) != NULL) {
+        free_job((struct t_albumart_fetch_job *)current->user_data);
+        list_node_free(current);
+    }
+    raxFree(fetch.pending);
+    fetch.pending = NULL;
+    if (fetch.mpd_state != NULL) {
+        mympd_mpd_state_free(fetch.mpd_state);
+        fetch.mpd_state = NULL;
+    }
+    FREE_SDS(fetch.conn_key);
+}
+
+/**
+ * Queues an albumart request.
+ * Requests for an uri that is already queued or fetched are attached to this job.
+ * This is called from the mympd_api thread.
+ * @param mympd_state pointer to mympd state
+ * @param partition_state pointer to partition specific states
+ * @param request the work request, the fetch threads take ownership on success
+ * @param uri uri to get cover for
+ * @return true on success, else false
+ */
+bool mympd_api_albumart_fetch_push(struct t_mympd_state *mympd_state, struct t_partition_state *partition_state,
+        struct t_work_request *request, sds uri)
+{
+    if (fetch.thread_count == 0) {
+        MYMPD_LOG_ERROR(NULL, "The albumart fetch threads are not running");
+        return false;
+    }
+    sds conn_key = get_conn_key(sdsempty(), mympd_state->mpd_state);
+    int64_t queued = now_us();
+    pthread_mutex_lock(&fetch.mutex);
+    if (strcmp(conn_key, fetch.conn_key) != 0) {
+        // connection settings have changed, the threads reconnect before the next fetch
+        if (fetch.mpd_state != NULL) {
+            mympd_mpd_state_free(fetch.mpd_state);
+        }
+        fetch.mpd_state = malloc_assert(sizeof(struct t_mpd_state));
+        mympd_mpd_state_copy(mympd_state->mpd_state, fetch.mpd_state);
+        fetch.config = mympd_state->config;
+        sdsclear(fetch.conn_key);
+        fetch.conn_key = sdscatsds(fetch.conn_key, conn_key);
+        fetch.generation++;
+    }
+    FREE_SDS(conn_key);
+
+    void *data;
+    if (raxFind(fetch.pending, (unsigned char *)uri, sdslen(uri), &data) == 1) {
+        struct t_albumart_fetch_job *job = (struct t_albumart_fetch_job *)data;
+        list_push(&job->waiters, "", queued, NULL, request);
+        fetch.coalesced++;
+        pthread_mutex_unlock(&fetch.mutex);
+        MYMPD_LOG_DEBUG(partition_state->name, "Albumart for \"%s\" is already queued", uri);
+        return true;
+    }
+    if (fetch.jobs.length >= MAX_ALBUMART_FETCH_JOBS) {
+        fetch.rejected++;
+        pthread_mutex_unlock(&fetch.mutex);
+        MYMPD_LOG_WARN(partition_state->name, "Too many queued albumart requests");
+        return false;
+    }
+    struct t_albumart_fetch_job *job = malloc_assert(sizeof(struct t_albumart_fetch_job));
+    job->uri = sdsdup(uri);
+    job->covercache = partition_state->config->cache_cover_keep_days != CACHE_DISK_DISABLED;
+    job->thumbs = partition_state->config->cache_thumbs_keep_days != CACHE_DISK_DISABLED;
+    job->cachedir = partition_state->config->cachedir;
+    list_init(&job->waiters);
+    list_push(&job->waiters, "", queued, NULL, request);
+    raxInsert(fetch.pending, (unsigned char *)job->uri, sdslen(job->uri), job, NULL);
+    list_push(&fetch.jobs, "", 0, NULL, job);
+    pthread_cond_signal(&fetch.wakeup);
+    pthread_mutex_unlock(&fetch.mutex);
+    return true;
+}
+
+/**
+ * Prints the albumart fetch metrics as json object
+ * @param buffer already allocated sds string to append
+ * @return pointer to buffer
+ */
+sds mympd_api_albumart_fetch_stats(sds buffer) {
+    pthread_mutex_lock(&fetch.mutex);
+    buffer = sdscatlen(buffer, "{", 1);
+    buffer = tojson_uint(buffer, "threads", fetch.thread_count, true);
+    buffer = tojson_uint(buffer, "queued", fetch.jobs.length, true);
+    buffer = tojson_uint(buffer, "running", fetch.running, true);
+    buffer = tojson_uint64(buffer, "found", fetch.found, true);
+    buffer = tojson_uint64(buffer, "notFound", fetch.not_found, true);
+    buffer = tojson_uint64(buffer, "coalesced", fetch.coalesced, true);
+    buffer = tojson_uint64(buffer, "rejected", fetch.rejected, true);
+    buffer = histogram_tojson(buffer, "latency", &fetch.latency, false);
+    buffer = sdscatlen(buffer, "}", 1);
+    pthread_mutex_unlock(&fetch.mutex);
+    return buffer;
+}
+
+/**
+ * Private functions
+ */
+
+/**
+ * This is the main function of the albumart fetch threads.
+ * The threads keep their mpd connections in idle mode between fetches.
+ * @param arg unused
+ * @return NULL
+ */
+static void *albumart_fetch_thread(void *arg) {
+    (void)arg;
+    static _Atomic unsigned thread_number;
+    thread_logname = sdscatprintf(sdsempty(), "albumart%02u", ++thread_number);
+    set_threadname(thread_logname);
+    thread_logline = sdsempty();
+    struct t_albumart_fetch_conn conn = {
+        .partition_state = NULL,
+        .mpd_state = NULL,
+        .generation = 0,
+        .repopulate_pfds = false
+    };
+
+    pthread_mutex_lock(&fetch.mutex);
+    while (fetch.stop == false) {
+        struct t_list_node *current = list_shift_first(&fetch.jobs);
+        if (current == NULL) {
+            pthread_cond_wait(&fetch.wakeup, &fetch.mutex);
+            continue;
+        }
+        struct t_albumart_fetch_job *job = (struct t_albumart_fetch_job *)current->user_data;
+        list_node_free(current);
+        fetch.running++;
+        if (conn.generation != fetch.generation) {
+            conn_update(&conn);
+        }
+        pthread_mutex_unlock(&fetch.mutex);
+
+        sds binary = sdsempty();
+        bool found = fetch_albumart(&conn, job->uri, &binary);
+        conn_idle(&conn);
+
+        // requests arriving from now on start a new fetch
+        pthread_mutex_lock(&fetch.mutex);
+        fetch.running--;
+        raxRemove(fetch.pending, (unsigned char *)job->uri, sdslen(job->uri), NULL);
+        struct t_list waiters = job->waiters;
+        list_init(&job->waiters);
+        pthread_mutex_unlock(&fetch.mutex);
+
+        struct t_histogram latency;
+        histogram_init(&latency);
+        respond(job, &waiters, binary, found, &latency);
+        FREE_SDS(binary);
+        free_job(job);
+
+        pthread_mutex_lock(&fetch.mutex);
+        histogram_merge(&fetch.latency, &latency);
+        if (found == true) {
+            fetch.found++;
+        }
+        else {
+            fetch.not_found++;
+        }
+    }
+    pthread_mutex_unlock(&fetch.mutex);
+
+    if (conn.partition_state != NULL) {
+        mympd_client_disconnect_silent(conn.partition_state);
+        partition_state_free(conn.partition_state);
+    }
+    if (conn.mpd_state != NULL) {
+        mympd_mpd_state_free(conn.mpd_state);
+    }
+    FREE_SDS(thread_logname);
+    FREE_SDS(thread_logline);
+    return NULL;
+}
+
+/**
+ * Reads the albumart from mpd, reconnects once if the connection is broken
+ * @param conn connection of the fetch thread
+ * @param uri uri to get cover for
+ * @param binary pointer to an already allocated sds string for the image
+ * @return true if albumart was found, else false
+ */
+static bool fetch_albumart(struct t_albumart_fetch_conn *conn, const char *uri, sds *binary) {
+    for (unsigned attempt = 0; attempt < 2; attempt++) {
+        if (conn_open(conn) == false) {
+            return false;
+        }
+        bool rc = mympd_api_albumart_read_mpd(conn->partition_state, uri, binary);
+        if (mpd_connection_get_error(conn->partition_state->conn) == MPD_ERROR_SUCCESS) {
+            return rc;
+        }
+        MYMPD_LOG_WARN(conn->partition_state->name, "Albumart fetch failed: %s",
+            mpd_connection_get_error_message(conn->partition_state->conn));
+        mympd_client_disconnect_silent(conn->partition_state);
+        sdsclear(*binary);
+    }
+    return false;
+}
+
+/**
+ * Leaves the idle mode of the connection or connects to mpd
+ * @param conn connection of the fetch thread
+ * @return true on success, else false
+ */
+static bool conn_open(struct t_albumart_fetch_conn *conn) {
+    if (conn->partition_state == NULL) {
+        MYMPD_LOG_ERROR(NULL, "No mpd connection settings for the albumart fetch thread");
+        return false;
+    }
+    struct t_partition_state *partition_state = conn->partition_state;
+    if (partition_state->conn != NULL) {
+        mpd_run_noidle(partition_state->conn);
+        if (mpd_connection_get_error(partition_state->conn) == MPD_ERROR_SUCCESS) {
+            return true;
+        }
+        MYMPD_LOG_INFO(partition_state->name, "Albumart fetch connection is broken: %s",
+            mpd_connection_get_error_message(partition_state->conn));
+        mympd_client_disconnect_silent(partition_state);
+    }
+    if (mympd_client_connect(partition_state) == false) {
+        mympd_client_disconnect_silent(partition_state);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Sets the connection in idle mode to not run into the mpd connection timeout
+ * @param conn connection of the fetch thread
+ */
+static void conn_idle(struct t_albumart_fetch_conn *conn) {
+    if (conn->partition_state == NULL ||
+        conn->partition_state->conn == NULL)
+    {
+        return;
+    }
+    if (mpd_connection_get_error(conn->partition_state->conn) != MPD_ERROR_SUCCESS ||
+        mpd_send_idle(conn->partition_state->conn) == false)
+    {
+        mympd_client_disconnect_silent(conn->partition_state);
+    }
+}
+
+/**
+ * Takes the current connection settings and closes the connection.
+ * Caller must hold the fetch mutex.
+ * @param conn connection of the fetch thread
+ */
+static void conn_update(struct t_albumart_fetch_conn *conn) {
+    if (conn->partition_state != NULL) {
+        mympd_client_disconnect_silent(conn->partition_state);
+        partition_state_free(conn->partition_state);
+        conn->partition_state = NULL;
+    }
+    if (conn->mpd_state != NULL) {
+        mympd_mpd_state_free(conn->mpd_state);
+        conn->mpd_state = NULL;
+    }
+    conn->generation = fetch.generation;
+    if (fetch.mpd_state == NULL) {
+        return;
+    }
+    conn->mpd_state = malloc_assert(sizeof(struct t_mpd_state));
+    mympd_mpd_state_copy(fetch.mpd_state, conn->mpd_state);
+    conn->partition_state = malloc_assert(sizeof(struct t_partition_state));
+    partition_state_default(conn->partition_state, MPD_PARTITION_DEFAULT, conn->mpd_state, fetch.config);
+    conn->partition_state->repopulate_pfds = &conn->repopulate_pfds;
+}
+
+/**
+ * Sends the albumart to all waiting requests and writes it to the covercache.
+ * Requests for uris without albumart are sent back to the mympd_api thread
+ * to run the albumart trigger.
+ * @param job the finished job
+ * @param waiters the waiting requests
+ * @param binary the image
+ * @param found true if albumart was found, else false
+ * @param latency histogram to add the latency of each request
+ */
+static void respond(struct t_albumart_fetch_job *job, struct t_list *waiters, sds binary, bool found,
+        struct t_histogram *latency)
+{
+    const char *mime_type = NULL;
+    if (found == true) {
+        mime_type = get_mime_type_by_magic_stream(binary);
+        if (job->covercache == true) {
+            sds filename = cache_disk_images_write_file(job->cachedir, DIR_CACHE_COVER, job->uri, mime_type, binary, 0);
+            #ifdef MYMPD_ENABLE_THUMBNAILS
+                if (job->thumbs == true &&
+                    filename != NULL &&
+                    mympd_worker_pool_queue_thumbnails(job->uri, 0, filename) == false)
+                {
+                    MYMPD_LOG_DEBUG(NULL, "Thumbnail queue is full, skipping \"%s\"", job->uri);
+                }
+            #endif
+            FREE_SDS(filename);
+        }
+        else {
+            MYMPD_LOG_DEBUG(NULL, "Covercache is disabled");
+        }
+    }
+    struct t_list_node *current;
+    while ((current = list_shift_first(waiters)) != NULL) {
+        struct t_work_request *request = (struct t_work_request *)current->user_data;
+        if (found == true) {
+            struct t_work_response *response = create_response(request);
+            response->data = jsonrpc_respond_start(response->data, INTERNAL_API_ALBUMART_BY_URI, request->id);
+            response->data = tojson_char(response->data, "mime_type", mime_type, false);
+            response->data = jsonrpc_end(response->data);
+            response->extra = sdsdup(binary);
+            response->extra_free = sds_free_void;
+            push_response(response);
+            free_request(request);
+        }
+        else {
+            struct t_work_request *not_found = create_request(request->type, request->conn_id, request->id,
+                INTERNAL_API_ALBUMART_BY_URI, NULL, request->partition);
+            not_found->data = tojson_sds(not_found->data, "uri", job->uri, true);
+            not_found->data = tojson_bool(not_found->data, "fetched", true, false);
+            not_found->data = jsonrpc_end(not_found->data);
+            mympd_queue_push(mympd_api_queue, not_found, 0);
+            free_request(request);
+        }
+        int64_t elapsed = now_us() - current->value_i;
+        histogram_add(latency, elapsed > 0 ? (uint64_t)elapsed : 0);
+        list_node_free(current);
+    }
+}
+
+/**
+ * Frees a job and its waiting requests
+ * @param job the job to free
+ */
+static void free_job(struct t_albumart_fetch_job *job) {
+    list_clear_user_data(&job->waiters, free_waiter);
+    FREE_SDS(job->uri);
+    FREE_PTR(job);
+}
+
+/**
+ * Callback for list_clear_user_data to free a waiting request
+ * @param current list node
+ */
+static void free_waiter(struct t_list_node *current) {
+    free_request((struct t_work_request *)current->user_data);
+    current->user_data = NULL;
+}
+
+/**
+ * Creates the key for the connection settings
+ * @param key already allocated sds string to append
+ * @param mpd_state mpd state with the connection settings
+ * @return pointer to key
+ */
+static sds get_conn_key(sds key, const struct t_mpd_state *mpd_state) {
+    return sdscatfmt(key, "%S\n%u\n%S\n%u\n%u\n%u", mpd_state->mpd_host, mpd_state->mpd_port,
+        mpd_state->mpd_pass, mpd_state->mpd_timeout, mpd_state->mpd_binarylimit,
+        (unsigned)mpd_state->mpd_keepalive);
+}
+
+/**
+ * Returns the monotonic time
+ * @return time in microseconds
+ */
+static int64_t now_us(void) {
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000000 + (int64_t)now.tv_nsec / 1000;
+}
@@ -0,0 +1,23 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2026 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+/*! \file
+ * \brief Fetches albumart from mpd outside of the mympd_api thread
+ */
+
+#ifndef MYMPD_API_ALBUMART_FETCH_H
+#define MYMPD_API_ALBUMART_FETCH_H
+
+#include "src/lib/api.h"
+#include "src/lib/config/mympd_state.h"
+
+bool mympd_api_albumart_fetch_start(void);
+void mympd_api_albumart_fetch_stop(void);
+bool mympd_api_albumart_fetch_push(struct t_mympd_state *mympd_state, struct t_partition_state *partition_state,
+        struct t_work_request *request, sds uri);
+sds mympd_api_albumart_fetch_stats(sds buffer);
+
+#endif
@@ -13,13 +13,12 @@
 
 #include "src/lib/album.h"
 #include "src/lib/cache/cache_rax_album.h"
+#include "src/lib/cache/cache_rax_album_index.h"
 #include "src/lib/fields.h"
 #include "src/lib/json/json_print.h"
 #include "src/lib/json/json_rpc.h"
 #include "src/lib/log.h"
-#include "src/lib/rax_extras.h"
 #include "src/lib/sds/sds_extras.h"
-#include "src/lib/sds/sds_utf8.h"
 #include "src/lib/search/search.h"
 #include "src/lib/sticker.h"
 #include "src/mympd_api/extra_media.h"
@@ -32,8 +31,6 @@
 #include <string.h>
 
 // private definitions
-static sds get_sort_key_album(sds key, enum sort_by_type sort_by,
-        enum mpd_tag_type sort_tag, const struct t_album *album);
 static bool check_album_sort_tag(enum sort_by_type sort_by, enum mpd_tag_type sort_tag,
         struct t_albums_config *album_config);
 
@@ -242,51 +239,33 @@ sds mympd_api_album_list(struct t_mympd_state *mympd_state, struct t_partition_s
         return buffer;
     }
     
-    //search and sort albumlist
-    unsigned real_limit = offset + limit;
-    rax *albums = raxNew();
-    raxIterator iter;
-    raxStart(&iter, mympd_state->album_cache.cache);
-    raxSeek(&iter, "^", NULL, 0);
-    sds key = sdsempty();
-    while (raxNext(&iter)) {
-        struct t_album *album = (struct t_album *)iter.data;
-        if (expr_list->length == 0 ||
-            search_expression_album(album, expr_list, &partition_state->mpd_state->tags_browse) == true)
-        {
-            key = get_sort_key_album(key, sort_by, sort_tag, album);
-            rax_insert_no_dup(albums, key, iter.data);
-            sdsclear(key);
-        }
-    }
-    raxStop(&iter);
-    search_expression_free(expr_list);
-    FREE_SDS(key);
+    //get the presorted album list, this is created on first use for uncommon sort tags
+    const struct t_album_sort_index *sort_index = album_index_get(&mympd_state->album_cache, sort_by, sort_tag);
 
     //print album list
     bool print_stickers = check_get_sticker(partition_state->mpd_state->feat.stickers, &tagcols->stickers);
     if (print_stickers == true) {
         stickerdb_exit_idle(mympd_state->stickerdb);
     }
+    bool filtered = expr_list->length > 0;
+    unsigned real_limit = offset + limit;
     unsigned entity_count = 0;
     unsigned entities_returned = 0;
-    raxStart(&iter, albums);
-    int (*iterator)(struct raxIterator *iter);
-    if (sortdesc == false) {
-        raxSeek(&iter, "^", NULL, 0);
-        iterator = &raxNext;
-    }
-    else {
-        raxSeek(&iter, "$", NULL, 0);
-        iterator = &raxPrev;
-    }
+    bool complete = true;
     sds album_exp = sdsempty();
-    while (iterator(&iter)) {
+    for (size_t i = 0; i < sort_index->len; i++) {
+        struct t_album *album = sortdesc == false
+            ? sort_index->albums[i]
+            : sort_index->albums[sort_index->len - 1 - i];
+        if (filtered == true &&
+            search_expression_album(album, expr_list, &partition_state->mpd_state->tags_browse) == false)
+        {
+            continue;
+        }
         if (entity_count >= offset) {
             if (entities_returned++) {
                 buffer = sdscatlen(buffer, ",", 1);
             }
-            struct t_album *album = (struct t_album *)iter.data;
             buffer = sdscat(buffer, "{\"Type\": \"album\",");
             buffer = print_album_tags(buffer, &partition_state->mpd_state->config->albums, &tagcols->mpd_tags, album);
             buffer = sdscatlen(buffer, ",", 1);
@@ -301,16 +280,26 @@ sds mympd_api_album_list(struct t_mympd_state *mympd_state, struct t_partition_s
         }
         entity_count++;
         if (entity_count == real_limit) {
+            // stop early, the total count is only known without filter
+            complete = i + 1 == sort_index->len;
             break;
         }
     }
-    raxStop(&iter);
+    search_expression_free(expr_list);
     FREE_SDS(album_exp);
     if (print_stickers == true) {
         stickerdb_enter_idle(mympd_state->stickerdb);
     }
     buffer = sdscatlen(buffer, "],", 2);
-    buffer = tojson_uint64(buffer, "totalEntities", albums->numele, true);
+    if (filtered == false) {
+        buffer = tojson_uint64(buffer, "totalEntities", (uint64_t)sort_index->len, true);
+    }
+    else if (complete == true) {
+        buffer = tojson_uint(buffer, "totalEntities", entity_count, true);
+    }
+    else {
+        buffer = tojson_int(buffer, "totalEntities", -1, true);
+    }
     buffer = tojson_uint(buffer, "returnedEntities", entities_returned, true);
     buffer = tojson_uint(buffer, "offset", offset, true);
     buffer = tojson_sds(buffer, "expression", expression, true);
@@ -318,45 +307,11 @@ sds mympd_api_album_list(struct t_mympd_state *mympd_state, struct t_partition_s
     buffer = tojson_bool(buffer, "sortdesc", sortdesc, true);
     buffer = tojson_char(buffer, "tag", "Album", false);
     buffer = jsonrpc_end(buffer);
-    raxFree(albums);
     return buffer;
 }
 
 // private functions
 
-/**
- * Gets an alphanumeric string for sorting
- * @param key already allocated sds string to append
- * @param sort_by enum sort_by
- * @param sort_tag mpd tag to sort by
- * @param album pointer to t_album
- * @return pointer to key
- */
-static sds get_sort_key_album(sds key, enum sort_by_type sort_by, enum mpd_tag_type sort_tag, const struct t_album *album) {
-    if (sort_by == SORT_BY_LAST_MODIFIED) {
-        key = sds_pad_int((int64_t)album_get_last_modified(album), key);
-    }
-    else if (sort_by == SORT_BY_ADDED) {
-        key = sds_pad_int((int64_t)album_get_added(album), key);
-    }
-    else if (is_numeric_tag(sort_tag) == true) {
-        key = album_get_tag_value_padded(album, sort_tag, '0', PADDING_LENGTH, key);
-    }
-    else if (sort_tag > MPD_TAG_UNKNOWN) {
-        key = album_get_tag_value_string(album, sort_tag, key);
-        if (sdslen(key) == 0) {
-            key = sdscatlen(key, "zzzzzzzzzz", 10);
-        }
-    }
-    enum mpd_tag_type secondary_sort_tag = sort_tag == MPD_TAG_ALBUM
-        ? MPD_TAG_ALBUM_ARTIST
-        : MPD_TAG_ALBUM;
-    key = sdscatfmt(key, "::%s::%s", album_get_tag(album, secondary_sort_tag, 0), album_get_uri(album));
-    key = sds_utf8_normalize(key);
-    return key;
-}
-
-
 /**
  * Validates the album sort tag
  * @param sort_by sort by type
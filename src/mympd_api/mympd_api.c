@@ -24,6 +24,7 @@
 #include "src/lib/thread.h"
 #include "src/lib/timer.h"
 #include "src/lib/webradio.h"
+#include "src/mympd_api/albumart_fetch.h"
 #include "src/mympd_api/home.h"
 #include "src/mympd_api/settings.h"
 #include "src/mympd_api/timer.h"
@@ -34,6 +35,7 @@
 #include "src/mympd_client/idle.h"
 #include "src/mympd_client/partitions.h"
 #include "src/mympd_client/stickerdb.h"
+#include "src/mympd_worker/mympd_worker.h"
 
 #include <errno.h>
 
@@ -42,6 +44,8 @@
 static void populate_pfds(struct t_mympd_state *mympd_state);
 static void handle_socket_pollin(struct t_mympd_state *mympd_state, nfds_t i, struct t_work_request **request);
 static void handle_socket_error(struct t_mympd_state *mympd_state, nfds_t i);
+static void set_queue_event(struct t_mympd_state *mympd_state, struct t_work_request *request);
+static bool handle_queue_batch(struct t_mympd_state *mympd_state);
 
 // public functions
 
@@ -98,6 +102,8 @@ void *mympd_api_loop(void *arg_config) {
     MYMPD_LOG_INFO(NULL, "Adding timer for cache cropping to execute periodic each day");
     mympd_api_timer_add(&mympd_state->timer_list, TIMER_DISK_CACHE_CLEANUP_OFFSET, TIMER_DISK_CACHE_CLEANUP_INTERVAL,
         timer_handler_by_id, TIMER_ID_DISK_CACHE_CROP, NULL);
+    mympd_api_timer_add(&mympd_state->timer_list, TIMER_DISK_CACHE_CROP_SLICE_OFFSET, TIMER_DISK_CACHE_CROP_SLICE_INTERVAL,
+        timer_handler_by_id, TIMER_ID_DISK_CACHE_CROP_SLICE, NULL);
 
     // start trigger
     mympd_api_trigger_execute(&mympd_state->trigger_list, TRIGGER_MYMPD_START, MPD_PARTITION_ALL, NULL);
@@ -117,6 +123,11 @@ void *mympd_api_loop(void *arg_config) {
         MYMPD_LOG_NOTICE("stickerdb", "Stickers are disabled by config");
     }
 
+    // start the worker pool
+    mympd_worker_pool_start(mympd_state->config);
+    // start the albumart fetch threads
+    mympd_api_albumart_fetch_start();
+
     // connect to default mpd partition
     mympd_timer_set(mympd_state->partition_state->timer_fd_mpd_connect, 0, 5);
 
@@ -143,22 +154,40 @@ void *mympd_api_loop(void *arg_config) {
             }
         }
         // Iterate through mpd partitions and handle the events
-        if (mympd_client_idle(mympd_state, request) == true &&
+        bool queue_event = request != NULL;
+        bool event_handled = mympd_client_idle(mympd_state, request);
+        if (queue_event == true &&
+            handle_queue_batch(mympd_state) == true)
+        {
+            event_handled = true;
+        }
+        if (event_handled == true &&
             mympd_state->config->state_save == true)
         {
             // myMPD is active - add an uniq timer to save the state
             mympd_api_timer_add_uniq(&mympd_state->timer_list, TIMER_DISK_STATE_SAVE_OFFSET, -1,
                 timer_handler_by_id, TIMER_ID_STATE_SAVE, NULL);
         }
+        if (mympd_state->stickerdb->cache.pending->numele > 0) {
+            // coalesce the sticker writes
+            mympd_api_timer_add_uniq(&mympd_state->timer_list, TIMER_STICKERDB_FLUSH_OFFSET, -1,
+                timer_handler_by_id, TIMER_ID_STICKERDB_FLUSH, NULL);
+        }
     }
     MYMPD_LOG_DEBUG(NULL, "Stopping mympd_api thread");
 
     // stop trigger
     mympd_api_trigger_execute(&mympd_state->trigger_list, TRIGGER_MYMPD_STOP, MPD_PARTITION_ALL, NULL);
 
+    // wait for running worker jobs
+    mympd_worker_pool_stop();
+    // wait for running albumart fetches
+    mympd_api_albumart_fetch_stop();
+
     // disconnect from mpd
     mympd_client_disconnect_all(mympd_state);
     if (mympd_state->stickerdb->conn != NULL) {
+        stickerdb_flush(mympd_state->stickerdb);
         stickerdb_disconnect(mympd_state->stickerdb);
     }
 
@@ -204,13 +233,7 @@ static void handle_socket_pollin(struct t_mympd_state *mympd_state, nfds_t i, st
                 if (*request == NULL) {
                     break;
                 }
-                struct t_partition_state *partition_state = partitions_get_by_name(mympd_state, (*request)->partition);
-                if (partition_state == NULL) {
-                    MYMPD_LOG_ERROR(NULL, "Unable to find partition for queue fd: %d", mympd_state->pfds.fds[i].fd);
-                    break;
-                }
-                MYMPD_LOG_DEBUG(partition_state->name, "Queue event");
-                partition_state->waiting_events |= PFD_TYPE_QUEUE;
+                set_queue_event(mympd_state, *request);
             }
             break;
         case PFD_TYPE_PARTITION:
@@ -307,3 +330,39 @@ static void populate_pfds(struct t_mympd_state *mympd_state) {
         MYMPD_LOG_DEBUG(NULL, "Polling %lu fds", mympd_state->pfds.len);
     #endif
 }
+
+/**
+ * Sets the queue event for the partition of the request
+ * @param mympd_state pointer to mympd state
+ * @param request the work request
+ */
+static void set_queue_event(struct t_mympd_state *mympd_state, struct t_work_request *request) {
+    struct t_partition_state *partition_state = partitions_get_by_name(mympd_state, request->partition);
+    if (partition_state == NULL) {
+        MYMPD_LOG_ERROR(NULL, "Unable to find partition \"%s\" for queue event", request->partition);
+        return;
+    }
+    MYMPD_LOG_DEBUG(partition_state->name, "Queue event");
+    partition_state->waiting_events |= PFD_TYPE_QUEUE;
+}
+
+/**
+ * Handles the requests that arrived together with the request of the queue event.
+ * The batch is limited, remaining requests are handled after the next poll
+ * to not starve the other file descriptors.
+ * @param mympd_state pointer to mympd state
+ * @return true if a request was handled, else false
+ */
+static bool handle_queue_batch(struct t_mympd_state *mympd_state) {
+    void *batch[MYMPD_QUEUE_BATCH_SIZE - 1];
+    size_t count = mympd_queue_shift_batch(mympd_api_queue, batch, MYMPD_QUEUE_BATCH_SIZE - 1);
+    for (size_t i = 0; i < count; i++) {
+        struct t_work_request *request = batch[i];
+        set_queue_event(mympd_state, request);
+        mympd_client_idle(mympd_state, request);
+    }
+    if (mympd_queue_length(mympd_api_queue) > 0) {
+        event_eventfd_write(mympd_api_queue->event_fd);
+    }
+    return count > 0;
+}
@@ -14,10 +14,12 @@
 #include "src/lib/api.h"
 #include "src/lib/cache/cache_rax_album.h"
 #include "src/lib/config/mympd_state.h"
+#include "src/lib/json/json_query.h"
 #include "src/lib/json/json_rpc.h"
 #include "src/lib/list/list.h"
 #include "src/lib/log.h"
 #include "src/lib/mem.h"
+#include "src/lib/metrics.h"
 #include "src/lib/sds/sds_extras.h"
 #include "src/lib/smartpls.h"
 #include "src/lib/thread.h"
@@ -26,6 +28,7 @@
 #include "src/lib/validate.h"
 #include "src/lib/webradio.h"
 #include "src/mympd_api/albumart.h"
+#include "src/mympd_api/albumart_fetch.h"
 #include "src/mympd_api/albums.h"
 #include "src/mympd_api/channel.h"
 #include "src/mympd_api/database.h"
@@ -77,6 +80,7 @@
 #include <assert.h>
 #include <stdbool.h>
 #include <string.h>
+#include <time.h>
 
 /**
  * Central myMPD api handler function
@@ -107,6 +111,9 @@ void mympd_api_handler(struct t_mympd_state *mympd_state, struct t_partition_sta
     struct t_json_parse_error parse_error;
     json_parse_error_init(&parse_error);
 
+    struct t_metrics_request request_metrics;
+    metrics_request_begin(&request_metrics, &request->queued);
+
     #ifdef MYMPD_DEBUG
         MEASURE_INIT
         MEASURE_START
@@ -122,8 +129,11 @@ void mympd_api_handler(struct t_mympd_state *mympd_state, struct t_partition_sta
     //create response struct
     struct t_work_response *response = create_response(request);
 
+    //tokenize the request once for all json_get_* calls
+    json_query_bind(request->data);
+
     switch(request->cmd_id) {
-    // methods that are delegated to a new worker thread
+    // methods that are delegated to the worker pool
         case MYMPD_API_CACHE_DISK_CROP:
         case MYMPD_API_CACHE_DISK_CLEAR:
         case MYMPD_API_CACHES_CREATE:
@@ -144,10 +154,10 @@ void mympd_api_handler(struct t_mympd_state *mympd_state, struct t_partition_sta
         case MYMPD_API_SMARTPLS_UPDATE_ALL:
         case MYMPD_API_SONG_FINGERPRINT:
         case MYMPD_API_WEBRADIODB_UPDATE:
-            if (mympd_worker_threads > MAX_MPD_WORKER_THREADS) {
+            if (mympd_worker_pool_accepts_jobs() == false) {
                 response->data = jsonrpc_respond_message(response->data, request->cmd_id, request->id,
-                    JSONRPC_FACILITY_GENERAL, JSONRPC_SEVERITY_ERROR, "Too many worker threads are already running");
-                MYMPD_LOG_ERROR(partition_state->name, "Too many worker threads are already running");
+                    JSONRPC_FACILITY_GENERAL, JSONRPC_SEVERITY_ERROR, "Too many worker jobs are already queued");
+                MYMPD_LOG_ERROR(partition_state->name, "Too many worker jobs are already queued");
                 break;
             }
             if (request->cmd_id == MYMPD_API_CACHES_CREATE ||
@@ -189,7 +199,7 @@ void mympd_api_handler(struct t_mympd_state *mympd_state, struct t_partition_sta
             async = mympd_worker_start(mympd_state, partition_state, request);
             if (async == false) {
                 response->data = jsonrpc_respond_message(response->data, request->cmd_id, request->id,
-                        JSONRPC_FACILITY_GENERAL, JSONRPC_SEVERITY_ERROR, "Error starting worker thread");
+                        JSONRPC_FACILITY_GENERAL, JSONRPC_SEVERITY_ERROR, "Error queuing worker job");
                 mympd_state->album_cache.building = false;
             }
             break;
@@ -203,16 +213,20 @@ void mympd_api_handler(struct t_mympd_state *mympd_state, struct t_partition_sta
             if (request->extra != NULL) {
                 //free the old album cache and replace it with the freshly generated one
                 if (cache_get_write_lock(&mympd_state->album_cache) == false) {
-                    album_cache_free_rt(request->extra);
+                    album_cache_free_void(request->extra);
                     request->extra = NULL;
                     send_jsonrpc_notify(JSONRPC_FACILITY_DATABASE, JSONRPC_SEVERITY_ERROR, MPD_PARTITION_ALL, "Album cache could not be replaced");
                     break;
                 }
                 album_cache_free(&mympd_state->album_cache);
-                mympd_state->album_cache.cache = (rax *) request->extra;
+                struct t_cache *new_album_cache = (struct t_cache *) request->extra;
+                mympd_state->album_cache.cache = new_album_cache->cache;
+                mympd_state->album_cache.index = new_album_cache->index;
+                mympd_state->album_cache.pool = new_album_cache->pool;
+                mympd_state->album_cache.map = new_album_cache->map;
                 mympd_state->album_cache.mtime = time(NULL);
                 cache_release_lock(&mympd_state->album_cache);
-                request->extra = NULL;
+                FREE_PTR(request->extra);
                 MYMPD_LOG_INFO(partition_state->name, "Album cache was replaced");
             }
             else {
@@ -260,7 +274,10 @@ void mympd_api_handler(struct t_mympd_state *mympd_state, struct t_partition_sta
             response->data = mympd_api_channel_messages_read(partition_state, response->data, request->id);
             break;
         case MYMPD_API_STATS:
-            response->data = mympd_api_stats_get(partition_state, response->data, request->id);
+            response->data = mympd_api_stats_get(mympd_state, partition_state, response->data, request->id);
+            break;
+        case MYMPD_API_STATS_METRICS:
+            response->data = mympd_api_stats_metrics(response->data, request->id);
             break;
     // Folderart
         case INTERNAL_API_FOLDERART:
@@ -306,14 +323,23 @@ void mympd_api_handler(struct t_mympd_state *mympd_state, struct t_partition_sta
     // Albumart
         case INTERNAL_API_ALBUMART_BY_URI:
             if (json_get_string(request->data, "$.params.uri", 1, FILEPATH_LEN_MAX, &sds_buf1, vcb_isfilepath, &parse_error) == true) {
-                response->extra = sdsempty();
-                response->extra_free = sds_free_void;
-                response->data = mympd_api_albumart_getcover_by_uri(mympd_state, partition_state, response->data, request->id, request->conn_id, sds_buf1, &response->extra);
-                if (sdslen(response->data) == 0) {
-                    // response must be send by triggered script
+                if (json_find_key(request->data, "$.params.fetched") == true) {
+                    // mpd has no albumart for this uri
+                    response->data = mympd_api_albumart_not_found(mympd_state, partition_state, response->data, request->id, request->conn_id, sds_buf1);
+                    if (sdslen(response->data) == 0) {
+                        // response must be send by triggered script
+                        async = true;
+                        // we do not pass the request to the script thread
+                        free_request(request);
+                    }
+                }
+                else if (mympd_api_albumart_fetch_push(mympd_state, partition_state, request, sds_buf1) == true) {
+                    // response is sent by the albumart fetch threads
                     async = true;
-                    // we do not pass the request to the script thread
-                    free_request(request);
+                }
+                else {
+                    response->data = jsonrpc_respond_message(response->data, request->cmd_id, request->id,
+                        JSONRPC_FACILITY_MPD, JSONRPC_SEVERITY_ERROR, "Too many queued albumart requests");
                 }
             }
             break;
@@ -1843,7 +1869,7 @@ void mympd_api_handler(struct t_mympd_state *mympd_state, struct t_partition_sta
                 json_get_string(request->data, "$.params.tag", 1, NAME_LEN_MAX, &sds_buf2, vcb_ismpdtag_or_any, &parse_error) == true &&
                 json_get_bool(request->data, "$.params.sortdesc", &bool_buf1, &parse_error) == true)
             {
-                response->data = mympd_api_tag_list(partition_state, response->data, request->id,
+                response->data = mympd_api_tag_list(mympd_state, partition_state, response->data, request->id,
                         sds_buf1, sds_buf2, uint_buf1, uint_buf2, bool_buf1);
             }
             break;
@@ -1943,8 +1969,10 @@ void mympd_api_handler(struct t_mympd_state *mympd_state, struct t_partition_sta
                 // switch the rax pointers
                 mympd_state->webradiodb->db = new->db;
                 mympd_state->webradiodb->idx_uris = new->idx_uris;
+                mympd_state->webradiodb->pool = new->pool;
                 new->db = NULL;
                 new->idx_uris = NULL;
+                new->pool = NULL;
                 webradios_free(new);
                 webradios_release_lock(mympd_state->webradiodb);
                 send_jsonrpc_notify(JSONRPC_FACILITY_DATABASE, JSONRPC_SEVERITY_INFO, MPD_PARTITION_ALL, "WebradioDB updated");
@@ -2057,6 +2085,7 @@ void mympd_api_handler(struct t_mympd_state *mympd_state, struct t_partition_sta
                 JSONRPC_FACILITY_GENERAL, JSONRPC_SEVERITY_ERROR, "Unknown request");
             MYMPD_LOG_ERROR(partition_state->name, "Unknown API request: %.*s", (int)sdslen(request->data), request->data);
     }
+    json_query_unbind();
 
     FREE_SDS(sds_buf0);
     FREE_SDS(sds_buf1);
@@ -2070,6 +2099,8 @@ void mympd_api_handler(struct t_mympd_state *mympd_state, struct t_partition_sta
         MEASURE_END
         MEASURE_PRINT(partition_state->name, method)
     #endif
+    // the execution time of the handler, the start timestamp is shared with the request metrics
+    histogram_add_since(&mympd_state->control_latency, &request_metrics.started);
 
     //async request handling
     //request was forwarded to worker thread - do not free it
@@ -2101,8 +2132,10 @@ void mympd_api_handler(struct t_mympd_state *mympd_state, struct t_partition_sta
             MYMPD_LOG_ERROR(partition_state->name, "No response for method \"%s\"", method);
         }
     }
+    enum mympd_cmd_ids cmd_id = request->cmd_id;
     push_response(response);
     free_request(request);
+    metrics_request_end(&request_metrics, cmd_id);
     FREE_SDS(error);
     json_parse_error_clear(&parse_error);
 }
@@ -20,6 +20,7 @@
 #include "src/lib/list/sort.h"
 #include "src/lib/log.h"
 #include "src/lib/mem.h"
+#include "src/lib/playlist_catalogue.h"
 #include "src/lib/rax_extras.h"
 #include "src/lib/sds/sds_extras.h"
 #include "src/lib/sds/sds_utf8.h"
@@ -50,16 +51,6 @@ struct t_pl_data {
     sds name;                  //!< playlistname
 };
 
-/**
- * Frees the t_pl_data struct used as callback for rax_free_data
- * @param data void pointer to a t_sticker_value struct
- */
-static void free_t_pl_data(void *data) {
-    struct t_pl_data *pl_data = (struct t_pl_data *)data;
-    FREE_SDS(pl_data->name);
-    FREE_PTR(pl_data);
-}
-
 /**
  * Moves entries from one playlist to another.
  * @param partition_state pointer to partition state
@@ -87,6 +78,7 @@ bool mympd_api_playlist_content_move_to_playlist(struct t_partition_state *parti
         list_free(src);
         return false;
     }
+    playlist_catalogue_clear(&partition_state->mpd_state->playlist_catalogue);
     list_sort_by_value_i(positions, LIST_SORT_DESC);
     if (mpd_command_list_begin(partition_state->conn, false)) {
         struct t_list_node *current;
@@ -149,6 +141,7 @@ bool mympd_api_playlist_copy(struct t_partition_state *partition_state,
         current = current->next;
     }
 
+    playlist_catalogue_clear(&partition_state->mpd_state->playlist_catalogue);
     if (mode == PLAYLIST_COPY_REPLACE) {
         //clear dst playlist
         mpd_run_playlist_clear(partition_state->conn, dst_plist);
@@ -213,6 +206,7 @@ bool mympd_api_playlist_content_insert(struct t_partition_state *partition_state
         *error = sdscat(*error, "No uris provided");
         return false;
     }
+    playlist_catalogue_clear(&partition_state->mpd_state->playlist_catalogue);
     if (mpd_command_list_begin(partition_state->conn, false)) {
         struct t_list_node *current;
         while ((current = list_shift_first(uris)) != NULL) {
@@ -449,6 +443,7 @@ bool mympd_api_playlist_content_replace_album_tag(struct t_partition_state *part
  * @return true on success, else false
  */
 bool mympd_api_playlist_content_move(struct t_partition_state *partition_state, sds plist, unsigned from, unsigned to, sds *error) {
+    playlist_catalogue_clear(&partition_state->mpd_state->playlist_catalogue);
     mpd_run_playlist_move(partition_state->conn, plist, from, to);
     return mympd_check_error_and_recover(partition_state, error, "mpd_run_playlist_move");
 }
@@ -467,6 +462,7 @@ bool mympd_api_playlist_content_rm_range(struct t_partition_state *partition_sta
     unsigned end_u = end < 0
         ? UINT_MAX
         : (unsigned)end;
+    playlist_catalogue_clear(&partition_state->mpd_state->playlist_catalogue);
     mpd_run_playlist_delete_range(partition_state->conn, plist, start, end_u);
     return mympd_check_error_and_recover(partition_state, error, "mpd_run_playlist_delete_range");
 }
@@ -484,6 +480,7 @@ bool mympd_api_playlist_content_rm_positions(struct t_partition_state *partition
         *error = sdscat(*error, "No song positions provided");
         return false;
     }
+    playlist_catalogue_clear(&partition_state->mpd_state->playlist_catalogue);
     list_sort_by_value_i(positions, LIST_SORT_DESC);
     if (mpd_command_list_begin(partition_state->conn, false)) {
         struct t_list_node *current;
@@ -533,41 +530,47 @@ sds mympd_api_playlist_list(struct t_partition_state *partition_state, struct t_
     size_t searchstr_len;
     char *searchstr_utf8 = utf8_wrap_normalize(searchstr, sdslen(searchstr), &searchstr_len);
 
-    if (mpd_send_list_playlists(partition_state->conn)) {
-        struct mpd_playlist *pl;
-        while ((pl = mpd_recv_playlist(partition_state->conn)) != NULL) {
-            const char *plpath = mpd_playlist_get_path(pl);
-            size_t value_len;
-            char *value_utf8 = utf8_wrap_normalize(plpath, strlen(plpath), &value_len);
-            bool smartpls = is_smartpls(partition_state->config->workdir, plpath);
-            if ((searchstr_len == 0 || strstr(value_utf8, searchstr_utf8) != NULL) &&
-                (type == PLTYPE_ALL || (type == PLTYPE_STATIC && smartpls == false) || (type == PLTYPE_SMART && smartpls == true)))
-            {
-                struct t_pl_data *data = malloc_assert(sizeof(struct t_pl_data));
-                data->last_modified = mpd_playlist_get_last_modified(pl);
-                data->type = smartpls == true
-                    ? PLTYPE_SMART
-                    : PLTYPE_STATIC;
-                data->name = sdsnew(plpath);
-                sdsclear(key);
-                if (sort == PLSORT_LAST_MODIFIED) {
-                    key = sds_pad_int(data->last_modified, key);
-                }
-                key = sdscatsds(key, data->name);
-                key = sds_utf8_normalize(key);
-                rax_insert_no_dup(entity_list, key, data);
-            }
-            mpd_playlist_free(pl);
-            FREE_PTR(value_utf8);
-        }
-    }
-    if (mympd_check_error_and_recover_respond(partition_state, &buffer, cmd_id, request_id, "mpd_send_list_playlists") == false) {
-        //free result
-        rax_free_data(entity_list, free_t_pl_data);
+    sds error = sdsempty();
+    struct t_playlist_catalogue *catalogue = mympd_client_playlist_catalogue(partition_state, &error);
+    if (catalogue == NULL) {
+        raxFree(entity_list);
         FREE_SDS(key);
+        FREE_PTR(searchstr_utf8);
         //return error message
+        buffer = jsonrpc_respond_message(buffer, cmd_id, request_id,
+            JSONRPC_FACILITY_MPD, JSONRPC_SEVERITY_ERROR, error);
+        FREE_SDS(error);
         return buffer;
     }
+    FREE_SDS(error);
+    raxIterator cat_iter;
+    raxStart(&cat_iter, catalogue->playlists);
+    raxSeek(&cat_iter, "^", NULL, 0);
+    while (raxNext(&cat_iter)) {
+        const struct t_playlist_catalogue_entry *entry = (const struct t_playlist_catalogue_entry *)cat_iter.data;
+        size_t value_len;
+        char *value_utf8 = utf8_wrap_normalize((char *)cat_iter.key, cat_iter.key_len, &value_len);
+        bool smartpls = entry->smartpls;
+        if ((searchstr_len == 0 || strstr(value_utf8, searchstr_utf8) != NULL) &&
+            (type == PLTYPE_ALL || (type == PLTYPE_STATIC && smartpls == false) || (type == PLTYPE_SMART && smartpls == true)))
+        {
+            struct t_pl_data *data = malloc_assert(sizeof(struct t_pl_data));
+            data->last_modified = entry->last_modified;
+            data->type = smartpls == true
+                ? PLTYPE_SMART
+                : PLTYPE_STATIC;
+            data->name = sdsnewlen(cat_iter.key, cat_iter.key_len);
+            sdsclear(key);
+            if (sort == PLSORT_LAST_MODIFIED) {
+                key = sds_pad_int(data->last_modified, key);
+            }
+            key = sdscatsds(key, data->name);
+            key = sds_utf8_normalize(key);
+            rax_insert_no_dup(entity_list, key, data);
+        }
+        FREE_PTR(value_utf8);
+    }
+    raxStop(&cat_iter);
 
     //add empty smart playlists
     if (type != PLTYPE_STATIC) {
@@ -939,6 +942,7 @@ sds mympd_api_playlist_rename(struct t_partition_state *partition_state, sds buf
     FREE_SDS(old_pl_file);
     FREE_SDS(new_pl_file);
     //rename mpd playlist
+    playlist_catalogue_clear(&partition_state->mpd_state->playlist_catalogue);
     mpd_run_rename(partition_state->conn, old_playlist, new_playlist);
     if (mympd_check_error_and_recover_respond(partition_state, &buffer, cmd_id, request_id, "mpd_run_rename") == true) {
         buffer = jsonrpc_respond_message(buffer, cmd_id, request_id,
@@ -960,13 +964,11 @@ bool mympd_api_playlist_delete(struct t_partition_state *partition_state, struct
         *error = sdscat(*error, "No playlists provided");
         return false;
     }
-    struct t_list all_plists;
-    list_init(&all_plists);
-    bool rc = mympd_client_get_all_playlists(partition_state, &all_plists, true, error);
-    if (rc == false) {
-        list_clear(&all_plists);
+    struct t_playlist_catalogue *catalogue = mympd_client_playlist_catalogue(partition_state, error);
+    if (catalogue == NULL) {
         return false;
     }
+    bool rc = true;
 
     struct t_list_node *current = playlists->head;
     sds pl_file = sdsempty();
@@ -984,7 +986,7 @@ bool mympd_api_playlist_delete(struct t_partition_state *partition_state, struct
             }
             sdsclear(pl_file);
             // try to remove mpd playlist
-            if (list_get_node(&all_plists, current->key) != NULL) {
+            if (playlist_catalogue_get(catalogue, current->key) != NULL) {
                 if (mpd_send_rm(partition_state->conn, current->key) == false) {
                     mympd_set_mpd_failure(partition_state, "Error adding command to command list mpd_send_rm");
                     break;
@@ -1000,7 +1002,8 @@ bool mympd_api_playlist_delete(struct t_partition_state *partition_state, struct
         // send update event manually if only smart playlists definitions are deleted
         send_jsonrpc_event(JSONRPC_EVENT_UPDATE_STORED_PLAYLIST, partition_state->name);
     }
-    list_clear(&all_plists);
+    // the smart playlist flags have changed
+    playlist_catalogue_clear(catalogue);
     return mympd_check_error_and_recover(partition_state, error, "mpd_send_rm") && rc;
 }
 
@@ -1039,6 +1042,8 @@ sds mympd_api_playlist_delete_all(struct t_partition_state *partition_state, sds
         return jsonrpc_respond_message(buffer, cmd_id, request_id, JSONRPC_FACILITY_PLAYLIST, JSONRPC_SEVERITY_ERROR, "Invalid deletion criteria");
     }
 
+    //the cached counts could be outdated
+    playlist_catalogue_clear(&partition_state->mpd_state->playlist_catalogue);
     //get all mpd playlists
     struct t_list playlists;
     list_init(&playlists);
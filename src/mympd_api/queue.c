@@ -15,7 +15,10 @@
 #include "src/lib/json/json_print.h"
 #include "src/lib/json/json_rpc.h"
 #include "src/lib/log.h"
+#include "src/lib/playlist_catalogue.h"
+#include "src/lib/queue_mirror.h"
 #include "src/lib/sds/sds_extras.h"
+#include "src/lib/search/search.h"
 #include "src/lib/utility.h"
 #include "src/mympd_api/sticker.h"
 #include "src/mympd_api/webradio.h"
@@ -35,7 +38,15 @@
 static bool add_queue_search_adv_params(struct t_partition_state *partition_state,
         sds sort, bool sortdesc, unsigned offset, unsigned limit);
 static sds print_queue_entry(struct t_mympd_state *mympd_state, struct t_partition_state *partition_state,
-        sds buffer, const struct t_fields *tagcols, bool print_stickers, struct mpd_song *song);
+        sds buffer, const struct t_fields *tagcols, bool print_stickers, const struct mpd_song *song);
+static bool queue_mirror_check(struct t_partition_state *partition_state);
+static sds queue_list_mirror(struct t_mympd_state *mympd_state, struct t_partition_state *partition_state,
+        sds buffer, unsigned request_id, unsigned offset, unsigned limit, const struct t_fields *tagcols);
+static sds queue_search_mirror(struct t_mympd_state *mympd_state, struct t_partition_state *partition_state,
+        sds buffer, unsigned request_id, sds expression, sds sort, bool sortdesc, unsigned offset, unsigned limit,
+        const struct t_fields *tagcols);
+static rax *queue_mirror_sort(struct t_partition_state *partition_state, const struct t_list *expr_list,
+        const struct t_fields *tagcols, sds sort, bool *sortdesc);
 
 /**
  * Public functions
@@ -50,6 +61,7 @@ static sds print_queue_entry(struct t_mympd_state *mympd_state, struct t_partiti
  * @return bool true on success, else false
  */
 bool mympd_api_queue_save(struct t_partition_state *partition_state, sds name, sds mode, sds *error) {
+    playlist_catalogue_clear(&partition_state->mpd_state->playlist_catalogue);
     if (partition_state->mpd_state->feat.advqueue == true) {
         enum mpd_queue_save_mode save_mode = mpd_parse_queue_save_mode(mode);
         if (save_mode == MPD_QUEUE_SAVE_MODE_UNKNOWN) {
@@ -758,6 +770,7 @@ sds mympd_api_queue_crop(struct t_partition_state *partition_state, sds buffer,
 
 /**
  * Lists the queue, this is faster for older MPD servers than the search function below.
+ * The queue is served from the queue mirror if it is in sync with MPD.
  * @param mympd_state pointer to mympd_state
  * @param partition_state pointer to partition state
  * @param buffer already allocated sds string to append the response
@@ -771,7 +784,9 @@ sds mympd_api_queue_list(struct t_mympd_state *mympd_state, struct t_partition_s
         sds buffer, unsigned request_id, unsigned offset, unsigned limit, const struct t_fields *tagcols)
 {
     enum mympd_cmd_ids cmd_id = MYMPD_API_QUEUE_SEARCH;
-    //update the queue status
+    if (queue_mirror_check(partition_state) == true) {
+        return queue_list_mirror(mympd_state, partition_state, buffer, request_id, offset, limit, tagcols);
+    }
     mympd_client_queue_status_update(partition_state);
     //Check offset
     if (offset >= partition_state->queue_length) {
@@ -822,7 +837,8 @@ sds mympd_api_queue_list(struct t_mympd_state *mympd_state, struct t_partition_s
 }
 
 /**
- * Searches the queue
+ * Searches the queue.
+ * The queue is served from the queue mirror if it is in sync with MPD.
  * @param mympd_state pointer to mympd_state
  * @param partition_state pointer to partition state
  * @param buffer already allocated sds string to append the response
@@ -840,7 +856,10 @@ sds mympd_api_queue_search(struct t_mympd_state *mympd_state, struct t_partition
         const struct t_fields *tagcols)
 {
     enum mympd_cmd_ids cmd_id = MYMPD_API_QUEUE_SEARCH;
-    //update the queue status
+    if (queue_mirror_check(partition_state) == true) {
+        return queue_search_mirror(mympd_state, partition_state, buffer, request_id, expression, sort, sortdesc,
+            offset, limit, tagcols);
+    }
     mympd_client_queue_status_update(partition_state);
 
     sds real_expression = sdslen(expression) == 0
@@ -981,7 +1000,7 @@ static bool add_queue_search_adv_params(struct t_partition_state *partition_stat
  * @return pointer to buffer
  */
 static sds print_queue_entry(struct t_mympd_state *mympd_state, struct t_partition_state *partition_state,
-        sds buffer, const struct t_fields *tagcols, bool print_stickers, struct mpd_song *song)
+        sds buffer, const struct t_fields *tagcols, bool print_stickers, const struct mpd_song *song)
 {
     buffer = sdscatlen(buffer, "{", 1);
     buffer = tojson_uint(buffer, "id", mpd_song_get_id(song), true);
@@ -1015,3 +1034,213 @@ static sds print_queue_entry(struct t_mympd_state *mympd_state, struct t_partiti
     buffer = sdscatlen(buffer, "}", 1);
     return buffer;
 }
+
+/**
+ * Checks if the queue mirror is in sync with MPD.
+ * The idle mode is left before each request and the queue idle events,
+ * also from earlier requests, are already parsed. The queue version
+ * from this status is used, the queue mirror is loaded if it is not valid.
+ * @param partition_state pointer to partition state
+ * @return true if the queue mirror can be used, else false
+ */
+static bool queue_mirror_check(struct t_partition_state *partition_state) {
+    return mympd_client_queue_mirror_update(partition_state);
+}
+
+/**
+ * Lists the queue from the queue mirror
+ * @param mympd_state pointer to mympd_state
+ * @param partition_state pointer to partition state
+ * @param buffer already allocated sds string to append the response
+ * @param request_id jsonrpc id
+ * @param offset offset for the list
+ * @param limit maximum entries to print
+ * @param tagcols columns to print
+ * @return pointer to buffer
+ */
+static sds queue_list_mirror(struct t_mympd_state *mympd_state, struct t_partition_state *partition_state,
+        sds buffer, unsigned request_id, unsigned offset, unsigned limit, const struct t_fields *tagcols)
+{
+    enum mympd_cmd_ids cmd_id = MYMPD_API_QUEUE_SEARCH;
+    const struct t_queue_mirror *mirror = &partition_state->queue_mirror;
+    bool print_stickers = check_get_sticker(partition_state->mpd_state->feat.stickers, &tagcols->stickers);
+    if (print_stickers == true) {
+        stickerdb_exit_idle(mympd_state->stickerdb);
+    }
+    buffer = jsonrpc_respond_start(buffer, cmd_id, request_id);
+    buffer = sdscat(buffer, "\"data\":[");
+    unsigned entities_returned = 0;
+    for (unsigned pos = offset; pos < mirror->length && entities_returned < limit; pos++) {
+        if (entities_returned++) {
+            buffer = sdscatlen(buffer, ",", 1);
+        }
+        buffer = print_queue_entry(mympd_state, partition_state, buffer, tagcols, print_stickers,
+            queue_mirror_get(mirror, pos));
+    }
+    if (print_stickers == true) {
+        stickerdb_enter_idle(mympd_state->stickerdb);
+    }
+    buffer = sdscatlen(buffer, "],", 2);
+    buffer = tojson_uint64(buffer, "totalTime", mirror->total_time, true);
+    buffer = tojson_uint(buffer, "totalEntities", mirror->length, true);
+    buffer = tojson_uint(buffer, "offset", offset, true);
+    buffer = tojson_uint(buffer, "returnedEntities", entities_returned, false);
+    buffer = jsonrpc_end(buffer);
+    return buffer;
+}
+
+/**
+ * Searches and sorts the queue mirror
+ * @param mympd_state pointer to mympd_state
+ * @param partition_state pointer to partition state
+ * @param buffer already allocated sds string to append the response
+ * @param request_id jsonrpc id
+ * @param expression mpd filter expression
+ * @param sort tag to sort, empty to keep the queue order
+ * @param sortdesc false = ascending, true = descending sort
+ * @param offset offset for the list
+ * @param limit maximum entries to print, 0 for no limit
+ * @param tagcols columns to print
+ * @return pointer to buffer
+ */
+static sds queue_search_mirror(struct t_mympd_state *mympd_state, struct t_partition_state *partition_state,
+        sds buffer, unsigned request_id, sds expression, sds sort, bool sortdesc, unsigned offset, unsigned limit,
+        const struct t_fields *tagcols)
+{
+    enum mympd_cmd_ids cmd_id = MYMPD_API_QUEUE_SEARCH;
+    const struct t_queue_mirror *mirror = &partition_state->queue_mirror;
+    struct t_list *expr_list = search_expression_parse(expression, SEARCH_TYPE_SONG);
+    if (expr_list == NULL) {
+        return jsonrpc_respond_message(buffer, cmd_id, request_id, JSONRPC_FACILITY_QUEUE,
+            JSONRPC_SEVERITY_ERROR, "Invalid search expression");
+    }
+    const unsigned real_limit = limit == 0
+        ? UINT_MAX
+        : limit;
+    bool print_stickers = check_get_sticker(partition_state->mpd_state->feat.stickers, &tagcols->stickers);
+    if (print_stickers == true) {
+        stickerdb_exit_idle(mympd_state->stickerdb);
+    }
+    buffer = jsonrpc_respond_start(buffer, cmd_id, request_id);
+    buffer = sdscat(buffer, "\"data\":[");
+    uint64_t total_time = 0;
+    unsigned entities_found = 0;
+    unsigned entities_returned = 0;
+    rax *sorted = queue_mirror_sort(partition_state, expr_list, tagcols, sort, &sortdesc);
+    if (sorted != NULL) {
+        raxIterator iter;
+        raxStart(&iter, sorted);
+        int (*iterator)(struct raxIterator *iter);
+        if (sortdesc == false) {
+            raxSeek(&iter, "^", NULL, 0);
+            iterator = &raxNext;
+        }
+        else {
+            raxSeek(&iter, "$", NULL, 0);
+            iterator = &raxPrev;
+        }
+        while (iterator(&iter)) {
+            const struct mpd_song *song = (const struct mpd_song *)iter.data;
+            total_time += mpd_song_get_duration(song);
+            if (entities_found++ >= offset &&
+                entities_returned < real_limit)
+            {
+                if (entities_returned++) {
+                    buffer = sdscatlen(buffer, ",", 1);
+                }
+                buffer = print_queue_entry(mympd_state, partition_state, buffer, tagcols, print_stickers, song);
+            }
+        }
+        raxStop(&iter);
+        raxFree(sorted);
+    }
+    else {
+        for (unsigned pos = 0; pos < mirror->length; pos++) {
+            const struct mpd_song *song = queue_mirror_get(mirror, pos);
+            if (search_expression_song(song, expr_list, &tagcols->mpd_tags) == false) {
+                continue;
+            }
+            total_time += mpd_song_get_duration(song);
+            if (entities_found++ >= offset &&
+                entities_returned < real_limit)
+            {
+                if (entities_returned++) {
+                    buffer = sdscatlen(buffer, ",", 1);
+                }
+                buffer = print_queue_entry(mympd_state, partition_state, buffer, tagcols, print_stickers, song);
+            }
+        }
+    }
+    search_expression_free(expr_list);
+    if (print_stickers == true) {
+        stickerdb_enter_idle(mympd_state->stickerdb);
+    }
+    buffer = sdscatlen(buffer, "],", 2);
+    buffer = tojson_uint64(buffer, "totalTime", total_time, true);
+    buffer = tojson_uint(buffer, "totalEntities", entities_found, true);
+    buffer = tojson_uint(buffer, "offset", offset, true);
+    buffer = tojson_uint(buffer, "returnedEntities", entities_returned, false);
+    buffer = jsonrpc_end(buffer);
+    return buffer;
+}
+
+/**
+ * Filters and sorts the songs of the queue mirror like the MPD queue search
+ * @param partition_state pointer to partition state
+ * @param expr_list parsed search expression
+ * @param tagcols columns to print, the tags are used for the any tag filter
+ * @param sort tag to sort
+ * @param sortdesc pointer to sort direction, it is swapped for timestamps like in add_queue_search_adv_params
+ * @return rax with sort keys pointing to the songs or NULL if the queue order should be kept
+ */
+static rax *queue_mirror_sort(struct t_partition_state *partition_state, const struct t_list *expr_list,
+        const struct t_fields *tagcols, sds sort, bool *sortdesc)
+{
+    enum sort_by_type sort_by = SORT_BY_TAG;
+    bool sort_prio = false;
+    enum mpd_tag_type sort_tag = mpd_tag_name_parse(sort);
+    if (sort_tag != MPD_TAG_UNKNOWN) {
+        // the songs of the queue mirror have only the tags enabled for myMPD
+        sort_tag = get_sort_tag(sort_tag, &partition_state->mpd_state->tags_mympd);
+    }
+    else if (strcmp(sort, "Last-Modified") == 0) {
+        sort_by = SORT_BY_LAST_MODIFIED;
+    }
+    else if (strcmp(sort, "Added") == 0) {
+        sort_by = SORT_BY_ADDED;
+    }
+    else if (strcmp(sort, "Priority") == 0) {
+        sort_prio = true;
+    }
+    else {
+        if (sdslen(sort) > 0) {
+            MYMPD_LOG_WARN(partition_state->name, "Unknown sort tag: %s", sort);
+        }
+        return NULL;
+    }
+    if (sort_by != SORT_BY_TAG) {
+        //swap order
+        *sortdesc = *sortdesc == false
+            ? true
+            : false;
+    }
+    const struct t_queue_mirror *mirror = &partition_state->queue_mirror;
+    rax *sorted = raxNew();
+    sds key = sdsempty();
+    for (unsigned pos = 0; pos < mirror->length; pos++) {
+        const struct mpd_song *song = queue_mirror_get(mirror, pos);
+        if (search_expression_song(song, expr_list, &tagcols->mpd_tags) == false) {
+            continue;
+        }
+        key = sort_prio == true
+            ? sds_pad_int((int64_t)mpd_song_get_prio(song), key)
+            : get_sort_key(key, sort_by, sort_tag, song);
+        // the queue position makes the key unique and the sort stable
+        key = sdscatlen(key, "::", 2);
+        key = sds_pad_int((int64_t)pos, key);
+        raxInsert(sorted, (unsigned char *)key, sdslen(key), (void *)song, NULL);
+        sdsclear(key);
+    }
+    FREE_SDS(key);
+    return sorted;
+}
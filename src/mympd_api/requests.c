@@ -21,7 +21,8 @@
  */
 bool mympd_api_request_caches_create(void) {
     struct t_work_request *request = create_request(REQUEST_TYPE_DISCARD, 0, 0, MYMPD_API_CACHES_CREATE, NULL, MPD_PARTITION_DEFAULT);
-    request->data = sdscat(request->data, "\"force\":true}}"); // Always update
+    // Always update, database changes are applied incrementally
+    request->data = sdscat(request->data, "\"force\":true,\"incremental\":true}}");
     return push_request(request, 0);
 }
 
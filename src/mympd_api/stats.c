@@ -11,20 +11,47 @@
 #include "compile_time.h"
 #include "src/mympd_api/stats.h"
 
+#include "src/lib/cache/cache_disk_index.h"
+#include "src/lib/cache/cache_rax_album.h"
+#include "src/lib/dir_cache.h"
+#include "src/lib/histogram.h"
+#include "src/lib/image_index.h"
 #include "src/lib/json/json_print.h"
 #include "src/lib/json/json_rpc.h"
+#include "src/lib/metrics.h"
+#include "src/lib/msg_queue.h"
 #include "src/lib/sds/sds_extras.h"
+#include "src/lib/sds/sds_json.h"
 #include "src/lib/utility.h"
+#include "src/mympd_api/albumart_fetch.h"
 #include "src/mympd_client/errorhandler.h"
+#include "src/mympd_worker/mympd_worker.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * Private definitions
+ */
+
+static sds print_queue_stats(sds buffer, struct t_mympd_queue *queue, bool comma);
+static uint64_t get_rss(void);
+
+/**
+ * Public functions
+ */
 
 /**
  * Get mpd statistics
+ * @param mympd_state pointer to mympd state
  * @param partition_state pointer to partition state
  * @param buffer already allocated sds string to append the response
  * @param request_id jsonrpc request id
  * @return pointer to buffer
  */
-sds mympd_api_stats_get(struct t_partition_state *partition_state, sds buffer, unsigned request_id) {
+sds mympd_api_stats_get(struct t_mympd_state *mympd_state, struct t_partition_state *partition_state, sds buffer, unsigned request_id) {
     enum mympd_cmd_ids cmd_id = MYMPD_API_STATS;
     struct mpd_stats *stats = mpd_run_stats(partition_state->conn);
     if (stats != NULL) {
@@ -44,7 +71,29 @@ sds mympd_api_stats_get(struct t_partition_state *partition_state, sds buffer, u
         buffer = tojson_uint64(buffer, "dbPlaytime", mpd_stats_get_db_play_time(stats), true);
         buffer = tojson_char(buffer, "mympdVersion", MYMPD_VERSION, true);
         buffer = tojson_char(buffer, "mpdProtocolVersion", mpd_protocol_version, true);
-        buffer = tojson_char(buffer, "myMPDuri", mympd_uri,false);
+        buffer = tojson_char(buffer, "myMPDuri", mympd_uri, true);
+        buffer = sdscat(buffer, "\"queues\":{");
+        buffer = print_queue_stats(buffer, mympd_api_queue, true);
+        #ifdef MYMPD_ENABLE_LUA
+            buffer = print_queue_stats(buffer, script_queue, true);
+            buffer = print_queue_stats(buffer, script_worker_queue, true);
+        #endif
+        buffer = print_queue_stats(buffer, webserver_queue, false);
+        buffer = sdscat(buffer, "},\"workerPool\":");
+        buffer = mympd_worker_pool_stats(buffer);
+        buffer = sdscat(buffer, ",\"albumartFetch\":");
+        buffer = mympd_api_albumart_fetch_stats(buffer);
+        buffer = sdscat(buffer, ",\"imageIndex\":");
+        buffer = image_index_stats(buffer);
+        buffer = sdscat(buffer, ",\"diskCache\":");
+        buffer = cache_disk_index_stats(buffer);
+        buffer = sdscat(buffer, ",\"albumCache\":");
+        buffer = album_cache_memory_stats(buffer, &mympd_state->album_cache);
+        buffer = sdscat(buffer, ",\"dirCache\":");
+        buffer = dir_cache_stats(buffer, &mympd_state->dir_cache);
+        buffer = sdscatlen(buffer, ",", 1);
+        buffer = tojson_uint64(buffer, "rss", get_rss(), true);
+        buffer = histogram_tojson(buffer, "controlLatency", &mympd_state->control_latency, false);
         buffer = jsonrpc_end(buffer);
 
         FREE_SDS(mympd_uri);
@@ -54,3 +103,64 @@ sds mympd_api_stats_get(struct t_partition_state *partition_state, sds buffer, u
     mympd_check_error_and_recover_respond(partition_state, &buffer, cmd_id, request_id, "mpd_run_stats");
     return buffer;
 }
+
+/**
+ * Prints the latency metrics of the api methods
+ * @param buffer already allocated sds string to append the response
+ * @param request_id jsonrpc request id
+ * @return pointer to buffer
+ */
+sds mympd_api_stats_metrics(sds buffer, unsigned request_id) {
+    buffer = jsonrpc_respond_start(buffer, MYMPD_API_STATS_METRICS, request_id);
+    buffer = sdscat(buffer, "\"methods\":");
+    buffer = metrics_print_json(buffer);
+    buffer = jsonrpc_end(buffer);
+    return buffer;
+}
+
+/**
+ * Private functions
+ */
+
+/**
+ * Prints the depth and high-water metrics of a message queue as json object
+ * @param buffer already allocated sds string to append the response
+ * @param queue pointer to the queue
+ * @param comma true to print a comma after the object
+ * @return pointer to buffer
+ */
+static sds print_queue_stats(sds buffer, struct t_mympd_queue *queue, bool comma) {
+    struct t_mympd_queue_stats stats;
+    mympd_queue_get_stats(queue, &stats);
+    buffer = sds_catjson(buffer, queue->name, strlen(queue->name));
+    buffer = sdscatlen(buffer, ":{", 2);
+    buffer = tojson_uint(buffer, "length", stats.length, true);
+    buffer = tojson_uint(buffer, "highWater", stats.high_water, true);
+    buffer = tojson_uint64(buffer, "pushed", stats.pushed, true);
+    buffer = tojson_uint64(buffer, "overflows", stats.overflows, true);
+    buffer = tojson_uint64(buffer, "wakeups", stats.wakeups, false);
+    buffer = sdscatlen(buffer, "}", 1);
+    if (comma == true) {
+        buffer = sdscatlen(buffer, ",", 1);
+    }
+    return buffer;
+}
+
+/**
+ * Gets the resident set size of the myMPD process
+ * @return resident set size in bytes, 0 if it is not available
+ */
+static uint64_t get_rss(void) {
+    FILE *fp = fopen("/proc/self/statm", OPEN_FLAGS_READ);
+    if (fp == NULL) {
+        return 0;
+    }
+    uint64_t size;
+    uint64_t resident;
+    int rc = fscanf(fp, "%" SCNu64 " %" SCNu64, &size, &resident);
+    (void) fclose(fp);
+    long page_size = sysconf(_SC_PAGESIZE);
+    return rc == 2 && page_size > 0
+        ? resident * (uint64_t)page_size
+        : 0;
+}
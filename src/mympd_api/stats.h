@@ -13,5 +13,6 @@
 
 #include "src/lib/config/mympd_state.h"
 
-sds mympd_api_stats_get(struct t_partition_state *partition_state, sds buffer, unsigned request_id);
+sds mympd_api_stats_get(struct t_mympd_state *mympd_state, struct t_partition_state *partition_state, sds buffer, unsigned request_id);
+sds mympd_api_stats_metrics(sds buffer, unsigned request_id);
 #endif
@@ -16,10 +16,8 @@
 #include "src/lib/json/json_rpc.h"
 #include "src/lib/log.h"
 #include "src/lib/mem.h"
-#include "src/lib/rax_extras.h"
 #include "src/lib/sds/sds_extras.h"
-#include "src/lib/sds/sds_utf8.h"
-#include "src/lib/utf8_wrapper.h"
+#include "src/lib/tag_value_cache.h"
 #include "src/mympd_client/errorhandler.h"
 #include "src/mympd_client/search.h"
 
@@ -27,8 +25,10 @@
 
 // private definitions
 
-static sds tag_list_legacy(struct t_partition_state *partition_state, sds buffer,
+static sds tag_list_cache(struct t_mympd_state *mympd_state, struct t_partition_state *partition_state, sds buffer,
     unsigned request_id, sds searchstr, sds tag, unsigned offset, unsigned limit, bool sortdesc);
+static bool tag_values_populate(struct t_partition_state *partition_state, struct t_tag_values *values,
+    enum mpd_tag_type mpdtag, sds *buffer, unsigned request_id);
 static sds tag_list_mpd025(struct t_partition_state *partition_state, sds buffer, unsigned request_id,
     sds searchstr, sds tag, unsigned offset, unsigned limit, bool sortdesc);
 
@@ -37,6 +37,7 @@ static sds tag_list_mpd025(struct t_partition_state *partition_state, sds buffer
 /**
  * Lists tags from the mpd database.
  * Wrapper that chooses the right method by MPD version.
+ * @param mympd_state pointer to central myMPD state
  * @param partition_state pointer to partition specific states
  * @param buffer sds string to append response
  * @param request_id jsonrpc request id
@@ -47,19 +48,21 @@ static sds tag_list_mpd025(struct t_partition_state *partition_state, sds buffer
  * @param sortdesc true to sort descending, false to sort ascending
  * @return pointer to buffer
  */
-sds mympd_api_tag_list(struct t_partition_state *partition_state, sds buffer, unsigned request_id,
-        sds searchstr, sds tag, unsigned offset, unsigned limit, bool sortdesc)
+sds mympd_api_tag_list(struct t_mympd_state *mympd_state, struct t_partition_state *partition_state, sds buffer,
+        unsigned request_id, sds searchstr, sds tag, unsigned offset, unsigned limit, bool sortdesc)
 {
     return partition_state->mpd_state->feat.mpd_0_25_0 == true && sortdesc == false
         ? tag_list_mpd025(partition_state, buffer, request_id, searchstr, tag, offset, limit, sortdesc)
-        : tag_list_legacy(partition_state, buffer, request_id, searchstr, tag, offset, limit, sortdesc);
+        : tag_list_cache(mympd_state, partition_state, buffer, request_id, searchstr, tag, offset, limit, sortdesc);
 }
 
 // private functions
 
 /**
- * Lists tags from the mpd database.
- * Searches and sorts the result on client side.
+ * Lists tags from the tag value cache.
+ * Populates the cache for the tag on the first request,
+ * searches and sorts the result on client side.
+ * @param mympd_state pointer to central myMPD state
  * @param partition_state pointer to partition specific states
  * @param buffer sds string to append response
  * @param request_id jsonrpc request id
@@ -70,85 +73,38 @@ sds mympd_api_tag_list(struct t_partition_state *partition_state, sds buffer, un
  * @param sortdesc true to sort descending, false to sort ascending
  * @return pointer to buffer
  */
-static sds tag_list_legacy(struct t_partition_state *partition_state, sds buffer, unsigned request_id,
-        sds searchstr, sds tag, unsigned offset, unsigned limit, bool sortdesc)
+static sds tag_list_cache(struct t_mympd_state *mympd_state, struct t_partition_state *partition_state, sds buffer,
+        unsigned request_id, sds searchstr, sds tag, unsigned offset, unsigned limit, bool sortdesc)
 {
     enum mympd_cmd_ids cmd_id = MYMPD_API_DATABASE_TAG_LIST;
     enum mpd_tag_type mpdtag = mpd_tag_name_parse(tag);
-
-    if (mpd_search_db_tags(partition_state->conn, mpdtag) == false) {
-        mpd_search_cancel(partition_state->conn);
+    struct t_tag_values *values = tag_value_cache_get(&mympd_state->tag_value_cache, mpdtag);
+    if (values == NULL) {
         return jsonrpc_respond_message(buffer, cmd_id, request_id, JSONRPC_FACILITY_DATABASE,
             JSONRPC_SEVERITY_ERROR, "Error creating MPD search command");
     }
-
-    unsigned real_limit = offset + limit;
-    rax *taglist = raxNew();
-    sds key = sdsempty();
-    size_t searchstr_len;
-    char *searchstr_utf8 = utf8_wrap_normalize(searchstr, sdslen(searchstr), &searchstr_len);
-
-    if (mpd_search_commit(partition_state->conn)) {
-        struct mpd_pair *pair;
-        //filter and sort
-        while ((pair = mpd_recv_pair_tag(partition_state->conn, mpdtag)) != NULL) {
-            size_t value_len;
-            char *value_utf8 = utf8_wrap_normalize(pair->value, strlen(pair->value), &value_len);
-            if (pair->value[0] == '\0') {
-                MYMPD_LOG_DEBUG(partition_state->name, "Value is empty, skipping");
-            }
-            else if (searchstr_len == 0 ||
-                (searchstr_len <= 2 && strcmp(searchstr_utf8, value_utf8) == 0) ||
-                (searchstr_len > 2 && strstr(value_utf8, searchstr_utf8) != NULL))
-            {
-                key = sdscat(key, pair->value);
-                key = sds_utf8_normalize(key);
-                sds data = sdsnew(pair->value);
-                rax_insert_no_dup(taglist, key, data);
-                sdsclear(key);
-            }
-            mpd_return_pair(partition_state->conn, pair);
-            FREE_PTR(value_utf8);
-        }
-    }
-    if (mympd_check_error_and_recover_respond(partition_state, &buffer, cmd_id, request_id, "mpd_search_db_tags") == false) {
-        rax_free_sds_data(taglist);
+    if (values->valid == false &&
+        tag_values_populate(partition_state, values, mpdtag, &buffer, request_id) == false)
+    {
         return buffer;
     }
-    FREE_SDS(key);
-    FREE_PTR(searchstr_utf8);
 
     //print list
+    unsigned *page = malloc_assert(limit * sizeof(unsigned));
+    unsigned entities_returned;
+    unsigned entities_total = tag_values_page(values, searchstr, sdslen(searchstr), sortdesc,
+        offset, limit, page, &entities_returned);
     buffer = jsonrpc_respond_start(buffer, cmd_id, request_id);
     buffer = sdscat(buffer, "\"data\":[");
-    unsigned entity_count = 0;
-    unsigned entities_returned = 0;
-    raxIterator iter;
-    raxStart(&iter, taglist);
-    int (*iterator)(struct raxIterator *iter);
-    if (sortdesc == false) {
-        raxSeek(&iter, "^", NULL, 0);
-        iterator = &raxNext;
-    }
-    else {
-        raxSeek(&iter, "$", NULL, 0);
-        iterator = &raxPrev;
-    }
-    while (iterator(&iter)) {
-        if (entity_count >= offset &&
-            entity_count < real_limit)
-        {
-            if (entities_returned++) {
-                buffer = sdscatlen(buffer, ",", 1);
-            }
-            buffer = sdscatlen(buffer, "{", 1);
-            buffer = tojson_sds(buffer, "Value", (sds)iter.data, false);
-            buffer = sdscatlen(buffer, "}", 1);
+    for (unsigned i = 0; i < entities_returned; i++) {
+        if (i > 0) {
+            buffer = sdscatlen(buffer, ",", 1);
         }
-        entity_count++;
-        FREE_SDS(iter.data);
+        buffer = sdscatlen(buffer, "{", 1);
+        buffer = tojson_sds(buffer, "Value", values->values[page[i]].value, false);
+        buffer = sdscatlen(buffer, "}", 1);
     }
-    raxStop(&iter);
+    FREE_PTR(page);
 
     //checks if this tag has a directory with pictures in /var/lib/mympd/pics
     sds pic_path = sdscatfmt(sdsempty(), "%S/%s/%s", partition_state->config->workdir, DIR_WORK_PICS, tag);
@@ -158,7 +114,7 @@ static sds tag_list_legacy(struct t_partition_state *partition_state, sds buffer
     FREE_SDS(pic_path);
 
     buffer = sdscatlen(buffer, "],", 2);
-    buffer = tojson_uint64(buffer, "totalEntities", taglist->numele, true);
+    buffer = tojson_uint(buffer, "totalEntities", entities_total, true);
     buffer = tojson_uint(buffer, "returnedEntities", entities_returned, true);
     buffer = tojson_uint(buffer, "offset", offset, true);
     buffer = tojson_uint(buffer, "limit", limit, true);
@@ -167,10 +123,49 @@ static sds tag_list_legacy(struct t_partition_state *partition_state, sds buffer
     buffer = tojson_bool(buffer, "sortdesc", sortdesc, true);
     buffer = tojson_bool(buffer, "pics", pic, false);
     buffer = jsonrpc_end(buffer);
-    raxFree(taglist);
     return buffer;
 }
 
+/**
+ * Populates the tag value cache for a tag from the mpd database
+ * @param partition_state pointer to partition specific states
+ * @param values pointer to the tag values to populate
+ * @param mpdtag tag type to list
+ * @param buffer pointer to the buffer for the error response
+ * @param request_id jsonrpc request id
+ * @return true on success, else false
+ */
+static bool tag_values_populate(struct t_partition_state *partition_state, struct t_tag_values *values,
+        enum mpd_tag_type mpdtag, sds *buffer, unsigned request_id)
+{
+    enum mympd_cmd_ids cmd_id = MYMPD_API_DATABASE_TAG_LIST;
+    if (mpd_search_db_tags(partition_state->conn, mpdtag) == false) {
+        mpd_search_cancel(partition_state->conn);
+        *buffer = jsonrpc_respond_message(*buffer, cmd_id, request_id, JSONRPC_FACILITY_DATABASE,
+            JSONRPC_SEVERITY_ERROR, "Error creating MPD search command");
+        return false;
+    }
+    if (mpd_search_commit(partition_state->conn)) {
+        struct mpd_pair *pair;
+        while ((pair = mpd_recv_pair_tag(partition_state->conn, mpdtag)) != NULL) {
+            if (pair->value[0] == '\0') {
+                MYMPD_LOG_DEBUG(partition_state->name, "Value is empty, skipping");
+            }
+            else {
+                tag_values_append(values, pair->value);
+            }
+            mpd_return_pair(partition_state->conn, pair);
+        }
+    }
+    if (mympd_check_error_and_recover_respond(partition_state, buffer, cmd_id, request_id, "mpd_search_db_tags") == false) {
+        tag_values_clear(values);
+        return false;
+    }
+    tag_values_commit(values);
+    MYMPD_LOG_DEBUG(partition_state->name, "Cached %u values for tag %s", values->length, mpd_tag_name(mpdtag));
+    return true;
+}
+
 /**
  * Lists tags from the mpd database.
  * Uses window parameter and does filtering and sorting on MPD side.
@@ -13,7 +13,7 @@
 
 #include "src/lib/config/mympd_state.h"
 
-sds mympd_api_tag_list(struct t_partition_state *partition_state, sds buffer,
+sds mympd_api_tag_list(struct t_mympd_state *mympd_state, struct t_partition_state *partition_state, sds buffer,
         unsigned request_id, sds searchstr, sds tag, unsigned offset, unsigned limit, bool sortdesc);
 
 #endif
@@ -12,6 +12,7 @@
 #include "src/mympd_api/timer_handlers.h"
 
 #include "src/lib/api.h"
+#include "src/lib/cache/cache_disk.h"
 #include "src/lib/config/mympd_state.h"
 #include "src/lib/json/json_print.h"
 #include "src/lib/json/json_query.h"
@@ -23,6 +24,7 @@
 #include "src/mympd_api/requests.h"
 #include "src/mympd_client/errorhandler.h"
 #include "src/mympd_client/shortcuts.h"
+#include "src/mympd_client/stickerdb.h"
 #include "src/mympd_client/volume.h"
 
 #ifdef MYMPD_ENABLE_LUA
@@ -40,6 +42,8 @@ static void timer_handler_smartpls_update(void);
 static void timer_handler_caches_create(void);
 static void timer_handler_webradiodb_update(void);
 static void timer_handler_state_save(struct t_mympd_state *mympd_state);
+static void timer_handler_stickerdb_flush(struct t_mympd_state *mympd_state);
+static void timer_handler_cache_disk_crop_slice(struct t_mympd_state *mympd_state);
 
 /**
  * Public functions
@@ -62,6 +66,10 @@ const char *get_timer_name(unsigned timer_id) {
             return "TIMER_ID_WEBRADIODB_UPDATE";
         case TIMER_ID_STATE_SAVE:
             return "TIMER_ID_STATE_SAVE";
+        case TIMER_ID_STICKERDB_FLUSH:
+            return "TIMER_ID_STICKERDB_FLUSH";
+        case TIMER_ID_DISK_CACHE_CROP_SLICE:
+            return "TIMER_ID_DISK_CACHE_CROP_SLICE";
     }
     return "TIMER_ID_USER_DEFINED";
 }
@@ -90,6 +98,12 @@ void timer_handler_by_id(enum timer_ids timer_id, struct t_timer_definition *def
         case TIMER_ID_STATE_SAVE:
             timer_handler_state_save(mympd_state);
             break;
+        case TIMER_ID_STICKERDB_FLUSH:
+            timer_handler_stickerdb_flush(mympd_state);
+            break;
+        case TIMER_ID_DISK_CACHE_CROP_SLICE:
+            timer_handler_cache_disk_crop_slice(mympd_state);
+            break;
     }
 }
 
@@ -287,3 +301,20 @@ static void timer_handler_state_save(struct t_mympd_state *mympd_state) {
         mympd_queue_push(script_queue, request, 0);
     #endif
 }
+
+/**
+ * Timer handler for timer_id TIMER_ID_STICKERDB_FLUSH
+ * @param mympd_state Pointer to mympd_state
+ */
+static void timer_handler_stickerdb_flush(struct t_mympd_state *mympd_state) {
+    MYMPD_LOG_INFO(NULL, "Start timer_handler_stickerdb_flush");
+    stickerdb_flush(mympd_state->stickerdb);
+}
+
+/**
+ * Timer handler for timer_id TIMER_ID_DISK_CACHE_CROP_SLICE
+ * @param mympd_state Pointer to mympd_state
+ */
+static void timer_handler_cache_disk_crop_slice(struct t_mympd_state *mympd_state) {
+    cache_disk_crop_slice(mympd_state->config);
+}
@@ -22,6 +22,8 @@ enum timer_ids {
     TIMER_ID_CACHES_CREATE,
     TIMER_ID_WEBRADIODB_UPDATE,
     TIMER_ID_STATE_SAVE,
+    TIMER_ID_STICKERDB_FLUSH,
+    TIMER_ID_DISK_CACHE_CROP_SLICE,
 };
 
 const char *get_timer_name(unsigned timer_id);
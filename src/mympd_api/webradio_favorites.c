@@ -12,6 +12,7 @@
 
 #include "dist/rax/rax.h"
 #include "src/lib/log.h"
+#include "src/lib/str_pool.h"
 
 #include <time.h>
 
@@ -51,6 +52,11 @@ bool mympd_api_webradio_favorite_save(struct t_webradios *webradio_favorites, st
     if (raxTryInsert(webradio_favorites->db, (unsigned char *)webradio->name, sdslen(webradio->name), webradio, NULL) == 1) {
         // write uri index
         raxTryInsert(webradio_favorites->idx_uris, (unsigned char *)webradio->uris.head->key, sdslen(webradio->uris.head->key), webradio, NULL);
+        // normalize the searchable tags
+        if (webradio_favorites->pool == NULL) {
+            webradio_favorites->pool = str_pool_new();
+        }
+        webradio_data_normalize(webradio, webradio_favorites->pool);
         return true;
     }
     MYMPD_LOG_ERROR("NULL", "Failure saving webradio favorite");
@@ -14,6 +14,7 @@
 #include "src/lib/event.h"
 #include "src/lib/json/json_rpc.h"
 #include "src/lib/log.h"
+#include "src/lib/queue_mirror.h"
 #include "src/lib/sds/sds_extras.h"
 #include "src/mympd_api/requests.h"
 #include "src/mympd_client/errorhandler.h"
@@ -180,6 +181,7 @@ void mympd_client_disconnect_silent(struct t_partition_state *partition_state) {
     }
     partition_state->conn = NULL;
     partition_state->conn_state = MPD_DISCONNECTED;
+    queue_mirror_clear(&partition_state->queue_mirror);
     if (partition_state->waiting_events & PFD_TYPE_PARTITION) {
         MYMPD_LOG_WARN(partition_state->name, "Clear pending mpd idle events");
         partition_state->waiting_events &= ~(unsigned)PFD_TYPE_PARTITION;
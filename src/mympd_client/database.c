@@ -31,6 +31,27 @@ time_t mympd_client_get_db_mtime(struct t_partition_state *partition_state) {
     return mtime;
 }
 
+/**
+ * Gets the mpd database update time and the number of songs in the database
+ * @param partition_state pointer to partition state
+ * @param db_mtime pointer to set the database update time
+ * @param songs pointer to set the number of songs
+ * @return true on success, else false
+ */
+bool mympd_client_get_db_stats(struct t_partition_state *partition_state, time_t *db_mtime, unsigned *songs) {
+    bool rc = false;
+    struct mpd_stats *stats = mpd_run_stats(partition_state->conn);
+    if (stats != NULL) {
+        *db_mtime = (time_t)mpd_stats_get_db_update_time(stats);
+        *songs = mpd_stats_get_number_of_songs(stats);
+        mpd_stats_free(stats);
+        rc = true;
+    }
+    return mympd_check_error_and_recover(partition_state, NULL, "mpd_run_stats") == true
+        ? rc
+        : false;
+}
+
 /**
  * Checks for a song in the database
  * @param partition_state Pointer to partition state
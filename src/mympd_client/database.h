@@ -14,6 +14,7 @@
 #include "src/lib/config/mympd_state.h"
 
 time_t mympd_client_get_db_mtime(struct t_partition_state *partition_state);
+bool mympd_client_get_db_stats(struct t_partition_state *partition_state, time_t *db_mtime, unsigned *songs);
 bool mympd_client_song_exists(struct t_partition_state *partition_state, const char *uri);
 
 #endif
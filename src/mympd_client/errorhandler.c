@@ -12,6 +12,7 @@
 
 #include "src/lib/json/json_rpc.h"
 #include "src/lib/log.h"
+#include "src/lib/metrics.h"
 #include "src/lib/timer.h"
 #include "src/mympd_client/connection.h"
 #include "src/mympd_client/tags.h"
@@ -149,6 +150,7 @@ static bool check_error_and_recover(struct t_partition_state *partition_state, s
         mympd_set_mpd_failure(partition_state, "Unrecoverable MPD error");
         return false;
     }
+    metrics_count_mpd_roundtrip();
     if (mpd_response_finish(partition_state->conn) == true) {
         return true;
     }
@@ -10,10 +10,14 @@
 
 #include "src/mympd_client/features.h"
 
+#include "src/lib/dir_cache.h"
 #include "src/lib/filehandler.h"
 #include "src/lib/log.h"
+#include "src/lib/playlist_catalogue.h"
+#include "src/lib/queue_mirror.h"
 #include "src/lib/sds/sds_extras.h"
 #include "src/lib/sds/sds_file.h"
+#include "src/lib/tag_value_cache.h"
 #include "src/lib/utility.h"
 #include "src/mympd_api/settings.h"
 #include "src/mympd_client/errorhandler.h"
@@ -89,6 +93,12 @@ void mympd_client_mpd_features(struct t_mympd_state *mympd_state, struct t_parti
     features_commands(partition_state);
     features_config(mympd_state, partition_state);
     features_tags(mympd_state, partition_state);
+    // the queue mirror must be reloaded with the enabled tags
+    queue_mirror_clear(&partition_state->queue_mirror);
+    // the tag values, directory listings and stored playlists are populated again from the connected MPD
+    tag_value_cache_clear(&mympd_state->tag_value_cache);
+    dir_cache_clear(&mympd_state->dir_cache);
+    playlist_catalogue_clear(&mympd_state->mpd_state->playlist_catalogue);
 
     settings_to_webserver(mympd_state);
 }
@@ -14,6 +14,7 @@
 #include "src/lib/config/mympd_state.h"
 #include "src/lib/datetime.h"
 #include "src/lib/event.h"
+#include "src/lib/image_index.h"
 #include "src/lib/json/json_rpc.h"
 #include "src/lib/log.h"
 #include "src/lib/msg_queue.h"
@@ -169,16 +170,17 @@ static void mympd_client_idle_partition(struct t_mympd_state *mympd_state, struc
         mympd_check_error_and_recover(partition_state, NULL, "mpd_send_noidle");
         return;
     }
-    if (partition_state->waiting_events & PFD_TYPE_PARTITION) {
-        // Handle MPD idle events
-        MYMPD_LOG_DEBUG(partition_state->name, "Checking for idle events");
-        enum mpd_idle idle_bitmask = mpd_recv_idle(partition_state->conn, false);
-        mympd_client_parse_idle(mympd_state, partition_state, idle_bitmask);
-        partition_state->waiting_events &= ~(unsigned)PFD_TYPE_PARTITION;
+    // Handle MPD idle events, the response to noidle can contain events
+    // that occurred after the last poll, e.g. from the worker threads
+    MYMPD_LOG_DEBUG(partition_state->name, "Checking for idle events");
+    enum mpd_idle idle_bitmask = mpd_recv_idle(partition_state->conn, false);
+    if (idle_bitmask == 0) {
+        mympd_check_error_and_recover(partition_state, NULL, "mpd_send_noidle");
     }
     else {
-        mympd_check_error_and_recover(partition_state, NULL, "mpd_send_noidle");
+        mympd_client_parse_idle(mympd_state, partition_state, idle_bitmask);
     }
+    partition_state->waiting_events &= ~(unsigned)PFD_TYPE_PARTITION;
     // Set mpd connection options
     if (partition_state->conn_state == MPD_CONNECTED &&
         partition_state->set_conn_options == true &&
@@ -243,6 +245,12 @@ static void mympd_client_parse_idle(struct t_mympd_state *mympd_state, struct t_
                 case MPD_IDLE_DATABASE:
                     //database has changed - global event
                     MYMPD_LOG_INFO(partition_state->name, "MPD database has changed");
+                    //images in the music directory may have changed
+                    image_index_files_removed(IMAGE_INDEX_SCOPE_MUSIC);
+                    //tag values are populated again on demand
+                    tag_value_cache_clear(&mympd_state->tag_value_cache);
+                    //directory listings are fetched again on demand
+                    dir_cache_clear(&mympd_state->dir_cache);
                     buffer = jsonrpc_event(buffer, JSONRPC_EVENT_UPDATE_DATABASE);
                     //add timer for cache updates
                     if (mympd_state->mpd_state->feat.tags == true) {
@@ -252,6 +260,10 @@ static void mympd_client_parse_idle(struct t_mympd_state *mympd_state, struct t_
                     break;
                 case MPD_IDLE_STORED_PLAYLIST:
                     //a playlist has changed - global event
+                    //playlists are part of the directory listings
+                    dir_cache_clear(&mympd_state->dir_cache);
+                    //the playlist catalogue is populated again on demand
+                    playlist_catalogue_clear(&mympd_state->mpd_state->playlist_catalogue);
                     buffer = jsonrpc_event(buffer, JSONRPC_EVENT_UPDATE_STORED_PLAYLIST);
                     break;
                 case MPD_IDLE_UPDATE:
@@ -266,6 +278,7 @@ static void mympd_client_parse_idle(struct t_mympd_state *mympd_state, struct t_
                     //MPD_IDLE_PLAYLIST is the same
                     //queue has changed - partition specific event
                     buffer = mympd_client_queue_status_print(partition_state, &mympd_state->album_cache, buffer);
+                    mympd_client_queue_mirror_update(partition_state);
                     //jukebox enabled
                     if (partition_state->jukebox.mode != JUKEBOX_OFF &&
                         partition_state->queue_length < partition_state->jukebox.queue_length)
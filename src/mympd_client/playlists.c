@@ -16,6 +16,7 @@
 #include "src/lib/fields.h"
 #include "src/lib/list/shuffle.h"
 #include "src/lib/log.h"
+#include "src/lib/playlist_catalogue.h"
 #include "src/lib/random.h"
 #include "src/lib/rax_extras.h"
 #include "src/lib/sds/sds_extras.h"
@@ -25,6 +26,8 @@
 #include "src/mympd_client/shortcuts.h"
 #include "src/mympd_client/tags.h"
 
+#include <dirent.h>
+#include <errno.h>
 #include <stdbool.h>
 #include <string.h>
 
@@ -39,36 +42,54 @@ static bool playlist_content_enumerate_mpd(struct t_partition_state *partition_s
         unsigned *count, unsigned *duration, sds *error);
 static bool playlist_content_enumerate_manual(struct t_partition_state *partition_state, const char *plist,
         unsigned *count, unsigned *duration, sds *error);
+static void catalogue_mark_smartpls(struct t_playlist_catalogue *catalogue, sds workdir);
 
 /**
  * Public functions
  */
 
 /**
- * Check if playlist exists
- * @param partition_state Pointer to partition state
- * @param plist Playlist name
- * @return true if exists, else false
+ * Gets the stored playlist catalogue, it is populated from MPD if it is invalid.
+ * The catalogue is invalidated by the MPD stored playlist idle event
+ * and by the helpers in this file that modify playlists.
+ * @param partition_state pointer to partition state
+ * @param error pointer to an already allocated sds string for the error message or NULL
+ * @return pointer to the catalogue or NULL on error
  */
-bool mympd_client_playlist_exists(struct t_partition_state *partition_state, const char *plist) {
-    struct mpd_playlist *pl;
-    bool exists = false;
+struct t_playlist_catalogue *mympd_client_playlist_catalogue(struct t_partition_state *partition_state, sds *error) {
+    struct t_playlist_catalogue *catalogue = &partition_state->mpd_state->playlist_catalogue;
+    if (catalogue->valid == true) {
+        return catalogue;
+    }
+    playlist_catalogue_clear(catalogue);
     if (mpd_send_list_playlists(partition_state->conn)) {
+        struct mpd_playlist *pl;
         while ((pl = mpd_recv_playlist(partition_state->conn)) != NULL) {
-            const char *plpath = mpd_playlist_get_path(pl);
-            if (strcmp(plist, plpath) == 0) {
-                exists = true;
-            }
+            playlist_catalogue_add(catalogue, mpd_playlist_get_path(pl), mpd_playlist_get_last_modified(pl), false);
             mpd_playlist_free(pl);
-            if (exists == true) {
-                break;
-            }
         }
     }
-    if (mympd_check_error_and_recover(partition_state, NULL, "mpd_send_list_playlists") == false) {
+    if (mympd_check_error_and_recover(partition_state, error, "mpd_send_list_playlists") == false) {
+        playlist_catalogue_clear(catalogue);
+        return NULL;
+    }
+    catalogue_mark_smartpls(catalogue, partition_state->config->workdir);
+    catalogue->valid = true;
+    return catalogue;
+}
+
+/**
+ * Check if playlist exists
+ * @param partition_state Pointer to partition state
+ * @param plist Playlist name
+ * @return true if exists, else false
+ */
+bool mympd_client_playlist_exists(struct t_partition_state *partition_state, const char *plist) {
+    struct t_playlist_catalogue *catalogue = mympd_client_playlist_catalogue(partition_state, NULL);
+    if (catalogue == NULL) {
         return false;
     }
-    return exists;
+    return playlist_catalogue_get(catalogue, plist) != NULL;
 }
 
 /**
@@ -82,7 +103,10 @@ bool mympd_client_playlist_delete_if_exists(struct t_partition_state *partition_
     bool exists = mympd_client_playlist_exists(partition_state, plist);
     if (exists == true) {
         mpd_run_rm(partition_state->conn, plist);
-        return mympd_check_error_and_recover(partition_state, NULL, "mpd_run_rm");
+        if (mympd_check_error_and_recover(partition_state, NULL, "mpd_run_rm") == false) {
+            return false;
+        }
+        playlist_catalogue_remove(&partition_state->mpd_state->playlist_catalogue, plist);
     }
     return true;
 }
@@ -96,20 +120,23 @@ bool mympd_client_playlist_delete_if_exists(struct t_partition_state *partition_
  * @return true on success, else false
  */
 bool mympd_client_get_all_playlists(struct t_partition_state *partition_state, struct t_list *l, bool smartpls, sds *error) {
-    if (mpd_send_list_playlists(partition_state->conn)) {
-        struct mpd_playlist *pl;
-        while ((pl = mpd_recv_playlist(partition_state->conn)) != NULL) {
-            const char *plpath = mpd_playlist_get_path(pl);
-            bool sp = is_smartpls(partition_state->config->workdir, plpath);
-            if (!(smartpls == false && sp == true)) {
-                list_push(l, plpath, sp, NULL, NULL);
-            }
-            mpd_playlist_free(pl);
-        }
-    }
-    if (mympd_check_error_and_recover(partition_state, error, "mpd_send_list_playlists") == false) {
+    struct t_playlist_catalogue *catalogue = mympd_client_playlist_catalogue(partition_state, error);
+    if (catalogue == NULL) {
         return false;
     }
+    raxIterator iter;
+    raxStart(&iter, catalogue->playlists);
+    raxSeek(&iter, "^", NULL, 0);
+    while (raxNext(&iter)) {
+        const struct t_playlist_catalogue_entry *entry = (const struct t_playlist_catalogue_entry *)iter.data;
+        if (smartpls == false &&
+            entry->smartpls == true)
+        {
+            continue;
+        }
+        list_push_len(l, (char *)iter.key, iter.key_len, entry->smartpls, NULL, 0, NULL);
+    }
+    raxStop(&iter);
     return true;
 }
 
@@ -120,23 +147,14 @@ bool mympd_client_get_all_playlists(struct t_partition_state *partition_state, s
  * @return last modification time or 0 on error
  */
 time_t mympd_client_get_playlist_mtime(struct t_partition_state *partition_state, const char *playlist) {
-    time_t mtime = 0;
-    if (mpd_send_list_playlists(partition_state->conn)) {
-        struct mpd_playlist *pl;
-        while ((pl = mpd_recv_playlist(partition_state->conn)) != NULL) {
-            const char *plpath = mpd_playlist_get_path(pl);
-            if (strcmp(plpath, playlist) == 0) {
-                mtime = mpd_playlist_get_last_modified(pl);
-                mpd_playlist_free(pl);
-                break;
-            }
-            mpd_playlist_free(pl);
-        }
-    }
-    if (mympd_check_error_and_recover(partition_state, NULL, "mpd_send_list_playlists") == false) {
+    struct t_playlist_catalogue *catalogue = mympd_client_playlist_catalogue(partition_state, NULL);
+    if (catalogue == NULL) {
         return 0;
     }
-    return mtime;
+    const struct t_playlist_catalogue_entry *entry = playlist_catalogue_get(catalogue, playlist);
+    return entry != NULL
+        ? entry->last_modified
+        : 0;
 }
 
 /**
@@ -216,7 +234,10 @@ int64_t mympd_client_playlist_dedup(struct t_partition_state *partition_state, c
     raxFree(plist);
 
     int64_t rc = duplicates.length;
-    if (remove == true) {
+    if (remove == true &&
+        rc > 0)
+    {
+        playlist_catalogue_clear(&partition_state->mpd_state->playlist_catalogue);
         struct t_list_node *current = duplicates.head;
         while (current != NULL) {
             mpd_run_playlist_delete(partition_state->conn, playlist, (unsigned)current->value_i);
@@ -290,6 +311,7 @@ int mympd_client_playlist_validate(struct t_partition_state *partition_state, co
     while (current != NULL) {
         if (mympd_client_song_exists(partition_state, current->key) == false) {
             if (remove == true) {
+                playlist_catalogue_clear(&partition_state->mpd_state->playlist_catalogue);
                 mpd_send_playlist_delete(partition_state->conn, playlist, (unsigned)current->value_i);
                 if (mympd_check_error_and_recover(partition_state, error, "mpd_run_playlist_delete") == false) {
                     rc = -1;
@@ -384,7 +406,8 @@ bool mympd_client_playlist_sort(struct t_partition_state *partition_state, const
 }
 
 /**
- * Counts the number of songs in the playlist
+ * Counts the number of songs in the playlist,
+ * the result is cached in the stored playlist catalogue
  * @param partition_state pointer to partition specific states
  * @param plist playlist to enumerate
  * @param count pointer to unsigned for entity count
@@ -395,9 +418,27 @@ bool mympd_client_playlist_sort(struct t_partition_state *partition_state, const
 bool mympd_client_enum_playlist(struct t_partition_state *partition_state, const char *plist,
         unsigned *count, unsigned *duration, sds *error)
 {
-    return partition_state->mpd_state->feat.mpd_0_24_0 == true
+    struct t_playlist_catalogue_entry *entry = partition_state->mpd_state->playlist_catalogue.valid == true
+        ? playlist_catalogue_get(&partition_state->mpd_state->playlist_catalogue, plist)
+        : NULL;
+    if (entry != NULL &&
+        entry->enumerated == true)
+    {
+        *count = entry->count;
+        *duration = entry->duration;
+        return true;
+    }
+    bool rc = partition_state->mpd_state->feat.mpd_0_24_0 == true
         ? playlist_content_enumerate_mpd(partition_state, plist, count, duration, error)
         : playlist_content_enumerate_manual(partition_state, plist, count, duration, error);
+    if (rc == true &&
+        entry != NULL)
+    {
+        entry->count = *count;
+        entry->duration = *duration;
+        entry->enumerated = true;
+    }
+    return rc;
 }
 
 /**
@@ -474,6 +515,7 @@ bool mympd_client_playlist_crop(struct t_partition_state *partition_state, const
     unsigned count;
     if (mympd_client_enum_playlist(partition_state, plist, &count, &duration, NULL) == true) {
         if (count > num_entries) {
+            playlist_catalogue_clear(&partition_state->mpd_state->playlist_catalogue);
             return mpd_run_playlist_delete_range(partition_state->conn, plist, num_entries, UINT_MAX);
         }
         return true;
@@ -489,6 +531,7 @@ bool mympd_client_playlist_crop(struct t_partition_state *partition_state, const
  * @return true on success, else false
  */
 bool mympd_client_playlist_clear(struct t_partition_state *partition_state, const char *plist, sds *error) {
+    playlist_catalogue_clear(&partition_state->mpd_state->playlist_catalogue);
     mpd_run_playlist_clear(partition_state->conn, plist);
     return mympd_check_error_and_recover(partition_state, error, "mpd_run_playlist_clear");
 }
@@ -724,6 +767,7 @@ static bool playlist_sort(struct t_partition_state *partition_state, const char
 static bool playlist_replace(struct t_partition_state *partition_state, const char *new_pl,
     const char *to_replace_pl, sds *error)
 {
+    playlist_catalogue_clear(&partition_state->mpd_state->playlist_catalogue);
     sds backup_pl = sdscatfmt(sdsempty(), "%s.bak", new_pl);
     //rename original playlist to old playlist
     mpd_run_rename(partition_state->conn, to_replace_pl, backup_pl);
@@ -745,3 +789,33 @@ static bool playlist_replace(struct t_partition_state *partition_state, const ch
     FREE_SDS(backup_pl);
     return mympd_check_error_and_recover(partition_state, error, "mpd_run_rename");
 }
+
+/**
+ * Sets the smart playlist flag for all playlists with a smart playlist definition.
+ * Reads the smart playlist directory once instead of checking each playlist.
+ * @param catalogue pointer to the playlist catalogue
+ * @param workdir myMPD working directory
+ */
+static void catalogue_mark_smartpls(struct t_playlist_catalogue *catalogue, sds workdir) {
+    sds smartpls_path = sdscatfmt(sdsempty(), "%S/%s", workdir, DIR_WORK_SMARTPLS);
+    errno = 0;
+    DIR *smartpls_dir = opendir(smartpls_path);
+    if (smartpls_dir == NULL) {
+        MYMPD_LOG_ERROR(NULL, "Can not open smartpls dir \"%s\"", smartpls_path);
+        MYMPD_LOG_ERRNO(NULL, errno);
+        FREE_SDS(smartpls_path);
+        return;
+    }
+    struct dirent *next_file;
+    while ((next_file = readdir(smartpls_dir)) != NULL) {
+        if (next_file->d_type != DT_REG) {
+            continue;
+        }
+        struct t_playlist_catalogue_entry *entry = playlist_catalogue_get(catalogue, next_file->d_name);
+        if (entry != NULL) {
+            entry->smartpls = true;
+        }
+    }
+    closedir(smartpls_dir);
+    FREE_SDS(smartpls_path);
+}
@@ -32,6 +32,7 @@ enum playlist_sort_types {
     PLSORT_LAST_MODIFIED
 };
 
+struct t_playlist_catalogue *mympd_client_playlist_catalogue(struct t_partition_state *partition_state, sds *error);
 bool mympd_client_playlist_exists(struct t_partition_state *partition_state, const char *plist);
 bool mympd_client_playlist_delete_if_exists(struct t_partition_state *partition_state, const char *plist);
 bool mympd_client_get_all_playlists(struct t_partition_state *partition_state, struct t_list *l, bool smartpls, sds *error);
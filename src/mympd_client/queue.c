@@ -12,8 +12,24 @@
 
 #include "src/lib/json/json_rpc.h"
 #include "src/lib/log.h"
+#include "src/lib/mem.h"
+#include "src/lib/queue_mirror.h"
 #include "src/mympd_api/status.h"
 #include "src/mympd_client/errorhandler.h"
+#include "src/mympd_client/shortcuts.h"
+
+#include <limits.h>
+
+/**
+ * Private definitions
+ */
+
+static bool queue_mirror_load(struct t_partition_state *partition_state);
+static bool queue_mirror_fetch(struct t_partition_state *partition_state, unsigned first_pending, unsigned last_pending);
+
+/**
+ * Public functions
+ */
 
 /**
  * Clears the queue
@@ -99,3 +115,152 @@ sds mympd_client_queue_status_print(struct t_partition_state *partition_state, s
     mympd_check_error_and_recover(partition_state, NULL, "mpd_run_status");
     return buffer;
 }
+
+/**
+ * Updates the queue mirror with the changes since its version.
+ * Only the positions and ids of the changes are requested,
+ * the metadata is fetched only for new and modified songs.
+ * The queue mirror is loaded completely if it is not valid.
+ * @param partition_state pointer to partition state
+ * @return true on success, else false
+ */
+bool mympd_client_queue_mirror_update(struct t_partition_state *partition_state) {
+    struct t_queue_mirror *mirror = &partition_state->queue_mirror;
+    if (mirror->valid == false) {
+        return queue_mirror_load(partition_state);
+    }
+    if (mirror->version == partition_state->queue_version) {
+        return true;
+    }
+    // the command list is executed atomically by mpd
+    unsigned version = 0;
+    unsigned length = 0;
+    bool rc = false;
+    struct t_queue_change *changes = NULL;
+    unsigned count = 0;
+    if (mpd_command_list_begin(partition_state->conn, true)) {
+        if (mpd_send_status(partition_state->conn) == false) {
+            mympd_set_mpd_failure(partition_state, "Error adding command to command list mpd_send_status");
+        }
+        if (mpd_send_queue_changes_brief(partition_state->conn, mirror->version) == false) {
+            mympd_set_mpd_failure(partition_state, "Error adding command to command list mpd_send_queue_changes_brief");
+        }
+        if (mympd_client_command_list_end_check(partition_state) == true) {
+            struct mpd_status *status = mpd_recv_status(partition_state->conn);
+            if (status != NULL) {
+                version = mpd_status_get_queue_version(status);
+                length = mpd_status_get_queue_length(status);
+                mpd_status_free(status);
+                rc = true;
+            }
+            if (mpd_response_next(partition_state->conn)) {
+                unsigned pos;
+                unsigned id;
+                unsigned size = 0;
+                while (mpd_recv_queue_change_brief(partition_state->conn, &pos, &id) == true) {
+                    if (count == size) {
+                        size = size == 0
+                            ? 64
+                            : size * 2;
+                        changes = realloc_assert(changes, size * sizeof(struct t_queue_change));
+                    }
+                    changes[count].pos = pos;
+                    changes[count].id = id;
+                    count++;
+                }
+            }
+        }
+    }
+    if (mympd_check_error_and_recover(partition_state, NULL, "mpd_send_queue_changes_brief") == false ||
+        rc == false)
+    {
+        FREE_PTR(changes);
+        queue_mirror_clear(mirror);
+        return false;
+    }
+    unsigned first_pending;
+    unsigned last_pending;
+    unsigned pending = queue_mirror_patch(mirror, changes, count, length, &first_pending, &last_pending);
+    FREE_PTR(changes);
+    MYMPD_LOG_DEBUG(partition_state->name, "Queue mirror: %u changes, %u songs to fetch", count, pending);
+    if (pending > 0 &&
+        queue_mirror_fetch(partition_state, first_pending, last_pending) == false)
+    {
+        queue_mirror_clear(mirror);
+        return false;
+    }
+    return queue_mirror_commit(mirror, version);
+}
+
+/**
+ * Private functions
+ */
+
+/**
+ * Loads the complete queue into the queue mirror
+ * @param partition_state pointer to partition state
+ * @return true on success, else false
+ */
+static bool queue_mirror_load(struct t_partition_state *partition_state) {
+    struct t_queue_mirror *mirror = &partition_state->queue_mirror;
+    queue_mirror_clear(mirror);
+    unsigned version = 0;
+    bool rc = false;
+    if (mpd_command_list_begin(partition_state->conn, true)) {
+        if (mpd_send_status(partition_state->conn) == false) {
+            mympd_set_mpd_failure(partition_state, "Error adding command to command list mpd_send_status");
+        }
+        if (mpd_send_list_queue_meta(partition_state->conn) == false) {
+            mympd_set_mpd_failure(partition_state, "Error adding command to command list mpd_send_list_queue_meta");
+        }
+        if (mympd_client_command_list_end_check(partition_state) == true) {
+            struct mpd_status *status = mpd_recv_status(partition_state->conn);
+            if (status != NULL) {
+                version = mpd_status_get_queue_version(status);
+                mpd_status_free(status);
+                rc = true;
+            }
+            if (mpd_response_next(partition_state->conn)) {
+                struct mpd_song *song;
+                while ((song = mpd_recv_song(partition_state->conn)) != NULL) {
+                    if (queue_mirror_append(mirror, song) == false) {
+                        rc = false;
+                    }
+                }
+            }
+        }
+    }
+    if (mympd_check_error_and_recover(partition_state, NULL, "mpd_send_list_queue_meta") == false ||
+        rc == false)
+    {
+        queue_mirror_clear(mirror);
+        return false;
+    }
+    MYMPD_LOG_DEBUG(partition_state->name, "Queue mirror: loaded %u songs", mirror->length);
+    return queue_mirror_commit(mirror, version);
+}
+
+/**
+ * Fetches the metadata of new and modified songs for the queue mirror
+ * @param partition_state pointer to partition state
+ * @param first_pending first position to fetch
+ * @param last_pending last position to fetch
+ * @return true on success, false if the queue has changed in the meantime
+ */
+static bool queue_mirror_fetch(struct t_partition_state *partition_state, unsigned first_pending, unsigned last_pending) {
+    struct t_queue_mirror *mirror = &partition_state->queue_mirror;
+    bool rc = true;
+    // the mirror version is set with the commit
+    if (mpd_send_queue_changes_meta_range(partition_state->conn, mirror->version, first_pending, last_pending + 1) == true) {
+        struct mpd_song *song;
+        while ((song = mpd_recv_song(partition_state->conn)) != NULL) {
+            if (queue_mirror_set_song(mirror, song) == false) {
+                rc = false;
+            }
+        }
+    }
+    if (mympd_check_error_and_recover(partition_state, NULL, "mpd_send_queue_changes_meta_range") == false) {
+        return false;
+    }
+    return rc;
+}
@@ -17,6 +17,7 @@ bool mympd_client_queue_play_newly_inserted(struct t_partition_state *partition_
 bool mympd_client_queue_check_start_play(struct t_partition_state *partition_state, bool play, sds *error);
 bool mympd_client_queue_clear(struct t_partition_state *partition_state, sds *error);
 void mympd_client_queue_status_update(struct t_partition_state *partition_state);
+bool mympd_client_queue_mirror_update(struct t_partition_state *partition_state);
 sds mympd_client_queue_status_print(struct t_partition_state *partition_state, struct t_cache *album_cache, sds buffer);
 
 #endif
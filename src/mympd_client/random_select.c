@@ -13,6 +13,7 @@
 
 #include "src/lib/convert.h"
 #include "src/lib/log.h"
+#include "src/lib/mem.h"
 #include "src/lib/random.h"
 #include "src/lib/sds/sds_extras.h"
 #include "src/lib/search/search.h"
@@ -37,20 +38,102 @@ static bool check_expression_album(const struct t_album *album, struct t_mympd_m
 static bool check_not_hated(rax *stickers_like, const char *uri, bool ignore_hated);
 static bool check_last_played_album(rax *stickers_last_played, const char *uri, time_t since, enum album_modes album_mode);
 static bool check_last_played(rax *stickers_last_played, const char *uri, time_t since);
-static long check_uniq_tag(const char *uri, const char *value, struct t_list *queue_list, struct t_list *add_list);
+static bool check_uniq_tag(struct t_random_select_reservoir *reservoir, const char *uri, const char *value);
+static void reservoir_index_list(struct t_random_select_reservoir *reservoir, struct t_list *list);
+static void reservoir_replace(struct t_random_select_reservoir *reservoir, unsigned pos, const char *uri, const char *value);
 static bool add_uri_constraint_or_expression(const char *include_expression, struct t_partition_state *partition_state);
 
+/*
+ * Public functions
+ */
+
 /**
- * Uniq constraints for random select
+ * Initializes the reservoir for a random selection run.
+ * The uris and uniq tag values of the queue_list and the add_list are indexed once,
+ * the uniq constraints are not enforced if queue_list is NULL.
+ * @param reservoir pointer to the reservoir to initialize
+ * @param expected_len expected length of the add_list
+ * @param queue_list list of current songs in mpd queue and last played or NULL
+ * @param add_list list to add the entries, existing entries are not touched
  */
-enum random_add_uniq_result {
-    RANDOM_ADD_UNIQ_IN_QUEUE = -2,
-    RANDOM_ADD_UNIQ_IS_UNIQ = -1
-};
+void random_select_reservoir_init(struct t_random_select_reservoir *reservoir, unsigned expected_len,
+        struct t_list *queue_list, struct t_list *add_list)
+{
+    reservoir->add_list = add_list;
+    reservoir->slots_len = expected_len > add_list->length
+        ? expected_len - add_list->length
+        : 0;
+    reservoir->slots_used = 0;
+    reservoir->lineno = 1;
+    reservoir->slots = reservoir->slots_len > 0
+        ? malloc_assert(reservoir->slots_len * sizeof(struct t_list_node *))
+        : NULL;
+    if (queue_list == NULL) {
+        reservoir->uris = NULL;
+        reservoir->values = NULL;
+        return;
+    }
+    reservoir->uris = raxNew();
+    reservoir->values = raxNew();
+    reservoir_index_list(reservoir, queue_list);
+    reservoir_index_list(reservoir, add_list);
+}
 
-/*
- * Public functions
+/**
+ * Offers a candidate to the reservoir.
+ * Uniq candidates are counted and selected with reservoir sampling,
+ * replacing a random slot if the reservoir is full.
+ * @param reservoir pointer to the reservoir
+ * @param uri song uri or albumid
+ * @param value uniq tag value
+ * @return true if the candidate is uniq, else false
  */
+bool random_select_reservoir_add(struct t_random_select_reservoir *reservoir, const char *uri, const char *value) {
+    if (check_uniq_tag(reservoir, uri, value) == false) {
+        return false;
+    }
+    if (randrange(0, reservoir->lineno) < reservoir->slots_len) {
+        if (reservoir->slots_used < reservoir->slots_len) {
+            // append to fill the queue
+            if (list_push(reservoir->add_list, uri, reservoir->lineno, value, NULL) == true) {
+                reservoir->slots[reservoir->slots_used] = reservoir->add_list->tail;
+                reservoir->slots_used++;
+                if (reservoir->uris != NULL) {
+                    raxInsert(reservoir->uris, (unsigned char *)uri, strlen(uri), reservoir->add_list->tail, NULL);
+                    raxInsert(reservoir->values, (unsigned char *)value, strlen(value), reservoir->add_list->tail, NULL);
+                }
+            }
+            else {
+                MYMPD_LOG_ERROR(NULL, "Can't push element to list");
+            }
+        }
+        else {
+            // replace a random slot, existing entries are not touched
+            unsigned pos = reservoir->slots_len > 1
+                ? randrange(0, reservoir->slots_len)
+                : 0;
+            reservoir_replace(reservoir, pos, uri, value);
+        }
+    }
+    reservoir->lineno++;
+    return true;
+}
+
+/**
+ * Frees the reservoir indexes, the add_list is not touched
+ * @param reservoir pointer to the reservoir
+ */
+void random_select_reservoir_clear(struct t_random_select_reservoir *reservoir) {
+    if (reservoir->uris != NULL) {
+        raxFree(reservoir->uris);
+        reservoir->uris = NULL;
+    }
+    if (reservoir->values != NULL) {
+        raxFree(reservoir->values);
+        reservoir->values = NULL;
+    }
+    FREE_PTR(reservoir->slots);
+}
 
 /**
  * Adds albums to the add_list
@@ -77,13 +160,13 @@ unsigned random_select_albums(struct t_partition_state *partition_state, struct
     if (add_list->length >= add_albums) {
         return add_list->length;
     }
-    add_albums = add_albums - add_list->length;
 
     MYMPD_LOG_DEBUG(partition_state->name, "Add list current length: %u", initial_length);
     MYMPD_LOG_DEBUG(partition_state->name, "Add list expected length: %u", add_list_expected_len);
 
     unsigned skipno = 0;
-    unsigned lineno = 1;
+    struct t_random_select_reservoir reservoir;
+    random_select_reservoir_init(&reservoir, add_list_expected_len, queue_list, add_list);
     time_t since = time(NULL);
     since = since - (time_t)(constraints->last_played * 3600);
     sds albumid = sdsempty();
@@ -116,43 +199,23 @@ unsigned random_select_albums(struct t_partition_state *partition_state, struct
 
         // we use the song uri in the album cache for enforcing last_played constraint,
         // because we do not know when an album was last played fully
-        if (check_last_played_album(stickers_last_played, album_get_uri(album), since, partition_state->config->albums.mode) == true &&
-            check_expression_album(album, &partition_state->mpd_state->tags_mpd, include_expr_list, exclude_expr_list) == true &&
-            check_uniq_tag(albumid, tag_value, queue_list, add_list) == RANDOM_ADD_UNIQ_IS_UNIQ)
+        if (check_last_played_album(stickers_last_played, album_get_uri(album), since, partition_state->config->albums.mode) == false ||
+            check_expression_album(album, &partition_state->mpd_state->tags_mpd, include_expr_list, exclude_expr_list) == false ||
+            random_select_reservoir_add(&reservoir, albumid, tag_value) == false)
         {
-            if (randrange(0, lineno) < add_albums) {
-                if (add_list->length < add_list_expected_len) {
-                    // append to fill the queue
-                    if (list_push(add_list, albumid, lineno, tag_value, NULL) == false) {
-                        MYMPD_LOG_ERROR(partition_state->name, "Can't push element to list");
-                    }
-                }
-                else {
-                    // replace at initial_length + random position
-                    // existing entries should not be touched
-                    unsigned pos = add_albums > 1
-                        ? initial_length + randrange(0, add_albums)
-                        : initial_length;
-                    if (list_replace(add_list, pos, albumid, lineno, tag_value, NULL) == false) {
-                        MYMPD_LOG_ERROR(partition_state->name, "Can't replace list element pos %u", pos);
-                    }
-                }
-            }
-            lineno++;
-        }
-        else {
             skipno++;
         }
     }
     FREE_SDS(albumid);
     FREE_SDS(tag_value);
     raxStop(&iter);
+    random_select_reservoir_clear(&reservoir);
     search_expression_free(include_expr_list);
     search_expression_free(exclude_expr_list);
     if (stickers_last_played != NULL) {
         stickerdb_free_find_result(stickers_last_played);
     }
-    MYMPD_LOG_DEBUG(partition_state->name, "Iterated through %u albums, skipped %u", lineno, skipno);
+    MYMPD_LOG_DEBUG(partition_state->name, "Iterated through %u albums, skipped %u", reservoir.lineno, skipno);
     return add_list->length;
 }
 
@@ -176,7 +239,6 @@ unsigned random_select_songs(struct t_partition_state *partition_state, struct t
     if (add_list->length >= add_songs) {
         return add_list->length;
     }
-    add_songs = add_list_expected_len - add_list->length;
 
     MYMPD_LOG_DEBUG(partition_state->name, "Add list current length: %u", initial_length);
     MYMPD_LOG_DEBUG(partition_state->name, "Add list expected length: %u", add_list_expected_len);
@@ -184,7 +246,6 @@ unsigned random_select_songs(struct t_partition_state *partition_state, struct t
     unsigned start = 0;
     unsigned end = start + MPD_RESULTS_MAX;
     unsigned skipno = 0;
-    unsigned lineno = 1;
     time_t since = time(NULL) - (time_t)(constraints->last_played * 3600);
 
     bool from_database = strcmp(playlist, "Database") == 0
@@ -221,6 +282,8 @@ unsigned random_select_songs(struct t_partition_state *partition_state, struct t
     // Request results from mpd in chunks of MPD_RESULTS_MAX
     // Only MPD 0.24 supports this for playlists
     bool iterate = from_database || partition_state->mpd_state->feat.listplaylist_range;
+    struct t_random_select_reservoir reservoir;
+    random_select_reservoir_init(&reservoir, add_list_expected_len, queue_list, add_list);
 
     do {
         MYMPD_LOG_DEBUG(partition_state->name, "Iterating through source, start: %u", start);
@@ -261,34 +324,13 @@ unsigned random_select_songs(struct t_partition_state *partition_state, struct t
             tag_value = mympd_client_get_tag_value_string(song, constraints->uniq_tag, tag_value);
             const char *uri = mpd_song_get_uri(song);
 
-            if (check_min_duration(song, constraints->min_song_duration) == true &&
-                check_max_duration(song, constraints->max_song_duration) == true &&
-                check_last_played(stickers_last_played, uri, since) == true &&
-                check_not_hated(stickers_like, uri, constraints->ignore_hated) == true &&
-                check_expression_song(song, &partition_state->mpd_state->tags_mpd, include_expr_list, exclude_expr_list) == true &&
-                check_uniq_tag(uri, tag_value, queue_list, add_list) == RANDOM_ADD_UNIQ_IS_UNIQ)
+            if (check_min_duration(song, constraints->min_song_duration) == false ||
+                check_max_duration(song, constraints->max_song_duration) == false ||
+                check_last_played(stickers_last_played, uri, since) == false ||
+                check_not_hated(stickers_like, uri, constraints->ignore_hated) == false ||
+                check_expression_song(song, &partition_state->mpd_state->tags_mpd, include_expr_list, exclude_expr_list) == false ||
+                random_select_reservoir_add(&reservoir, uri, tag_value) == false)
             {
-                if (randrange(0, lineno) < add_songs) {
-                    if (add_list->length < add_list_expected_len) {
-                        // append to fill the queue
-                        if (list_push(add_list, uri, lineno, tag_value, NULL) == false) {
-                            MYMPD_LOG_ERROR(partition_state->name, "Can't push element to list");
-                        }
-                    }
-                    else {
-                        // replace at initial_length + random position
-                        // existing entries should not be touched
-                        unsigned pos = add_songs > 1
-                            ? initial_length + randrange(0, add_songs)
-                            : initial_length;
-                        if (list_replace(add_list, pos, uri, lineno, tag_value, NULL) == false) {
-                            MYMPD_LOG_ERROR(partition_state->name, "Can't replace list element pos %u", pos);
-                        }
-                    }
-                }
-                lineno++;
-            }
-            else {
                 skipno++;
             }
             mpd_song_free(song);
@@ -298,13 +340,14 @@ unsigned random_select_songs(struct t_partition_state *partition_state, struct t
         }
         start = end;
         end = end + MPD_RESULTS_MAX;
-    } while (iterate == true && lineno + skipno > start);
+    } while (iterate == true && reservoir.lineno + skipno > start);
+    random_select_reservoir_clear(&reservoir);
     stickerdb_free_find_result(stickers_last_played);
     stickerdb_free_find_result(stickers_like);
     search_expression_free(include_expr_list);
     search_expression_free(exclude_expr_list);
     FREE_SDS(tag_value);
-    MYMPD_LOG_DEBUG(partition_state->name, "Iterated through %u songs, skipped %u", lineno, skipno);
+    MYMPD_LOG_DEBUG(partition_state->name, "Iterated through %u songs, skipped %u", reservoir.lineno, skipno);
     return add_list->length;
 }
 
@@ -337,50 +380,57 @@ static bool check_max_duration(const struct mpd_song *song, unsigned max_duratio
 }
 
 /**
- * Checks for the uniq tag constraint for songs
+ * Checks the uniq constraints against the reservoir indexes
+ * @param reservoir pointer to the reservoir
  * @param uri song uri or albumid
  * @param value tag value to check
- * @param queue_list list of current songs in mpd queue and last played
- * @param add_list list to add the entries
- * @return value matches in the mpd queue: RANDOM_ADD_UNIQ_IN_QUEUE
- *         value matches in the add_list: position in the add_list
- *         value does not match, is uniq: RANDOM_ADD_UNIQ_IS_UNIQ
+ * @return true if uri and value are not in the mpd queue, last played or add_list, else false
  */
-static long check_uniq_tag(const char *uri, const char *value, struct t_list *queue_list, struct t_list *add_list)
-{
-    if (queue_list == NULL) {
-        return RANDOM_ADD_UNIQ_IS_UNIQ;
+static bool check_uniq_tag(struct t_random_select_reservoir *reservoir, const char *uri, const char *value) {
+    if (reservoir->uris == NULL) {
+        return true;
     }
-    // check mpd queue and last_played
-    struct t_list_node *current = queue_list->head;
-    while(current != NULL) {
-        if (strcmp(current->key, uri) == 0) {
-            return RANDOM_ADD_UNIQ_IN_QUEUE;
-        }
-        if (value != NULL &&
-            strcmp(current->value_p, value) == 0)
-        {
-            return RANDOM_ADD_UNIQ_IN_QUEUE;
-        }
-        current = current->next;
+    if (raxFind(reservoir->uris, (unsigned char *)uri, strlen(uri), NULL) == 1) {
+        return false;
     }
+    return raxFind(reservoir->values, (unsigned char *)value, strlen(value), NULL) == 0;
+}
 
-    // check add_list
-    current = add_list->head;
-    long i = 0;
+/**
+ * Adds the uris and uniq tag values of a list to the reservoir indexes
+ * @param reservoir pointer to the reservoir
+ * @param list list to index
+ */
+static void reservoir_index_list(struct t_random_select_reservoir *reservoir, struct t_list *list) {
+    struct t_list_node *current = list->head;
     while (current != NULL) {
-        if (strcmp(current->key, uri) == 0) {
-            return i;
-        }
-        if (value != NULL &&
-            strcmp(current->value_p, value) == 0)
-        {
-            return i;
+        raxInsert(reservoir->uris, (unsigned char *)current->key, sdslen(current->key), NULL, NULL);
+        if (current->value_p != NULL) {
+            raxInsert(reservoir->values, (unsigned char *)current->value_p, sdslen(current->value_p), NULL, NULL);
         }
         current = current->next;
-        i++;
     }
-    return RANDOM_ADD_UNIQ_IS_UNIQ;
+}
+
+/**
+ * Replaces a reservoir slot and updates the indexes
+ * @param reservoir pointer to the reservoir
+ * @param pos slot to replace
+ * @param uri new song uri or albumid
+ * @param value new uniq tag value
+ */
+static void reservoir_replace(struct t_random_select_reservoir *reservoir, unsigned pos, const char *uri, const char *value) {
+    struct t_list_node *node = reservoir->slots[pos];
+    if (reservoir->uris != NULL) {
+        // the entries of the slots are uniq, they are not shared with the queue or other slots
+        raxRemove(reservoir->uris, (unsigned char *)node->key, sdslen(node->key), NULL);
+        raxRemove(reservoir->values, (unsigned char *)node->value_p, sdslen(node->value_p), NULL);
+        raxInsert(reservoir->uris, (unsigned char *)uri, strlen(uri), node, NULL);
+        raxInsert(reservoir->values, (unsigned char *)value, strlen(value), node, NULL);
+    }
+    node->key = sds_replace(node->key, uri);
+    node->value_i = reservoir->lineno;
+    node->value_p = sds_replace(node->value_p, value);
 }
 
 /**
@@ -11,7 +11,9 @@
 #ifndef MYMPD_RANDOM_ADD_H
 #define MYMPD_RANDOM_ADD_H
 
+#include "dist/rax/rax.h"
 #include "src/lib/config/mympd_state.h"
+#include "src/lib/list/list.h"
 
 /**
  * Jukebox constraints for song/album selection
@@ -26,6 +28,23 @@ struct t_random_add_constraints {
     unsigned max_song_duration;  //!< maximum song duration
 };
 
+/**
+ * Reservoir for the random selection with indexed uniq constraints
+ */
+struct t_random_select_reservoir {
+    struct t_list *add_list;        //!< list to add the selected entries
+    struct t_list_node **slots;     //!< nodes of the add_list that can be replaced
+    unsigned slots_len;             //!< number of reservoir slots
+    unsigned slots_used;            //!< number of filled reservoir slots
+    unsigned lineno;                //!< number of accepted candidates + 1
+    rax *uris;                      //!< uris of the queue, the add_list and the reservoir
+    rax *values;                    //!< uniq tag values of the queue, the add_list and the reservoir
+};
+
+void random_select_reservoir_init(struct t_random_select_reservoir *reservoir, unsigned expected_len,
+        struct t_list *queue_list, struct t_list *add_list);
+bool random_select_reservoir_add(struct t_random_select_reservoir *reservoir, const char *uri, const char *value);
+void random_select_reservoir_clear(struct t_random_select_reservoir *reservoir);
 unsigned random_select_albums(struct t_partition_state *partition_state, struct t_stickerdb_state *stickerdb,
         struct t_cache *album_cache, unsigned add_albums, struct t_list *queue_list, struct t_list *add_list,
         struct t_random_add_constraints *constraints);
@@ -11,6 +11,7 @@
 #include "src/mympd_client/search.h"
 
 #include "src/lib/log.h"
+#include "src/lib/playlist_catalogue.h"
 #include "src/lib/sds/sds_extras.h"
 #include "src/mympd_client/errorhandler.h"
 #include "src/mympd_client/tags.h"
@@ -51,6 +52,7 @@ bool mympd_client_search_add_to_plist_window(struct t_partition_state *partition
         *error = sdscat(*error, "Error creating MPD search command");
         return false;
     }
+    playlist_catalogue_clear(&partition_state->mpd_state->playlist_catalogue);
     mpd_search_commit(partition_state->conn);
     return mympd_check_error_and_recover(partition_state, error, "mpd_search_add_db_songs_to_playlist");
 }
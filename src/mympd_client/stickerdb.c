@@ -18,6 +18,7 @@
 #include "src/lib/log.h"
 #include "src/lib/sds/sds_extras.h"
 #include "src/lib/sticker.h"
+#include "src/lib/sticker_cache.h"
 #include "src/lib/utility.h"
 #include "src/mympd_api/requests.h"
 
@@ -42,8 +43,19 @@ static bool set_sticker_int64(struct t_stickerdb_state *stickerdb, enum mympd_st
 static bool dec_sticker(struct t_stickerdb_state *stickerdb, enum mympd_sticker_type type, const char *uri, const char *name, unsigned value);
 static bool inc_sticker(struct t_stickerdb_state *stickerdb, enum mympd_sticker_type type, const char *uri, const char *name, unsigned value);
 static bool remove_sticker(struct t_stickerdb_state *stickerdb, enum mympd_sticker_type type, const char *uri, const char *name);
+static sds sticker_int64_to_str(struct t_stickerdb_state *stickerdb, int64_t value);
 static bool stickerdb_connect_mpd(struct t_stickerdb_state *stickerdb);
 static bool check_sticker_support(struct t_stickerdb_state *stickerdb);
+static bool stickerdb_leave_idle(struct t_stickerdb_state *stickerdb);
+static bool stickerdb_require_conn(struct t_stickerdb_state *stickerdb);
+static bool stickerdb_drain_own_events(struct t_stickerdb_state *stickerdb);
+
+static bool sticker_cache_is_valid(struct t_stickerdb_state *stickerdb, enum mympd_sticker_type type);
+static bool sticker_cache_check(struct t_stickerdb_state *stickerdb, enum mympd_sticker_type type);
+static bool sticker_cache_warm(struct t_stickerdb_state *stickerdb);
+static bool sticker_cache_scan(struct t_stickerdb_state *stickerdb, const char *name);
+static void sticker_cache_queue_inc(struct t_stickerdb_state *stickerdb, const char *uri, const char *name, unsigned value);
+static bool sticker_cache_flush(struct t_stickerdb_state *stickerdb);
 
 // Public functions
 
@@ -65,7 +77,8 @@ bool stickerdb_connect(struct t_stickerdb_state *stickerdb) {
     if (stickerdb->conn_state == MPD_CONNECTED) {
         // already connected
         MYMPD_LOG_DEBUG("stickerdb", "Connected, leaving idle mode");
-        if (stickerdb_exit_idle(stickerdb) == true) {
+        if (stickerdb_leave_idle(stickerdb) == true) {
+            sticker_cache_flush(stickerdb);
             return true;
         }
         // stickerdb connection broken
@@ -107,6 +120,8 @@ bool stickerdb_connect(struct t_stickerdb_state *stickerdb) {
     mympd_api_request_sticker_features(stickerdb->mpd_state->feat.stickers,
         stickerdb->mpd_state->feat.advsticker);
     *stickerdb->repopulate_pfds = true;
+    // write the stickers that could not be written before the reconnect
+    sticker_cache_flush(stickerdb);
     MYMPD_LOG_DEBUG("stickerdb", "MPD connected and waiting for commands");
     return true;
 }
@@ -122,19 +137,38 @@ void stickerdb_disconnect(struct t_stickerdb_state *stickerdb) {
     }
     stickerdb->conn = NULL;
     stickerdb->conn_state = MPD_DISCONNECTED;
+    stickerdb->idle = false;
+    // sticker changes are not tracked without connection
+    sticker_cache_clear(&stickerdb->cache);
     *stickerdb->repopulate_pfds = true;
 }
 
 /**
- * Discards waiting idle events for the stickerdb connection.
- * This prevents the connection to timeout.
+ * Writes the pending sticker writes to MPD
+ * @param stickerdb pointer to the stickerdb state
+ * @return true on success, else false
+ */
+bool stickerdb_flush(struct t_stickerdb_state *stickerdb) {
+    if (stickerdb->cache.pending->numele == 0) {
+        return true;
+    }
+    // stickerdb_connect flushes the pending writes
+    if (stickerdb_connect(stickerdb) == false) {
+        return false;
+    }
+    return stickerdb_enter_idle(stickerdb);
+}
+
+/**
+ * Handles waiting idle events for the stickerdb connection.
+ * This prevents the connection to timeout and keeps the sticker cache coherent.
  * @param stickerdb pointer to the stickerdb state
  * @return true on success, else false
  */
 bool stickerdb_idle(struct t_stickerdb_state *stickerdb) {
-    MYMPD_LOG_DEBUG("stickerdb", "Discarding idle events");
+    MYMPD_LOG_DEBUG("stickerdb", "Handling idle events");
     mympd_api_request_trigger_event_emit(TRIGGER_MPD_STICKER, MPD_PARTITION_DEFAULT, NULL, 0);
-    return stickerdb_exit_idle(stickerdb) &&
+    return stickerdb_leave_idle(stickerdb) &&
         stickerdb_enter_idle(stickerdb);
 }
 
@@ -144,27 +178,35 @@ bool stickerdb_idle(struct t_stickerdb_state *stickerdb) {
  * @return true on success, else false
  */
 bool stickerdb_enter_idle(struct t_stickerdb_state *stickerdb) {
+    if (stickerdb->idle == true) {
+        // the connection stayed in idle mode, stickers were served from the cache
+        return true;
+    }
     MYMPD_LOG_DEBUG("stickerdb", "Entering idle mode");
-    // the idle events are discarded in the mympd api loop
+    // the idle events are handled in the mympd api loop
     if (mpd_send_idle_mask(stickerdb->conn, MPD_IDLE_STICKER) == false) {
         MYMPD_LOG_ERROR("stickerdb", "Error entering idle mode");
         stickerdb_disconnect(stickerdb);
         return false;
     }
+    stickerdb->idle = true;
     return true;
 }
 
 /**
- * Exits the idle mode, ignoring all idle events
+ * Exits the idle mode for batch reads.
+ * The connection stays in idle mode if the song stickers can be served from the cache,
+ * the batch functions leave the idle mode on demand.
  * @param stickerdb pointer to the stickerdb state
  * @return true on success, else false
  */
 bool stickerdb_exit_idle(struct t_stickerdb_state *stickerdb) {
-    MYMPD_LOG_DEBUG("stickerdb", "Exiting idle mode");
-    if (mpd_send_noidle(stickerdb->conn) == false) {
-        MYMPD_LOG_ERROR("stickerdb", "Error exiting idle mode");
+    if (stickerdb->cache.valid == true &&
+        stickerdb->idle == true)
+    {
+        return true;
     }
-    return stickerdb_check_error_and_recover(stickerdb, "mpd_send_noidle");
+    return stickerdb_leave_idle(stickerdb);
 }
 
 /**
@@ -232,7 +274,9 @@ sds stickerdb_get(struct t_stickerdb_state *stickerdb, enum mympd_sticker_type t
     if (is_streamuri(uri) == true) {
         return sdsempty();
     }
-    if (stickerdb_connect(stickerdb) == false) {
+    if (sticker_cache_is_valid(stickerdb, type) == false &&
+        stickerdb_connect(stickerdb) == false)
+    {
         return sdsempty();
     }
     sds value = get_sticker_value(stickerdb, type, uri, name);
@@ -271,8 +315,10 @@ int64_t stickerdb_get_int64(struct t_stickerdb_state *stickerdb, enum mympd_stic
     if (is_streamuri(uri) == true) {
         return value;
     }
-    if (stickerdb_connect(stickerdb) == false) {
-        return false;
+    if (sticker_cache_is_valid(stickerdb, type) == false &&
+        stickerdb_connect(stickerdb) == false)
+    {
+        return value;
     }
     value = get_sticker_int64(stickerdb, type, uri, name);
     stickerdb_enter_idle(stickerdb);
@@ -341,7 +387,9 @@ struct t_sticker *stickerdb_get_all(struct t_stickerdb_state *stickerdb, enum my
     if (is_streamuri(uri) == true) {
         return NULL;
     }
-    if (stickerdb_connect(stickerdb) == false) {
+    if (sticker_cache_is_valid(stickerdb, type) == false &&
+        stickerdb_connect(stickerdb) == false)
+    {
         return NULL;
     }
     sticker = get_sticker_all(stickerdb, type, uri, sticker, user_defined);
@@ -591,6 +639,14 @@ bool stickerdb_inc(struct t_stickerdb_state *stickerdb, enum mympd_sticker_type
  * @return true on success, else false
  */
 bool stickerdb_set_elapsed(struct t_stickerdb_state *stickerdb, enum mympd_sticker_type type, const char *uri, time_t elapsed) {
+    if (is_streamuri(uri) == true) {
+        return true;
+    }
+    if (sticker_cache_is_valid(stickerdb, type) == true) {
+        // write back by the flush timer
+        sticker_cache_queue(&stickerdb->cache, uri, sticker_name_lookup(STICKER_ELAPSED), (int64_t)elapsed, false);
+        return true;
+    }
     return stickerdb_set_int64(stickerdb, type, uri, sticker_name_lookup(STICKER_ELAPSED), (int64_t)elapsed);
 }
 
@@ -610,6 +666,12 @@ bool stickerdb_inc_set(struct t_stickerdb_state *stickerdb, enum mympd_sticker_t
     if (is_streamuri(uri) == true) {
         return true;
     }
+    if (sticker_cache_is_valid(stickerdb, type) == true) {
+        // write back by the flush timer
+        sticker_cache_queue(&stickerdb->cache, uri, sticker_name_lookup(name_timestamp), (int64_t)timestamp, false);
+        sticker_cache_queue_inc(stickerdb, uri, sticker_name_lookup(name_inc), 1);
+        return true;
+    }
     if (stickerdb_connect(stickerdb) == false) {
         return false;
     }
@@ -790,9 +852,16 @@ static struct t_sticker *get_sticker_all(struct t_stickerdb_state *stickerdb, en
         const char *uri, struct t_sticker *sticker, bool user_defined)
 {
     struct mpd_pair *pair;
+    if (sticker_cache_check(stickerdb, type) == true &&
+        sticker_cache_get_all(&stickerdb->cache, uri, sticker, user_defined) == true)
+    {
+        return sticker;
+    }
     sticker_struct_init(sticker);
     const char *type_name = mympd_sticker_type_name_lookup(type);
-    if (type_name == NULL) {
+    if (type_name == NULL ||
+        stickerdb_require_conn(stickerdb) == false)
+    {
         return sticker;
     }
     if (mpd_send_sticker_list(stickerdb->conn, type_name, uri)) {
@@ -825,9 +894,17 @@ static struct t_sticker *get_sticker_all(struct t_stickerdb_state *stickerdb, en
  */
 static sds get_sticker_value(struct t_stickerdb_state *stickerdb, enum mympd_sticker_type type, const char *uri, const char *name) {
     struct mpd_pair *pair;
+    if (sticker_cache_check(stickerdb, type) == true) {
+        sds cached = sticker_cache_get(&stickerdb->cache, uri, name);
+        if (cached != NULL) {
+            return cached;
+        }
+    }
     sds value = sdsempty();
     const char *type_name = mympd_sticker_type_name_lookup(type);
-    if (type_name == NULL) {
+    if (type_name == NULL ||
+        stickerdb_require_conn(stickerdb) == false)
+    {
         return value;
     }
     if (mpd_send_sticker_list(stickerdb->conn, type_name, uri)) {
@@ -853,8 +930,15 @@ static sds get_sticker_value(struct t_stickerdb_state *stickerdb, enum mympd_sti
 int64_t get_sticker_int64(struct t_stickerdb_state *stickerdb, enum mympd_sticker_type type, const char *uri, const char *name) {
     struct mpd_pair *pair;
     int64_t value = 0;
+    if (sticker_cache_check(stickerdb, type) == true &&
+        sticker_cache_get_int64(&stickerdb->cache, uri, name, &value) == true)
+    {
+        return value;
+    }
     const char *type_name = mympd_sticker_type_name_lookup(type);
-    if (type_name == NULL) {
+    if (type_name == NULL ||
+        stickerdb_require_conn(stickerdb) == false)
+    {
         return value;
     }
     if (mpd_send_sticker_list(stickerdb->conn, type_name, uri)) {
@@ -885,7 +969,14 @@ static bool set_sticker_value(struct t_stickerdb_state *stickerdb, enum mympd_st
     }
     MYMPD_LOG_INFO(stickerdb->name, "Setting sticker %s: \"%s\" -> %s: %s", type_name, uri, name, value);
     mpd_run_sticker_set(stickerdb->conn, type_name, uri, name, value);
-    return stickerdb_check_error_and_recover(stickerdb, "mpd_run_sticker_set");
+    if (stickerdb_check_error_and_recover(stickerdb, "mpd_run_sticker_set") == false) {
+        return false;
+    }
+    stickerdb_drain_own_events(stickerdb);
+    if (sticker_cache_is_valid(stickerdb, type) == true) {
+        sticker_cache_set(&stickerdb->cache, uri, name, value);
+    }
+    return true;
 }
 
 /**
@@ -898,21 +989,7 @@ static bool set_sticker_value(struct t_stickerdb_state *stickerdb, enum mympd_st
  * @return true on success, else false
  */
 static bool set_sticker_int64(struct t_stickerdb_state *stickerdb, enum mympd_sticker_type type, const char *uri, const char *name, int64_t value) {
-    sds value_str = sdsfromlonglong((long long)value);
-    if (stickerdb->config->stickers_pad_int == true &&
-        stickerdb->mpd_state->feat.advsticker == false)
-    {
-        sds pad_str = sdsempty();
-        size_t value_len = sdslen(value_str);
-        if (value_len < PADDING_LENGTH) {
-            for (size_t i = 0, j = PADDING_LENGTH - value_len; i < j; i++) {
-                pad_str = sds_catchar(pad_str, '0');
-            }
-        }
-        pad_str = sdscatsds(pad_str, value_str);
-        FREE_SDS(value_str);
-        value_str = pad_str;
-    }
+    sds value_str = sticker_int64_to_str(stickerdb, value);
     bool rc = set_sticker_value(stickerdb, type, uri, name, value_str);
     FREE_SDS(value_str);
     return rc;
@@ -934,7 +1011,14 @@ static bool dec_sticker(struct t_stickerdb_state *stickerdb, enum mympd_sticker_
             return false;
         }
         mpd_run_sticker_dec(stickerdb->conn, type_name, uri, name, value);
-        return stickerdb_check_error_and_recover(stickerdb, "mpd_run_sticker_dec");
+        if (stickerdb_check_error_and_recover(stickerdb, "mpd_run_sticker_dec") == false) {
+            return false;
+        }
+        stickerdb_drain_own_events(stickerdb);
+        if (sticker_cache_is_valid(stickerdb, type) == true) {
+            sticker_cache_inc(&stickerdb->cache, uri, name, -(int64_t)value);
+        }
+        return true;
     }
     // MPD < 0.24
     int64_t new_value = get_sticker_int64(stickerdb, type, uri, name) - value;
@@ -957,7 +1041,14 @@ static bool inc_sticker(struct t_stickerdb_state *stickerdb, enum mympd_sticker_
             return false;
         }
         mpd_run_sticker_inc(stickerdb->conn, type_name, uri, name, value);
-        return stickerdb_check_error_and_recover(stickerdb, "mpd_run_sticker_inc");
+        if (stickerdb_check_error_and_recover(stickerdb, "mpd_run_sticker_inc") == false) {
+            return false;
+        }
+        stickerdb_drain_own_events(stickerdb);
+        if (sticker_cache_is_valid(stickerdb, type) == true) {
+            sticker_cache_inc(&stickerdb->cache, uri, name, (int64_t)value);
+        }
+        return true;
     }
     // MPD < 0.24
     int64_t new_value = get_sticker_int64(stickerdb, type, uri, name) + value;
@@ -979,7 +1070,39 @@ static bool remove_sticker(struct t_stickerdb_state *stickerdb, enum mympd_stick
     }
     MYMPD_LOG_INFO(stickerdb->name, "Removing sticker: \"%s\" -> %s", uri, name);
     mpd_run_sticker_delete(stickerdb->conn, type_name, uri, name);
-    return stickerdb_check_error_and_recover(stickerdb, "mpd_run_sticker_delete");
+    if (stickerdb_check_error_and_recover(stickerdb, "mpd_run_sticker_delete") == false) {
+        return false;
+    }
+    stickerdb_drain_own_events(stickerdb);
+    if (sticker_cache_is_valid(stickerdb, type) == true) {
+        sticker_cache_remove(&stickerdb->cache, uri, name);
+    }
+    return true;
+}
+
+/**
+ * Converts a number to a sticker value, pads the number for MPD < 0.24
+ * @param stickerdb pointer to the stickerdb state
+ * @param value number to convert
+ * @return newly allocated sds string
+ */
+static sds sticker_int64_to_str(struct t_stickerdb_state *stickerdb, int64_t value) {
+    sds value_str = sdsfromlonglong((long long)value);
+    if (stickerdb->config->stickers_pad_int == true &&
+        stickerdb->mpd_state->feat.advsticker == false)
+    {
+        sds pad_str = sdsempty();
+        size_t value_len = sdslen(value_str);
+        if (value_len < PADDING_LENGTH) {
+            for (size_t i = 0, j = PADDING_LENGTH - value_len; i < j; i++) {
+                pad_str = sds_catchar(pad_str, '0');
+            }
+        }
+        pad_str = sdscatsds(pad_str, value_str);
+        FREE_SDS(value_str);
+        value_str = pad_str;
+    }
+    return value_str;
 }
 
 /**
@@ -1035,6 +1158,7 @@ static bool stickerdb_connect_mpd(struct t_stickerdb_state *stickerdb) {
 
     MYMPD_LOG_NOTICE(stickerdb->name, "Connected to MPD");
     stickerdb->conn_state = MPD_CONNECTED;
+    stickerdb->idle = false;
     return true;
 }
 
@@ -1061,3 +1185,258 @@ static bool check_sticker_support(struct t_stickerdb_state *stickerdb) {
     }
     return supported;
 }
+
+/**
+ * Leaves the idle mode and handles the sticker idle event
+ * @param stickerdb pointer to the stickerdb state
+ * @return true on success, else false
+ */
+static bool stickerdb_leave_idle(struct t_stickerdb_state *stickerdb) {
+    MYMPD_LOG_DEBUG("stickerdb", "Exiting idle mode");
+    if (mpd_send_noidle(stickerdb->conn) == false) {
+        MYMPD_LOG_ERROR("stickerdb", "Error exiting idle mode");
+    }
+    else {
+        enum mpd_idle events = mpd_recv_idle(stickerdb->conn, false);
+        // the events of our own writes are drained after each write,
+        // this event was caused by another client
+        if ((events & MPD_IDLE_STICKER) == MPD_IDLE_STICKER &&
+            stickerdb->cache.valid == true)
+        {
+            MYMPD_LOG_INFO(stickerdb->name, "Stickers were changed by another client, invalidating the sticker cache");
+            sticker_cache_clear(&stickerdb->cache);
+        }
+    }
+    stickerdb->idle = false;
+    return stickerdb_check_error_and_recover(stickerdb, "mpd_send_noidle");
+}
+
+/**
+ * Consumes the sticker idle event that our own writes have caused.
+ * The idle command returns at once if an event is pending.
+ * Changes of other clients that are reported before are handled by stickerdb_leave_idle.
+ * The connection must not be in idle mode.
+ * @param stickerdb pointer to the stickerdb state
+ * @return true on success, else false
+ */
+static bool stickerdb_drain_own_events(struct t_stickerdb_state *stickerdb) {
+    if (stickerdb->conn_state != MPD_CONNECTED) {
+        return false;
+    }
+    if (mpd_send_idle_mask(stickerdb->conn, MPD_IDLE_STICKER) == true &&
+        mpd_send_noidle(stickerdb->conn) == true)
+    {
+        mpd_recv_idle(stickerdb->conn, false);
+    }
+    return stickerdb_check_error_and_recover(stickerdb, "mpd_send_idle_mask");
+}
+
+/**
+ * Leaves the idle mode, if the connection stayed in idle mode for batch reads
+ * @param stickerdb pointer to the stickerdb state
+ * @return true on success, else false
+ */
+static bool stickerdb_require_conn(struct t_stickerdb_state *stickerdb) {
+    if (stickerdb->idle == false) {
+        return true;
+    }
+    return stickerdb_leave_idle(stickerdb);
+}
+
+/**
+ * Checks if the sticker cache can serve the sticker type
+ * @param stickerdb pointer to the stickerdb state
+ * @param type MPD sticker type
+ * @return true if the cache is valid for this type, else false
+ */
+static bool sticker_cache_is_valid(struct t_stickerdb_state *stickerdb, enum mympd_sticker_type type) {
+    return stickerdb->cache.valid == true &&
+        type == STICKER_TYPE_SONG;
+}
+
+/**
+ * Checks if the sticker cache can serve the sticker type and warms the cache on demand.
+ * Warming requires a connection that is not in idle mode.
+ * @param stickerdb pointer to the stickerdb state
+ * @param type MPD sticker type
+ * @return true if the cache is valid for this type, else false
+ */
+static bool sticker_cache_check(struct t_stickerdb_state *stickerdb, enum mympd_sticker_type type) {
+    if (stickerdb->cache.enabled == false ||
+        type != STICKER_TYPE_SONG)
+    {
+        return false;
+    }
+    if (stickerdb->cache.valid == true) {
+        return true;
+    }
+    if (stickerdb->idle == true ||
+        stickerdb->conn_state != MPD_CONNECTED)
+    {
+        return false;
+    }
+    return sticker_cache_warm(stickerdb);
+}
+
+/**
+ * Populates the sticker cache with a sticker find scan for each sticker name.
+ * User defined stickers are only cached for MPD 0.24 and above,
+ * older versions can not list the sticker names.
+ * @param stickerdb pointer to the stickerdb state
+ * @return true on success, else false
+ */
+static bool sticker_cache_warm(struct t_stickerdb_state *stickerdb) {
+    // the pending writes must be visible for the scan
+    if (sticker_cache_flush(stickerdb) == false) {
+        return false;
+    }
+    sticker_cache_clear(&stickerdb->cache);
+    struct t_list names;
+    list_init(&names);
+    for (int i = 0; i < STICKER_COUNT; i++) {
+        list_push(&names, sticker_name_lookup((enum mympd_sticker_names)i), 0, NULL, NULL);
+    }
+    bool user_defined = false;
+    if (stickerdb->mpd_state->feat.advsticker == true) {
+        struct mpd_pair *pair;
+        if (mpd_send_stickernamestypes(stickerdb->conn, mympd_sticker_type_name_lookup(STICKER_TYPE_SONG))) {
+            while ((pair = mpd_recv_pair(stickerdb->conn)) != NULL) {
+                if (strcmp(pair->name, "name") == 0 &&
+                    sticker_name_parse(pair->value) == STICKER_UNKNOWN)
+                {
+                    list_push(&names, pair->value, 0, NULL, NULL);
+                }
+                mpd_return_pair(stickerdb->conn, pair);
+            }
+        }
+        user_defined = stickerdb_check_error_and_recover(stickerdb, "mpd_send_stickernamestypes");
+    }
+    bool rc = true;
+    struct t_list_node *current = names.head;
+    while (current != NULL) {
+        if (sticker_cache_scan(stickerdb, current->key) == false) {
+            rc = false;
+            break;
+        }
+        current = current->next;
+    }
+    list_clear(&names);
+    if (rc == false) {
+        MYMPD_LOG_ERROR(stickerdb->name, "Warming the sticker cache failed");
+        sticker_cache_clear(&stickerdb->cache);
+        return false;
+    }
+    stickerdb->cache.valid = true;
+    stickerdb->cache.user_defined = user_defined;
+    MYMPD_LOG_INFO(stickerdb->name, "Sticker cache warmed with stickers for %" PRIu64 " songs", stickerdb->cache.songs->numele);
+    return true;
+}
+
+/**
+ * Adds all song stickers with the given name to the sticker cache
+ * @param stickerdb pointer to the stickerdb state
+ * @param name sticker name
+ * @return true on success, else false
+ */
+static bool sticker_cache_scan(struct t_stickerdb_state *stickerdb, const char *name) {
+    if (mpd_sticker_search_begin(stickerdb->conn, mympd_sticker_type_name_lookup(STICKER_TYPE_SONG), NULL, name) == false) {
+        mpd_sticker_search_cancel(stickerdb->conn);
+        return false;
+    }
+    struct mpd_pair *pair;
+    size_t name_len = strlen(name) + 1;
+    sds file = sdsempty();
+    if (mpd_sticker_search_commit(stickerdb->conn) == true) {
+        while ((pair = mpd_recv_pair(stickerdb->conn)) != NULL) {
+            if (strcmp(pair->name, "file") == 0) {
+                file = sds_replace(file, pair->value);
+            }
+            else if (strcmp(pair->name, "sticker") == 0 &&
+                strlen(pair->value) >= name_len)
+            {
+                sticker_cache_set(&stickerdb->cache, file, name, pair->value + name_len);
+            }
+            mpd_return_sticker(stickerdb->conn, pair);
+        }
+    }
+    FREE_SDS(file);
+    return stickerdb_check_error_and_recover(stickerdb, "mpd_sticker_search_commit");
+}
+
+/**
+ * Queues a sticker increment.
+ * MPD < 0.24 has no increment command, the new value is calculated from the cache.
+ * @param stickerdb pointer to the stickerdb state
+ * @param uri song uri
+ * @param name sticker name
+ * @param value value to increment
+ */
+static void sticker_cache_queue_inc(struct t_stickerdb_state *stickerdb, const char *uri, const char *name, unsigned value) {
+    if (stickerdb->mpd_state->feat.advsticker == true) {
+        sticker_cache_queue(&stickerdb->cache, uri, name, (int64_t)value, true);
+        return;
+    }
+    int64_t current;
+    sticker_cache_get_int64(&stickerdb->cache, uri, name, &current);
+    sticker_cache_queue(&stickerdb->cache, uri, name, current + value, false);
+}
+
+/**
+ * Sends the pending sticker writes in one command list.
+ * Only the writes that MPD has acknowledged are removed from the pending writes,
+ * the others are written with the next flush.
+ * The connection must not be in idle mode.
+ * @param stickerdb pointer to the stickerdb state
+ * @return true on success, else false
+ */
+static bool sticker_cache_flush(struct t_stickerdb_state *stickerdb) {
+    if (stickerdb->cache.pending->numele == 0) {
+        return true;
+    }
+    MYMPD_LOG_INFO(stickerdb->name, "Writing %" PRIu64 " pending stickers", stickerdb->cache.pending->numele);
+    const char *type_name = mympd_sticker_type_name_lookup(STICKER_TYPE_SONG);
+    bool rc = mpd_command_list_begin(stickerdb->conn, true);
+    raxIterator iter;
+    raxStart(&iter, stickerdb->cache.pending);
+    raxSeek(&iter, "^", NULL, 0);
+    while (rc == true &&
+        raxNext(&iter))
+    {
+        struct t_sticker_cache_write *write = (struct t_sticker_cache_write *)iter.data;
+        if (write->inc == true) {
+            rc = mpd_send_sticker_inc(stickerdb->conn, type_name, write->uri, write->name, (unsigned)write->value);
+        }
+        else {
+            sds value_str = sticker_int64_to_str(stickerdb, write->value);
+            rc = mpd_send_sticker_set(stickerdb->conn, type_name, write->uri, write->name, value_str);
+            FREE_SDS(value_str);
+        }
+    }
+    raxStop(&iter);
+    size_t written = 0;
+    if (rc == true) {
+        rc = mpd_command_list_end(stickerdb->conn);
+    }
+    if (rc == true) {
+        // each acknowledged command was written
+        while (mpd_response_next(stickerdb->conn) == true) {
+            written++;
+        }
+        rc = mpd_response_finish(stickerdb->conn);
+    }
+    if (stickerdb_check_error_and_recover(stickerdb, "sticker command list") == false ||
+        rc == false)
+    {
+        // the cache does not reflect the sticker database anymore
+        sticker_cache_clear(&stickerdb->cache);
+        rc = false;
+    }
+    if (written > 0) {
+        stickerdb_drain_own_events(stickerdb);
+    }
+    if (written < stickerdb->cache.pending->numele) {
+        MYMPD_LOG_WARN(stickerdb->name, "Keeping %" PRIu64 " unwritten stickers", (uint64_t)(stickerdb->cache.pending->numele - written));
+    }
+    sticker_cache_pending_drop(&stickerdb->cache, written);
+    return rc;
+}
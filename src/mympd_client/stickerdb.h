@@ -15,6 +15,7 @@
 
 bool stickerdb_connect(struct t_stickerdb_state *stickerdb);
 void stickerdb_disconnect(struct t_stickerdb_state *stickerdb);
+bool stickerdb_flush(struct t_stickerdb_state *stickerdb);
 bool stickerdb_idle(struct t_stickerdb_state *stickerdb);
 bool stickerdb_enter_idle(struct t_stickerdb_state *stickerdb);
 bool stickerdb_exit_idle(struct t_stickerdb_state *stickerdb);
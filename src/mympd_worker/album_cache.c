@@ -13,10 +13,13 @@
 
 #include "src/lib/album.h"
 #include "src/lib/cache/cache_rax_album.h"
+#include "src/lib/cache/cache_rax_album_index.h"
+#include "src/lib/cache/cache_rax_album_songs.h"
 #include "src/lib/datetime.h"
 #include "src/lib/filehandler.h"
 #include "src/lib/json/json_rpc.h"
 #include "src/lib/log.h"
+#include "src/lib/mem.h"
 #include "src/lib/msg_queue.h"
 #include "src/lib/sds/sds_extras.h"
 #include "src/lib/utility.h"
@@ -32,8 +35,27 @@
 /**
  * Private definitions
  */
-static bool album_cache_create(struct t_mympd_worker_state *mympd_worker_state, rax *album_cache);
+
+/**
+ * Result of an incremental album cache update
+ */
+enum album_cache_update_rc {
+    ALBUM_CACHE_UPDATE_OK,        //!< album cache was updated
+    ALBUM_CACHE_UPDATE_FALLBACK,  //!< a full rebuild is required
+    ALBUM_CACHE_UPDATE_ERROR      //!< error communicating with mpd
+};
+
+static bool album_cache_create(struct t_mympd_worker_state *mympd_worker_state, rax *album_cache,
+        struct t_album_songs *album_songs);
+static enum album_cache_update_rc album_cache_update(struct t_mympd_worker_state *mympd_worker_state,
+        struct t_cache *album_cache, struct t_album_songs *album_songs);
 static bool album_cache_create_simple(struct t_mympd_worker_state *mympd_worker_state, rax *album_cache);
+static void album_cache_set_tags(struct t_mympd_worker_state *mympd_worker_state);
+static struct t_album *album_cache_new_album(struct t_mympd_worker_state *mympd_worker_state, const struct mpd_song *song);
+static void album_cache_fix_tags(struct t_mympd_worker_state *mympd_worker_state, struct t_album *album);
+static bool album_cache_song_has_album(const struct mpd_song *song, const struct t_albums_config *album_config);
+static bool album_cache_mark_uris(struct t_mympd_worker_state *mympd_worker_state, struct t_album_songs *album_songs,
+        unsigned *unknown);
 
 /**
  * Public functions
@@ -43,9 +65,10 @@ static bool album_cache_create_simple(struct t_mympd_worker_state *mympd_worker_
  * Creates the album cache and returns it to the mympd_api thread
  * @param mympd_worker_state pointer to mympd_worker_state struct
  * @param force true=force update, false=update only if mpd database is newer then the cache
+ * @param incremental true=patch the albums of changed songs, false=rebuild the cache completely
  * @return true on success else false
  */
-bool mympd_worker_album_cache_create(struct t_mympd_worker_state *mympd_worker_state, bool force) {
+bool mympd_worker_album_cache_create(struct t_mympd_worker_state *mympd_worker_state, bool force, bool incremental) {
     if (force == false) {
         // Update cache only if database mtime is newer then album cache mtime
         time_t db_mtime = mympd_client_get_db_mtime(mympd_worker_state->partition_state);
@@ -75,26 +98,64 @@ bool mympd_worker_album_cache_create(struct t_mympd_worker_state *mympd_worker_s
 
     bool rc = true;
     if (mympd_worker_state->partition_state->mpd_state->feat.tags == true) {
-        struct t_cache album_cache;
-        album_cache.cache = raxNew();
-        rc = mympd_worker_state->config->albums.mode == ALBUM_MODE_ADV
-            ? album_cache_create(mympd_worker_state, album_cache.cache)
-            : album_cache_create_simple(mympd_worker_state, album_cache.cache);
+        struct t_cache *album_cache = malloc_assert(sizeof(struct t_cache));
+        album_cache->cache = NULL;
+        album_cache->index = NULL;
+        album_cache->pool = NULL;
+        album_cache->map = NULL;
+        struct t_album_songs album_songs;
+        album_songs_init(&album_songs);
+        if (mympd_worker_state->config->albums.mode == ALBUM_MODE_ADV) {
+            enum album_cache_update_rc update_rc = incremental == true
+                ? album_cache_update(mympd_worker_state, album_cache, &album_songs)
+                : ALBUM_CACHE_UPDATE_FALLBACK;
+            if (update_rc == ALBUM_CACHE_UPDATE_FALLBACK) {
+                // discard partial results and rebuild the cache completely
+                album_cache_free(album_cache);
+                album_songs_clear(&album_songs);
+                album_songs_init(&album_songs);
+                album_cache->cache = raxNew();
+                rc = album_cache_create(mympd_worker_state, album_cache->cache, &album_songs);
+            }
+            else {
+                rc = update_rc == ALBUM_CACHE_UPDATE_OK;
+            }
+        }
+        else {
+            album_cache->cache = raxNew();
+            rc = album_cache_create_simple(mympd_worker_state, album_cache->cache);
+        }
         if (rc == true) {
+            // presort the album cache for the album list view
+            album_cache->index = album_index_new();
+            album_index_create_default(album_cache->index, album_cache->cache,
+                &mympd_worker_state->mpd_state->tags_mympd, &mympd_worker_state->config->albums);
+            // normalize the tag values once for searching
+            album_cache_normalize(album_cache);
+            // write the cache before handing it over, the mympd_api thread owns it afterwards
+            album_cache_write(album_cache, mympd_worker_state->config->workdir,
+                &mympd_worker_state->mpd_state->tags_album, &mympd_worker_state->config->albums, false);
+            // the song index is only maintained for the advanced album mode
+            if (mympd_worker_state->config->albums.mode == ALBUM_MODE_ADV) {
+                album_songs_write(&album_songs, mympd_worker_state->config->workdir, &mympd_worker_state->mpd_state->tags_album);
+            }
+            else {
+                album_songs_remove_file(mympd_worker_state->config->workdir);
+            }
             struct t_work_request *request = create_request(REQUEST_TYPE_DISCARD, 0, 0, INTERNAL_API_ALBUMCACHE_CREATED, "", mympd_worker_state->partition_state->name);
-            request->extra = (void *) album_cache.cache;
-            request->extra_free = album_cache_free_rt_void;
+            request->extra = (void *) album_cache;
+            request->extra_free = album_cache_free_void;
             mympd_queue_push(mympd_api_queue, request, 0);
             send_jsonrpc_notify(JSONRPC_FACILITY_DATABASE, JSONRPC_SEVERITY_INFO, MPD_PARTITION_ALL, "Updated album cache");
-            album_cache_write(&album_cache, mympd_worker_state->config->workdir,
-                &mympd_worker_state->mpd_state->tags_album, &mympd_worker_state->config->albums, false);
         }
         else {
-            album_cache_free(&album_cache);
+            album_cache_free(album_cache);
+            FREE_PTR(album_cache);
             send_jsonrpc_notify(JSONRPC_FACILITY_DATABASE, JSONRPC_SEVERITY_ERROR, MPD_PARTITION_ALL, "Update of album cache failed");
             struct t_work_request *request = create_request(REQUEST_TYPE_DISCARD, 0, 0, INTERNAL_API_ALBUMCACHE_ERROR, "", mympd_worker_state->partition_state->name);
             mympd_queue_push(mympd_api_queue, request, 0);
         }
+        album_songs_clear(&album_songs);
     }
     else {
         MYMPD_LOG_INFO("default", "Skipped album cache creation, tags are disabled");
@@ -114,9 +175,12 @@ bool mympd_worker_album_cache_create(struct t_mympd_worker_state *mympd_worker_s
  * Initializes the album cache
  * @param mympd_worker_state pointer to mympd_worker_state struct
  * @param album_cache pointer to empty album_cache
+ * @param album_songs pointer to empty song index to populate
  * @return true on success, else false
  */
-static bool album_cache_create(struct t_mympd_worker_state *mympd_worker_state, rax *album_cache) {
+static bool album_cache_create(struct t_mympd_worker_state *mympd_worker_state, rax *album_cache,
+        struct t_album_songs *album_songs)
+{
     MYMPD_LOG_INFO("default", "Creating album cache");
     if (mympd_worker_state->config->albums.group_tag != MPD_TAG_UNKNOWN) {
         MYMPD_LOG_DEBUG("default", "Additional group tag: %s", mpd_tag_name(mympd_worker_state->config->albums.group_tag));
@@ -131,39 +195,23 @@ static bool album_cache_create(struct t_mympd_worker_state *mympd_worker_state,
     int album_count = 0;
     int skip_count = 0;
 
-    //set interesting tags
-    if (mympd_client_tag_exists(&mympd_worker_state->mpd_state->tags_mympd, MPD_TAG_DISC) == true) {
-        if (mympd_client_tag_exists(&mympd_worker_state->mpd_state->tags_album, MPD_TAG_DISC) == false) {
-            mympd_worker_state->mpd_state->tags_album.tags[mympd_worker_state->mpd_state->tags_album.len++] = MPD_TAG_DISC;
-        }
-    }
-    else {
-        MYMPD_LOG_WARN("default", "Disc tag is not enabled");
-    }
-    if (mympd_worker_state->config->albums.group_tag != MPD_TAG_UNKNOWN) {
-        if (mympd_client_tag_exists(&mympd_worker_state->mpd_state->tags_mympd, mympd_worker_state->config->albums.group_tag) == true) {
-            if (mympd_client_tag_exists(&mympd_worker_state->mpd_state->tags_album, mympd_worker_state->config->albums.group_tag) == false) {
-                mympd_worker_state->mpd_state->tags_album.tags[mympd_worker_state->mpd_state->tags_album.len++] = mympd_worker_state->config->albums.group_tag;
-            }
-        }
-        else {
-            MYMPD_LOG_WARN("default", "%s tag is not enabled", mpd_tag_name(mympd_worker_state->config->albums.group_tag));
-        }
+    // the song index is based on the database state before fetching the songs
+    if (mympd_client_get_db_stats(mympd_worker_state->partition_state, &album_songs->db_mtime, &album_songs->db_songs) == false) {
+        MYMPD_LOG_ERROR("default", "Cache update failed");
+        return false;
     }
-    enable_mpd_tags(mympd_worker_state->partition_state, &mympd_worker_state->mpd_state->tags_album);
+    album_cache_set_tags(mympd_worker_state);
 
     //get all songs and set albums
     #ifdef MYMPD_DEBUG
         MEASURE_INIT
         MEASURE_START
     #endif
+    // all songs are fetched, the songs without album are added to the song index only
     sds key = sdsempty();
-    const char *search_expression = mympd_worker_state->config->albums.unknown == true
-        ? "((AlbumArtist != ''))"
-        : "((Album != '') AND (AlbumArtist != ''))";
     do {
         if (mpd_search_db_songs(mympd_worker_state->partition_state->conn, false) == false ||
-            mpd_search_add_expression(mympd_worker_state->partition_state->conn, search_expression) == false ||
+            mpd_search_add_expression(mympd_worker_state->partition_state->conn, "(modified-since '0')") == false ||
             mympd_client_add_search_window(mympd_worker_state->partition_state->conn, start, end) == false)
         {
             MYMPD_LOG_ERROR("default", "Cache update failed");
@@ -173,8 +221,16 @@ static bool album_cache_create(struct t_mympd_worker_state *mympd_worker_state,
         if (mpd_search_commit(mympd_worker_state->partition_state->conn)) {
             struct mpd_song *song;
             while ((song = mpd_recv_song(mympd_worker_state->partition_state->conn)) != NULL) {
+                if (album_cache_song_has_album(song, &mympd_worker_state->config->albums) == false) {
+                    sdsclear(key);
+                    sdsfree(album_songs_set(album_songs, song, key, &mympd_worker_state->mpd_state->tags_album));
+                    mpd_song_free(song);
+                    i++;
+                    continue;
+                }
                 // construct the key
                 key = album_cache_get_key_from_song(key, song, &mympd_worker_state->config->albums);
+                sdsfree(album_songs_set(album_songs, song, key, &mympd_worker_state->mpd_state->tags_album));
                 if (sdslen(key) > 0) {
                     void *data;
                     if (raxFind(album_cache, (unsigned char *)key, sdslen(key), &data) == 1) {
@@ -190,24 +246,7 @@ static bool album_cache_create(struct t_mympd_worker_state *mympd_worker_state,
                         album_inc_song_count(album);                                       // inc song count by one
                     }
                     else {
-                        struct t_album *album = album_new_from_song(song, &mympd_worker_state->mpd_state->tags_album);
-                        if (mympd_worker_state->config->albums.unknown == true &&
-                            album_get_unknown(album) == true)
-                        {
-                            MYMPD_LOG_DEBUG(NULL, "Using \"%s\" for Album for uri \"%s\", tag Album is empty", UNKNOWN_ALBUM, mpd_song_get_uri(song));
-                            album_append_tag(album, MPD_TAG_ALBUM, UNKNOWN_ALBUM);
-                        }
-                        if (mympd_worker_state->tag_disc_empty_is_first == true) {
-                            // handle empty disc tag as disc one
-                            album_set_disc_count(album, 1);
-                        }
-                        if (mympd_worker_state->partition_state->mpd_state->tag_albumartist == MPD_TAG_ALBUM_ARTIST &&
-                            album_get_tag(album, MPD_TAG_ALBUM_ARTIST, 0) == NULL)
-                        {
-                            // Copy Artist tag to AlbumArtist tag
-                            // for filters mpd falls back from AlbumArtist to Artist if AlbumArtist does not exist
-                            album_copy_tags(album, MPD_TAG_ARTIST, MPD_TAG_ALBUM_ARTIST);
-                        }
+                        struct t_album *album = album_cache_new_album(mympd_worker_state, song);
                         if (raxTryInsert(album_cache, (unsigned char *)key, sdslen(key), (void *)album, NULL) == 0) {
                             MYMPD_LOG_ERROR(NULL, "Duplicate album id for AlbumArtist: \"%s\", Album: \"%s\"", album_get_tag(album, MPD_TAG_ALBUM_ARTIST, 0), album_get_tag(album, MPD_TAG_ALBUM, 0));
                             album_free(album);
@@ -247,6 +286,152 @@ static bool album_cache_create(struct t_mympd_worker_state *mympd_worker_state,
     return true;
 }
 
+/**
+ * Updates the album cache from disc with the songs changed since the last update.
+ * Only the albums of changed, added and removed songs are recalculated.
+ * @param mympd_worker_state pointer to mympd_worker_state struct
+ * @param album_cache pointer to album_cache to populate
+ * @param album_songs pointer to empty song index to populate
+ * @return ALBUM_CACHE_UPDATE_OK on success,
+ *         ALBUM_CACHE_UPDATE_FALLBACK if a full rebuild is required,
+ *         ALBUM_CACHE_UPDATE_ERROR on mpd error
+ */
+static enum album_cache_update_rc album_cache_update(struct t_mympd_worker_state *mympd_worker_state,
+        struct t_cache *album_cache, struct t_album_songs *album_songs)
+{
+    album_cache_set_tags(mympd_worker_state);
+    if (album_songs_read(album_songs, mympd_worker_state->config->workdir, &mympd_worker_state->mpd_state->tags_album) == false ||
+        album_cache_read(album_cache, mympd_worker_state->config->workdir, &mympd_worker_state->config->albums) == false)
+    {
+        MYMPD_LOG_INFO("default", "No usable album cache found for incremental update");
+        return ALBUM_CACHE_UPDATE_FALLBACK;
+    }
+    time_t db_mtime;
+    unsigned db_songs;
+    if (mympd_client_get_db_stats(mympd_worker_state->partition_state, &db_mtime, &db_songs) == false) {
+        MYMPD_LOG_ERROR("default", "Cache update failed");
+        return ALBUM_CACHE_UPDATE_ERROR;
+    }
+    MYMPD_LOG_INFO("default", "Updating album cache");
+    #ifdef MYMPD_DEBUG
+        MEASURE_INIT
+        MEASURE_START
+    #endif
+
+    // fetch all songs modified since the last update
+    rax *affected = raxNew();
+    unsigned start = 0;
+    unsigned end = start + MPD_RESULTS_MAX;
+    unsigned i = 0;
+    sds key = sdsempty();
+    sds expression = sdscatfmt(sdsempty(), "(modified-since '%I')", (int64_t)album_songs->db_mtime);
+    bool rc = true;
+    do {
+        if (mpd_search_db_songs(mympd_worker_state->partition_state->conn, false) == false ||
+            mpd_search_add_expression(mympd_worker_state->partition_state->conn, expression) == false ||
+            mympd_client_add_search_window(mympd_worker_state->partition_state->conn, start, end) == false)
+        {
+            mpd_search_cancel(mympd_worker_state->partition_state->conn);
+            rc = false;
+            break;
+        }
+        if (mpd_search_commit(mympd_worker_state->partition_state->conn)) {
+            struct mpd_song *song;
+            while ((song = mpd_recv_song(mympd_worker_state->partition_state->conn)) != NULL) {
+                if (album_cache_song_has_album(song, &mympd_worker_state->config->albums) == true) {
+                    key = album_cache_get_key_from_song(key, song, &mympd_worker_state->config->albums);
+                }
+                else {
+                    sdsclear(key);
+                }
+                sds old_key = album_songs_set(album_songs, song, key, &mympd_worker_state->mpd_state->tags_album);
+                if (old_key != NULL &&
+                    sdslen(old_key) > 0)
+                {
+                    raxInsert(affected, (unsigned char *)old_key, sdslen(old_key), NULL, NULL);
+                }
+                FREE_SDS(old_key);
+                if (sdslen(key) > 0) {
+                    raxInsert(affected, (unsigned char *)key, sdslen(key), NULL, NULL);
+                    if (raxFind(album_cache->cache, (unsigned char *)key, sdslen(key), NULL) == 0) {
+                        // tags, counts and timestamps are set by album_songs_patch_albums
+                        struct t_album *album = album_new_uri(mpd_song_get_uri(song));
+                        raxInsert(album_cache->cache, (unsigned char *)key, sdslen(key), album, NULL);
+                    }
+                }
+                mpd_song_free(song);
+                i++;
+            }
+        }
+        if (mympd_check_error_and_recover(mympd_worker_state->partition_state, NULL, "mpd_search_commit") == false) {
+            rc = false;
+            break;
+        }
+        start = end;
+        end = end + MPD_RESULTS_MAX;
+    } while (i >= start &&
+             i <= ALBUM_CACHE_UPDATE_MAX_SONGS);
+    FREE_SDS(expression);
+    FREE_SDS(key);
+    if (rc == false) {
+        raxFree(affected);
+        MYMPD_LOG_ERROR("default", "Cache update failed");
+        return ALBUM_CACHE_UPDATE_ERROR;
+    }
+    if (i > ALBUM_CACHE_UPDATE_MAX_SONGS) {
+        raxFree(affected);
+        MYMPD_LOG_INFO("default", "Too many changed songs for an incremental update");
+        return ALBUM_CACHE_UPDATE_FALLBACK;
+    }
+
+    // mark and sweep the song index to find the removed songs,
+    // the song count can not be used because songs could be added and removed
+    unsigned unknown = 0;
+    if (album_cache_mark_uris(mympd_worker_state, album_songs, &unknown) == false) {
+        raxFree(affected);
+        MYMPD_LOG_ERROR("default", "Cache update failed");
+        return ALBUM_CACHE_UPDATE_ERROR;
+    }
+    if (unknown > 0) {
+        // added songs with an older modification time than the last database update
+        raxFree(affected);
+        MYMPD_LOG_INFO("default", "Found %u added songs not reported as modified", unknown);
+        return ALBUM_CACHE_UPDATE_FALLBACK;
+    }
+    unsigned removed_count = album_songs_sweep(album_songs, affected);
+    if (i + removed_count > ALBUM_CACHE_UPDATE_MAX_SONGS) {
+        raxFree(affected);
+        MYMPD_LOG_INFO("default", "Too many removed songs for an incremental update");
+        return ALBUM_CACHE_UPDATE_FALLBACK;
+    }
+
+    album_songs_patch_albums(album_songs, affected, album_cache->cache,
+        &mympd_worker_state->mpd_state->tags_album, mympd_worker_state->tag_disc_empty_is_first);
+    raxIterator iter;
+    raxStart(&iter, affected);
+    raxSeek(&iter, "^", NULL, 0);
+    while (raxNext(&iter)) {
+        void *data;
+        if (raxFind(album_cache->cache, iter.key, iter.key_len, &data) == 1) {
+            album_cache_fix_tags(mympd_worker_state, (struct t_album *)data);
+        }
+    }
+    raxStop(&iter);
+    album_songs->db_mtime = db_mtime;
+    album_songs->db_songs = db_songs;
+    #ifdef MYMPD_DEBUG
+        MEASURE_END
+        MEASURE_PRINT("default", "Update album cache")
+    #endif
+    MYMPD_LOG_INFO("default", "Updated %" PRIu64 " albums for %u changed and %u removed songs",
+        affected->numele, i, removed_count);
+    raxFree(affected);
+    // the indexes are rebuilt by the caller
+    album_index_free(album_cache->index);
+    album_cache->index = NULL;
+    return ALBUM_CACHE_UPDATE_OK;
+}
+
 /**
  * Initializes the simple album cache.
  * This is faster as the cache_init function, but does not fetch all the album details.
@@ -376,3 +561,136 @@ static bool album_cache_create_simple(struct t_mympd_worker_state *mympd_worker_
     MYMPD_LOG_INFO("default", "Cache updated successfully");
     return true;
 }
+
+/**
+ * Adds the disc and group tag to the album tags and enables the album tags
+ * @param mympd_worker_state pointer to mympd_worker_state struct
+ */
+static void album_cache_set_tags(struct t_mympd_worker_state *mympd_worker_state) {
+    if (mympd_client_tag_exists(&mympd_worker_state->mpd_state->tags_mympd, MPD_TAG_DISC) == true) {
+        if (mympd_client_tag_exists(&mympd_worker_state->mpd_state->tags_album, MPD_TAG_DISC) == false) {
+            mympd_worker_state->mpd_state->tags_album.tags[mympd_worker_state->mpd_state->tags_album.len++] = MPD_TAG_DISC;
+        }
+    }
+    else {
+        MYMPD_LOG_WARN("default", "Disc tag is not enabled");
+    }
+    if (mympd_worker_state->config->albums.group_tag != MPD_TAG_UNKNOWN) {
+        if (mympd_client_tag_exists(&mympd_worker_state->mpd_state->tags_mympd, mympd_worker_state->config->albums.group_tag) == true) {
+            if (mympd_client_tag_exists(&mympd_worker_state->mpd_state->tags_album, mympd_worker_state->config->albums.group_tag) == false) {
+                mympd_worker_state->mpd_state->tags_album.tags[mympd_worker_state->mpd_state->tags_album.len++] = mympd_worker_state->config->albums.group_tag;
+            }
+        }
+        else {
+            MYMPD_LOG_WARN("default", "%s tag is not enabled", mpd_tag_name(mympd_worker_state->config->albums.group_tag));
+        }
+    }
+    enable_mpd_tags(mympd_worker_state->partition_state, &mympd_worker_state->mpd_state->tags_album);
+}
+
+/**
+ * Creates a new album from the first song of the album
+ * @param mympd_worker_state pointer to mympd_worker_state struct
+ * @param song mpd song
+ * @return newly allocated album
+ */
+static struct t_album *album_cache_new_album(struct t_mympd_worker_state *mympd_worker_state, const struct mpd_song *song) {
+    struct t_album *album = album_new_from_song(song, &mympd_worker_state->mpd_state->tags_album);
+    if (mympd_worker_state->tag_disc_empty_is_first == true) {
+        // handle empty disc tag as disc one
+        album_set_disc_count(album, 1);
+    }
+    album_cache_fix_tags(mympd_worker_state, album);
+    return album;
+}
+
+/**
+ * Applies the configured fallbacks for missing album tags
+ * @param mympd_worker_state pointer to mympd_worker_state struct
+ * @param album the album
+ */
+static void album_cache_fix_tags(struct t_mympd_worker_state *mympd_worker_state, struct t_album *album) {
+    if (mympd_worker_state->config->albums.unknown == true &&
+        album_get_unknown(album) == true)
+    {
+        MYMPD_LOG_DEBUG(NULL, "Using \"%s\" for Album for uri \"%s\", tag Album is empty", UNKNOWN_ALBUM, album_get_uri(album));
+        album_append_tag(album, MPD_TAG_ALBUM, UNKNOWN_ALBUM);
+    }
+    if (mympd_worker_state->partition_state->mpd_state->tag_albumartist == MPD_TAG_ALBUM_ARTIST &&
+        album_get_tag(album, MPD_TAG_ALBUM_ARTIST, 0) == NULL)
+    {
+        // Copy Artist tag to AlbumArtist tag
+        // for filters mpd falls back from AlbumArtist to Artist if AlbumArtist does not exist
+        album_copy_tags(album, MPD_TAG_ARTIST, MPD_TAG_ALBUM_ARTIST);
+    }
+}
+
+/**
+ * Checks if a song is part of an album like the search expression
+ * ((Album != '') AND (AlbumArtist != '')), mpd falls back from AlbumArtist to Artist
+ * @param song mpd song
+ * @param album_config album configuration
+ * @return true if the song is part of an album, else false
+ */
+static bool album_cache_song_has_album(const struct mpd_song *song, const struct t_albums_config *album_config) {
+    if (mpd_song_get_tag(song, MPD_TAG_ALBUM_ARTIST, 0) == NULL &&
+        mpd_song_get_tag(song, MPD_TAG_ARTIST, 0) == NULL)
+    {
+        return false;
+    }
+    return album_config->unknown == true ||
+        mpd_song_get_tag(song, MPD_TAG_ALBUM, 0) != NULL;
+}
+
+/**
+ * Fetches the uris of all songs in the mpd database without tags
+ * and marks them in the song index.
+ * @param mympd_worker_state pointer to mympd_worker_state struct
+ * @param album_songs pointer to song index
+ * @param unknown pointer to set the number of songs that are not indexed
+ * @return true on success, else false
+ */
+static bool album_cache_mark_uris(struct t_mympd_worker_state *mympd_worker_state, struct t_album_songs *album_songs,
+        unsigned *unknown)
+{
+    unsigned start = 0;
+    unsigned end = start + MPD_RESULTS_MAX;
+    unsigned i = 0;
+    *unknown = 0;
+    if (disable_all_mpd_tags(mympd_worker_state->partition_state) == false) {
+        return false;
+    }
+    bool rc = true;
+    do {
+        if (mpd_search_db_songs(mympd_worker_state->partition_state->conn, false) == false ||
+            mpd_search_add_expression(mympd_worker_state->partition_state->conn, "(modified-since '0')") == false ||
+            mympd_client_add_search_window(mympd_worker_state->partition_state->conn, start, end) == false)
+        {
+            mpd_search_cancel(mympd_worker_state->partition_state->conn);
+            rc = false;
+            break;
+        }
+        if (mpd_search_commit(mympd_worker_state->partition_state->conn)) {
+            struct mpd_song *song;
+            while ((song = mpd_recv_song(mympd_worker_state->partition_state->conn)) != NULL) {
+                const char *uri = mpd_song_get_uri(song);
+                if (album_songs_mark(album_songs, uri, strlen(uri)) == false) {
+                    (*unknown)++;
+                }
+                mpd_song_free(song);
+                i++;
+            }
+        }
+        if (mympd_check_error_and_recover(mympd_worker_state->partition_state, NULL, "mpd_search_commit") == false) {
+            rc = false;
+            break;
+        }
+        start = end;
+        end = end + MPD_RESULTS_MAX;
+    } while (i >= start);
+    // restore the album tags
+    if (enable_mpd_tags(mympd_worker_state->partition_state, &mympd_worker_state->mpd_state->tags_album) == false) {
+        rc = false;
+    }
+    return rc;
+}
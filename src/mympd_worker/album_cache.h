@@ -13,5 +13,5 @@
 
 #include "src/mympd_worker/state.h"
 
-bool mympd_worker_album_cache_create(struct t_mympd_worker_state *mympd_worker_state, bool force);
+bool mympd_worker_album_cache_create(struct t_mympd_worker_state *mympd_worker_state, bool force, bool incremental);
 #endif
@@ -51,6 +51,9 @@ void mympd_worker_api(struct t_mympd_worker_state *mympd_worker_state) {
     //some shortcuts
     struct t_partition_state *partition_state = mympd_worker_state->partition_state;
 
+    //tokenize the request once for all json_get_* calls
+    json_query_bind(request->data);
+
     switch(request->cmd_id) {
         case MYMPD_API_JUKEBOX_REFILL: {
             if (request->type != REQUEST_TYPE_DISCARD) {
@@ -129,9 +132,16 @@ void mympd_worker_api(struct t_mympd_worker_state *mympd_worker_state) {
             break;
         case MYMPD_API_CACHES_CREATE:
             if (json_get_bool(request->data, "$.params.force", &bool_buf1, &parse_error) == true) {
+                // optional parameter, defaults to a full rebuild
+                bool incremental = false;
+                if (json_find_key(request->data, "$.params.incremental") == true &&
+                    json_get_bool(request->data, "$.params.incremental", &incremental, &parse_error) == false)
+                {
+                    break;
+                }
                 response->data = jsonrpc_respond_ok(response->data, request->cmd_id, request->id, JSONRPC_FACILITY_DATABASE);
                 push_response(response);
-                mympd_worker_album_cache_create(mympd_worker_state, bool_buf1);
+                mympd_worker_album_cache_create(mympd_worker_state, bool_buf1, incremental);
                 async = true;
             }
             break;
@@ -423,6 +433,7 @@ void mympd_worker_api(struct t_mympd_worker_state *mympd_worker_state) {
                 JSONRPC_FACILITY_GENERAL, JSONRPC_SEVERITY_ERROR, "Unknown request");
             MYMPD_LOG_ERROR(MPD_PARTITION_DEFAULT, "Unknown API request: %.*s", (int)sdslen(request->data), request->data);
     }
+    json_query_unbind();
     FREE_SDS(sds_buf1);
     FREE_SDS(sds_buf2);
     FREE_SDS(sds_buf3);
@@ -12,31 +12,144 @@
 #include "src/mympd_worker/mympd_worker.h"
 
 #include "dist/sds/sds.h"
+#include "src/lib/cache/cache_disk_images.h"
 #include "src/lib/config/mympd_state.h"
+#include "src/lib/histogram.h"
+#include "src/lib/json/json_print.h"
+#include "src/lib/list/list.h"
 #include "src/lib/log.h"
 #include "src/lib/mem.h"
+#include "src/lib/metrics.h"
 #include "src/lib/msg_queue.h"
 #include "src/lib/sds/sds_extras.h"
+#include "src/lib/sds/sds_file.h"
 #include "src/lib/thread.h"
 #include "src/mympd_client/connection.h"
 #include "src/mympd_client/stickerdb.h"
+#include "src/mympd_client/tags.h"
 #include "src/mympd_worker/api.h"
 
+#include <inttypes.h>
 #include <pthread.h>
 #include <string.h>
+#include <time.h>
 
 /**
  * Private definitions
  */
 
-static void *mympd_worker_run(void *arg);
+/**
+ * Latency metrics for a worker job type
+ */
+struct t_mympd_worker_job_stats {
+    uint64_t count;        //!< number of finished jobs
+    uint64_t wait_us;      //!< summed up time in the job queue
+    uint64_t run_us;       //!< summed up run time
+    uint64_t run_us_max;   //!< maximum run time
+};
+
+/**
+ * A queued worker job
+ */
+struct t_mympd_worker_job {
+    struct t_mympd_worker_state *mympd_worker_state;  //!< the state for the job
+    struct timespec queued;                           //!< time the job was queued
+    bool heavy;                                       //!< job counts against MAX_MPD_WORKER_HEAVY_JOBS
+};
+
+/**
+ * The worker pool
+ */
+struct t_mympd_worker_pool {
+    pthread_mutex_t mutex;          //!< protects all other members
+    pthread_cond_t wakeup;          //!< signaled for new jobs and finished heavy jobs
+    pthread_t threads[MAX_MPD_WORKER_THREADS];  //!< the worker threads
+    unsigned thread_count;          //!< number of started threads
+    bool stop;                      //!< true if the pool should stop
+    struct t_list jobs;             //!< queued jobs
+    unsigned running;               //!< number of running jobs
+    unsigned running_heavy;         //!< number of running heavy jobs
+    struct t_list thumbnails;       //!< queued thumbnail jobs, key is the cached image
+    bool thumbnail_running;         //!< true if a thumbnail job is running
+    struct t_config *config;        //!< pointer to static config
+    struct t_mympd_worker_job_stats stats[TOTAL_API_COUNT];  //!< latency metrics by method
+};
+
+static struct t_mympd_worker_pool pool;  //!< The worker pool
+
+static void *mympd_worker_pool_thread(void *arg);
+static struct t_mympd_worker_job *get_runnable_job(void);
+#ifdef MYMPD_ENABLE_THUMBNAILS
+    static bool run_thumbnail_job(void);
+#endif
+static void job_done(const struct t_mympd_worker_job *job, enum mympd_cmd_ids cmd_id, const struct timespec *started);
+static bool is_heavy_job(enum mympd_cmd_ids cmd_id);
+static void mympd_worker_run(struct t_mympd_worker_state *mympd_worker_state, struct t_list *conns);
+static bool mympd_worker_connect(struct t_partition_state *partition_state);
+static sds get_conn_key(sds key, const char *name, const struct t_mpd_state *mpd_state);
+static bool conn_checkout(struct t_list *conns, struct t_mympd_worker_state *mympd_worker_state);
+static void conn_checkin(struct t_list *conns, struct t_mympd_worker_state *mympd_worker_state);
+static void conn_store(struct t_list *conns, sds key, struct mpd_connection *conn);
+static void free_conn(struct t_list_node *current);
 
 /**
  * Public functions
  */
 
 /**
- * Starts the worker thread in detached state.
+ * Starts the threads of the worker pool.
+ * This is called from the mympd_api thread.
+ * @param config pointer to static config
+ * @return true on success, else false
+ */
+bool mympd_worker_pool_start(struct t_config *config) {
+    pool.mutex = (pthread_mutex_t)PTHREAD_MUTEX_INITIALIZER;
+    pool.wakeup = (pthread_cond_t)PTHREAD_COND_INITIALIZER;
+    pool.thread_count = 0;
+    pool.stop = false;
+    pool.running = 0;
+    pool.running_heavy = 0;
+    list_init(&pool.jobs);
+    list_init(&pool.thumbnails);
+    pool.thumbnail_running = false;
+    pool.config = config;
+    memset(pool.stats, 0, sizeof(pool.stats));
+    for (unsigned i = 0; i < MAX_MPD_WORKER_THREADS; i++) {
+        if (pthread_create(&pool.threads[i], NULL, mympd_worker_pool_thread, NULL) != 0) {
+            MYMPD_LOG_ERROR(NULL, "Can not create mympd_worker thread");
+            break;
+        }
+        pool.thread_count++;
+    }
+    MYMPD_LOG_INFO(NULL, "Started %u mympd_worker threads", pool.thread_count);
+    return pool.thread_count > 0;
+}
+
+/**
+ * Stops the worker pool, waits for running jobs and discards queued jobs.
+ * This is called from the mympd_api thread.
+ */
+void mympd_worker_pool_stop(void) {
+    pthread_mutex_lock(&pool.mutex);
+    pool.stop = true;
+    pthread_cond_broadcast(&pool.wakeup);
+    pthread_mutex_unlock(&pool.mutex);
+    for (unsigned i = 0; i < pool.thread_count; i++) {
+        pthread_join(pool.threads[i], NULL);
+    }
+    pool.thread_count = 0;
+    struct t_list_node *current;
+    while ((current = list_shift_first(&pool.jobs)) != NULL) {
+        struct t_mympd_worker_job *job = current->user_data;
+        mympd_worker_state_free(job->mympd_worker_state);
+        FREE_PTR(job);
+        list_node_free(current);
+    }
+    list_clear(&pool.thumbnails);
+}
+
+/**
+ * Queues a job for the worker pool.
  * @param mympd_state pointer to mympd_state struct
  * @param partition_state pointer to partition_state struct
  * @param request the work request
@@ -45,15 +158,9 @@ static void *mympd_worker_run(void *arg);
 bool mympd_worker_start(struct t_mympd_state *mympd_state, struct t_partition_state *partition_state,
         struct t_work_request *request)
 {
-    MYMPD_LOG_NOTICE(NULL, "Starting mympd_worker thread for %s", get_cmd_id_method_name(request->cmd_id));
-    pthread_t mympd_worker_thread;
-    pthread_attr_t attr;
-    if (pthread_attr_init(&attr) != 0) {
-        MYMPD_LOG_ERROR(NULL, "Can not init mympd_worker thread attribute");
-        return false;
-    }
-    if (pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED) != 0) {
-        MYMPD_LOG_ERROR(NULL, "Can not set mympd_worker thread to detached");
+    MYMPD_LOG_NOTICE(NULL, "Queuing mympd_worker job for %s", get_cmd_id_method_name(request->cmd_id));
+    if (pool.thread_count == 0) {
+        MYMPD_LOG_ERROR(NULL, "The mympd_worker pool is not running");
         return false;
     }
     //create mpd worker state from mympd_state
@@ -101,48 +208,275 @@ bool mympd_worker_start(struct t_mympd_state *mympd_state, struct t_partition_st
         mympd_mpd_state_copy(mympd_state->stickerdb->mpd_state, mympd_worker_state->stickerdb->mpd_state);
     }
 
-    //create the worker thread
-    if (pthread_create(&mympd_worker_thread, &attr, mympd_worker_run, mympd_worker_state) != 0) {
-        MYMPD_LOG_ERROR(NULL, "Can not create mympd_worker thread");
-        mympd_worker_state_free(mympd_worker_state);
-        return false;
-    }
+    struct t_mympd_worker_job *job = malloc_assert(sizeof(struct t_mympd_worker_job));
+    job->mympd_worker_state = mympd_worker_state;
+    job->heavy = is_heavy_job(request->cmd_id);
+    (void)clock_gettime(CLOCK_MONOTONIC, &job->queued);
+
+    pthread_mutex_lock(&pool.mutex);
+    list_push(&pool.jobs, "", 0, NULL, job);
+    pthread_cond_signal(&pool.wakeup);
+    pthread_mutex_unlock(&pool.mutex);
     return true;
 }
 
+#ifdef MYMPD_ENABLE_THUMBNAILS
+/**
+ * Queues the creation of the thumbnail variants of a cached cover.
+ * Thumbnail jobs have their own bounded queue and run only if no other job is runnable.
+ * This function can be called from any thread.
+ * @param uri uri of the song for the cover
+ * @param offset number of the coverimage
+ * @param image_path path of the cover in the covercache
+ * @return true if the job is queued, false if the queue is full
+ */
+bool mympd_worker_pool_queue_thumbnails(const char *uri, int offset, const char *image_path) {
+    bool rc = true;
+    pthread_mutex_lock(&pool.mutex);
+    if (pool.thread_count == 0 ||
+        pool.stop == true)
+    {
+        rc = false;
+    }
+    else if (list_get_node(&pool.thumbnails, image_path) != NULL) {
+        MYMPD_LOG_DEBUG(NULL, "Thumbnails for \"%s\" are already queued", image_path);
+    }
+    else if (pool.thumbnails.length >= MAX_MPD_WORKER_THUMBNAIL_JOBS) {
+        rc = false;
+    }
+    else {
+        list_push(&pool.thumbnails, image_path, offset, uri, NULL);
+        pthread_cond_signal(&pool.wakeup);
+    }
+    pthread_mutex_unlock(&pool.mutex);
+    return rc;
+}
+#endif
+
+/**
+ * Checks if the worker pool can take another job
+ * @return true if the job limit is not reached, else false
+ */
+bool mympd_worker_pool_accepts_jobs(void) {
+    pthread_mutex_lock(&pool.mutex);
+    bool rc = pool.jobs.length + pool.running < MAX_MPD_WORKER_JOBS;
+    pthread_mutex_unlock(&pool.mutex);
+    return rc;
+}
+
+/**
+ * Prints the worker pool metrics as json object
+ * @param buffer already allocated sds string to append
+ * @return pointer to buffer
+ */
+sds mympd_worker_pool_stats(sds buffer) {
+    pthread_mutex_lock(&pool.mutex);
+    buffer = sdscatlen(buffer, "{", 1);
+    buffer = tojson_uint(buffer, "threads", pool.thread_count, true);
+    buffer = tojson_uint(buffer, "queued", pool.jobs.length, true);
+    buffer = tojson_uint(buffer, "running", pool.running, true);
+    buffer = tojson_uint(buffer, "runningHeavy", pool.running_heavy, true);
+    buffer = tojson_uint(buffer, "queuedThumbnails", pool.thumbnails.length, true);
+    buffer = sdscat(buffer, "\"jobs\":{");
+    bool first = true;
+    for (unsigned i = 0; i < TOTAL_API_COUNT; i++) {
+        const struct t_mympd_worker_job_stats *stats = &pool.stats[i];
+        if (stats->count == 0) {
+            continue;
+        }
+        if (first == false) {
+            buffer = sdscatlen(buffer, ",", 1);
+        }
+        first = false;
+        buffer = sdscatfmt(buffer, "\"%s\":{", get_cmd_id_method_name((enum mympd_cmd_ids)i));
+        buffer = tojson_uint64(buffer, "count", stats->count, true);
+        buffer = tojson_uint64(buffer, "waitMsAvg", stats->wait_us / stats->count / 1000, true);
+        buffer = tojson_uint64(buffer, "runMsAvg", stats->run_us / stats->count / 1000, true);
+        buffer = tojson_uint64(buffer, "runMsMax", stats->run_us_max / 1000, false);
+        buffer = sdscatlen(buffer, "}", 1);
+    }
+    buffer = sdscatlen(buffer, "}}", 2);
+    pthread_mutex_unlock(&pool.mutex);
+    return buffer;
+}
+
 /**
  * Private functions
  */
 
 /**
- * This is the main function of the worker thread.
- * @param arg void pointer to the mympd_worker_state
+ * This is the main function of the worker pool threads.
+ * The threads keep their mpd connections open between jobs.
+ * @param arg unused
  * @return NULL
  */
-static void *mympd_worker_run(void *arg) {
-    mympd_worker_threads++;
-    thread_logname = sdscatprintf(sdsempty(), "worker%02d", mympd_worker_threads);
+static void *mympd_worker_pool_thread(void *arg) {
+    (void)arg;
+    int thread_number = ++mympd_worker_threads;
+    thread_logname = sdscatprintf(sdsempty(), "worker%02d", thread_number);
     set_threadname(thread_logname);
     thread_logline = sdsempty();
+    struct t_list conns;
+    list_init(&conns);
+
+    pthread_mutex_lock(&pool.mutex);
+    while (pool.stop == false) {
+        struct t_mympd_worker_job *job = get_runnable_job();
+        if (job == NULL) {
+            #ifdef MYMPD_ENABLE_THUMBNAILS
+                if (run_thumbnail_job() == true) {
+                    continue;
+                }
+            #endif
+            pthread_cond_wait(&pool.wakeup, &pool.mutex);
+            continue;
+        }
+        pool.running++;
+        if (job->heavy == true) {
+            pool.running_heavy++;
+        }
+        pthread_mutex_unlock(&pool.mutex);
+
+        struct timespec started;
+        (void)clock_gettime(CLOCK_MONOTONIC, &started);
+        enum mympd_cmd_ids cmd_id = job->mympd_worker_state->request->cmd_id;
+        struct t_metrics_request request_metrics;
+        metrics_request_begin(&request_metrics, &job->mympd_worker_state->request->queued);
+        MYMPD_LOG_NOTICE(NULL, "Running mympd_worker job for %s", get_cmd_id_method_name(cmd_id));
+        mympd_worker_run(job->mympd_worker_state, &conns);
+        metrics_request_end(&request_metrics, cmd_id);
+
+        pthread_mutex_lock(&pool.mutex);
+        job_done(job, cmd_id, &started);
+        FREE_PTR(job);
+    }
+    pthread_mutex_unlock(&pool.mutex);
+
+    list_clear_user_data(&conns, free_conn);
+    mympd_worker_threads--;
+    FREE_SDS(thread_logname);
+    FREE_SDS(thread_logline);
+    return NULL;
+}
+
+/**
+ * Gets the first queued job that is allowed to run.
+ * Heavy jobs are skipped if MAX_MPD_WORKER_HEAVY_JOBS are already running.
+ * Caller must hold the pool mutex.
+ * @return the job or NULL if no job is runnable
+ */
+static struct t_mympd_worker_job *get_runnable_job(void) {
+    struct t_list_node *current = pool.jobs.head;
+    while (current != NULL) {
+        struct t_mympd_worker_job *job = current->user_data;
+        if (job->heavy == false ||
+            pool.running_heavy < MAX_MPD_WORKER_HEAVY_JOBS)
+        {
+            list_node_free(list_node_extract(&pool.jobs, current));
+            return job;
+        }
+        current = current->next;
+    }
+    return NULL;
+}
+
+#ifdef MYMPD_ENABLE_THUMBNAILS
+/**
+ * Runs the first queued thumbnail job, only one thumbnail job runs at a time.
+ * Caller must hold the pool mutex, it is released while the job runs.
+ * @return true if a job was run, else false
+ */
+static bool run_thumbnail_job(void) {
+    if (pool.thumbnail_running == true) {
+        return false;
+    }
+    struct t_list_node *current = list_shift_first(&pool.thumbnails);
+    if (current == NULL) {
+        return false;
+    }
+    pool.thumbnail_running = true;
+    pthread_mutex_unlock(&pool.mutex);
+
+    int nread;
+    sds binary = sds_getfile(sdsempty(), current->key, MPD_BINARY_SIZE_MAX, false, true, &nread);
+    if (nread > 0) {
+        cache_disk_images_write_thumbnails(pool.config->cachedir, current->value_p, binary, (int)current->value_i);
+    }
+    FREE_SDS(binary);
+    list_node_free(current);
+
+    pthread_mutex_lock(&pool.mutex);
+    pool.thumbnail_running = false;
+    return true;
+}
+#endif
+
+/**
+ * Updates the counters and the latency metrics after a job has finished.
+ * Caller must hold the pool mutex.
+ * @param job the finished job
+ * @param cmd_id method of the job
+ * @param started time the job was started
+ */
+static void job_done(const struct t_mympd_worker_job *job, enum mympd_cmd_ids cmd_id, const struct timespec *started) {
+    struct timespec finished;
+    (void)clock_gettime(CLOCK_MONOTONIC, &finished);
+    pool.running--;
+    if (job->heavy == true) {
+        pool.running_heavy--;
+        // queued heavy jobs can run now
+        pthread_cond_broadcast(&pool.wakeup);
+    }
+    struct t_mympd_worker_job_stats *stats = &pool.stats[cmd_id];
+    uint64_t run_us = histogram_elapsed_us(started, &finished);
+    stats->count++;
+    stats->wait_us += histogram_elapsed_us(&job->queued, started);
+    stats->run_us += run_us;
+    if (run_us > stats->run_us_max) {
+        stats->run_us_max = run_us;
+    }
+    MYMPD_LOG_DEBUG(NULL, "Execution time for %s: %" PRIu64 " ms", get_cmd_id_method_name(cmd_id), run_us / 1000);
+}
+
+/**
+ * Jobs that iterate the whole database or all playlists
+ * @param cmd_id method of the job
+ * @return true if this is a heavy job, else false
+ */
+static bool is_heavy_job(enum mympd_cmd_ids cmd_id) {
+    switch(cmd_id) {
+        case MYMPD_API_CACHE_DISK_CROP:
+        case MYMPD_API_CACHE_DISK_CLEAR:
+        case MYMPD_API_CACHES_CREATE:
+        case MYMPD_API_PLAYLIST_CONTENT_DEDUP_ALL:
+        case MYMPD_API_PLAYLIST_CONTENT_VALIDATE_ALL:
+        case MYMPD_API_PLAYLIST_CONTENT_VALIDATE_DEDUP_ALL:
+        case MYMPD_API_SMARTPLS_UPDATE_ALL:
+        case MYMPD_API_WEBRADIODB_UPDATE:
+            return true;
+        default:
+            return false;
+    }
+}
 
-    struct t_mympd_worker_state *mympd_worker_state = (struct t_mympd_worker_state *) arg;
+/**
+ * Runs a job and frees the worker state.
+ * @param mympd_worker_state the worker state
+ * @param conns pooled mpd connections of this worker thread
+ */
+static void mympd_worker_run(struct t_mympd_worker_state *mympd_worker_state, struct t_list *conns) {
     if (mympd_worker_state->mympd_only == true) {
         //call api handler
         mympd_worker_api(mympd_worker_state);
     }
-    else if (mympd_client_connect(mympd_worker_state->partition_state) == true) {
-        bool rc = true;
-        if (strcmp(mympd_worker_state->partition_state->name, MPD_PARTITION_DEFAULT) != 0) {
-            if (mpd_run_switch_partition(mympd_worker_state->partition_state->conn, mympd_worker_state->partition_state->name) == false) {
-                MYMPD_LOG_ERROR(MPD_PARTITION_DEFAULT, "Could not switch to partition \"%s\"", mympd_worker_state->partition_state->name);
-                rc = false;
-            }
-        }
-        if (rc == true) {
-            //call api handler
-            mympd_worker_api(mympd_worker_state);
-        }
-        //disconnect
+    else if (conn_checkout(conns, mympd_worker_state) == true ||
+        mympd_worker_connect(mympd_worker_state->partition_state) == true)
+    {
+        //call api handler
+        mympd_worker_api(mympd_worker_state);
+        //return the connections to the pool
+        conn_checkin(conns, mympd_worker_state);
+        //disconnect connections that could not be returned
         mympd_client_disconnect_silent(mympd_worker_state->partition_state);
         if (mympd_worker_state->stickerdb->conn != NULL) {
             stickerdb_disconnect(mympd_worker_state->stickerdb);
@@ -162,10 +496,137 @@ static void *mympd_worker_run(void *arg) {
                 break;
         }
     }
-    MYMPD_LOG_NOTICE(NULL, "Stopping mympd_worker thread");
     mympd_worker_state_free(mympd_worker_state);
-    mympd_worker_threads--;
-    FREE_SDS(thread_logname);
-    FREE_SDS(thread_logline);
-    return NULL;
+}
+
+/**
+ * Creates a new mpd connection and switches to the partition
+ * @param partition_state pointer to the partition state of the worker
+ * @return true on success, else false
+ */
+static bool mympd_worker_connect(struct t_partition_state *partition_state) {
+    if (mympd_client_connect(partition_state) == false) {
+        return false;
+    }
+    if (strcmp(partition_state->name, MPD_PARTITION_DEFAULT) != 0 &&
+        mpd_run_switch_partition(partition_state->conn, partition_state->name) == false)
+    {
+        MYMPD_LOG_ERROR(MPD_PARTITION_DEFAULT, "Could not switch to partition \"%s\"", partition_state->name);
+        mympd_client_disconnect_silent(partition_state);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Creates the key for a pooled connection.
+ * Connections are only reused if the connection settings are unchanged.
+ * @param key already allocated sds string to append
+ * @param name partition name or stickerdb
+ * @param mpd_state mpd state with the connection settings
+ * @return pointer to key
+ */
+static sds get_conn_key(sds key, const char *name, const struct t_mpd_state *mpd_state) {
+    return sdscatfmt(key, "%s\n%S\n%u\n%S\n%u\n%u\n%u\n%s", name, mpd_state->mpd_host, mpd_state->mpd_port,
+        mpd_state->mpd_pass, mpd_state->mpd_timeout, mpd_state->mpd_binarylimit,
+        (unsigned)mpd_state->mpd_keepalive, (mpd_state->mpd_stringnormalization == true ? "1" : "0"));
+}
+
+/**
+ * Takes the pooled connections for the partition and the stickerdb.
+ * The partition connection is checked by leaving the idle mode and
+ * resetting the enabled tags, the stickerdb connection is checked by stickerdb_connect on first use.
+ * @param conns pooled mpd connections of this worker thread
+ * @param mympd_worker_state the worker state
+ * @return true if a working connection for the partition was found, else false
+ */
+static bool conn_checkout(struct t_list *conns, struct t_mympd_worker_state *mympd_worker_state) {
+    struct t_partition_state *partition_state = mympd_worker_state->partition_state;
+    struct t_stickerdb_state *stickerdb = mympd_worker_state->stickerdb;
+    sds key = get_conn_key(sdsempty(), "stickerdb", stickerdb->mpd_state);
+    struct t_list_node *node = list_get_node(conns, key);
+    if (node != NULL) {
+        stickerdb->conn = node->user_data;
+        stickerdb->conn_state = MPD_CONNECTED;
+        list_node_free(list_node_extract(conns, node));
+    }
+    sdsclear(key);
+    key = get_conn_key(key, partition_state->name, partition_state->mpd_state);
+    node = list_get_node(conns, key);
+    FREE_SDS(key);
+    if (node == NULL) {
+        return false;
+    }
+    struct mpd_connection *conn = node->user_data;
+    list_node_free(list_node_extract(conns, node));
+    mpd_run_noidle(conn);
+    if (mpd_connection_get_error(conn) != MPD_ERROR_SUCCESS) {
+        MYMPD_LOG_INFO(partition_state->name, "Pooled mpd connection is broken: %s", mpd_connection_get_error_message(conn));
+        mpd_connection_free(conn);
+        return false;
+    }
+    partition_state->conn = conn;
+    partition_state->conn_state = MPD_CONNECTED;
+    // jobs can change the enabled tags
+    if (enable_mpd_tags(partition_state, &partition_state->mpd_state->tags_mympd) == false) {
+        mympd_client_disconnect_silent(partition_state);
+        return false;
+    }
+    MYMPD_LOG_DEBUG(partition_state->name, "Reusing pooled mpd connection");
+    return true;
+}
+
+/**
+ * Returns working connections to the pool.
+ * The partition connection enters the idle mode to not run into the mpd connection timeout,
+ * the stickerdb connection is already in idle mode.
+ * @param conns pooled mpd connections of this worker thread
+ * @param mympd_worker_state the worker state
+ */
+static void conn_checkin(struct t_list *conns, struct t_mympd_worker_state *mympd_worker_state) {
+    struct t_partition_state *partition_state = mympd_worker_state->partition_state;
+    struct t_stickerdb_state *stickerdb = mympd_worker_state->stickerdb;
+    if (partition_state->conn != NULL &&
+        partition_state->conn_state == MPD_CONNECTED &&
+        mpd_connection_get_error(partition_state->conn) == MPD_ERROR_SUCCESS &&
+        mpd_send_idle(partition_state->conn) == true)
+    {
+        conn_store(conns, get_conn_key(sdsempty(), partition_state->name, partition_state->mpd_state), partition_state->conn);
+        partition_state->conn = NULL;
+        partition_state->conn_state = MPD_DISCONNECTED;
+    }
+    if (stickerdb->conn != NULL &&
+        stickerdb->conn_state == MPD_CONNECTED &&
+        mpd_connection_get_error(stickerdb->conn) == MPD_ERROR_SUCCESS)
+    {
+        conn_store(conns, get_conn_key(sdsempty(), "stickerdb", stickerdb->mpd_state), stickerdb->conn);
+        stickerdb->conn = NULL;
+        stickerdb->conn_state = MPD_DISCONNECTED;
+    }
+}
+
+/**
+ * Adds a connection to the pool, the least recently used connection
+ * is closed if the pool is full.
+ * @param conns pooled mpd connections of this worker thread
+ * @param key connection key, takes ownership
+ * @param conn the mpd connection
+ */
+static void conn_store(struct t_list *conns, sds key, struct mpd_connection *conn) {
+    if (conns->length == MAX_MPD_WORKER_CONNS) {
+        struct t_list_node *node = list_shift_first(conns);
+        free_conn(node);
+        list_node_free(node);
+    }
+    list_push(conns, key, 0, NULL, conn);
+    FREE_SDS(key);
+}
+
+/**
+ * Callback for list_clear_user_data to close a pooled connection
+ * @param current list node
+ */
+static void free_conn(struct t_list_node *current) {
+    mpd_connection_free((struct mpd_connection *)current->user_data);
+    current->user_data = NULL;
 }
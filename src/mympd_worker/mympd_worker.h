@@ -14,6 +14,13 @@
 #include "src/lib/api.h"
 #include "src/lib/config/mympd_state.h"
 
+bool mympd_worker_pool_start(struct t_config *config);
+void mympd_worker_pool_stop(void);
+bool mympd_worker_pool_accepts_jobs(void);
+#ifdef MYMPD_ENABLE_THUMBNAILS
+    bool mympd_worker_pool_queue_thumbnails(const char *uri, int offset, const char *image_path);
+#endif
+sds mympd_worker_pool_stats(sds buffer);
 bool mympd_worker_start(struct t_mympd_state *mympd_state, struct t_partition_state *partition_state,
         struct t_work_request *request);
 
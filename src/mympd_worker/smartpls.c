@@ -16,6 +16,7 @@
 #include "src/lib/filehandler.h"
 #include "src/lib/json/json_query.h"
 #include "src/lib/log.h"
+#include "src/lib/playlist_catalogue.h"
 #include "src/lib/sds/sds_extras.h"
 #include "src/lib/sds/sds_file.h"
 #include "src/lib/smartpls.h"
@@ -225,6 +226,9 @@ bool mympd_worker_smartpls_update(struct t_mympd_worker_state *mympd_worker_stat
         }
     }
 
+    // the playlist was recreated
+    playlist_catalogue_clear(&mympd_worker_state->partition_state->mpd_state->playlist_catalogue);
+
     // sort or shuffle
     if (rc == true &&
         sdslen(sort) > 0)
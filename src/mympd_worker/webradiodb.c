@@ -73,6 +73,8 @@ bool mympd_worker_webradiodb_update(struct t_mympd_worker_state *mympd_worker_st
     }
 
     webradios_save_to_disk(mympd_worker_state->config, webradiodb, FILENAME_WEBRADIODB);
+    // normalize the tag values once for searching
+    webradios_normalize(webradiodb);
     struct t_work_request *request = create_request(REQUEST_TYPE_DISCARD, 0, 0, INTERNAL_API_WEBRADIODB_CREATED, "", "default");
     request->extra = (void *) webradiodb;
     request->extra_free = webradios_free_void;
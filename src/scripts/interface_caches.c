@@ -11,6 +11,7 @@
 #include "src/scripts/interface_caches.h"
 
 #include "src/lib/cache/cache_disk_images.h"
+#include "src/lib/cache/cache_disk_index.h"
 #include "src/lib/cache/cache_disk_lyrics.h"
 #include "src/lib/config/config_def.h"
 #include "src/lib/filehandler.h"
@@ -63,6 +64,7 @@ int lua_caches_update_mtime(lua_State *lua_vm) {
 
     lua_pop(lua_vm, n);
     if (update_mtime(filename) == true) {
+        cache_disk_index_touch(filename);
         lua_pushnumber(lua_vm, 0);
     }
     else {
@@ -127,6 +129,7 @@ int lua_caches_images_write(lua_State *lua_vm) {
         lua_pushstring(lua_vm, "Failure renaming file");
         return 2;
     }
+    cache_disk_index_add(dst);
     lua_pushnumber(lua_vm, 0);
     lua_pushstring(lua_vm, dst);
     FREE_SDS(dst);
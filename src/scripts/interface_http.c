@@ -12,6 +12,7 @@
 #include "src/scripts/interface_http.h"
 
 #include "src/lib/cache/cache_disk.h"
+#include "src/lib/cache/cache_disk_index.h"
 #include "src/lib/config/config_def.h"
 #include "src/lib/filehandler.h"
 #include "src/lib/http_client/http_client.h"
@@ -169,9 +170,11 @@ int lua_http_download(lua_State *lua_vm) {
         http_client_request(&mg_client_request, mg_client_response);
         rc = 1;
         if (mg_client_response->rc == 0) {
-            if (out[0] == '\0' ||
-                write_data_to_file(out, mg_client_response->body, sdslen(mg_client_response->body)) == true)
-            {
+            if (out[0] == '\0') {
+                rc = 0;
+            }
+            else if (write_data_to_file(out, mg_client_response->body, sdslen(mg_client_response->body)) == true) {
+                cache_disk_index_add(out);
                 rc = 0;
             }
             if (out[0] == '\0' ||
@@ -13,6 +13,7 @@
 
 #include "src/lib/api.h"
 #include "src/lib/cache/cache_disk.h"
+#include "src/lib/cache/cache_disk_images.h"
 #include "src/lib/convert.h"
 #include "src/lib/filehandler.h"
 #include "src/lib/json/json_print.h"
@@ -40,10 +41,19 @@
     #include "src/webserver/albumart_flac.h"
 #endif
 
+#ifdef MYMPD_ENABLE_THUMBNAILS
+    #include "src/mympd_worker/mympd_worker.h"
+#endif
+
 /**
  * Privat definitions
  */
-static bool handle_coverextract(struct mg_connection *nc, sds cachedir, const char *uri, const char *media_file, bool covercache, int offset);
+static bool handle_coverextract(struct mg_connection *nc, struct t_mg_user_data *mg_user_data,
+        const char *uri, const char *media_file, bool covercache, int offset);
+#ifdef MYMPD_ENABLE_THUMBNAILS
+static bool check_thumbnail(struct mg_connection *nc, struct mg_http_message *hm,
+        struct t_mg_user_data *mg_user_data, const char *uri, int offset, enum albumart_sizes size);
+#endif
 
 /**
  * Public functions
@@ -162,6 +172,14 @@ bool request_handler_albumart_by_uri(struct mg_connection *nc, struct mg_http_me
 
     MYMPD_LOG_DEBUG(NULL, "Handle albumart for uri \"%s\", offset %d", uri, offset);
 
+    #ifdef MYMPD_ENABLE_THUMBNAILS
+        //check thumbs cache and serve the thumbnail variant if found
+        if (check_thumbnail(nc, hm, mg_user_data, uri, offset, size) == true) {
+            FREE_SDS(uri);
+            return true;
+        }
+    #endif
+
     //check covercache and serve image from it if found
     if (check_imagescache(nc, hm, mg_user_data, DIR_CACHE_COVER, uri, offset) == true) {
         FREE_SDS(uri);
@@ -225,19 +243,19 @@ bool request_handler_albumart_by_uri(struct mg_connection *nc, struct mg_http_me
             sds coverfile = sdsempty();
             switch(size) {
                 case ALBUMART_SM:
-                    found = find_image_in_folder(&coverfile, mg_user_data->music_directory, path, mg_user_data->image_names_sm, mg_user_data->image_names_sm_len) ||
-                        find_image_in_folder(&coverfile, mg_user_data->music_directory, path, mg_user_data->image_names_md, mg_user_data->image_names_md_len) ||
-                        find_image_in_folder(&coverfile, mg_user_data->music_directory, path, mg_user_data->image_names_lg, mg_user_data->image_names_lg_len);
+                    found = find_image_in_folder(&coverfile, mg_user_data->image_index, mg_user_data->music_directory, path, mg_user_data->image_names_sm, mg_user_data->image_names_sm_len) ||
+                        find_image_in_folder(&coverfile, mg_user_data->image_index, mg_user_data->music_directory, path, mg_user_data->image_names_md, mg_user_data->image_names_md_len) ||
+                        find_image_in_folder(&coverfile, mg_user_data->image_index, mg_user_data->music_directory, path, mg_user_data->image_names_lg, mg_user_data->image_names_lg_len);
                     break;
                 case ALBUMART_MD:
-                    found = find_image_in_folder(&coverfile, mg_user_data->music_directory, path, mg_user_data->image_names_md, mg_user_data->image_names_md_len) ||
-                        find_image_in_folder(&coverfile, mg_user_data->music_directory, path, mg_user_data->image_names_lg, mg_user_data->image_names_lg_len) ||
-                        find_image_in_folder(&coverfile, mg_user_data->music_directory, path, mg_user_data->image_names_sm, mg_user_data->image_names_sm_len);
+                    found = find_image_in_folder(&coverfile, mg_user_data->image_index, mg_user_data->music_directory, path, mg_user_data->image_names_md, mg_user_data->image_names_md_len) ||
+                        find_image_in_folder(&coverfile, mg_user_data->image_index, mg_user_data->music_directory, path, mg_user_data->image_names_lg, mg_user_data->image_names_lg_len) ||
+                        find_image_in_folder(&coverfile, mg_user_data->image_index, mg_user_data->music_directory, path, mg_user_data->image_names_sm, mg_user_data->image_names_sm_len);
                     break;
                 case ALBUMART_LG:
-                    found = find_image_in_folder(&coverfile, mg_user_data->music_directory, path, mg_user_data->image_names_lg, mg_user_data->image_names_lg_len) ||
-                        find_image_in_folder(&coverfile, mg_user_data->music_directory, path, mg_user_data->image_names_md, mg_user_data->image_names_md_len) ||
-                        find_image_in_folder(&coverfile, mg_user_data->music_directory, path, mg_user_data->image_names_sm, mg_user_data->image_names_sm_len);
+                    found = find_image_in_folder(&coverfile, mg_user_data->image_index, mg_user_data->music_directory, path, mg_user_data->image_names_lg, mg_user_data->image_names_lg_len) ||
+                        find_image_in_folder(&coverfile, mg_user_data->image_index, mg_user_data->music_directory, path, mg_user_data->image_names_md, mg_user_data->image_names_md_len) ||
+                        find_image_in_folder(&coverfile, mg_user_data->image_index, mg_user_data->music_directory, path, mg_user_data->image_names_sm, mg_user_data->image_names_sm_len);
                     break;
             }
             if (found == true) {
@@ -259,7 +277,7 @@ bool request_handler_albumart_by_uri(struct mg_connection *nc, struct mg_http_me
             bool covercache = mg_user_data->config->cache_cover_keep_days != CACHE_DISK_DISABLED
                 ? true
                 : false;
-            bool rc = handle_coverextract(nc, config->cachedir, uri, mediafile, covercache, offset);
+            bool rc = handle_coverextract(nc, mg_user_data, uri, mediafile, covercache, offset);
             if (rc == true) {
                 FREE_SDS(uri);
                 FREE_SDS(mediafile);
@@ -289,19 +307,19 @@ bool request_handler_albumart_by_uri(struct mg_connection *nc, struct mg_http_me
 /**
  * Extracts albumart from media files
  * @param nc mongoose connection
- * @param cachedir covercache directory
+ * @param mg_user_data pointer to mongoose configuration
  * @param uri song uri
  * @param media_file full path to the song
  * @param covercache true = covercache is enabled
  * @param offset number of embedded image to extract
  * @return true on success, else false
  */
-static bool handle_coverextract(struct mg_connection *nc, sds cachedir,
+static bool handle_coverextract(struct mg_connection *nc, struct t_mg_user_data *mg_user_data,
         const char *uri, const char *media_file, bool covercache, int offset)
 {
     #if !defined MYMPD_ENABLE_LIBID3TAG && !defined MYMPD_ENABLE_FLAC
+        (void) mg_user_data;
         (void) covercache;
-        (void) cachedir;
         (void) offset;
         return false;
     #endif
@@ -313,19 +331,36 @@ static bool handle_coverextract(struct mg_connection *nc, sds cachedir,
     sds binary = sdsempty();
     if (strcmp(mime_type_media_file, "audio/mpeg") == 0) {
         #ifdef MYMPD_ENABLE_LIBID3TAG
-            rc = handle_coverextract_id3(cachedir, uri, media_file, &binary, covercache, offset);
+            rc = handle_coverextract_id3(mg_user_data->config->cachedir, uri, media_file, &binary, covercache, offset);
         #endif
     }
     else if (strcmp(mime_type_media_file, "audio/ogg") == 0) {
         #ifdef MYMPD_ENABLE_FLAC
-            rc = handle_coverextract_flac(cachedir, uri, media_file, &binary, true, covercache, offset);
+            rc = handle_coverextract_flac(mg_user_data->config->cachedir, uri, media_file, &binary, true, covercache, offset);
         #endif
     }
     else if (strcmp(mime_type_media_file, "audio/flac") == 0) {
         #ifdef MYMPD_ENABLE_FLAC
-            rc = handle_coverextract_flac(cachedir, uri, media_file, &binary, false, covercache, offset);
+            rc = handle_coverextract_flac(mg_user_data->config->cachedir, uri, media_file, &binary, false, covercache, offset);
         #endif
     }
+    #ifdef MYMPD_ENABLE_THUMBNAILS
+        //the thumbnail variants are created by the worker pool from the cached cover,
+        //the original image is served now
+        if (rc == true &&
+            covercache == true &&
+            mg_user_data->config->cache_thumbs_keep_days != CACHE_DISK_DISABLED)
+        {
+            sds filename = cache_disk_images_get_filepath(mg_user_data->config->cachedir, DIR_CACHE_COVER, uri,
+                get_mime_type_by_magic_stream(binary), offset);
+            if (filename != NULL &&
+                mympd_worker_pool_queue_thumbnails(uri, offset, filename) == false)
+            {
+                MYMPD_LOG_DEBUG(NULL, "Thumbnail queue is full, skipping \"%s\"", uri);
+            }
+            FREE_SDS(filename);
+        }
+    #endif
     if (rc == true) {
         const char *mime_type = get_mime_type_by_magic_stream(binary);
         MYMPD_LOG_DEBUG(NULL, "Serving coverimage for \"%s\" (%s)", media_file, mime_type);
@@ -337,3 +372,35 @@ static bool handle_coverextract(struct mg_connection *nc, sds cachedir,
     FREE_SDS(binary);
     return rc;
 }
+
+#ifdef MYMPD_ENABLE_THUMBNAILS
+/**
+ * Serves the thumbnail variant for the requested albumart size from the thumbs cache
+ * @param nc mongoose connection
+ * @param hm http message
+ * @param mg_user_data pointer to mongoose configuration
+ * @param uri song uri
+ * @param offset number of the coverimage
+ * @param size albumart size
+ * @return true if a thumbnail was served, else false
+ */
+static bool check_thumbnail(struct mg_connection *nc, struct mg_http_message *hm,
+        struct t_mg_user_data *mg_user_data, const char *uri, int offset, enum albumart_sizes size)
+{
+    if (size == ALBUMART_LG) {
+        return false;
+    }
+    const char *variant = size == ALBUMART_SM
+        ? THUMBNAIL_VARIANT_SM
+        : THUMBNAIL_VARIANT_MD;
+    sds thumbfile = cache_disk_images_get_thumbnail_basename(mg_user_data->config->cachedir, uri, offset, variant);
+    thumbfile = webserver_find_image_file_indexed(mg_user_data->image_index, IMAGE_INDEX_SCOPE_CACHE, thumbfile);
+    if (sdslen(thumbfile) > 0) {
+        webserver_serve_file(nc, hm, EXTRA_HEADERS_IMAGE, thumbfile);
+        FREE_SDS(thumbfile);
+        return true;
+    }
+    FREE_SDS(thumbfile);
+    return false;
+}
+#endif
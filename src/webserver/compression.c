@@ -0,0 +1,381 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2026 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+/*! \file
+ * \brief Compression of http responses and websocket messages
+ */
+
+#include "compile_time.h"
+#include "src/webserver/compression.h"
+
+#include "src/lib/log.h"
+#include "src/lib/mem.h"
+
+#include <string.h>
+#include <time.h>
+#include <zlib.h>
+
+/**
+ * Private definitions
+ */
+
+/**
+ * Tail of a deflate block flushed with Z_SYNC_FLUSH,
+ * it is stripped from websocket messages (RFC 7692)
+ */
+static const unsigned char ws_tail[4] = {0x00, 0x00, 0xff, 0xff};
+
+/**
+ * Compression stream
+ */
+struct t_compression_stream {
+    z_stream zs;                          //!< zlib deflate stream
+    enum compression_encoding encoding;   //!< encoding of the stream
+    int level;                            //!< compression level
+};
+
+static struct mg_str strip_whitespace(struct mg_str s);
+static bool is_q_zero(struct mg_str params);
+static struct t_compression_stream *stream_new(enum compression_encoding encoding, int level);
+static bool run_deflate(z_stream *zs, int flush, sds *out);
+static uint64_t cpu_time_ns(void);
+
+/**
+ * Public functions
+ */
+
+/**
+ * Parses the Accept-Encoding header, gzip is preferred over deflate
+ * @param header value of the Accept-Encoding header, can be NULL
+ * @return the encoding to use
+ */
+enum compression_encoding compression_accept_encoding(struct mg_str *header) {
+    if (header == NULL) {
+        return COMPRESSION_NONE;
+    }
+    enum compression_encoding encoding = COMPRESSION_NONE;
+    struct mg_str s = *header;
+    struct mg_str entry;
+    while (mg_span(s, &entry, &s, ',')) {
+        struct mg_str coding;
+        struct mg_str params;
+        mg_span(entry, &coding, &params, ';');
+        coding = strip_whitespace(coding);
+        if (is_q_zero(params) == true) {
+            continue;
+        }
+        if (mg_strcasecmp(coding, mg_str("gzip")) == 0) {
+            return COMPRESSION_GZIP;
+        }
+        if (mg_strcasecmp(coding, mg_str("deflate")) == 0) {
+            encoding = COMPRESSION_DEFLATE;
+        }
+    }
+    return encoding;
+}
+
+/**
+ * Checks if the client offers the permessage-deflate websocket extension
+ * @param header value of the Sec-WebSocket-Extensions header, can be NULL
+ * @return true if offered, else false
+ */
+bool compression_ws_offered(struct mg_str *header) {
+    if (header == NULL) {
+        return false;
+    }
+    struct mg_str s = *header;
+    struct mg_str entry;
+    while (mg_span(s, &entry, &s, ',')) {
+        struct mg_str extension;
+        mg_span(entry, &extension, NULL, ';');
+        extension = strip_whitespace(extension);
+        if (mg_strcasecmp(extension, mg_str("permessage-deflate")) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Returns the Content-Encoding header for the http encoding
+ * @param encoding the encoding
+ * @return header line
+ */
+const char *compression_encoding_header(enum compression_encoding encoding) {
+    switch(encoding) {
+        case COMPRESSION_GZIP:
+            return "Content-Encoding: gzip\r\nVary: Accept-Encoding\r\n";
+        case COMPRESSION_DEFLATE:
+            return "Content-Encoding: deflate\r\nVary: Accept-Encoding\r\n";
+        case COMPRESSION_NONE:
+        case COMPRESSION_WS_DEFLATE:
+            break;
+    }
+    return "";
+}
+
+/**
+ * Initializes the compression statistics
+ * @param stats pointer to compression statistics
+ */
+void compression_stats_init(struct t_compression_stats *stats) {
+    stats->count = 0;
+    stats->bytes_in = 0;
+    stats->bytes_out = 0;
+    stats->cpu_ns = 0;
+}
+
+/**
+ * Compresses a message.
+ * The stream is created on first use and reused for all following messages.
+ * Http messages are compressed independently, websocket messages share the
+ * compression context (context takeover).
+ * @param stream pointer to the stream pointer of the connection
+ * @param encoding encoding to use
+ * @param level compression level 1 - 9
+ * @param data data to compress
+ * @param len length of data
+ * @param out pointer to sds string to append the compressed data
+ * @param stats compression statistics to update, can be NULL
+ * @return true on success, else false
+ */
+bool compression_deflate(struct t_compression_stream **stream, enum compression_encoding encoding, int level,
+        const char *data, size_t len, sds *out, struct t_compression_stats *stats)
+{
+    if (encoding == COMPRESSION_NONE ||
+        len > UINT32_MAX)
+    {
+        return false;
+    }
+    uint64_t started = cpu_time_ns();
+    if (*stream != NULL &&
+        ((*stream)->encoding != encoding || (*stream)->level != level))
+    {
+        compression_stream_free(*stream);
+        *stream = NULL;
+    }
+    if (*stream == NULL) {
+        *stream = stream_new(encoding, level);
+        if (*stream == NULL) {
+            return false;
+        }
+    }
+    else if (encoding != COMPRESSION_WS_DEFLATE) {
+        deflateReset(&(*stream)->zs);
+    }
+    z_stream *zs = &(*stream)->zs;
+    zs->next_in = (Bytef *)data;
+    zs->avail_in = (uInt)len;
+    size_t out_start = sdslen(*out);
+    *out = sdsMakeRoomFor(*out, deflateBound(zs, (uLong)len) + sizeof(ws_tail));
+    bool rc;
+    if (encoding == COMPRESSION_WS_DEFLATE) {
+        rc = run_deflate(zs, Z_SYNC_FLUSH, out);
+        if (rc == true &&
+            sdslen(*out) - out_start >= sizeof(ws_tail))
+        {
+            sdsIncrLen(*out, -(ssize_t)sizeof(ws_tail));
+        }
+    }
+    else {
+        rc = run_deflate(zs, Z_FINISH, out);
+    }
+    if (rc == false) {
+        MYMPD_LOG_ERROR(NULL, "Compression failed: %s", (zs->msg != NULL ? zs->msg : "unknown error"));
+        sdssubstr(*out, 0, out_start);
+        // the stream state is undefined
+        compression_stream_free(*stream);
+        *stream = NULL;
+        return false;
+    }
+    if (stats != NULL) {
+        stats->count++;
+        stats->bytes_in += len;
+        stats->bytes_out += sdslen(*out) - out_start;
+        stats->cpu_ns += cpu_time_ns() - started;
+    }
+    return true;
+}
+
+/**
+ * Decompresses a websocket message compressed without context takeover
+ * @param data compressed message
+ * @param len length of the compressed message
+ * @param max_len maximum length of the decompressed message
+ * @param out pointer to sds string to append the decompressed message
+ * @return true on success, false on error or if the message is longer than max_len
+ */
+bool compression_ws_inflate(const char *data, size_t len, size_t max_len, sds *out) {
+    if (len > UINT32_MAX ||
+        max_len > UINT32_MAX)
+    {
+        return false;
+    }
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    if (inflateInit2(&zs, -MAX_WBITS) != Z_OK) {
+        return false;
+    }
+    size_t out_start = sdslen(*out);
+    // one byte more to detect too long messages
+    *out = sdsMakeRoomFor(*out, max_len + 1);
+    zs.next_out = (Bytef *)(*out + out_start);
+    zs.avail_out = (uInt)max_len + 1;
+    bool rc = true;
+    const unsigned char *inputs[2] = {(const unsigned char *)data, ws_tail};
+    const size_t input_lens[2] = {len, sizeof(ws_tail)};
+    for (int i = 0; i < 2 && rc == true; i++) {
+        zs.next_in = (Bytef *)inputs[i];
+        zs.avail_in = (uInt)input_lens[i];
+        int zrc = inflate(&zs, Z_SYNC_FLUSH);
+        if (zrc != Z_OK &&
+            zrc != Z_STREAM_END &&
+            zrc != Z_BUF_ERROR)
+        {
+            rc = false;
+        }
+    }
+    size_t out_len = max_len + 1 - zs.avail_out;
+    inflateEnd(&zs);
+    if (rc == false ||
+        out_len > max_len)
+    {
+        return false;
+    }
+    sdsIncrLen(*out, (ssize_t)out_len);
+    return true;
+}
+
+/**
+ * Frees the compression stream
+ * @param stream the stream to free, can be NULL
+ */
+void compression_stream_free(struct t_compression_stream *stream) {
+    if (stream == NULL) {
+        return;
+    }
+    deflateEnd(&stream->zs);
+    FREE_PTR(stream);
+}
+
+/**
+ * Private functions
+ */
+
+/**
+ * Strips leading and trailing whitespace
+ * @param s string to strip
+ * @return the stripped string
+ */
+static struct mg_str strip_whitespace(struct mg_str s) {
+    while (s.len > 0 &&
+        (s.buf[0] == ' ' || s.buf[0] == '\t'))
+    {
+        s.buf++;
+        s.len--;
+    }
+    while (s.len > 0 &&
+        (s.buf[s.len - 1] == ' ' || s.buf[s.len - 1] == '\t'))
+    {
+        s.len--;
+    }
+    return s;
+}
+
+/**
+ * Checks for a quality value of zero, that disables the coding
+ * @param params parameters of an Accept-Encoding entry
+ * @return true if q=0, else false
+ */
+static bool is_q_zero(struct mg_str params) {
+    struct mg_str param;
+    while (mg_span(params, &param, &params, ';')) {
+        param = strip_whitespace(param);
+        if (param.len < 3 ||
+            (param.buf[0] != 'q' && param.buf[0] != 'Q') ||
+            param.buf[1] != '=')
+        {
+            continue;
+        }
+        for (size_t i = 2; i < param.len; i++) {
+            if (param.buf[i] != '0' &&
+                param.buf[i] != '.')
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Creates a new compression stream
+ * @param encoding encoding of the stream
+ * @param level compression level
+ * @return the new stream or NULL on error
+ */
+static struct t_compression_stream *stream_new(enum compression_encoding encoding, int level) {
+    struct t_compression_stream *stream = malloc_assert(sizeof(struct t_compression_stream));
+    memset(&stream->zs, 0, sizeof(stream->zs));
+    stream->encoding = encoding;
+    stream->level = level;
+    // zlib selects the stream format by the window bits
+    int window_bits = MAX_WBITS;
+    if (encoding == COMPRESSION_GZIP) {
+        window_bits += 16;
+    }
+    else if (encoding == COMPRESSION_WS_DEFLATE) {
+        window_bits = -MAX_WBITS;
+    }
+    if (deflateInit2(&stream->zs, level, Z_DEFLATED, window_bits, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        MYMPD_LOG_ERROR(NULL, "Could not initialize the compression stream");
+        FREE_PTR(stream);
+        return NULL;
+    }
+    return stream;
+}
+
+/**
+ * Runs deflate until all input is consumed
+ * @param zs zlib stream with the input set
+ * @param flush zlib flush mode
+ * @param out pointer to sds string to append the compressed data
+ * @return true on success, else false
+ */
+static bool run_deflate(z_stream *zs, int flush, sds *out) {
+    int rc;
+    do {
+        if (sdsavail(*out) == 0) {
+            *out = sdsMakeRoomFor(*out, zs->avail_in + 64);
+        }
+        size_t avail = sdsavail(*out) > UINT32_MAX
+            ? UINT32_MAX
+            : sdsavail(*out);
+        zs->next_out = (Bytef *)(*out + sdslen(*out));
+        zs->avail_out = (uInt)avail;
+        rc = deflate(zs, flush);
+        if (rc == Z_STREAM_ERROR) {
+            return false;
+        }
+        sdsIncrLen(*out, (ssize_t)(avail - zs->avail_out));
+    } while (zs->avail_out == 0);
+    return flush == Z_FINISH
+        ? rc == Z_STREAM_END
+        : zs->avail_in == 0;
+}
+
+/**
+ * Returns the cpu time of the calling thread
+ * @return cpu time in nanoseconds
+ */
+static uint64_t cpu_time_ns(void) {
+    struct timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) {
+        return 0;
+    }
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
@@ -0,0 +1,54 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2026 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+/*! \file
+ * \brief Compression of http responses and websocket messages
+ */
+
+#ifndef MYMPD_WEBSERVER_COMPRESSION_H
+#define MYMPD_WEBSERVER_COMPRESSION_H
+
+#include "dist/mongoose/mongoose.h"
+#include "dist/sds/sds.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Supported content encodings
+ */
+enum compression_encoding {
+    COMPRESSION_NONE = 0,     //!< no compression
+    COMPRESSION_DEFLATE,      //!< http deflate, zlib format
+    COMPRESSION_GZIP,         //!< http gzip
+    COMPRESSION_WS_DEFLATE    //!< websocket permessage-deflate, raw deflate
+};
+
+/**
+ * Compression statistics
+ */
+struct t_compression_stats {
+    uint64_t count;      //!< number of compressed messages
+    uint64_t bytes_in;   //!< uncompressed bytes
+    uint64_t bytes_out;  //!< compressed bytes
+    uint64_t cpu_ns;     //!< cpu time used for compression in nanoseconds
+};
+
+/**
+ * Opaque compression stream, reused for all messages of a connection
+ */
+struct t_compression_stream;
+
+enum compression_encoding compression_accept_encoding(struct mg_str *header);
+bool compression_ws_offered(struct mg_str *header);
+const char *compression_encoding_header(enum compression_encoding encoding);
+void compression_stats_init(struct t_compression_stats *stats);
+bool compression_deflate(struct t_compression_stream **stream, enum compression_encoding encoding, int level,
+        const char *data, size_t len, sds *out, struct t_compression_stats *stats);
+bool compression_ws_inflate(const char *data, size_t len, size_t max_len, sds *out);
+void compression_stream_free(struct t_compression_stream *stream);
+
+#endif
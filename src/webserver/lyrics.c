@@ -11,6 +11,7 @@
 #include "compile_time.h"
 #include "src/webserver/lyrics.h"
 
+#include "src/lib/cache/cache_disk_index.h"
 #include "src/lib/cache/cache_disk_lyrics.h"
 #include "src/lib/filehandler.h"
 #include "src/lib/json/json_print.h"
@@ -74,16 +75,20 @@ bool webserver_lyrics_get(struct mg_connection *nc, unsigned request_id, sds bod
     sds cache_file = cache_disk_lyrics_get_name(config->cachedir, uri);
     int nread = 0;
     sds content = sds_getfile(sdsempty(), cache_file, CONTENT_LEN_MAX, true, false, &nread);
+    bool cache_hit = false;
     if (nread > 0) {
         if (validate_json_object(content) == true) {
             MYMPD_LOG_DEBUG(NULL, "Found cached lyrics");
             list_push(&extracted, content, 0, NULL, NULL);
+            cache_disk_index_touch(cache_file);
+            cache_hit = true;
         }
         else {
             MYMPD_LOG_WARN(NULL, "Invalid cached lyrics found, removing file");
             rm_file(cache_file);
         }
     }
+    cache_disk_index_count(CACHE_DISK_TYPE_LYRICS, cache_hit);
     FREE_SDS(cache_file);
     FREE_SDS(content);
 
@@ -115,7 +120,7 @@ bool webserver_lyrics_get(struct mg_connection *nc, unsigned request_id, sds bod
         buffer = tojson_uint(buffer, "totalEntities", entity_count, true);
         buffer = tojson_uint(buffer, "returnedEntities", entity_count, false);
         buffer = jsonrpc_end(buffer);
-        webserver_send_data(nc, buffer, sdslen(buffer), EXTRA_HEADERS_JSON_CONTENT);
+        webserver_send_json(nc, buffer, sdslen(buffer));
         FREE_SDS(buffer);
         return true;
     }
@@ -68,6 +68,10 @@ struct t_mg_user_data *webserver_init_mg_user_data(struct t_config *config) {
     mg_user_data->publish_playlists = false;
     mg_user_data->connection_count = 2; // listening + wakeup
     list_init(&mg_user_data->stream_uris);
+    mg_user_data->image_index = image_index_new();
+    #ifdef MYMPD_ENABLE_ZLIB
+        compression_stats_init(&mg_user_data->compression_stats);
+    #endif
     list_init(&mg_user_data->session_list);
     mg_user_data->mympd_api_started = false;
     mg_user_data->webradiodb = NULL;
@@ -176,6 +180,7 @@ void mg_user_data_free(struct t_mg_user_data *mg_user_data) {
     FREE_SDS(mg_user_data->lyrics.sylt_ext);
     FREE_SDS(mg_user_data->lyrics.vorbis_uslt);
     FREE_SDS(mg_user_data->lyrics.vorbis_sylt);
+    image_index_free(mg_user_data->image_index);
     FREE_PTR(mg_user_data);
 }
 
@@ -14,8 +14,10 @@
 #include "dist/mongoose/mongoose.h"
 #include "dist/sds/sds.h"
 #include "src/lib/config/config_def.h"
+#include "src/lib/image_index.h"
 #include "src/lib/list/list.h"
 #include "src/lib/lyrics.h"
+#include "src/webserver/compression.h"
 
 #include <stdbool.h>
 
@@ -68,6 +70,8 @@ struct t_mg_user_data {
     struct t_embedded_file embedded_files[MAX_EMBEDDED_FILES];  //!< Embedded files
     unsigned embedded_file_index;            //!< Index of last embedded_file
     struct t_lyrics lyrics;                  //!< lyrics settings
+    struct t_image_index *image_index;       //!< index of resolved cover and folder images
+    struct t_compression_stats compression_stats;  //!< statistics for compressed responses
 };
 
 struct t_mg_user_data *webserver_init_mg_user_data(struct t_config *config);
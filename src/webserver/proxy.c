@@ -22,6 +22,11 @@
 #include "src/webserver/response.h"
 #include "src/webserver/utility.h"
 
+//optional includes
+#ifdef MYMPD_ENABLE_THUMBNAILS
+    #include "src/mympd_worker/mympd_worker.h"
+#endif
+
 /**
  * Private definitions
  */
@@ -259,6 +264,14 @@ void forward_backend_to_frontend_covercache(struct mg_connection *nc, int ev, vo
                 //cache the image
                 if (config->cache_cover_keep_days != CACHE_DISK_DISABLED) {
                     sds filename = cache_disk_images_write_file(config->cachedir, DIR_CACHE_COVER, backend_nc_data->uri, mime_type, binary, 0);
+                    #ifdef MYMPD_ENABLE_THUMBNAILS
+                        if (config->cache_thumbs_keep_days != CACHE_DISK_DISABLED &&
+                            filename != NULL &&
+                            mympd_worker_pool_queue_thumbnails(backend_nc_data->uri, 0, filename) == false)
+                        {
+                            MYMPD_LOG_DEBUG(NULL, "Thumbnail queue is full, skipping \"%s\"", backend_nc_data->uri);
+                        }
+                    #endif
                     FREE_SDS(filename);
                 }
                 FREE_SDS(binary);
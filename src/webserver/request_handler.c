@@ -16,6 +16,7 @@
 #include "src/lib/json/json_query.h"
 #include "src/lib/json/json_rpc.h"
 #include "src/lib/log.h"
+#include "src/lib/metrics.h"
 #include "src/lib/sds/sds_extras.h"
 #include "src/webserver/lyrics.h"
 #include "src/webserver/proxy.h"
@@ -308,6 +309,20 @@ void request_handler_serverinfo(struct mg_connection *nc) {
             MYMPD_LOG_ERROR(NULL, "Could not convert peer ip to string");
             response = tojson_char_len(response, "ip", "", 0, false);
         }
+        #ifdef MYMPD_ENABLE_ZLIB
+            struct t_mg_user_data *mg_user_data = (struct t_mg_user_data *)nc->mgr->userdata;
+            const struct t_compression_stats *stats = &mg_user_data->compression_stats;
+            response = sdscat(response, ",\"compression\":{");
+            response = tojson_uint64(response, "count", stats->count, true);
+            response = tojson_uint64(response, "bytesIn", stats->bytes_in, true);
+            response = tojson_uint64(response, "bytesOut", stats->bytes_out, true);
+            uint64_t saved = stats->bytes_in > stats->bytes_out
+                ? stats->bytes_in - stats->bytes_out
+                : 0;
+            response = tojson_uint64(response, "bytesSaved", saved, true);
+            response = tojson_uint64(response, "cpuTimeUs", stats->cpu_ns / 1000, false);
+            response = sdscatlen(response, "}", 1);
+        #endif
         response = jsonrpc_end(response);
         webserver_send_data(nc, response, sdslen(response), EXTRA_HEADERS_JSON_CONTENT);
         FREE_SDS(response);
@@ -317,6 +332,17 @@ void request_handler_serverinfo(struct mg_connection *nc) {
     }
 }
 
+/**
+ * Request handler for /metrics
+ * Prints the api metrics in the Prometheus text format
+ * @param nc mongoose connection
+ */
+void request_handler_metrics(struct mg_connection *nc) {
+    sds response = metrics_print_prometheus(sdsempty());
+    webserver_send_data(nc, response, sdslen(response), EXTRA_HEADERS_METRICS_CONTENT);
+    FREE_SDS(response);
+}
+
 /**
  * Request handler for /ca.crt
  * @param nc mongoose connection
@@ -15,6 +15,7 @@
 #include "src/lib/log.h"
 #include "src/lib/sds/sds_extras.h"
 #include "src/webserver/albumart.h"
+#include "src/webserver/compression.h"
 #include "src/webserver/placeholder.h"
 #include "src/webserver/utility.h"
 
@@ -83,7 +84,7 @@ void webserver_send_api_response(struct mg_mgr *mgr, struct t_work_response *res
                 break;
             default:
                 MYMPD_LOG_DEBUG(response->partition, "Sending response to conn_id \"%lu\" (length: %lu): %s", nc->id, (unsigned long)sdslen(response->data), response->data);
-                webserver_send_data(nc, response->data, sdslen(response->data), EXTRA_HEADERS_JSON_CONTENT);
+                webserver_send_json(nc, response->data, sdslen(response->data));
         }
     }
     else {
@@ -153,6 +154,46 @@ void webserver_send_data(struct mg_connection *nc, const char *data, size_t len,
     webserver_handle_connection_close(nc);
 }
 
+/**
+ * Sends json data, compresses it if the client accepts a supported content encoding
+ * @param nc mongoose connection
+ * @param data data to send
+ * @param len length of the data to send
+ */
+void webserver_send_json(struct mg_connection *nc, const char *data, size_t len) {
+    #ifdef MYMPD_ENABLE_ZLIB
+        struct t_mg_user_data *mg_user_data = (struct t_mg_user_data *)nc->mgr->userdata;
+        struct t_config *config = mg_user_data->config;
+        enum compression_encoding encoding = COMPRESSION_NONE;
+        if (nc->data[3] == 'G') {
+            encoding = COMPRESSION_GZIP;
+        }
+        else if (nc->data[3] == 'D') {
+            encoding = COMPRESSION_DEFLATE;
+        }
+        if (encoding != COMPRESSION_NONE &&
+            config->compression_level > 0 &&
+            len >= config->compression_min_size)
+        {
+            struct t_frontend_nc_data *frontend_nc_data = (struct t_frontend_nc_data *)nc->fn_data;
+            sds compressed = sdsempty();
+            if (compression_deflate(&frontend_nc_data->compression, encoding, config->compression_level,
+                    data, len, &compressed, &mg_user_data->compression_stats) == true &&
+                sdslen(compressed) < len)
+            {
+                MYMPD_LOG_DEBUG(NULL, "Compressed %lu bytes to %lu bytes", (unsigned long)len, (unsigned long)sdslen(compressed));
+                sds headers = sdscatfmt(sdsempty(), "%s%s", EXTRA_HEADERS_JSON_CONTENT, compression_encoding_header(encoding));
+                webserver_send_data(nc, compressed, sdslen(compressed), headers);
+                FREE_SDS(headers);
+                FREE_SDS(compressed);
+                return;
+            }
+            FREE_SDS(compressed);
+        }
+    #endif
+    webserver_send_data(nc, data, len, EXTRA_HEADERS_JSON_CONTENT);
+}
+
 /**
  * Sends a raw reply
  * @param nc mongoose connection
@@ -181,7 +222,7 @@ void webserver_send_jsonrpc_response(struct mg_connection *nc,
 {
     sds response = jsonrpc_respond_message(sdsempty(), cmd_id, request_id,
         facility, severity, message);
-    webserver_send_data(nc, response, sdslen(response), EXTRA_HEADERS_JSON_CONTENT);
+    webserver_send_json(nc, response, sdslen(response));
     FREE_SDS(response);
 }
 
@@ -25,6 +25,7 @@ void webserver_send_header_redirect(struct mg_connection *nc, const char *locati
 void webserver_send_header_found(struct mg_connection *nc, const char *location, const char *headers);
 void webserver_send_cors_reply(struct mg_connection *nc);
 void webserver_send_data(struct mg_connection *nc, const char *data, size_t len, const char *headers);
+void webserver_send_json(struct mg_connection *nc, const char *data, size_t len);
 void webserver_send_raw(struct mg_connection *nc, const char *data, size_t len);
 void webserver_send_jsonrpc_response(struct mg_connection *nc,
         enum mympd_cmd_ids cmd_id, unsigned request_id,
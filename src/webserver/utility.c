@@ -12,6 +12,7 @@
 #include "src/webserver/utility.h"
 
 #include "src/lib/cache/cache_disk_images.h"
+#include "src/lib/cache/cache_disk_index.h"
 #include "src/lib/config/config_def.h"
 #include "src/lib/filehandler.h"
 #include "src/lib/log.h"
@@ -199,13 +200,17 @@ bool check_imagescache(struct mg_connection *nc, struct mg_http_message *hm,
         struct t_mg_user_data *mg_user_data, const char *type, sds uri_decoded, int offset)
 {
     sds imagescachefile = cache_disk_images_get_basename(mg_user_data->config->cachedir, type, uri_decoded, offset);
-    imagescachefile = webserver_find_image_file(imagescachefile);
+    imagescachefile = webserver_find_image_file_indexed(mg_user_data->image_index, IMAGE_INDEX_SCOPE_CACHE, imagescachefile);
+    enum cache_disk_type cache_type = cache_disk_index_type(type);
     if (sdslen(imagescachefile) > 0) {
+        cache_disk_index_touch(imagescachefile);
+        cache_disk_index_count(cache_type, true);
         webserver_serve_file(nc, hm, EXTRA_HEADERS_IMAGE, imagescachefile);
         FREE_SDS(imagescachefile);
         return true;
     }
     MYMPD_LOG_DEBUG(NULL, "No %s cache file found", type);
+    cache_disk_index_count(cache_type, false);
     FREE_SDS(imagescachefile);
     return false;
 }
@@ -245,26 +250,61 @@ sds webserver_find_image_file(sds basefilename) {
     return basefilename;
 }
 
+/**
+ * Finds the first image with basefilename by trying out extensions.
+ * The result is looked up in and added to the image index.
+ * @param image_index pointer to the image index
+ * @param scope invalidation scope for the index entry
+ * @param basefilename basefilename to append extensions
+ * @return pointer to extended basefilename on success, else empty
+ */
+sds webserver_find_image_file_indexed(struct t_image_index *image_index, enum image_index_scope scope, sds basefilename) {
+    sds indexed = image_index_get(image_index, basefilename, sdslen(basefilename));
+    if (indexed != NULL) {
+        sdsclear(basefilename);
+        return sdscatsds(basefilename, indexed);
+    }
+    sds key = sdsdup(basefilename);
+    basefilename = webserver_find_image_file(basefilename);
+    image_index_set(image_index, scope, key, sdslen(key), basefilename, sdslen(basefilename));
+    FREE_SDS(key);
+    return basefilename;
+}
+
 /**
  * Finds an image in a specific subdir in dir
  * @param coverfile pointer to already allocated sds string to append the found image path
+ * @param image_index pointer to the image index
  * @param music_directory parent directory
  * @param path subdirectory
  * @param names sds array of names
  * @param names_len length of sds array
  * @return true on success, else false
  */
-bool find_image_in_folder(sds *coverfile, sds music_directory, sds path, sds *names, int names_len) {
+bool find_image_in_folder(sds *coverfile, struct t_image_index *image_index, sds music_directory, sds path, sds *names, int names_len) {
     for (int j = 0; j < names_len; j++) {
         *coverfile = sdscatfmt(*coverfile, "%S/%S/%S", music_directory, path, names[j]);
         if (strchr(names[j], '.') == NULL) {
             //basename, try extensions
-            *coverfile = webserver_find_image_file(*coverfile);
+            *coverfile = webserver_find_image_file_indexed(image_index, IMAGE_INDEX_SCOPE_MUSIC, *coverfile);
+            if (sdslen(*coverfile) > 0) {
+                return true;
+            }
         }
-        if (sdslen(*coverfile) > 0 &&
-            testfile_read(*coverfile) == true)
-        {
-            return true;
+        else {
+            sds indexed = image_index_get(image_index, *coverfile, sdslen(*coverfile));
+            if (indexed != NULL) {
+                if (sdslen(indexed) > 0) {
+                    return true;
+                }
+            }
+            else if (testfile_read(*coverfile) == true) {
+                image_index_set(image_index, IMAGE_INDEX_SCOPE_MUSIC, *coverfile, sdslen(*coverfile), *coverfile, sdslen(*coverfile));
+                return true;
+            }
+            else {
+                image_index_set(image_index, IMAGE_INDEX_SCOPE_MUSIC, *coverfile, sdslen(*coverfile), "", 0);
+            }
         }
         sdsclear(*coverfile);
     }
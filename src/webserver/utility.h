@@ -13,7 +13,9 @@
 
 #include "dist/mongoose/mongoose.h"
 #include "dist/sds/sds.h"
+#include "src/lib/image_index.h"
 #include "src/lib/list/list.h"
+#include "src/webserver/compression.h"
 #include "src/webserver/mg_user_data.h"
 
 #include <stdbool.h>
@@ -23,6 +25,7 @@
  */
 struct t_frontend_nc_data {
     struct mg_connection *backend_nc;  //!< pointer to backend connection
+    struct t_compression_stream *compression;  //!< compression stream, created on first use
     //for websocket connections only
     sds partition;                     //!< partition
     unsigned id;                       //!< jsonrpc id (client id)
@@ -38,7 +41,8 @@ bool get_partition_from_uri(struct mg_connection *nc, struct mg_http_message *hm
 bool check_imagescache(struct mg_connection *nc, struct mg_http_message *hm,
         struct t_mg_user_data *mg_user_data, const char *type, sds uri_decoded, int offset);
 sds webserver_find_image_file(sds basefilename);
-bool find_image_in_folder(sds *coverfile, sds music_directory, sds path, sds *names, int names_len);
+sds webserver_find_image_file_indexed(struct t_image_index *image_index, enum image_index_scope scope, sds basefilename);
+bool find_image_in_folder(sds *coverfile, struct t_image_index *image_index, sds music_directory, sds path, sds *names, int names_len);
 void webserver_handle_connection_close(struct mg_connection *nc);
 struct t_list *webserver_parse_arguments(struct mg_http_message *hm);
 
@@ -40,6 +40,7 @@
  * Private definitions
  */
 static void read_queue(struct mg_mgr *mgr);
+static void handle_response(struct mg_mgr *mgr, struct t_work_response *response);
 static bool parse_internal_message(struct t_work_response *response, struct t_mg_user_data *mg_user_data);
 static void ev_handler(struct mg_connection *nc, int ev, void *ev_data);
 static void ev_handler_redirect(struct mg_connection *nc_http, int ev, void *ev_data);
@@ -157,58 +158,70 @@ void *webserver_loop(void *arg_mgr) {
  */
 
 /**
- * Reads and processes all messages from the webserver queue.
+ * Reads and processes all messages from the webserver queue in batches.
  * This function does not block and returns immediately if the queue is empty.
  * @param mgr pointer to mongoose mgr
  */
 static void read_queue(struct mg_mgr *mgr) {
-    struct t_mg_user_data *mg_user_data = (struct t_mg_user_data *) mgr->userdata;
-    struct t_work_response *response;
-    while ((response = mympd_queue_shift(webserver_queue, -1, 0)) != NULL) {
-        switch(response->type) {
-            case RESPONSE_TYPE_SCRIPT_DIALOG:
-            case RESPONSE_TYPE_NOTIFY_CLIENT:
-                //websocket notify for specific clients
-                websocket_send_notify_client(mgr, response);
-                break;
-            case RESPONSE_TYPE_NOTIFY_PARTITION:
-                //websocket notify for all clients
-                websocket_send_notify(mgr, response);
-                break;
-            case RESPONSE_TYPE_PUSH_CONFIG:
-                //internal message
-                if (response->cmd_id == INTERNAL_API_WEBSERVER_READY) {
-                    mg_user_data->mympd_api_started = true;
-                    free_response(response);
-                }
-                else if (response->cmd_id == INTERNAL_API_WEBSERVER_SETTINGS){
-                    parse_internal_message(response, mg_user_data);
-                }
-                else {
-                    MYMPD_LOG_ERROR(response->partition, "Invalid API method: %s", get_cmd_id_method_name(response->cmd_id));
-                }
-                break;
-            case RESPONSE_TYPE_DEFAULT:
-                //api response
-                MYMPD_LOG_DEBUG(response->partition, "Got API response for id \"%lu\"", response->conn_id);
-                webserver_send_api_response(mgr, response);
-                break;
-            case RESPONSE_TYPE_RAW:
-                MYMPD_LOG_DEBUG(response->partition, "Got raw response for id \"%lu\" with %lu bytes", response->conn_id, (unsigned long)sdslen(response->data));
-                webserver_send_raw_response(mgr, response);
-                break;
-            case RESPONSE_TYPE_REDIRECT:
-                MYMPD_LOG_DEBUG(response->partition, "Got redirect for id \"%lu\" to %s", response->conn_id, response->data);
-                webserver_send_redirect(mgr, response);
-                break;
-            case RESPONSE_TYPE_SCRIPT:
-            case RESPONSE_TYPE_DISCARD:
-                //ignore
-                break;
+    void *batch[MYMPD_QUEUE_BATCH_SIZE];
+    size_t count;
+    while ((count = mympd_queue_shift_batch(webserver_queue, batch, MYMPD_QUEUE_BATCH_SIZE)) > 0) {
+        for (size_t i = 0; i < count; i++) {
+            handle_response(mgr, batch[i]);
         }
     }
 }
 
+/**
+ * Processes a message from the webserver queue
+ * @param mgr pointer to mongoose mgr
+ * @param response the response to process
+ */
+static void handle_response(struct mg_mgr *mgr, struct t_work_response *response) {
+    struct t_mg_user_data *mg_user_data = (struct t_mg_user_data *) mgr->userdata;
+    switch(response->type) {
+        case RESPONSE_TYPE_SCRIPT_DIALOG:
+        case RESPONSE_TYPE_NOTIFY_CLIENT:
+            //websocket notify for specific clients
+            websocket_send_notify_client(mgr, response);
+            break;
+        case RESPONSE_TYPE_NOTIFY_PARTITION:
+            //websocket notify for all clients
+            websocket_send_notify(mgr, response);
+            break;
+        case RESPONSE_TYPE_PUSH_CONFIG:
+            //internal message
+            if (response->cmd_id == INTERNAL_API_WEBSERVER_READY) {
+                mg_user_data->mympd_api_started = true;
+                free_response(response);
+            }
+            else if (response->cmd_id == INTERNAL_API_WEBSERVER_SETTINGS){
+                parse_internal_message(response, mg_user_data);
+            }
+            else {
+                MYMPD_LOG_ERROR(response->partition, "Invalid API method: %s", get_cmd_id_method_name(response->cmd_id));
+            }
+            break;
+        case RESPONSE_TYPE_DEFAULT:
+            //api response
+            MYMPD_LOG_DEBUG(response->partition, "Got API response for id \"%lu\"", response->conn_id);
+            webserver_send_api_response(mgr, response);
+            break;
+        case RESPONSE_TYPE_RAW:
+            MYMPD_LOG_DEBUG(response->partition, "Got raw response for id \"%lu\" with %lu bytes", response->conn_id, (unsigned long)sdslen(response->data));
+            webserver_send_raw_response(mgr, response);
+            break;
+        case RESPONSE_TYPE_REDIRECT:
+            MYMPD_LOG_DEBUG(response->partition, "Got redirect for id \"%lu\" to %s", response->conn_id, response->data);
+            webserver_send_redirect(mgr, response);
+            break;
+        case RESPONSE_TYPE_SCRIPT:
+        case RESPONSE_TYPE_DISCARD:
+            //ignore
+            break;
+    }
+}
+
 /**
  * Sets the mg_user_data values from set_mg_user_data_request.
  * Message is sent from the mympd_api thread.
@@ -264,6 +277,9 @@ static bool parse_internal_message(struct t_work_response *response, struct t_mg
         mg_user_data->image_names_lg = sds_split_comma_trim(new_mg_user_data->image_names_lg, &mg_user_data->image_names_lg_len);
         FREE_SDS(new_mg_user_data->image_names_lg);
 
+        //the resolved images depend on the music directory and the coverimage names
+        image_index_clear(mg_user_data->image_index);
+
         // Lyrics
         mg_user_data->lyrics.uslt_ext = sds_replace(mg_user_data->lyrics.uslt_ext, new_mg_user_data->lyrics.uslt_ext);
         FREE_SDS(new_mg_user_data->lyrics.uslt_ext);
@@ -416,6 +432,20 @@ static bool check_request(struct mg_connection *nc, struct mg_http_message *hm)
             nc->data[2] = 'K';
         }
     }
+    //accepted content encoding for the response
+    nc->data[3] = '-';
+    #ifdef MYMPD_ENABLE_ZLIB
+        switch(compression_accept_encoding(mg_http_get_header(hm, "Accept-Encoding"))) {
+            case COMPRESSION_GZIP:
+                nc->data[3] = 'G';
+                break;
+            case COMPRESSION_DEFLATE:
+                nc->data[3] = 'D';
+                break;
+            default:
+                break;
+        }
+    #endif
     return true;
 }
 
@@ -425,6 +455,7 @@ static bool check_request(struct mg_connection *nc, struct mg_http_message *hm)
  * 0 - connection type: F = frontend connection, B = backend connection
  * 1 - http method: G = GET, H = HEAD, P = POST
  * 2 - connection header: C = close, K = keepalive
+ * 3 - content encoding: G = gzip, D = deflate, W = websocket permessage-deflate, - = none
  *
  * @param nc mongoose connection
  * @param ev connection event
@@ -452,11 +483,13 @@ static void ev_handler(struct mg_connection *nc, int ev, void *ev_data) {
                 frontend_nc_data->id = 0;                     // populated through websocket message
                 frontend_nc_data->last_ws_ping = time(NULL);  // websocket ping timestamp
                 frontend_nc_data->backend_nc = NULL;          // used for reverse proxy function
+                frontend_nc_data->compression = NULL;         // created on first compressed response
                 nc->fn_data = frontend_nc_data;
                 //set labels
                 nc->data[0] = 'F'; // connection type
                 nc->data[1] = '-'; // http method
                 nc->data[2] = '-'; // connection header
+                nc->data[3] = '-'; // content encoding
             }
             break;
         }
@@ -492,14 +525,38 @@ static void ev_handler(struct mg_connection *nc, int ev, void *ev_data) {
             struct mg_ws_message *wm = (struct mg_ws_message *) ev_data;
             struct mg_str matches[1];
             size_t sent = 0;
-            if (wm->data.len > 9) {
+            struct mg_str data = wm->data;
+            sds inflated = NULL;
+            bool too_long = false;
+            if ((wm->flags & WEBSOCKET_FLAG_COMPRESSED) != 0) {
+                // compressed message
+                #ifdef MYMPD_ENABLE_ZLIB
+                    if (nc->data[3] == 'W') {
+                        inflated = sdsempty();
+                        if (compression_ws_inflate(wm->data.buf, wm->data.len, 9, &inflated) == true) {
+                            data = mg_str_n(inflated, sdslen(inflated));
+                        }
+                        else {
+                            too_long = true;
+                        }
+                    }
+                #endif
+                if (inflated == NULL) {
+                    MYMPD_LOG_ERROR(frontend_nc_data->partition, "Websocket (%lu): Unexpected compressed message, closing connection", nc->id);
+                    nc->is_closing = 1;
+                    break;
+                }
+            }
+            if (too_long == true ||
+                data.len > 9)
+            {
                 MYMPD_LOG_ERROR(frontend_nc_data->partition, "Websocket (%lu) message too long: %lu", nc->id, (unsigned long)wm->data.len);
                 sent = mg_ws_send(nc, "too long", 8, WEBSOCKET_OP_TEXT);
             }
-            else if (mg_strcmp(wm->data, mg_str("ping")) == 0) {
+            else if (mg_strcmp(data, mg_str("ping")) == 0) {
                 sent = mg_ws_send(nc, "pong", 4, WEBSOCKET_OP_TEXT);
             }
-            else if (mg_match(wm->data, mg_str("id:*"), matches)) {
+            else if (mg_match(data, mg_str("id:*"), matches)) {
                 if (mg_str_to_num(matches[0], 10, &frontend_nc_data->id, sizeof(frontend_nc_data->id)) == true) {
                     MYMPD_LOG_INFO(frontend_nc_data->partition, "Setting websocket (%lu) id to \"%u\"", nc->id, frontend_nc_data->id);
                     sent = mg_ws_send(nc, "ok", 2, WEBSOCKET_OP_TEXT);
@@ -509,10 +566,11 @@ static void ev_handler(struct mg_connection *nc, int ev, void *ev_data) {
                 }
             }
             else {
-                MYMPD_LOG_DEBUG(frontend_nc_data->partition, "Websocket (%lu) message: %.*s", nc->id, (int)wm->data.len, wm->data.buf);
+                MYMPD_LOG_DEBUG(frontend_nc_data->partition, "Websocket (%lu) message: %.*s", nc->id, (int)data.len, data.buf);
                 MYMPD_LOG_ERROR(frontend_nc_data->partition, "Websocket (%lu): Invalid message", nc->id);
                 sent = mg_ws_send(nc, "invalid", 7, WEBSOCKET_OP_TEXT);
             }
+            FREE_SDS(inflated);
             if (sent == 0) {
                 MYMPD_LOG_ERROR(frontend_nc_data->partition, "Websocket (%lu): Could not reply, closing connection", nc->id);
                 nc->is_closing = 1;
@@ -592,10 +650,24 @@ static void ev_handler(struct mg_connection *nc, int ev, void *ev_data) {
                 if (get_partition_from_uri(nc, hm, frontend_nc_data) == false) {
                     break;
                 }
-                mg_ws_upgrade(nc, hm, NULL);
+                nc->data[3] = '-';
+                #ifdef MYMPD_ENABLE_ZLIB
+                    if (config->compression_level > 0 &&
+                        compression_ws_offered(mg_http_get_header(hm, "Sec-WebSocket-Extensions")) == true)
+                    {
+                        // client messages are inflated independently
+                        nc->data[3] = 'W';
+                    }
+                #endif
+                if (nc->data[3] == 'W') {
+                    mg_ws_upgrade(nc, hm, "Sec-WebSocket-Extensions: permessage-deflate; client_no_context_takeover\r\n");
+                }
+                else {
+                    mg_ws_upgrade(nc, hm, NULL);
+                }
                 MYMPD_LOG_INFO(frontend_nc_data->partition, "New Websocket connection established (%lu)", nc->id);
                 sds response = jsonrpc_event(sdsempty(), JSONRPC_EVENT_WELCOME);
-                mg_ws_send(nc, response, sdslen(response), WEBSOCKET_OP_TEXT);
+                websocket_send(nc, response, sdslen(response));
                 FREE_SDS(response);
             }
             else if (mg_match(hm->uri, mg_str("/stream/*"), NULL)) {
@@ -622,6 +694,9 @@ static void ev_handler(struct mg_connection *nc, int ev, void *ev_data) {
             else if (mg_match(hm->uri, mg_str("/serverinfo"), NULL)) {
                 request_handler_serverinfo(nc);
             }
+            else if (mg_match(hm->uri, mg_str("/metrics"), NULL)) {
+                request_handler_metrics(nc);
+            }
         #ifdef MYMPD_ENABLE_LUA
             else if (mg_match(hm->uri, mg_str("/script-api/*"), NULL)) {
                 if (config->scripts_external == false) {
@@ -738,6 +813,9 @@ static void ev_handler(struct mg_connection *nc, int ev, void *ev_data) {
                 //close backend connection
                 frontend_nc_data->backend_nc->is_closing = 1;
             }
+            #ifdef MYMPD_ENABLE_ZLIB
+                compression_stream_free(frontend_nc_data->compression);
+            #endif
             FREE_SDS(frontend_nc_data->partition);
             FREE_PTR(frontend_nc_data);
             nc->fn_data = NULL;
@@ -767,6 +845,7 @@ static void ev_handler_redirect(struct mg_connection *nc, int ev, void *ev_data)
             nc->data[0] = 'F'; // connection type
             nc->data[1] = '-'; // http method
             nc->data[2] = '-'; // connection header
+            nc->data[3] = '-'; // content encoding
             break;
         case MG_EV_ACCEPT:
             //enforce connection limit
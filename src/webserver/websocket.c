@@ -12,8 +12,39 @@
 #include "src/webserver/websocket.h"
 
 #include "src/lib/log.h"
+#include "src/lib/sds/sds_extras.h"
 #include "src/webserver/utility.h"
 
+/**
+ * Sends a text message through the websocket,
+ * compresses it if permessage-deflate was negotiated
+ * @param nc mongoose connection
+ * @param data message to send
+ * @param len length of the message
+ */
+void websocket_send(struct mg_connection *nc, const char *data, size_t len) {
+    #ifdef MYMPD_ENABLE_ZLIB
+        struct t_mg_user_data *mg_user_data = (struct t_mg_user_data *)nc->mgr->userdata;
+        struct t_config *config = mg_user_data->config;
+        if (nc->data[3] == 'W' &&
+            config->compression_level > 0 &&
+            len >= config->compression_min_size)
+        {
+            struct t_frontend_nc_data *frontend_nc_data = (struct t_frontend_nc_data *)nc->fn_data;
+            sds compressed = sdsempty();
+            if (compression_deflate(&frontend_nc_data->compression, COMPRESSION_WS_DEFLATE, config->compression_level,
+                    data, len, &compressed, &mg_user_data->compression_stats) == true)
+            {
+                mg_ws_send(nc, compressed, sdslen(compressed), WEBSOCKET_OP_TEXT | WEBSOCKET_FLAG_COMPRESSED);
+                FREE_SDS(compressed);
+                return;
+            }
+            FREE_SDS(compressed);
+        }
+    #endif
+    mg_ws_send(nc, data, len, WEBSOCKET_OP_TEXT);
+}
+
 /**
  * Broadcasts a message through all websocket connections for a specific or all partitions
  * @param mgr mongoose mgr
@@ -34,7 +65,7 @@ void websocket_send_notify(struct mg_mgr *mgr, struct t_work_response *response)
                 strcmp(response->partition, MPD_PARTITION_ALL) == 0)
             {
                 MYMPD_LOG_DEBUG(response->partition, "Sending notify to conn_id \"%lu\": %s", nc->id, response->data);
-                mg_ws_send(nc, response->data, sdslen(response->data), WEBSOCKET_OP_TEXT);
+                websocket_send(nc, response->data, sdslen(response->data));
                 send_count++;
             }
         }
@@ -62,7 +93,7 @@ void websocket_send_notify_client(struct mg_mgr *mgr, struct t_work_response *re
             struct t_frontend_nc_data *frontend_nc_data = (struct t_frontend_nc_data *)nc->fn_data;
             if (client_id == frontend_nc_data->id) {
                 MYMPD_LOG_DEBUG(response->partition, "Sending notify to conn_id \"%lu\", jsonrpc client id %u: %s", nc->id, client_id, response->data);
-                mg_ws_send(nc, response->data, sdslen(response->data), WEBSOCKET_OP_TEXT);
+                websocket_send(nc, response->data, sdslen(response->data));
                 send_count++;
                 break;
             }
@@ -15,6 +15,12 @@
 #include "dist/mongoose/mongoose.h"
 #include "src/lib/api.h"
 
+/**
+ * Websocket frame flag (RSV1) for compressed messages (RFC 7692)
+ */
+#define WEBSOCKET_FLAG_COMPRESSED 0x40
+
+void websocket_send(struct mg_connection *nc, const char *data, size_t len);
 void websocket_send_notify(struct mg_mgr *mgr, struct t_work_response *response);
 void websocket_send_notify_client(struct mg_mgr *mgr, struct t_work_response *response);
 
@@ -0,0 +1,66 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2026 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+/*! \file
+ * \brief Shared definitions of the benchmarks
+ */
+
+#ifndef BENCH_BENCH_H
+#define BENCH_BENCH_H
+
+#include "fake_mpd.h"
+#include "library.h"
+
+#include "src/lib/fields.h"
+#include "src/lib/list/list.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Benchmark options
+ */
+struct t_bench_options {
+    struct t_bench_library_config library;  //!< size of the synthetic library
+    unsigned iterations;                    //!< iterations per bench case
+    unsigned cache_iterations;              //!< iterations for the album cache creation
+    unsigned page_size;                     //!< page size for the list cases
+    const char *workdir;                    //!< working directory
+};
+
+/**
+ * Shared state of the bench cases
+ */
+struct t_bench_env {
+    struct t_bench_options *options;             //!< benchmark options
+    struct t_bench_library *library;             //!< the synthetic library
+    struct t_fake_mpd *server;                   //!< the fake mpd server
+    struct t_mympd_state *mympd_state;           //!< myMPD state connected to the fake server
+    struct t_mympd_worker_state *worker_state;   //!< worker state sharing the connections of mympd_state
+    struct t_fields tagcols;                     //!< tags and stickers to print
+    struct t_list queue_list;                    //!< queue for the jukebox uniq constraints
+};
+
+/**
+ * Runs or prepares one iteration of a bench case
+ * @param env the bench environment
+ * @param iteration number of the iteration
+ * @param items pointer to add the number of processed items
+ * @return true on success, else false
+ */
+typedef bool (*bench_case_cb)(struct t_bench_env *env, unsigned iteration, uint64_t *items);
+
+/**
+ * Definition of a bench case
+ */
+struct t_bench_case {
+    const char *name;      //!< name of the bench case
+    bench_case_cb cb;      //!< callback running one iteration
+    bench_case_cb prepare; //!< optional callback called untimed before each iteration
+    bool cache_case;       //!< true = use the cache iterations
+};
+
+#endif
@@ -0,0 +1,1591 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2026 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+/*! \file
+ * \brief In-process fake MPD server for the benchmarks.
+ * It implements the subset of the MPD protocol used by the benchmarked code paths.
+ * Filter expressions are evaluated with the myMPD search implementation.
+ */
+
+#include "compile_time.h"
+#include "fake_mpd.h"
+
+#include "src/lib/log.h"
+#include "src/lib/mem.h"
+#include "src/lib/sds/sds_extras.h"
+#include "src/lib/search/search.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * Private definitions
+ */
+
+/**
+ * MPD ack codes
+ */
+enum fake_mpd_ack {
+    ACK_OK = 0,
+    ACK_ERROR_ARG = 2,
+    ACK_ERROR_UNKNOWN = 5,
+    ACK_ERROR_NO_EXIST = 50
+};
+
+/**
+ * Connection state of a client
+ */
+struct t_fake_mpd_client {
+    struct t_fake_mpd *server;   //!< pointer to the server
+    int fd;                      //!< client socket
+    bool tags[MPD_TAG_COUNT];    //!< enabled tag types
+    unsigned binarylimit;        //!< maximum size of binary responses
+    bool idle;                   //!< client is in idle mode
+};
+
+/**
+ * Parsed search parameters
+ */
+struct t_fake_mpd_search {
+    struct t_list *expr_list;    //!< parsed filter expression
+    const char *sort;            //!< sort tag, NULL for database order
+    unsigned start;              //!< window start
+    unsigned end;                //!< window end
+};
+
+/**
+ * Matching sticker of a sticker find command
+ */
+struct t_fake_mpd_sticker {
+    const char *uri;             //!< song uri
+    const char *value;           //!< sticker value
+};
+
+typedef enum fake_mpd_ack (*fake_mpd_cmd_cb)(struct t_fake_mpd_client *client, int argc, sds *argv, sds *buffer, sds *error);
+
+/**
+ * MPD command and its implementation
+ */
+struct t_fake_mpd_cmd {
+    const char *name;            //!< command name
+    fake_mpd_cmd_cb cb;          //!< callback implementing the command
+};
+
+static void *accept_loop(void *arg);
+static void *client_loop(void *arg);
+static void run_command_list(struct t_fake_mpd_client *client, struct t_list *commands, bool list_ok, sds *buffer);
+static bool run_command(struct t_fake_mpd_client *client, const char *line, unsigned idx, sds *buffer);
+static sds *split_args(const char *line, int *argc);
+static bool write_all(int fd, const char *data, size_t len);
+static sds print_time(sds buffer, const char *name, time_t timestamp);
+static sds print_song(sds buffer, struct t_fake_mpd_client *client, const struct mpd_song *song);
+static enum fake_mpd_ack parse_range(const char *str, unsigned *start, unsigned *end, sds *error);
+static enum fake_mpd_ack parse_search(int argc, sds *argv, int first, struct t_fake_mpd_search *search, sds *error);
+static struct t_list *parse_filter(const char *expression);
+static struct mpd_song **select_songs(struct t_fake_mpd_client *client, struct t_list *uris,
+        struct t_fake_mpd_search *search, unsigned *len);
+static int song_cmp(const void *a, const void *b);
+static int sticker_cmp(const void *a, const void *b);
+static int sticker_match(const char *sticker, const char *op, const char *value);
+
+static enum fake_mpd_ack cmd_albumart(struct t_fake_mpd_client *client, int argc, sds *argv, sds *buffer, sds *error);
+static enum fake_mpd_ack cmd_binarylimit(struct t_fake_mpd_client *client, int argc, sds *argv, sds *buffer, sds *error);
+static enum fake_mpd_ack cmd_commands(struct t_fake_mpd_client *client, int argc, sds *argv, sds *buffer, sds *error);
+static enum fake_mpd_ack cmd_config(struct t_fake_mpd_client *client, int argc, sds *argv, sds *buffer, sds *error);
+static enum fake_mpd_ack cmd_list(struct t_fake_mpd_client *client, int argc, sds *argv, sds *buffer, sds *error);
+static enum fake_mpd_ack cmd_listplaylist(struct t_fake_mpd_client *client, int argc, sds *argv, sds *buffer, sds *error);
+static enum fake_mpd_ack cmd_listplaylistinfo(struct t_fake_mpd_client *client, int argc, sds *argv, sds *buffer, sds *error);
+static enum fake_mpd_ack cmd_listplaylists(struct t_fake_mpd_client *client, int argc, sds *argv, sds *buffer, sds *error);
+static enum fake_mpd_ack cmd_ok(struct t_fake_mpd_client *client, int argc, sds *argv, sds *buffer, sds *error);
+static enum fake_mpd_ack cmd_playlistadd(struct t_fake_mpd_client *client, int argc, sds *argv, sds *buffer, sds *error);
+static enum fake_mpd_ack cmd_playlistclear(struct t_fake_mpd_client *client, int argc, sds *argv, sds *buffer, sds *error);
+static enum fake_mpd_ack cmd_playlistinfo(struct t_fake_mpd_client *client, int argc, sds *argv, sds *buffer, sds *error);
+static enum fake_mpd_ack cmd_playlistlength(struct t_fake_mpd_client *client, int argc, sds *argv, sds *buffer, sds *error);
+static enum fake_mpd_ack cmd_readpicture(struct t_fake_mpd_client *client, int argc, sds *argv, sds *buffer, sds *error);
+static enum fake_mpd_ack cmd_rm(struct t_fake_mpd_client *client, int argc, sds *argv, sds *buffer, sds *error);
+static enum fake_mpd_ack cmd_save(struct t_fake_mpd_client *client, int argc, sds *argv, sds *buffer, sds *error);
+static enum fake_mpd_ack cmd_search(struct t_fake_mpd_client *client, int argc, sds *argv, sds *buffer, sds *error);
+static enum fake_mpd_ack cmd_searchaddpl(struct t_fake_mpd_client *client, int argc, sds *argv, sds *buffer, sds *error);
+static enum fake_mpd_ack cmd_searchplaylist(struct t_fake_mpd_client *client, int argc, sds *argv, sds *buffer, sds *error);
+static enum fake_mpd_ack cmd_stats(struct t_fake_mpd_client *client, int argc, sds *argv, sds *buffer, sds *error);
+static enum fake_mpd_ack cmd_status(struct t_fake_mpd_client *client, int argc, sds *argv, sds *buffer, sds *error);
+static enum fake_mpd_ack cmd_sticker(struct t_fake_mpd_client *client, int argc, sds *argv, sds *buffer, sds *error);
+static enum fake_mpd_ack cmd_stickernamestypes(struct t_fake_mpd_client *client, int argc, sds *argv, sds *buffer, sds *error);
+static enum fake_mpd_ack cmd_stickertypes(struct t_fake_mpd_client *client, int argc, sds *argv, sds *buffer, sds *error);
+static enum fake_mpd_ack cmd_tagtypes(struct t_fake_mpd_client *client, int argc, sds *argv, sds *buffer, sds *error);
+
+/**
+ * Implemented commands, sorted by name
+ */
+static const struct t_fake_mpd_cmd fake_mpd_cmds[] = {
+    { "albumart", cmd_albumart },
+    { "binarylimit", cmd_binarylimit },
+    { "commands", cmd_commands },
+    { "config", cmd_config },
+    { "find", cmd_search },
+    { "list", cmd_list },
+    { "listplaylist", cmd_listplaylist },
+    { "listplaylistinfo", cmd_listplaylistinfo },
+    { "listplaylists", cmd_listplaylists },
+    { "notcommands", cmd_ok },
+    { "password", cmd_ok },
+    { "ping", cmd_ok },
+    { "playlistadd", cmd_playlistadd },
+    { "playlistclear", cmd_playlistclear },
+    { "playlistinfo", cmd_playlistinfo },
+    { "playlistlength", cmd_playlistlength },
+    { "protocol", cmd_ok },
+    { "readpicture", cmd_readpicture },
+    { "rm", cmd_rm },
+    { "save", cmd_save },
+    { "search", cmd_search },
+    { "searchaddpl", cmd_searchaddpl },
+    { "searchplaylist", cmd_searchplaylist },
+    { "stats", cmd_stats },
+    { "status", cmd_status },
+    { "sticker", cmd_sticker },
+    { "stickernamestypes", cmd_stickernamestypes },
+    { "stickertypes", cmd_stickertypes },
+    { "stringnormalization", cmd_ok },
+    { "tagtypes", cmd_tagtypes },
+    { NULL, NULL }
+};
+
+/**
+ * Sort tag for song_cmp and sticker sort for sticker_cmp
+ */
+static _Thread_local const char *sort_by;
+
+/**
+ * Public functions
+ */
+
+/**
+ * Starts the fake MPD server
+ * @param server pointer to the server struct to initialize
+ * @param library the library to serve
+ * @param socket_path path of the unix socket to create
+ * @return true on success, else false
+ */
+bool fake_mpd_start(struct t_fake_mpd *server, struct t_bench_library *library, const char *socket_path) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(socket_path) >= sizeof(addr.sun_path)) {
+        MYMPD_LOG_ERROR(NULL, "Socket path \"%s\" is too long", socket_path);
+        return false;
+    }
+    strncpy(addr.sun_path, socket_path, sizeof(addr.sun_path) - 1);
+    unlink(socket_path);
+    errno = 0;
+    server->listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (server->listen_fd < 0 ||
+        bind(server->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        listen(server->listen_fd, 16) != 0)
+    {
+        MYMPD_LOG_ERROR(NULL, "Can not listen on \"%s\"", socket_path);
+        MYMPD_LOG_ERRNO(NULL, errno);
+        if (server->listen_fd >= 0) {
+            close(server->listen_fd);
+        }
+        return false;
+    }
+
+    server->library = library;
+    server->socket_path = sdsnew(socket_path);
+    server->clients = 0;
+    server->commands = 0;
+    server->any_tags.len = 0;
+    for (int i = 0; i < MPD_TAG_COUNT; i++) {
+        server->any_tags.tags[server->any_tags.len++] = (enum mpd_tag_type)i;
+    }
+    pthread_mutex_init(&server->mutex, NULL);
+    pthread_cond_init(&server->clients_done, NULL);
+    if (pthread_create(&server->accept_thread, NULL, accept_loop, server) != 0) {
+        MYMPD_LOG_ERROR(NULL, "Can not start the fake mpd server thread");
+        close(server->listen_fd);
+        unlink(socket_path);
+        pthread_mutex_destroy(&server->mutex);
+        pthread_cond_destroy(&server->clients_done);
+        FREE_SDS(server->socket_path);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Stops the fake MPD server.
+ * Waits until all clients are disconnected.
+ * @param server pointer to the server
+ */
+void fake_mpd_stop(struct t_fake_mpd *server) {
+    shutdown(server->listen_fd, SHUT_RDWR);
+    pthread_join(server->accept_thread, NULL);
+    close(server->listen_fd);
+    pthread_mutex_lock(&server->mutex);
+    while (server->clients > 0) {
+        pthread_cond_wait(&server->clients_done, &server->mutex);
+    }
+    pthread_mutex_unlock(&server->mutex);
+    pthread_mutex_destroy(&server->mutex);
+    pthread_cond_destroy(&server->clients_done);
+    unlink(server->socket_path);
+    FREE_SDS(server->socket_path);
+}
+
+/**
+ * Private functions
+ */
+
+/**
+ * Accepts the connections and starts a thread for each client
+ * @param arg pointer to the server
+ * @return NULL
+ */
+static void *accept_loop(void *arg) {
+    struct t_fake_mpd *server = (struct t_fake_mpd *)arg;
+    int fd;
+    while ((fd = accept(server->listen_fd, NULL, NULL)) >= 0) {
+        struct t_fake_mpd_client *client = malloc_assert(sizeof(struct t_fake_mpd_client));
+        client->server = server;
+        client->fd = fd;
+        client->binarylimit = 8192;
+        client->idle = false;
+        for (int i = 0; i < MPD_TAG_COUNT; i++) {
+            client->tags[i] = true;
+        }
+        pthread_mutex_lock(&server->mutex);
+        server->clients++;
+        pthread_mutex_unlock(&server->mutex);
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, client_loop, client) != 0) {
+            MYMPD_LOG_ERROR(NULL, "Can not start the fake mpd client thread");
+            close(fd);
+            FREE_PTR(client);
+            pthread_mutex_lock(&server->mutex);
+            server->clients--;
+            pthread_mutex_unlock(&server->mutex);
+            continue;
+        }
+        pthread_detach(thread);
+    }
+    return NULL;
+}
+
+/**
+ * Reads and executes the commands of a client until it disconnects
+ * @param arg pointer to the client
+ * @return NULL
+ */
+static void *client_loop(void *arg) {
+    struct t_fake_mpd_client *client = (struct t_fake_mpd_client *)arg;
+    struct t_fake_mpd *server = client->server;
+    thread_logname = sdsnew("fake_mpd");
+    thread_logline = sdsempty();
+    FILE *fp = fdopen(client->fd, "r");
+    sds buffer = sdsnew("OK MPD 0.24.0\n");
+    struct t_list commands;
+    list_init(&commands);
+    bool in_list = false;
+    bool list_ok = false;
+    char *line = NULL;
+    size_t line_size = 0;
+    ssize_t nread;
+    if (fp == NULL ||
+        write_all(client->fd, buffer, sdslen(buffer)) == false)
+    {
+        nread = -1;
+    }
+    else {
+        nread = 0;
+    }
+    sdsclear(buffer);
+    while (nread >= 0 &&
+           (nread = getline(&line, &line_size, fp)) > 0)
+    {
+        if (line[nread - 1] == '\n') {
+            line[nread - 1] = '\0';
+        }
+        if (in_list == true) {
+            if (strcmp(line, "command_list_end") == 0) {
+                run_command_list(client, &commands, list_ok, &buffer);
+                list_clear(&commands);
+                in_list = false;
+            }
+            else {
+                list_push(&commands, line, 0, NULL, NULL);
+                continue;
+            }
+        }
+        else if (strcmp(line, "command_list_begin") == 0 ||
+                 strcmp(line, "command_list_ok_begin") == 0)
+        {
+            in_list = true;
+            list_ok = strcmp(line, "command_list_ok_begin") == 0;
+            continue;
+        }
+        else if (strncmp(line, "idle", 4) == 0) {
+            // no events are generated, the client leaves the idle mode with noidle
+            client->idle = true;
+            continue;
+        }
+        else if (strcmp(line, "noidle") == 0) {
+            if (client->idle == false) {
+                continue;
+            }
+            client->idle = false;
+            buffer = sdscatlen(buffer, "OK\n", 3);
+        }
+        else if (strcmp(line, "close") == 0) {
+            break;
+        }
+        else {
+            client->idle = false;
+            if (run_command(client, line, 0, &buffer) == true) {
+                buffer = sdscatlen(buffer, "OK\n", 3);
+            }
+        }
+        if (write_all(client->fd, buffer, sdslen(buffer)) == false) {
+            break;
+        }
+        sdsclear(buffer);
+    }
+    FREE_PTR(line);
+    list_clear(&commands);
+    FREE_SDS(buffer);
+    if (fp != NULL) {
+        fclose(fp);
+    }
+    else {
+        close(client->fd);
+    }
+    FREE_PTR(client);
+    FREE_SDS(thread_logname);
+    FREE_SDS(thread_logline);
+    pthread_mutex_lock(&server->mutex);
+    server->clients--;
+    if (server->clients == 0) {
+        pthread_cond_signal(&server->clients_done);
+    }
+    pthread_mutex_unlock(&server->mutex);
+    return NULL;
+}
+
+/**
+ * Executes a command list, stops on the first error
+ * @param client pointer to the client
+ * @param commands list of command lines
+ * @param list_ok true = respond list_OK after each command
+ * @param buffer pointer to the response buffer
+ */
+static void run_command_list(struct t_fake_mpd_client *client, struct t_list *commands, bool list_ok, sds *buffer) {
+    unsigned idx = 0;
+    for (struct t_list_node *current = commands->head; current != NULL; current = current->next) {
+        if (run_command(client, current->key, idx, buffer) == false) {
+            return;
+        }
+        if (list_ok == true) {
+            *buffer = sdscatlen(*buffer, "list_OK\n", 8);
+        }
+        idx++;
+    }
+    *buffer = sdscatlen(*buffer, "OK\n", 3);
+}
+
+/**
+ * Executes a single command
+ * @param client pointer to the client
+ * @param line command line
+ * @param idx index of the command in a command list
+ * @param buffer pointer to the response buffer
+ * @return true on success, false if an ACK was sent
+ */
+static bool run_command(struct t_fake_mpd_client *client, const char *line, unsigned idx, sds *buffer) {
+    client->server->commands++;
+    int argc;
+    sds *argv = split_args(line, &argc);
+    if (argv == NULL) {
+        *buffer = sdscatfmt(*buffer, "ACK [%u@%u] {} Invalid command\n", ACK_ERROR_ARG, idx);
+        return false;
+    }
+    enum fake_mpd_ack rc = ACK_ERROR_UNKNOWN;
+    sds error = sdsempty();
+    const struct t_fake_mpd_cmd *cmd = NULL;
+    for (const struct t_fake_mpd_cmd *p = fake_mpd_cmds; p->name != NULL; p++) {
+        if (strcmp(p->name, argv[0]) == 0) {
+            cmd = p;
+            break;
+        }
+    }
+    if (cmd != NULL) {
+        size_t buffer_len = sdslen(*buffer);
+        pthread_mutex_lock(&client->server->mutex);
+        rc = cmd->cb(client, argc, argv, buffer, &error);
+        pthread_mutex_unlock(&client->server->mutex);
+        if (rc != ACK_OK) {
+            // discard the partial response
+            sdssubstr(*buffer, 0, buffer_len);
+        }
+    }
+    else {
+        MYMPD_LOG_WARN(NULL, "Fake mpd: unknown command \"%s\"", line);
+        error = sdscatfmt(error, "unknown command \"%S\"", argv[0]);
+    }
+    if (rc != ACK_OK) {
+        *buffer = sdscatfmt(*buffer, "ACK [%u@%u] {%S} %S\n", rc, idx, argv[0], error);
+    }
+    FREE_SDS(error);
+    sdsfreesplitres(argv, argc);
+    return rc == ACK_OK;
+}
+
+/**
+ * Splits a command line into arguments,
+ * arguments are separated by spaces or quoted with double quotes.
+ * @param line the command line
+ * @param argc pointer to set the number of arguments
+ * @return array of arguments or NULL on error
+ */
+static sds *split_args(const char *line, int *argc) {
+    sds *argv = NULL;
+    *argc = 0;
+    const char *p = line;
+    while (true) {
+        while (*p == ' ' || *p == '\t') {
+            p++;
+        }
+        if (*p == '\0') {
+            break;
+        }
+        sds arg = sdsempty();
+        if (*p == '"') {
+            p++;
+            while (*p != '"') {
+                if (*p == '\\' && p[1] != '\0') {
+                    p++;
+                }
+                if (*p == '\0') {
+                    FREE_SDS(arg);
+                    sdsfreesplitres(argv, *argc);
+                    *argc = 0;
+                    return NULL;
+                }
+                arg = sdscatlen(arg, p, 1);
+                p++;
+            }
+            p++;
+        }
+        else {
+            const char *start = p;
+            while (*p != '\0' && *p != ' ' && *p != '\t') {
+                p++;
+            }
+            arg = sdscatlen(arg, start, (size_t)(p - start));
+        }
+        argv = realloc_assert(argv, sizeof(sds) * (size_t)(*argc + 1));
+        argv[*argc] = arg;
+        (*argc)++;
+    }
+    return argv;
+}
+
+/**
+ * Writes the complete buffer to the socket
+ * @param fd socket
+ * @param data data to write
+ * @param len length of data
+ * @return true on success, else false
+ */
+static bool write_all(int fd, const char *data, size_t len) {
+    while (len > 0) {
+        ssize_t n = send(fd, data, len, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+/**
+ * Prints a timestamp in the ISO 8601 format MPD uses
+ * @param buffer already allocated sds string to append
+ * @param name name of the pair
+ * @param timestamp the timestamp
+ * @return pointer to buffer
+ */
+static sds print_time(sds buffer, const char *name, time_t timestamp) {
+    char fmt_time[32];
+    struct tm tm;
+    gmtime_r(&timestamp, &tm);
+    strftime(fmt_time, sizeof(fmt_time), "%Y-%m-%dT%H:%M:%SZ", &tm);
+    return sdscatfmt(buffer, "%s: %s\n", name, fmt_time);
+}
+
+/**
+ * Prints a song with the tags enabled for the client
+ * @param buffer already allocated sds string to append
+ * @param client pointer to the client
+ * @param song the song
+ * @return pointer to buffer
+ */
+static sds print_song(sds buffer, struct t_fake_mpd_client *client, const struct mpd_song *song) {
+    buffer = sdscatfmt(buffer, "file: %s\n", mpd_song_get_uri(song));
+    buffer = print_time(buffer, "Last-Modified", mpd_song_get_last_modified(song));
+    buffer = print_time(buffer, "Added", mpd_song_get_added(song));
+    for (int i = 0; i < MPD_TAG_COUNT; i++) {
+        if (client->tags[i] == false) {
+            continue;
+        }
+        const char *value;
+        unsigned idx = 0;
+        while ((value = mpd_song_get_tag(song, (enum mpd_tag_type)i, idx)) != NULL) {
+            buffer = sdscatfmt(buffer, "%s: %s\n", mpd_tag_name((enum mpd_tag_type)i), value);
+            idx++;
+        }
+    }
+    unsigned duration = mpd_song_get_duration(song);
+    buffer = sdscatfmt(buffer, "Time: %u\nduration: %u.000\n", duration, duration);
+    return buffer;
+}
+
+/**
+ * Parses a range argument
+ * @param str range in the format start:end, start: or position
+ * @param start pointer to set the start
+ * @param end pointer to set the end
+ * @param error pointer to the error message
+ * @return ACK_OK on success, else an ack code
+ */
+static enum fake_mpd_ack parse_range(const char *str, unsigned *start, unsigned *end, sds *error) {
+    char *rest;
+    errno = 0;
+    unsigned long value = strtoul(str, &rest, 10);
+    if (errno != 0 ||
+        rest == str ||
+        value > UINT_MAX)
+    {
+        *error = sdscatfmt(*error, "Invalid range \"%s\"", str);
+        return ACK_ERROR_ARG;
+    }
+    *start = (unsigned)value;
+    if (*rest == '\0') {
+        *end = *start + 1;
+        return ACK_OK;
+    }
+    if (*rest != ':') {
+        *error = sdscatfmt(*error, "Invalid range \"%s\"", str);
+        return ACK_ERROR_ARG;
+    }
+    rest++;
+    if (*rest == '\0') {
+        *end = UINT_MAX;
+        return ACK_OK;
+    }
+    const char *end_str = rest;
+    value = strtoul(end_str, &rest, 10);
+    if (errno != 0 ||
+        rest == end_str ||
+        *rest != '\0' ||
+        value > UINT_MAX)
+    {
+        *error = sdscatfmt(*error, "Invalid range \"%s\"", str);
+        return ACK_ERROR_ARG;
+    }
+    *end = (unsigned)value;
+    return ACK_OK;
+}
+
+/**
+ * Parses a filter expression with the myMPD search engine.
+ * MPD accepts unix timestamps for added-since and modified-since, the myMPD
+ * search engine only dates. The timestamps are translated to the local date,
+ * the fake server filters with day granularity. The epoch day can not be
+ * parsed, it is translated to the next day, the synthetic library is newer.
+ * @param expression mpd filter expression
+ * @return the parsed expression or NULL on error
+ */
+static struct t_list *parse_filter(const char *expression) {
+    static const char *since_filters[] = {"added-since '", "modified-since '", NULL};
+    sds translated = sdsempty();
+    const char *p = expression;
+    while (*p != '\0') {
+        size_t filter_len = 0;
+        for (const char **filter = since_filters; *filter != NULL; filter++) {
+            if (strncmp(p, *filter, strlen(*filter)) == 0) {
+                filter_len = strlen(*filter);
+                break;
+            }
+        }
+        if (filter_len == 0) {
+            translated = sdscatlen(translated, p, 1);
+            p++;
+            continue;
+        }
+        translated = sdscatlen(translated, p, filter_len);
+        p += filter_len;
+        char *end;
+        errno = 0;
+        long long timestamp = strtoll(p, &end, 10);
+        if (end != p &&
+            *end == '\'' &&
+            errno == 0)
+        {
+            time_t t = timestamp > 86400
+                ? (time_t)timestamp
+                : 86400;
+            struct tm tm;
+            char date[32];
+            if (localtime_r(&t, &tm) != NULL &&
+                strftime(date, sizeof(date), "%Y-%m-%d", &tm) > 0)
+            {
+                translated = sdscat(translated, date);
+                p = end;
+            }
+        }
+    }
+    struct t_list *expr_list = search_expression_parse(translated, SEARCH_TYPE_SONG);
+    FREE_SDS(translated);
+    return expr_list;
+}
+
+/**
+ * Parses a filter expression or the legacy tag/value pairs and the sort and window parameters
+ * @param argc number of arguments
+ * @param argv arguments
+ * @param first index of the filter expression
+ * @param search pointer to the search struct to populate
+ * @param error pointer to the error message
+ * @return ACK_OK on success, else an ack code
+ */
+static enum fake_mpd_ack parse_search(int argc, sds *argv, int first, struct t_fake_mpd_search *search, sds *error) {
+    search->expr_list = NULL;
+    search->sort = NULL;
+    search->start = 0;
+    search->end = UINT_MAX;
+    if (argc <= first) {
+        *error = sdscat(*error, "too few arguments");
+        return ACK_ERROR_ARG;
+    }
+    int i = first;
+    if (argv[i][0] == '(') {
+        search->expr_list = parse_filter(argv[i]);
+        i++;
+    }
+    else {
+        // legacy syntax: find uses exact matches, search substring matches
+        const char *op = strcmp(argv[0], "find") == 0
+            ? "=="
+            : "contains";
+        sds expression = sdsempty();
+        for (; i + 1 < argc; i += 2) {
+            if (strcmp(argv[i], "sort") == 0 ||
+                strcmp(argv[i], "window") == 0)
+            {
+                break;
+            }
+            if (sdslen(argv[i + 1]) == 0 &&
+                op[0] == 'c')
+            {
+                // an empty substring matches all songs
+                continue;
+            }
+            if (sdslen(expression) > 0) {
+                expression = sdscat(expression, " AND ");
+            }
+            expression = sdscatfmt(expression, "(%S %s '%S')", argv[i], op, argv[i + 1]);
+        }
+        search->expr_list = sdslen(expression) > 0
+            ? parse_filter(expression)
+            : list_new();
+        FREE_SDS(expression);
+    }
+    if (search->expr_list == NULL) {
+        *error = sdscat(*error, "Failed to parse filter");
+        return ACK_ERROR_ARG;
+    }
+    for (; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "sort") == 0) {
+            search->sort = argv[i + 1];
+        }
+        else if (strcmp(argv[i], "window") == 0) {
+            enum fake_mpd_ack rc = parse_range(argv[i + 1], &search->start, &search->end, error);
+            if (rc != ACK_OK) {
+                search_expression_free(search->expr_list);
+                search->expr_list = NULL;
+                return rc;
+            }
+        }
+    }
+    return ACK_OK;
+}
+
+/**
+ * Selects the songs matching the search
+ * @param client pointer to the client
+ * @param uris list of uris to search or NULL to search the database
+ * @param search the parsed search
+ * @param len pointer to set the number of selected songs
+ * @return newly allocated array of songs
+ */
+static struct mpd_song **select_songs(struct t_fake_mpd_client *client, struct t_list *uris,
+        struct t_fake_mpd_search *search, unsigned *len)
+{
+    struct t_bench_library *library = client->server->library;
+    unsigned max = uris == NULL
+        ? library->config.songs
+        : uris->length;
+    struct mpd_song **songs = malloc_assert((max + 1) * sizeof(struct mpd_song *));
+    unsigned count = 0;
+    struct t_list_node *current = uris == NULL
+        ? NULL
+        : uris->head;
+    for (unsigned i = 0; i < max; i++) {
+        struct mpd_song *song;
+        if (uris == NULL) {
+            song = library->songs[i];
+        }
+        else {
+            song = bench_library_get_song(library, current->key);
+            current = current->next;
+            if (song == NULL) {
+                continue;
+            }
+        }
+        if (search_expression_song(song, search->expr_list, &client->server->any_tags) == true) {
+            songs[count++] = song;
+        }
+    }
+    if (search->sort != NULL) {
+        sort_by = search->sort;
+        qsort(songs, count, sizeof(struct mpd_song *), song_cmp);
+    }
+    // apply the window
+    unsigned end = search->end < count
+        ? search->end
+        : count;
+    if (search->start >= end) {
+        *len = 0;
+        return songs;
+    }
+    *len = end - search->start;
+    if (search->start > 0) {
+        memmove(songs, songs + search->start, *len * sizeof(struct mpd_song *));
+    }
+    return songs;
+}
+
+/**
+ * Compares two songs by the tag or timestamp in sort_by, a leading "-" sorts descending
+ * @param a pointer to the first song
+ * @param b pointer to the second song
+ * @return result of the comparison
+ */
+static int song_cmp(const void *a, const void *b) {
+    const struct mpd_song *song1 = *(struct mpd_song * const *)a;
+    const struct mpd_song *song2 = *(struct mpd_song * const *)b;
+    const char *sort = sort_by;
+    int desc = 1;
+    if (sort[0] == '-') {
+        desc = -1;
+        sort++;
+    }
+    if (strcmp(sort, "Last-Modified") == 0) {
+        time_t t1 = mpd_song_get_last_modified(song1);
+        time_t t2 = mpd_song_get_last_modified(song2);
+        return desc * ((t1 > t2) - (t1 < t2));
+    }
+    if (strcmp(sort, "Added") == 0) {
+        time_t t1 = mpd_song_get_added(song1);
+        time_t t2 = mpd_song_get_added(song2);
+        return desc * ((t1 > t2) - (t1 < t2));
+    }
+    enum mpd_tag_type tag = mpd_tag_name_iparse(sort);
+    const char *v1 = tag != MPD_TAG_UNKNOWN
+        ? mpd_song_get_tag(song1, tag, 0)
+        : NULL;
+    const char *v2 = tag != MPD_TAG_UNKNOWN
+        ? mpd_song_get_tag(song2, tag, 0)
+        : NULL;
+    if (v1 == NULL) {
+        v1 = "";
+    }
+    if (v2 == NULL) {
+        v2 = "";
+    }
+    int rc = strcmp(v1, v2);
+    if (rc == 0) {
+        rc = strcmp(mpd_song_get_uri(song1), mpd_song_get_uri(song2));
+    }
+    return desc * rc;
+}
+
+/**
+ * Compares two stickers by the sticker sort in sort_by
+ * @param a pointer to the first sticker
+ * @param b pointer to the second sticker
+ * @return result of the comparison
+ */
+static int sticker_cmp(const void *a, const void *b) {
+    const struct t_fake_mpd_sticker *s1 = (const struct t_fake_mpd_sticker *)a;
+    const struct t_fake_mpd_sticker *s2 = (const struct t_fake_mpd_sticker *)b;
+    const char *sort = sort_by;
+    int desc = 1;
+    if (sort[0] == '-') {
+        desc = -1;
+        sort++;
+    }
+    if (strcmp(sort, "value_int") == 0) {
+        long long v1 = strtoll(s1->value, NULL, 10);
+        long long v2 = strtoll(s2->value, NULL, 10);
+        return desc * ((v1 > v2) - (v1 < v2));
+    }
+    if (strcmp(sort, "value") == 0) {
+        return desc * strcmp(s1->value, s2->value);
+    }
+    return desc * strcmp(s1->uri, s2->uri);
+}
+
+/**
+ * Compares a sticker value with the operator of the sticker find command
+ * @param sticker the sticker value
+ * @param op the operator
+ * @param value value to compare with
+ * @return 1 on match, 0 on no match, -1 for an unknown operator
+ */
+static int sticker_match(const char *sticker, const char *op, const char *value) {
+    if (strcmp(op, "=") == 0) {
+        return strcmp(sticker, value) == 0;
+    }
+    if (strcmp(op, "<") == 0) {
+        return strcmp(sticker, value) < 0;
+    }
+    if (strcmp(op, ">") == 0) {
+        return strcmp(sticker, value) > 0;
+    }
+    if (strcmp(op, "contains") == 0) {
+        return strstr(sticker, value) != NULL;
+    }
+    if (strcmp(op, "starts_with") == 0) {
+        return strncmp(sticker, value, strlen(value)) == 0;
+    }
+    long long sticker_int = strtoll(sticker, NULL, 10);
+    long long value_int = strtoll(value, NULL, 10);
+    if (strcmp(op, "eq") == 0) {
+        return sticker_int == value_int;
+    }
+    if (strcmp(op, "lt") == 0) {
+        return sticker_int < value_int;
+    }
+    if (strcmp(op, "gt") == 0) {
+        return sticker_int > value_int;
+    }
+    return -1;
+}
+
+/**
+ * Command implementations
+ */
+
+/**
+ * Sends a chunk of the albumart
+ */
+static enum fake_mpd_ack cmd_albumart(struct t_fake_mpd_client *client, int argc, sds *argv, sds *buffer, sds *error) {
+    struct t_bench_library *library = client->server->library;
+    if (argc != 3) {
+        *error = sdscat(*error, "wrong number of arguments");
+        return ACK_ERROR_ARG;
+    }
+    if (bench_library_get_song(library, argv[1]) == NULL ||
+        sdslen(library->albumart) == 0)
+    {
+        *error = sdscat(*error, "No file exists");
+        return ACK_ERROR_NO_EXIST;
+    }
+    unsigned offset = (unsigned)strtoul(argv[2], NULL, 10);
+    unsigned size = (unsigned)sdslen(library->albumart);
+    unsigned len = offset < size
+        ? size - offset
+        : 0;
+    if (len > client->binarylimit) {
+        len = client->binarylimit;
+    }
+    *buffer = sdscatfmt(*buffer, "size: %u\nbinary: %u\n", size, len);
+    *buffer = sdscatlen(*buffer, library->albumart + (offset < size ? offset : 0), len);
+    *buffer = sdscatlen(*buffer, "\n", 1);
+    return ACK_OK;
+}
+
+/**
+ * Sets the maximum size of binary responses
+ */
+static enum fake_mpd_ack cmd_binarylimit(struct t_fake_mpd_client *client, int argc, sds *argv, sds *buffer, sds *error) {
+    (void)buffer;
+    if (argc != 2) {
+        *error = sdscat(*error, "wrong number of arguments");
+        return ACK_ERROR_ARG;
+    }
+    unsigned limit = (unsigned)strtoul(argv[1], NULL, 10);
+    if (limit < 64) {
+        *error = sdscat(*error, "Value too small");
+        return ACK_ERROR_ARG;
+    }
+    client->binarylimit = limit;
+    return ACK_OK;
+}
+
+/**
+ * Lists the implemented commands
+ */
+static enum fake_mpd_ack cmd_commands(struct t_fake_mpd_client *client, int argc, sds *argv, sds *buffer, sds *error) {
+    (void)client;
+    (void)argc;
+    (void)argv;
+    (void)error;
+    for (const struct t_fake_mpd_cmd *p = fake_mpd_cmds; p->name != NULL; p++) {
+        *buffer = sdscatfmt(*buffer, "command: %s\n", p->name);
+    }
+    return ACK_OK;
+}
+
+/**
+ * Prints the server configuration
+ */
+static enum fake_mpd_ack cmd_config(struct t_fake_mpd_client *client, int argc, sds *argv, sds *buffer, sds *error) {
+    (void)client;
+    (void)argc;
+    (void)argv;
+    (void)error;
+    *buffer = sdscat(*buffer, "pcre: 1\n");
+    return ACK_OK;
+}
+
+/**
+ * Lists the unique values of a tag, the group parameter is ignored
+ */
+static enum fake_mpd_ack cmd_list(struct t_fake_mpd_client *client, int argc, sds *argv, sds *buffer, sds *error) {
+    struct t_bench_library *library = client->server->library;
+    if (argc < 2) {
+        *error = sdscat(*error, "too few arguments");
+        return ACK_ERROR_ARG;
+    }
+    enum mpd_tag_type tag = mpd_tag_name_iparse(argv[1]);
+    if (tag == MPD_TAG_UNKNOWN) {
+        *error = sdscatfmt(*error, "Unknown tag type: %S", argv[1]);
+        return ACK_ERROR_ARG;
+    }
+    struct t_list *expr_list = NULL;
+    if (argc > 2 &&
+        strcmp(argv[2], "group") != 0)
+    {
+        expr_list = parse_filter(argv[2]);
+        if (expr_list == NULL) {
+            *error = sdscat(*error, "Failed to parse filter");
+            return ACK_ERROR_ARG;
+        }
+    }
+    rax *values = raxNew();
+    for (unsigned i = 0; i < library->config.songs; i++) {
+        const struct mpd_song *song = library->songs[i];
+        if (expr_list != NULL &&
+            search_expression_song(song, expr_list, &client->server->any_tags) == false)
+        {
+            continue;
+        }
+        const char *value;
+        unsigned idx = 0;
+        while ((value = mpd_song_get_tag(song, tag, idx)) != NULL) {
+            raxInsert(values, (unsigned char *)value, strlen(value), NULL, NULL);
+            idx++;
+        }
+    }
+    raxIterator iter;
+    raxStart(&iter, values);
+    raxSeek(&iter, "^", NULL, 0);
+    while (raxNext(&iter)) {
+        *buffer = sdscatfmt(*buffer, "%s: ", mpd_tag_name(tag));
+        *buffer = sdscatlen(*buffer, iter.key, iter.key_len);
+        *buffer = sdscatlen(*buffer, "\n", 1);
+    }
+    raxStop(&iter);
+    raxFree(values);
+    if (expr_list != NULL) {
+        search_expression_free(expr_list);
+    }
+    return ACK_OK;
+}
+
+/**
+ * Lists the uris of a stored playlist
+ */
+static enum fake_mpd_ack cmd_listplaylist(struct t_fake_mpd_client *client, int argc, sds *argv, sds *buffer, sds *error) {
+    if (argc < 2) {
+        *error = sdscat(*error, "too few arguments");
+        return ACK_ERROR_ARG;
+    }
+    struct t_list *entries = bench_library_get_playlist(client->server->library, argv[1], false);
+    if (entries == NULL) {
+        *error = sdscat(*error, "No such playlist");
+        return ACK_ERROR_NO_EXIST;
+    }
+    unsigned start = 0;
+    unsigned end = UINT_MAX;
+    if (argc > 2) {
+        enum fake_mpd_ack rc = parse_range(argv[2], &start, &end, error);
+        if (rc != ACK_OK) {
+            return rc;
+        }
+    }
+    unsigned pos = 0;
+    for (struct t_list_node *current = entries->head; current != NULL && pos < end; current = current->next, pos++) {
+        if (pos >= start) {
+            *buffer = sdscatfmt(*buffer, "file: %s\n", current->key);
+        }
+    }
+    return ACK_OK;
+}
+
+/**
+ * Lists the songs of a stored playlist
+ */
+static enum fake_mpd_ack cmd_listplaylistinfo(struct t_fake_mpd_client *client, int argc, sds *argv, sds *buffer, sds *error) {
+    if (argc < 2) {
+        *error = sdscat(*error, "too few arguments");
+        return ACK_ERROR_ARG;
+    }
+    struct t_list *entries = bench_library_get_playlist(client->server->library, argv[1], false);
+    if (entries == NULL) {
+        *error = sdscat(*error, "No such playlist");
+        return ACK_ERROR_NO_EXIST;
+    }
+    unsigned start = 0;
+    unsigned end = UINT_MAX;
+    if (argc > 2) {
+        enum fake_mpd_ack rc = parse_range(argv[2], &start, &end, error);
+        if (rc != ACK_OK) {
+            return rc;
+        }
+    }
+    unsigned pos = 0;
+    for (struct t_list_node *current = entries->head; current != NULL && pos < end; current = current->next, pos++) {
+        if (pos < start) {
+            continue;
+        }
+        struct mpd_song *song = bench_library_get_song(client->server->library, current->key);
+        if (song != NULL) {
+            *buffer = print_song(*buffer, client, song);
+        }
+        else {
+            *buffer = sdscatfmt(*buffer, "file: %s\n", current->key);
+        }
+        *buffer = sdscatfmt(*buffer, "Pos: %u\n", pos);
+    }
+    return ACK_OK;
+}
+
+/**
+ * Lists the stored playlists
+ */
+static enum fake_mpd_ack cmd_listplaylists(struct t_fake_mpd_client *client, int argc, sds *argv, sds *buffer, sds *error) {
+    (void)argc;
+    (void)argv;
+    (void)error;
+    for (struct t_list_node *current = client->server->library->playlists.head; current != NULL; current = current->next) {
+        *buffer = sdscatfmt(*buffer, "playlist: %s\n", current->key);
+        *buffer = print_time(*buffer, "Last-Modified", (time_t)current->value_i);
+    }
+    return ACK_OK;
+}
+
+/**
+ * Commands without response
+ */
+static enum fake_mpd_ack cmd_ok(struct t_fake_mpd_client *client, int argc, sds *argv, sds *buffer, sds *error) {
+    (void)client;
+    (void)argc;
+    (void)argv;
+    (void)buffer;
+    (void)error;
+    return ACK_OK;
+}
+
+/**
+ * Appends an uri to a stored playlist, the playlist is created if it does not exist
+ */
+static enum fake_mpd_ack cmd_playlistadd(struct t_fake_mpd_client *client, int argc, sds *argv, sds *buffer, sds *error) {
+    (void)buffer;
+    if (argc < 3) {
+        *error = sdscat(*error, "too few arguments");
+        return ACK_ERROR_ARG;
+    }
+    if (bench_library_get_song(client->server->library, argv[2]) == NULL) {
+        *error = sdscat(*error, "No such song");
+        return ACK_ERROR_NO_EXIST;
+    }
+    struct t_list *entries = bench_library_get_playlist(client->server->library, argv[1], true);
+    list_push(entries, argv[2], 0, NULL, NULL);
+    return ACK_OK;
+}
+
+/**
+ * Clears a stored playlist, the playlist is created if it does not exist
+ */
+static enum fake_mpd_ack cmd_playlistclear(struct t_fake_mpd_client *client, int argc, sds *argv, sds *buffer, sds *error) {
+    (void)buffer;
+    if (argc != 2) {
+        *error = sdscat(*error, "wrong number of arguments");
+        return ACK_ERROR_ARG;
+    }
+    struct t_list *entries = bench_library_get_playlist(client->server->library, argv[1], true);
+    list_clear(entries);
+    return ACK_OK;
+}
+
+/**
+ * Lists the songs of the queue
+ */
+static enum fake_mpd_ack cmd_playlistinfo(struct t_fake_mpd_client *client, int argc, sds *argv, sds *buffer, sds *error) {
+    unsigned start = 0;
+    unsigned end = UINT_MAX;
+    if (argc > 1) {
+        enum fake_mpd_ack rc = parse_range(argv[1], &start, &end, error);
+        if (rc != ACK_OK) {
+            return rc;
+        }
+    }
+    unsigned pos = 0;
+    struct t_list_node *current = client->server->library->queue.head;
+    for (; current != NULL && pos < end; current = current->next, pos++) {
+        if (pos < start) {
+            continue;
+        }
+        struct mpd_song *song = bench_library_get_song(client->server->library, current->key);
+        *buffer = print_song(*buffer, client, song);
+        *buffer = sdscatfmt(*buffer, "Pos: %u\nId: %u\n", pos, pos + 1);
+    }
+    return ACK_OK;
+}
+
+/**
+ * Prints the length of a stored playlist
+ */
+static enum fake_mpd_ack cmd_playlistlength(struct t_fake_mpd_client *client, int argc, sds *argv, sds *buffer, sds *error) {
+    if (argc != 2) {
+        *error = sdscat(*error, "wrong number of arguments");
+        return ACK_ERROR_ARG;
+    }
+    struct t_list *entries = bench_library_get_playlist(client->server->library, argv[1], false);
+    if (entries == NULL) {
+        *error = sdscat(*error, "No such playlist");
+        return ACK_ERROR_NO_EXIST;
+    }
+    unsigned playtime = 0;
+    for (struct t_list_node *current = entries->head; current != NULL; current = current->next) {
+        struct mpd_song *song = bench_library_get_song(client->server->library, current->key);
+        if (song != NULL) {
+            playtime += mpd_song_get_duration(song);
+        }
+    }
+    *buffer = sdscatfmt(*buffer, "songs: %u\nplaytime: %u\n", entries->length, playtime);
+    return ACK_OK;
+}
+
+/**
+ * The synthetic songs have no embedded pictures
+ */
+static enum fake_mpd_ack cmd_readpicture(struct t_fake_mpd_client *client, int argc, sds *argv, sds *buffer, sds *error) {
+    (void)client;
+    (void)argc;
+    (void)argv;
+    (void)buffer;
+    (void)error;
+    return ACK_OK;
+}
+
+/**
+ * Removes a stored playlist
+ */
+static enum fake_mpd_ack cmd_rm(struct t_fake_mpd_client *client, int argc, sds *argv, sds *buffer, sds *error) {
+    (void)buffer;
+    if (argc != 2) {
+        *error = sdscat(*error, "wrong number of arguments");
+        return ACK_ERROR_ARG;
+    }
+    struct t_list *playlists = &client->server->library->playlists;
+    struct t_list_node *node = list_get_node(playlists, argv[1]);
+    if (node == NULL) {
+        *error = sdscat(*error, "No such playlist");
+        return ACK_ERROR_NO_EXIST;
+    }
+    list_free((struct t_list *)node->user_data);
+    node->user_data = NULL;
+    list_remove_node_by_key_user_data(playlists, argv[1], NULL);
+    return ACK_OK;
+}
+
+/**
+ * Saves the queue as stored playlist
+ */
+static enum fake_mpd_ack cmd_save(struct t_fake_mpd_client *client, int argc, sds *argv, sds *buffer, sds *error) {
+    (void)buffer;
+    if (argc < 2) {
+        *error = sdscat(*error, "too few arguments");
+        return ACK_ERROR_ARG;
+    }
+    struct t_list *entries = bench_library_get_playlist(client->server->library, argv[1], true);
+    list_clear(entries);
+    for (struct t_list_node *current = client->server->library->queue.head; current != NULL; current = current->next) {
+        list_push(entries, current->key, 0, NULL, NULL);
+    }
+    return ACK_OK;
+}
+
+/**
+ * Searches the database, find is handled as search
+ */
+static enum fake_mpd_ack cmd_search(struct t_fake_mpd_client *client, int argc, sds *argv, sds *buffer, sds *error) {
+    struct t_fake_mpd_search search;
+    enum fake_mpd_ack rc = parse_search(argc, argv, 1, &search, error);
+    if (rc != ACK_OK) {
+        return rc;
+    }
+    unsigned len;
+    struct mpd_song **songs = select_songs(client, NULL, &search, &len);
+    for (unsigned i = 0; i < len; i++) {
+        *buffer = print_song(*buffer, client, songs[i]);
+    }
+    FREE_PTR(songs);
+    search_expression_free(search.expr_list);
+    return ACK_OK;
+}
+
+/**
+ * Searches the database and appends the songs to a stored playlist
+ */
+static enum fake_mpd_ack cmd_searchaddpl(struct t_fake_mpd_client *client, int argc, sds *argv, sds *buffer, sds *error) {
+    (void)buffer;
+    struct t_fake_mpd_search search;
+    enum fake_mpd_ack rc = parse_search(argc, argv, 2, &search, error);
+    if (rc != ACK_OK) {
+        return rc;
+    }
+    unsigned len;
+    struct mpd_song **songs = select_songs(client, NULL, &search, &len);
+    struct t_list *entries = bench_library_get_playlist(client->server->library, argv[1], true);
+    for (unsigned i = 0; i < len; i++) {
+        list_push(entries, mpd_song_get_uri(songs[i]), 0, NULL, NULL);
+    }
+    FREE_PTR(songs);
+    search_expression_free(search.expr_list);
+    return ACK_OK;
+}
+
+/**
+ * Searches a stored playlist
+ */
+static enum fake_mpd_ack cmd_searchplaylist(struct t_fake_mpd_client *client, int argc, sds *argv, sds *buffer, sds *error) {
+    if (argc < 3) {
+        *error = sdscat(*error, "too few arguments");
+        return ACK_ERROR_ARG;
+    }
+    struct t_list *entries = bench_library_get_playlist(client->server->library, argv[1], false);
+    if (entries == NULL) {
+        *error = sdscat(*error, "No such playlist");
+        return ACK_ERROR_NO_EXIST;
+    }
+    struct t_fake_mpd_search search;
+    enum fake_mpd_ack rc = parse_search(argc, argv, 2, &search, error);
+    if (rc != ACK_OK) {
+        return rc;
+    }
+    unsigned len;
+    struct mpd_song **songs = select_songs(client, entries, &search, &len);
+    for (unsigned i = 0; i < len; i++) {
+        *buffer = print_song(*buffer, client, songs[i]);
+    }
+    FREE_PTR(songs);
+    search_expression_free(search.expr_list);
+    return ACK_OK;
+}
+
+/**
+ * Prints the database statistics
+ */
+static enum fake_mpd_ack cmd_stats(struct t_fake_mpd_client *client, int argc, sds *argv, sds *buffer, sds *error) {
+    (void)argc;
+    (void)argv;
+    (void)error;
+    struct t_bench_library *library = client->server->library;
+    *buffer = sdscatfmt(*buffer, "artists: %u\nalbums: %u\nsongs: %u\nuptime: 1\nplaytime: 0\ndb_playtime: %u\ndb_update: %I\n",
+        library->config.artists, library->config.albums, library->config.songs,
+        library->config.songs * 270, (int64_t)library->db_update);
+    return ACK_OK;
+}
+
+/**
+ * Prints the player status
+ */
+static enum fake_mpd_ack cmd_status(struct t_fake_mpd_client *client, int argc, sds *argv, sds *buffer, sds *error) {
+    (void)argc;
+    (void)argv;
+    (void)error;
+    *buffer = sdscatfmt(*buffer, "volume: 100\nrepeat: 0\nrandom: 0\nsingle: 0\nconsume: 0\nplaylist: 1\nplaylistlength: %u\nstate: stop\n",
+        client->server->library->queue.length);
+    return ACK_OK;
+}
+
+/**
+ * Implements the sticker get, set, delete, list and find commands for songs
+ */
+static enum fake_mpd_ack cmd_sticker(struct t_fake_mpd_client *client, int argc, sds *argv, sds *buffer, sds *error) {
+    struct t_bench_library *library = client->server->library;
+    if (argc < 4) {
+        *error = sdscat(*error, "too few arguments");
+        return ACK_ERROR_ARG;
+    }
+    if (strcmp(argv[2], "song") != 0) {
+        // only song stickers are generated
+        if (strcmp(argv[1], "get") == 0) {
+            *error = sdscat(*error, "no such sticker");
+            return ACK_ERROR_NO_EXIST;
+        }
+        return ACK_OK;
+    }
+    const char *uri = argv[3];
+    struct t_list *stickers = bench_library_get_stickers(library, uri);
+    if (strcmp(argv[1], "list") == 0) {
+        if (stickers != NULL) {
+            for (struct t_list_node *current = stickers->head; current != NULL; current = current->next) {
+                *buffer = sdscatfmt(*buffer, "sticker: %s=%s\n", current->key, current->value_p);
+            }
+        }
+        return ACK_OK;
+    }
+    if (strcmp(argv[1], "get") == 0) {
+        struct t_list_node *node = argc > 4 && stickers != NULL
+            ? list_get_node(stickers, argv[4])
+            : NULL;
+        if (node == NULL) {
+            *error = sdscat(*error, "no such sticker");
+            return ACK_ERROR_NO_EXIST;
+        }
+        *buffer = sdscatfmt(*buffer, "sticker: %s=%s\n", node->key, node->value_p);
+        return ACK_OK;
+    }
+    if (strcmp(argv[1], "set") == 0) {
+        if (argc != 6) {
+            *error = sdscat(*error, "wrong number of arguments");
+            return ACK_ERROR_ARG;
+        }
+        if (stickers == NULL) {
+            stickers = list_new();
+            raxInsert(library->stickers, (unsigned char *)uri, strlen(uri), stickers, NULL);
+        }
+        struct t_list_node *node = list_get_node(stickers, argv[4]);
+        if (node != NULL) {
+            node->value_p = sds_replace(node->value_p, argv[5]);
+        }
+        else {
+            list_push(stickers, argv[4], 0, argv[5], NULL);
+        }
+        return ACK_OK;
+    }
+    if (strcmp(argv[1], "delete") == 0) {
+        if (stickers != NULL) {
+            if (argc > 4) {
+                list_remove_node_by_key(stickers, argv[4]);
+            }
+            else {
+                list_clear(stickers);
+            }
+        }
+        return ACK_OK;
+    }
+    if (strcmp(argv[1], "find") != 0 ||
+        argc < 5)
+    {
+        *error = sdscat(*error, "bad request");
+        return ACK_ERROR_ARG;
+    }
+    // sticker find song {base} {name} [{op} {value}] [sort {sort}] [window {start:end}]
+    const char *base = argv[3];
+    size_t base_len = strlen(base);
+    const char *name = argv[4];
+    const char *op = NULL;
+    const char *value = NULL;
+    const char *sort = NULL;
+    unsigned start = 0;
+    unsigned end = UINT_MAX;
+    for (int i = 5; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "sort") == 0) {
+            sort = argv[i + 1];
+        }
+        else if (strcmp(argv[i], "window") == 0) {
+            enum fake_mpd_ack rc = parse_range(argv[i + 1], &start, &end, error);
+            if (rc != ACK_OK) {
+                return rc;
+            }
+        }
+        else {
+            op = argv[i];
+            value = argv[i + 1];
+        }
+    }
+    struct t_fake_mpd_sticker *matches = malloc_assert((library->stickers->numele + 1) * sizeof(struct t_fake_mpd_sticker));
+    unsigned count = 0;
+    raxIterator iter;
+    raxStart(&iter, library->stickers);
+    raxSeek(&iter, ">=", (unsigned char *)base, base_len);
+    while (raxNext(&iter)) {
+        if (iter.key_len < base_len ||
+            memcmp(iter.key, base, base_len) != 0)
+        {
+            break;
+        }
+        struct t_list_node *node = list_get_node((struct t_list *)iter.data, name);
+        if (node == NULL) {
+            continue;
+        }
+        if (op != NULL) {
+            int match = sticker_match(node->value_p, op, value);
+            if (match == -1) {
+                raxStop(&iter);
+                FREE_PTR(matches);
+                *error = sdscatfmt(*error, "bad operator \"%s\"", op);
+                return ACK_ERROR_ARG;
+            }
+            if (match == 0) {
+                continue;
+            }
+        }
+        // the iterator key is not persistent, use the uri of the song in the library
+        void *song;
+        if (raxFind(library->uris, iter.key, iter.key_len, &song) == 0) {
+            continue;
+        }
+        matches[count].uri = mpd_song_get_uri((struct mpd_song *)song);
+        matches[count].value = node->value_p;
+        count++;
+    }
+    raxStop(&iter);
+    if (sort != NULL) {
+        sort_by = sort;
+        qsort(matches, count, sizeof(struct t_fake_mpd_sticker), sticker_cmp);
+    }
+    for (unsigned i = start; i < count && i < end; i++) {
+        *buffer = sdscatfmt(*buffer, "file: %s\nsticker: %s=%s\n", matches[i].uri, name, matches[i].value);
+    }
+    FREE_PTR(matches);
+    return ACK_OK;
+}
+
+/**
+ * Lists the sticker names
+ */
+static enum fake_mpd_ack cmd_stickernamestypes(struct t_fake_mpd_client *client, int argc, sds *argv, sds *buffer, sds *error) {
+    (void)error;
+    if (argc > 1 &&
+        strcmp(argv[1], "song") != 0)
+    {
+        return ACK_OK;
+    }
+    rax *names = raxNew();
+    raxIterator iter;
+    raxStart(&iter, client->server->library->stickers);
+    raxSeek(&iter, "^", NULL, 0);
+    while (raxNext(&iter)) {
+        for (struct t_list_node *current = ((struct t_list *)iter.data)->head; current != NULL; current = current->next) {
+            raxInsert(names, (unsigned char *)current->key, sdslen(current->key), NULL, NULL);
+        }
+    }
+    raxStop(&iter);
+    raxStart(&iter, names);
+    raxSeek(&iter, "^", NULL, 0);
+    while (raxNext(&iter)) {
+        *buffer = sdscat(*buffer, "name: ");
+        *buffer = sdscatlen(*buffer, iter.key, iter.key_len);
+        *buffer = sdscat(*buffer, "\ntype: song\n");
+    }
+    raxStop(&iter);
+    raxFree(names);
+    return ACK_OK;
+}
+
+/**
+ * Lists the sticker types
+ */
+static enum fake_mpd_ack cmd_stickertypes(struct t_fake_mpd_client *client, int argc, sds *argv, sds *buffer, sds *error) {
+    (void)client;
+    (void)argc;
+    (void)argv;
+    (void)error;
+    *buffer = sdscat(*buffer, "stickertype: song\n");
+    return ACK_OK;
+}
+
+/**
+ * Lists and sets the tag types of the client
+ */
+static enum fake_mpd_ack cmd_tagtypes(struct t_fake_mpd_client *client, int argc, sds *argv, sds *buffer, sds *error) {
+    if (argc == 1 ||
+        strcmp(argv[1], "available") == 0)
+    {
+        bool available = argc > 1;
+        for (int i = 0; i < MPD_TAG_COUNT; i++) {
+            if (available == true ||
+                client->tags[i] == true)
+            {
+                *buffer = sdscatfmt(*buffer, "tagtype: %s\n", mpd_tag_name((enum mpd_tag_type)i));
+            }
+        }
+        return ACK_OK;
+    }
+    bool enable;
+    if (strcmp(argv[1], "clear") == 0 ||
+        strcmp(argv[1], "all") == 0)
+    {
+        enable = argv[1][0] == 'a';
+        for (int i = 0; i < MPD_TAG_COUNT; i++) {
+            client->tags[i] = enable;
+        }
+        return ACK_OK;
+    }
+    if (strcmp(argv[1], "reset") == 0) {
+        for (int i = 0; i < MPD_TAG_COUNT; i++) {
+            client->tags[i] = false;
+        }
+        enable = true;
+    }
+    else if (strcmp(argv[1], "enable") == 0 ||
+             strcmp(argv[1], "disable") == 0)
+    {
+        enable = argv[1][0] == 'e';
+    }
+    else {
+        *error = sdscatfmt(*error, "Unknown sub command \"%S\"", argv[1]);
+        return ACK_ERROR_ARG;
+    }
+    for (int i = 2; i < argc; i++) {
+        enum mpd_tag_type tag = mpd_tag_name_iparse(argv[i]);
+        if (tag == MPD_TAG_UNKNOWN) {
+            *error = sdscatfmt(*error, "Unknown tag type: %S", argv[i]);
+            return ACK_ERROR_ARG;
+        }
+        client->tags[tag] = enable;
+    }
+    return ACK_OK;
+}
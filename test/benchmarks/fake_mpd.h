@@ -0,0 +1,40 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2026 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+/*! \file
+ * \brief In-process fake MPD server for the benchmarks
+ */
+
+#ifndef BENCH_FAKE_MPD_H
+#define BENCH_FAKE_MPD_H
+
+#include "dist/sds/sds.h"
+#include "library.h"
+#include "src/lib/fields.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Fake MPD server listening on a unix socket
+ */
+struct t_fake_mpd {
+    struct t_bench_library *library;  //!< the library to serve
+    sds socket_path;                  //!< path of the unix socket
+    int listen_fd;                    //!< listening socket
+    pthread_t accept_thread;          //!< thread accepting the connections
+    pthread_mutex_t mutex;            //!< serializes the command execution and the client count
+    pthread_cond_t clients_done;      //!< signaled if the last client disconnects
+    unsigned clients;                 //!< number of connected clients
+    _Atomic uint64_t commands;        //!< number of executed commands
+    struct t_mympd_mpd_tags any_tags; //!< tags for the "any" filter
+};
+
+bool fake_mpd_start(struct t_fake_mpd *server, struct t_bench_library *library, const char *socket_path);
+void fake_mpd_stop(struct t_fake_mpd *server);
+
+#endif
@@ -0,0 +1,249 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2026 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+/*! \file
+ * \brief Synthetic music library for the benchmarks
+ */
+
+#include "compile_time.h"
+#include "library.h"
+
+#include "src/lib/mem.h"
+#include "src/lib/sds/sds_extras.h"
+
+#include <inttypes.h>
+#include <string.h>
+
+/**
+ * Private definitions
+ */
+
+static struct mpd_song *new_song(struct t_bench_library *library, unsigned idx, unsigned album, unsigned track);
+static void song_feed(struct mpd_song *song, const char *name, const char *value);
+static void add_stickers(struct t_bench_library *library, const char *uri, unsigned idx);
+static void free_cb_list_user_data(struct t_list_node *current);
+
+/**
+ * Public functions
+ */
+
+/**
+ * Generates the synthetic library.
+ * The songs are evenly distributed to the albums, the albums to the artists and genres.
+ * @param library pointer to the library to populate
+ * @param config size of the library
+ */
+void bench_library_init(struct t_bench_library *library, const struct t_bench_library_config *config) {
+    library->config = *config;
+    library->db_update = 1700000000;
+    library->songs = malloc_assert(config->songs * sizeof(struct mpd_song *));
+    library->uris = raxNew();
+    library->stickers = raxNew();
+    list_init(&library->playlists);
+    list_init(&library->queue);
+
+    unsigned album = 0;
+    unsigned album_start = 0;
+    for (unsigned i = 0; i < config->songs; i++) {
+        unsigned song_album = (unsigned)((uint64_t)i * config->albums / config->songs);
+        if (song_album != album) {
+            album = song_album;
+            album_start = i;
+        }
+        struct mpd_song *song = new_song(library, i, album, i - album_start + 1);
+        const char *uri = mpd_song_get_uri(song);
+        library->songs[i] = song;
+        raxInsert(library->uris, (unsigned char *)uri, strlen(uri), song, NULL);
+        if (i % 100 < config->stickers) {
+            add_stickers(library, uri, i);
+        }
+    }
+
+    sds name = sdsempty();
+    for (unsigned i = 0; i < config->playlists; i++) {
+        struct t_list *entries = list_new();
+        for (unsigned j = 0; j < config->playlist_len; j++) {
+            unsigned idx = (i * 7919 + j * 31) % config->songs;
+            list_push(entries, mpd_song_get_uri(library->songs[idx]), 0, NULL, NULL);
+        }
+        sdsclear(name);
+        name = sdscatfmt(name, "Playlist %u", i);
+        list_push(&library->playlists, name, library->db_update, NULL, entries);
+    }
+    FREE_SDS(name);
+
+    for (unsigned i = 0; i < config->queue_len; i++) {
+        unsigned idx = (i * 13) % config->songs;
+        list_push(&library->queue, mpd_song_get_uri(library->songs[idx]), 0, NULL, NULL);
+    }
+
+    library->albumart = sdsempty();
+    library->albumart = sdsMakeRoomFor(library->albumart, config->albumart_size);
+    for (unsigned i = 0; i < config->albumart_size; i++) {
+        library->albumart[i] = (char)(i % 251);
+    }
+    sdssetlen(library->albumart, config->albumart_size);
+}
+
+/**
+ * Frees the synthetic library
+ * @param library pointer to the library
+ */
+void bench_library_clear(struct t_bench_library *library) {
+    for (unsigned i = 0; i < library->config.songs; i++) {
+        mpd_song_free(library->songs[i]);
+    }
+    FREE_PTR(library->songs);
+    raxFree(library->uris);
+    raxFreeWithCallback(library->stickers, list_free_void);
+    list_clear_user_data(&library->playlists, free_cb_list_user_data);
+    list_clear(&library->queue);
+    FREE_SDS(library->albumart);
+}
+
+/**
+ * Looks up a song by uri
+ * @param library pointer to the library
+ * @param uri song uri
+ * @return the song or NULL if not found
+ */
+struct mpd_song *bench_library_get_song(struct t_bench_library *library, const char *uri) {
+    void *data;
+    if (raxFind(library->uris, (unsigned char *)uri, strlen(uri), &data) == 1) {
+        return (struct mpd_song *)data;
+    }
+    return NULL;
+}
+
+/**
+ * Looks up the stickers of a song
+ * @param library pointer to the library
+ * @param uri song uri
+ * @return list of sticker name/value pairs or NULL if the song has no stickers
+ */
+struct t_list *bench_library_get_stickers(struct t_bench_library *library, const char *uri) {
+    void *data;
+    if (raxFind(library->stickers, (unsigned char *)uri, strlen(uri), &data) == 1) {
+        return (struct t_list *)data;
+    }
+    return NULL;
+}
+
+/**
+ * Looks up a stored playlist
+ * @param library pointer to the library
+ * @param name playlist name
+ * @param create true = create the playlist if it does not exist
+ * @return list of uris or NULL if the playlist does not exist
+ */
+struct t_list *bench_library_get_playlist(struct t_bench_library *library, const char *name, bool create) {
+    struct t_list_node *node = list_get_node(&library->playlists, name);
+    if (node != NULL) {
+        return (struct t_list *)node->user_data;
+    }
+    if (create == false) {
+        return NULL;
+    }
+    struct t_list *entries = list_new();
+    list_push(&library->playlists, name, library->db_update, NULL, entries);
+    return entries;
+}
+
+/**
+ * Private functions
+ */
+
+/**
+ * Creates a song with the same pairs MPD sends
+ * @param library pointer to the library
+ * @param idx index of the song
+ * @param album index of the album
+ * @param track track number in the album
+ * @return newly allocated song
+ */
+static struct mpd_song *new_song(struct t_bench_library *library, unsigned idx, unsigned album, unsigned track) {
+    unsigned artist = album % library->config.artists;
+    sds value = sdscatfmt(sdsempty(), "Artist %u/Album %u/%u - Title %u.flac", artist, album, track, idx);
+    struct mpd_pair pair = { "file", value };
+    struct mpd_song *song = mpd_song_begin(&pair);
+
+    sdsclear(value);
+    value = sdscatfmt(value, "Artist %u", artist);
+    song_feed(song, "Artist", value);
+    song_feed(song, "AlbumArtist", value);
+    sdsclear(value);
+    value = sdscatfmt(value, "Album %u", album);
+    song_feed(song, "Album", value);
+    sdsclear(value);
+    value = sdscatfmt(value, "Title %u", idx);
+    song_feed(song, "Title", value);
+    sdsclear(value);
+    value = sdscatfmt(value, "%u", track);
+    song_feed(song, "Track", value);
+    song_feed(song, "Disc", "1");
+    sdsclear(value);
+    value = sdscatfmt(value, "Genre %u", album % library->config.genres);
+    song_feed(song, "Genre", value);
+    sdsclear(value);
+    value = sdscatfmt(value, "%u", 1960 + album % 60);
+    song_feed(song, "Date", value);
+    sdsclear(value);
+    value = sdscatfmt(value, "%u", 120 + (idx * 37) % 300);
+    song_feed(song, "duration", value);
+
+    // the newest songs are at the end of the database
+    char fmt_time[32];
+    time_t mtime = library->db_update - (time_t)(library->config.songs - idx);
+    struct tm tm;
+    gmtime_r(&mtime, &tm);
+    strftime(fmt_time, sizeof(fmt_time), "%Y-%m-%dT%H:%M:%SZ", &tm);
+    song_feed(song, "Last-Modified", fmt_time);
+    song_feed(song, "Added", fmt_time);
+    FREE_SDS(value);
+    return song;
+}
+
+/**
+ * Feeds a name/value pair to the song
+ * @param song the song
+ * @param name pair name
+ * @param value pair value
+ */
+static void song_feed(struct mpd_song *song, const char *name, const char *value) {
+    struct mpd_pair pair = { name, value };
+    mpd_song_feed(song, &pair);
+}
+
+/**
+ * Adds the myMPD stickers for a song
+ * @param library pointer to the library
+ * @param uri song uri
+ * @param idx index of the song
+ */
+static void add_stickers(struct t_bench_library *library, const char *uri, unsigned idx) {
+    struct t_list *stickers = list_new();
+    sds value = sdscatfmt(sdsempty(), "%u", idx % 20);
+    list_push(stickers, "playCount", 0, value, NULL);
+    sdsclear(value);
+    value = sdscatfmt(value, "%I", (int64_t)library->db_update - (int64_t)idx * 60);
+    list_push(stickers, "lastPlayed", 0, value, NULL);
+    sdsclear(value);
+    value = sdscatfmt(value, "%u", idx % 3);
+    list_push(stickers, "like", 0, value, NULL);
+    sdsclear(value);
+    value = sdscatfmt(value, "%u", idx % 11);
+    list_push(stickers, "rating", 0, value, NULL);
+    FREE_SDS(value);
+    raxInsert(library->stickers, (unsigned char *)uri, strlen(uri), stickers, NULL);
+}
+
+/**
+ * Frees the playlist entries saved as user_data
+ * @param current list node
+ */
+static void free_cb_list_user_data(struct t_list_node *current) {
+    list_free((struct t_list *)current->user_data);
+}
@@ -0,0 +1,57 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2026 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+/*! \file
+ * \brief Synthetic music library for the benchmarks
+ */
+
+#ifndef BENCH_LIBRARY_H
+#define BENCH_LIBRARY_H
+
+#include "dist/rax/rax.h"
+#include "dist/sds/sds.h"
+#include "src/lib/list/list.h"
+#include "src/lib/mpdclient.h"
+
+#include <stdbool.h>
+#include <time.h>
+
+/**
+ * Size of the synthetic library
+ */
+struct t_bench_library_config {
+    unsigned songs;         //!< number of songs
+    unsigned albums;        //!< number of albums, the songs are evenly distributed
+    unsigned artists;       //!< number of album artists
+    unsigned genres;        //!< number of genres
+    unsigned stickers;      //!< percentage of songs with stickers
+    unsigned playlists;     //!< number of stored playlists
+    unsigned playlist_len;  //!< number of songs per stored playlist
+    unsigned queue_len;     //!< number of songs in the queue
+    unsigned albumart_size; //!< size of the albumart in bytes
+};
+
+/**
+ * Synthetic library served by the fake MPD server
+ */
+struct t_bench_library {
+    struct t_bench_library_config config;  //!< library size
+    struct mpd_song **songs;               //!< songs in database order
+    rax *uris;                             //!< uri to song
+    rax *stickers;                         //!< uri to struct t_list of sticker name/value pairs
+    struct t_list playlists;               //!< stored playlists, user_data is a struct t_list of uris
+    struct t_list queue;                   //!< uris of the queue
+    sds albumart;                          //!< albumart returned for all songs
+    time_t db_update;                      //!< database update time
+};
+
+void bench_library_init(struct t_bench_library *library, const struct t_bench_library_config *config);
+void bench_library_clear(struct t_bench_library *library);
+struct mpd_song *bench_library_get_song(struct t_bench_library *library, const char *uri);
+struct t_list *bench_library_get_stickers(struct t_bench_library *library, const char *uri);
+struct t_list *bench_library_get_playlist(struct t_bench_library *library, const char *name, bool create);
+
+#endif
@@ -0,0 +1,663 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2026 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+/*! \file
+ * \brief Benchmarks for the MPD facing code paths.
+ * The real myMPD functions are driven against an in-process fake MPD server
+ * serving a synthetic library. The in-process cases from micro.c follow them.
+ * The results are printed as JSON to stdout, the log is redirected to stderr.
+ */
+
+#include "compile_time.h"
+#include "bench.h"
+#include "micro.h"
+
+#include "src/lib/api.h"
+#include "src/lib/cache/cache_rax_album.h"
+#include "src/lib/config/config.h"
+#include "src/lib/config/mympd_state.h"
+#include "src/lib/json/json_print.h"
+#include "src/lib/log.h"
+#include "src/lib/mem.h"
+#include "src/lib/msg_queue.h"
+#include "src/lib/sds/sds_extras.h"
+#include "src/lib/smartpls.h"
+#include "src/mympd_api/albumart.h"
+#include "src/mympd_api/albums.h"
+#include "src/mympd_api/queue.h"
+#include "src/mympd_client/connection.h"
+#include "src/mympd_client/features.h"
+#include "src/mympd_client/queue.h"
+#include "src/mympd_client/stickerdb.h"
+#include "src/mympd_worker/album_cache.h"
+#include "src/mympd_worker/jukebox.h"
+#include "src/mympd_worker/smartpls.h"
+#include "src/mympd_worker/state.h"
+
+#include <errno.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * Private definitions
+ */
+
+static bool bench_album_cache_create(struct t_bench_env *env, unsigned iteration, uint64_t *items);
+static bool bench_album_list(struct t_bench_env *env, unsigned iteration, uint64_t *items);
+static bool bench_jukebox_fill(struct t_bench_env *env, unsigned iteration, uint64_t *items);
+static bool bench_smartpls_update(struct t_bench_env *env, unsigned iteration, uint64_t *items);
+static bool bench_queue_list_stickers(struct t_bench_env *env, unsigned iteration, uint64_t *items);
+static bool bench_albumart(struct t_bench_env *env, unsigned iteration, uint64_t *items);
+
+/**
+ * The bench cases, the album cache creation must be the first one
+ */
+static const struct t_bench_case bench_cases[] = {
+    { "album_cache_create", bench_album_cache_create, NULL, true },
+    { "album_list", bench_album_list, NULL, false },
+    { "jukebox_fill", bench_jukebox_fill, NULL, false },
+    { "smartpls_update", bench_smartpls_update, NULL, false },
+    { "queue_list_stickers", bench_queue_list_stickers, NULL, false },
+    { "albumart", bench_albumart, NULL, false },
+    { NULL, NULL, NULL, false }
+};
+
+static bool parse_options(int argc, char **argv, struct t_bench_options *options);
+static bool create_workdir(const char *workdir);
+static sds run_case(struct t_bench_env *env, const struct t_bench_case *bench_case, sds buffer, bool *rc);
+static void drain_queues(struct t_mympd_state *mympd_state);
+static void free_webserver_settings(struct set_mg_user_data_request *settings);
+static double elapsed_ms(const struct timespec *start, const struct timespec *end);
+static int double_cmp(const void *a, const void *b);
+static double percentile(const double *sorted, unsigned len, unsigned p);
+static long peak_rss_kib(void);
+
+/**
+ * Public functions
+ */
+
+/**
+ * Main function of the benchmarks
+ * @param argc number of command line arguments
+ * @param argv command line arguments
+ * @return EXIT_SUCCESS or EXIT_FAILURE
+ */
+int main(int argc, char **argv) {
+    thread_logname = sdsnew("bench");
+    thread_logline = sdsempty();
+    log_type = LOG_TO_STDOUT;
+    set_loglevel(LOG_ERR);
+
+    struct t_bench_options options = {
+        .library = {
+            .songs = 20000,
+            .albums = 2000,
+            .artists = 500,
+            .genres = 20,
+            .stickers = 50,
+            .playlists = 20,
+            .playlist_len = 200,
+            .queue_len = 1000,
+            .albumart_size = 100000
+        },
+        .iterations = 50,
+        .cache_iterations = 5,
+        .page_size = 100,
+        .workdir = "/tmp/mympd-bench"
+    };
+    if (parse_options(argc, argv, &options) == false) {
+        return EXIT_FAILURE;
+    }
+    // the results are printed to the original stdout, the log goes to stderr
+    int json_fd = dup(STDOUT_FILENO);
+    FILE *json_out = json_fd >= 0
+        ? fdopen(json_fd, "w")
+        : NULL;
+    if (json_out == NULL ||
+        dup2(STDERR_FILENO, STDOUT_FILENO) < 0 ||
+        setvbuf(stdout, NULL, _IOLBF, 0) != 0)
+    {
+        MYMPD_LOG_ERROR(NULL, "Can not redirect stdout");
+        return EXIT_FAILURE;
+    }
+    if (create_workdir(options.workdir) == false) {
+        fclose(json_out);
+        return EXIT_FAILURE;
+    }
+
+    mympd_api_queue = mympd_queue_create("mympd_api_queue", QUEUE_TYPE_REQUEST, false);
+    webserver_queue = mympd_queue_create("webserver_queue", QUEUE_TYPE_RESPONSE, false);
+
+    struct t_config *config = malloc_assert(sizeof(struct t_config));
+    mympd_config_defaults_initial(config);
+    config->workdir = sds_replace(config->workdir, options.workdir);
+    config->cachedir = sds_replace(config->cachedir, options.workdir);
+    mympd_config_read(config);
+
+    struct t_bench_library library;
+    bench_library_init(&library, &options.library);
+    struct t_fake_mpd server;
+    sds socket_path = sdscatfmt(sdsempty(), "%s/mpd.socket", options.workdir);
+    bool server_started = fake_mpd_start(&server, &library, socket_path);
+    bool rc = server_started;
+
+    struct t_mympd_state *mympd_state = malloc_assert(sizeof(struct t_mympd_state));
+    mympd_state_default(mympd_state, config);
+    mympd_state->mpd_state->mpd_host = sds_replace(mympd_state->mpd_state->mpd_host, socket_path);
+    mympd_state->stickerdb->mpd_state->mpd_host = sds_replace(mympd_state->stickerdb->mpd_state->mpd_host, socket_path);
+    FREE_SDS(socket_path);
+
+    struct t_partition_state *partition_state = mympd_state->partition_state;
+    if (rc == true) {
+        // the stickerdb connection waits in idle mode like in the mympd_api thread
+        rc = mympd_client_connect(partition_state) &&
+            stickerdb_connect(mympd_state->stickerdb) &&
+            stickerdb_enter_idle(mympd_state->stickerdb);
+    }
+    if (rc == true) {
+        mympd_client_mpd_features(mympd_state, partition_state);
+        // update the state like partitions_connect
+        mympd_client_queue_status_update(partition_state);
+        rc = partition_state->conn_state == MPD_CONNECTED;
+    }
+    drain_queues(mympd_state);
+
+    // the worker state shares the connections of the mympd_state
+    struct t_mympd_worker_state worker_state = {
+        .smartpls = true,
+        .smartpls_sort = sdsdup(mympd_state->smartpls_sort),
+        .smartpls_prefix = sdsdup(mympd_state->smartpls_prefix),
+        .partition_state = partition_state,
+        .mpd_state = mympd_state->mpd_state,
+        .config = config,
+        .request = NULL,
+        .tag_disc_empty_is_first = mympd_state->tag_disc_empty_is_first,
+        .stickerdb = mympd_state->stickerdb,
+        .mympd_only = false,
+        .album_cache = &mympd_state->album_cache,
+        .repopulate_pfds = false
+    };
+    mympd_mpd_tags_clone(&mympd_state->smartpls_generate_tag_types, &worker_state.smartpls_generate_tag_types);
+
+    struct t_bench_env env = {
+        .options = &options,
+        .library = &library,
+        .server = &server,
+        .mympd_state = mympd_state,
+        .worker_state = &worker_state
+    };
+    fields_reset(&env.tagcols);
+    env.tagcols.mpd_tags.tags[env.tagcols.mpd_tags.len++] = MPD_TAG_ARTIST;
+    env.tagcols.mpd_tags.tags[env.tagcols.mpd_tags.len++] = MPD_TAG_ALBUM;
+    env.tagcols.mpd_tags.tags[env.tagcols.mpd_tags.len++] = MPD_TAG_TITLE;
+    env.tagcols.mpd_tags.tags[env.tagcols.mpd_tags.len++] = MPD_TAG_TRACK;
+    stickers_enable_all(&env.tagcols.stickers, STICKER_TYPE_SONG);
+    list_init(&env.queue_list);
+    for (struct t_list_node *current = library.queue.head; current != NULL; current = current->next) {
+        list_push(&env.queue_list, current->key, 0, NULL, NULL);
+    }
+
+    sds buffer = sdsnewlen("{", 1);
+    buffer = sdscat(buffer, "\"library\":{");
+    buffer = tojson_uint(buffer, "songs", options.library.songs, true);
+    buffer = tojson_uint(buffer, "albums", options.library.albums, true);
+    buffer = tojson_uint(buffer, "artists", options.library.artists, true);
+    buffer = tojson_uint(buffer, "genres", options.library.genres, true);
+    buffer = tojson_uint(buffer, "stickerPercent", options.library.stickers, true);
+    buffer = tojson_uint(buffer, "playlists", options.library.playlists, true);
+    buffer = tojson_uint(buffer, "playlistLength", options.library.playlist_len, true);
+    buffer = tojson_uint(buffer, "queueLength", options.library.queue_len, true);
+    buffer = tojson_uint(buffer, "albumartSize", options.library.albumart_size, false);
+    buffer = sdscat(buffer, "},\"cases\":[");
+    if (rc == true) {
+        for (const struct t_bench_case *bench_case = bench_cases; bench_case->name != NULL; bench_case++) {
+            if (bench_case != bench_cases) {
+                buffer = sdscatlen(buffer, ",", 1);
+            }
+            buffer = run_case(&env, bench_case, buffer, &rc);
+        }
+        // in-process cases without mpd commands
+        for (const struct t_bench_case *bench_case = bench_micro_cases; bench_case->name != NULL; bench_case++) {
+            buffer = sdscatlen(buffer, ",", 1);
+            buffer = run_case(&env, bench_case, buffer, &rc);
+        }
+    }
+    else {
+        MYMPD_LOG_ERROR(NULL, "Can not connect to the fake mpd server");
+    }
+    buffer = sdscatlen(buffer, "],", 2);
+    buffer = tojson_bool(buffer, "success", rc, true);
+    buffer = tojson_int64(buffer, "peakRssKiB", peak_rss_kib(), false);
+    buffer = sdscatlen(buffer, "}\n", 2);
+    fputs(buffer, json_out);
+    fclose(json_out);
+    FREE_SDS(buffer);
+
+    // cleanup
+    bench_micro_clear();
+    list_clear(&env.queue_list);
+    FREE_SDS(worker_state.smartpls_sort);
+    FREE_SDS(worker_state.smartpls_prefix);
+    mympd_client_disconnect_silent(partition_state);
+    if (mympd_state->stickerdb->conn != NULL) {
+        stickerdb_disconnect(mympd_state->stickerdb);
+    }
+    if (server_started == true) {
+        fake_mpd_stop(&server);
+    }
+    drain_queues(mympd_state);
+    mympd_state_free(mympd_state);
+    mympd_config_free(config);
+    bench_library_clear(&library);
+    mympd_queue_free(mympd_api_queue);
+    mympd_queue_free(webserver_queue);
+    FREE_SDS(thread_logname);
+    FREE_SDS(thread_logline);
+    return rc == true
+        ? EXIT_SUCCESS
+        : EXIT_FAILURE;
+}
+
+/**
+ * Private functions
+ */
+
+/**
+ * Parses the command line options
+ * @param argc number of command line arguments
+ * @param argv command line arguments
+ * @param options pointer to the options to populate
+ * @return true on success, else false
+ */
+static bool parse_options(int argc, char **argv, struct t_bench_options *options) {
+    static const struct option long_options[] = {
+        {"songs", required_argument, 0, 's'},
+        {"albums", required_argument, 0, 'a'},
+        {"artists", required_argument, 0, 'r'},
+        {"genres", required_argument, 0, 'g'},
+        {"stickers", required_argument, 0, 'k'},
+        {"playlists", required_argument, 0, 'p'},
+        {"playlist-length", required_argument, 0, 'l'},
+        {"queue-length", required_argument, 0, 'q'},
+        {"albumart-size", required_argument, 0, 'z'},
+        {"iterations", required_argument, 0, 'i'},
+        {"cache-iterations", required_argument, 0, 'c'},
+        {"page-size", required_argument, 0, 'e'},
+        {"workdir", required_argument, 0, 'w'},
+        {"loglevel", required_argument, 0, 'o'},
+        {"help", no_argument, 0, 'h'},
+        {0, 0, 0, 0}
+    };
+    int n;
+    while ((n = getopt_long(argc, argv, "s:a:r:g:k:p:l:q:z:i:c:e:w:o:h", long_options, NULL)) != -1) {
+        unsigned value = optarg != NULL
+            ? (unsigned)strtoul(optarg, NULL, 10)
+            : 0;
+        switch (n) {
+            case 's': options->library.songs = value; break;
+            case 'a': options->library.albums = value; break;
+            case 'r': options->library.artists = value; break;
+            case 'g': options->library.genres = value; break;
+            case 'k': options->library.stickers = value; break;
+            case 'p': options->library.playlists = value; break;
+            case 'l': options->library.playlist_len = value; break;
+            case 'q': options->library.queue_len = value; break;
+            case 'z': options->library.albumart_size = value; break;
+            case 'i': options->iterations = value; break;
+            case 'c': options->cache_iterations = value; break;
+            case 'e': options->page_size = value; break;
+            case 'w': options->workdir = optarg; break;
+            case 'o': set_loglevel((int)value); break;
+            default:
+                fprintf(stderr, "Usage: %s [--songs n] [--albums n] [--artists n] [--genres n] [--stickers percent]\n"
+                    "    [--playlists n] [--playlist-length n] [--queue-length n] [--albumart-size bytes]\n"
+                    "    [--iterations n] [--cache-iterations n] [--page-size n] [--workdir dir] [--loglevel n]\n", argv[0]);
+                return false;
+        }
+    }
+    if (options->library.songs == 0 ||
+        options->library.albums == 0 ||
+        options->library.albums > options->library.songs ||
+        options->library.artists == 0 ||
+        options->library.genres == 0 ||
+        options->library.stickers > 100 ||
+        options->library.queue_len == 0 ||
+        options->iterations == 0 ||
+        options->cache_iterations == 0 ||
+        options->page_size == 0)
+    {
+        fprintf(stderr, "Invalid library size or iterations\n");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Creates the working directory with the subdirectories myMPD needs
+ * @param workdir working directory
+ * @return true on success, else false
+ */
+static bool create_workdir(const char *workdir) {
+    const char *subdirs[] = {
+        "",
+        "/" DIR_WORK_CONFIG,
+        "/" DIR_WORK_SMARTPLS,
+        "/" DIR_WORK_STATE,
+        "/" DIR_WORK_STATE_DEFAULT,
+        "/" DIR_WORK_TAGS,
+        NULL
+    };
+    sds dir = sdsempty();
+    for (const char **p = subdirs; *p != NULL; p++) {
+        sdsclear(dir);
+        dir = sdscatfmt(dir, "%s%s", workdir, *p);
+        if (mkdir(dir, 0770) != 0 &&
+            errno != EEXIST)
+        {
+            MYMPD_LOG_ERROR(NULL, "Can not create directory \"%s\"", dir);
+            MYMPD_LOG_ERRNO(NULL, errno);
+            FREE_SDS(dir);
+            return false;
+        }
+    }
+    FREE_SDS(dir);
+    return true;
+}
+
+/**
+ * Runs a bench case and prints the result
+ * @param env the bench environment
+ * @param bench_case the bench case to run
+ * @param buffer already allocated sds string to append the result
+ * @param rc set to false if an iteration has failed
+ * @return pointer to buffer
+ */
+static sds run_case(struct t_bench_env *env, const struct t_bench_case *bench_case, sds buffer, bool *rc) {
+    unsigned iterations = bench_case->cache_case == true
+        ? env->options->cache_iterations
+        : env->options->iterations;
+    double *samples = malloc_assert(iterations * sizeof(double));
+    uint64_t items = 0;
+    unsigned failed = 0;
+    uint64_t commands_start = env->server->commands;
+    double total_ms = 0;
+    for (unsigned i = 0; i < iterations; i++) {
+        if (bench_case->prepare != NULL &&
+            bench_case->prepare(env, i, &items) == false)
+        {
+            failed++;
+            samples[i] = 0;
+            continue;
+        }
+        struct timespec start;
+        struct timespec end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        bool case_rc = bench_case->cb(env, i, &items);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        samples[i] = elapsed_ms(&start, &end);
+        total_ms += samples[i];
+        if (case_rc == false) {
+            failed++;
+        }
+        drain_queues(env->mympd_state);
+    }
+    uint64_t commands = env->server->commands - commands_start;
+    qsort(samples, iterations, sizeof(double), double_cmp);
+    double total_s = total_ms / 1000;
+
+    MYMPD_LOG_NOTICE(NULL, "Bench case %s: %u iterations, %.3f ms", bench_case->name, iterations, total_ms);
+    if (failed > 0) {
+        MYMPD_LOG_ERROR(NULL, "Bench case %s: %u of %u iterations failed", bench_case->name, failed, iterations);
+        *rc = false;
+    }
+    buffer = sdscatlen(buffer, "{", 1);
+    buffer = tojson_char(buffer, "name", bench_case->name, true);
+    buffer = tojson_uint(buffer, "iterations", iterations, true);
+    buffer = tojson_uint(buffer, "failed", failed, true);
+    buffer = tojson_uint64(buffer, "items", items, true);
+    buffer = tojson_float(buffer, "opsPerSecond", (float)(iterations / total_s), true);
+    buffer = tojson_float(buffer, "itemsPerSecond", (float)((double)items / total_s), true);
+    buffer = tojson_uint64(buffer, "mpdCommands", commands, true);
+    buffer = sdscat(buffer, "\"latencyMs\":{");
+    buffer = tojson_float(buffer, "mean", (float)(total_ms / iterations), true);
+    buffer = tojson_float(buffer, "p50", (float)percentile(samples, iterations, 50), true);
+    buffer = tojson_float(buffer, "p99", (float)percentile(samples, iterations, 99), true);
+    buffer = tojson_float(buffer, "max", (float)samples[iterations - 1], false);
+    buffer = sdscat(buffer, "},");
+    buffer = tojson_int64(buffer, "peakRssKiB", peak_rss_kib(), false);
+    buffer = sdscatlen(buffer, "}", 1);
+    FREE_PTR(samples);
+    return buffer;
+}
+
+/**
+ * Processes the internal requests of the worker functions and discards the websocket notifications.
+ * A created album cache replaces the current album cache like the mympd_api thread does.
+ * @param mympd_state pointer to the myMPD state
+ */
+static void drain_queues(struct t_mympd_state *mympd_state) {
+    struct t_work_request *request;
+    while ((request = mympd_queue_shift(mympd_api_queue, -1, 0)) != NULL) {
+        if (request->cmd_id == INTERNAL_API_ALBUMCACHE_CREATED &&
+            request->extra != NULL)
+        {
+            album_cache_free(&mympd_state->album_cache);
+            struct t_cache *new_album_cache = (struct t_cache *)request->extra;
+            mympd_state->album_cache.cache = new_album_cache->cache;
+            mympd_state->album_cache.index = new_album_cache->index;
+            mympd_state->album_cache.pool = new_album_cache->pool;
+            mympd_state->album_cache.map = new_album_cache->map;
+            mympd_state->album_cache.mtime = time(NULL);
+            FREE_PTR(request->extra);
+        }
+        free_request(request);
+    }
+    struct t_work_response *response;
+    while ((response = mympd_queue_shift(webserver_queue, -1, 0)) != NULL) {
+        if (response->cmd_id == INTERNAL_API_WEBSERVER_SETTINGS &&
+            response->extra != NULL)
+        {
+            // the webserver thread consumes the settings, there is no free function for it
+            free_webserver_settings((struct set_mg_user_data_request *)response->extra);
+            response->extra = NULL;
+        }
+        free_response(response);
+    }
+}
+
+/**
+ * Frees the settings pushed to the webserver thread
+ * @param settings pointer to the settings
+ */
+static void free_webserver_settings(struct set_mg_user_data_request *settings) {
+    FREE_SDS(settings->music_directory);
+    FREE_SDS(settings->playlist_directory);
+    FREE_SDS(settings->image_names_sm);
+    FREE_SDS(settings->image_names_md);
+    FREE_SDS(settings->image_names_lg);
+    FREE_SDS(settings->mpd_host);
+    FREE_SDS(settings->lyrics.uslt_ext);
+    FREE_SDS(settings->lyrics.sylt_ext);
+    FREE_SDS(settings->lyrics.vorbis_uslt);
+    FREE_SDS(settings->lyrics.vorbis_sylt);
+    list_clear(&settings->partitions);
+    FREE_PTR(settings);
+}
+
+/**
+ * Returns the elapsed time in milliseconds
+ * @param start start time
+ * @param end end time
+ * @return elapsed time in milliseconds
+ */
+static double elapsed_ms(const struct timespec *start, const struct timespec *end) {
+    return (double)(end->tv_sec - start->tv_sec) * 1000 +
+        (double)(end->tv_nsec - start->tv_nsec) / 1000000;
+}
+
+/**
+ * Compares two doubles for qsort
+ * @param a pointer to the first double
+ * @param b pointer to the second double
+ * @return result of the comparison
+ */
+static int double_cmp(const void *a, const void *b) {
+    double d1 = *(const double *)a;
+    double d2 = *(const double *)b;
+    return (d1 > d2) - (d1 < d2);
+}
+
+/**
+ * Returns the nearest-rank percentile of sorted samples
+ * @param sorted sorted samples
+ * @param len number of samples
+ * @param p percentile
+ * @return the percentile value
+ */
+static double percentile(const double *sorted, unsigned len, unsigned p) {
+    unsigned rank = (p * len + 99) / 100;
+    return rank == 0
+        ? sorted[0]
+        : sorted[rank - 1];
+}
+
+/**
+ * Returns the peak resident set size of the process, including the fake mpd server
+ * @return peak rss in KiB
+ */
+static long peak_rss_kib(void) {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+    return usage.ru_maxrss;
+}
+
+/**
+ * Bench cases
+ */
+
+/**
+ * Creates the album cache from scratch
+ */
+static bool bench_album_cache_create(struct t_bench_env *env, unsigned iteration, uint64_t *items) {
+    (void)iteration;
+    bool rc = mympd_worker_album_cache_create(env->worker_state, true, false);
+    // install the new cache for the following bench cases
+    drain_queues(env->mympd_state);
+    *items += env->library->config.songs;
+    return rc &&
+        env->mympd_state->album_cache.cache != NULL;
+}
+
+/**
+ * Pages through the album list sorted by album artist
+ */
+static bool bench_album_list(struct t_bench_env *env, unsigned iteration, uint64_t *items) {
+    unsigned page_size = env->options->page_size;
+    unsigned pages = (env->library->config.albums + page_size - 1) / page_size;
+    unsigned offset = (iteration % pages) * page_size;
+    sds expression = sdsempty();
+    sds sort = sdsnew("AlbumArtist");
+    sds buffer = mympd_api_album_list(env->mympd_state, env->mympd_state->partition_state, sdsempty(), 0,
+        expression, sort, false, offset, page_size, &env->tagcols);
+    bool rc = strstr(buffer, "\"error\":") == NULL;
+    unsigned remaining = env->library->config.albums - offset;
+    *items += remaining < page_size
+        ? remaining
+        : page_size;
+    FREE_SDS(buffer);
+    FREE_SDS(expression);
+    FREE_SDS(sort);
+    return rc;
+}
+
+/**
+ * Fills the jukebox queue with random songs
+ */
+static bool bench_jukebox_fill(struct t_bench_env *env, unsigned iteration, uint64_t *items) {
+    (void)iteration;
+    struct t_partition_state *partition_state = env->mympd_state->partition_state;
+    partition_state->jukebox.mode = JUKEBOX_ADD_SONG;
+    // the synthetic library has less artists than the jukebox queue length
+    partition_state->jukebox.uniq_tag.tags[0] = MPD_TAG_TITLE;
+    list_clear(partition_state->jukebox.queue);
+    sds error = sdsempty();
+    bool rc = mympd_worker_jukebox_queue_fill(env->worker_state, &env->queue_list, 0, &error);
+    if (rc == false) {
+        MYMPD_LOG_ERROR(NULL, "Jukebox fill failed: %s", error);
+    }
+    *items += partition_state->jukebox.queue->length;
+    FREE_SDS(error);
+    return rc;
+}
+
+/**
+ * Updates a search and a sticker based smart playlist alternately
+ */
+static bool bench_smartpls_update(struct t_bench_env *env, unsigned iteration, uint64_t *items) {
+    const char *playlist;
+    if (iteration % 2 == 0) {
+        playlist = "bench-search";
+        if (iteration == 0) {
+            smartpls_save_search(env->mympd_state->config->workdir,
+                playlist, "((Genre == 'Genre 1') AND (AlbumArtist contains '1'))", "", false, 0);
+        }
+    }
+    else {
+        playlist = "bench-sticker";
+        if (iteration == 1) {
+            smartpls_save_sticker(env->mympd_state->config->workdir, playlist, "playCount", "10", "gt", "", false, 0);
+        }
+    }
+    bool rc = mympd_worker_smartpls_update(env->worker_state, playlist);
+    pthread_mutex_lock(&env->server->mutex);
+    struct t_list *entries = bench_library_get_playlist(env->library, playlist, false);
+    if (entries != NULL) {
+        *items += entries->length;
+    }
+    pthread_mutex_unlock(&env->server->mutex);
+    return rc;
+}
+
+/**
+ * Pages through the queue with all song stickers
+ */
+static bool bench_queue_list_stickers(struct t_bench_env *env, unsigned iteration, uint64_t *items) {
+    unsigned page_size = env->options->page_size;
+    unsigned pages = (env->library->config.queue_len + page_size - 1) / page_size;
+    unsigned offset = (iteration % pages) * page_size;
+    sds buffer = mympd_api_queue_list(env->mympd_state, env->mympd_state->partition_state, sdsempty(), 0,
+        offset, page_size, &env->tagcols);
+    bool rc = strstr(buffer, "\"error\":") == NULL;
+    unsigned remaining = env->library->config.queue_len - offset;
+    *items += remaining < page_size
+        ? remaining
+        : page_size;
+    FREE_SDS(buffer);
+    return rc;
+}
+
+/**
+ * Reads the albumart of a song in chunks of the binarylimit
+ */
+static bool bench_albumart(struct t_bench_env *env, unsigned iteration, uint64_t *items) {
+    const struct mpd_song *song = env->library->songs[(iteration * 97) % env->library->config.songs];
+    sds binary = sdsempty();
+    bool rc = mympd_api_albumart_read_mpd(env->mympd_state->partition_state, mpd_song_get_uri(song), &binary);
+    if (rc == true) {
+        rc = sdslen(binary) == env->library->config.albumart_size;
+        *items += 1;
+    }
+    FREE_SDS(binary);
+    return rc;
+}
@@ -0,0 +1,736 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2026 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+/*! \file
+ * \brief In-process bench cases without mpd commands.
+ * The input data is sized by the library options and created in the untimed
+ * prepare callbacks on first use.
+ */
+
+#include "compile_time.h"
+#include "micro.h"
+
+#include "dist/mpack/mpack.h"
+#include "src/lib/album.h"
+#include "src/lib/cache/cache_rax_album.h"
+#include "src/lib/filehandler.h"
+#include "src/lib/json/json_query.h"
+#include "src/lib/list/list.h"
+#include "src/lib/list/sort.h"
+#include "src/lib/log.h"
+#include "src/lib/mem.h"
+#include "src/lib/sds/sds_extras.h"
+#include "src/lib/search/search_pcre.h"
+#include "src/lib/utf8_wrapper.h"
+#include "src/mympd_client/random_select.h"
+#include "src/mympd_client/tags.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+
+//optional includes
+#ifdef MYMPD_ENABLE_THUMBNAILS
+    #include "src/lib/thumbnail.h"
+
+    #include <png.h>
+    #include <string.h>
+#endif
+
+/**
+ * Private definitions
+ */
+
+static bool prepare_album_cache_build(struct t_bench_env *env, unsigned iteration, uint64_t *items);
+static bool bench_album_cache_build(struct t_bench_env *env, unsigned iteration, uint64_t *items);
+static bool prepare_album_cache_read_mpack(struct t_bench_env *env, unsigned iteration, uint64_t *items);
+static bool prepare_album_cache_read_binary(struct t_bench_env *env, unsigned iteration, uint64_t *items);
+static bool bench_album_cache_read(struct t_bench_env *env, unsigned iteration, uint64_t *items);
+static bool prepare_json_query(struct t_bench_env *env, unsigned iteration, uint64_t *items);
+static bool bench_json_query_mjson(struct t_bench_env *env, unsigned iteration, uint64_t *items);
+static bool bench_json_query_bind(struct t_bench_env *env, unsigned iteration, uint64_t *items);
+static bool prepare_list_sort(struct t_bench_env *env, unsigned iteration, uint64_t *items);
+static bool bench_list_sort_callback(struct t_bench_env *env, unsigned iteration, uint64_t *items);
+static bool bench_list_sort_key(struct t_bench_env *env, unsigned iteration, uint64_t *items);
+static bool prepare_random_select(struct t_bench_env *env, unsigned iteration, uint64_t *items);
+static bool bench_random_select_reservoir(struct t_bench_env *env, unsigned iteration, uint64_t *items);
+static bool prepare_search_pcre(struct t_bench_env *env, unsigned iteration, uint64_t *items);
+static bool bench_search_pcre_interpreter(struct t_bench_env *env, unsigned iteration, uint64_t *items);
+static bool bench_search_pcre_jit(struct t_bench_env *env, unsigned iteration, uint64_t *items);
+
+/**
+ * Albums with interned tag values
+ */
+static rax *album_cache_albums;
+
+static rax *album_cache_albums_create(unsigned album_count);
+
+/**
+ * Album cache files in an own working directory
+ */
+static struct {
+    sds workdir;              //!< working directory for the album cache files
+    struct t_cache cache;     //!< album cache read from the files
+} album_cache_file;
+
+/**
+ * Tags of the album cache files
+ */
+static const struct t_mympd_mpd_tags album_cache_tags = {
+    .len = 5,
+    .tags = {MPD_TAG_ARTIST, MPD_TAG_ALBUM_ARTIST, MPD_TAG_ALBUM, MPD_TAG_GENRE, MPD_TAG_DATE}
+};
+
+/**
+ * Album configuration of the album cache files
+ */
+static const struct t_albums_config album_cache_config = {
+    .mode = ALBUM_MODE_ADV,
+    .group_tag = MPD_TAG_UNKNOWN,
+    .unknown = false
+};
+
+static bool album_cache_file_prepare(struct t_bench_env *env);
+static bool album_cache_write_mpack(rax *albums, sds workdir);
+
+/**
+ * Request bodies as sent by the webui
+ */
+static sds json_query_requests[2];
+
+/**
+ * Parsed requests per iteration of the json query cases
+ */
+#define JSON_QUERY_REQUESTS 100
+
+static bool json_query_parse(bool bind);
+
+/**
+ * Unsorted source list and the list to sort for the list sort cases
+ */
+static struct {
+    struct t_list source;  //!< unsorted list with one node per song
+    struct t_list sorted;  //!< copy of the source list that is sorted
+} list_sort;
+
+static bool list_sort_cb_casecmp(struct t_list_node *first, struct t_list_node *second,
+        enum list_sort_direction direction);
+
+/**
+ * Candidates and queue for the random select case
+ */
+static struct {
+    sds *uris;               //!< uris of the candidates
+    sds *artists;            //!< uniq tag values of the candidates
+    unsigned count;          //!< number of candidates
+    unsigned expected;       //!< number of songs that can be selected
+    struct t_list queue;     //!< queue for the uniq constraints
+    struct t_list add_list;  //!< selected songs
+} random_select;
+
+/**
+ * Number of songs the random select case selects
+ */
+#define RANDOM_SELECT_LEN 50
+
+/**
+ * Tag values and compiled regexes for the pcre cases
+ */
+static struct {
+    sds *values;                     //!< synthetic tag values
+    unsigned count;                  //!< number of tag values
+    struct t_search_pcre *re_interp; //!< regex for the interpreter
+    struct t_search_pcre *re_jit;    //!< JIT compiled regex
+} search_pcre;
+
+static unsigned search_pcre_match_all(struct t_search_pcre *re);
+
+#ifdef MYMPD_ENABLE_THUMBNAILS
+static bool prepare_thumbnail(struct t_bench_env *env, unsigned iteration, uint64_t *items);
+static bool bench_thumbnail(struct t_bench_env *env, unsigned iteration, uint64_t *items);
+
+/**
+ * Cover image for the thumbnail case
+ */
+static sds thumbnail_cover;
+#endif
+
+/**
+ * Public functions
+ */
+
+/**
+ * The in-process bench cases
+ */
+const struct t_bench_case bench_micro_cases[] = {
+    { "album_cache_build", bench_album_cache_build, prepare_album_cache_build, false },
+    { "album_cache_read_mpack", bench_album_cache_read, prepare_album_cache_read_mpack, true },
+    { "album_cache_read_binary", bench_album_cache_read, prepare_album_cache_read_binary, false },
+    { "json_query_mjson", bench_json_query_mjson, prepare_json_query, false },
+    { "json_query_bind", bench_json_query_bind, prepare_json_query, false },
+    { "list_sort_callback", bench_list_sort_callback, prepare_list_sort, false },
+    { "list_sort_key", bench_list_sort_key, prepare_list_sort, false },
+    { "random_select_reservoir", bench_random_select_reservoir, prepare_random_select, false },
+    { "search_pcre_interpreter", bench_search_pcre_interpreter, prepare_search_pcre, false },
+    { "search_pcre_jit", bench_search_pcre_jit, prepare_search_pcre, false },
+    #ifdef MYMPD_ENABLE_THUMBNAILS
+    { "thumbnail", bench_thumbnail, prepare_thumbnail, false },
+    #endif
+    { NULL, NULL, NULL, false }
+};
+
+/**
+ * Frees the input data of the in-process bench cases
+ */
+void bench_micro_clear(void) {
+    if (album_cache_file.workdir != NULL) {
+        album_cache_free(&album_cache_file.cache);
+        cache_free(&album_cache_file.cache);
+        album_cache_remove(album_cache_file.workdir);
+        FREE_SDS(album_cache_file.workdir);
+    }
+    if (album_cache_albums != NULL) {
+        album_cache_free_rt(album_cache_albums);
+        album_cache_albums = NULL;
+    }
+    FREE_SDS(json_query_requests[0]);
+    FREE_SDS(json_query_requests[1]);
+    list_clear(&list_sort.source);
+    list_clear(&list_sort.sorted);
+    if (random_select.uris != NULL) {
+        for (unsigned i = 0; i < random_select.count; i++) {
+            FREE_SDS(random_select.uris[i]);
+            FREE_SDS(random_select.artists[i]);
+        }
+        FREE_PTR(random_select.uris);
+        FREE_PTR(random_select.artists);
+    }
+    list_clear(&random_select.queue);
+    list_clear(&random_select.add_list);
+    if (search_pcre.values != NULL) {
+        for (unsigned i = 0; i < search_pcre.count; i++) {
+            FREE_SDS(search_pcre.values[i]);
+        }
+        FREE_PTR(search_pcre.values);
+    }
+    mympd_search_pcre_free(search_pcre.re_interp);
+    search_pcre.re_interp = NULL;
+    mympd_search_pcre_free(search_pcre.re_jit);
+    search_pcre.re_jit = NULL;
+    #ifdef MYMPD_ENABLE_THUMBNAILS
+    FREE_SDS(thumbnail_cover);
+    #endif
+}
+
+/**
+ * Private functions
+ */
+
+/**
+ * Frees the albums of the last iteration
+ */
+static bool prepare_album_cache_build(struct t_bench_env *env, unsigned iteration, uint64_t *items) {
+    (void)env;
+    (void)iteration;
+    (void)items;
+    if (album_cache_albums != NULL) {
+        album_cache_free_rt(album_cache_albums);
+        album_cache_albums = NULL;
+    }
+    return true;
+}
+
+/**
+ * Creates one album per library album, the tag values are interned
+ */
+static bool bench_album_cache_build(struct t_bench_env *env, unsigned iteration, uint64_t *items) {
+    (void)iteration;
+    album_cache_albums = album_cache_albums_create(env->options->library.albums);
+    *items += album_cache_albums->numele;
+    return true;
+}
+
+/**
+ * Writes the album cache file of older myMPD versions that is converted on read
+ */
+static bool prepare_album_cache_read_mpack(struct t_bench_env *env, unsigned iteration, uint64_t *items) {
+    (void)iteration;
+    (void)items;
+    return album_cache_file_prepare(env) &&
+        album_cache_remove(album_cache_file.workdir) &&
+        album_cache_write_mpack(album_cache_albums, album_cache_file.workdir);
+}
+
+/**
+ * Writes the binary album cache file on first use
+ */
+static bool prepare_album_cache_read_binary(struct t_bench_env *env, unsigned iteration, uint64_t *items) {
+    (void)iteration;
+    (void)items;
+    if (album_cache_file_prepare(env) == false) {
+        return false;
+    }
+    sds filepath = sdscatfmt(sdsempty(), "%S/%s/%s", album_cache_file.workdir, DIR_WORK_TAGS, FILENAME_ALBUMCACHE);
+    bool rc = testfile_read(filepath);
+    FREE_SDS(filepath);
+    if (rc == true) {
+        return true;
+    }
+    struct t_cache album_cache;
+    cache_init(&album_cache);
+    album_cache.cache = album_cache_albums;
+    rc = album_cache_write(&album_cache, album_cache_file.workdir, &album_cache_tags, &album_cache_config, false);
+    cache_free(&album_cache);
+    return rc;
+}
+
+/**
+ * Reads the album cache like on startup
+ */
+static bool bench_album_cache_read(struct t_bench_env *env, unsigned iteration, uint64_t *items) {
+    (void)env;
+    (void)iteration;
+    if (album_cache_read(&album_cache_file.cache, album_cache_file.workdir, &album_cache_config) == false) {
+        return false;
+    }
+    *items += album_cache_file.cache.cache->numele;
+    return true;
+}
+
+/**
+ * Creates the working directory and the albums on first use and frees the
+ * album cache of the last iteration
+ * @param env the bench environment
+ * @return true on success, else false
+ */
+static bool album_cache_file_prepare(struct t_bench_env *env) {
+    if (album_cache_file.workdir == NULL) {
+        album_cache_file.workdir = sdscatfmt(sdsempty(), "%s/micro", env->options->workdir);
+        cache_init(&album_cache_file.cache);
+        sds dir = sdscatfmt(sdsempty(), "%S/%s", album_cache_file.workdir, DIR_WORK_TAGS);
+        bool rc = (mkdir(album_cache_file.workdir, 0770) == 0 || errno == EEXIST) &&
+            (mkdir(dir, 0770) == 0 || errno == EEXIST);
+        FREE_SDS(dir);
+        if (rc == false) {
+            MYMPD_LOG_ERROR(NULL, "Can not create directory \"%s\"", album_cache_file.workdir);
+            return false;
+        }
+    }
+    if (album_cache_albums == NULL) {
+        album_cache_albums = album_cache_albums_create(env->options->library.albums);
+    }
+    album_cache_free(&album_cache_file.cache);
+    return true;
+}
+
+/**
+ * Writes the albums in the album cache file format of older myMPD versions
+ * @param albums the albums by album id
+ * @param workdir working directory
+ * @return true on success, else false
+ */
+static bool album_cache_write_mpack(rax *albums, sds workdir) {
+    sds filepath = sdscatfmt(sdsempty(), "%S/%s/%s", workdir, DIR_WORK_TAGS, FILENAME_ALBUMCACHE_MPACK);
+    mpack_writer_t writer;
+    mpack_writer_init_filename(&writer, filepath);
+    FREE_SDS(filepath);
+    mpack_build_map(&writer);
+    mpack_write_kv(&writer, "cacheVersion", 1);
+    mpack_write_kv(&writer, "albumMode", album_cache_config.mode);
+    mpack_write_kv(&writer, "albumGroupTag", album_cache_config.group_tag);
+    mpack_write_kv(&writer, "albumUnknown", album_cache_config.unknown);
+    mpack_write_cstr(&writer, "tags");
+    mpack_start_array(&writer, (uint32_t)album_cache_tags.len);
+    for (size_t i = 0; i < album_cache_tags.len; i++) {
+        mpack_write_cstr(&writer, mpd_tag_name(album_cache_tags.tags[i]));
+    }
+    mpack_finish_array(&writer);
+    mpack_write_cstr(&writer, "albums");
+    mpack_start_array(&writer, (uint32_t)albums->numele);
+    raxIterator iter;
+    raxStart(&iter, albums);
+    raxSeek(&iter, "^", NULL, 0);
+    while (raxNext(&iter)) {
+        struct t_album *album = (struct t_album *)iter.data;
+        mpack_build_map(&writer);
+        mpack_write_kv(&writer, "uri", album_get_uri(album));
+        mpack_write_kv(&writer, "Discs", album_get_disc_count(album));
+        mpack_write_kv(&writer, "Songs", album_get_song_count(album));
+        mpack_write_kv(&writer, "Duration", album_get_total_time(album));
+        mpack_write_kv(&writer, "Last-Modified", (uint64_t)album_get_last_modified(album));
+        mpack_write_kv(&writer, "Added", (uint64_t)album_get_added(album));
+        mpack_write_cstr(&writer, "AlbumId");
+        mpack_write_str(&writer, (char *)iter.key, (uint32_t)iter.key_len);
+        for (size_t i = 0; i < album_cache_tags.len; i++) {
+            enum mpd_tag_type tag = album_cache_tags.tags[i];
+            if (album_get_tag(album, tag, 0) == NULL) {
+                continue;
+            }
+            mpack_write_cstr(&writer, mpd_tag_name(tag));
+            if (is_multivalue_tag(tag) == true) {
+                unsigned count = 0;
+                while (album_get_tag(album, tag, count) != NULL) {
+                    count++;
+                }
+                mpack_start_array(&writer, count);
+                for (unsigned j = 0; j < count; j++) {
+                    mpack_write_cstr(&writer, album_get_tag(album, tag, j));
+                }
+                mpack_finish_array(&writer);
+            }
+            else {
+                mpack_write_cstr(&writer, album_get_tag(album, tag, 0));
+            }
+        }
+        mpack_complete_map(&writer);
+    }
+    raxStop(&iter);
+    mpack_finish_array(&writer);
+    mpack_complete_map(&writer);
+    return mpack_writer_destroy(&writer) == mpack_ok;
+}
+
+/**
+ * Creates albums with the tags of the album cache
+ * @param album_count number of albums
+ * @return the albums by album id
+ */
+static rax *album_cache_albums_create(unsigned album_count) {
+    rax *albums = raxNew();
+    sds key = sdsempty();
+    sds value = sdsempty();
+    for (unsigned i = 0; i < album_count; i++) {
+        sdsclear(value);
+        value = sdscatfmt(value, "music/artist %u/album %u/01 - title.flac", i % 2000, i);
+        struct t_album *album = album_new_uri(value);
+        sdsclear(value);
+        value = sdscatfmt(value, "Artist %u", i % 2000);
+        album_append_tag(album, MPD_TAG_ARTIST, value);
+        album_append_tag(album, MPD_TAG_ALBUM_ARTIST, value);
+        sdsclear(value);
+        value = sdscatfmt(value, "Album %u", i);
+        album_append_tag(album, MPD_TAG_ALBUM, value);
+        sdsclear(value);
+        value = sdscatfmt(value, "Genre %u", i % 20);
+        album_append_tag(album, MPD_TAG_GENRE, value);
+        album_append_tag(album, MPD_TAG_DATE, "2024");
+        album_set_disc_count(album, 1 + i % 2);
+        album_set_song_count(album, 10);
+        album_set_total_time(album, 3000 + i);
+        album_set_last_modified(album, 1699304451 + i);
+        album_set_added(album, 1699300000 + i);
+        sdsclear(key);
+        key = sdscatprintf(key, "%08x", i);
+        raxInsert(albums, (unsigned char *)key, sdslen(key), album, NULL);
+    }
+    FREE_SDS(key);
+    FREE_SDS(value);
+    return albums;
+}
+
+/**
+ * Creates a queue append request with 2000 uris and a queue search request
+ */
+static bool prepare_json_query(struct t_bench_env *env, unsigned iteration, uint64_t *items) {
+    (void)env;
+    (void)iteration;
+    (void)items;
+    if (json_query_requests[0] != NULL) {
+        return true;
+    }
+    sds request = sdsnew("{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"MYMPD_API_QUEUE_APPEND_URIS\",\"params\":{\"uris\":[");
+    for (int i = 0; i < 2000; i++) {
+        request = sdscatfmt(request, "%s\"Music/Artist %i/Album %i/%i - Title.flac\"", (i > 0 ? "," : ""), i / 100, i / 10, i);
+    }
+    json_query_requests[0] = sdscat(request, "],\"play\":true,\"partition\":\"default\"}}");
+    json_query_requests[1] = sdsnew("{\"jsonrpc\":\"2.0\",\"id\":2,\"method\":\"MYMPD_API_QUEUE_SEARCH\",\"params\":{\"offset\":0,\"limit\":100,"
+        "\"sort\":\"Priority\",\"sortdesc\":false,\"expression\":\"((any contains 'test'))\","
+        "\"fields\":[\"Pos\",\"Title\",\"Artist\",\"Album\",\"Duration\",\"AlbumArtist\",\"Genre\",\"Date\"],\"partition\":\"default\"}}");
+    return true;
+}
+
+/**
+ * Resolves the paths of the request handlers for the requests
+ * @param bind true = bind the request to the token index, false = resolve with mjson
+ * @return true on success, else false
+ */
+static bool json_query_parse(bool bind) {
+    static const char *paths[2][5] = {
+        {"$.method", "$.id", "$.params.uris", "$.params.play", "$.params.partition"},
+        {"$.method", "$.id", "$.params.limit", "$.params.fields", "$.params.partition"}
+    };
+    bool rc = true;
+    for (unsigned i = 0; i < JSON_QUERY_REQUESTS; i++) {
+        sds request = json_query_requests[i % 2];
+        if (bind == true) {
+            rc = json_query_bind(request) && rc;
+        }
+        for (unsigned p = 0; p < 5; p++) {
+            rc = json_find_key(request, paths[i % 2][p]) && rc;
+        }
+        sds partition = json_get_key_as_sds(request, "$.params.partition");
+        rc = partition != NULL && rc;
+        FREE_SDS(partition);
+        if (bind == true) {
+            json_query_unbind();
+        }
+    }
+    return rc;
+}
+
+/**
+ * Resolves each path with mjson
+ */
+static bool bench_json_query_mjson(struct t_bench_env *env, unsigned iteration, uint64_t *items) {
+    (void)env;
+    (void)iteration;
+    *items += JSON_QUERY_REQUESTS;
+    return json_query_parse(false);
+}
+
+/**
+ * Tokenizes each request once and resolves the paths with the token index
+ */
+static bool bench_json_query_bind(struct t_bench_env *env, unsigned iteration, uint64_t *items) {
+    (void)env;
+    (void)iteration;
+    *items += JSON_QUERY_REQUESTS;
+    return json_query_parse(true);
+}
+
+/**
+ * Creates the unsorted source list on first use and copies it for each iteration
+ */
+static bool prepare_list_sort(struct t_bench_env *env, unsigned iteration, uint64_t *items) {
+    (void)iteration;
+    (void)items;
+    if (list_sort.source.length == 0) {
+        unsigned count = env->options->library.songs;
+        sds key = sdsempty();
+        for (unsigned i = 0; i < count; i++) {
+            // scattered keys with mixed case
+            unsigned n = (unsigned)((i * 2654435761U) % count);
+            sdsclear(key);
+            key = sdscatfmt(key, "%s %u - Title %u", (n % 2 == 0 ? "Artist" : "artist"), n % 500, n);
+            list_push(&list_sort.source, key, i, NULL, NULL);
+        }
+        FREE_SDS(key);
+    }
+    list_clear(&list_sort.sorted);
+    for (struct t_list_node *current = list_sort.source.head; current != NULL; current = current->next) {
+        list_push(&list_sort.sorted, current->key, current->value_i, NULL, NULL);
+    }
+    return true;
+}
+
+/**
+ * Sort callback that compares with utf8_wrap_casecmp on each comparison
+ */
+static bool list_sort_cb_casecmp(struct t_list_node *first, struct t_list_node *second,
+        enum list_sort_direction direction)
+{
+    int result = utf8_wrap_casecmp(first->key, sdslen(first->key), second->key, sdslen(second->key));
+    return (direction == LIST_SORT_ASC && result > 0) ||
+        (direction == LIST_SORT_DESC && result < 0);
+}
+
+/**
+ * Merge sort that casefolds the keys on each comparison
+ */
+static bool bench_list_sort_callback(struct t_bench_env *env, unsigned iteration, uint64_t *items) {
+    (void)env;
+    (void)iteration;
+    *items += list_sort.sorted.length;
+    return list_sort_by_callback(&list_sort.sorted, LIST_SORT_ASC, list_sort_cb_casecmp);
+}
+
+/**
+ * Sort with precomputed collation keys
+ */
+static bool bench_list_sort_key(struct t_bench_env *env, unsigned iteration, uint64_t *items) {
+    (void)env;
+    (void)iteration;
+    *items += list_sort.sorted.length;
+    return list_sort_by_key(&list_sort.sorted, LIST_SORT_ASC);
+}
+
+/**
+ * Creates one candidate per song and the queue on first use,
+ * the artists of the queue are not selectable
+ */
+static bool prepare_random_select(struct t_bench_env *env, unsigned iteration, uint64_t *items) {
+    (void)iteration;
+    (void)items;
+    list_clear(&random_select.add_list);
+    if (random_select.uris != NULL) {
+        return true;
+    }
+    random_select.count = env->options->library.songs;
+    unsigned artists = env->options->library.artists < random_select.count
+        ? env->options->library.artists
+        : random_select.count;
+    random_select.uris = malloc_assert(random_select.count * sizeof(sds));
+    random_select.artists = malloc_assert(random_select.count * sizeof(sds));
+    for (unsigned i = 0; i < random_select.count; i++) {
+        random_select.uris[i] = sdscatfmt(sdsempty(), "music/artist%u/song%u.mp3", i % artists, i);
+        random_select.artists[i] = sdscatfmt(sdsempty(), "artist%u", i % artists);
+    }
+    // each queue entry blocks one artist, keep enough artists for the selection
+    unsigned queue_max = artists > RANDOM_SELECT_LEN
+        ? artists - RANDOM_SELECT_LEN
+        : artists / 2;
+    unsigned queue_len = env->options->library.queue_len < queue_max
+        ? env->options->library.queue_len
+        : queue_max;
+    for (unsigned i = 0; i < queue_len; i++) {
+        list_push(&random_select.queue, random_select.uris[i], 0, random_select.artists[i], NULL);
+    }
+    random_select.expected = artists - queue_len < RANDOM_SELECT_LEN
+        ? artists - queue_len
+        : RANDOM_SELECT_LEN;
+    return true;
+}
+
+/**
+ * Selects songs with uniq artists from all candidates like the jukebox fill
+ */
+static bool bench_random_select_reservoir(struct t_bench_env *env, unsigned iteration, uint64_t *items) {
+    (void)env;
+    (void)iteration;
+    struct t_random_select_reservoir reservoir;
+    random_select_reservoir_init(&reservoir, RANDOM_SELECT_LEN, &random_select.queue, &random_select.add_list);
+    for (unsigned i = 0; i < random_select.count; i++) {
+        random_select_reservoir_add(&reservoir, random_select.uris[i], random_select.artists[i]);
+    }
+    random_select_reservoir_clear(&reservoir);
+    *items += random_select.count;
+    if (random_select.add_list.length != random_select.expected) {
+        MYMPD_LOG_ERROR(NULL, "Random select: %u of %u songs selected", random_select.add_list.length, random_select.expected);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Creates one tag value per song and compiles the regex with and without JIT
+ */
+static bool prepare_search_pcre(struct t_bench_env *env, unsigned iteration, uint64_t *items) {
+    (void)iteration;
+    (void)items;
+    if (search_pcre.values != NULL) {
+        return true;
+    }
+    search_pcre.count = env->options->library.songs;
+    search_pcre.values = malloc_assert(search_pcre.count * sizeof(sds));
+    for (unsigned i = 0; i < search_pcre.count; i++) {
+        search_pcre.values[i] = sdscatprintf(sdsempty(), "artist %u - album title %u (remastered %u)",
+            i % 5000, i, 1990 + i % 30);
+    }
+    sds regex = sdsnew("^artist 1[0-9]* - .*\\(remastered 199[0-4]\\)$");
+    search_pcre.re_interp = mympd_search_pcre_compile(regex, false);
+    search_pcre.re_jit = mympd_search_pcre_compile(regex, true);
+    FREE_SDS(regex);
+    return search_pcre.re_interp != NULL &&
+        search_pcre.re_jit != NULL;
+}
+
+/**
+ * Matches the regex against all values
+ * @param re compiled regex
+ * @return number of matching values
+ */
+static unsigned search_pcre_match_all(struct t_search_pcre *re) {
+    unsigned hits = 0;
+    for (unsigned i = 0; i < search_pcre.count; i++) {
+        if (mympd_search_pcre_match(search_pcre.values[i], sdslen(search_pcre.values[i]), re) == true) {
+            hits++;
+        }
+    }
+    return hits;
+}
+
+/**
+ * Matches the regex with the pcre2 interpreter
+ */
+static bool bench_search_pcre_interpreter(struct t_bench_env *env, unsigned iteration, uint64_t *items) {
+    (void)env;
+    (void)iteration;
+    unsigned hits = search_pcre_match_all(search_pcre.re_interp);
+    *items += search_pcre.count;
+    return hits > 0;
+}
+
+/**
+ * Matches the JIT compiled regex, it falls back to the interpreter if JIT is not available
+ */
+static bool bench_search_pcre_jit(struct t_bench_env *env, unsigned iteration, uint64_t *items) {
+    (void)env;
+    (void)iteration;
+    unsigned hits = search_pcre_match_all(search_pcre.re_jit);
+    *items += search_pcre.count;
+    return hits > 0;
+}
+
+#ifdef MYMPD_ENABLE_THUMBNAILS
+/**
+ * Creates a 1500x1500 pixel png cover with a gradient and some noise
+ */
+static bool prepare_thumbnail(struct t_bench_env *env, unsigned iteration, uint64_t *items) {
+    (void)env;
+    (void)iteration;
+    (void)items;
+    if (thumbnail_cover != NULL) {
+        return true;
+    }
+    png_image png;
+    memset(&png, 0, sizeof(png));
+    png.version = PNG_IMAGE_VERSION;
+    png.width = 1500;
+    png.height = 1500;
+    png.format = PNG_FORMAT_RGB;
+    unsigned char *pixels = malloc_assert(PNG_IMAGE_SIZE(png));
+    unsigned seed = 1;
+    for (unsigned y = 0; y < png.height; y++) {
+        for (unsigned x = 0; x < png.width; x++) {
+            unsigned char *p = pixels + ((size_t)y * png.width + x) * 3;
+            seed = seed * 1103515245 + 12345;
+            p[0] = (unsigned char)(x * 255 / png.width);
+            p[1] = (unsigned char)(y * 255 / png.height);
+            p[2] = (unsigned char)((seed >> 28) + x % 64);
+        }
+    }
+    png_alloc_size_t len = 0;
+    bool rc = png_image_write_to_memory(&png, NULL, &len, 0, pixels, 0, NULL) != 0;
+    if (rc == true) {
+        thumbnail_cover = sdsnewlen(NULL, len);
+        rc = png_image_write_to_memory(&png, thumbnail_cover, &len, 0, pixels, 0, NULL) != 0;
+        sdssetlen(thumbnail_cover, len);
+    }
+    FREE_PTR(pixels);
+    return rc;
+}
+
+/**
+ * Decodes the cover once and encodes the small and medium thumbnail
+ */
+static bool bench_thumbnail(struct t_bench_env *env, unsigned iteration, uint64_t *items) {
+    (void)env;
+    (void)iteration;
+    struct t_thumbnail_image image;
+    if (thumbnail_decode(thumbnail_cover, sdslen(thumbnail_cover), THUMBNAIL_SIZE_MD, &image) == false) {
+        return false;
+    }
+    sds jpeg = sdsempty();
+    bool rc = thumbnail_encode(&image, THUMBNAIL_SIZE_SM, &jpeg);
+    sdsclear(jpeg);
+    rc = rc &&
+        thumbnail_encode(&image, THUMBNAIL_SIZE_MD, &jpeg);
+    thumbnail_image_clear(&image);
+    FREE_SDS(jpeg);
+    *items += 1;
+    return rc;
+}
+#endif
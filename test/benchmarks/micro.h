@@ -0,0 +1,20 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2026 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+/*! \file
+ * \brief In-process bench cases without mpd commands
+ */
+
+#ifndef BENCH_MICRO_H
+#define BENCH_MICRO_H
+
+#include "bench.h"
+
+extern const struct t_bench_case bench_micro_cases[];
+
+void bench_micro_clear(void);
+
+#endif
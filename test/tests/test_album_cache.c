@@ -7,14 +7,22 @@
 #include "compile_time.h"
 #include "dist/utest/utest.h"
 
+#include "dist/mpack/mpack.h"
 #include "src/lib/album.h"
 #include "src/lib/cache/cache_rax_album.h"
+#include "src/lib/cache/cache_rax_album_index.h"
+#include "src/lib/cache/cache_rax_album_songs.h"
 #include "src/lib/config/config_def.h"
+#include "src/lib/filehandler.h"
 #include "src/lib/mpdclient.h"
+#include "src/lib/str_pool.h"
+#include "src/mympd_client/tags.h"
 #include "utility.h"
 
 #define PCRE2_CODE_UNIT_WIDTH 8
 #include <pcre2.h>
+#include <sys/stat.h>
+#include <time.h>
 
 UTEST(album_cache, test_album_cache_get_key) {
     struct t_albums_config album_config = {
@@ -110,3 +118,520 @@ UTEST(album_cache, test_album_cache_set_uri) {
     ASSERT_STREQ("/newuri", album_get_uri(album));
     album_free(album);
 }
+
+UTEST(album_cache, test_album_index) {
+    struct t_cache album_cache;
+    cache_init(&album_cache);
+    album_cache.cache = raxNew();
+    const char *names[] = {"Zeta", "alpha", "Mu"};
+    const char *keys[] = {"1", "2", "3"};
+    for (unsigned i = 0; i < 3; i++) {
+        struct t_album *album = album_new_uri("music/test.mp3");
+        album_append_tag(album, MPD_TAG_ALBUM_ARTIST, "Artist");
+        album_append_tag(album, MPD_TAG_ALBUM, names[i]);
+        album_set_added(album, (time_t)(1000 - i));
+        raxInsert(album_cache.cache, (unsigned char *)keys[i], 1, album, NULL);
+    }
+
+    const struct t_album_sort_index *sort_index = album_index_get(&album_cache, SORT_BY_TAG, MPD_TAG_ALBUM);
+    ASSERT_EQ((size_t)3, sort_index->len);
+    ASSERT_STREQ("alpha", album_get_tag(sort_index->albums[0], MPD_TAG_ALBUM, 0));
+    ASSERT_STREQ("Mu", album_get_tag(sort_index->albums[1], MPD_TAG_ALBUM, 0));
+    ASSERT_STREQ("Zeta", album_get_tag(sort_index->albums[2], MPD_TAG_ALBUM, 0));
+    // second call returns the cached index
+    ASSERT_TRUE(sort_index == album_index_get(&album_cache, SORT_BY_TAG, MPD_TAG_ALBUM));
+
+    sort_index = album_index_get(&album_cache, SORT_BY_ADDED, MPD_TAG_ALBUM);
+    ASSERT_STREQ("Mu", album_get_tag(sort_index->albums[0], MPD_TAG_ALBUM, 0));
+    ASSERT_STREQ("Zeta", album_get_tag(sort_index->albums[2], MPD_TAG_ALBUM, 0));
+
+    album_cache_free(&album_cache);
+    ASSERT_TRUE(album_cache.index == NULL);
+    cache_free(&album_cache);
+}
+
+static const struct t_mympd_mpd_tags album_songs_tags = {
+    .len = 3,
+    .tags = {MPD_TAG_ARTIST, MPD_TAG_ALBUM, MPD_TAG_GENRE}
+};
+
+static struct mpd_song *new_album_song(const char *uri, const char *disc, unsigned duration, time_t added) {
+    struct mpd_song *song = new_test_song();
+    free(song->uri);
+    song->uri = strdup(uri);
+    // replace the disc tag of the test song
+    free(song->tags[MPD_TAG_DISC].value);
+    song->tags[MPD_TAG_DISC].value = NULL;
+    if (disc != NULL) {
+        song_append_tag(song, MPD_TAG_DISC, disc);
+    }
+    song->duration = duration;
+    song->added = added;
+    song->last_modified = added;
+    return song;
+}
+
+static void album_songs_test_set(struct t_album_songs *album_songs, const char *uri, const char *disc,
+        unsigned duration, time_t added, const char *key)
+{
+    struct mpd_song *song = new_album_song(uri, disc, duration, added);
+    sds album_key = sdsnew(key);
+    sdsfree(album_songs_set(album_songs, song, album_key, &album_songs_tags));
+    sdsfree(album_key);
+    mpd_song_free(song);
+}
+
+UTEST(album_cache, test_album_songs_set_remove) {
+    struct t_album_songs album_songs;
+    album_songs_init(&album_songs);
+    struct mpd_song *song = new_album_song("music/a1.mp3", "1", 10, 1000);
+    sds key = sdsnew("a");
+    ASSERT_TRUE(album_songs_set(&album_songs, song, key, &album_songs_tags) == NULL);
+    // the song moved to another album
+    sdsclear(key);
+    key = sdscat(key, "b");
+    sds old_key = album_songs_set(&album_songs, song, key, &album_songs_tags);
+    ASSERT_STREQ("a", old_key);
+    sdsfree(old_key);
+    ASSERT_EQ((uint64_t)1, album_songs.songs->numele);
+
+    old_key = album_songs_remove(&album_songs, "music/a1.mp3", 12);
+    ASSERT_STREQ("b", old_key);
+    sdsfree(old_key);
+    ASSERT_TRUE(album_songs_remove(&album_songs, "music/a1.mp3", 12) == NULL);
+    sdsfree(key);
+    mpd_song_free(song);
+    album_songs_clear(&album_songs);
+}
+
+UTEST(album_cache, test_album_songs_mark_sweep) {
+    struct t_album_songs album_songs;
+    album_songs_init(&album_songs);
+    album_songs_test_set(&album_songs, "music/a1.mp3", "1", 10, 1000, "a");
+    album_songs_test_set(&album_songs, "music/a2.mp3", "1", 10, 1000, "a");
+    album_songs_test_set(&album_songs, "music/b1.mp3", NULL, 10, 1000, "b");
+    album_songs_test_set(&album_songs, "music/single.mp3", NULL, 10, 1000, "");
+    ASSERT_TRUE(album_songs_mark(&album_songs, "music/a1.mp3", 12));
+    ASSERT_TRUE(album_songs_mark(&album_songs, "music/single.mp3", 16));
+    ASSERT_FALSE(album_songs_mark(&album_songs, "music/c1.mp3", 12));
+
+    rax *affected = raxNew();
+    ASSERT_EQ(2U, album_songs_sweep(&album_songs, affected));
+    ASSERT_EQ((uint64_t)2, album_songs.songs->numele);
+    ASSERT_EQ((uint64_t)2, affected->numele);
+    ASSERT_EQ(1, raxFind(affected, (unsigned char *)"a", 1, NULL));
+    ASSERT_EQ(1, raxFind(affected, (unsigned char *)"b", 1, NULL));
+    // the marks are cleared by the sweep
+    ASSERT_EQ(2U, album_songs_sweep(&album_songs, affected));
+    ASSERT_EQ((uint64_t)0, album_songs.songs->numele);
+    raxFree(affected);
+    album_songs_clear(&album_songs);
+}
+
+UTEST(album_cache, test_album_songs_patch_albums) {
+    struct t_album_songs album_songs;
+    album_songs_init(&album_songs);
+    album_songs_test_set(&album_songs, "music/a1.mp3", "1", 10, 1000, "a");
+    album_songs_test_set(&album_songs, "music/a2.mp3", "2", 20, 2000, "a");
+    album_songs_test_set(&album_songs, "music/b1.mp3", NULL, 30, 3000, "b");
+    album_songs_test_set(&album_songs, "music/c1.mp3", NULL, 40, 4000, "c");
+    album_songs_test_set(&album_songs, "music/single.mp3", NULL, 50, 5000, "");
+
+    rax *album_cache = raxNew();
+    const char *keys[] = {"a", "b", "c"};
+    const char *uris[] = {"music/a1.mp3", "music/b1.mp3", "music/c1.mp3"};
+    for (unsigned i = 0; i < 3; i++) {
+        struct t_album *album = album_new_uri(uris[i]);
+        raxInsert(album_cache, (unsigned char *)keys[i], 1, album, NULL);
+    }
+
+    // move a2 to album b, remove b1 and c1
+    rax *affected = raxNew();
+    raxInsert(affected, (unsigned char *)"a", 1, NULL, NULL);
+    raxInsert(affected, (unsigned char *)"b", 1, NULL, NULL);
+    raxInsert(affected, (unsigned char *)"c", 1, NULL, NULL);
+    album_songs_test_set(&album_songs, "music/a2.mp3", "2", 20, 2000, "b");
+    sdsfree(album_songs_remove(&album_songs, "music/b1.mp3", 12));
+    sdsfree(album_songs_remove(&album_songs, "music/c1.mp3", 12));
+    album_songs_patch_albums(&album_songs, affected, album_cache, &album_songs_tags, true);
+    raxFree(affected);
+
+    ASSERT_EQ((uint64_t)2, album_cache->numele);
+    void *data;
+    ASSERT_EQ(1, raxFind(album_cache, (unsigned char *)"a", 1, &data));
+    struct t_album *album = (struct t_album *)data;
+    ASSERT_EQ(1U, album_get_song_count(album));
+    ASSERT_EQ(10U, album_get_total_time(album));
+    ASSERT_EQ(1U, album_get_disc_count(album));
+    ASSERT_EQ(1000, album_get_last_modified(album));
+
+    ASSERT_EQ(1, raxFind(album_cache, (unsigned char *)"b", 1, &data));
+    album = (struct t_album *)data;
+    ASSERT_EQ(1U, album_get_song_count(album));
+    ASSERT_EQ(20U, album_get_total_time(album));
+    ASSERT_EQ(2U, album_get_disc_count(album));
+    ASSERT_EQ(2000, album_get_added(album));
+    // the uri of the removed song is replaced
+    ASSERT_STREQ("music/a2.mp3", album_get_uri(album));
+
+    album_cache_free_rt(album_cache);
+    album_songs_clear(&album_songs);
+}
+
+static void album_songs_test_set_genre(struct t_album_songs *album_songs, const char *uri, const char *genre) {
+    struct mpd_song *song = new_album_song(uri, NULL, 10, 1000);
+    song_append_tag(song, MPD_TAG_GENRE, genre);
+    sds album_key = sdsnew("a");
+    sdsfree(album_songs_set(album_songs, song, album_key, &album_songs_tags));
+    sdsfree(album_key);
+    mpd_song_free(song);
+}
+
+UTEST(album_cache, test_album_songs_patch_tags) {
+    struct t_album_songs album_songs;
+    album_songs_init(&album_songs);
+    album_songs_test_set_genre(&album_songs, "music/a1.mp3", "Rock");
+    album_songs_test_set_genre(&album_songs, "music/a2.mp3", "Pop");
+
+    // album with an outdated tag value
+    rax *album_cache = raxNew();
+    struct t_album *album = album_new_uri("music/a1.mp3");
+    album_append_tag(album, MPD_TAG_ALBUM, "Tabula Rasa");
+    album_append_tag(album, MPD_TAG_GENRE, "Rokc");
+    raxInsert(album_cache, (unsigned char *)"a", 1, album, NULL);
+    rax *affected = raxNew();
+    raxInsert(affected, (unsigned char *)"a", 1, NULL, NULL);
+    album_songs_patch_albums(&album_songs, affected, album_cache, &album_songs_tags, false);
+    ASSERT_STREQ("Tabula Rasa", album_get_tag(album, MPD_TAG_ALBUM, 0));
+    ASSERT_STREQ("Einstürzende Neubauten", album_get_tag(album, MPD_TAG_ARTIST, 0));
+    ASSERT_STREQ("Blixa Bargeld", album_get_tag(album, MPD_TAG_ARTIST, 1));
+    ASSERT_TRUE(album_get_tag(album, MPD_TAG_ARTIST, 2) == NULL);
+    ASSERT_STREQ("Rock", album_get_tag(album, MPD_TAG_GENRE, 0));
+    ASSERT_STREQ("Pop", album_get_tag(album, MPD_TAG_GENRE, 1));
+    ASSERT_TRUE(album_get_tag(album, MPD_TAG_GENRE, 2) == NULL);
+    ASSERT_FALSE(album_get_unknown(album));
+
+    // fix the genre of the first song
+    album_songs_test_set_genre(&album_songs, "music/a1.mp3", "Jazz");
+    album_songs_patch_albums(&album_songs, affected, album_cache, &album_songs_tags, false);
+    ASSERT_STREQ("Jazz", album_get_tag(album, MPD_TAG_GENRE, 0));
+    ASSERT_STREQ("Pop", album_get_tag(album, MPD_TAG_GENRE, 1));
+    ASSERT_TRUE(album_get_tag(album, MPD_TAG_GENRE, 2) == NULL);
+    ASSERT_EQ(2U, album_get_song_count(album));
+    raxFree(affected);
+
+    album_cache_free_rt(album_cache);
+    album_songs_clear(&album_songs);
+}
+
+UTEST(album_cache, test_album_songs_read_write) {
+    init_testenv();
+    mkdir("/tmp/mympd-test/tags", 0770);
+    struct t_mympd_mpd_tags album_tags = album_songs_tags;
+    struct t_album_songs album_songs;
+    album_songs_init(&album_songs);
+    album_songs.db_mtime = 1699304451;
+    album_songs.db_songs = 2;
+    album_songs_test_set(&album_songs, "music/a1.mp3", "1", 10, 1000, "a");
+    album_songs_test_set(&album_songs, "music/single.mp3", NULL, 50, 5000, "");
+    ASSERT_TRUE(album_songs_write(&album_songs, workdir, &album_tags));
+    album_songs_clear(&album_songs);
+
+    album_songs_init(&album_songs);
+    ASSERT_TRUE(album_songs_read(&album_songs, workdir, &album_tags));
+    ASSERT_EQ((uint64_t)2, album_songs.songs->numele);
+    ASSERT_EQ(1699304451, album_songs.db_mtime);
+    ASSERT_EQ(2U, album_songs.db_songs);
+    // the album tags are saved only for songs of albums
+    void *data;
+    ASSERT_EQ(1, raxFind(album_songs.songs, (unsigned char *)"music/a1.mp3", 12, &data));
+    const struct t_album_song *album_song = (struct t_album_song *)data;
+    ASSERT_EQ(3U, album_song->tags_len);
+    ASSERT_EQ(MPD_TAG_ALBUM, album_song->tags[2].tag);
+    ASSERT_STREQ("Tabula Rasa", album_song->tags[2].value);
+    ASSERT_EQ(1, raxFind(album_songs.songs, (unsigned char *)"music/single.mp3", 16, &data));
+    ASSERT_EQ(0U, ((struct t_album_song *)data)->tags_len);
+    sds old_key = album_songs_remove(&album_songs, "music/a1.mp3", 12);
+    ASSERT_STREQ("a", old_key);
+    sdsfree(old_key);
+    album_songs_clear(&album_songs);
+
+    // changed album tags invalidate the index
+    album_tags.tags[album_tags.len++] = MPD_TAG_DATE;
+    album_songs_init(&album_songs);
+    ASSERT_FALSE(album_songs_read(&album_songs, workdir, &album_tags));
+    album_songs_clear(&album_songs);
+
+    ASSERT_TRUE(album_songs_remove_file(workdir));
+    clean_testenv();
+}
+
+UTEST(album_cache, test_album_tag_order) {
+    struct t_album *album = album_new();
+    ASSERT_TRUE(album_append_tag(album, MPD_TAG_GENRE, "Rock"));
+    ASSERT_TRUE(album_append_tag(album, MPD_TAG_ARTIST, "Artist 2"));
+    ASSERT_TRUE(album_append_tag(album, MPD_TAG_ARTIST, "Artist 1"));
+    ASSERT_TRUE(album_append_tag(album, MPD_TAG_GENRE, "Pop"));
+    ASSERT_TRUE(album_append_tag(album, MPD_TAG_ALBUM, "Album"));
+    // duplicate values are ignored
+    ASSERT_TRUE(album_append_tag(album, MPD_TAG_ARTIST, "Artist 2"));
+    ASSERT_FALSE(album_append_tag(album, MPD_TAG_COUNT, "Invalid"));
+
+    // values keep the insertion order
+    ASSERT_STREQ("Artist 2", album_get_tag(album, MPD_TAG_ARTIST, 0));
+    ASSERT_STREQ("Artist 1", album_get_tag(album, MPD_TAG_ARTIST, 1));
+    ASSERT_TRUE(album_get_tag(album, MPD_TAG_ARTIST, 2) == NULL);
+    ASSERT_STREQ("Rock", album_get_tag(album, MPD_TAG_GENRE, 0));
+    ASSERT_STREQ("Pop", album_get_tag(album, MPD_TAG_GENRE, 1));
+    ASSERT_STREQ("Album", album_get_tag(album, MPD_TAG_ALBUM, 0));
+    ASSERT_TRUE(album_get_tag(album, MPD_TAG_DATE, 0) == NULL);
+    album_free(album);
+}
+
+UTEST(album_cache, test_album_cache_memory) {
+    struct t_str_pool_stats before;
+    str_pool_get_stats(&before);
+    // 6000 albums of 200 artists with 20 genres
+    const unsigned album_count = 6000;
+    struct t_cache album_cache;
+    cache_init(&album_cache);
+    album_cache.cache = raxNew();
+    sds key = sdsempty();
+    sds value = sdsempty();
+    for (unsigned i = 0; i < album_count; i++) {
+        struct t_album *album = album_new_uri("music/artist/album/01 - title.flac");
+        sdsclear(value);
+        value = sdscatprintf(value, "Artist %u", i % 200);
+        album_append_tag(album, MPD_TAG_ARTIST, value);
+        album_append_tag(album, MPD_TAG_ALBUM_ARTIST, value);
+        sdsclear(value);
+        value = sdscatprintf(value, "Album %u", i);
+        album_append_tag(album, MPD_TAG_ALBUM, value);
+        sdsclear(value);
+        value = sdscatprintf(value, "Genre %u", i % 20);
+        album_append_tag(album, MPD_TAG_GENRE, value);
+        album_append_tag(album, MPD_TAG_DATE, "2024");
+        sdsclear(key);
+        key = sdscatfmt(key, "%u", i);
+        raxInsert(album_cache.cache, (unsigned char *)key, sdslen(key), album, NULL);
+    }
+    sdsfree(key);
+    sdsfree(value);
+
+    struct t_str_pool_stats stats;
+    str_pool_get_stats(&stats);
+    // artists, albums, genres and the date are stored only once
+    ASSERT_EQ(200U + album_count + 20 + 1, stats.values - before.values);
+    ASSERT_EQ((size_t)album_count * 5, stats.refs - before.refs);
+
+    sds buffer = album_cache_memory_stats(sdsempty(), &album_cache);
+    ASSERT_TRUE(strstr(buffer, "\"albums\":6000,") != NULL);
+    sdsfree(buffer);
+
+    album_cache_free(&album_cache);
+    cache_free(&album_cache);
+    str_pool_get_stats(&stats);
+    ASSERT_EQ(before.values, stats.values);
+}
+
+static rax *album_cache_test_create(unsigned album_count) {
+    rax *album_cache = raxNew();
+    sds key = sdsempty();
+    sds value = sdsempty();
+    for (unsigned i = 0; i < album_count; i++) {
+        sdsclear(value);
+        value = sdscatprintf(value, "music/artist %u/album %u/01 - title.flac", i % 2000, i);
+        struct t_album *album = album_new_uri(value);
+        sdsclear(value);
+        value = sdscatprintf(value, "Artist %u", i % 2000);
+        album_append_tag(album, MPD_TAG_ALBUM_ARTIST, value);
+        sdsclear(value);
+        value = sdscatprintf(value, "Album %u", i);
+        album_append_tag(album, MPD_TAG_ALBUM, value);
+        album_append_tag(album, MPD_TAG_GENRE, "Rock");
+        album_append_tag(album, MPD_TAG_GENRE, "Pop");
+        album_set_disc_count(album, 1 + i % 2);
+        album_set_song_count(album, 10);
+        album_set_total_time(album, 3000 + i);
+        album_set_last_modified(album, 1699304451 + i);
+        album_set_added(album, 1699300000 + i);
+        sdsclear(key);
+        key = sdscatprintf(key, "%08x", i);
+        raxInsert(album_cache, (unsigned char *)key, sdslen(key), album, NULL);
+    }
+    sdsfree(key);
+    sdsfree(value);
+    return album_cache;
+}
+
+static bool album_cache_test_write_mpack(rax *album_cache, const struct t_mympd_mpd_tags *album_tags,
+        const struct t_albums_config *album_config)
+{
+    // album cache file format of older myMPD versions
+    sds filepath = sdscatfmt(sdsempty(), "%S/%s/%s", workdir, DIR_WORK_TAGS, FILENAME_ALBUMCACHE_MPACK);
+    mpack_writer_t writer;
+    mpack_writer_init_filename(&writer, filepath);
+    sdsfree(filepath);
+    mpack_build_map(&writer);
+    mpack_write_kv(&writer, "cacheVersion", 1);
+    mpack_write_kv(&writer, "albumMode", album_config->mode);
+    mpack_write_kv(&writer, "albumGroupTag", album_config->group_tag);
+    mpack_write_kv(&writer, "albumUnknown", album_config->unknown);
+    mpack_write_cstr(&writer, "tags");
+    mpack_start_array(&writer, (uint32_t)album_tags->len);
+    for (size_t i = 0; i < album_tags->len; i++) {
+        mpack_write_cstr(&writer, mpd_tag_name(album_tags->tags[i]));
+    }
+    mpack_finish_array(&writer);
+    mpack_write_cstr(&writer, "albums");
+    mpack_start_array(&writer, (uint32_t)album_cache->numele);
+    raxIterator iter;
+    raxStart(&iter, album_cache);
+    raxSeek(&iter, "^", NULL, 0);
+    while (raxNext(&iter)) {
+        struct t_album *album = (struct t_album *)iter.data;
+        mpack_build_map(&writer);
+        mpack_write_kv(&writer, "uri", album_get_uri(album));
+        mpack_write_kv(&writer, "Discs", album_get_disc_count(album));
+        mpack_write_kv(&writer, "Songs", album_get_song_count(album));
+        mpack_write_kv(&writer, "Duration", album_get_total_time(album));
+        mpack_write_kv(&writer, "Last-Modified", (uint64_t)album_get_last_modified(album));
+        mpack_write_kv(&writer, "Added", (uint64_t)album_get_added(album));
+        mpack_write_cstr(&writer, "AlbumId");
+        mpack_write_str(&writer, (char *)iter.key, (uint32_t)iter.key_len);
+        for (size_t i = 0; i < album_tags->len; i++) {
+            enum mpd_tag_type tag = album_tags->tags[i];
+            if (album_get_tag(album, tag, 0) == NULL) {
+                continue;
+            }
+            mpack_write_cstr(&writer, mpd_tag_name(tag));
+            if (is_multivalue_tag(tag) == true) {
+                unsigned count = 0;
+                while (album_get_tag(album, tag, count) != NULL) {
+                    count++;
+                }
+                mpack_start_array(&writer, count);
+                for (unsigned j = 0; j < count; j++) {
+                    mpack_write_cstr(&writer, album_get_tag(album, tag, j));
+                }
+                mpack_finish_array(&writer);
+            }
+            else {
+                mpack_write_cstr(&writer, album_get_tag(album, tag, 0));
+            }
+        }
+        mpack_complete_map(&writer);
+    }
+    raxStop(&iter);
+    mpack_finish_array(&writer);
+    mpack_complete_map(&writer);
+    return mpack_writer_destroy(&writer) == mpack_ok;
+}
+
+UTEST(album_cache, test_album_cache_bin_read_write) {
+    init_testenv();
+    mkdir("/tmp/mympd-test/tags", 0770);
+    struct t_mympd_mpd_tags album_tags = {
+        .len = 3,
+        .tags = {MPD_TAG_ALBUM_ARTIST, MPD_TAG_ALBUM, MPD_TAG_GENRE}
+    };
+    struct t_albums_config album_config = {
+        .mode = ALBUM_MODE_ADV,
+        .group_tag = MPD_TAG_UNKNOWN,
+        .unknown = false
+    };
+    struct t_cache album_cache;
+    cache_init(&album_cache);
+    album_cache.cache = album_cache_test_create(3);
+    ASSERT_TRUE(album_cache_write(&album_cache, workdir, &album_tags, &album_config, true));
+    ASSERT_TRUE(album_cache.cache == NULL);
+
+    ASSERT_TRUE(album_cache_read(&album_cache, workdir, &album_config));
+    ASSERT_TRUE(album_cache.map != NULL);
+    ASSERT_EQ((uint64_t)3, album_cache.cache->numele);
+    sds key = sdsnew("00000001");
+    struct t_album *album = album_cache_get_album(&album_cache, key);
+    ASSERT_TRUE(album != NULL);
+    ASSERT_STREQ("music/artist 1/album 1/01 - title.flac", album_get_uri(album));
+    ASSERT_STREQ("Artist 1", album_get_tag(album, MPD_TAG_ALBUM_ARTIST, 0));
+    ASSERT_STREQ("Album 1", album_get_tag(album, MPD_TAG_ALBUM, 0));
+    ASSERT_STREQ("Rock", album_get_tag(album, MPD_TAG_GENRE, 0));
+    ASSERT_STREQ("Pop", album_get_tag(album, MPD_TAG_GENRE, 1));
+    ASSERT_EQ(2U, album_get_disc_count(album));
+    ASSERT_EQ(10U, album_get_song_count(album));
+    ASSERT_EQ(3001U, album_get_total_time(album));
+    ASSERT_EQ(1699304452, album_get_last_modified(album));
+    ASSERT_EQ(1699300001, album_get_added(album));
+
+    // changes of mapped albums are kept in memory
+    ASSERT_TRUE(album_append_tag(album, MPD_TAG_GENRE, "Jazz"));
+    album_set_uri(album, "music/changed.flac");
+    ASSERT_STREQ("Pop", album_get_tag(album, MPD_TAG_GENRE, 1));
+    ASSERT_STREQ("Jazz", album_get_tag(album, MPD_TAG_GENRE, 2));
+    ASSERT_STREQ("music/changed.flac", album_get_uri(album));
+
+    // the mapped file is replaced while in use
+    ASSERT_TRUE(album_cache_write(&album_cache, workdir, &album_tags, &album_config, false));
+    ASSERT_STREQ("Album 1", album_get_tag(album, MPD_TAG_ALBUM, 0));
+    album_cache_free(&album_cache);
+    ASSERT_TRUE(album_cache.map == NULL);
+
+    ASSERT_TRUE(album_cache_read(&album_cache, workdir, &album_config));
+    album = album_cache_get_album(&album_cache, key);
+    ASSERT_TRUE(album != NULL);
+    ASSERT_STREQ("Jazz", album_get_tag(album, MPD_TAG_GENRE, 2));
+    ASSERT_STREQ("music/changed.flac", album_get_uri(album));
+    album_cache_free(&album_cache);
+
+    // changed album settings discard the cache
+    album_config.unknown = true;
+    ASSERT_FALSE(album_cache_read(&album_cache, workdir, &album_config));
+    ASSERT_TRUE(album_cache.cache == NULL);
+    sds filepath = sdscatfmt(sdsempty(), "%S/%s/%s", workdir, DIR_WORK_TAGS, FILENAME_ALBUMCACHE);
+    ASSERT_FALSE(testfile_read(filepath));
+    sdsfree(filepath);
+    sdsfree(key);
+    cache_free(&album_cache);
+    clean_testenv();
+}
+
+UTEST(album_cache, test_album_cache_convert) {
+    init_testenv();
+    mkdir("/tmp/mympd-test/tags", 0770);
+    struct t_mympd_mpd_tags album_tags = {
+        .len = 3,
+        .tags = {MPD_TAG_ALBUM_ARTIST, MPD_TAG_ALBUM, MPD_TAG_GENRE}
+    };
+    struct t_albums_config album_config = {
+        .mode = ALBUM_MODE_ADV,
+        .group_tag = MPD_TAG_UNKNOWN,
+        .unknown = false
+    };
+    rax *legacy = album_cache_test_create(5);
+    ASSERT_TRUE(album_cache_test_write_mpack(legacy, &album_tags, &album_config));
+    album_cache_free_rt(legacy);
+
+    struct t_cache album_cache;
+    cache_init(&album_cache);
+    ASSERT_TRUE(album_cache_read(&album_cache, workdir, &album_config));
+    ASSERT_EQ((uint64_t)5, album_cache.cache->numele);
+    sds key = sdsnew("00000004");
+    struct t_album *album = album_cache_get_album(&album_cache, key);
+    ASSERT_TRUE(album != NULL);
+    ASSERT_STREQ("Album 4", album_get_tag(album, MPD_TAG_ALBUM, 0));
+    ASSERT_STREQ("Pop", album_get_tag(album, MPD_TAG_GENRE, 1));
+    ASSERT_EQ(3004U, album_get_total_time(album));
+    sdsfree(key);
+    album_cache_free(&album_cache);
+    cache_free(&album_cache);
+
+    // the legacy file is replaced by the binary file
+    sds filepath = sdscatfmt(sdsempty(), "%S/%s/%s", workdir, DIR_WORK_TAGS, FILENAME_ALBUMCACHE_MPACK);
+    ASSERT_FALSE(testfile_read(filepath));
+    sdsclear(filepath);
+    filepath = sdscatfmt(filepath, "%S/%s/%s", workdir, DIR_WORK_TAGS, FILENAME_ALBUMCACHE);
+    ASSERT_TRUE(testfile_read(filepath));
+    sdsfree(filepath);
+    ASSERT_TRUE(album_cache_remove(workdir));
+    clean_testenv();
+}
@@ -0,0 +1,110 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2026 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+#include "compile_time.h"
+#include "utility.h"
+
+#include "dist/utest/utest.h"
+#include "src/lib/cache/cache_disk_index.h"
+#include "src/lib/filehandler.h"
+#include "src/lib/sds/sds_extras.h"
+
+#include <string.h>
+#include <sys/stat.h>
+#include <utime.h>
+
+static sds write_cache_file(const char *name, size_t size, time_t mtime) {
+    sds filepath = sdscatfmt(sdsempty(), "/tmp/mympd-test/%s/%s", DIR_CACHE_COVER, name);
+    sds data = sdsgrowzero(sdsempty(), size);
+    write_data_to_file(filepath, data, size);
+    struct utimbuf times = {.actime = mtime, .modtime = mtime};
+    utime(filepath, &times);
+    FREE_SDS(data);
+    return filepath;
+}
+
+static void create_cache_files(void) {
+    init_testenv();
+    mkdir("/tmp/mympd-test/" DIR_CACHE_COVER, 0770);
+    time_t now = time(NULL);
+    // file0 is the least recently used file
+    for (int i = 0; i < 5; i++) {
+        sds name = sdscatfmt(sdsempty(), "file%i", i);
+        sds filepath = write_cache_file(name, 1000, now - (5 - i) * 86400);
+        FREE_SDS(filepath);
+        FREE_SDS(name);
+    }
+}
+
+UTEST(cache_disk_index, test_cache_disk_index_sync) {
+    create_cache_files();
+    ASSERT_TRUE(cache_disk_index_type(DIR_CACHE_COVER) == CACHE_DISK_TYPE_COVER);
+    ASSERT_TRUE(cache_disk_index_type("unknown") == CACHE_DISK_TYPE_COUNT);
+    ASSERT_TRUE(cache_disk_index_sync("/tmp/mympd-test", CACHE_DISK_TYPE_COVER));
+    ASSERT_EQ((uint64_t)5000, cache_disk_index_bytes(CACHE_DISK_TYPE_COVER));
+
+    // vanished files are removed, new files are added
+    rm_file("/tmp/mympd-test/" DIR_CACHE_COVER "/file1");
+    sds filepath = write_cache_file("file5", 500, time(NULL));
+    FREE_SDS(filepath);
+    ASSERT_TRUE(cache_disk_index_sync("/tmp/mympd-test", CACHE_DISK_TYPE_COVER));
+    ASSERT_EQ((uint64_t)4500, cache_disk_index_bytes(CACHE_DISK_TYPE_COVER));
+
+    sds stats = cache_disk_index_stats(sdsempty());
+    ASSERT_TRUE(strstr(stats, "\"cover\":{\"indexed\":true,\"files\":5,\"bytes\":4500,") != NULL);
+    FREE_SDS(stats);
+
+    cache_disk_index_free();
+    clean_testenv();
+}
+
+UTEST(cache_disk_index, test_cache_disk_index_crop) {
+    create_cache_files();
+    // nothing is cropped before the index is built
+    ASSERT_EQ(0U, cache_disk_index_crop("/tmp/mympd-test", CACHE_DISK_TYPE_COVER, time(NULL), 0, 100, NULL));
+    ASSERT_TRUE(cache_disk_index_sync("/tmp/mympd-test", CACHE_DISK_TYPE_COVER));
+
+    // expired files
+    time_t expire_time = time(NULL) - 4 * 86400 + 60;
+    ASSERT_EQ(2U, cache_disk_index_crop("/tmp/mympd-test", CACHE_DISK_TYPE_COVER, expire_time, 0, 100, NULL));
+    ASSERT_FALSE(testfile_read("/tmp/mympd-test/" DIR_CACHE_COVER "/file0"));
+    ASSERT_FALSE(testfile_read("/tmp/mympd-test/" DIR_CACHE_COVER "/file1"));
+    ASSERT_TRUE(testfile_read("/tmp/mympd-test/" DIR_CACHE_COVER "/file2"));
+
+    // the touched file is the most recently used file
+    cache_disk_index_touch("/tmp/mympd-test/" DIR_CACHE_COVER "/file2");
+
+    // size budget, limited by the number of files per call
+    ASSERT_EQ(1U, cache_disk_index_crop("/tmp/mympd-test", CACHE_DISK_TYPE_COVER, 0, 1000, 1, NULL));
+    ASSERT_EQ(1U, cache_disk_index_crop("/tmp/mympd-test", CACHE_DISK_TYPE_COVER, 0, 1000, 1, NULL));
+    ASSERT_EQ(0U, cache_disk_index_crop("/tmp/mympd-test", CACHE_DISK_TYPE_COVER, 0, 1000, 1, NULL));
+    ASSERT_EQ((uint64_t)1000, cache_disk_index_bytes(CACHE_DISK_TYPE_COVER));
+    ASSERT_TRUE(testfile_read("/tmp/mympd-test/" DIR_CACHE_COVER "/file2"));
+    ASSERT_FALSE(testfile_read("/tmp/mympd-test/" DIR_CACHE_COVER "/file4"));
+
+    // written files are added as most recently used
+    sds filepath = write_cache_file("file6", 1000, time(NULL));
+    cache_disk_index_add(filepath);
+    FREE_SDS(filepath);
+    ASSERT_EQ((uint64_t)2000, cache_disk_index_bytes(CACHE_DISK_TYPE_COVER));
+    ASSERT_EQ(1U, cache_disk_index_crop("/tmp/mympd-test", CACHE_DISK_TYPE_COVER, 0, 1000, 100, NULL));
+    ASSERT_FALSE(testfile_read("/tmp/mympd-test/" DIR_CACHE_COVER "/file2"));
+    ASSERT_TRUE(testfile_read("/tmp/mympd-test/" DIR_CACHE_COVER "/file6"));
+
+    cache_disk_index_free();
+    clean_testenv();
+}
+
+UTEST(cache_disk_index, test_cache_disk_index_count) {
+    cache_disk_index_count(CACHE_DISK_TYPE_LYRICS, true);
+    cache_disk_index_count(CACHE_DISK_TYPE_LYRICS, true);
+    cache_disk_index_count(CACHE_DISK_TYPE_LYRICS, true);
+    cache_disk_index_count(CACHE_DISK_TYPE_LYRICS, false);
+    sds stats = cache_disk_index_stats(sdsempty());
+    ASSERT_TRUE(strstr(stats, "\"hits\":3,\"misses\":1,\"hitRate\":75,") != NULL);
+    FREE_SDS(stats);
+    cache_disk_index_free();
+}
@@ -0,0 +1,130 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2026 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+#include "compile_time.h"
+#include "utility.h"
+
+#include "dist/utest/utest.h"
+#include "src/lib/sds/sds_extras.h"
+#include "src/webserver/compression.h"
+
+#include <string.h>
+#include <zlib.h>
+
+static sds create_json(int entries) {
+    sds json = sdsnew("{\"jsonrpc\":\"2.0\",\"result\":{\"data\":[");
+    for (int i = 0; i < entries; i++) {
+        json = sdscatfmt(json, "%s{\"Title\":\"Title %i\",\"Artist\":[\"Artist %i\"],\"Duration\":%i}",
+            (i > 0 ? "," : ""), i, i % 10, i);
+    }
+    return sdscat(json, "]}}");
+}
+
+static sds inflate_data(z_stream *zs, const char *data, size_t len, bool ws) {
+    sds out = sdsempty();
+    out = sdsMakeRoomFor(out, 1024 * 1024);
+    zs->next_out = (Bytef *)out;
+    zs->avail_out = 1024 * 1024;
+    zs->next_in = (Bytef *)data;
+    zs->avail_in = (uInt)len;
+    inflate(zs, Z_SYNC_FLUSH);
+    if (ws == true) {
+        unsigned char tail[4] = {0x00, 0x00, 0xff, 0xff};
+        zs->next_in = tail;
+        zs->avail_in = 4;
+        inflate(zs, Z_SYNC_FLUSH);
+    }
+    sdsIncrLen(out, (ssize_t)(1024 * 1024 - zs->avail_out));
+    return out;
+}
+
+UTEST(compression, test_compression_accept_encoding) {
+    struct mg_str header = mg_str("gzip, deflate, br");
+    ASSERT_TRUE(compression_accept_encoding(&header) == COMPRESSION_GZIP);
+    header = mg_str("deflate;q=0.5,gzip;q=0");
+    ASSERT_TRUE(compression_accept_encoding(&header) == COMPRESSION_DEFLATE);
+    header = mg_str("br, identity");
+    ASSERT_TRUE(compression_accept_encoding(&header) == COMPRESSION_NONE);
+    ASSERT_TRUE(compression_accept_encoding(NULL) == COMPRESSION_NONE);
+    header = mg_str("permessage-deflate; client_max_window_bits");
+    ASSERT_TRUE(compression_ws_offered(&header));
+    header = mg_str("x-webkit-deflate-frame");
+    ASSERT_FALSE(compression_ws_offered(&header));
+}
+
+UTEST(compression, test_compression_http) {
+    sds json = create_json(1000);
+    struct t_compression_stream *stream = NULL;
+    struct t_compression_stats stats;
+    compression_stats_init(&stats);
+    const enum compression_encoding encodings[] = {COMPRESSION_GZIP, COMPRESSION_GZIP, COMPRESSION_DEFLATE};
+    const int window_bits[] = {MAX_WBITS + 16, MAX_WBITS + 16, MAX_WBITS};
+    for (int i = 0; i < 3; i++) {
+        // the stream is reused for the second response
+        sds compressed = sdsempty();
+        ASSERT_TRUE(compression_deflate(&stream, encodings[i], 6, json, sdslen(json), &compressed, &stats));
+        ASSERT_LT(sdslen(compressed), sdslen(json) / 4);
+        z_stream zs;
+        memset(&zs, 0, sizeof(zs));
+        ASSERT_EQ(Z_OK, inflateInit2(&zs, window_bits[i]));
+        sds inflated = inflate_data(&zs, compressed, sdslen(compressed), false);
+        inflateEnd(&zs);
+        ASSERT_STREQ(json, inflated);
+        FREE_SDS(inflated);
+        FREE_SDS(compressed);
+    }
+    ASSERT_EQ((uint64_t)3, stats.count);
+    ASSERT_EQ((uint64_t)sdslen(json) * 3, stats.bytes_in);
+    compression_stream_free(stream);
+    FREE_SDS(json);
+}
+
+UTEST(compression, test_compression_websocket) {
+    sds json = create_json(50);
+    struct t_compression_stream *stream = NULL;
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    ASSERT_EQ(Z_OK, inflateInit2(&zs, -MAX_WBITS));
+    size_t first_len = 0;
+    for (int i = 0; i < 2; i++) {
+        sds compressed = sdsempty();
+        ASSERT_TRUE(compression_deflate(&stream, COMPRESSION_WS_DEFLATE, 6, json, sdslen(json), &compressed, NULL));
+        // the tail of the deflate block is stripped
+        ASSERT_NE(0, memcmp(compressed + sdslen(compressed) - 4, "\x00\x00\xff\xff", 4));
+        if (i == 0) {
+            first_len = sdslen(compressed);
+        }
+        else {
+            // context takeover: the repeated message is much smaller
+            ASSERT_LT(sdslen(compressed), first_len / 4);
+        }
+        sds inflated = inflate_data(&zs, compressed, sdslen(compressed), true);
+        ASSERT_STREQ(json, inflated);
+        FREE_SDS(inflated);
+        FREE_SDS(compressed);
+    }
+    inflateEnd(&zs);
+    compression_stream_free(stream);
+    FREE_SDS(json);
+}
+
+UTEST(compression, test_compression_ws_inflate) {
+    struct t_compression_stream *stream = NULL;
+    sds compressed = sdsempty();
+    ASSERT_TRUE(compression_deflate(&stream, COMPRESSION_WS_DEFLATE, 6, "id:123456", 9, &compressed, NULL));
+    sds inflated = sdsempty();
+    ASSERT_TRUE(compression_ws_inflate(compressed, sdslen(compressed), 9, &inflated));
+    ASSERT_STREQ("id:123456", inflated);
+    sdsclear(inflated);
+    // too long
+    ASSERT_FALSE(compression_ws_inflate(compressed, sdslen(compressed), 8, &inflated));
+    ASSERT_EQ(0U, sdslen(inflated));
+    // invalid
+    ASSERT_FALSE(compression_ws_inflate("\xff\xff\xff", 3, 9, &inflated));
+    FREE_SDS(inflated);
+    FREE_SDS(compressed);
+    compression_stream_free(stream);
+}
@@ -0,0 +1,90 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2026 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+#include "compile_time.h"
+#include "utility.h"
+
+#include "dist/utest/utest.h"
+#include "src/lib/dir_cache.h"
+
+#include <string.h>
+
+static struct t_dir_listing *dir_listing_test_new(const char *path) {
+    struct t_dir_listing *listing = dir_listing_new(path);
+    dir_listing_append(listing, MPD_ENTITY_TYPE_PLAYLIST, "music/rock.m3u", sdsnew("rock.m3u"), NULL);
+    dir_listing_append(listing, MPD_ENTITY_TYPE_DIRECTORY, "music/pop", sdsnew("pop"), NULL);
+    dir_listing_append(listing, MPD_ENTITY_TYPE_DIRECTORY, "music/Jazz", sdsnew("Jazz"), NULL);
+    dir_listing_append(listing, MPD_ENTITY_TYPE_PLAYLIST, "music/jazz.pls", sdsnew("jazz.pls"), NULL);
+    dir_listing_append(listing, MPD_ENTITY_TYPE_DIRECTORY, "music/blues", sdsnew("blues"), NULL);
+    dir_listing_commit(listing);
+    return listing;
+}
+
+UTEST(dir_cache, test_dir_listing_page) {
+    struct t_dir_listing *listing = dir_listing_test_new("music");
+    ASSERT_EQ(5U, listing->length);
+    // directories first, then playlists
+    ASSERT_STREQ("blues", listing->entries[0].name);
+    ASSERT_STREQ("Jazz", listing->entries[1].name);
+    ASSERT_STREQ("pop", listing->entries[2].name);
+    ASSERT_STREQ("jazz.pls", listing->entries[3].name);
+    ASSERT_STREQ("rock.m3u", listing->entries[4].name);
+    unsigned page[2];
+    unsigned returned;
+    ASSERT_EQ(5U, dir_listing_page(listing, "", 0, 1, 2, page, &returned));
+    ASSERT_EQ(2U, returned);
+    ASSERT_STREQ("Jazz", listing->entries[page[0]].name);
+    ASSERT_STREQ("pop", listing->entries[page[1]].name);
+    ASSERT_EQ(5U, dir_listing_page(listing, "", 0, 4, 2, page, &returned));
+    ASSERT_EQ(1U, returned);
+    // case insensitive substring search
+    ASSERT_EQ(2U, dir_listing_page(listing, "JAZZ", 4, 0, 2, page, &returned));
+    ASSERT_EQ(2U, returned);
+    ASSERT_STREQ("Jazz", listing->entries[page[0]].name);
+    ASSERT_STREQ("jazz.pls", listing->entries[page[1]].name);
+    ASSERT_EQ(2U, dir_listing_page(listing, "jazz", 4, 1, 2, page, &returned));
+    ASSERT_EQ(1U, returned);
+    ASSERT_STREQ("jazz.pls", listing->entries[page[0]].name);
+    ASSERT_EQ(0U, dir_listing_page(listing, "classic", 7, 0, 2, page, &returned));
+    ASSERT_EQ(0U, returned);
+    dir_listing_free(listing);
+}
+
+UTEST(dir_cache, test_dir_cache_lru) {
+    struct t_dir_listing *listing1 = dir_listing_test_new("dir1");
+    struct t_dir_cache cache;
+    // budget for two listings
+    dir_cache_init(&cache, listing1->size * 2 + listing1->size / 2);
+    ASSERT_TRUE(dir_cache_get(&cache, "dir1") == NULL);
+    ASSERT_TRUE(dir_cache_add(&cache, listing1));
+    ASSERT_TRUE(dir_cache_add(&cache, dir_listing_test_new("dir2")));
+    ASSERT_TRUE(dir_cache_get(&cache, "dir1") == listing1);
+    // dir2 is the least recently used listing
+    ASSERT_TRUE(dir_cache_add(&cache, dir_listing_test_new("dir3")));
+    ASSERT_EQ(2U, (unsigned)cache.listings->numele);
+    ASSERT_TRUE(dir_cache_get(&cache, "dir2") == NULL);
+    ASSERT_TRUE(dir_cache_get(&cache, "dir1") != NULL);
+    ASSERT_TRUE(dir_cache_get(&cache, "dir3") != NULL);
+    ASSERT_EQ(3U, (unsigned)cache.hits);
+    ASSERT_EQ(2U, (unsigned)cache.misses);
+    // listings larger than the budget are not cached
+    struct t_dir_cache small;
+    dir_cache_init(&small, 16);
+    struct t_dir_listing *listing4 = dir_listing_test_new("dir4");
+    ASSERT_FALSE(dir_cache_add(&small, listing4));
+    dir_listing_free(listing4);
+    dir_cache_free(&small);
+    // clear keeps the metrics
+    dir_cache_clear(&cache);
+    ASSERT_EQ(0U, (unsigned)cache.size);
+    ASSERT_TRUE(cache.lru.head == NULL);
+    ASSERT_EQ(3U, (unsigned)cache.hits);
+    sds stats = dir_cache_stats(sdsempty(), &cache);
+    ASSERT_TRUE(strstr(stats, "\"listings\":0,\"bytes\":0,") != NULL);
+    ASSERT_TRUE(strstr(stats, "\"hits\":3,\"misses\":2}") != NULL);
+    sdsfree(stats);
+    dir_cache_free(&cache);
+}
@@ -0,0 +1,73 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2026 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+#include "compile_time.h"
+#include "utility.h"
+
+#include "dist/utest/utest.h"
+#include "src/lib/histogram.h"
+#include "src/lib/sds/sds_extras.h"
+
+UTEST(histogram, test_histogram_add) {
+    struct t_histogram histogram;
+    histogram_init(&histogram);
+    ASSERT_EQ(0U, histogram_percentile(&histogram, 50));
+
+    histogram_add(&histogram, 100);   // bucket 0
+    histogram_add(&histogram, 250);   // bucket 0, bounds are inclusive
+    histogram_add(&histogram, 251);   // bucket 1
+    histogram_add(&histogram, 3000);  // bucket 4
+    histogram_add(&histogram, UINT64_MAX / 2);  // last bucket
+    ASSERT_EQ(5U, histogram.count);
+    ASSERT_EQ(2U, histogram.buckets[0]);
+    ASSERT_EQ(1U, histogram.buckets[1]);
+    ASSERT_EQ(1U, histogram.buckets[4]);
+    ASSERT_EQ(1U, histogram.buckets[HISTOGRAM_BUCKETS - 1]);
+    ASSERT_EQ(UINT64_MAX / 2, histogram.max_us);
+    ASSERT_EQ(UINT64_MAX, histogram_bucket_bound(HISTOGRAM_BUCKETS - 1));
+}
+
+UTEST(histogram, test_histogram_percentile) {
+    struct t_histogram histogram;
+    histogram_init(&histogram);
+    for (unsigned i = 0; i < 90; i++) {
+        histogram_add(&histogram, 200);
+    }
+    for (unsigned i = 0; i < 10; i++) {
+        histogram_add(&histogram, 1500);
+    }
+    ASSERT_EQ(250U, histogram_percentile(&histogram, 50));
+    ASSERT_EQ(250U, histogram_percentile(&histogram, 90));
+    // bucket bound is 2000, capped by the maximum
+    ASSERT_EQ(1500U, histogram_percentile(&histogram, 95));
+    ASSERT_EQ(1500U, histogram_percentile(&histogram, 100));
+}
+
+UTEST(histogram, test_histogram_merge) {
+    struct t_histogram h1;
+    struct t_histogram h2;
+    histogram_init(&h1);
+    histogram_init(&h2);
+    histogram_add(&h1, 10);
+    histogram_add(&h2, 600);
+    histogram_add(&h2, 700);
+    histogram_merge(&h1, &h2);
+    ASSERT_EQ(3U, h1.count);
+    ASSERT_EQ(1310U, h1.sum_us);
+    ASSERT_EQ(700U, h1.max_us);
+    ASSERT_EQ(2U, h1.buckets[2]);
+}
+
+UTEST(histogram, test_histogram_tojson) {
+    struct t_histogram histogram;
+    histogram_init(&histogram);
+    histogram_add(&histogram, 1000);
+    sds s = histogram_tojson(sdsempty(), "latency", &histogram, false);
+    ASSERT_TRUE(strstr(s, "\"latency\":{\"count\":1,\"avgUs\":1000,\"maxUs\":1000,") == s);
+    ASSERT_TRUE(strstr(s, "{\"leUs\":1000,\"count\":1}") != NULL);
+    ASSERT_TRUE(strstr(s, "{\"leUs\":null,\"count\":0}]}") != NULL);
+    sdsfree(s);
+}
@@ -7,15 +7,21 @@
 #include "compile_time.h"
 #include "utility.h"
 
+#include "dist/mpack/mpack.h"
 #include "dist/sds/sds.h"
 #include "dist/utest/utest.h"
 #include "src/lib/http_client/http_client.h"
 #include "src/lib/http_client/http_client_cache.h"
+#include "src/lib/filehandler.h"
 #include "src/lib/list/list.h"
+#include "src/lib/sds/sds_hash.h"
 
 #include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
 
-UTEST(http_client, test_http_client_cache) {
+UTEST(http_client_cache, test_http_client_cache) {
     init_testenv();
 
     struct t_config config;
@@ -55,5 +61,172 @@ UTEST(http_client, test_http_client_cache) {
     http_client_response_clear(cached);
     free(cached);
     sdsfree(config.cachedir);
+    http_client_cache_mem_clear();
+    clean_testenv();
+}
+
+static sds cache_filepath(const char *uri) {
+    sds hash = sds_hash_sha256(uri);
+    sds filepath = sdscatfmt(sdsempty(), "/tmp/mympd-test/http/%S", hash);
+    sdsfree(hash);
+    return filepath;
+}
+
+static void free_response(struct mg_client_response_t *response) {
+    http_client_response_clear(response);
+    free(response);
+}
+
+UTEST(http_client_cache, test_http_client_cache_file) {
+    init_testenv();
+
+    struct t_config config;
+    config.cache_http_keep_days = 31;
+    config.cachedir = sdsnew("/tmp/mympd-test");
+    const char *uri = "https://github.com/jcorporation/file";
+
+    struct mg_client_response_t rw;
+    http_client_response_init(&rw);
+    rw.response_code = 404;
+    list_push(&rw.header, "Content-Type", 0, "application/octet-stream", NULL);
+    rw.body = sdscatlen(rw.body, "bin\0ary", 7);
+    ASSERT_TRUE(http_client_cache_write(&config, uri, &rw));
+
+    // read the file directly, bypassing the in-memory tier
+    sds filepath = cache_filepath(uri);
+    struct mg_client_response_t *cached = http_client_cache_read(filepath);
+    assert(cached);
+    ASSERT_EQ(0, cached->rc);
+    ASSERT_EQ(404, cached->response_code);
+    ASSERT_EQ(1U, cached->header.length);
+    ASSERT_STREQ("Content-Type", cached->header.head->key);
+    ASSERT_EQ(7U, sdslen(cached->body));
+    ASSERT_EQ(0, memcmp(rw.body, cached->body, 7));
+    free_response(cached);
+
+    // a truncated file is removed
+    ASSERT_EQ(0, truncate(filepath, 10));
+    ASSERT_TRUE(http_client_cache_read(filepath) == NULL);
+    ASSERT_FALSE(testfile_read(filepath));
+
+    http_client_response_clear(&rw);
+    sdsfree(filepath);
+    sdsfree(config.cachedir);
+    http_client_cache_mem_clear();
+    clean_testenv();
+}
+
+UTEST(http_client_cache, test_http_client_cache_mpack_file) {
+    init_testenv();
+
+    // cache file in the mpack format of older myMPD versions
+    sds filepath = cache_filepath("https://github.com/jcorporation/mpack");
+    FILE *fp = fopen(filepath, "w");
+    assert(fp);
+    mpack_writer_t writer;
+    mpack_writer_init_stdfile(&writer, fp, true);
+    mpack_build_map(&writer);
+    mpack_write_kv(&writer, "code", 200);
+    mpack_write_cstr(&writer, "header");
+    mpack_start_array(&writer, 2);
+    mpack_write_cstr(&writer, "Test-Header");
+    mpack_write_cstr(&writer, "Test-Value");
+    mpack_finish_array(&writer);
+    mpack_write_cstr(&writer, "body");
+    mpack_write_bin(&writer, "Testbody", 8);
+    mpack_complete_map(&writer);
+    ASSERT_TRUE(mpack_writer_destroy(&writer) == mpack_ok);
+
+    struct mg_client_response_t *cached = http_client_cache_read(filepath);
+    assert(cached);
+    ASSERT_EQ(200, cached->response_code);
+    ASSERT_EQ(1U, cached->header.length);
+    ASSERT_STREQ("Test-Value", cached->header.head->value_p);
+    ASSERT_STREQ("Testbody", cached->body);
+    free_response(cached);
+
+    sdsfree(filepath);
+    clean_testenv();
+}
+
+UTEST(http_client_cache, test_http_client_cache_mem) {
+    init_testenv();
+
+    struct t_config config;
+    config.cache_http_keep_days = 31;
+    config.cachedir = sdsnew("/tmp/mympd-test");
+    const char *uri = "https://github.com/jcorporation/mem";
+
+    struct mg_client_response_t rw;
+    http_client_response_init(&rw);
+    rw.rc = 0;
+    rw.response_code = 200;
+    rw.body = sdscat(rw.body, "Testbody");
+    ASSERT_TRUE(http_client_cache_write(&config, uri, &rw));
+    ASSERT_GT(http_client_cache_mem_size(), 0U);
+
+    // served from memory without the cache file
+    sds filepath = cache_filepath(uri);
+    sds moved = sdscatfmt(sdsempty(), "%S.moved", filepath);
+    ASSERT_EQ(0, rename(filepath, moved));
+    struct mg_client_response_t *cached = http_client_cache_check(&config, uri);
+    assert(cached);
+    ASSERT_STREQ("Testbody", cached->body);
+    free_response(cached);
+
+    // the pending mtime update is written on flush
+    ASSERT_EQ(0, rename(moved, filepath));
+    http_client_cache_mem_flush(config.cache_http_keep_days);
+    ASSERT_GT(http_client_cache_mem_size(), 0U);
+
+    // entries are dropped on flush if the cache file was removed
+    cached = http_client_cache_check(&config, uri);
+    free_response(cached);
+    rm_file(filepath);
+    http_client_cache_mem_flush(config.cache_http_keep_days);
+    ASSERT_EQ(0U, http_client_cache_mem_size());
+    ASSERT_TRUE(http_client_cache_check(&config, uri) == NULL);
+
+    http_client_response_clear(&rw);
+    sdsfree(filepath);
+    sdsfree(moved);
+    sdsfree(config.cachedir);
+    http_client_cache_mem_clear();
+    clean_testenv();
+}
+
+UTEST(http_client_cache, test_http_client_cache_mem_evict) {
+    init_testenv();
+
+    struct t_config config;
+    config.cache_http_keep_days = 31;
+    config.cachedir = sdsnew("/tmp/mympd-test");
+
+    struct mg_client_response_t rw;
+    http_client_response_init(&rw);
+    rw.rc = 0;
+    rw.response_code = 200;
+    rw.body = sdsgrowzero(rw.body, HTTP_CLIENT_CACHE_MEM_ENTRY_MAX / 2);
+    int count = (HTTP_CLIENT_CACHE_MEM_MAX / (HTTP_CLIENT_CACHE_MEM_ENTRY_MAX / 2)) + 4;
+    for (int i = 0; i < count; i++) {
+        sds uri = sdscatfmt(sdsempty(), "https://github.com/jcorporation/%i", i);
+        ASSERT_TRUE(http_client_cache_write(&config, uri, &rw));
+        ASSERT_LE(http_client_cache_mem_size(), (size_t)HTTP_CLIENT_CACHE_MEM_MAX);
+        sdsfree(uri);
+    }
+    // the first entry was evicted and is read from disk
+    sds filepath = cache_filepath("https://github.com/jcorporation/0");
+    rm_file(filepath);
+    ASSERT_TRUE(http_client_cache_check(&config, "https://github.com/jcorporation/0") == NULL);
+    sdsfree(filepath);
+
+    // responses larger than the entry limit are only cached on disk
+    http_client_cache_mem_clear();
+    rw.body = sdsgrowzero(rw.body, HTTP_CLIENT_CACHE_MEM_ENTRY_MAX);
+    ASSERT_TRUE(http_client_cache_write(&config, "https://github.com/jcorporation/large", &rw));
+    ASSERT_EQ(0U, http_client_cache_mem_size());
+
+    http_client_response_clear(&rw);
+    sdsfree(config.cachedir);
     clean_testenv();
 }
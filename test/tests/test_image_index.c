@@ -0,0 +1,59 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2026 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+#include "compile_time.h"
+#include "utility.h"
+
+#include "dist/utest/utest.h"
+#include "src/lib/image_index.h"
+
+UTEST(image_index, test_image_index_get_set) {
+    struct t_image_index *image_index = image_index_new();
+    const char *key = "/music/album/folder";
+    ASSERT_TRUE(image_index_get(image_index, key, strlen(key)) == NULL);
+
+    image_index_set(image_index, IMAGE_INDEX_SCOPE_MUSIC, key, strlen(key), "/music/album/folder.jpg", 23);
+    sds path = image_index_get(image_index, key, strlen(key));
+    ASSERT_TRUE(path != NULL);
+    ASSERT_STREQ("/music/album/folder.jpg", path);
+
+    // replace the entry
+    image_index_set(image_index, IMAGE_INDEX_SCOPE_MUSIC, key, strlen(key), "", 0);
+    path = image_index_get(image_index, key, strlen(key));
+    ASSERT_TRUE(path != NULL);
+    ASSERT_EQ(0U, sdslen(path));
+    ASSERT_EQ(1U, (unsigned)image_index->entries->numele);
+
+    image_index_clear(image_index);
+    ASSERT_TRUE(image_index_get(image_index, key, strlen(key)) == NULL);
+    image_index_free(image_index);
+}
+
+UTEST(image_index, test_image_index_invalidate) {
+    struct t_image_index *image_index = image_index_new();
+    const char *hit = "/cache/covercache/hit";
+    const char *miss = "/cache/covercache/miss";
+    const char *music = "/music/album/cover";
+    image_index_set(image_index, IMAGE_INDEX_SCOPE_CACHE, hit, strlen(hit), "/cache/covercache/hit.jpg", 25);
+    image_index_set(image_index, IMAGE_INDEX_SCOPE_CACHE, miss, strlen(miss), "", 0);
+    image_index_set(image_index, IMAGE_INDEX_SCOPE_MUSIC, music, strlen(music), "", 0);
+
+    // adding files invalidates only the negative entries of the scope
+    image_index_files_added(IMAGE_INDEX_SCOPE_CACHE);
+    ASSERT_TRUE(image_index_get(image_index, hit, strlen(hit)) != NULL);
+    ASSERT_TRUE(image_index_get(image_index, miss, strlen(miss)) == NULL);
+    ASSERT_TRUE(image_index_get(image_index, music, strlen(music)) != NULL);
+
+    // removing files invalidates all entries of the scope
+    image_index_files_removed(IMAGE_INDEX_SCOPE_CACHE);
+    ASSERT_TRUE(image_index_get(image_index, hit, strlen(hit)) == NULL);
+    ASSERT_TRUE(image_index_get(image_index, music, strlen(music)) != NULL);
+
+    image_index_files_removed(IMAGE_INDEX_SCOPE_MUSIC);
+    ASSERT_TRUE(image_index_get(image_index, music, strlen(music)) == NULL);
+    ASSERT_EQ(0U, (unsigned)image_index->entries->numele);
+    image_index_free(image_index);
+}
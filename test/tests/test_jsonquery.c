@@ -266,3 +266,62 @@ UTEST(jsonquery, test_json_get_fields_as_string) {
     FREE_SDS(cols);
     FREE_SDS(data);
 }
+
+static sds json_query_test_lookups(sds data, sds result) {
+    bool bool_buf;
+    int int_buf;
+    unsigned uint_buf;
+    sds sds_buf = NULL;
+    struct t_list l;
+    list_init(&l);
+    result = sdscatfmt(result, "method:%i,", json_get_string_cmp(data, "$.method", 1, 100, "MYMPD_API_QUEUE_SEARCH", &sds_buf, NULL));
+    FREE_SDS(sds_buf);
+    result = sdscatfmt(result, "id:%i,", json_get_int_max(data, "$.id", &int_buf, NULL));
+    result = sdscatfmt(result, "%i,", int_buf);
+    result = sdscatfmt(result, "play:%i,", json_get_bool(data, "$.params.play", &bool_buf, NULL));
+    result = sdscatfmt(result, "%i,", bool_buf);
+    result = sdscatfmt(result, "offset:%i,", json_get_uint(data, "$.params.offset", 0, 100, &uint_buf, NULL));
+    result = sdscatfmt(result, "%u,", uint_buf);
+    if (json_get_string(data, "$.params.expression", 0, 100, &sds_buf, vcb_isname, NULL) == true) {
+        result = sdscatfmt(result, "expression:%S,", sds_buf);
+    }
+    FREE_SDS(sds_buf);
+    result = sdscatfmt(result, "uris:%i,", json_get_array_string(data, "$.params.uris", &l, vcb_isuri, 10, NULL));
+    result = sdscatfmt(result, "%u,", l.length);
+    list_clear(&l);
+    result = sdscatfmt(result, "fields:%i,", json_get_object_string(data, "$.params.fields", &l, vcb_isname, vcb_isname, 10, NULL));
+    result = sdscatfmt(result, "%u,", l.length);
+    list_clear(&l);
+    sds_buf = json_get_key_as_sds(data, "$.params.uris[1]");
+    if (sds_buf != NULL) {
+        result = sdscatfmt(result, "uris[1]:%S,", sds_buf);
+        FREE_SDS(sds_buf);
+    }
+    result = sdscatfmt(result, "missing:%i,", json_find_key(data, "$.params.missing"));
+    result = sdscatfmt(result, "nested:%i,", json_find_key(data, "$.params.fields.k2"));
+    result = sdscatfmt(result, "wrongtype:%i", json_find_key(data, "$.id.key"));
+    return result;
+}
+
+UTEST(jsonquery, test_json_query_bind) {
+    const char *requests[] = {
+        "{\"jsonrpc\":\"2.0\",\"id\":12,\"method\":\"MYMPD_API_QUEUE_SEARCH\",\"params\":{\"offset\":5,\"play\":true,"
+            "\"expression\":\"a\\\"b\",\"uris\":[\"a.mp3\",\"b \\u00e4.mp3\"],\"fields\":{\"k1\":\"v1\",\"k2\":\"v2\"}}}",
+        "{ \"id\" : 1 , \"params\" : { \"uris\" : [ ] , \"fields\" : { } , \"play\" : false } }",
+        // invalid json is resolved by mjson
+        "{\"id\":1,\"params\":{\"play\":true}",
+        NULL
+    };
+    for (const char **request = requests; *request != NULL; request++) {
+        sds data = sdsnew(*request);
+        sds unbound = json_query_test_lookups(data, sdsempty());
+        bool valid = json_query_bind(data);
+        ASSERT_EQ(request != &requests[2], valid);
+        sds bound = json_query_test_lookups(data, sdsempty());
+        json_query_unbind();
+        ASSERT_STREQ(unbound, bound);
+        FREE_SDS(unbound);
+        FREE_SDS(bound);
+        FREE_SDS(data);
+    }
+}
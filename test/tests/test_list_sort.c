@@ -199,3 +199,63 @@ UTEST(list_sort, test_list_sort_empty) {
 
     list_clear(&test_list);
 }
+
+UTEST(list_sort, test_list_sort_by_key_stable) {
+    struct t_list test_list;
+    list_init(&test_list);
+    list_push(&test_list, "b", 0, NULL, NULL);
+    list_push(&test_list, "A", 1, NULL, NULL);
+    list_push(&test_list, "a", 2, NULL, NULL);
+    list_push(&test_list, "B", 3, NULL, NULL);
+    list_push(&test_list, "ab", 4, NULL, NULL);
+
+    list_sort_by_key(&test_list, LIST_SORT_ASC);
+    ASSERT_EQ(1, test_list.head->value_i);
+    ASSERT_EQ(2, test_list.head->next->value_i);
+    ASSERT_EQ(4, test_list.head->next->next->value_i);
+    ASSERT_EQ(3, test_list.tail->value_i);
+    ASSERT_EQ(check_list_integrity(&test_list, 5), true);
+
+    list_sort_by_key(&test_list, LIST_SORT_DESC);
+    ASSERT_EQ(0, test_list.head->value_i);
+    ASSERT_EQ(3, test_list.head->next->value_i);
+    ASSERT_EQ(2, test_list.tail->value_i);
+    ASSERT_EQ(check_list_integrity(&test_list, 5), true);
+
+    list_clear(&test_list);
+}
+
+/**
+ * Sort callback that compares with utf8_wrap_casecmp on each comparison
+ */
+static bool sort_cb_casecmp(struct t_list_node *first, struct t_list_node *second, enum list_sort_direction direction) {
+    int result = utf8_wrap_casecmp(first->key, sdslen(first->key), second->key, sdslen(second->key));
+    return (direction == LIST_SORT_ASC && result > 0) ||
+        (direction == LIST_SORT_DESC && result < 0);
+}
+
+UTEST(list_sort, test_list_sort_by_key_callback_order) {
+    const unsigned count = 1000;
+    struct t_list *list_callback = list_new();
+    populate_large_list(list_callback, true, (int)count);
+    struct t_list *list_key = list_new();
+    struct t_list_node *current = list_callback->head;
+    while (current != NULL) {
+        list_push(list_key, current->key, current->value_i, current->value_p, NULL);
+        current = current->next;
+    }
+    list_sort_by_callback(list_callback, LIST_SORT_ASC, sort_cb_casecmp);
+    list_sort_by_key(list_key, LIST_SORT_ASC);
+
+    // both sorts are stable and must produce the same order
+    struct t_list_node *node_callback = list_callback->head;
+    struct t_list_node *node_key = list_key->head;
+    while (node_callback != NULL) {
+        ASSERT_EQ(node_callback->value_i, node_key->value_i);
+        node_callback = node_callback->next;
+        node_key = node_key->next;
+    }
+    ASSERT_EQ(check_list_integrity(list_key, count), true);
+    list_free(list_callback);
+    list_free(list_key);
+}
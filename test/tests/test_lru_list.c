@@ -0,0 +1,56 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2026 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+#include "compile_time.h"
+#include "utility.h"
+
+#include "dist/utest/utest.h"
+#include "src/lib/lru_list.h"
+
+struct t_test_entry {
+    int value;
+    struct t_lru_node lru;
+};
+
+static int entry_value(struct t_lru_node *node) {
+    return LRU_LIST_ENTRY(node, struct t_test_entry, lru)->value;
+}
+
+UTEST(lru_list, test_lru_list_order) {
+    struct t_lru_list list = LRU_LIST_INIT;
+    struct t_test_entry entries[3] = {
+        { .value = 0 }, { .value = 1 }, { .value = 2 }
+    };
+    for (int i = 0; i < 3; i++) {
+        lru_list_link_head(&list, &entries[i].lru);
+    }
+    // 2, 1, 0
+    ASSERT_EQ(2, entry_value(list.head));
+    ASSERT_EQ(0, entry_value(list.tail));
+
+    // 0, 2, 1
+    lru_list_touch(&list, &entries[0].lru);
+    ASSERT_EQ(0, entry_value(list.head));
+    ASSERT_EQ(1, entry_value(list.tail));
+    ASSERT_EQ(2, entry_value(list.head->next));
+    ASSERT_EQ(0, entry_value(list.tail->prev->prev));
+
+    // touching the head keeps the order
+    lru_list_touch(&list, &entries[0].lru);
+    ASSERT_EQ(0, entry_value(list.head));
+
+    // 0, 1
+    lru_list_unlink(&list, &entries[2].lru);
+    ASSERT_TRUE(entries[2].lru.prev == NULL);
+    ASSERT_TRUE(entries[2].lru.next == NULL);
+    ASSERT_EQ(1, entry_value(list.head->next));
+    ASSERT_EQ(0, entry_value(list.tail->prev));
+
+    lru_list_unlink(&list, &entries[1].lru);
+    lru_list_unlink(&list, &entries[0].lru);
+    ASSERT_TRUE(list.head == NULL);
+    ASSERT_TRUE(list.tail == NULL);
+}
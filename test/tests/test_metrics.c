@@ -0,0 +1,88 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2026 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+#include "compile_time.h"
+#include "utility.h"
+
+#include "dist/utest/utest.h"
+#include "src/lib/metrics.h"
+#include "src/lib/sds/sds_extras.h"
+
+#include <pthread.h>
+#include <string.h>
+
+static void record_request(enum mympd_cmd_ids cmd_id, unsigned roundtrips, size_t bytes) {
+    struct timespec queued;
+    clock_gettime(CLOCK_MONOTONIC, &queued);
+    struct t_metrics_request request_metrics;
+    metrics_request_begin(&request_metrics, &queued);
+    for (unsigned i = 0; i < roundtrips; i++) {
+        metrics_count_mpd_roundtrip();
+    }
+    metrics_count_response_bytes(bytes);
+    metrics_request_end(&request_metrics, cmd_id);
+}
+
+static void *record_thread(void *arg) {
+    (void)arg;
+    for (unsigned i = 0; i < 1000; i++) {
+        record_request(MYMPD_API_QUEUE_SEARCH, 1, 10);
+    }
+    return NULL;
+}
+
+UTEST(metrics, test_metrics_request) {
+    record_request(MYMPD_API_STATS, 2, 100);
+    record_request(MYMPD_API_STATS, 3, 50);
+    // roundtrips and bytes outside of a request are not counted
+    metrics_count_mpd_roundtrip();
+    metrics_count_response_bytes(1000);
+
+    struct t_metrics_method method;
+    metrics_get(MYMPD_API_STATS, &method);
+    ASSERT_EQ((uint64_t)2, method.latency.count);
+    ASSERT_EQ((uint64_t)2, method.wait.count);
+    ASSERT_EQ((uint64_t)5, method.mpd_roundtrips);
+    ASSERT_EQ((uint64_t)150, method.response_bytes);
+
+    metrics_get(MYMPD_API_STATS_METRICS, &method);
+    ASSERT_EQ((uint64_t)0, method.latency.count);
+    metrics_free();
+}
+
+UTEST(metrics, test_metrics_threads) {
+    pthread_t threads[METRICS_SHARDS_MAX + 2];
+    for (unsigned i = 0; i < METRICS_SHARDS_MAX + 2; i++) {
+        ASSERT_EQ(0, pthread_create(&threads[i], NULL, record_thread, NULL));
+    }
+    for (unsigned i = 0; i < METRICS_SHARDS_MAX + 2; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    struct t_metrics_method method;
+    metrics_get(MYMPD_API_QUEUE_SEARCH, &method);
+    ASSERT_EQ((uint64_t)(METRICS_SHARDS_MAX + 2) * 1000, method.latency.count);
+    ASSERT_EQ((uint64_t)(METRICS_SHARDS_MAX + 2) * 1000, method.mpd_roundtrips);
+    ASSERT_EQ((uint64_t)(METRICS_SHARDS_MAX + 2) * 10000, method.response_bytes);
+    metrics_free();
+}
+
+UTEST(metrics, test_metrics_print) {
+    record_request(MYMPD_API_STATS, 1, 100);
+
+    sds json = metrics_print_json(sdsempty());
+    ASSERT_TRUE(strstr(json, "[{\"method\":\"MYMPD_API_STATS\",\"mpdRoundtrips\":1,\"responseBytes\":100,\"latency\":{\"count\":1,") != NULL);
+    FREE_SDS(json);
+
+    sds text = metrics_print_prometheus(sdsempty());
+    ASSERT_TRUE(strstr(text, "# TYPE mympd_request_duration_seconds histogram\n") != NULL);
+    ASSERT_TRUE(strstr(text, "mympd_request_duration_seconds_bucket{method=\"MYMPD_API_STATS\",le=\"+Inf\"} 1\n") != NULL);
+    ASSERT_TRUE(strstr(text, "mympd_request_duration_seconds_count{method=\"MYMPD_API_STATS\"} 1\n") != NULL);
+    ASSERT_TRUE(strstr(text, "mympd_request_mpd_roundtrips_total{method=\"MYMPD_API_STATS\"} 1\n") != NULL);
+    ASSERT_TRUE(strstr(text, "mympd_response_bytes_total{method=\"MYMPD_API_STATS\"} 100\n") != NULL);
+    ASSERT_TRUE(strstr(text, "MYMPD_API_QUEUE_SEARCH") == NULL);
+    FREE_SDS(text);
+    metrics_free();
+}
@@ -10,7 +10,9 @@
 #include "dist/utest/utest.h"
 #include "src/lib/api.h"
 #include "src/lib/event.h"
+#include "src/lib/log.h"
 #include "src/lib/msg_queue.h"
+#include "src/lib/sds/sds_extras.h"
 
 UTEST(mympd_queue, push_shift) {
     struct t_mympd_queue *test_queue = mympd_queue_create("test", QUEUE_TYPE_REQUEST, false);
@@ -129,3 +131,182 @@ UTEST(mympd_queue, event) {
     ASSERT_TRUE(rc);
     mympd_queue_free(test_queue);
 }
+
+UTEST(mympd_queue, ring_push_shift) {
+    struct t_mympd_queue *test_queue = mympd_queue_create_ring("test", QUEUE_TYPE_REQUEST, false, 4);
+    sds test_data[6];
+    for (int i = 0; i < 6; i++) {
+        test_data[i] = sdscatfmt(sdsempty(), "test%i", i);
+        ASSERT_TRUE(mympd_queue_push(test_queue, test_data[i], 0));
+    }
+    // two entries did not fit in the ring buffer
+    struct t_mympd_queue_stats stats;
+    mympd_queue_get_stats(test_queue, &stats);
+    ASSERT_EQ(6U, stats.length);
+    ASSERT_EQ(6U, stats.high_water);
+    ASSERT_EQ(2U, stats.overflows);
+
+    for (int i = 0; i < 6; i++) {
+        sds test_data_out = mympd_queue_shift(test_queue, 50, 0);
+        ASSERT_STREQ(test_data[i], test_data_out);
+    }
+    ASSERT_TRUE(mympd_queue_shift(test_queue, -1, 0) == NULL);
+    ASSERT_EQ(0U, mympd_queue_length(test_queue));
+    mympd_queue_get_stats(test_queue, &stats);
+    ASSERT_EQ(6U, stats.high_water);
+
+    mympd_queue_free(test_queue);
+    for (int i = 0; i < 6; i++) {
+        sdsfree(test_data[i]);
+    }
+}
+
+UTEST(mympd_queue, ring_overflow_fifo) {
+    struct t_mympd_queue *test_queue = mympd_queue_create_ring("test", QUEUE_TYPE_REQUEST, false, 4);
+    sds test_data[10];
+    for (int i = 0; i < 10; i++) {
+        test_data[i] = sdscatfmt(sdsempty(), "test%i", i);
+    }
+    // fill the ring buffer and the overflow list
+    for (int i = 0; i < 6; i++) {
+        ASSERT_TRUE(mympd_queue_push(test_queue, test_data[i], 0));
+    }
+    // free slots in the ring buffer
+    for (int i = 0; i < 2; i++) {
+        sds test_data_out = mympd_queue_shift(test_queue, -1, 0);
+        ASSERT_STREQ(test_data[i], test_data_out);
+    }
+    // the overflow list is not drained, new entries must not bypass it
+    for (int i = 6; i < 9; i++) {
+        ASSERT_TRUE(mympd_queue_push(test_queue, test_data[i], 0));
+    }
+    for (int i = 2; i < 9; i++) {
+        sds test_data_out = mympd_queue_shift(test_queue, -1, 0);
+        ASSERT_STREQ(test_data[i], test_data_out);
+    }
+    // the drained list gives the ring buffer free again
+    ASSERT_TRUE(mympd_queue_push(test_queue, test_data[9], 0));
+    struct t_mympd_queue_stats stats;
+    mympd_queue_get_stats(test_queue, &stats);
+    ASSERT_EQ(5U, stats.overflows);
+    ASSERT_STREQ(test_data[9], mympd_queue_shift(test_queue, -1, 0));
+
+    // ring buffer entries are moved before the overflow list entries
+    for (int i = 0; i < 6; i++) {
+        ASSERT_TRUE(mympd_queue_push(test_queue, test_data[i], (unsigned)(i % 2) + 1));
+    }
+    for (int i = 0; i < 6; i += 2) {
+        sds test_data_out = mympd_queue_shift(test_queue, -1, 1);
+        ASSERT_STREQ(test_data[i], test_data_out);
+    }
+    for (int i = 1; i < 6; i += 2) {
+        sds test_data_out = mympd_queue_shift(test_queue, -1, 0);
+        ASSERT_STREQ(test_data[i], test_data_out);
+    }
+    ASSERT_EQ(0U, mympd_queue_length(test_queue));
+
+    mympd_queue_free(test_queue);
+    for (int i = 0; i < 10; i++) {
+        sdsfree(test_data[i]);
+    }
+}
+
+UTEST(mympd_queue, ring_push_shift_id) {
+    struct t_mympd_queue *test_queue = mympd_queue_create_ring("test", QUEUE_TYPE_REQUEST, false, 8);
+    sds test_data_in0 = sdsnew("test0");
+    sds test_data_in1 = sdsnew("test1");
+    sds test_data_in2 = sdsnew("test2");
+
+    mympd_queue_push(test_queue, test_data_in0, 10);
+    mympd_queue_push(test_queue, test_data_in1, 20);
+    mympd_queue_push(test_queue, test_data_in2, 10);
+    ASSERT_EQ(3U, mympd_queue_length(test_queue));
+
+    sds test_data_out = mympd_queue_shift(test_queue, 50, 20);
+    ASSERT_STREQ(test_data_in1, test_data_out);
+    test_data_out = mympd_queue_shift(test_queue, 50, 10);
+    ASSERT_STREQ(test_data_in0, test_data_out);
+    test_data_out = mympd_queue_shift(test_queue, 50, 10);
+    ASSERT_STREQ(test_data_in2, test_data_out);
+    ASSERT_TRUE(mympd_queue_shift(test_queue, 10, 10) == NULL);
+    ASSERT_EQ(0U, mympd_queue_length(test_queue));
+
+    mympd_queue_free(test_queue);
+    sdsfree(test_data_in0);
+    sdsfree(test_data_in1);
+    sdsfree(test_data_in2);
+}
+
+UTEST(mympd_queue, shift_batch) {
+    struct t_mympd_queue *test_queue = mympd_queue_create("test", QUEUE_TYPE_REQUEST, false);
+    struct t_mympd_queue *test_ring = mympd_queue_create_ring("test", QUEUE_TYPE_REQUEST, false, 8);
+    sds test_data[5];
+    for (int i = 0; i < 5; i++) {
+        test_data[i] = sdscatfmt(sdsempty(), "test%i", i);
+        mympd_queue_push(test_queue, test_data[i], 0);
+        mympd_queue_push(test_ring, test_data[i], 0);
+    }
+    void *batch[3];
+    ASSERT_EQ(3U, mympd_queue_shift_batch(test_queue, batch, 3));
+    ASSERT_STREQ(test_data[2], batch[2]);
+    ASSERT_EQ(2U, mympd_queue_shift_batch(test_queue, batch, 3));
+    ASSERT_STREQ(test_data[4], batch[1]);
+    ASSERT_EQ(0U, mympd_queue_shift_batch(test_queue, batch, 3));
+
+    ASSERT_EQ(3U, mympd_queue_shift_batch(test_ring, batch, 3));
+    ASSERT_STREQ(test_data[0], batch[0]);
+    ASSERT_EQ(2U, mympd_queue_shift_batch(test_ring, batch, 3));
+    ASSERT_STREQ(test_data[3], batch[0]);
+    ASSERT_EQ(0U, mympd_queue_shift_batch(test_ring, batch, 3));
+
+    mympd_queue_free(test_queue);
+    mympd_queue_free(test_ring);
+    for (int i = 0; i < 5; i++) {
+        sdsfree(test_data[i]);
+    }
+}
+
+/**
+ * Number of messages each producer thread pushes
+ */
+#define RING_TEST_MESSAGES 20000
+
+/**
+ * Producer thread for the ring buffer test
+ * @param arg the queue
+ * @return NULL
+ */
+static void *ring_producer(void *arg) {
+    struct t_mympd_queue *test_queue = arg;
+    thread_logname = sdsnew("producer");
+    thread_logline = sdsempty();
+    for (uintptr_t i = 1; i <= RING_TEST_MESSAGES; i++) {
+        mympd_queue_push(test_queue, (void *)i, 0);
+    }
+    FREE_SDS(thread_logname);
+    FREE_SDS(thread_logline);
+    return NULL;
+}
+
+UTEST(mympd_queue, ring_multi_producer) {
+    struct t_mympd_queue *test_queue = mympd_queue_create_ring("test", QUEUE_TYPE_REQUEST, false, 64);
+    pthread_t producers[4];
+    for (int i = 0; i < 4; i++) {
+        pthread_create(&producers[i], NULL, ring_producer, test_queue);
+    }
+    uint64_t sum = 0;
+    unsigned received = 0;
+    while (received < 4 * RING_TEST_MESSAGES) {
+        void *data = mympd_queue_shift(test_queue, 100, 0);
+        if (data != NULL) {
+            sum += (uintptr_t)data;
+            received++;
+        }
+    }
+    for (int i = 0; i < 4; i++) {
+        pthread_join(producers[i], NULL);
+    }
+    ASSERT_EQ((uint64_t)4 * RING_TEST_MESSAGES * (RING_TEST_MESSAGES + 1) / 2, sum);
+    ASSERT_EQ(0U, mympd_queue_length(test_queue));
+    mympd_queue_free(test_queue);
+}
@@ -0,0 +1,45 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2026 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+#include "compile_time.h"
+#include "utility.h"
+
+#include "dist/utest/utest.h"
+#include "src/lib/playlist_catalogue.h"
+
+UTEST(playlist_catalogue, test_playlist_catalogue) {
+    struct t_playlist_catalogue catalogue;
+    playlist_catalogue_init(&catalogue);
+    ASSERT_FALSE(catalogue.valid);
+    playlist_catalogue_add(&catalogue, "rock", 100, false);
+    playlist_catalogue_add(&catalogue, "newest", 200, true);
+    catalogue.valid = true;
+
+    struct t_playlist_catalogue_entry *entry = playlist_catalogue_get(&catalogue, "newest");
+    ASSERT_TRUE(entry != NULL);
+    ASSERT_EQ(200, (int)entry->last_modified);
+    ASSERT_TRUE(entry->smartpls);
+    ASSERT_FALSE(entry->enumerated);
+    ASSERT_TRUE(playlist_catalogue_get(&catalogue, "jazz") == NULL);
+
+    // replacing resets the cached enumeration
+    entry->enumerated = true;
+    playlist_catalogue_add(&catalogue, "newest", 300, true);
+    entry = playlist_catalogue_get(&catalogue, "newest");
+    ASSERT_EQ(300, (int)entry->last_modified);
+    ASSERT_FALSE(entry->enumerated);
+    ASSERT_EQ(2U, (unsigned)catalogue.playlists->numele);
+
+    playlist_catalogue_remove(&catalogue, "rock");
+    playlist_catalogue_remove(&catalogue, "rock");
+    ASSERT_TRUE(playlist_catalogue_get(&catalogue, "rock") == NULL);
+    ASSERT_TRUE(catalogue.valid);
+
+    playlist_catalogue_clear(&catalogue);
+    ASSERT_FALSE(catalogue.valid);
+    ASSERT_TRUE(playlist_catalogue_get(&catalogue, "newest") == NULL);
+    playlist_catalogue_free(&catalogue);
+}
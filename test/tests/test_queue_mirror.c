@@ -0,0 +1,114 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2026 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+#include "compile_time.h"
+#include "utility.h"
+
+#include "dist/utest/utest.h"
+#include "src/lib/queue_mirror.h"
+
+#include <limits.h>
+
+static struct mpd_song *new_queue_song(unsigned pos, unsigned id, unsigned duration) {
+    struct mpd_song *song = new_test_song();
+    song->pos = pos;
+    song->id = id;
+    song->duration = duration;
+    return song;
+}
+
+static void queue_mirror_test_load(struct t_queue_mirror *mirror, unsigned length) {
+    queue_mirror_init(mirror);
+    for (unsigned pos = 0; pos < length; pos++) {
+        queue_mirror_append(mirror, new_queue_song(pos, pos + 100, 10));
+    }
+    queue_mirror_commit(mirror, 1);
+}
+
+UTEST(queue_mirror, test_queue_mirror_load) {
+    struct t_queue_mirror mirror;
+    queue_mirror_test_load(&mirror, 3);
+    ASSERT_TRUE(mirror.valid);
+    ASSERT_EQ(3U, mirror.length);
+    ASSERT_EQ((uint64_t)30, mirror.total_time);
+    ASSERT_EQ(102U, mpd_song_get_id(queue_mirror_get(&mirror, 2)));
+    ASSERT_TRUE(queue_mirror_get(&mirror, 3) == NULL);
+    // positions must be contiguous
+    ASSERT_FALSE(queue_mirror_append(&mirror, new_queue_song(5, 200, 10)));
+    queue_mirror_clear(&mirror);
+    ASSERT_FALSE(mirror.valid);
+    ASSERT_EQ(0U, mirror.length);
+}
+
+UTEST(queue_mirror, test_queue_mirror_consume) {
+    struct t_queue_mirror mirror;
+    queue_mirror_test_load(&mirror, 4);
+    const struct mpd_song *second = queue_mirror_get(&mirror, 1);
+    // the first song was removed, all other songs moved up
+    const struct t_queue_change changes[] = {{0, 101}, {1, 102}, {2, 103}};
+    unsigned first;
+    unsigned last;
+    ASSERT_EQ(0U, queue_mirror_patch(&mirror, changes, 3, 3, &first, &last));
+    ASSERT_TRUE(queue_mirror_commit(&mirror, 2));
+    ASSERT_EQ(3U, mirror.length);
+    ASSERT_EQ(2U, mirror.version);
+    ASSERT_EQ((uint64_t)30, mirror.total_time);
+    // moved songs are reused and get the new position
+    ASSERT_TRUE(second == queue_mirror_get(&mirror, 0));
+    ASSERT_EQ(0U, mpd_song_get_pos(queue_mirror_get(&mirror, 0)));
+    ASSERT_EQ(103U, mpd_song_get_id(queue_mirror_get(&mirror, 2)));
+    queue_mirror_clear(&mirror);
+}
+
+UTEST(queue_mirror, test_queue_mirror_append_modify) {
+    struct t_queue_mirror mirror;
+    queue_mirror_test_load(&mirror, 3);
+    // song 101 got a priority, song 200 was appended
+    const struct t_queue_change changes[] = {{1, 101}, {3, 200}};
+    unsigned first;
+    unsigned last;
+    ASSERT_EQ(2U, queue_mirror_patch(&mirror, changes, 2, 4, &first, &last));
+    ASSERT_EQ(1U, first);
+    ASSERT_EQ(3U, last);
+    ASSERT_TRUE(queue_mirror_set_song(&mirror, new_queue_song(1, 101, 10)));
+    // unchanged songs in the fetched range are replaced
+    ASSERT_TRUE(queue_mirror_set_song(&mirror, new_queue_song(2, 102, 10)));
+    ASSERT_TRUE(queue_mirror_set_song(&mirror, new_queue_song(3, 200, 50)));
+    ASSERT_TRUE(queue_mirror_commit(&mirror, 2));
+    ASSERT_EQ((uint64_t)80, mirror.total_time);
+    queue_mirror_clear(&mirror);
+}
+
+UTEST(queue_mirror, test_queue_mirror_changed_meanwhile) {
+    struct t_queue_mirror mirror;
+    queue_mirror_test_load(&mirror, 3);
+    const struct t_queue_change changes[] = {{3, 200}};
+    unsigned first;
+    unsigned last;
+    ASSERT_EQ(1U, queue_mirror_patch(&mirror, changes, 1, 4, &first, &last));
+    // the queue has changed between the requests
+    ASSERT_FALSE(queue_mirror_set_song(&mirror, new_queue_song(3, 201, 10)));
+    ASSERT_FALSE(queue_mirror_commit(&mirror, 2));
+    ASSERT_FALSE(mirror.valid);
+    ASSERT_EQ(0U, mirror.length);
+}
+
+UTEST(queue_mirror, test_queue_mirror_move) {
+    struct t_queue_mirror mirror;
+    queue_mirror_test_load(&mirror, 4);
+    // song 103 was moved to the front
+    const struct t_queue_change changes[] = {{0, 103}, {1, 100}, {2, 101}, {3, 102}};
+    unsigned first;
+    unsigned last;
+    ASSERT_EQ(0U, queue_mirror_patch(&mirror, changes, 4, 4, &first, &last));
+    ASSERT_EQ(UINT_MAX, first);
+    ASSERT_TRUE(queue_mirror_commit(&mirror, 2));
+    for (unsigned pos = 0; pos < 4; pos++) {
+        ASSERT_EQ(pos, mpd_song_get_pos(queue_mirror_get(&mirror, pos)));
+        ASSERT_EQ(changes[pos].id, mpd_song_get_id(queue_mirror_get(&mirror, pos)));
+    }
+    queue_mirror_clear(&mirror);
+}
@@ -0,0 +1,138 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2026 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+#include "compile_time.h"
+#include "utility.h"
+
+#include "dist/utest/utest.h"
+#include "src/lib/sds/sds_extras.h"
+#include "src/mympd_client/random_select.h"
+
+#include <string.h>
+
+static void populate_queue_list(struct t_list *queue_list, unsigned count, unsigned artists) {
+    sds uri = sdsempty();
+    sds artist = sdsempty();
+    for (unsigned i = 0; i < count; i++) {
+        sdsclear(uri);
+        sdsclear(artist);
+        uri = sdscatfmt(uri, "music/artist%u/song%u.mp3", i % artists, i);
+        artist = sdscatfmt(artist, "artist%u", i % artists);
+        list_push(queue_list, uri, 0, artist, NULL);
+    }
+    FREE_SDS(uri);
+    FREE_SDS(artist);
+}
+
+static unsigned fill_add_list(struct t_list *queue_list, struct t_list *add_list, unsigned expected_len,
+        unsigned count, unsigned artists)
+{
+    struct t_random_select_reservoir reservoir;
+    random_select_reservoir_init(&reservoir, expected_len, queue_list, add_list);
+    sds uri = sdsempty();
+    sds artist = sdsempty();
+    unsigned skipno = 0;
+    for (unsigned i = 0; i < count; i++) {
+        sdsclear(uri);
+        sdsclear(artist);
+        uri = sdscatfmt(uri, "music/artist%u/song%u.mp3", i % artists, i);
+        artist = sdscatfmt(artist, "artist%u", i % artists);
+        if (random_select_reservoir_add(&reservoir, uri, artist) == false) {
+            skipno++;
+        }
+    }
+    random_select_reservoir_clear(&reservoir);
+    FREE_SDS(uri);
+    FREE_SDS(artist);
+    return skipno;
+}
+
+static bool check_uniq(struct t_list *queue_list, struct t_list *add_list) {
+    for (struct t_list_node *current = add_list->head; current != NULL; current = current->next) {
+        for (struct t_list_node *other = current->next; other != NULL; other = other->next) {
+            if (strcmp(current->value_p, other->value_p) == 0) {
+                return false;
+            }
+        }
+        if (list_get_node(queue_list, current->key) != NULL) {
+            return false;
+        }
+        for (struct t_list_node *other = queue_list->head; other != NULL; other = other->next) {
+            if (strcmp(current->value_p, other->value_p) == 0) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+UTEST(random_select, test_random_select_reservoir_uniq) {
+    struct t_list *queue_list = list_new();
+    struct t_list *add_list = list_new();
+    // artist0 to artist9 are in the queue
+    populate_queue_list(queue_list, 10, 10);
+    unsigned skipno = fill_add_list(queue_list, add_list, 5, 20, 20);
+    // 10 artists are in the queue
+    ASSERT_EQ(10U, skipno);
+    ASSERT_EQ(5U, add_list->length);
+    ASSERT_TRUE(check_uniq(queue_list, add_list));
+
+    // existing entries of the add_list are kept and used for the uniq check
+    sds first = sdsdup(add_list->head->key);
+    skipno = fill_add_list(queue_list, add_list, 10, 20, 20);
+    // 5 more artists are in the add_list
+    ASSERT_EQ(15U, skipno);
+    ASSERT_EQ(10U, add_list->length);
+    ASSERT_STREQ(first, add_list->head->key);
+    ASSERT_TRUE(check_uniq(queue_list, add_list));
+    ASSERT_EQ(check_list_integrity(add_list, 10), true);
+    FREE_SDS(first);
+    list_free(queue_list);
+    list_free(add_list);
+}
+
+UTEST(random_select, test_random_select_reservoir_no_queue) {
+    struct t_list *add_list = list_new();
+    // uniq constraints are not enforced without queue list
+    unsigned skipno = fill_add_list(NULL, add_list, 5, 100, 1);
+    ASSERT_EQ(0U, skipno);
+    ASSERT_EQ(5U, add_list->length);
+    ASSERT_EQ(check_list_integrity(add_list, 5), true);
+    list_free(add_list);
+}
+
+UTEST(random_select, test_random_select_reservoir_distribution) {
+    // every candidate should be selected sometimes, also the first ones
+    unsigned selected[10] = {0};
+    for (unsigned run = 0; run < 1000; run++) {
+        struct t_list *queue_list = list_new();
+        struct t_list *add_list = list_new();
+        fill_add_list(queue_list, add_list, 2, 10, 10);
+        ASSERT_EQ(2U, add_list->length);
+        for (struct t_list_node *current = add_list->head; current != NULL; current = current->next) {
+            selected[current->value_i - 1]++;
+        }
+        list_free(queue_list);
+        list_free(add_list);
+    }
+    for (unsigned i = 0; i < 10; i++) {
+        ASSERT_GT(selected[i], 100U);
+        ASSERT_LT(selected[i], 300U);
+    }
+}
+
+UTEST(random_select, test_random_select_reservoir_large_queue) {
+    const unsigned count = 20000;
+    struct t_list *queue_list = list_new();
+    struct t_list *add_list = list_new();
+    // jukebox fill with a 1000 entries queue and artist as uniq tag
+    populate_queue_list(queue_list, 1000, count / 10);
+    fill_add_list(queue_list, add_list, 50, count, count / 10);
+    ASSERT_EQ(50U, add_list->length);
+    ASSERT_TRUE(check_uniq(queue_list, add_list));
+    list_free(queue_list);
+    list_free(add_list);
+}
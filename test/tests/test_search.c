@@ -9,12 +9,15 @@
 #include "utility.h"
 
 #include "dist/utest/utest.h"
+#include "src/lib/album.h"
 #include "src/lib/mpdclient.h"
 #include "src/lib/search/search_fuzzy.h"
+#include "src/lib/search/search_pcre.h"
 #include "src/lib/search/search.h"
+#include "src/lib/str_pool.h"
+#include "src/lib/webradio.h"
 
-#define PCRE2_CODE_UNIT_WIDTH 8
-#include <pcre2.h>
+#include <time.h>
 
 bool search_by_expression(const char *expr_string) {
     struct mpd_song *song = new_test_song();
@@ -110,6 +113,83 @@ UTEST(search_local, test_search_mpd_song_expression) {
     ASSERT_FALSE(search_by_expression("((file 'abc/abc.mp3'))"));
 }
 
+bool search_album_by_expression(const struct t_album *album, const char *expr_string) {
+    struct t_mympd_mpd_tags tags;
+    mympd_mpd_tags_reset(&tags);
+    tags.len++;
+    tags.tags[0] = MPD_TAG_ALBUM;
+    tags.len++;
+    tags.tags[1] = MPD_TAG_ALBUM_ARTIST;
+
+    struct t_list *expr_list = search_expression_parse(expr_string, SEARCH_TYPE_SONG);
+    if (expr_list == NULL) {
+        return false;
+    }
+    bool rc = search_expression_album(album, expr_list, &tags);
+    search_expression_free(expr_list);
+    return rc;
+}
+
+UTEST(search_local, test_search_album_expression_normalized) {
+    struct t_album *album = album_new();
+    album_append_tag(album, MPD_TAG_ALBUM, "Tabula Rasa");
+    album_append_tag(album, MPD_TAG_ALBUM_ARTIST, "Einstuerzende Neubauten");
+    album_append_tag(album, MPD_TAG_ALBUM_ARTIST, "Blixa Bargeld");
+    ASSERT_TRUE(album_get_tag_normalized(album, MPD_TAG_ALBUM, 0) == NULL);
+
+    struct t_str_pool *pool = str_pool_new();
+    // same source string returns the same interned string
+    sds norm = str_pool_get_normalized(pool, "Blixa Bargeld", 13);
+    ASSERT_TRUE(norm == str_pool_get_normalized(pool, "Blixa Bargeld", 13));
+
+    // results must be the same with and without the normalized values
+    for (int i = 0; i < 2; i++) {
+        if (i == 1) {
+            album_normalize_tags(album, pool);
+            ASSERT_TRUE(album_get_tag_normalized(album, MPD_TAG_ALBUM_ARTIST, 1) == norm);
+        }
+        ASSERT_TRUE(search_album_by_expression(album, "((Album contains 'tabula'))"));
+        ASSERT_TRUE(search_album_by_expression(album, "((AlbumArtist == 'Blixa Bargeld'))"));
+        ASSERT_TRUE(search_album_by_expression(album, "((any starts_with 'einst'))"));
+        ASSERT_TRUE(search_album_by_expression(album, "((AlbumArtist ~~ 'Plixa'))"));
+        ASSERT_FALSE(search_album_by_expression(album, "((Album != 'Tabula Rasa'))"));
+        ASSERT_FALSE(search_album_by_expression(album, "((AlbumArtist =~ 'xyz.*'))"));
+    }
+    album_free(album);
+    str_pool_free(pool);
+}
+
+UTEST(search_local, test_search_webradio_expression_normalized) {
+    struct t_webradio_data *webradio = webradio_data_new(WEBRADIO_WEBRADIODB);
+    webradio->name = sdsnew("Radio Eins");
+    webradio->country = sdsnew("Germany");
+    list_push(&webradio->genres, "Rock", 0, NULL, NULL);
+    list_push(&webradio->genres, "Pop", 0, NULL, NULL);
+    struct t_webradio_tags tags;
+    webradio_tags_search(&tags);
+
+    struct t_str_pool *pool = str_pool_new();
+    for (int i = 0; i < 2; i++) {
+        if (i == 1) {
+            webradio_data_normalize(webradio, pool);
+            ASSERT_TRUE(webradio_get_tag_normalized(webradio, WEBRADIO_TAG_GENRES, 1) != NULL);
+            ASSERT_TRUE(webradio_get_tag_normalized(webradio, WEBRADIO_TAG_REGION, 0) == NULL);
+        }
+        struct t_list *expr_list = search_expression_parse("((Genres == 'pop'))", SEARCH_TYPE_WEBRADIO);
+        ASSERT_TRUE(expr_list != NULL);
+        ASSERT_TRUE(search_expression_webradio(webradio, expr_list, &tags));
+        search_expression_free(expr_list);
+        expr_list = search_expression_parse("((any contains 'germ'))", SEARCH_TYPE_WEBRADIO);
+        ASSERT_TRUE(search_expression_webradio(webradio, expr_list, &tags));
+        search_expression_free(expr_list);
+        expr_list = search_expression_parse("((Name starts_with 'eins'))", SEARCH_TYPE_WEBRADIO);
+        ASSERT_FALSE(search_expression_webradio(webradio, expr_list, &tags));
+        search_expression_free(expr_list);
+    }
+    webradio_data_free(webradio);
+    str_pool_free(pool);
+}
+
 long try_parse(const char *expr) {
     sds expression = sdsnew(expr);
     struct t_list *expr_list = search_expression_parse(expression, SEARCH_TYPE_SONG);
@@ -175,4 +255,60 @@ UTEST(search_local, test_mympd_search_fuzzy_match) {
     ASSERT_FALSE(rc);
     rc = search_fuzzy_match("einstuerzende neubauten", "xinstuerzende neubauxxx");
     ASSERT_FALSE(rc);
+
+    //substrings with the length of the needle are compared
+    rc = search_fuzzy_match("neubaten x", "neubauten");
+    ASSERT_FALSE(rc);
+    //a needle prefix within the maximum distance matches
+    rc = search_fuzzy_match("neubauten", "nebautenx");
+    ASSERT_TRUE(rc);
+    rc = search_fuzzy_match("blixa bargeld", "blxax");
+    ASSERT_TRUE(rc);
+    rc = search_fuzzy_match("blixa bargeld", "bargld");
+    ASSERT_TRUE(rc);
+    rc = search_fuzzy_match("blixa bargeld", "bargldx");
+    ASSERT_TRUE(rc);
+    rc = search_fuzzy_match("blixa", "blxaz");
+    ASSERT_TRUE(rc);
+
+    //needles longer than 64 bytes
+    const char *long_haystack = "live at the palast der republik - einstuerzende neubauten - "
+        "halber mensch - tabula rasa - silence is sexy - alles wieder offen";
+    rc = search_fuzzy_match(long_haystack, "einstuerzende neubauten - halber mensch - tabula rasa - silence is sexy");
+    ASSERT_TRUE(rc);
+    rc = search_fuzzy_match(long_haystack, "einstuerzende neubautxx - halbxr mensch - tabulx rasa - silxnce is sexy");
+    ASSERT_TRUE(rc);
+    rc = search_fuzzy_match(long_haystack, "xxxxxxxxxxxxx neubauten - halber mensch - tabula rasa - silence is sexy");
+    ASSERT_FALSE(rc);
+
+    //compiled needle can be reused
+    struct t_search_fuzzy *pattern = mympd_search_fuzzy_compile("bauden", 6);
+    ASSERT_TRUE(mympd_search_fuzzy_match_compiled("einstuerzende neubauten", 23, pattern));
+    ASSERT_FALSE(mympd_search_fuzzy_match_compiled("tabula rasa", 11, pattern));
+    mympd_search_fuzzy_free(pattern);
+}
+
+UTEST(search_local, test_search_pcre_jit) {
+    sds regex = sdsnew("^artist 1[0-9]* - .*\\(remastered 199[0-4]\\)$");
+    struct t_search_pcre *re_interp = mympd_search_pcre_compile(regex, false);
+    struct t_search_pcre *re_jit = mympd_search_pcre_compile(regex, true);
+    ASSERT_TRUE(re_interp != NULL);
+    ASSERT_TRUE(re_jit != NULL);
+    ASSERT_FALSE(re_interp->jit);
+    // the interpreter and the JIT compiled regex return the same results
+    const char *values[] = {
+        "artist 12 - album title 12 (remastered 1992)",
+        "artist 12 - album title 12 (remastered 1995)",
+        "artist 2 - album title 2 (remastered 1992)",
+        "artist 1 - album title 1 (remastered 1990)",
+        NULL
+    };
+    const bool expected[] = { true, false, false, true };
+    for (unsigned i = 0; values[i] != NULL; i++) {
+        ASSERT_EQ(expected[i], mympd_search_pcre_match(values[i], strlen(values[i]), re_interp));
+        ASSERT_EQ(expected[i], mympd_search_pcre_match(values[i], strlen(values[i]), re_jit));
+    }
+    mympd_search_pcre_free(re_interp);
+    mympd_search_pcre_free(re_jit);
+    sdsfree(regex);
 }
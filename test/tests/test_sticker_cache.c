@@ -0,0 +1,124 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2026 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+#include "compile_time.h"
+
+#include "dist/utest/utest.h"
+#include "src/lib/sticker_cache.h"
+
+#include <string.h>
+
+static void sticker_cache_test_warm(struct t_sticker_cache *cache) {
+    sticker_cache_init(cache);
+    sticker_cache_set(cache, "song1.mp3", "playCount", "0000000005");
+    sticker_cache_set(cache, "song1.mp3", "like", "2");
+    sticker_cache_set(cache, "song1.mp3", "mood", "happy");
+    cache->valid = true;
+    cache->user_defined = true;
+}
+
+UTEST(sticker_cache, test_sticker_cache_get_all) {
+    struct t_sticker_cache cache;
+    sticker_cache_test_warm(&cache);
+    struct t_sticker sticker;
+    ASSERT_TRUE(sticker_cache_get_all(&cache, "song1.mp3", &sticker, true));
+    ASSERT_EQ((int64_t)5, sticker.mympd[STICKER_PLAY_COUNT]);
+    ASSERT_EQ((int64_t)STICKER_LIKE_LOVE, sticker.mympd[STICKER_LIKE]);
+    ASSERT_EQ(1U, sticker.user.length);
+    ASSERT_STREQ("happy", sticker.user.head->value_p);
+    sticker_struct_clear(&sticker);
+    // songs without stickers get the default values
+    ASSERT_TRUE(sticker_cache_get_all(&cache, "song2.mp3", &sticker, true));
+    ASSERT_EQ((int64_t)0, sticker.mympd[STICKER_PLAY_COUNT]);
+    ASSERT_EQ((int64_t)STICKER_LIKE_NEUTRAL, sticker.mympd[STICKER_LIKE]);
+    sticker_struct_clear(&sticker);
+
+    sds value = sticker_cache_get(&cache, "song1.mp3", "mood");
+    ASSERT_STREQ("happy", value);
+    sdsfree(value);
+    value = sticker_cache_get(&cache, "song1.mp3", "rating");
+    ASSERT_STREQ("", value);
+    sdsfree(value);
+
+    sticker_cache_remove(&cache, "song1.mp3", "like");
+    sticker_cache_remove(&cache, "song1.mp3", "mood");
+    ASSERT_TRUE(sticker_cache_get_all(&cache, "song1.mp3", &sticker, true));
+    ASSERT_EQ((int64_t)STICKER_LIKE_NEUTRAL, sticker.mympd[STICKER_LIKE]);
+    ASSERT_EQ(0U, sticker.user.length);
+    sticker_struct_clear(&sticker);
+    sticker_cache_free(&cache);
+}
+
+UTEST(sticker_cache, test_sticker_cache_invalid) {
+    struct t_sticker_cache cache;
+    sticker_cache_test_warm(&cache);
+    cache.user_defined = false;
+    struct t_sticker sticker;
+    int64_t value;
+    // user defined stickers are not cached
+    ASSERT_FALSE(sticker_cache_get_all(&cache, "song1.mp3", &sticker, true));
+    ASSERT_TRUE(sticker_cache_get(&cache, "song1.mp3", "mood") == NULL);
+    ASSERT_TRUE(sticker_cache_get_int64(&cache, "song1.mp3", "playCount", &value));
+    sticker_cache_clear(&cache);
+    ASSERT_FALSE(cache.valid);
+    ASSERT_FALSE(sticker_cache_get_int64(&cache, "song1.mp3", "playCount", &value));
+    ASSERT_EQ((int64_t)0, value);
+    sticker_cache_free(&cache);
+}
+
+UTEST(sticker_cache, test_sticker_cache_queue) {
+    struct t_sticker_cache cache;
+    sticker_cache_test_warm(&cache);
+    sticker_cache_queue(&cache, "song1.mp3", "playCount", 1, true);
+    sticker_cache_queue(&cache, "song1.mp3", "playCount", 1, true);
+    sticker_cache_queue(&cache, "song1.mp3", "lastPlayed", 100, false);
+    sticker_cache_queue(&cache, "song1.mp3", "lastPlayed", 200, false);
+    sticker_cache_queue(&cache, "song2.mp3", "elapsed", 10, false);
+    sticker_cache_queue(&cache, "song2.mp3", "elapsed", 5, true);
+    // the writes are applied to the cache
+    int64_t value;
+    ASSERT_TRUE(sticker_cache_get_int64(&cache, "song1.mp3", "playCount", &value));
+    ASSERT_EQ((int64_t)7, value);
+    ASSERT_TRUE(sticker_cache_get_int64(&cache, "song2.mp3", "elapsed", &value));
+    ASSERT_EQ((int64_t)15, value);
+    // and coalesced
+    ASSERT_EQ((uint64_t)3, cache.pending->numele);
+    raxIterator iter;
+    raxStart(&iter, cache.pending);
+    raxSeek(&iter, "^", NULL, 0);
+    while (raxNext(&iter)) {
+        struct t_sticker_cache_write *write = (struct t_sticker_cache_write *)iter.data;
+        if (strcmp(write->name, "playCount") == 0) {
+            ASSERT_TRUE(write->inc);
+            ASSERT_EQ((int64_t)2, write->value);
+        }
+        else if (strcmp(write->name, "lastPlayed") == 0) {
+            ASSERT_FALSE(write->inc);
+            ASSERT_EQ((int64_t)200, write->value);
+        }
+        else {
+            // an increment after a set is a set
+            ASSERT_FALSE(write->inc);
+            ASSERT_EQ((int64_t)15, write->value);
+        }
+    }
+    raxStop(&iter);
+    // pending writes survive the invalidation
+    sticker_cache_clear(&cache);
+    ASSERT_EQ((uint64_t)3, cache.pending->numele);
+    // only the written entries are dropped
+    sticker_cache_pending_drop(&cache, 2);
+    ASSERT_EQ((uint64_t)1, cache.pending->numele);
+    raxStart(&iter, cache.pending);
+    raxSeek(&iter, "^", NULL, 0);
+    ASSERT_TRUE(raxNext(&iter));
+    struct t_sticker_cache_write *last = (struct t_sticker_cache_write *)iter.data;
+    ASSERT_STREQ("song2.mp3", last->uri);
+    raxStop(&iter);
+    sticker_cache_pending_clear(&cache);
+    ASSERT_EQ((uint64_t)0, cache.pending->numele);
+    sticker_cache_free(&cache);
+}
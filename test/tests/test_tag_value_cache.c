@@ -0,0 +1,88 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2026 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+#include "compile_time.h"
+#include "utility.h"
+
+#include "dist/utest/utest.h"
+#include "src/lib/tag_value_cache.h"
+
+#include <string.h>
+
+static void tag_values_test_populate(struct t_tag_values *values) {
+    const char *list[] = {"pop", "jazz", "ab", "rock", "blues", "jazz rock", "a", "pop rock"};
+    for (unsigned i = 0; i < sizeof(list) / sizeof(list[0]); i++) {
+        tag_values_append(values, list[i]);
+    }
+    tag_values_commit(values);
+}
+
+UTEST(tag_value_cache, test_tag_value_cache_get) {
+    struct t_tag_value_cache cache;
+    tag_value_cache_init(&cache);
+    ASSERT_TRUE(tag_value_cache_get(&cache, MPD_TAG_UNKNOWN) == NULL);
+    struct t_tag_values *values = tag_value_cache_get(&cache, MPD_TAG_GENRE);
+    ASSERT_TRUE(values != NULL);
+    ASSERT_FALSE(values->valid);
+    tag_values_test_populate(values);
+    ASSERT_TRUE(values->valid);
+    ASSERT_EQ(8U, values->length);
+    ASSERT_STREQ("a", values->values[0].value);
+    ASSERT_STREQ("rock", values->values[7].value);
+    tag_value_cache_clear(&cache);
+    ASSERT_FALSE(values->valid);
+    ASSERT_EQ(0U, values->length);
+}
+
+UTEST(tag_value_cache, test_tag_values_page) {
+    struct t_tag_values values = { NULL, 0, 0, false };
+    tag_values_test_populate(&values);
+    unsigned page[3];
+    unsigned returned;
+    // paging without filter
+    ASSERT_EQ(8U, tag_values_page(&values, "", 0, false, 2, 3, page, &returned));
+    ASSERT_EQ(3U, returned);
+    ASSERT_STREQ("blues", values.values[page[0]].value);
+    ASSERT_STREQ("jazz rock", values.values[page[2]].value);
+    ASSERT_EQ(8U, tag_values_page(&values, "", 0, true, 0, 3, page, &returned));
+    ASSERT_EQ(3U, returned);
+    ASSERT_STREQ("rock", values.values[page[0]].value);
+    ASSERT_STREQ("pop", values.values[page[2]].value);
+    ASSERT_EQ(8U, tag_values_page(&values, "", 0, false, 7, 3, page, &returned));
+    ASSERT_EQ(1U, returned);
+    // short search strings must match the whole value
+    ASSERT_EQ(1U, tag_values_page(&values, "ab", 2, false, 0, 3, page, &returned));
+    ASSERT_STREQ("ab", values.values[page[0]].value);
+    ASSERT_EQ(0U, tag_values_page(&values, "po", 2, false, 0, 3, page, &returned));
+    ASSERT_EQ(0U, returned);
+    // substring search
+    ASSERT_EQ(3U, tag_values_page(&values, "rock", 4, false, 0, 3, page, &returned));
+    ASSERT_STREQ("jazz rock", values.values[page[0]].value);
+    ASSERT_STREQ("rock", values.values[page[2]].value);
+    ASSERT_EQ(3U, tag_values_page(&values, "rock", 4, true, 1, 3, page, &returned));
+    ASSERT_EQ(2U, returned);
+    ASSERT_STREQ("pop rock", values.values[page[0]].value);
+    ASSERT_STREQ("jazz rock", values.values[page[1]].value);
+    tag_values_clear(&values);
+}
+
+UTEST(tag_value_cache, test_tag_values_same_key) {
+    struct t_tag_values values = { NULL, 0, 0, false };
+    tag_values_append(&values, "rock");
+    tag_values_append(&values, "Pop");
+    tag_values_append(&values, "Rock");
+    tag_values_commit(&values);
+    // values with the same normalized key are kept and sorted by value
+    ASSERT_EQ(3U, values.length);
+    ASSERT_STREQ("Pop", values.values[0].value);
+    ASSERT_STREQ("Rock", values.values[1].value);
+    ASSERT_STREQ("rock", values.values[2].value);
+    unsigned page[3];
+    unsigned returned;
+    ASSERT_EQ(2U, tag_values_page(&values, "ROCK", 4, false, 0, 3, page, &returned));
+    ASSERT_EQ(2U, returned);
+    tag_values_clear(&values);
+}
@@ -0,0 +1,117 @@
+/*
+ SPDX-License-Identifier: GPL-3.0-or-later
+ myMPD (c) 2018-2026 Juergen Mang <mail@jcgames.de>
+ https://github.com/jcorporation/mympd
+*/
+
+#include "compile_time.h"
+#include "utility.h"
+
+#include "dist/utest/utest.h"
+#include "src/lib/mem.h"
+#include "src/lib/thumbnail.h"
+
+#include <png.h>
+
+/**
+ * Creates a png image with a gradient and some noise
+ */
+static sds create_png(unsigned width, unsigned height, bool alpha) {
+    png_image png;
+    memset(&png, 0, sizeof(png));
+    png.version = PNG_IMAGE_VERSION;
+    png.width = width;
+    png.height = height;
+    png.format = alpha == true
+        ? PNG_FORMAT_RGBA
+        : PNG_FORMAT_RGB;
+    unsigned char *pixels = malloc_assert(PNG_IMAGE_SIZE(png));
+    unsigned channels = PNG_IMAGE_PIXEL_CHANNELS(png.format);
+    unsigned seed = 1;
+    for (unsigned y = 0; y < height; y++) {
+        for (unsigned x = 0; x < width; x++) {
+            unsigned char *p = pixels + ((size_t)y * width + x) * channels;
+            seed = seed * 1103515245 + 12345;
+            p[0] = (unsigned char)(x * 255 / width);
+            p[1] = (unsigned char)(y * 255 / height);
+            p[2] = (unsigned char)((seed >> 28) + x % 64);
+            if (alpha == true) {
+                p[3] = (unsigned char)(x < width / 2 ? 255 : 0);
+            }
+        }
+    }
+    png_alloc_size_t len = 0;
+    png_image_write_to_memory(&png, NULL, &len, 0, pixels, 0, NULL);
+    sds data = sdsnewlen(NULL, len);
+    png_image_write_to_memory(&png, data, &len, 0, pixels, 0, NULL);
+    sdssetlen(data, len);
+    free(pixels);
+    return data;
+}
+
+UTEST(thumbnail, test_thumbnail_png) {
+    sds png = create_png(1200, 900, true);
+    struct t_thumbnail_image image;
+    ASSERT_TRUE(thumbnail_decode(png, sdslen(png), THUMBNAIL_SIZE_MD, &image));
+    ASSERT_EQ(1200U, image.width);
+    ASSERT_EQ(900U, image.height);
+    // transparent pixels are composed on white background
+    size_t last = ((size_t)image.width * image.height - 1) * 3;
+    ASSERT_EQ(255, image.pixels[last]);
+
+    sds jpeg = sdsempty();
+    ASSERT_TRUE(thumbnail_encode(&image, THUMBNAIL_SIZE_SM, &jpeg));
+    thumbnail_image_clear(&image);
+    ASSERT_TRUE(sdslen(jpeg) < sdslen(png));
+
+    // the thumbnail keeps the aspect ratio
+    ASSERT_TRUE(thumbnail_decode(jpeg, sdslen(jpeg), THUMBNAIL_SIZE_SM, &image));
+    ASSERT_EQ(350U, image.width);
+    ASSERT_EQ(263U, image.height);
+    thumbnail_image_clear(&image);
+    sdsfree(jpeg);
+    sdsfree(png);
+}
+
+UTEST(thumbnail, test_thumbnail_jpeg_scaled_decode) {
+    sds png = create_png(1600, 800, false);
+    struct t_thumbnail_image image;
+    ASSERT_TRUE(thumbnail_decode(png, sdslen(png), 0, &image));
+    sds jpeg = sdsempty();
+    // no upscaling
+    ASSERT_TRUE(thumbnail_encode(&image, 4000, &jpeg));
+    thumbnail_image_clear(&image);
+
+    // 1600 / 4 >= 350, 1600 / 8 < 350
+    ASSERT_TRUE(thumbnail_decode(jpeg, sdslen(jpeg), THUMBNAIL_SIZE_SM, &image));
+    ASSERT_EQ(400U, image.width);
+    ASSERT_EQ(200U, image.height);
+    thumbnail_image_clear(&image);
+    sdsfree(jpeg);
+    sdsfree(png);
+}
+
+UTEST(thumbnail, test_thumbnail_invalid) {
+    struct t_thumbnail_image image;
+    sds data = sdsnew("GIF89a not supported");
+    ASSERT_FALSE(thumbnail_decode(data, sdslen(data), THUMBNAIL_SIZE_MD, &image));
+    sdsclear(data);
+    // truncated jpeg
+    data = sdscatlen(data, "\xFF\xD8\xFF\xE0\x00\x10JFIF", 10);
+    ASSERT_FALSE(thumbnail_decode(data, sdslen(data), THUMBNAIL_SIZE_MD, &image));
+    ASSERT_TRUE(image.pixels == NULL);
+    sdsfree(data);
+}
+
+UTEST(thumbnail, test_thumbnail_cover_size) {
+    sds png = create_png(1500, 1500, false);
+    struct t_thumbnail_image image;
+    ASSERT_TRUE(thumbnail_decode(png, sdslen(png), THUMBNAIL_SIZE_MD, &image));
+    sds jpeg = sdsempty();
+    ASSERT_TRUE(thumbnail_encode(&image, THUMBNAIL_SIZE_SM, &jpeg));
+    // the grid thumbnail is a fraction of the original cover
+    ASSERT_TRUE(sdslen(jpeg) * 10 < sdslen(png));
+    thumbnail_image_clear(&image);
+    sdsfree(jpeg);
+    sdsfree(png);
+}
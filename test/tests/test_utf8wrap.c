@@ -78,3 +78,14 @@ UTEST(utf8wrap, utf8_wrap_casecmp) {
     ASSERT_EQ(rc, 0);
     ASSERT_EQ(errno, EINVAL);
 }
+
+UTEST(utf8wrap, utf8_wrap_tolower) {
+    char buffer[UTF8_TOLOWER_MAX_LEN(6)];
+    size_t len = strlen(utf8_str_valid);
+    size_t newlen = utf8_wrap_tolower(utf8_str_valid, len, buffer);
+    ASSERT_EQ(len, newlen);
+    ASSERT_EQ(0, memcmp(buffer, "abc123", 6));
+    newlen = utf8_wrap_tolower("XYZ", 3, buffer);
+    ASSERT_EQ((size_t)3, newlen);
+    ASSERT_EQ(0, memcmp(buffer, "xyz", 3));
+}